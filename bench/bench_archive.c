@@ -0,0 +1,355 @@
+/**
+ * @file bench_archive.c
+ * @brief Columnar archive against a row-by-row archive of the same packets.
+ *
+ * Housekeeping packets of 8 APIDs, each with 32 parameters (status flags,
+ * 12-bit ADC readings, 16-bit signed counters and 32-bit floats), are
+ * archived twice: as fixed-size rows in arrival order (header fields and all
+ * decommutated parameters), and as per-APID columnar chunks. Two analysis
+ * queries then run on both archives in memory:
+ *
+ *   - the mean of one ADC reading of one APID (an encoded column);
+ *   - the mean of one float of one APID (a plain column, scanned in place).
+ *
+ * The benchmark reports the archive sizes, the archiving cost per packet and
+ * the query times; the answers are checked to agree.
+ *
+ * Tuning: BENCH_PACKETS (default 1000000), BENCH_CHUNK (default 8192).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_archive.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define APIDS 8u
+#define PARAMS 32u
+#define DATA_LEN 64u
+#define BATCH 64u
+
+/* One row of the row-by-row archive. */
+typedef struct
+{
+    uint64_t time;
+    uint8_t addr;
+    uint8_t user_app;
+    uint16_t apid;
+    uint16_t seq;
+    uint16_t length;
+    uint64_t params[PARAMS];
+} row_t;
+
+static uint32_t g_rng = 2463534242u;
+
+static uint32_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+/* Write @p width bits of @p v at bit @p bit of @p data, MSB first. */
+static void put_bits(uint8_t *data, uint32_t bit, uint32_t width, uint64_t v)
+{
+    for (uint32_t b = 0; b < width; b++)
+    {
+        const uint32_t pos = bit + b;
+        const uint8_t mask = (uint8_t)(0x80u >> (pos % 8u));
+        if ((v >> (width - 1u - b)) & 1u)
+            data[pos / 8u] |= mask;
+        else
+            data[pos / 8u] &= (uint8_t)~mask;
+    }
+}
+
+/* Append @p n packets to @p w, flushing full chunks to @p out. */
+static int archive(sw_archive_writer_t *w,
+                   const uint64_t *times,
+                   const sw_packet_frame_t *frames,
+                   size_t n,
+                   uint8_t *out,
+                   size_t cap,
+                   size_t *used)
+{
+    size_t done = sw_archive_append(w, times, frames, n);
+
+    while (done < n)
+    {
+        size_t len = 0;
+        if (sw_archive_flush(w, out + *used, cap - *used, &len) != SW_OK)
+            return -1;
+        *used += len;
+        done += sw_archive_append(w, &times[done], &frames[done], n - done);
+    }
+    return 0;
+}
+
+int main(void)
+{
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 1000000u);
+    const uint32_t chunk_rows = bench_env_uint("BENCH_CHUNK", 8192u);
+
+    static sw_decom_param_t params[PARAMS];
+    static sw_decom_word_t words[PARAMS];
+    static sw_decom_op_t ops[PARAMS];
+    static sw_decom_plan_t plans[APIDS];
+    static sw_archive_writer_t writers[APIDS];
+    static uint8_t state[APIDS][DATA_LEN];
+    static uint16_t seq[APIDS];
+    static void *storage[APIDS];
+
+    /* 8 flags, 8 ADC readings, 8 counters, 8 floats. */
+    uint32_t bit = 0;
+    for (unsigned k = 0; k < PARAMS; k++)
+    {
+        static const uint8_t width[4] = {1, 12, 16, 32};
+        static const uint8_t type[4] = {SW_DECOM_UINT, SW_DECOM_UINT, SW_DECOM_INT, SW_DECOM_FLOAT};
+        const unsigned g = k / 8u;
+        if (g >= 2u)
+            bit = (bit + 7u) & ~7u;
+        params[k] = (sw_decom_param_t){bit, width[g], SW_DECOM_BIG, type[g]};
+        bit += width[g];
+    }
+
+    row_t *rows = malloc((size_t)packets * sizeof(row_t));
+    uint64_t *times = malloc((size_t)packets * sizeof(uint64_t));
+    sw_packet_frame_t *frames = calloc(packets, sizeof(*frames));
+    uint8_t *data = malloc((size_t)packets * DATA_LEN);
+    if (!rows || !times || !frames || !data)
+        return 1;
+
+    for (unsigned a = 0; a < APIDS; a++)
+    {
+        if (sw_decom_compile(&plans[a], (uint16_t)(0x200u + a), params, PARAMS, words, ops) !=
+            SW_OK)
+            return 1;
+        /* Plans may share words and ops: every APID has the same layout. */
+        const size_t size = sw_archive_storage_size(chunk_rows, PARAMS);
+        if (posix_memalign(&storage[a], 64, size) != 0)
+            return 1;
+        if (sw_archive_writer_init(&writers[a], 0, &plans[a], params, chunk_rows, storage[a], size))
+            return 1;
+        for (unsigned j = 0; j < DATA_LEN; j++)
+            state[a][j] = (uint8_t)rnd();
+    }
+
+    /* Telemetry that drifts: flags rarely change, ADC readings and counters
+     * move by small steps, floats are noisy. */
+    uint64_t t = 1000000000ull;
+    for (uint32_t i = 0; i < packets; i++)
+    {
+        const unsigned a = rnd() % APIDS;
+        uint8_t *d = &data[(size_t)i * DATA_LEN];
+
+        if (rnd() % 1000u == 0)
+            put_bits(state[a], params[rnd() % 8u].bit_offset, 1, rnd());
+        for (unsigned k = 8; k < 24u; k++)
+            put_bits(state[a], params[k].bit_offset, params[k].width, 2048u + rnd() % 64u);
+        for (unsigned k = 24; k < PARAMS; k++)
+        {
+            const float f = 20.0f + (float)(rnd() % 1000u) / 100.0f;
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            put_bits(state[a], params[k].bit_offset, 32, bits);
+        }
+        memcpy(d, state[a], DATA_LEN);
+
+        sw_packet_frame_t *f = &frames[i];
+        f->logical_addr = (uint8_t)(0x40u + a);
+        f->user_app = 0;
+        f->packet.ph.apid = (unsigned)((0x200u + a) & 0x7FFu);
+        f->packet.ph.seq_count = seq[a]++ & 0x3FFFu;
+        f->packet.data = d;
+        f->packet.data_len = DATA_LEN;
+        times[i] = t;
+        t += 1u + rnd() % 2000u;
+    }
+
+    /* Row archive: decommutate batches of each APID, then scatter the
+     * parameters into the rows in arrival order. */
+    uint64_t t0 = bench_now_ns();
+    {
+        static uint64_t cols[PARAMS][BATCH];
+        void *col_ptrs[PARAMS];
+        for (unsigned k = 0; k < PARAMS; k++)
+            col_ptrs[k] = cols[k];
+
+        for (uint32_t i = 0; i < packets; i++)
+        {
+            const sw_packet_frame_t *f = &frames[i];
+            row_t *r = &rows[i];
+            r->time = times[i];
+            r->addr = f->logical_addr;
+            r->user_app = f->user_app;
+            r->apid = (uint16_t)f->packet.ph.apid;
+            r->seq = (uint16_t)f->packet.ph.seq_count;
+            r->length = f->packet.data_len;
+        }
+        /* Demultiplexed by APID as for the columnar archive. */
+        static sw_packet_frame_t batch[APIDS][BATCH];
+        static uint32_t index[APIDS][BATCH];
+        static size_t fill[APIDS];
+        for (uint32_t i = 0; i <= packets; i++)
+        {
+            for (unsigned a = 0; a < APIDS; a++)
+            {
+                if (fill[a] < (i == packets ? 1u : BATCH))
+                    continue;
+                sw_decom_run(&plans[a], batch[a], fill[a], col_ptrs, NULL);
+                for (size_t j = 0; j < fill[a]; j++)
+                    for (unsigned k = 0; k < PARAMS; k++)
+                        rows[index[a][j]].params[k] = cols[k][j];
+                fill[a] = 0;
+            }
+            if (i < packets)
+            {
+                const unsigned a = frames[i].packet.ph.apid - 0x200u;
+                batch[a][fill[a]] = frames[i];
+                index[a][fill[a]++] = i;
+            }
+        }
+    }
+    const uint64_t row_ns = bench_now_ns() - t0;
+
+    /* Columnar archive: demultiplex by APID in batches, flush full chunks. */
+    const size_t bound = sw_archive_flush_bound(&writers[0]);
+    const size_t cap = (size_t)packets * sizeof(row_t) + (APIDS + 1u) * bound;
+    void *image = NULL;
+    if (posix_memalign(&image, 64, cap) != 0)
+        return 1;
+    uint8_t *out = image;
+    size_t used = 0;
+
+    t0 = bench_now_ns();
+    {
+        static sw_packet_frame_t batch[APIDS][BATCH];
+        static uint64_t batch_times[APIDS][BATCH];
+        static size_t fill[APIDS];
+
+        for (uint32_t i = 0; i < packets; i++)
+        {
+            const unsigned a = frames[i].packet.ph.apid - 0x200u;
+            batch[a][fill[a]] = frames[i];
+            batch_times[a][fill[a]++] = times[i];
+            if (fill[a] == BATCH)
+            {
+                if (archive(&writers[a], batch_times[a], batch[a], BATCH, out, cap, &used) != 0)
+                    return 1;
+                fill[a] = 0;
+            }
+        }
+        for (unsigned a = 0; a < APIDS; a++)
+        {
+            size_t n = 0;
+            if (archive(&writers[a], batch_times[a], batch[a], fill[a], out, cap, &used) != 0 ||
+                sw_archive_flush(&writers[a], out + used, cap - used, &n) != SW_OK)
+                return 1;
+            used += n;
+        }
+    }
+    const uint64_t col_ns = bench_now_ns() - t0;
+
+    sw_archive_reader_t reader;
+    if (sw_archive_open(&reader, image, used) != SW_OK)
+        return 1;
+
+    printf("Telemetry archive: %u packets, %u APIDs x %u parameters, %u-row chunks\n",
+           (unsigned)packets,
+           APIDS,
+           PARAMS,
+           (unsigned)chunk_rows);
+    printf("  %-10s %12s %14s\n", "archive", "size MB", "ns/packet");
+    printf("  %-10s %12.1f %14.1f\n",
+           "rows",
+           (double)packets * sizeof(row_t) / 1e6,
+           (double)row_ns / packets);
+    printf("  %-10s %12.1f %14.1f\n", "columnar", (double)used / 1e6, (double)col_ns / packets);
+    printf("  %-28s %12s %12s %10s\n", "query", "rows us", "columnar us", "speedup");
+
+    const struct
+    {
+        const char *name;
+        unsigned param;
+    } queries[] = {
+        {"mean ADC reading, one APID", 9},
+        {"mean float, one APID", 27},
+    };
+    const uint16_t apid = 0x203;
+
+    for (unsigned q = 0; q < sizeof(queries) / sizeof(queries[0]); q++)
+    {
+        const unsigned k = queries[q].param;
+        const int is_float = params[k].type == SW_DECOM_FLOAT;
+        double sum_rows = 0;
+        double sum_cols = 0;
+        uint64_t n_rows = 0;
+        uint64_t n_cols = 0;
+
+        t0 = bench_now_ns();
+        for (uint32_t i = 0; i < packets; i++)
+        {
+            if (rows[i].apid != apid)
+                continue;
+            double v;
+            if (is_float)
+                memcpy(&v, &rows[i].params[k], sizeof(v));
+            else
+                v = (double)rows[i].params[k];
+            sum_rows += v;
+            n_rows++;
+        }
+        const uint64_t scan_rows_ns = bench_now_ns() - t0;
+
+        t0 = bench_now_ns();
+        for (const sw_archive_chunk_t *c = sw_archive_next(&reader, NULL); c;
+             c = sw_archive_next(&reader, c))
+        {
+            if (c->apid != apid)
+                continue;
+            const sw_archive_column_t *col = sw_archive_column(c, SW_ARCHIVE_COL_PARAM + k);
+            const double *plain = is_float ? sw_archive_values(c, col) : NULL;
+            if (plain)
+            {
+                for (uint32_t i = 0; i < c->num_rows; i++)
+                    sum_cols += plain[i];
+            }
+            else
+            {
+                uint64_t v[1024];
+                for (uint32_t i = 0; i < c->num_rows; i += 1024u)
+                {
+                    const uint32_t m = c->num_rows - i < 1024u ? c->num_rows - i : 1024u;
+                    sw_archive_read(c, col, i, m, v);
+                    for (uint32_t j = 0; j < m; j++)
+                    {
+                        double d = (double)v[j];
+                        if (is_float)
+                            memcpy(&d, &v[j], sizeof(d));
+                        sum_cols += d;
+                    }
+                }
+            }
+            n_cols += c->num_rows;
+        }
+        const uint64_t scan_cols_ns = bench_now_ns() - t0;
+
+        printf("  %-28s %12.1f %12.1f %9.1fx%s\n",
+               queries[q].name,
+               (double)scan_rows_ns / 1e3,
+               (double)scan_cols_ns / 1e3,
+               (double)scan_rows_ns / (double)(scan_cols_ns ? scan_cols_ns : 1u),
+               n_rows == n_cols && sum_rows == sum_cols ? "" : "  MISMATCH");
+    }
+
+    for (unsigned a = 0; a < APIDS; a++)
+        free(storage[a]);
+    free(image);
+    free(rows);
+    free(times);
+    free(frames);
+    free(data);
+    return 0;
+}
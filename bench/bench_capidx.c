@@ -0,0 +1,272 @@
+/**
+ * @file bench_capidx.c
+ * @brief Capture index: query latency against a linear scan of the capture.
+ *
+ * A capture file of random CCSDS PTP packets (64 APIDs, 8 logical
+ * addresses, uneven rates) is recorded together with its index sidecar,
+ * both written through file descriptors as a recorder would. Both files
+ * are then mapped read-only, and "APID a between t1 and t2" and "address x
+ * between t1 and t2" are answered once by scanning the capture and once
+ * through the index; the answers are checked to agree.
+ *
+ * The benchmark reports the indexing cost per packet, the sidecar size
+ * relative to the capture, and the time of each query both ways. Times are
+ * with both files in the page cache; on a cold multi-terabyte capture the
+ * scan is bounded by disk bandwidth, while the index reads a few pages.
+ *
+ * Capture record: [ time: 8 octets | length: 4 | pad: 4 | packet, padded to 8 ].
+ *
+ * Tuning: BENCH_PACKETS (default 2000000).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_capidx.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define SEGMENT 8192u
+#define MAX_SEGMENTS 4096u
+#define CHUNK (1u << 20)
+
+typedef struct
+{
+    uint64_t time;
+    uint32_t len;
+    uint32_t pad;
+} record_t;
+
+static uint64_t g_rng = 0x2545F4914F6CDD1Du;
+
+static uint64_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+static int put(int fd, const void *data, size_t len)
+{
+    return write(fd, data, len) == (ssize_t)len ? 0 : -1;
+}
+
+/* Linear scan: packets of @p key in [t_begin, t_end), stopping at t_end. */
+static uint64_t scan(const uint8_t *cap,
+                     size_t len,
+                     uint32_t key,
+                     uint64_t t_begin,
+                     uint64_t t_end,
+                     uint64_t *sum)
+{
+    uint64_t hits = 0;
+    size_t off = 0;
+
+    while (off + sizeof(record_t) <= len)
+    {
+        const record_t *rec = (const record_t *)(const void *)(cap + off);
+        if (rec->time >= t_end)
+            break;
+
+        const uint8_t *pkt = cap + off + sizeof(record_t);
+        if (rec->time >= t_begin && rec->len >= SW_PTP_HEADER_LEN + 2u)
+        {
+            const uint32_t apid = ((uint32_t)(pkt[4] & 0x07u) << 8) | pkt[5];
+            if (key == SW_CAPIDX_ANY || key == SW_CAPIDX_APID(apid) ||
+                key == SW_CAPIDX_ADDR(pkt[0]))
+            {
+                hits++;
+                *sum += off;
+            }
+        }
+        off += sizeof(record_t) + ((rec->len + 7u) & ~7u);
+    }
+
+    return hits;
+}
+
+static uint64_t indexed(const sw_capidx_reader_t *r,
+                        uint32_t key,
+                        uint64_t t_begin,
+                        uint64_t t_end,
+                        uint64_t *sum)
+{
+    static sw_capidx_record_t out[4096];
+    sw_capidx_cursor_t cursor = {0, 0};
+    uint64_t hits = 0;
+    size_t n;
+
+    do
+    {
+        n = sw_capidx_query(r, key, t_begin, t_end, &cursor, out, 4096);
+        for (size_t i = 0; i < n; i++)
+            *sum += out[i].offset;
+        hits += n;
+    } while (n == 4096);
+
+    return hits;
+}
+
+int main(void)
+{
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 2000000u);
+
+    static sw_capidx_writer_t w;
+    static sw_capidx_record_t records[SEGMENT];
+    static uint16_t keys[2u * SEGMENT];
+    static sw_capidx_dirent_t dir[MAX_SEGMENTS];
+    static uint8_t payload[256];
+    const size_t bound = sw_capidx_flush_bound(SEGMENT) + (MAX_SEGMENTS + 1u) * 24u;
+    uint8_t *chunk = malloc(CHUNK);
+    void *side = NULL;
+    if (!chunk || posix_memalign(&side, 8, bound) != 0)
+        return 1;
+
+    char cap_path[] = "/tmp/bench_capidx_cap_XXXXXX";
+    char idx_path[] = "/tmp/bench_capidx_idx_XXXXXX";
+    const int cap_fd = mkstemp(cap_path);
+    const int idx_fd = mkstemp(idx_path);
+    if (cap_fd < 0 || idx_fd < 0)
+        return 1;
+    unlink(cap_path);
+    unlink(idx_path);
+
+    /* Record: the capture is buffered in chunks, the index flushed per segment. */
+    sw_capidx_writer_init(&w, records, keys, SEGMENT, dir, MAX_SEGMENTS);
+    uint64_t cap_len = 0;
+    uint64_t idx_len = 0;
+    size_t fill = 0;
+    uint64_t t = 0;
+
+    for (uint32_t i = 0; i < packets; i++)
+    {
+        /* APID a (and address a % 8) is drawn with weight ~ 1 / (a + 1). */
+        uint32_t a = (uint32_t)(rnd() % 64u);
+        a = (uint32_t)(a * (rnd() % 64u) / 64u);
+        const uint16_t len = (uint16_t)(16u + rnd() % 200u);
+
+        uint8_t *dst = chunk + fill + sizeof(record_t);
+        const size_t pkt_len = sw_packet_create((uint8_t)(0x40u + a % 8u),
+                                                0,
+                                                (uint16_t)(0x100u + a),
+                                                payload,
+                                                len,
+                                                dst,
+                                                CHUNK - fill - sizeof(record_t));
+        const record_t rec = {t, (uint32_t)pkt_len, 0};
+        memcpy(chunk + fill, &rec, sizeof(rec));
+
+        if (sw_capidx_add(&w, t, cap_len, dst, pkt_len) == SW_ERR)
+        {
+            size_t n = 0;
+            if (sw_capidx_flush(&w, side, bound, &n) != SW_OK || put(idx_fd, side, n) != 0)
+                return 1;
+            idx_len += n;
+            sw_capidx_add(&w, t, cap_len, dst, pkt_len);
+        }
+
+        const size_t step = sizeof(record_t) + ((pkt_len + 7u) & ~(size_t)7u);
+        fill += step;
+        cap_len += step;
+        t += 1u + rnd() % 2000u; /* ns between packets */
+
+        if (fill + sizeof(record_t) + 512u > CHUNK)
+        {
+            if (put(cap_fd, chunk, fill) != 0)
+                return 1;
+            fill = 0;
+        }
+    }
+
+    size_t n = 0;
+    if (put(cap_fd, chunk, fill) != 0 || sw_capidx_finish(&w, side, bound, &n) != SW_OK ||
+        put(idx_fd, side, n) != 0)
+        return 1;
+    idx_len += n;
+
+    const uint8_t *cap = mmap(NULL, cap_len, PROT_READ, MAP_PRIVATE, cap_fd, 0);
+    const void *idx = mmap(NULL, idx_len, PROT_READ, MAP_PRIVATE, idx_fd, 0);
+    if (cap == MAP_FAILED || idx == MAP_FAILED)
+        return 1;
+
+    sw_capidx_reader_t r;
+    if (sw_capidx_open(&r, idx, idx_len) != SW_OK)
+        return 1;
+
+    /* Indexing cost alone: index the mapped capture again, discarding the output. */
+    sw_capidx_writer_init(&w, records, keys, SEGMENT, NULL, 0);
+    const uint64_t t_index = bench_now_ns();
+    for (uint64_t off = 0; off < cap_len;)
+    {
+        const record_t *rec = (const record_t *)(const void *)(cap + off);
+        const uint8_t *pkt = cap + off + sizeof(record_t);
+        if (sw_capidx_add(&w, rec->time, off, pkt, rec->len) == SW_ERR)
+        {
+            sw_capidx_flush(&w, side, bound, &n);
+            sw_capidx_add(&w, rec->time, off, pkt, rec->len);
+        }
+        off += sizeof(record_t) + ((rec->len + 7u) & ~7u);
+    }
+    sw_capidx_finish(&w, side, bound, &n);
+    const uint64_t index_ns = bench_now_ns() - t_index;
+
+    printf("Capture index: %u packets, capture %.1f MB, sidecar %.1f MB (%.1f%%), "
+           "indexing %.1f ns/packet\n",
+           (unsigned)packets,
+           (double)cap_len / 1e6,
+           (double)idx_len / 1e6,
+           100.0 * (double)idx_len / (double)cap_len,
+           (double)index_ns / packets);
+    printf("  %-28s %10s %12s %12s %10s\n", "query", "matches", "scan us", "index us", "speedup");
+
+    const struct
+    {
+        const char *name;
+        uint32_t key;
+        uint64_t from; /* 0.01% of the capture */
+        uint64_t to;
+    } queries[] = {
+        {"rare APID, 1% window", SW_CAPIDX_APID(0x13C), 5000, 5100},
+        {"rare APID, whole capture", SW_CAPIDX_APID(0x13C), 0, 10000},
+        {"common APID, 1% window", SW_CAPIDX_APID(0x100), 5000, 5100},
+        {"address, 10% window", SW_CAPIDX_ADDR(0x43), 3000, 4000},
+        {"any packet, 0.01% window", SW_CAPIDX_ANY, 5000, 5001},
+    };
+
+    for (unsigned q = 0; q < sizeof(queries) / sizeof(queries[0]); q++)
+    {
+        /* Windows are in units of 0.01% of the capture's duration. */
+        const uint64_t t1 = queries[q].from * (t / 10000u);
+        const uint64_t t2 = queries[q].to == 10000u ? t : queries[q].to * (t / 10000u);
+        uint64_t sum_scan = 0;
+        uint64_t sum_index = 0;
+
+        uint64_t t0 = bench_now_ns();
+        const uint64_t hits_scan = scan(cap, cap_len, queries[q].key, t1, t2, &sum_scan);
+        const uint64_t scan_ns = bench_now_ns() - t0;
+
+        t0 = bench_now_ns();
+        const uint64_t hits_index = indexed(&r, queries[q].key, t1, t2, &sum_index);
+        const uint64_t index_q_ns = bench_now_ns() - t0;
+
+        printf("  %-28s %10llu %12.1f %12.1f %9.0fx%s\n",
+               queries[q].name,
+               (unsigned long long)hits_index,
+               (double)scan_ns / 1e3,
+               (double)index_q_ns / 1e3,
+               (double)scan_ns / (double)(index_q_ns ? index_q_ns : 1u),
+               hits_scan == hits_index && sum_scan == sum_index ? "" : "  MISMATCH");
+    }
+
+    munmap((void *)(uintptr_t)cap, cap_len);
+    munmap((void *)(uintptr_t)idx, idx_len);
+    close(cap_fd);
+    close(idx_fd);
+    free(chunk);
+    free(side);
+    return 0;
+}
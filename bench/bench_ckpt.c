@@ -0,0 +1,216 @@
+/**
+ * @file bench_ckpt.c
+ * @brief What-if branches from a warmed-up checkpoint versus from scratch.
+ *
+ * A 14 x 14 mesh of routers, each with a node attached, is run under uniform
+ * random traffic until it reaches steady state, then saved to a file. Each
+ * branch fails a different link and runs on for a while. Branches are
+ * started three ways:
+ *
+ *   - cold:    build the network and repeat the warm-up;
+ *   - restore: map the file and copy it into private storage;
+ *   - attach:  map the file copy-on-write and run in the mapping.
+ *
+ * The benchmark reports the image size and, per branch, the set-up and total
+ * time of each, and checks that all three give identical branch results.
+ *
+ * Tuning: BENCH_BRANCHES (default 20), BENCH_WARMUP_US (default 5000),
+ * BENCH_BRANCH_US (default 500).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_ckpt.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define SIDE 14u
+#define NODES (SIDE * SIDE)
+#define MAX_LINKS (2u * SIDE * (SIDE - 1u))
+#define EVENTS (1u << 16)
+
+typedef struct
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[MAX_LINKS];
+    sw_sim_t sim;
+    sw_sim_node_t sim_nodes[NODES];
+    uint8_t tables[SW_SIM_MAX_TABLES * NODES * SW_ROUTE_TABLE_SIZE];
+} model_t;
+
+static sw_sim_event_t g_events[EVENTS];
+
+static void build(model_t *m)
+{
+    static uint64_t dist[NODES];
+    static uint16_t heap[NODES];
+    static uint16_t pos[NODES];
+    const sw_net_work_t work = {.dist = dist, .heap = heap, .pos = pos};
+
+    memset(m, 0, sizeof(*m));
+    sw_net_init(&m->net, m->nodes, NODES, m->links, MAX_LINKS);
+
+    /* Ports: 1 north, 2 east, 3 south, 4 west. */
+    for (unsigned i = 0; i < NODES; i++)
+        sw_net_add_node(&m->net, 5, (uint8_t)(0x20u + i), NULL);
+
+    for (unsigned y = 0; y < SIDE; y++)
+    {
+        for (unsigned x = 0; x < SIDE; x++)
+        {
+            const uint16_t n = (uint16_t)(y * SIDE + x);
+            if (x + 1u < SIDE)
+                sw_net_connect(&m->net, n, 2, (uint16_t)(n + 1u), 4, 200000000, 1000, NULL);
+            if (y + 1u < SIDE)
+                sw_net_connect(&m->net, n, 3, (uint16_t)(n + SIDE), 1, 200000000, 1000, NULL);
+        }
+    }
+
+    sw_net_compute_routes(&m->net, &work, m->tables);
+    sw_net_install_routes(&m->net, m->tables);
+    sw_sim_init(&m->sim, &m->net, m->sim_nodes, g_events, EVENTS, 21);
+    for (uint16_t n = 0; n < NODES; n++)
+        sw_sim_set_traffic(&m->sim, n, 40000, 64);
+}
+
+/** The what-if of branch @p b: fail one link, run on; returns the stats. */
+static sw_sim_stats_t branch(sw_sim_t *sim, unsigned b, uint64_t duration)
+{
+    const uint16_t link = (uint16_t)(b * 7u % sim->net->num_links);
+    sw_sim_stats_t st;
+
+    sw_sim_schedule_link(sim, link, sim->now + 1000u, 0);
+    sw_sim_run(sim, sim->now + duration);
+    sw_sim_get_stats(sim, &st);
+    return st;
+}
+
+int main(void)
+{
+    const unsigned branches = bench_env_uint("BENCH_BRANCHES", 20u);
+    const uint64_t warmup = (uint64_t)bench_env_uint("BENCH_WARMUP_US", 5000u) * 1000u;
+    const uint64_t duration = (uint64_t)bench_env_uint("BENCH_BRANCH_US", 500u) * 1000u;
+
+    static model_t m;
+    static sw_sim_event_t events[EVENTS];
+
+    build(&m);
+    sw_sim_run(&m.sim, warmup);
+
+    const uint32_t in_flight = m.sim.num_events;
+    const size_t size = sw_ckpt_size(&m.sim);
+    void *buf = NULL;
+    size_t len = 0;
+    if (posix_memalign(&buf, SW_CKPT_ALIGN, size) != 0 ||
+        sw_ckpt_save(&m.sim, buf, size, &len) != SW_OK)
+        return 1;
+
+    char path[] = "/tmp/bench_ckpt_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0 || write(fd, buf, len) != (ssize_t)len)
+        return 1;
+    unlink(path);
+    free(buf);
+
+    sw_sim_stats_t *ref = calloc(branches, sizeof(*ref));
+    if (!ref)
+        return 1;
+
+    uint64_t t_cold = 0;
+    uint64_t t_restore = 0;
+    uint64_t t_attach = 0;
+    uint64_t setup_cold = 0;
+    uint64_t setup_restore = 0;
+    uint64_t setup_attach = 0;
+    unsigned mismatches = 0;
+
+    for (unsigned b = 0; b < branches; b++)
+    {
+        const uint64_t t0 = bench_now_ns();
+        build(&m);
+        sw_sim_run(&m.sim, warmup);
+        const uint64_t t1 = bench_now_ns();
+        ref[b] = branch(&m.sim, b, duration);
+        setup_cold += t1 - t0;
+        t_cold += bench_now_ns() - t0;
+    }
+
+    for (unsigned b = 0; b < branches; b++)
+    {
+        const uint64_t t0 = bench_now_ns();
+        void *image = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (image == MAP_FAILED)
+            return 1;
+
+        const sw_ckpt_storage_t st = {.nodes = m.nodes,
+                                      .links = m.links,
+                                      .sim_nodes = m.sim_nodes,
+                                      .events = events,
+                                      .tables = m.tables,
+                                      .max_nodes = NODES,
+                                      .max_links = MAX_LINKS,
+                                      .max_events = EVENTS,
+                                      .max_tables = SW_SIM_MAX_TABLES};
+        if (sw_ckpt_restore(image, len, &st, &m.net, &m.sim) != SW_OK)
+            return 1;
+        munmap(image, len);
+
+        const uint64_t t1 = bench_now_ns();
+        const sw_sim_stats_t s = branch(&m.sim, b, duration);
+        setup_restore += t1 - t0;
+        t_restore += bench_now_ns() - t0;
+        mismatches += memcmp(&s, &ref[b], sizeof(s)) != 0;
+    }
+
+    for (unsigned b = 0; b < branches; b++)
+    {
+        sw_net_t net;
+        sw_sim_t sim;
+
+        const uint64_t t0 = bench_now_ns();
+        void *image = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (image == MAP_FAILED || sw_ckpt_attach(image, len, events, EVENTS, &net, &sim) != SW_OK)
+            return 1;
+
+        const uint64_t t1 = bench_now_ns();
+        const sw_sim_stats_t s = branch(&sim, b, duration);
+        munmap(image, len);
+        setup_attach += t1 - t0;
+        t_attach += bench_now_ns() - t0;
+        mismatches += memcmp(&s, &ref[b], sizeof(s)) != 0;
+    }
+
+    printf("Checkpoint branches: %ux%u router mesh, %u us warm-up, %u branches of %u us\n",
+           SIDE,
+           SIDE,
+           (unsigned)(warmup / 1000u),
+           branches,
+           (unsigned)(duration / 1000u));
+    printf("  image %zu octets, %u events in flight\n", len, (unsigned)in_flight);
+    printf("  %-10s %16s %16s %10s\n", "start", "set-up ms/br", "total ms/br", "speedup");
+    printf("  %-10s %16.3f %16.3f %10.1f\n",
+           "cold",
+           (double)setup_cold / branches / 1e6,
+           (double)t_cold / branches / 1e6,
+           1.0);
+    printf("  %-10s %16.3f %16.3f %10.1f\n",
+           "restore",
+           (double)setup_restore / branches / 1e6,
+           (double)t_restore / branches / 1e6,
+           (double)t_cold / (double)(t_restore ? t_restore : 1u));
+    printf("  %-10s %16.3f %16.3f %10.1f\n",
+           "attach",
+           (double)setup_attach / branches / 1e6,
+           (double)t_attach / branches / 1e6,
+           (double)t_cold / (double)(t_attach ? t_attach : 1u));
+    printf("  branch results identical: %s\n", mismatches == 0 ? "yes" : "NO");
+
+    close(fd);
+    free(ref);
+    return mismatches == 0 ? 0 : 1;
+}
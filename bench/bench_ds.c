@@ -0,0 +1,188 @@
+/**
+ * @file bench_ds.c
+ * @brief Decode throughput of the data-strobe capture decoder.
+ *
+ * A capture is synthesised with the encoder: NULLs to synchronise, then CCSDS
+ * PTP packets (built with sw_packet_encode(), 16..512-octet payloads), each
+ * followed by an FCT, at a fixed number of samples per bit. The same capture
+ * is decoded by sw_ds_decode() twice:
+ *
+ * - packets only: no character callback, so the bits of each word are
+ *   gathered at once (with PEXT where BMI2 is available);
+ * - with a character callback: every character and its sample is reported.
+ *
+ * Each row gives samples and recovered line bits per second and checks that
+ * every packet decoded. A last row times sw_ds_pack() converting a
+ * one-octet-per-sample export of the capture into line words.
+ *
+ * Tuning: BENCH_WORDS (words per line, default 65536), BENCH_SPB (samples per
+ * bit, default 4), BENCH_ROUNDS (default 20).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_ds.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BUF_LEN 600u
+
+typedef struct
+{
+    uint64_t packets; /**< Packets seen. */
+    uint64_t ok;      /**< Of those, decoded with SW_OK. */
+    uint64_t chars;   /**< Characters reported. */
+} sink_t;
+
+static void on_packet(void *ctx,
+                      const sw_packet_frame_t *pf,
+                      sw_result_t result,
+                      sw_ptp_status_t status,
+                      const uint8_t *pkt,
+                      size_t len,
+                      sw_end_marker_t end)
+{
+    sink_t *sink = ctx;
+    (void)pf;
+    (void)status;
+    (void)pkt;
+    (void)len;
+    (void)end;
+    sink->packets++;
+    sink->ok += result == SW_OK;
+}
+
+static void on_char(void *ctx, const sw_ds_char_t *ch)
+{
+    sink_t *sink = ctx;
+    (void)ch;
+    sink->chars++;
+}
+
+/** Fill the capture with NULLs, then packets and FCTs; return the packets encoded. */
+static uint64_t build_capture(sw_ds_encoder_t *enc)
+{
+    static uint8_t payload[512];
+    static uint8_t pkt[BUF_LEN];
+    uint64_t x = 0x9E3779B97F4A7C15u;
+    uint64_t packets = 0;
+
+    for (size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 13u);
+    for (int i = 0; i < 4; i++)
+        sw_ds_encode_char(enc, SW_DS_NULL, 0);
+
+    for (;;)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+
+        sw_packet_frame_t pf;
+        const sw_packet_config_t config = {.path = NULL,
+                                           .path_len = 0,
+                                           .logical_addr = 0x40,
+                                           .user_app = 0};
+        sw_packet_init(&pf, &config);
+        pf.packet.ph.apid = (unsigned)(packets & 0x7FFu);
+        pf.packet.data = payload;
+        pf.packet.data_len = (uint16_t)(16u + x % 497u);
+        const size_t len = sw_packet_encode(&pf, pkt, sizeof(pkt));
+
+        if (sw_ds_encode_packet(enc, pkt, len, SW_END_EOP) != SW_OK ||
+            sw_ds_encode_char(enc, SW_DS_FCT, 0) != SW_OK)
+            return packets;
+        packets++;
+    }
+}
+
+static void run_decode(const char *name,
+                       const uint64_t *d,
+                       const uint64_t *s,
+                       size_t words,
+                       unsigned rounds,
+                       uint64_t expected,
+                       int with_chars)
+{
+    static uint8_t buf[BUF_LEN];
+    sink_t sink = {0};
+    sw_ds_decoder_t dec;
+    const sw_ds_config_t config = {.buf = buf,
+                                   .cap = BUF_LEN,
+                                   .disconnect_samples = 0,
+                                   .on_packet = on_packet,
+                                   .on_char = with_chars ? on_char : NULL,
+                                   .ctx = &sink};
+    uint64_t bits = 0;
+
+    const uint64_t t0 = bench_now_ns();
+    for (unsigned r = 0; r < rounds; r++)
+    {
+        sw_ds_init(&dec, &config);
+        sw_ds_decode(&dec, d, s, words);
+        bits += dec.stats.bits;
+    }
+    const uint64_t ns = bench_now_ns() - t0;
+
+    const double samples = (double)words * SW_DS_WORD_SAMPLES * rounds;
+    printf("  %-22s %12.1f %12.1f %10s\n",
+           name,
+           samples * 1e3 / (double)ns,
+           (double)bits * 1e3 / (double)ns,
+           sink.ok == expected * rounds ? "ok" : "MISMATCH");
+}
+
+int main(void)
+{
+    const size_t words = bench_env_uint("BENCH_WORDS", 65536u);
+    const unsigned spb = bench_env_uint("BENCH_SPB", 4u);
+    const unsigned rounds = bench_env_uint("BENCH_ROUNDS", 20u);
+    const size_t count = words * SW_DS_WORD_SAMPLES;
+
+    uint64_t *d = calloc(words, sizeof(*d));
+    uint64_t *s = calloc(words, sizeof(*s));
+    uint64_t *d2 = calloc(words, sizeof(*d2));
+    uint64_t *s2 = calloc(words, sizeof(*s2));
+    uint8_t *raw = malloc(count);
+    if (!d || !s || !d2 || !s2 || !raw || spb == 0u)
+        return 1;
+
+    sw_ds_encoder_t enc;
+    sw_ds_encoder_init(&enc, d, s, words, spb);
+    const uint64_t packets = build_capture(&enc);
+
+    printf("Data-strobe decode: %zu samples, %u samples/bit, %llu packets\n",
+           count,
+           spb,
+           (unsigned long long)packets);
+    printf("  %-22s %12s %12s %10s\n", "path", "Msamples/s", "Mbit/s", "packets");
+
+    run_decode("packets only", d, s, words, rounds, packets, 0);
+    run_decode("with on_char", d, s, words, rounds, packets, 1);
+
+    /* Logic-analyser export: Data on channel 0, Strobe on channel 1. */
+    for (size_t i = 0; i < count; i++)
+        raw[i] = (uint8_t)(((d[i / 64u] >> (i % 64u)) & 1u) |
+                           (((s[i / 64u] >> (i % 64u)) & 1u) << 1) | 0xA4u);
+
+    const uint64_t t0 = bench_now_ns();
+    for (unsigned r = 0; r < rounds; r++)
+        sw_ds_pack(raw, count, 0, 1, d2, s2);
+    const uint64_t ns = bench_now_ns() - t0;
+
+    const int same = memcmp(d, d2, words * sizeof(*d)) == 0 &&
+                     memcmp(s, s2, words * sizeof(*s)) == 0;
+    printf("  %-22s %12.1f %12s %10s\n",
+           "sw_ds_pack",
+           (double)count * rounds * 1e3 / (double)ns,
+           "-",
+           same ? "ok" : "MISMATCH");
+
+    free(raw);
+    free(s2);
+    free(d2);
+    free(s);
+    free(d);
+    return 0;
+}
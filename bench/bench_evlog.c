@@ -0,0 +1,54 @@
+/**
+ * @file bench_evlog.c
+ * @brief Cost of recording a flight-recorder event.
+ *
+ * Measures sw_evlog_record() with a ring attached and without one (the cost
+ * every library call site pays when recording is off), and the cost of a
+ * sw_link_set_state() call that logs a state change.
+ *
+ * Tuning: BENCH_EVENTS (default 20000000).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire.h"
+#include "spacewire_evlog.h"
+
+#include <stdio.h>
+
+static sw_ev_record_t g_records[4096];
+
+int main(void)
+{
+    const unsigned events = bench_env_uint("BENCH_EVENTS", 20000000u);
+
+    sw_evlog_ring_t ring;
+    sw_evlog_ring_init(&ring, g_records, 4096, 0);
+
+    printf("Event log: %u events\n", events);
+
+    sw_evlog_attach(NULL);
+    uint64_t t0 = bench_now_ns();
+    for (unsigned i = 0; i < events; i++)
+        sw_evlog_record(SW_EV_USER, &ring, (uint16_t)i, 0);
+    printf("  %-28s %6.2f ns/event\n", "detached (no-op)", (double)(bench_now_ns() - t0) / events);
+
+    sw_evlog_attach(&ring);
+    t0 = bench_now_ns();
+    for (unsigned i = 0; i < events; i++)
+        sw_evlog_record(SW_EV_USER, &ring, (uint16_t)i, 0);
+    printf("  %-28s %6.2f ns/event\n", "attached", (double)(bench_now_ns() - t0) / events);
+
+    sw_link_layer_t link;
+    const sw_link_config_t config = {.bit_rate = 200000000u};
+    sw_link_init(&link, &config);
+    t0 = bench_now_ns();
+    for (unsigned i = 0; i < events; i++)
+        sw_link_set_state(&link, (i & 1u) ? SW_LINK_CONNECTED : SW_LINK_ERROR);
+    printf("  %-28s %6.2f ns/call\n",
+           "sw_link_set_state (logged)",
+           (double)(bench_now_ns() - t0) / events);
+
+    sw_evlog_attach(NULL);
+    return 0;
+}
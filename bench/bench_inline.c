@@ -0,0 +1,159 @@
+/**
+ * @file bench_inline.c
+ * @brief Small packets carried inline in descriptors against pool buffers.
+ *
+ * A receive stage writes each packet, pushes its descriptor to a ring in
+ * bursts of 32, and a decode stage pops the burst and runs
+ * sw_desc_decode() on every packet:
+ *
+ * - external: the packet is written to the next free buffer of a pool of
+ *   2-KiB buffers, as a DMA engine would, and the decode stage returns the
+ *   buffer to the pool's free list once decoded;
+ * - inline: the packet is written to a scratch buffer and copied into the
+ *   descriptor by sw_desc_set_packet(); no pool buffer is used.
+ *
+ * Both stages run on one thread, so the figures are per-packet costs, not
+ * a parallel rate. The pool is far larger than the caches, as when many
+ * buffers are in flight; each external packet is then a cache miss when
+ * written and again when decoded. The benchmark reports nanoseconds and
+ * millions of packets per second for each packet size that fits inline, and
+ * the packets that failed to decode.
+ *
+ * Tuning: BENCH_PACKETS (per size and path, default 10000000), BENCH_POOL
+ * (buffers in the pool, default 16384).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_ring.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define RING_SLOTS 1024u
+#define BURST 32u
+#define BUF_SIZE 2048u
+
+static sw_ring_t g_ring;
+static sw_desc_t g_slots[RING_SLOTS];
+static uint8_t g_template[SW_DESC_INLINE_MAX];
+static uint8_t *g_pool;
+static uint32_t *g_free;
+
+/* The free list is a FIFO, so buffers are reused in the order they were
+ * returned and the whole pool stays in play. */
+static uint64_t run(uint32_t packets, uint32_t len, uint32_t pool, int use_inline, uint64_t *errors)
+{
+    sw_desc_t in[BURST];
+    sw_desc_t out[BURST];
+    sw_packet_frame_t pf;
+    uint8_t scratch[SW_DESC_INLINE_MAX];
+    uint32_t free_head = 0;
+    uint32_t free_tail = pool;
+
+    for (uint32_t i = 0; i < pool; i++)
+        g_free[i] = i;
+    memset(in, 0, sizeof(in));
+    sw_ring_init(&g_ring, g_slots, RING_SLOTS);
+    *errors = 0;
+
+    const uint64_t t0 = bench_now_ns();
+    for (uint32_t i = 0; i < packets; i += BURST)
+    {
+        const uint32_t n = packets - i < BURST ? packets - i : BURST;
+
+        for (uint32_t k = 0; k < n; k++)
+        {
+            in[k].end = SW_END_EOP;
+            if (use_inline)
+            {
+                memcpy(scratch, g_template, len);
+                scratch[len - 1u] = (uint8_t)(i + k);
+                sw_desc_set_packet(&in[k], scratch, len);
+            }
+            else
+            {
+                const uint32_t b = g_free[free_head++ % pool];
+                uint8_t *buf = &g_pool[(size_t)b * BUF_SIZE];
+                memcpy(buf, g_template, len);
+                buf[len - 1u] = (uint8_t)(i + k);
+                in[k].data = buf;
+                in[k].len = len;
+                in[k].tag = (uint16_t)b;
+            }
+        }
+        sw_ring_push_burst(&g_ring, in, n);
+
+        const uint32_t m = sw_ring_pop_burst(&g_ring, out, BURST);
+        for (uint32_t k = 0; k < m; k++)
+        {
+            *errors += sw_desc_decode(&pf, &out[k], NULL) != SW_OK;
+            *errors += pf.packet.data[pf.packet.data_len - 1u] != (uint8_t)(i + k);
+            if (!sw_desc_is_inline(&out[k]))
+                g_free[free_tail++ % pool] = out[k].tag;
+        }
+    }
+    return bench_now_ns() - t0;
+}
+
+int main(void)
+{
+    static const uint32_t lens[] = {16, 24, 32, SW_DESC_INLINE_MAX};
+    static const uint8_t payload[SW_DESC_INLINE_MAX] = {0};
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 10000000u);
+    uint32_t pool = bench_env_uint("BENCH_POOL", 16384u);
+    if (pool > 65536u)
+        pool = 65536u;
+    if (pool < 2u * RING_SLOTS)
+        pool = 2u * RING_SLOTS;
+
+    g_pool = malloc((size_t)pool * BUF_SIZE);
+    g_free = malloc(pool * sizeof(*g_free));
+    if (!g_pool || !g_free)
+        return 1;
+    memset(g_pool, 0, (size_t)pool * BUF_SIZE);
+
+    printf("Inline descriptors: %u packets per size, %u-octet descriptors, pool of %u buffers\n",
+           (unsigned)packets,
+           (unsigned)sizeof(sw_desc_t),
+           (unsigned)pool);
+    printf("  %6s %10s %10s %10s %10s %8s %7s\n",
+           "octets",
+           "ext ns",
+           "ext Mpps",
+           "inl ns",
+           "inl Mpps",
+           "speedup",
+           "errors");
+
+    for (size_t s = 0; s < sizeof(lens) / sizeof(lens[0]); s++)
+    {
+        const uint32_t len = lens[s];
+        uint64_t ext_errors;
+        uint64_t inl_errors;
+
+        sw_packet_create(0x42,
+                         0,
+                         0x123,
+                         payload,
+                         (uint16_t)(len - SW_PTP_HEADER_LEN - 6u),
+                         g_template,
+                         sizeof(g_template));
+
+        const uint64_t ext = run(packets, len, pool, 0, &ext_errors);
+        const uint64_t inl = run(packets, len, pool, 1, &inl_errors);
+
+        printf("  %6u %10.2f %10.2f %10.2f %10.2f %7.1fx %7llu\n",
+               (unsigned)len,
+               (double)ext / packets,
+               (double)packets * 1e3 / (double)ext,
+               (double)inl / packets,
+               (double)packets * 1e3 / (double)inl,
+               (double)ext / (double)inl,
+               (unsigned long long)(ext_errors + inl_errors));
+    }
+
+    free(g_free);
+    free(g_pool);
+    return 0;
+}
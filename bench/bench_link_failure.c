@@ -0,0 +1,225 @@
+/**
+ * @file bench_link_failure.c
+ * @brief Monte-Carlo link-failure trials on a router mesh, run across cores.
+ *
+ * A 6 x 6 mesh of routers, each with a node attached (logical addresses
+ * 0x40 upwards), carries uniform random traffic. Every trial fails one random
+ * link and lets the network manager reinstall the routing tables that change
+ * after a detection delay, each router taking its new table at a random
+ * point of the install window. The benchmark reports the distribution over
+ * trials of packets lost, disruption (failure to last loss) and convergence
+ * (failure to last install), and the trial rate on one thread and on all.
+ *
+ * Trial i uses seed i, so the distributions do not depend on the number of
+ * threads.
+ *
+ * Tuning: BENCH_TRIALS (default 2000), BENCH_THREADS (default: online CPUs),
+ * BENCH_DETECT_US (default 50), BENCH_SPREAD_US (default 200).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_sim.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SIDE 6u
+#define NODES (SIDE * SIDE)
+#define MAX_LINKS (2u * SIDE * (SIDE - 1u))
+#define EVENTS 8192u
+#define MAX_THREADS 64u
+
+/** Per-thread copy of the network and simulator. */
+typedef struct
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[MAX_LINKS];
+    uint64_t dist[NODES];
+    uint16_t heap[NODES];
+    uint16_t pos[NODES];
+    uint8_t tables[2u * NODES * SW_ROUTE_TABLE_SIZE];
+    sw_sim_t sim;
+    sw_sim_node_t sim_nodes[NODES];
+    sw_sim_event_t events[EVENTS];
+} worker_t;
+
+typedef struct
+{
+    const sw_net_t *net;
+    sw_sim_failure_cfg_t cfg;
+    sw_sim_failure_result_t *results;
+    uint32_t trials;
+    uint32_t next;
+} job_t;
+
+typedef struct
+{
+    job_t *job;
+    worker_t *w;
+} worker_arg_t;
+
+static worker_t g_workers[MAX_THREADS];
+
+static void build_mesh(sw_net_t *net, sw_net_node_t *nodes, sw_net_link_t *links)
+{
+    sw_net_init(net, nodes, NODES, links, MAX_LINKS);
+
+    /* Ports: 1 north, 2 east, 3 south, 4 west. */
+    for (unsigned i = 0; i < NODES; i++)
+        sw_net_add_node(net, 5, (uint8_t)(0x40u + i), NULL);
+
+    for (unsigned y = 0; y < SIDE; y++)
+    {
+        for (unsigned x = 0; x < SIDE; x++)
+        {
+            const uint16_t n = (uint16_t)(y * SIDE + x);
+            if (x + 1u < SIDE)
+                sw_net_connect(net, n, 2, (uint16_t)(n + 1u), 4, 200000000, 200, NULL);
+            if (y + 1u < SIDE)
+                sw_net_connect(net, n, 3, (uint16_t)(n + SIDE), 1, 200000000, 200, NULL);
+        }
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    const worker_arg_t *wa = (const worker_arg_t *)arg;
+    job_t *job = wa->job;
+    worker_t *w = wa->w;
+
+    sw_net_clone(&w->net, w->nodes, w->links, job->net);
+    sw_sim_init(&w->sim, &w->net, w->sim_nodes, w->events, EVENTS, 0);
+
+    const sw_net_work_t work = {.dist = w->dist, .heap = w->heap, .pos = w->pos};
+    sw_sim_failure_cfg_t cfg = job->cfg;
+
+    for (;;)
+    {
+        const uint32_t i = __atomic_fetch_add(&job->next, 1u, __ATOMIC_RELAXED);
+        if (i >= job->trials)
+            break;
+
+        cfg.seed = i;
+        sw_sim_link_failure_trial(&w->sim, &cfg, &work, w->tables, &job->results[i]);
+    }
+
+    return NULL;
+}
+
+/** Run all trials on @p threads threads; returns the wall time in seconds. */
+static double run(job_t *job, unsigned threads)
+{
+    pthread_t tid[MAX_THREADS];
+    worker_arg_t args[MAX_THREADS];
+
+    job->next = 0;
+    const uint64_t t0 = bench_now_ns();
+
+    for (unsigned t = 0; t < threads; t++)
+    {
+        args[t].job = job;
+        args[t].w = &g_workers[t];
+        pthread_create(&tid[t], NULL, worker_main, &args[t]);
+    }
+
+    for (unsigned t = 0; t < threads; t++)
+        pthread_join(tid[t], NULL);
+
+    return (double)(bench_now_ns() - t0) / 1e9;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *v, uint32_t n)
+{
+    qsort(v, n, sizeof(*v), cmp_double);
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; i++)
+        sum += v[i];
+
+    printf("  %-18s %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+           name,
+           sum / n,
+           v[n / 2u],
+           v[(uint32_t)((uint64_t)n * 90u / 100u)],
+           v[(uint32_t)((uint64_t)n * 99u / 100u)],
+           v[n - 1u]);
+}
+
+int main(void)
+{
+    const uint32_t trials = bench_env_uint("BENCH_TRIALS", 2000u);
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned threads = bench_env_uint("BENCH_THREADS", cpus > 0 ? (unsigned)cpus : 1u);
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    static sw_net_node_t nodes[NODES];
+    static sw_net_link_t links[MAX_LINKS];
+    sw_net_t net;
+    build_mesh(&net, nodes, links);
+
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    job.net = &net;
+    job.trials = trials;
+    job.results = calloc(trials, sizeof(*job.results));
+    job.cfg.link = SW_NET_NONE;
+    job.cfg.packet_len = 64;
+    job.cfg.interval_ns = 20000;
+    job.cfg.warmup_ns = 200000;
+    job.cfg.duration_ns = 2000000;
+    job.cfg.detect_ns = bench_env_uint("BENCH_DETECT_US", 50u) * 1000u;
+    job.cfg.install_spread_ns = bench_env_uint("BENCH_SPREAD_US", 200u) * 1000u;
+
+    double *v = calloc(trials, sizeof(*v));
+    if (!job.results || !v)
+        return 1;
+
+    printf("Link failure: %u trials, %ux%u router mesh, detect %u us, install window %u us\n",
+           (unsigned)trials,
+           SIDE,
+           SIDE,
+           (unsigned)(job.cfg.detect_ns / 1000u),
+           (unsigned)(job.cfg.install_spread_ns / 1000u));
+
+    const double t1 = run(&job, 1);
+    const double tn = run(&job, threads);
+    printf("  1 thread: %.0f trials/s, %u thread(s): %.0f trials/s (x%.1f)\n",
+           trials / t1,
+           threads,
+           trials / tn,
+           t1 / tn);
+
+    printf("  %-18s %10s %10s %10s %10s %10s\n", "metric", "mean", "p50", "p90", "p99", "max");
+
+    for (uint32_t i = 0; i < trials; i++)
+        v[i] = job.results[i].lost;
+    report("packets lost", v, trials);
+
+    for (uint32_t i = 0; i < trials; i++)
+        v[i] = (double)job.results[i].disruption_ns / 1000.0;
+    report("disruption (us)", v, trials);
+
+    for (uint32_t i = 0; i < trials; i++)
+        v[i] = (double)job.results[i].convergence_ns / 1000.0;
+    report("convergence (us)", v, trials);
+
+    for (uint32_t i = 0; i < trials; i++)
+        v[i] = job.results[i].routers_updated;
+    report("routers updated", v, trials);
+
+    free(v);
+    free(job.results);
+    return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file bench_nc.c
+ * @brief Worst-case delay analysis of many flows on a mesh.
+ *
+ * A mesh of routers, each with a node attached, is joined by 200 Mbit/s
+ * links of 500 ns and routed by sw_net_compute_routes(). Ports 1 and 2 lead
+ * east and west, 3 and 4 north and south, so the lowest-port choice among
+ * shortest paths is dimension-order (X then Y) routing, which cannot
+ * deadlock. Flows join random node pairs with 64..1024-octet packets, a
+ * burst of two packets and a rate of 2000 octets/s.
+ *
+ * For a growing number of flows the benchmark reports the analysis time of
+ * sw_nc_analyse(), how many flows it bounds, how many overload their source
+ * or deadlock, and the largest and median delay bounds.
+ *
+ * Tuning: BENCH_MESH (side, default 8), BENCH_FLOWS (default 800).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_nc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t g_rng = 2463534242u;
+
+static uint32_t rnd(uint32_t n)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng % n;
+}
+
+static void build_mesh(sw_net_t *net, uint16_t side)
+{
+    for (uint16_t i = 0; i < side * side; i++)
+        sw_net_add_node(net, 5, (uint8_t)(0x40u + i), NULL);
+
+    for (uint16_t y = 0; y < side; y++)
+    {
+        for (uint16_t x = 0; x < side; x++)
+        {
+            const uint16_t n = (uint16_t)(y * side + x);
+            if (x + 1u < side)
+                sw_net_connect(net, n, 1, (uint16_t)(n + 1u), 2, 200000000, 500, NULL);
+            if (y + 1u < side)
+                sw_net_connect(net, n, 4, (uint16_t)(n + side), 3, 200000000, 500, NULL);
+        }
+    }
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void)
+{
+    unsigned side = bench_env_uint("BENCH_MESH", 8u);
+    if (side * side > 190u)
+        side = 13u;
+    const unsigned max_flows = bench_env_uint("BENCH_FLOWS", 800u);
+    const uint16_t nodes_n = (uint16_t)(side * side);
+    const uint16_t links_n = (uint16_t)(2u * side * side);
+
+    sw_net_t net;
+    sw_net_node_t *nodes = calloc(nodes_n, sizeof(*nodes));
+    sw_net_link_t *links = calloc(links_n, sizeof(*links));
+    sw_net_init(&net, nodes, nodes_n, links, links_n);
+    build_mesh(&net, (uint16_t)side);
+
+    uint64_t *dist = calloc(nodes_n, sizeof(*dist));
+    uint16_t *heap = calloc(nodes_n, sizeof(*heap));
+    uint16_t *pos = calloc(nodes_n, sizeof(*pos));
+    uint8_t *table = calloc((size_t)nodes_n * SW_ROUTE_TABLE_SIZE, 1);
+    const sw_net_work_t net_work = {.dist = dist, .heap = heap, .pos = pos};
+    sw_net_compute_routes(&net, &net_work, table);
+    sw_net_install_routes(&net, table);
+
+    sw_nc_flow_t *flows = calloc(max_flows, sizeof(*flows));
+    sw_nc_bound_t *bounds = calloc(max_flows, sizeof(*bounds));
+    uint64_t *delays = calloc(max_flows, sizeof(*delays));
+    const size_t max_hops = (size_t)max_flows * 2u * side;
+    sw_nc_work_t work = {
+        .hops = calloc(max_hops, sizeof(sw_nc_hop_t)),
+        .max_hops = max_hops,
+        .out_head = calloc(2u * links_n, sizeof(uint32_t)),
+        .sources = calloc(nodes_n, sizeof(sw_nc_source_t)),
+    };
+
+    for (unsigned i = 0; i < max_flows; i++)
+    {
+        const uint16_t src = (uint16_t)rnd(nodes_n);
+        uint16_t dst = (uint16_t)rnd(nodes_n - 1u);
+        dst = (uint16_t)(dst + (dst >= src));
+        flows[i].src = src;
+        flows[i].dst_addr = (uint8_t)(0x40u + dst);
+        flows[i].max_len = (uint16_t)(64u + rnd(961u));
+        flows[i].burst = 2u * flows[i].max_len;
+        flows[i].rate = 2000u;
+    }
+
+    printf("Worst-case analysis: %ux%u mesh, 200 Mbit/s links, XY routes, "
+           "64..1024-octet packets\n",
+           side,
+           side);
+    printf("  %8s %12s %9s %9s %9s %14s %14s\n",
+           "flows",
+           "analysis us",
+           "bounded",
+           "overload",
+           "deadlock",
+           "max delay us",
+           "median us");
+
+    for (unsigned n = 100; n <= max_flows; n *= 2u)
+    {
+        const uint64_t t0 = bench_now_ns();
+        if (sw_nc_analyse(&net, flows, n, &work, bounds) != SW_OK)
+            return 1;
+        const uint64_t ns = bench_now_ns() - t0;
+
+        unsigned bounded = 0;
+        unsigned overload = 0;
+        unsigned deadlock = 0;
+        for (unsigned i = 0; i < n; i++)
+        {
+            if (bounds[i].status == SW_NC_BOUNDED)
+                delays[bounded++] = bounds[i].delay_ns;
+            overload += bounds[i].status == SW_NC_OVERLOAD;
+            deadlock += bounds[i].status == SW_NC_DEADLOCK;
+        }
+        qsort(delays, bounded, sizeof(*delays), cmp_u64);
+
+        printf("  %8u %12.1f %9u %9u %9u %14.1f %14.1f\n",
+               n,
+               (double)ns / 1e3,
+               bounded,
+               overload,
+               deadlock,
+               bounded ? (double)delays[bounded - 1u] / 1e3 : 0.0,
+               bounded ? (double)delays[bounded / 2u] / 1e3 : 0.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,456 @@
+/**
+ * @file bench_pipeline.c
+ * @brief Multi-threaded encode -> route -> decode pipeline.
+ *
+ * Each lane is three threads joined by SPSC descriptor rings:
+ *
+ *     producer i --ring--> router i --ring[i][c]--> consumer c
+ *
+ * Producers build CCSDS PTP packets with sw_packet_encode() into a private
+ * buffer pool, routers look up the logical address with sw_router_route()
+ * on their own router and forward the descriptor to the consumer serving
+ * the selected port, and consumers run sw_desc_decode() and hand the
+ * buffer back. Only descriptors cross threads; the octets stay in place.
+ *
+ * In the "inline" rows the producers store packets with
+ * sw_desc_set_packet() instead: those that fit travel inside the
+ * descriptor and their buffer is reused at once, the others by pointer as
+ * before. Routers and consumers handle both kinds through sw_desc_data()
+ * and sw_desc_decode().
+ *
+ * The benchmark reports packets per second, payload throughput, and the
+ * end-to-end latency (encode start to decode end) of every 16th packet, for
+ * 1, 2, 4, ... lanes and several payload sizes, with the smallest also
+ * inline. With more lanes than cores the threads time-share and the
+ * numbers measure the scheduler instead.
+ *
+ * @note sw_packet_encode() and sw_packet_decode() update the library's
+ *       unsynchronised global statistics, so with several lanes the producer
+ *       and consumer threads contend for that cache line; this is part of
+ *       what the benchmark measures. The counters themselves are not read.
+ *
+ * Tuning: BENCH_PACKETS (per lane, default 500000), BENCH_THREADS (default:
+ * online CPUs; lanes are limited to a third of it).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire.h"
+#include "spacewire_ring.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_LANES 8u
+#define RING_SLOTS 1024u
+#define POOL 2048u
+#define BUF_LEN 1100u
+#define BURST 32u
+#define SAMPLE_EVERY 16u
+#define MAX_SAMPLES (1u << 16)
+#define ADDRS 64u
+
+typedef struct
+{
+    uint8_t *bufs;               /**< POOL buffers of BUF_LEN octets. */
+    uint8_t busy[POOL];          /**< Set by the producer, cleared by the consumer. */
+    sw_ring_t out;               /**< To the router. */
+    sw_desc_t slots[RING_SLOTS]; /**< Storage of @ref out. */
+    uint32_t done;               /**< All packets pushed. */
+} producer_t;
+
+typedef struct
+{
+    sw_router_t router; /**< Private routing table and counters. */
+    uint32_t done;      /**< Input drained after the producer finished. */
+    uint64_t discarded; /**< Packets without a route. */
+} router_t;
+
+typedef struct
+{
+    uint64_t packets;              /**< Packets decoded and delivered. */
+    uint64_t octets;               /**< Payload octets delivered. */
+    uint64_t errors;               /**< Failed decodes or misrouted packets. */
+    uint32_t num_samples;          /**< Latency samples taken. */
+    uint64_t samples[MAX_SAMPLES]; /**< Latencies in ns. */
+} consumer_t;
+
+typedef struct
+{
+    unsigned lanes;                        /**< Threads per stage. */
+    uint32_t packets;                      /**< Packets per producer. */
+    uint16_t payload_len;                  /**< CCSDS data field length. */
+    int inline_small;                      /**< Store packets that fit inline. */
+    producer_t prod[MAX_LANES];            /**< Producer state, by lane. */
+    router_t rtr[MAX_LANES];               /**< Router state, by lane. */
+    consumer_t cons[MAX_LANES];            /**< Consumer state, by lane. */
+    sw_ring_t links[MAX_LANES][MAX_LANES]; /**< [router][consumer]. */
+    sw_desc_t *link_slots;                 /**< Storage of @ref links. */
+    uint32_t go;                           /**< Start signal. */
+} pipeline_t;
+
+typedef struct
+{
+    pipeline_t *p;
+    unsigned lane;
+} thread_arg_t;
+
+static const uint8_t g_payload[BUF_LEN] = {0};
+
+/* Busy-wait briefly, then let another thread of the pipeline run. */
+static void backoff(unsigned *spins)
+{
+    if (++*spins >= 64u)
+    {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+static void wait_go(const pipeline_t *p)
+{
+    unsigned spins = 0;
+    while (!__atomic_load_n(&p->go, __ATOMIC_ACQUIRE))
+        backoff(&spins);
+}
+
+/* Hand a descriptor's buffer back to its producer; inline ones hold none. */
+static void release(producer_t *pr, const sw_desc_t *d)
+{
+    if (!sw_desc_is_inline(d))
+        __atomic_store_n(&pr->busy[d->tag], 0, __ATOMIC_RELEASE);
+}
+
+static void push_all(sw_ring_t *ring, const sw_desc_t *descs, uint32_t n)
+{
+    unsigned spins = 0;
+    while (n > 0)
+    {
+        const uint32_t k = sw_ring_push_burst(ring, descs, n);
+        descs += k;
+        n -= k;
+        if (n > 0)
+            backoff(&spins);
+    }
+}
+
+static void *producer_main(void *arg)
+{
+    const thread_arg_t *ta = (const thread_arg_t *)arg;
+    pipeline_t *p = ta->p;
+    producer_t *pr = &p->prod[ta->lane];
+    sw_desc_t burst[BURST];
+    uint32_t n = 0;
+    unsigned spins = 0;
+
+    sw_packet_frame_t pf;
+    const sw_packet_config_t config = {.path = NULL,
+                                       .path_len = 0,
+                                       .logical_addr = 0x20,
+                                       .user_app = 0};
+    sw_packet_init(&pf, &config);
+    pf.packet.data = g_payload;
+    pf.packet.data_len = p->payload_len;
+
+    wait_go(p);
+
+    for (uint32_t seq = 0; seq < p->packets; seq++)
+    {
+        const uint16_t b = (uint16_t)(seq % POOL);
+        while (__atomic_load_n(&pr->busy[b], __ATOMIC_ACQUIRE))
+        {
+            /* Don't sit on a partial burst the consumers are waiting for. */
+            if (n > 0)
+            {
+                push_all(&pr->out, burst, n);
+                n = 0;
+            }
+            backoff(&spins);
+        }
+
+        sw_desc_t *d = &burst[n++];
+        d->timestamp = seq % SAMPLE_EVERY == 0 ? bench_now_ns() : 0;
+
+        pf.logical_addr = (uint8_t)(0x20u + seq % ADDRS);
+        pf.user_app = (uint8_t)(seq % 4u);
+        pf.packet.ph.apid = seq & 0x7FFu;
+
+        uint8_t *buf = &pr->bufs[(size_t)b * BUF_LEN];
+        const uint32_t len = (uint32_t)sw_packet_encode(&pf, buf, BUF_LEN);
+        d->port = 0;
+        d->end = SW_END_EOP;
+        d->tag = b;
+        if (p->inline_small)
+        {
+            sw_desc_set_packet(d, buf, len);
+        }
+        else
+        {
+            d->data = buf;
+            d->len = len;
+        }
+        if (!sw_desc_is_inline(d))
+            __atomic_store_n(&pr->busy[b], 1, __ATOMIC_RELAXED);
+
+        if (n == BURST)
+        {
+            push_all(&pr->out, burst, n);
+            n = 0;
+        }
+    }
+
+    push_all(&pr->out, burst, n);
+    __atomic_store_n(&pr->done, 1u, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *router_main(void *arg)
+{
+    const thread_arg_t *ta = (const thread_arg_t *)arg;
+    pipeline_t *p = ta->p;
+    producer_t *pr = &p->prod[ta->lane];
+    router_t *rt = &p->rtr[ta->lane];
+    sw_desc_t in[BURST];
+    sw_desc_t out[MAX_LANES][BURST];
+    uint32_t count[MAX_LANES];
+    unsigned spins = 0;
+
+    wait_go(p);
+
+    for (;;)
+    {
+        const uint32_t done = __atomic_load_n(&pr->done, __ATOMIC_ACQUIRE);
+        const uint32_t n = sw_ring_pop_burst(&pr->out, in, BURST);
+        if (n == 0)
+        {
+            if (done)
+                break;
+            backoff(&spins);
+            continue;
+        }
+
+        memset(count, 0, sizeof(count));
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint8_t port = 0;
+            uint8_t del = 0;
+            if (sw_router_route(&rt->router, sw_desc_data(&in[i]), in[i].len, &port, &del) !=
+                SW_ROUTE_OK)
+            {
+                /* Nothing to deliver; release the buffer here. */
+                rt->discarded++;
+                release(pr, &in[i]);
+                continue;
+            }
+
+            const unsigned c = (port - 1u) % p->lanes;
+            in[i].port = port;
+            out[c][count[c]++] = in[i];
+        }
+
+        for (unsigned c = 0; c < p->lanes; c++)
+            push_all(&p->links[ta->lane][c], out[c], count[c]);
+    }
+
+    __atomic_store_n(&rt->done, 1u, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *consumer_main(void *arg)
+{
+    const thread_arg_t *ta = (const thread_arg_t *)arg;
+    pipeline_t *p = ta->p;
+    consumer_t *co = &p->cons[ta->lane];
+    sw_desc_t in[BURST];
+    unsigned spins = 0;
+
+    wait_go(p);
+
+    for (;;)
+    {
+        unsigned finished = 0;
+        uint32_t got = 0;
+
+        for (unsigned r = 0; r < p->lanes; r++)
+        {
+            const uint32_t done = __atomic_load_n(&p->rtr[r].done, __ATOMIC_ACQUIRE);
+            const uint32_t n = sw_ring_pop_burst(&p->links[r][ta->lane], in, BURST);
+            if (n == 0 && done)
+                finished++;
+            got += n;
+
+            for (uint32_t i = 0; i < n; i++)
+            {
+                sw_packet_frame_t pf;
+                /* Each delivery is checked against the routing table set up below. */
+                if (sw_desc_decode(&pf, &in[i], NULL) == SW_OK &&
+                    (pf.logical_addr - 0x20u) % p->lanes == ta->lane)
+                {
+                    co->packets++;
+                    co->octets += pf.packet.data_len;
+                }
+                else
+                {
+                    co->errors++;
+                }
+
+                if (in[i].timestamp != 0 && co->num_samples < MAX_SAMPLES)
+                    co->samples[co->num_samples++] = bench_now_ns() - in[i].timestamp;
+
+                /* The buffer was lent by producer r (lanes are one-to-one). */
+                release(&p->prod[r], &in[i]);
+            }
+        }
+
+        if (finished == p->lanes)
+            break;
+        if (got == 0)
+            backoff(&spins);
+    }
+
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void setup(pipeline_t *p, unsigned lanes, uint16_t payload_len, uint32_t packets)
+{
+    p->lanes = lanes;
+    p->packets = packets;
+    p->payload_len = payload_len;
+    p->go = 0;
+
+    for (unsigned i = 0; i < lanes; i++)
+    {
+        producer_t *pr = &p->prod[i];
+        memset(pr->busy, 0, sizeof(pr->busy));
+        pr->done = 0;
+        sw_ring_init(&pr->out, pr->slots, RING_SLOTS);
+
+        /* Logical addresses are spread over the ports of all consumers. */
+        router_t *rt = &p->rtr[i];
+        sw_router_init(&rt->router, (uint8_t)(lanes + 1u));
+        for (unsigned a = 0; a < ADDRS; a++)
+            sw_router_add_route(&rt->router, (uint8_t)(0x20u + a), (uint8_t)(1u + a % lanes), 0);
+        rt->done = 0;
+        rt->discarded = 0;
+
+        memset(&p->cons[i], 0, offsetof(consumer_t, samples));
+
+        for (unsigned c = 0; c < lanes; c++)
+            sw_ring_init(&p->links[i][c],
+                         &p->link_slots[((size_t)i * MAX_LANES + c) * RING_SLOTS],
+                         RING_SLOTS);
+    }
+}
+
+static void run(pipeline_t *p, unsigned lanes, uint16_t payload_len, uint32_t packets,
+                int inline_small)
+{
+    pthread_t tid[3u * MAX_LANES];
+    thread_arg_t args[MAX_LANES];
+    static uint64_t samples[MAX_LANES * MAX_SAMPLES];
+
+    setup(p, lanes, payload_len, packets);
+    p->inline_small = inline_small;
+
+    for (unsigned i = 0; i < lanes; i++)
+    {
+        args[i].p = p;
+        args[i].lane = i;
+        pthread_create(&tid[3u * i], NULL, consumer_main, &args[i]);
+        pthread_create(&tid[3u * i + 1u], NULL, router_main, &args[i]);
+        pthread_create(&tid[3u * i + 2u], NULL, producer_main, &args[i]);
+    }
+
+    const uint64_t t0 = bench_now_ns();
+    __atomic_store_n(&p->go, 1u, __ATOMIC_RELEASE);
+    for (unsigned t = 0; t < 3u * lanes; t++)
+        pthread_join(tid[t], NULL);
+    const uint64_t t1 = bench_now_ns();
+
+    uint64_t delivered = 0;
+    uint64_t octets = 0;
+    uint64_t lost = 0;
+    uint32_t n = 0;
+    for (unsigned i = 0; i < lanes; i++)
+    {
+        delivered += p->cons[i].packets;
+        octets += p->cons[i].octets;
+        lost += p->cons[i].errors + p->rtr[i].discarded;
+        memcpy(&samples[n], p->cons[i].samples, p->cons[i].num_samples * sizeof(samples[0]));
+        n += p->cons[i].num_samples;
+    }
+    qsort(samples, n, sizeof(samples[0]), cmp_u64);
+
+    const double secs = (double)(t1 - t0) / 1e9;
+    printf("  %5u %8u %-7s %10.2f %10.2f %10.1f %10.1f %8llu\n",
+           lanes,
+           (unsigned)payload_len,
+           inline_small ? "inline" : "pool",
+           (double)delivered / secs / 1e6,
+           (double)octets * 8.0 / secs / 1e9,
+           n > 0 ? (double)samples[n / 2u] / 1e3 : 0.0,
+           n > 0 ? (double)samples[n - 1u - n / 100u] / 1e3 : 0.0,
+           (unsigned long long)lost);
+}
+
+int main(void)
+{
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 500000u);
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const unsigned threads = bench_env_uint("BENCH_THREADS", cpus > 0 ? (unsigned)cpus : 1u);
+    const uint16_t payloads[] = {16, 256, 1024};
+
+    unsigned max_lanes = threads / 3u;
+    if (max_lanes > MAX_LANES)
+        max_lanes = MAX_LANES;
+    if (max_lanes == 0)
+        max_lanes = 1;
+
+    static pipeline_t p;
+    for (unsigned i = 0; i < MAX_LANES; i++)
+        p.prod[i].bufs = malloc((size_t)POOL * BUF_LEN);
+    p.link_slots = calloc((size_t)MAX_LANES * MAX_LANES * RING_SLOTS, sizeof(sw_desc_t));
+    if (!p.link_slots)
+        return 1;
+    for (unsigned i = 0; i < MAX_LANES; i++)
+    {
+        if (!p.prod[i].bufs)
+            return 1;
+    }
+
+    printf("Pipeline encode -> route -> decode: %u packets per lane, up to %u lanes\n",
+           (unsigned)packets,
+           max_lanes);
+    printf("  %5s %8s %-7s %10s %10s %10s %10s %8s\n",
+           "lanes",
+           "payload",
+           "desc",
+           "Mpps",
+           "Gbit/s",
+           "p50 us",
+           "p99 us",
+           "lost");
+
+    for (unsigned lanes = 1; lanes <= max_lanes; lanes *= 2u)
+    {
+        for (unsigned s = 0; s < sizeof(payloads) / sizeof(payloads[0]); s++)
+            run(&p, lanes, payloads[s], packets, 0);
+        run(&p, lanes, payloads[0], packets, 1);
+    }
+
+    for (unsigned i = 0; i < MAX_LANES; i++)
+        free(p.prod[i].bufs);
+    free(p.link_slots);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * @file bench_psim.c
+ * @brief Parallel versus sequential discrete-event simulation of a large mesh.
+ *
+ * A 14 x 14 mesh of routers, each with a node attached (logical addresses
+ * 0x20 upwards), carries uniform random traffic; one link fails half-way
+ * through. The run is simulated by the sequential engine and then by the
+ * parallel one with 1, 2, 4, ... partitions (one thread each, blocks of mesh
+ * rows). Every parallel run is checked to leave exactly the node states of
+ * the sequential run.
+ *
+ * The benchmark reports events per second and the speedup over the
+ * sequential engine, together with the number of windows and the lookahead.
+ *
+ * Tuning: BENCH_THREADS (default: online CPUs), BENCH_SIM_US (default 20000).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_psim.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SIDE 14u
+#define NODES (SIDE * SIDE)
+#define MAX_LINKS (2u * SIDE * (SIDE - 1u))
+#define EVENTS (1u << 16)
+#define QUEUE_LEN (1u << 14)
+#define MAX_THREADS 16u
+
+typedef struct
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[MAX_LINKS];
+    sw_sim_t sim;
+    sw_sim_node_t sim_nodes[NODES];
+} model_t;
+
+typedef struct
+{
+    sw_psim_t *psim;
+    uint16_t part;
+    uint64_t until;
+    uint64_t processed;
+} thread_arg_t;
+
+static void build(model_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    sw_net_init(&m->net, m->nodes, NODES, m->links, MAX_LINKS);
+
+    /* Ports: 1 north, 2 east, 3 south, 4 west. */
+    for (unsigned i = 0; i < NODES; i++)
+        sw_net_add_node(&m->net, 5, (uint8_t)(0x20u + i), NULL);
+
+    for (unsigned y = 0; y < SIDE; y++)
+    {
+        for (unsigned x = 0; x < SIDE; x++)
+        {
+            const uint16_t n = (uint16_t)(y * SIDE + x);
+            if (x + 1u < SIDE)
+                sw_net_connect(&m->net, n, 2, (uint16_t)(n + 1u), 4, 200000000, 1000, NULL);
+            if (y + 1u < SIDE)
+                sw_net_connect(&m->net, n, 3, (uint16_t)(n + SIDE), 1, 200000000, 1000, NULL);
+        }
+    }
+}
+
+/** Routes, traffic and a link failure at @p t_fail, rerouted 20 us later. */
+static void prepare(model_t *m,
+                    sw_sim_event_t *events,
+                    uint8_t *tables,
+                    const sw_net_work_t *work,
+                    uint64_t t_fail)
+{
+    const uint16_t failing = (uint16_t)(MAX_LINKS / 2u);
+    uint8_t *after = &tables[NODES * SW_ROUTE_TABLE_SIZE];
+
+    sw_net_compute_routes(&m->net, work, tables);
+    sw_net_install_routes(&m->net, tables);
+    m->links[failing].up = 0;
+    sw_net_compute_routes(&m->net, work, after);
+    m->links[failing].up = 1;
+
+    sw_sim_init(&m->sim, &m->net, m->sim_nodes, events, EVENTS, 11);
+    for (uint16_t n = 0; n < NODES; n++)
+        sw_sim_set_traffic(&m->sim, n, 40000, 64);
+
+    uint16_t t = 0;
+    sw_sim_add_table(&m->sim, after, &t);
+    sw_sim_schedule_link(&m->sim, failing, t_fail, 0);
+    for (uint16_t n = 0; n < NODES; n++)
+        sw_sim_schedule_install(&m->sim, n, t_fail + 20000u, t);
+}
+
+static void *thread_main(void *arg)
+{
+    thread_arg_t *ta = (thread_arg_t *)arg;
+    ta->processed = sw_psim_run(ta->psim, ta->part, ta->until);
+    return NULL;
+}
+
+int main(void)
+{
+    const uint64_t until = (uint64_t)bench_env_uint("BENCH_SIM_US", 20000u) * 1000u;
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned max_threads = bench_env_uint("BENCH_THREADS", cpus > 0 ? (unsigned)cpus : 1u);
+    if (max_threads > MAX_THREADS)
+        max_threads = MAX_THREADS;
+    if (max_threads == 0)
+        max_threads = 1;
+
+    static model_t seq;
+    static model_t par;
+    static uint8_t tables[2u * NODES * SW_ROUTE_TABLE_SIZE];
+    static uint64_t dist[NODES];
+    static uint16_t heap[NODES];
+    static uint16_t pos[NODES];
+    static uint16_t owner[NODES];
+    static sw_psim_t psim;
+    static sw_sim_t parts[MAX_THREADS];
+    static sw_psim_queue_t queues[MAX_THREADS * MAX_THREADS];
+
+    sw_sim_event_t *seq_events = calloc(EVENTS, sizeof(*seq_events));
+    sw_sim_event_t *events = calloc((size_t)MAX_THREADS * EVENTS, sizeof(*events));
+    sw_sim_event_t *slots =
+        calloc((size_t)MAX_THREADS * MAX_THREADS * QUEUE_LEN, sizeof(*slots));
+    if (!seq_events || !events || !slots)
+        return 1;
+
+    const sw_net_work_t work = {.dist = dist, .heap = heap, .pos = pos};
+
+    build(&seq);
+    prepare(&seq, seq_events, tables, &work, until / 2u);
+    uint64_t t0 = bench_now_ns();
+    const uint64_t seq_processed = sw_sim_run(&seq.sim, until);
+    const double t_seq = (double)(bench_now_ns() - t0) / 1e9;
+
+    sw_sim_stats_t st;
+    sw_sim_get_stats(&seq.sim, &st);
+
+    printf("Parallel simulation: %ux%u router mesh, %u us simulated, %llu events\n",
+           SIDE,
+           SIDE,
+           (unsigned)(until / 1000u),
+           (unsigned long long)seq_processed);
+    printf("  generated %u, delivered %u, lost %u\n",
+           (unsigned)st.generated,
+           (unsigned)st.delivered,
+           (unsigned)(st.lost_link + st.lost_no_route + st.lost_hops));
+    printf("  %-12s %10s %14s %10s %12s %10s\n",
+           "engine",
+           "threads",
+           "Mevents/s",
+           "speedup",
+           "windows",
+           "identical");
+    printf("  %-12s %10u %14.2f %10.2f %12s %10s\n",
+           "sequential",
+           1u,
+           (double)seq_processed / t_seq / 1e6,
+           1.0,
+           "-",
+           "-");
+
+    int mismatches = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2u)
+    {
+        pthread_t tid[MAX_THREADS];
+        thread_arg_t args[MAX_THREADS];
+
+        build(&par);
+        prepare(&par, events, tables, &work, until / 2u);
+        sw_psim_partition_blocks(&par.net, (uint16_t)threads, owner);
+        if (sw_psim_init(&psim, &par.sim, parts, (uint16_t)threads, owner, events, EVENTS,
+                         queues, slots, QUEUE_LEN) != SW_OK)
+            return 1;
+
+        t0 = bench_now_ns();
+        for (unsigned t = 0; t < threads; t++)
+        {
+            args[t].psim = &psim;
+            args[t].part = (uint16_t)t;
+            args[t].until = until;
+            pthread_create(&tid[t], NULL, thread_main, &args[t]);
+        }
+
+        uint64_t processed = 0;
+        for (unsigned t = 0; t < threads; t++)
+        {
+            pthread_join(tid[t], NULL);
+            processed += args[t].processed;
+        }
+        const double t_par = (double)(bench_now_ns() - t0) / 1e9;
+
+        const int same = memcmp(seq.sim_nodes, par.sim_nodes, sizeof(seq.sim_nodes)) == 0 &&
+                         processed == seq_processed;
+        mismatches += !same;
+
+        printf("  %-12s %10u %14.2f %10.2f %12llu %10s\n",
+               "parallel",
+               threads,
+               (double)processed / t_par / 1e6,
+               t_seq / t_par,
+               (unsigned long long)psim.windows,
+               same ? "yes" : "NO");
+    }
+
+    if (max_threads > 1u)
+        printf("  lookahead %llu ns\n", (unsigned long long)psim.lookahead);
+
+    free(seq_events);
+    free(events);
+    free(slots);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file bench_resolve.c
+ * @brief Fused multi-hop route resolution against routing hop by hop.
+ *
+ * A chain of k routers (8 ports each) is crossed by packets whose header
+ * has k - 1 path octets, chosen at random, and a logical address that the
+ * last router maps to a port. 256 such packets with 64-octet payloads are
+ * resolved over and over:
+ *
+ * - per hop: as a simulator does, the packet is copied once and each router
+ *   calls sw_router_route() on it, deleting the leading octet with memmove()
+ *   whenever the router asks for it;
+ * - resolve: one sw_router_resolve() call on the original packet.
+ *
+ * The benchmark reports nanoseconds per packet for each, and checks that
+ * both chose the same ports and deleted the same octets.
+ *
+ * Tuning: BENCH_PACKETS (per chain length and path, default 5000000).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_packet.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_HOPS 16u
+#define PKTS 256u
+#define BUF_LEN 96u
+
+static sw_router_t g_routers[MAX_HOPS];
+static const sw_router_t *g_chain[MAX_HOPS];
+static uint8_t g_pkts[PKTS][BUF_LEN];
+static size_t g_lens[PKTS];
+
+static void build(uint32_t hops)
+{
+    static const uint8_t payload[64] = {0};
+    uint32_t rng = 0x1234567u;
+
+    for (uint32_t i = 0; i < hops; i++)
+    {
+        sw_router_init(&g_routers[i], 8);
+        g_chain[i] = &g_routers[i];
+    }
+    sw_router_add_route(&g_routers[hops - 1u], 0x42, 5, 0);
+
+    for (uint32_t p = 0; p < PKTS; p++)
+    {
+        for (uint32_t i = 0; i + 1u < hops; i++)
+        {
+            rng = rng * 1103515245u + 12345u;
+            g_pkts[p][i] = (uint8_t)(1u + (rng >> 16) % 7u);
+        }
+        g_lens[p] = hops - 1u + sw_packet_create(0x42,
+                                                 0,
+                                                 (uint16_t)p,
+                                                 payload,
+                                                 sizeof(payload),
+                                                 &g_pkts[p][hops - 1u],
+                                                 BUF_LEN - (hops - 1u));
+    }
+}
+
+static uint64_t run_per_hop(uint32_t packets, uint32_t hops, uint32_t *check)
+{
+    uint8_t copy[BUF_LEN];
+    uint32_t sum = 0;
+
+    const uint64_t t0 = bench_now_ns();
+    for (uint32_t n = 0; n < packets; n++)
+    {
+        const uint32_t p = n % PKTS;
+        size_t len = g_lens[p];
+        memcpy(copy, g_pkts[p], len);
+
+        for (uint32_t i = 0; i < hops; i++)
+        {
+            uint8_t port = 0;
+            uint8_t del = 0;
+            if (sw_router_route(&g_routers[i], copy, len, &port, &del) != SW_ROUTE_OK)
+                break;
+            sum += port;
+            if (del)
+                memmove(copy, &copy[1], --len);
+        }
+        sum += (uint32_t)(g_lens[p] - len);
+    }
+    const uint64_t ns = bench_now_ns() - t0;
+
+    *check = sum;
+    return ns;
+}
+
+static uint64_t run_resolve(uint32_t packets, uint32_t hops, uint32_t *check)
+{
+    uint8_t ports[MAX_HOPS];
+    uint32_t sum = 0;
+
+    const uint64_t t0 = bench_now_ns();
+    for (uint32_t n = 0; n < packets; n++)
+    {
+        const uint32_t p = n % PKTS;
+        size_t consumed = 0;
+        size_t done = 0;
+
+        sw_router_resolve(g_chain, hops, g_pkts[p], g_lens[p], ports, &consumed, &done);
+        for (size_t i = 0; i < done; i++)
+            sum += ports[i];
+        sum += (uint32_t)consumed;
+    }
+    const uint64_t ns = bench_now_ns() - t0;
+
+    *check = sum;
+    return ns;
+}
+
+int main(void)
+{
+    static const uint32_t chains[] = {1, 2, 4, 8, 16};
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 5000000u);
+
+    printf("Multi-hop resolution: %u packets per chain\n", (unsigned)packets);
+    printf("  %5s %12s %12s %8s %6s\n", "hops", "per-hop ns", "resolve ns", "speedup", "ports");
+
+    for (size_t c = 0; c < sizeof(chains) / sizeof(chains[0]); c++)
+    {
+        const uint32_t hops = chains[c];
+        uint32_t a = 0;
+        uint32_t b = 0;
+
+        build(hops);
+        const uint64_t per_hop = run_per_hop(packets, hops, &a);
+        const uint64_t fused = run_resolve(packets, hops, &b);
+
+        printf("  %5u %12.2f %12.2f %7.1fx %6s\n",
+               (unsigned)hops,
+               (double)per_hop / packets,
+               (double)fused / packets,
+               (double)per_hop / (double)fused,
+               a == b ? "ok" : "DIFF");
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file bench_route_update.c
+ * @brief Incremental route updates versus full recomputation after link flaps.
+ *
+ * A thousand routers, 200 of them with a node attached, are joined in a ring
+ * with random chords (up to six links per router). Each flap takes a random
+ * link down and brings it back. Every update is applied incrementally with
+ * sw_net_spf_set_link() and, for comparison, by recomputing every table with
+ * sw_net_compute_routes(); the two tables are checked to be identical.
+ *
+ * The benchmark reports the time per update of both, the routing-table
+ * entries each update changes, and the entries a full reinstall rewrites.
+ *
+ * Tuning: BENCH_NODES (default 1000), BENCH_FLAPS (default 25).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_net.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_PORTS 7u
+#define ADDRS 200u
+
+static uint32_t g_rng = 2463534242u;
+
+static uint32_t rnd(uint32_t n)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng % n;
+}
+
+static void build(sw_net_t *net, uint16_t num_nodes)
+{
+    uint8_t *next_port = calloc(num_nodes, 1);
+    const uint16_t stride = (uint16_t)(num_nodes / ADDRS);
+
+    for (uint16_t i = 0; i < num_nodes; i++)
+    {
+        const int addressed = i % stride == 0 && i / stride < ADDRS;
+        sw_net_add_node(net, MAX_PORTS, addressed ? (uint8_t)(0x30u + i / stride) : 0u, NULL);
+        next_port[i] = 1;
+    }
+
+    for (uint16_t i = 0; i < num_nodes; i++)
+    {
+        const uint16_t j = (uint16_t)((i + 1u) % num_nodes);
+        sw_net_connect(net, i, next_port[i]++, j, next_port[j]++, 100000000, 100, NULL);
+    }
+
+    for (unsigned tries = 0; tries < 4u * num_nodes; tries++)
+    {
+        const uint16_t a = (uint16_t)rnd(num_nodes);
+        const uint16_t b = (uint16_t)rnd(num_nodes);
+        if (a == b || next_port[a] >= MAX_PORTS || next_port[b] >= MAX_PORTS ||
+            net->num_links >= net->max_links)
+            continue;
+        sw_net_connect(net, a, next_port[a]++, b, next_port[b]++, 100000000, 100, NULL);
+    }
+
+    free(next_port);
+}
+
+int main(void)
+{
+    unsigned num_nodes = bench_env_uint("BENCH_NODES", 1000u);
+    const unsigned flaps = bench_env_uint("BENCH_FLAPS", 25u);
+    if (num_nodes < ADDRS)
+        num_nodes = ADDRS;
+    if (num_nodes > 8000u)
+        num_nodes = 8000u; /* links are indexed by uint16_t */
+
+    const uint16_t n = (uint16_t)num_nodes;
+    const uint16_t max_links = (uint16_t)(n * MAX_PORTS / 2u);
+    const size_t table_size = (size_t)n * SW_ROUTE_TABLE_SIZE;
+    const size_t max_changes = (size_t)n * SW_NET_NUM_ADDRS;
+
+    sw_net_t net;
+    sw_net_node_t *nodes = calloc(n, sizeof(*nodes));
+    sw_net_link_t *links = calloc(max_links, sizeof(*links));
+    uint64_t *spf_dist = calloc((size_t)SW_NET_NUM_ADDRS * n, sizeof(*spf_dist));
+    uint64_t *dist = calloc(n, sizeof(*dist));
+    uint16_t *heap = calloc(n, sizeof(*heap));
+    uint16_t *pos = calloc(n, sizeof(*pos));
+    uint16_t *list = calloc(n, sizeof(*list));
+    uint8_t *mark = calloc(n, 1);
+    uint8_t *table = calloc(table_size, 1);
+    uint8_t *full = calloc(table_size, 1);
+    sw_net_route_change_t *changes = calloc(max_changes, sizeof(*changes));
+
+    if (!nodes || !links || !spf_dist || !dist || !heap || !pos || !list || !mark || !table ||
+        !full || !changes)
+        return 1;
+
+    sw_net_init(&net, nodes, n, links, max_links);
+    build(&net, n);
+
+    const sw_net_work_t work = {
+        .dist = dist, .heap = heap, .pos = pos, .list = list, .mark = mark};
+    sw_net_spf_t spf;
+    sw_net_spf_init(&spf, &net, spf_dist, table, &work);
+
+    uint64_t t_inc = 0;
+    uint64_t t_full = 0;
+    uint64_t changed = 0;
+    unsigned mismatches = 0;
+    unsigned updates = 0;
+
+    for (unsigned f = 0; f < flaps; f++)
+    {
+        const uint16_t l = (uint16_t)rnd(net.num_links);
+
+        for (int up = 0; up < 2; up++)
+        {
+            size_t count = 0;
+            const uint64_t t0 = bench_now_ns();
+            sw_net_spf_set_link(&spf, &net, l, up, 1, changes, max_changes, &count);
+            const uint64_t t1 = bench_now_ns();
+            sw_net_compute_routes(&net, &work, full);
+            const uint64_t t2 = bench_now_ns();
+
+            t_inc += t1 - t0;
+            t_full += t2 - t1;
+            changed += count;
+            mismatches += memcmp(table, full, table_size) != 0;
+            updates++;
+        }
+    }
+
+    printf("Route updates: %u nodes, %u links, %u addresses, %u link flaps\n",
+           (unsigned)n,
+           (unsigned)net.num_links,
+           ADDRS,
+           flaps);
+    printf("  %-24s %12s %16s\n", "method", "us/update", "entries/update");
+    printf("  %-24s %12.1f %16.1f\n",
+           "full recomputation",
+           (double)t_full / updates / 1e3,
+           (double)n * ADDRS);
+    printf("  %-24s %12.1f %16.1f\n",
+           "incremental",
+           (double)t_inc / updates / 1e3,
+           (double)changed / updates);
+    printf("  speedup x%.1f, tables identical: %s\n",
+           (double)t_full / (double)(t_inc ? t_inc : 1u),
+           mismatches == 0 ? "yes" : "NO");
+
+    free(nodes);
+    free(links);
+    free(spf_dist);
+    free(dist);
+    free(heap);
+    free(pos);
+    free(list);
+    free(mark);
+    free(table);
+    free(full);
+    free(changes);
+    return mismatches == 0 ? 0 : 1;
+}
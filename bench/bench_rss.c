@@ -0,0 +1,235 @@
+/**
+ * @file bench_rss.c
+ * @brief Receive steering of skewed traffic across decode workers.
+ *
+ * A receive thread steers packets with sw_rss_steer_burst() to N worker
+ * threads, each popping its own ring and running sw_packet_decode(). The
+ * traffic is 1024 flows (logical address, user application, APID) of
+ * 64-octet payloads, skewed: every other packet belongs to one of 8 heavy
+ * flows. Each worker checks that a flow's packets reach it in order; a flow
+ * whose bucket moves continues, in order, at another worker.
+ *
+ * For 1, 2, 4, ... workers the benchmark runs once with the initial
+ * indirection table and once calling sw_rss_rebalance() every 16384
+ * packets, and reports the packet rate, the busiest worker's share against
+ * an even share, the buckets moved and the packets that failed to decode or
+ * arrived out of order. A first row decodes on the receive thread alone.
+ * With more threads than cores they time-share and the rates measure the
+ * scheduler instead.
+ *
+ * Tuning: BENCH_PACKETS (default 2000000), BENCH_THREADS (default: online
+ * CPUs; workers are limited to one less).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_rss.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_WORKERS 16u
+#define RING_SLOTS 1024u
+#define FLOWS 1024u
+#define HEAVY 8u
+#define BUF_LEN 96u
+#define BURST 32u
+#define REBALANCE_EVERY 16384u
+
+typedef struct
+{
+    sw_ring_t *ring;             /**< From the receive thread. */
+    sw_desc_t slots[RING_SLOTS]; /**< Storage of @ref ring. */
+    const uint32_t *done;        /**< Set when the receive thread has finished. */
+    uint32_t next[FLOWS];        /**< Lowest sequence number still in order, by flow. */
+    uint64_t packets;            /**< Packets decoded. */
+    uint64_t errors;             /**< Failed decodes and out-of-order packets. */
+} worker_t;
+
+static worker_t g_workers[MAX_WORKERS];
+static sw_ring_t g_rings[MAX_WORKERS];
+static uint8_t g_pkts[FLOWS][BUF_LEN];
+static uint32_t g_lens[FLOWS];
+
+static void build_flows(void)
+{
+    static const uint8_t payload[64] = {0};
+
+    for (uint32_t f = 0; f < FLOWS; f++)
+        g_lens[f] = (uint32_t)sw_packet_create((uint8_t)(0x20u + f % 64u),
+                                               (uint8_t)(f / 64u % 4u),
+                                               (uint16_t)(f & 0x7FFu),
+                                               payload,
+                                               sizeof(payload),
+                                               g_pkts[f],
+                                               BUF_LEN);
+}
+
+/** Flow of the i-th packet: every other one is heavy. */
+static uint32_t flow_of(uint32_t i)
+{
+    return (i & 1u) ? (i >> 1) % HEAVY : HEAVY + (i >> 1) % (FLOWS - HEAVY);
+}
+
+static void *worker_main(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    sw_desc_t in[BURST];
+    sw_packet_frame_t pf;
+
+    for (;;)
+    {
+        const uint32_t done = __atomic_load_n(w->done, __ATOMIC_ACQUIRE);
+        const uint32_t n = sw_ring_pop_burst(w->ring, in, BURST);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            const uint16_t f = in[i].tag;
+            w->errors += sw_desc_decode(&pf, &in[i], NULL) != SW_OK;
+            w->errors += in[i].timestamp < w->next[f];
+            w->next[f] = (uint32_t)in[i].timestamp + 1u;
+        }
+        w->packets += n;
+
+        if (n == 0)
+        {
+            if (done)
+                break;
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/* Decode on the receive thread alone. */
+static void run_single(uint32_t packets)
+{
+    sw_packet_frame_t pf;
+    uint64_t errors = 0;
+
+    const uint64_t t0 = bench_now_ns();
+    for (uint32_t i = 0; i < packets; i++)
+    {
+        const uint32_t f = flow_of(i);
+        errors += sw_packet_decode(&pf, g_pkts[f], g_lens[f], SW_END_EOP, NULL) != SW_OK;
+    }
+    const uint64_t ns = bench_now_ns() - t0;
+
+    printf("  %7s %9s %8.2f %10s %7s %7llu\n",
+           "-",
+           "no",
+           (double)packets * 1e3 / (double)ns,
+           "-",
+           "-",
+           (unsigned long long)errors);
+}
+
+static void run(unsigned workers, int rebalance, uint32_t packets)
+{
+    static sw_rss_t rss;
+    pthread_t tid[MAX_WORKERS];
+    uint32_t done = 0;
+    uint32_t seq[FLOWS] = {0};
+    uint64_t moved = 0;
+
+    for (unsigned i = 0; i < workers; i++)
+    {
+        worker_t *w = &g_workers[i];
+        memset(w->next, 0, sizeof(w->next));
+        w->packets = 0;
+        w->errors = 0;
+        w->done = &done;
+        w->ring = &g_rings[i];
+        sw_ring_init(w->ring, w->slots, RING_SLOTS);
+    }
+
+    sw_rss_init(&rss, g_rings, (uint8_t)workers, 0x5EEDu);
+    for (unsigned i = 0; i < workers; i++)
+        pthread_create(&tid[i], NULL, worker_main, &g_workers[i]);
+
+    const uint64_t t0 = bench_now_ns();
+    sw_desc_t burst[BURST];
+    memset(burst, 0, sizeof(burst));
+    for (uint32_t i = 0; i < packets; i += BURST)
+    {
+        const uint32_t n = packets - i < BURST ? packets - i : BURST;
+        for (uint32_t k = 0; k < n; k++)
+        {
+            const uint32_t f = flow_of(i + k);
+            burst[k].data = g_pkts[f];
+            burst[k].len = g_lens[f];
+            burst[k].end = SW_END_EOP;
+            burst[k].tag = (uint16_t)f;
+            burst[k].timestamp = seq[f]++;
+        }
+
+        for (uint32_t k = 0; k < n;)
+        {
+            const uint32_t m = sw_rss_steer_burst(&rss, &burst[k], n - k);
+            k += m;
+            if (m == 0)
+                sched_yield();
+        }
+
+        if (rebalance && (i + BURST) % REBALANCE_EVERY == 0)
+            moved += sw_rss_rebalance(&rss);
+    }
+    __atomic_store_n(&done, 1u, __ATOMIC_RELEASE);
+    for (unsigned i = 0; i < workers; i++)
+        pthread_join(tid[i], NULL);
+    const uint64_t ns = bench_now_ns() - t0;
+
+    uint64_t busiest = 0;
+    uint64_t errors = 0;
+    for (unsigned i = 0; i < workers; i++)
+    {
+        if (g_workers[i].packets > busiest)
+            busiest = g_workers[i].packets;
+        errors += g_workers[i].errors;
+    }
+
+    printf("  %7u %9s %8.2f %10.2f %7llu %7llu\n",
+           workers,
+           rebalance ? "yes" : "no",
+           (double)packets * 1e3 / (double)ns,
+           (double)busiest * workers / (double)packets,
+           (unsigned long long)moved,
+           (unsigned long long)errors);
+}
+
+int main(void)
+{
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 2000000u);
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const unsigned threads = bench_env_uint("BENCH_THREADS", cpus > 0 ? (unsigned)cpus : 1u);
+
+    unsigned max_workers = threads > 1u ? threads - 1u : 1u;
+    if (max_workers > MAX_WORKERS)
+        max_workers = MAX_WORKERS;
+
+    build_flows();
+
+    printf("Receive steering: %u packets, %u flows, half of them in %u heavy flows\n",
+           (unsigned)packets,
+           FLOWS,
+           HEAVY);
+    printf("  %7s %9s %8s %10s %7s %7s\n",
+           "workers",
+           "rebalance",
+           "Mpps",
+           "max/even",
+           "moved",
+           "errors");
+
+    run_single(packets);
+    for (unsigned w = 1; w <= max_workers; w *= 2u)
+    {
+        run(w, 0, packets);
+        run(w, 1, packets);
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file bench_rtshare.c
+ * @brief Routers sharing one routing table against a private table each.
+ *
+ * A simulation holds N routers (8 ports each) with identical routes: 64
+ * logical addresses spread over ports 1..7. The routers are set up twice:
+ *
+ * - private: each router is configured in its own table;
+ * - shared: one table is configured (sw_router_set_routes()) and every
+ *   router uses it (sw_router_share_routes()).
+ *
+ * Routers are the same size either way; sharing changes how many tables
+ * the routing decisions read. For each layout the benchmark reports the
+ * routing tables in use and the nanoseconds per packet when packets for
+ * random addresses arrive at random routers, and, for the shared layout,
+ * the cost of the first route change at 64 of the routers (each copies the
+ * shared table into its own). It checks that both layouts chose the same
+ * ports.
+ *
+ * Tuning: BENCH_ROUTERS (default 20000), BENCH_PACKETS (per layout,
+ * default 10000000).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ADDRS 64u
+#define CHANGES 64u
+#define PKTS 4096u
+
+static sw_router_t *g_routers;
+static sw_route_table_t g_shared;
+static uint32_t g_dst[PKTS];
+static uint8_t g_pkts[PKTS][2];
+
+static void configure(sw_router_t *router)
+{
+    for (uint32_t a = 0; a < ADDRS; a++)
+        sw_router_add_route(router, (uint8_t)(0x40u + a), (uint8_t)(1u + a % 7u), 0);
+}
+
+static void build_private(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        sw_router_init(&g_routers[i], 8);
+        configure(&g_routers[i]);
+    }
+}
+
+static void build_shared(uint32_t n)
+{
+    sw_router_init(&g_routers[0], 8);
+    configure(&g_routers[0]);
+    sw_router_set_routes(&g_routers[0], &g_shared);
+
+    for (uint32_t i = 1; i < n; i++)
+    {
+        sw_router_init(&g_routers[i], 8);
+        sw_router_share_routes(&g_routers[i], &g_routers[0]);
+    }
+}
+
+static uint64_t run(uint32_t packets, uint32_t *check)
+{
+    uint32_t sum = 0;
+
+    const uint64_t t0 = bench_now_ns();
+    for (uint32_t p = 0; p < packets; p++)
+    {
+        const uint32_t k = p % PKTS;
+        uint8_t port = 0;
+        uint8_t del = 0;
+
+        sw_router_route(&g_routers[g_dst[k]], g_pkts[k], 2, &port, &del);
+        sum += port;
+    }
+    const uint64_t ns = bench_now_ns() - t0;
+
+    *check = sum;
+    return ns;
+}
+
+int main(void)
+{
+    const uint32_t n = bench_env_uint("BENCH_ROUTERS", 20000u);
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 10000000u);
+    uint32_t rng = 0xC0FFEEu;
+
+    g_routers = calloc(n, sizeof(*g_routers));
+    if (!g_routers || n < CHANGES + 1u)
+        return 1;
+
+    for (uint32_t k = 0; k < PKTS; k++)
+    {
+        rng = rng * 1103515245u + 12345u;
+        g_dst[k] = (rng >> 8) % n;
+        g_pkts[k][0] = (uint8_t)(0x40u + (rng >> 4) % ADDRS);
+        g_pkts[k][1] = 0;
+    }
+
+    printf("Shared routing tables: %u routers, %u routes each, %u packets\n",
+           (unsigned)n,
+           ADDRS,
+           (unsigned)packets);
+    printf("  %-8s %8s %10s\n", "layout", "tables", "route ns");
+
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    build_private(n);
+    const uint64_t private_ns = run(packets, &a);
+    printf("  %-8s %8u %10.2f\n", "private", (unsigned)n, (double)private_ns / packets);
+
+    build_shared(n);
+    const uint64_t shared_ns = run(packets, &b);
+    printf("  %-8s %8u %10.2f  %s\n",
+           "shared",
+           1u,
+           (double)shared_ns / packets,
+           a == b ? "ok" : "DIFF");
+
+    /* First change at 64 routers: each copies the shared table. */
+    const uint64_t t0 = bench_now_ns();
+    for (uint32_t i = 0; i < CHANGES; i++)
+        sw_router_add_route(&g_routers[1u + i * ((n - 1u) / CHANGES)], 0x40, 2, 1);
+    const uint64_t cow_ns = bench_now_ns() - t0;
+    printf("  copy-on-write: %.0f ns per first change\n", (double)cow_ns / CHANGES);
+
+    free(g_routers);
+    return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file bench_sched.c
+ * @brief Work stealing versus static per-port pinning under skewed load.
+ *
+ * Eight input ports share a worker pool. Two ports carry 80 % of the traffic
+ * and both are homed on worker 0, the placement a one-thread-per-port-group
+ * pinning would give them. Each burst routes, decodes and re-encodes up to 32
+ * packets. The benchmark reports throughput and per-worker utilisation (the
+ * share of polls that found work) with and without stealing.
+ *
+ * Tuning: BENCH_PACKETS (default 2000000), BENCH_WORKERS (default 4).
+ *
+ * @note sw_packet_encode() and sw_packet_decode() bump the process-global
+ *       statistics block, which is shared by all workers here.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire.h"
+#include "spacewire_packet.h"
+#include "spacewire_sched.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_PORTS 8u
+#define BURST 32u
+#define MAX_WORKERS 16u
+
+typedef struct
+{
+    uint32_t backlog; /* packets still waiting on this port */
+    uint8_t rx[64];
+    size_t rx_len;
+    uint8_t tx[64];
+} port_t;
+
+typedef struct
+{
+    port_t ports[NUM_PORTS];
+    sw_router_t routers[MAX_WORKERS]; /* one per worker: the counters are not shared */
+    sw_sched_t sched;
+    sw_sched_worker_t workers[MAX_WORKERS];
+    uint32_t remaining;
+    uint32_t go;
+} bench_t;
+
+typedef struct
+{
+    bench_t *b;
+    unsigned id;
+} worker_arg_t;
+
+static bench_t g_bench;
+
+static size_t poll_port(void *ctx, uint16_t task, unsigned worker)
+{
+    bench_t *b = (bench_t *)ctx;
+    port_t *p = &b->ports[task];
+    const uint32_t n = p->backlog < BURST ? p->backlog : BURST;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint8_t out_port = 0;
+        uint8_t del = 0;
+        sw_router_route(&b->routers[worker], p->rx, p->rx_len, &out_port, &del);
+
+        sw_packet_frame_t pf;
+        if (sw_packet_decode(&pf, p->rx, p->rx_len, SW_END_EOP, NULL) == SW_OK)
+            sw_packet_encode(&pf, p->tx, sizeof(p->tx));
+    }
+
+    p->backlog -= n;
+    if (n > 0)
+        __atomic_fetch_sub(&b->remaining, n, __ATOMIC_RELAXED);
+
+    return n;
+}
+
+static void *worker_main(void *arg)
+{
+    const worker_arg_t *wa = (const worker_arg_t *)arg;
+    bench_t *b = wa->b;
+
+    while (!__atomic_load_n(&b->go, __ATOMIC_ACQUIRE))
+        ;
+
+    while (__atomic_load_n(&b->remaining, __ATOMIC_RELAXED) > 0)
+        sw_sched_run_once(&b->sched, wa->id);
+
+    return NULL;
+}
+
+static void run(unsigned num_workers, uint32_t flags, uint32_t packets)
+{
+    bench_t *b = &g_bench;
+    memset(b, 0, sizeof(*b));
+
+    static const uint8_t payload[16] = {0};
+    for (unsigned p = 0; p < NUM_PORTS; p++)
+    {
+        b->ports[p].rx_len = sw_packet_create(
+            0x40, 0x01, (uint16_t)(0x100u + p), payload, sizeof(payload), b->ports[p].rx, 64);
+        /* Ports 0 and 4 share a home worker and carry 40 % each. */
+        b->ports[p].backlog = (p == 0 || p == 4) ? packets / 10u * 4u : packets / 30u;
+        b->remaining += b->ports[p].backlog;
+    }
+
+    for (unsigned w = 0; w < num_workers; w++)
+    {
+        sw_router_init(&b->routers[w], 4);
+        sw_router_add_route(&b->routers[w], 0x40, 1, 0);
+    }
+
+    sw_sched_init(&b->sched, b->workers, num_workers, NUM_PORTS, poll_port, b, flags);
+
+    pthread_t threads[MAX_WORKERS];
+    worker_arg_t args[MAX_WORKERS];
+    for (unsigned w = 0; w < num_workers; w++)
+    {
+        args[w].b = b;
+        args[w].id = w;
+        pthread_create(&threads[w], NULL, worker_main, &args[w]);
+    }
+
+    const uint32_t total = b->remaining;
+    const uint64_t t0 = bench_now_ns();
+    __atomic_store_n(&b->go, 1u, __ATOMIC_RELEASE);
+
+    for (unsigned w = 0; w < num_workers; w++)
+        pthread_join(threads[w], NULL);
+
+    const double secs = (double)(bench_now_ns() - t0) / 1e9;
+
+    double util_min = 1.0;
+    double util_sum = 0.0;
+    uint32_t steals = 0;
+    for (unsigned w = 0; w < num_workers; w++)
+    {
+        const sw_sched_worker_t *wk = &b->workers[w];
+        const double polls = (double)wk->busy_polls + wk->idle_polls + wk->empty_polls;
+        const double util = polls > 0 ? (double)wk->busy_polls / polls : 0.0;
+        util_sum += util;
+        if (util < util_min)
+            util_min = util;
+        steals += wk->steals;
+    }
+
+    printf("  %-8s %7u %10.2f %10.1f %%  %8.1f %%  %10u\n",
+           (flags & SW_SCHED_STATIC) ? "static" : "stealing",
+           num_workers,
+           (double)total / secs / 1e6,
+           100.0 * util_sum / num_workers,
+           100.0 * util_min,
+           steals);
+}
+
+int main(void)
+{
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 2000000u);
+    unsigned max_workers = bench_env_uint("BENCH_WORKERS", 4u);
+    if (max_workers > MAX_WORKERS)
+        max_workers = MAX_WORKERS;
+
+    printf("Port scheduler: %u packets, 8 ports, 80 %% of load on two ports of worker 0\n",
+           (unsigned)packets);
+    printf("  %-8s %7s %10s %12s %10s %11s\n",
+           "mode",
+           "workers",
+           "Mpps",
+           "util(avg)",
+           "util(min)",
+           "steals");
+
+    for (unsigned w = 1; w <= max_workers; w *= 2)
+    {
+        run(w, SW_SCHED_STATIC, packets);
+        run(w, 0, packets);
+    }
+
+    return 0;
+}
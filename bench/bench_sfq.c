@@ -0,0 +1,159 @@
+/**
+ * @file bench_sfq.c
+ * @brief Store-and-forward queue: spill and drain rates through a mapped file.
+ *
+ * A link outage is simulated on one output port: packets of 64..1024 octets
+ * in four priorities are spilled into a store-and-forward queue kept in a
+ * file mapped with MAP_SHARED, committing and writing back (msync) every
+ * BENCH_COMMIT packets. The queue is then reopened from the file as after a
+ * crash, and drained to a link stub that copies each packet out and checks
+ * priority order and per-priority FIFO order.
+ *
+ * The benchmark reports the spill rate, the reopen time and the drain rate,
+ * to compare with SpaceWire (up to 400 Mbit/s) and SpaceFibre (6.25 Gbit/s)
+ * link rates.
+ *
+ * Tuning: BENCH_LOG_MB (default 256), BENCH_COMMIT (default 8192).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_sfq.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+typedef struct
+{
+    uint8_t out[2048];        /* the link's transmit buffer */
+    uint32_t last[SW_SFQ_PRIORITIES];
+    uint8_t priority;
+    uint64_t octets;
+    uint64_t errors;
+} link_t;
+
+static uint64_t g_rng = 0x2545F4914F6CDD1Du;
+
+static uint64_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+static int link_send(void *ctx, uint8_t priority, const uint8_t *pkt, uint32_t len)
+{
+    link_t *link = ctx;
+    uint32_t id;
+
+    memcpy(link->out, pkt, len);
+    memcpy(&id, link->out, sizeof(id));
+    link->errors += priority < link->priority || id <= link->last[priority];
+    link->last[priority] = id;
+    link->priority = priority;
+    link->octets += len;
+    return 0;
+}
+
+int main(void)
+{
+    const uint32_t log_mb = bench_env_uint("BENCH_LOG_MB", 256u);
+    const uint32_t commit_every = bench_env_uint("BENCH_COMMIT", 8192u);
+    const size_t size = sw_sfq_region_size((uint64_t)log_mb << 20);
+
+    char path[] = "/tmp/bench_sfq_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0)
+        return 1;
+    unlink(path);
+    if (ftruncate(fd, (off_t)size) != 0)
+        return 1;
+
+    uint8_t *region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (region == MAP_FAILED)
+        return 1;
+
+    static sw_sfq_t q;
+    if (sw_sfq_format(&q, region, size) != SW_OK)
+        return 1;
+
+    /* Outage: spill until the log is full. */
+    static uint8_t pkt[1024];
+    static uint32_t ids[SW_SFQ_PRIORITIES];
+    uint64_t spilled_octets = 0;
+    uint32_t since_commit = 0;
+
+    for (size_t i = 0; i < sizeof(pkt); i++)
+        pkt[i] = (uint8_t)rnd();
+
+    uint64_t t0 = bench_now_ns();
+    for (;;)
+    {
+        const uint64_t r = rnd();
+        const uint32_t len = 64u + (uint32_t)(r % 961u);
+        const uint8_t priority = (uint8_t)((r >> 32) % SW_SFQ_PRIORITIES);
+        const uint32_t id = ++ids[priority];
+
+        memcpy(pkt, &id, sizeof(id));
+        if (sw_sfq_push(&q, priority, pkt, len) != SW_OK)
+            break;
+        spilled_octets += len;
+
+        if (++since_commit == commit_every)
+        {
+            msync(region, size, MS_SYNC);
+            sw_sfq_commit(&q);
+            msync(region, SW_SFQ_META_SIZE, MS_SYNC);
+            since_commit = 0;
+        }
+    }
+    msync(region, size, MS_SYNC);
+    sw_sfq_commit(&q);
+    msync(region, SW_SFQ_META_SIZE, MS_SYNC);
+    const uint64_t spill_ns = bench_now_ns() - t0;
+    const uint64_t packets = q.spilled;
+
+    /* Restart: reopen from the file. */
+    t0 = bench_now_ns();
+    if (sw_sfq_open(&q, region, size) != SW_OK)
+        return 1;
+    const uint64_t open_ns = bench_now_ns() - t0;
+
+    /* Link back: drain at whatever rate the link stub takes. */
+    static link_t link;
+    t0 = bench_now_ns();
+    const size_t drained = sw_sfq_drain(&q, link_send, &link, SIZE_MAX);
+    const uint64_t drain_ns = bench_now_ns() - t0;
+
+    printf("Store-and-forward queue: %u MB log in a mapped file, %llu packets "
+           "(%.1f MB), commit every %u, state %u octets in RAM\n",
+           (unsigned)log_mb,
+           (unsigned long long)packets,
+           (double)spilled_octets / 1e6,
+           (unsigned)commit_every,
+           (unsigned)sizeof(sw_sfq_t));
+    printf("  %-10s %12s %12s %12s\n", "phase", "ms", "Mpkt/s", "Gbit/s");
+    printf("  %-10s %12.1f %12.2f %12.2f\n",
+           "spill",
+           (double)spill_ns / 1e6,
+           (double)packets * 1e3 / (double)spill_ns,
+           (double)spilled_octets * 8.0 / (double)spill_ns);
+    printf("  %-10s %12.1f\n", "reopen", (double)open_ns / 1e6);
+    printf("  %-10s %12.1f %12.2f %12.2f\n",
+           "drain",
+           (double)drain_ns / 1e6,
+           (double)drained * 1e3 / (double)drain_ns,
+           (double)link.octets * 8.0 / (double)drain_ns);
+    printf("  drained %llu of %llu, order errors %llu\n",
+           (unsigned long long)drained,
+           (unsigned long long)packets,
+           (unsigned long long)link.errors);
+
+    munmap(region, size);
+    close(fd);
+    return drained == packets && link.errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,272 @@
+/**
+ * @file bench_spfi.c
+ * @brief SpaceFibre VC framing against character-level SpaceWire emulation.
+ *
+ * The same CCSDS PTP packets (built with sw_packet_encode(), 16..1024-octet
+ * payloads, four virtual channels with 40/30/20/10 percent reserved) are
+ * carried over two software links:
+ *
+ * - SpaceFibre: packets are queued on their VC, packed into data frames by
+ *   sw_spfi_tx_next_frame(), unpacked by sw_spfi_rx_frame() and the FCT
+ *   returned, with every VC kept saturated;
+ * - SpaceWire: each octet is sent as a data character and each packet ends
+ *   with an EOP, under the standard credit of 8 characters per FCT with a
+ *   56-character receive buffer, one character at a time, as a CODEC would.
+ *
+ * For each it reports the host throughput of the emulation and the modelled
+ * line efficiency: packet bits over line bits (SpaceFibre words are 40 line
+ * bits after 8B/10B; SpaceWire data characters 10 bits, EOP and FCT 4). The
+ * SpaceFibre rows also give each VC's share of the lane against its
+ * reservation.
+ *
+ * Tuning: BENCH_PACKETS (default 400000).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire.h"
+#include "spacewire_spfi.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define VCS 4u
+#define POOL 256u
+#define BUF_LEN 1100u
+#define SLOTS 64u
+
+static uint8_t g_pool[POOL][BUF_LEN];
+static uint32_t g_len[POOL];
+
+typedef struct
+{
+    uint32_t next[VCS]; /**< Pool index each VC expects next. */
+    uint64_t packets;   /**< Packets delivered. */
+    uint64_t octets;    /**< Packet octets delivered. */
+    uint64_t errors;    /**< Packets of an unexpected length. */
+} sink_t;
+
+static void sink_packet(sink_t *s, uint8_t vc, const uint8_t *pkt, uint32_t len)
+{
+    const uint32_t i = s->next[vc];
+    s->errors += len != g_len[i] || pkt[len - 1u] != g_pool[i][len - 1u];
+    s->next[vc] = (i + VCS) % POOL;
+    s->packets++;
+    s->octets += len;
+}
+
+static void on_spfi_packet(void *ctx,
+                           uint8_t vc,
+                           const uint8_t *pkt,
+                           uint32_t len,
+                           sw_end_marker_t end)
+{
+    (void)end;
+    sink_packet(ctx, vc, pkt, len);
+}
+
+static void build_pool(void)
+{
+    static uint8_t payload[1024];
+    uint64_t x = 0x9E3779B97F4A7C15u;
+
+    for (size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 13u);
+
+    for (uint32_t i = 0; i < POOL; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+
+        sw_packet_frame_t pf;
+        const sw_packet_config_t config = {.path = NULL,
+                                           .path_len = 0,
+                                           .logical_addr = 0x40,
+                                           .user_app = 0};
+        sw_packet_init(&pf, &config);
+        sw_packet_set_virtual_channel(&pf, (sw_virtual_channel_t)(i % VCS));
+        pf.packet.ph.apid = (unsigned)(i & 0x7FFu);
+        pf.packet.data = payload;
+        pf.packet.data_len = (uint16_t)(16u + x % 1009u);
+        g_len[i] = (uint32_t)sw_packet_encode(&pf, g_pool[i], BUF_LEN);
+    }
+}
+
+/* ============================================================================
+ * SPACEFIBRE
+ * ============================================================================ */
+
+static void run_spfi(uint64_t packets)
+{
+    static const sw_spfi_vc_config_t configs[VCS] = {
+        {.priority = 0, .bandwidth = 40},
+        {.priority = 0, .bandwidth = 30},
+        {.priority = 0, .bandwidth = 20},
+        {.priority = 0, .bandwidth = 10},
+    };
+    static sw_spfi_tx_t tx;
+    static sw_spfi_rx_t rx;
+    static sw_ring_t rings[VCS];
+    static sw_desc_t slots[VCS][SLOTS];
+    static uint8_t rx_bufs[VCS][BUF_LEN];
+    static sink_t sink;
+    uint32_t next[VCS] = {0, 1, 2, 3};
+    uint64_t queued = 0;
+    sw_spfi_frame_t frame;
+
+    sw_spfi_tx_init(&tx);
+    sw_spfi_rx_init(&rx, on_spfi_packet, &sink);
+    for (uint8_t v = 0; v < VCS; v++)
+    {
+        sw_ring_init(&rings[v], slots[v], SLOTS);
+        sw_spfi_tx_add_vc(&tx, v, &configs[v], &rings[v]);
+        sw_spfi_tx_map(&tx, v, v);
+        sw_spfi_tx_fct(&tx, v, 8); /* far-end buffer: 8 frames per VC */
+        sw_spfi_rx_add_vc(&rx, v, rx_bufs[v], BUF_LEN);
+        sink.next[v] = v;
+    }
+
+    const uint64_t t0 = bench_now_ns();
+    while (sink.packets < packets)
+    {
+        /* Keep every VC saturated. */
+        for (uint8_t v = 0; v < VCS && queued < packets; v++)
+        {
+            while (queued < packets)
+            {
+                const uint32_t i = next[v];
+                const sw_desc_t d = {.data = g_pool[i], .len = g_len[i], .end = SW_END_EOP};
+                if (sw_spfi_tx_enqueue(&tx, v, &d) != SW_OK)
+                    break;
+                next[v] = (i + VCS) % POOL;
+                queued++;
+            }
+        }
+
+        if (sw_spfi_tx_next_frame(&tx, &frame) != SW_OK)
+            break;
+        sw_spfi_rx_frame(&rx, &frame);
+        sw_spfi_tx_fct(&tx, frame.vc, 1);
+    }
+    const uint64_t ns = bench_now_ns() - t0;
+
+    const double line_bits = (double)tx.words * 40.0;
+    printf("  %-12s %10.2f %12.1f%% %10llu %8llu\n",
+           "SpaceFibre",
+           (double)sink.octets * 8.0 / (double)ns,
+           (double)sink.octets * 8.0 * 100.0 / line_bits,
+           (unsigned long long)sink.packets,
+           (unsigned long long)(sink.errors + rx.crc_errors));
+    for (uint8_t v = 0; v < VCS; v++)
+    {
+        printf("    VC %u: %5.1f%% of the lane (reserved %u%%)\n",
+               (unsigned)v,
+               (double)tx.vc[v].words * 100.0 / (double)tx.words,
+               (unsigned)configs[v].bandwidth);
+    }
+}
+
+/* ============================================================================
+ * SPACEWIRE
+ * ============================================================================ */
+
+/** @brief Character-level SpaceWire link: credit, receive buffer, sink. */
+typedef struct
+{
+    uint32_t credit;      /**< Characters the transmitter may send. */
+    uint8_t fifo[56];     /**< Receive buffer. */
+    uint32_t fifo_head;   /**< Next character to read. */
+    uint32_t fifo_count;  /**< Characters buffered. */
+    uint8_t fifo_eop[56]; /**< 1 where the character is an EOP. */
+    uint32_t consumed;    /**< Characters read since the last FCT. */
+    uint8_t pkt[BUF_LEN]; /**< Packet being reassembled. */
+    uint32_t pkt_len;     /**< Its length so far. */
+    uint64_t line_bits;   /**< Line bits, both directions. */
+} spw_link_t;
+
+/* Receiver side: drain the buffer and return FCTs, 8 characters each. */
+static void spw_receive(spw_link_t *l, sink_t *s)
+{
+    while (l->fifo_count > 0)
+    {
+        const uint32_t h = l->fifo_head;
+        if (l->fifo_eop[h])
+        {
+            sink_packet(s, l->pkt[3], l->pkt, l->pkt_len);
+            l->pkt_len = 0;
+        }
+        else
+        {
+            l->pkt[l->pkt_len++] = l->fifo[h];
+        }
+        l->fifo_head = (h + 1u) % sizeof(l->fifo);
+        l->fifo_count--;
+
+        if (++l->consumed == 8u)
+        {
+            l->consumed = 0;
+            l->credit += 8u;
+            l->line_bits += 4u;
+        }
+    }
+}
+
+/* Transmitter side: one character, once there is credit for it. */
+static void spw_send(spw_link_t *l, sink_t *s, uint8_t ch, uint8_t eop)
+{
+    if (l->credit == 0)
+        spw_receive(l, s);
+
+    const uint32_t tail = (l->fifo_head + l->fifo_count) % sizeof(l->fifo);
+    l->fifo[tail] = ch;
+    l->fifo_eop[tail] = eop;
+    l->fifo_count++;
+    l->credit--;
+    l->line_bits += eop ? 4u : 10u;
+}
+
+static void run_spw(uint64_t packets)
+{
+    static spw_link_t link;
+    static sink_t sink;
+
+    link.credit = 56u;
+    for (uint8_t v = 0; v < VCS; v++)
+        sink.next[v] = v;
+
+    const uint64_t t0 = bench_now_ns();
+    for (uint64_t n = 0; n < packets; n++)
+    {
+        /* Round-robin over the VCs: SpaceWire has no reservation. */
+        const uint32_t i = (uint32_t)(n % POOL);
+        for (uint32_t k = 0; k < g_len[i]; k++)
+            spw_send(&link, &sink, g_pool[i][k], 0);
+        spw_send(&link, &sink, 0, 1);
+    }
+    spw_receive(&link, &sink);
+    const uint64_t ns = bench_now_ns() - t0;
+
+    printf("  %-12s %10.2f %12.1f%% %10llu %8llu\n",
+           "SpaceWire",
+           (double)sink.octets * 8.0 / (double)ns,
+           (double)sink.octets * 8.0 * 100.0 / (double)link.line_bits,
+           (unsigned long long)sink.packets,
+           (unsigned long long)sink.errors);
+}
+
+int main(void)
+{
+    const uint64_t packets = bench_env_uint("BENCH_PACKETS", 400000u);
+
+    build_pool();
+
+    printf("SpaceFibre VC layer vs SpaceWire characters: %llu packets, "
+           "16..1024-octet payloads, %u VCs\n",
+           (unsigned long long)packets,
+           VCS);
+    printf("  %-12s %10s %13s %10s %8s\n", "link", "host Gb/s", "line effic.", "packets", "errors");
+    run_spfi(packets);
+    run_spw(packets);
+    return 0;
+}
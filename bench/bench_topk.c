@@ -0,0 +1,144 @@
+/**
+ * @file bench_topk.c
+ * @brief Heavy-hitter detector: update cost and accuracy against exact counts.
+ *
+ * A stream of packets is drawn from many (logical address, VC, APID) flows
+ * with Zipf popularity (s = 1) and random lengths. For several counter
+ * budgets K, the benchmark reports the cost per packet and how well the
+ * reported top 10 matches the exact top 10: recall and the largest relative
+ * error of the reported octet counts.
+ *
+ * Tuning: BENCH_PACKETS (default 5000000), BENCH_FLOWS (default 100000).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_topk.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TOP 10u
+
+static uint64_t g_rng = 0x9E3779B97F4A7C15u;
+
+static uint64_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+static uint32_t flow_key(uint32_t f)
+{
+    return SW_TOPK_KEY(0x20u + f % 223u, (f / 223u) % 8u, f % 2048u);
+}
+
+/* Flow index of rank r in the exact counts, i.e. the exact top list. */
+static void exact_top(const uint64_t *exact, uint32_t flows, uint32_t *top)
+{
+    for (unsigned i = 0; i < TOP; i++)
+        top[i] = UINT32_MAX;
+
+    for (uint32_t f = 0; f < flows; f++)
+    {
+        unsigned i = TOP;
+        while (i > 0 && (top[i - 1u] == UINT32_MAX || exact[top[i - 1u]] < exact[f]))
+            i--;
+        if (i >= TOP)
+            continue;
+        memmove(&top[i + 1u], &top[i], (TOP - 1u - i) * sizeof(top[0]));
+        top[i] = f;
+    }
+}
+
+int main(void)
+{
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 5000000u);
+    const uint32_t flows = bench_env_uint("BENCH_FLOWS", 100000u);
+    const uint16_t budgets[] = {64, 256, 1024};
+
+    double *cdf = calloc(flows, sizeof(*cdf));
+    uint32_t *stream = calloc(packets, sizeof(*stream));
+    uint16_t *lens = calloc(packets, sizeof(*lens));
+    uint64_t *exact = calloc(flows, sizeof(*exact));
+    sw_topk_entry_t *entries = calloc(1024, sizeof(*entries));
+    uint16_t *heap = calloc(1024, sizeof(*heap));
+    uint16_t *index = calloc(2048, sizeof(*index));
+    if (!cdf || !stream || !lens || !exact || !entries || !heap || !index)
+        return 1;
+
+    /* Zipf popularity: flow f is drawn with weight 1 / (f + 1). */
+    double sum = 0.0;
+    for (uint32_t f = 0; f < flows; f++)
+        cdf[f] = (sum += 1.0 / ((double)f + 1.0));
+
+    for (uint32_t i = 0; i < packets; i++)
+    {
+        const double u = (double)(rnd() >> 11) / 9007199254740992.0 * sum;
+        uint32_t lo = 0;
+        uint32_t hi = flows - 1u;
+        while (lo < hi)
+        {
+            const uint32_t mid = (lo + hi) / 2u;
+            if (cdf[mid] < u)
+                lo = mid + 1u;
+            else
+                hi = mid;
+        }
+        stream[i] = lo;
+        lens[i] = (uint16_t)(16u + rnd() % 1009u);
+        exact[lo] += lens[i];
+    }
+
+    uint32_t top[TOP];
+    exact_top(exact, flows, top);
+
+    printf("Heavy hitters: %u packets over %u flows (Zipf s=1), top %u\n",
+           (unsigned)packets,
+           (unsigned)flows,
+           TOP);
+    printf("  %-8s %12s %10s %14s\n", "K", "ns/packet", "recall", "max rel err");
+
+    for (unsigned b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++)
+    {
+        sw_topk_t topk;
+        sw_topk_entry_t found[TOP];
+        sw_topk_init(&topk, entries, heap, budgets[b], index, 2u * budgets[b]);
+
+        const uint64_t t0 = bench_now_ns();
+        for (uint32_t i = 0; i < packets; i++)
+            sw_topk_add(&topk, flow_key(stream[i]), lens[i]);
+        const uint64_t t1 = bench_now_ns();
+
+        const uint16_t n = sw_topk_top(&topk, found, TOP);
+        unsigned hits = 0;
+        double max_err = 0.0;
+        for (unsigned i = 0; i < TOP; i++)
+        {
+            const uint64_t est = sw_topk_estimate(&topk, flow_key(top[i]), NULL);
+            const double diff = (double)est - (double)exact[top[i]];
+            const double err = (diff < 0.0 ? -diff : diff) / (double)exact[top[i]];
+            if (err > max_err)
+                max_err = err;
+            for (uint16_t j = 0; j < n; j++)
+                hits += found[j].key == flow_key(top[i]);
+        }
+
+        printf("  %-8u %12.1f %9.0f%% %13.2f%%\n",
+               (unsigned)budgets[b],
+               (double)(t1 - t0) / packets,
+               100.0 * hits / TOP,
+               100.0 * max_err);
+    }
+
+    free(cdf);
+    free(stream);
+    free(lens);
+    free(exact);
+    free(entries);
+    free(heap);
+    free(index);
+    return 0;
+}
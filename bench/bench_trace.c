@@ -0,0 +1,260 @@
+/**
+ * @file bench_trace.c
+ * @brief Span tracing: cost on the packet path and a two-thread trace.
+ *
+ * One thread runs bursts of 32 packets through sw_packet_encode(),
+ * sw_ring_push_burst(), sw_ring_pop_burst(), sw_router_route() and
+ * sw_packet_decode(), first with no trace buffer attached, then sampling one
+ * burst in 16, then tracing every burst. The benchmark reports the time per
+ * packet and the overhead against the untraced run.
+ *
+ * It then runs the same stages as a producer thread (encode, push) and a
+ * consumer thread (pop, route, decode) with one burst in 16 traced, the
+ * burst number travelling in ::sw_desc_t::timestamp as the trace identifier.
+ * If BENCH_TRACE_OUT names a file, the trace is written there as Chrome trace
+ * JSON for chrome://tracing or ui.perfetto.dev.
+ *
+ * Tuning: BENCH_BURSTS (default 100000), BENCH_TRACE_OUT (unset).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire.h"
+#include "spacewire_ring.h"
+#include "spacewire_trace.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BURST 32u
+#define RING_SLOTS 1024u
+#define BUF_LEN 256u
+#define SAMPLE 16u
+#define TRACE_EVENTS (1u << 16)
+
+static uint8_t g_payload[128];
+static uint8_t g_bufs[RING_SLOTS][BUF_LEN];
+static sw_desc_t g_slots[RING_SLOTS];
+static sw_ring_t g_ring;
+static sw_router_t g_router;
+static uint32_t g_bursts;
+static uint64_t g_delivered;
+
+static sw_trace_event_t g_events[3][TRACE_EVENTS];
+static sw_trace_buf_t g_trace[3];
+
+static void make_frame(sw_packet_frame_t *pf)
+{
+    const sw_packet_config_t config = {.path = NULL,
+                                       .path_len = 0,
+                                       .logical_addr = 0x40,
+                                       .user_app = 0};
+    sw_packet_init(pf, &config);
+    pf->packet.data = g_payload;
+    pf->packet.data_len = sizeof(g_payload);
+}
+
+/* Encode one burst into the buffers starting at slot @p first. */
+static void encode_burst(sw_packet_frame_t *pf, sw_desc_t *descs, uint32_t burst)
+{
+    const uint32_t first = (burst * BURST) & (RING_SLOTS - 1u);
+
+    for (uint32_t i = 0; i < BURST; i++)
+    {
+        sw_desc_t *d = &descs[i];
+        pf->packet.ph.apid = (unsigned)((burst + i) & 0x7FFu);
+        d->data = g_bufs[first + i];
+        d->len = (uint32_t)sw_packet_encode(pf, d->data, BUF_LEN);
+        d->end = SW_END_EOP;
+        d->timestamp = burst;
+    }
+}
+
+static void deliver(const sw_desc_t *descs, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint8_t port = 0;
+        uint8_t del = 0;
+        sw_packet_frame_t pf;
+
+        if (sw_router_route(&g_router, sw_desc_data(&descs[i]), descs[i].len, &port, &del) ==
+                SW_ROUTE_OK &&
+            sw_desc_decode(&pf, &descs[i], NULL) == SW_OK)
+            g_delivered++;
+    }
+}
+
+/* All stages on one thread; returns ns per packet. */
+static double run_inline(sw_trace_buf_t *buf)
+{
+    sw_packet_frame_t pf;
+    sw_desc_t descs[BURST];
+
+    make_frame(&pf);
+    sw_trace_attach(buf);
+
+    const uint64_t t0 = bench_now_ns();
+    for (uint32_t b = 0; b < g_bursts; b++)
+    {
+        sw_trace_set_id(b);
+        encode_burst(&pf, descs, b);
+        sw_ring_push_burst(&g_ring, descs, BURST);
+        const uint32_t n = sw_ring_pop_burst(&g_ring, descs, BURST);
+        deliver(descs, n);
+    }
+    const uint64_t ns = bench_now_ns() - t0;
+
+    sw_trace_attach(NULL);
+    return (double)ns / ((double)g_bursts * BURST);
+}
+
+static void *producer_main(void *arg)
+{
+    sw_packet_frame_t pf;
+    sw_desc_t descs[BURST];
+
+    (void)arg;
+    make_frame(&pf);
+    sw_trace_attach(&g_trace[1]);
+
+    for (uint32_t b = 0; b < g_bursts; b++)
+    {
+        sw_trace_set_id(b);
+        encode_burst(&pf, descs, b);
+
+        /* A burst may only reuse buffers the consumer has drained. */
+        while (sw_ring_count(&g_ring) > RING_SLOTS - 2u * BURST)
+            sched_yield();
+
+        for (uint32_t done = 0; done < BURST;)
+        {
+            done += sw_ring_push_burst(&g_ring, &descs[done], BURST - done);
+            if (done < BURST)
+                sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *consumer_main(void *arg)
+{
+    sw_desc_t descs[BURST];
+    uint64_t packets = 0;
+
+    (void)arg;
+    sw_trace_attach(&g_trace[2]);
+
+    while (packets < (uint64_t)g_bursts * BURST)
+    {
+        /* The identifier of the burst at the ring head decides sampling. */
+        const uint32_t avail = sw_ring_count(&g_ring);
+        if (avail == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        sw_trace_set_id((uint32_t)g_slots[g_ring.head & (RING_SLOTS - 1u)].timestamp);
+
+        const uint32_t n = sw_ring_pop_burst(&g_ring, descs, BURST);
+        deliver(descs, n);
+        packets += n;
+    }
+    return NULL;
+}
+
+static int file_write(void *ctx, const void *data, size_t len)
+{
+    return fwrite(data, 1, len, (FILE *)ctx) == len ? 0 : -1;
+}
+
+/* Timestamp counter ticks per microsecond, measured against the clock. */
+static double ticks_per_us(void)
+{
+    const uint64_t n0 = bench_now_ns();
+    const uint64_t t0 = sw_evlog_timestamp();
+    while (bench_now_ns() - n0 < 20000000u)
+        ;
+    const uint64_t t1 = sw_evlog_timestamp();
+    const uint64_t n1 = bench_now_ns();
+    return (double)(t1 - t0) * 1000.0 / (double)(n1 - n0);
+}
+
+int main(void)
+{
+    g_bursts = bench_env_uint("BENCH_BURSTS", 100000u);
+    const char *out = getenv("BENCH_TRACE_OUT");
+
+    for (size_t i = 0; i < sizeof(g_payload); i++)
+        g_payload[i] = (uint8_t)i;
+    sw_router_init(&g_router, 4);
+    sw_router_add_route(&g_router, 0x40, 1, 0);
+    sw_ring_init(&g_ring, g_slots, RING_SLOTS);
+
+    sw_trace_buf_init(&g_trace[0], g_events[0], TRACE_EVENTS, 0, SAMPLE);
+    sw_trace_buf_init(&g_trace[1], g_events[1], TRACE_EVENTS, 1, SAMPLE);
+    sw_trace_buf_init(&g_trace[2], g_events[2], TRACE_EVENTS, 2, SAMPLE);
+
+    static sw_trace_event_t all_events[TRACE_EVENTS];
+    sw_trace_buf_t all;
+    sw_trace_buf_init(&all, all_events, TRACE_EVENTS, 0, 1);
+
+    /* Warm up, then measure each mode. */
+    run_inline(NULL);
+    const double off = run_inline(NULL);
+    const double sampled = run_inline(&g_trace[0]);
+    const double every = run_inline(&all);
+
+    printf("Span tracing: %u bursts of %u packets, %u-octet payload, "
+           "encode/push/pop/route/decode\n",
+           (unsigned)g_bursts,
+           BURST,
+           (unsigned)sizeof(g_payload));
+    printf("  %-22s %10s %10s %10s\n", "mode", "ns/pkt", "overhead", "spans");
+    printf("  %-22s %10.1f %9.1f%% %10s\n", "no buffer", off, 0.0, "-");
+    printf("  %-22s %10.1f %9.1f%% %10u\n",
+           "1 burst in 16",
+           sampled,
+           (sampled / off - 1.0) * 100.0,
+           (unsigned)g_trace[0].head);
+    printf("  %-22s %10.1f %9.1f%% %10u\n",
+           "every burst",
+           every,
+           (every / off - 1.0) * 100.0,
+           (unsigned)all.head);
+
+    /* Two threads, one burst in 16 traced on both. */
+    sw_ring_init(&g_ring, g_slots, RING_SLOTS);
+    sw_trace_register(&g_trace[1]);
+    sw_trace_register(&g_trace[2]);
+    g_delivered = 0;
+
+    pthread_t prod;
+    pthread_t cons;
+    const uint64_t t0 = bench_now_ns();
+    pthread_create(&cons, NULL, consumer_main, NULL);
+    pthread_create(&prod, NULL, producer_main, NULL);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+    const uint64_t ns = bench_now_ns() - t0;
+
+    printf("  two threads: %.1f ns/pkt, %llu delivered, spans %u (producer) + %u "
+           "(consumer)\n",
+           (double)ns / ((double)g_bursts * BURST),
+           (unsigned long long)g_delivered,
+           (unsigned)g_trace[1].head,
+           (unsigned)g_trace[2].head);
+
+    if (out)
+    {
+        FILE *f = fopen(out, "w");
+        if (!f || sw_trace_export_json(file_write, f, ticks_per_us()) != SW_OK)
+            return 1;
+        fclose(f);
+        printf("  trace written to %s\n", out);
+    }
+
+    return g_delivered == (uint64_t)g_bursts * BURST ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+/**
+ * @file bench_txq.c
+ * @brief Producer scaling of the MPSC transmit queue against a mutex.
+ *
+ * N producer threads send descriptors to one link, whose owner thread
+ * removes them in bursts of 32:
+ *
+ * - txq: producers call sw_txq_enqueue_burst() on a shared transmit queue;
+ * - mutex: producers serialise on a pthread mutex around
+ *   sw_ring_push_burst() on an SPSC ring, which is how an application shares
+ *   a link without the queue.
+ *
+ * Producers send in bursts of 1 and of 8 descriptors; a full queue is
+ * retried after a yield. The link owner checks that each producer's
+ * descriptors arrive in order. Each row gives the descriptors moved per
+ * second and the retries producers made because the queue was full. With
+ * more producers than cores the threads time-share and the numbers measure
+ * the scheduler instead.
+ *
+ * Tuning: BENCH_PACKETS (per producer, default 1000000), BENCH_THREADS
+ * (default: online CPUs; producers are limited to one less).
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+#include "spacewire_txq.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_PRODUCERS 16u
+#define SLOTS 1024u
+#define DRAIN 32u
+
+typedef enum
+{
+    QUEUE_TXQ = 0,
+    QUEUE_MUTEX = 1
+} queue_kind_t;
+
+typedef struct
+{
+    queue_kind_t kind;               /**< Queue under test. */
+    unsigned producers;              /**< Producer threads. */
+    uint32_t burst;                  /**< Descriptors per enqueue. */
+    uint32_t packets;                /**< Descriptors per producer. */
+    sw_txq_t txq;                    /**< Shared transmit queue. */
+    sw_ring_t ring;                  /**< SPSC ring behind @ref lock. */
+    pthread_mutex_t lock;            /**< Serialises ring producers. */
+    uint32_t go;                     /**< Start signal. */
+    uint32_t finished;               /**< Producers done. */
+    uint64_t retries[MAX_PRODUCERS]; /**< Full-queue retries, by producer. */
+    uint32_t next[MAX_PRODUCERS];    /**< Next sequence expected, by producer. */
+    uint64_t errors;                 /**< Descriptors out of order. */
+} bench_t;
+
+typedef struct
+{
+    bench_t *b;
+    unsigned id;
+} thread_arg_t;
+
+static sw_txq_slot_t g_txq_slots[SLOTS];
+static sw_desc_t g_ring_slots[SLOTS];
+
+static uint32_t enqueue(bench_t *b, const sw_desc_t *descs, uint32_t n)
+{
+    if (b->kind == QUEUE_TXQ)
+        return sw_txq_enqueue_burst(&b->txq, descs, n);
+
+    pthread_mutex_lock(&b->lock);
+    n = sw_ring_push_burst(&b->ring, descs, n);
+    pthread_mutex_unlock(&b->lock);
+    return n;
+}
+
+static void *producer_main(void *arg)
+{
+    const thread_arg_t *ta = (const thread_arg_t *)arg;
+    bench_t *b = ta->b;
+    sw_desc_t burst[8];
+    uint64_t retries = 0;
+
+    memset(burst, 0, sizeof(burst));
+    while (!__atomic_load_n(&b->go, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    for (uint32_t seq = 0; seq < b->packets;)
+    {
+        uint32_t n = b->packets - seq < b->burst ? b->packets - seq : b->burst;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            burst[i].tag = (uint16_t)ta->id;
+            burst[i].timestamp = seq + i;
+            burst[i].len = 64;
+        }
+
+        const sw_desc_t *d = burst;
+        while (n > 0)
+        {
+            const uint32_t k = enqueue(b, d, n);
+            d += k;
+            n -= k;
+            seq += k;
+            if (n > 0)
+            {
+                retries++;
+                sched_yield();
+            }
+        }
+    }
+
+    b->retries[ta->id] = retries;
+    __atomic_fetch_add(&b->finished, 1u, __ATOMIC_ACQ_REL);
+    return NULL;
+}
+
+static void *owner_main(void *arg)
+{
+    bench_t *b = (bench_t *)arg;
+    sw_desc_t out[DRAIN];
+
+    while (!__atomic_load_n(&b->go, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    for (;;)
+    {
+        const uint32_t finished = __atomic_load_n(&b->finished, __ATOMIC_ACQUIRE);
+        const uint32_t n = b->kind == QUEUE_TXQ ? sw_txq_dequeue_burst(&b->txq, out, DRAIN)
+                                                : sw_ring_pop_burst(&b->ring, out, DRAIN);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint32_t *next = &b->next[out[i].tag];
+            b->errors += out[i].timestamp != *next;
+            *next = (uint32_t)out[i].timestamp + 1u;
+        }
+
+        if (n == 0)
+        {
+            if (finished == b->producers)
+                break;
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void run(bench_t *b,
+                queue_kind_t kind,
+                unsigned producers,
+                uint32_t burst,
+                uint32_t packets)
+{
+    pthread_t owner;
+    pthread_t tid[MAX_PRODUCERS];
+    thread_arg_t args[MAX_PRODUCERS];
+
+    b->kind = kind;
+    b->producers = producers;
+    b->burst = burst;
+    b->packets = packets;
+    b->go = 0;
+    b->finished = 0;
+    b->errors = 0;
+    memset(b->retries, 0, sizeof(b->retries));
+    memset(b->next, 0, sizeof(b->next));
+    sw_txq_init(&b->txq, g_txq_slots, SLOTS, 0);
+    sw_ring_init(&b->ring, g_ring_slots, SLOTS);
+
+    pthread_create(&owner, NULL, owner_main, b);
+    for (unsigned i = 0; i < producers; i++)
+    {
+        args[i].b = b;
+        args[i].id = i;
+        pthread_create(&tid[i], NULL, producer_main, &args[i]);
+    }
+
+    const uint64_t t0 = bench_now_ns();
+    __atomic_store_n(&b->go, 1u, __ATOMIC_RELEASE);
+    for (unsigned i = 0; i < producers; i++)
+        pthread_join(tid[i], NULL);
+    pthread_join(owner, NULL);
+    const uint64_t ns = bench_now_ns() - t0;
+
+    uint64_t retries = 0;
+    uint64_t delivered = 0;
+    for (unsigned i = 0; i < producers; i++)
+    {
+        retries += b->retries[i];
+        delivered += b->next[i];
+    }
+
+    printf("  %-6s %9u %6u %10.2f %10llu %8s\n",
+           kind == QUEUE_TXQ ? "txq" : "mutex",
+           producers,
+           burst,
+           (double)delivered * 1e3 / (double)ns,
+           (unsigned long long)retries,
+           b->errors == 0 && delivered == (uint64_t)packets * producers ? "ok" : "ERROR");
+}
+
+int main(void)
+{
+    const uint32_t packets = bench_env_uint("BENCH_PACKETS", 1000000u);
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const unsigned threads = bench_env_uint("BENCH_THREADS", cpus > 0 ? (unsigned)cpus : 1u);
+    const uint32_t bursts[] = {1, 8};
+
+    unsigned max_producers = threads > 1u ? threads - 1u : 1u;
+    if (max_producers > MAX_PRODUCERS)
+        max_producers = MAX_PRODUCERS;
+
+    static bench_t b;
+    pthread_mutex_init(&b.lock, NULL);
+
+    printf("Transmit queue: %u descriptors per producer, %u slots, drained %u at a time\n",
+           (unsigned)packets,
+           SLOTS,
+           DRAIN);
+    printf("  %-6s %9s %6s %10s %10s %8s\n",
+           "queue",
+           "producers",
+           "burst",
+           "Mdesc/s",
+           "retries",
+           "order");
+
+    for (unsigned p = 1; p <= max_producers; p *= 2u)
+    {
+        for (unsigned s = 0; s < sizeof(bursts) / sizeof(bursts[0]); s++)
+        {
+            run(&b, QUEUE_TXQ, p, bursts[s], packets);
+            run(&b, QUEUE_MUTEX, p, bursts[s], packets);
+        }
+    }
+
+    pthread_mutex_destroy(&b.lock);
+    return 0;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file bench_util.h
+ * @brief Timing helpers shared by the benchmarks.
+ *
+ * Benchmarks are POSIX programs; define _POSIX_C_SOURCE before including any
+ * system header.
+ */
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** @brief Monotonic time in nanoseconds. */
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Read an unsigned tuning knob from the environment.
+ * @param[in] name Variable name.
+ * @param[in] dflt Value if unset or invalid.
+ */
+static inline unsigned bench_env_uint(const char *name, unsigned dflt)
+{
+    const char *v = getenv(name);
+    if (!v || !*v)
+        return dflt;
+
+    char *end = NULL;
+    const unsigned long n = strtoul(v, &end, 10);
+    return (*end == '\0' && n > 0 && n < 1000000000ul) ? (unsigned)n : dflt;
+}
+
+#endif /* BENCH_UTIL_H */
@@ -139,17 +139,60 @@ typedef struct
     uint8_t delete_addr; /**< 1 to delete the logical address before forwarding (clause 5.6.8.6). */
 } sw_route_entry_t;
 
+/**
+ * @brief A logical-address routing table that routers may share.
+ *
+ * A table referenced by more than one router is immutable: a router that
+ * changes its routes first copies the table into its own (copy-on-write).
+ */
+typedef struct
+{
+    sw_route_entry_t entries[SW_ROUTE_TABLE_SIZE]; /**< Routes, indexed by logical address. */
+    uint32_t refs;                                 /**< Routers referencing the table. */
+} sw_route_table_t;
+
+/** @brief Most address octets an egress translation rule inserts. */
+#define SW_XLAT_MAX_PREFIX 13u
+
+/**
+ * @brief An egress address-translation rule, selected by the leading octet
+ *        of a packet leaving a port.
+ *
+ * The rule deletes @ref strip leading octets and inserts @ref prefix in their
+ * place: a logical-address rewrite strips 1 and inserts the new address; a
+ * path prefix for the next segment strips 0 and inserts path octets; both
+ * may be combined.
+ */
+typedef struct
+{
+    uint8_t configured;                 /**< 1 if the rule applies. */
+    uint8_t strip;                      /**< Leading octets to delete. */
+    uint8_t prefix_len;                 /**< Octets of @ref prefix to insert. */
+    uint8_t prefix[SW_XLAT_MAX_PREFIX]; /**< Octets inserted, leading first. */
+} sw_xlat_rule_t;
+
+/**
+ * @brief Egress translation table: one rule per leading octet, like the
+ *        routing table.
+ */
+typedef struct
+{
+    sw_xlat_rule_t rules[SW_ROUTE_TABLE_SIZE]; /**< Rules, indexed by leading octet. */
+} sw_xlat_table_t;
+
 /**
  * @brief A SpaceWire routing switch: ports, a routing table and counters.
  */
 typedef struct
 {
-    sw_link_t links[SW_NUM_PORTS];                /**< Per-port link state. */
-    sw_route_entry_t routes[SW_ROUTE_TABLE_SIZE]; /**< Logical-address routing table. */
-    uint8_t num_ports;                            /**< Ports present (port 0 = config). */
-    uint32_t invalid_address_errors;              /**< Invalid-address discards (clause 5.6.8.5). */
-    uint32_t packets_routed;                      /**< Packets successfully routed. */
-    uint32_t packets_discarded;                   /**< Packets discarded. */
+    sw_link_t links[SW_NUM_PORTS];             /**< Per-port link state. */
+    sw_route_table_t *routes;                  /**< Shared table in use; NULL: @ref own. */
+    const sw_xlat_table_t **xlat;              /**< Egress translation by port; NULL: none. */
+    uint8_t num_ports;                         /**< Ports present (port 0 = config). */
+    uint32_t invalid_address_errors;           /**< Invalid-address discards (clause 5.6.8.5). */
+    uint32_t packets_routed;                   /**< Packets successfully routed. */
+    uint32_t packets_discarded;                /**< Packets discarded. */
+    sw_route_table_t own;                      /**< The router's own table, never shared. */
 } sw_router_t;
 
 /**
@@ -164,6 +207,10 @@ typedef enum
 /**
  * @brief Initialize a router.
  *
+ * The router starts with no routes, in its own table. Not for a router
+ * using a shared table: its reference would be lost and the table's count
+ * left too high; sw_router_clear_routes() drops it.
+ *
  * @param[out] router    Router to initialise. No-op if NULL.
  * @param[in]  num_ports Number of ports, clamped to [1, ::SW_NUM_PORTS] and
  *                       counting the configuration port 0.
@@ -178,13 +225,91 @@ void sw_router_init(sw_router_t *router, uint8_t num_ports);
  * @param[in]     output_port  Existing output port to forward through.
  * @param[in]     delete_addr  Non-zero to delete the logical address before
  *                             forwarding (logical-address deletion, clause 5.6.8.6).
- * @return ::SW_OK on success, error code otherwise.
+ * @return ::SW_OK on success (a shared table is copied into the router's
+ *         own first if the route changes), error code otherwise.
  */
 sw_result_t sw_router_add_route(sw_router_t *router,
                                 uint8_t logical_addr,
                                 uint8_t output_port,
                                 int delete_addr);
 
+/**
+ * @brief Remove a logical-address route (clause 5.6.8.4).
+ *
+ * Packets for the address are then discarded with an invalid-address error
+ * (clause 5.6.8.5).
+ *
+ * @param[in,out] router       Target router.
+ * @param[in]     logical_addr Logical address to unconfigure; must be 32..254.
+ * @return ::SW_OK on success (also if no route was configured), error code
+ *         otherwise.
+ */
+sw_result_t sw_router_remove_route(sw_router_t *router, uint8_t logical_addr);
+
+/**
+ * @brief Look up the routing-table entry of a logical address.
+ *
+ * @param[in] router       Router.
+ * @param[in] logical_addr Logical address.
+ * @return The entry if the address has a configured route, else NULL.
+ */
+const sw_route_entry_t *sw_router_get_route(const sw_router_t *router, uint8_t logical_addr);
+
+/**
+ * @brief Make a router use a caller-owned table that other routers may share.
+ *
+ * The router's current routes are copied into @p table, which the router
+ * then writes in place for as long as no other router shares it.
+ *
+ * @param[in,out] router Router.
+ * @param[out]    table  Table storage no router references.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_router_set_routes(sw_router_t *router, sw_route_table_t *table);
+
+/**
+ * @brief Make a router use the shared table of another one.
+ *
+ * Many routers with the same routes thus read one table between them. The
+ * table is immutable while shared: a router that changes its routes copies
+ * it into its own table first. The last router left on it writes it in
+ * place again. A router's own table is never shared, so routes are always
+ * writable.
+ *
+ * A table and the routers sharing it belong to one thread while any of
+ * them is configured (routing through a shared table from several threads
+ * is safe).
+ *
+ * @param[in,out] router Router to reconfigure.
+ * @param[in,out] from   Router using a table from sw_router_set_routes() or
+ *                       shared (its reference count is updated).
+ * @return ::SW_OK, ::SW_ERR if @p from uses its own table, or
+ *         ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_router_share_routes(sw_router_t *router, sw_router_t *from);
+
+/**
+ * @brief Drop a router's routes and its reference to a shared table.
+ *
+ * The router is left with an empty table of its own.
+ *
+ * @param[in,out] router Router.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_router_clear_routes(sw_router_t *router);
+
+/**
+ * @brief Copy a router, with the routes of a shared table in the copy's own.
+ *
+ * The copy references no shared table and is independent of @p src; raw
+ * copies of a router sharing a table would alias it without counting.
+ *
+ * @param[out] dst Copy.
+ * @param[in]  src Router.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_router_copy(sw_router_t *dst, const sw_router_t *src);
+
 /**
  * @brief Decide the output port for a packet from its leading address character.
  *
@@ -208,6 +333,147 @@ sw_route_result_t sw_router_route(sw_router_t *router,
                                   uint8_t *output_port,
                                   uint8_t *delete_leading);
 
+/**
+ * @brief Resolve a packet's route across a chain of routers in one pass.
+ *
+ * Applies the routing decision of sw_router_route() at each router in
+ * turn, where @p routers[i] is the router the packet reaches at hop i.
+ * Instead of deleting leading characters from a copy of the packet, the
+ * resolver advances an offset into @p packet, so the packet is neither
+ * copied nor modified. The walk ends early if a router forwards the packet
+ * to its configuration port, which consumes it.
+ *
+ * Meant for simulation and route verification: no router counter, event or
+ * trace span is recorded.
+ *
+ * @param[in]  routers     Routers in the order the packet traverses them.
+ * @param[in]  num_routers Number of routers.
+ * @param[in]  packet      Packet octets (the destination address leads).
+ * @param[in]  len         Packet length in octets.
+ * @param[out] ports       Output port chosen at each hop; room for
+ *                         @p num_routers entries.
+ * @param[out] consumed    Leading address octets deleted along the way;
+ *                         the packet leaves the last router as
+ *                         `packet + *consumed`. May be NULL.
+ * @param[out] hops        Routers that forwarded the packet: @p num_routers,
+ *                         or fewer if it reached a configuration port, on
+ *                         ::SW_ROUTE_OK; the index of the discarding router
+ *                         on ::SW_ROUTE_DISCARD. May be NULL.
+ * @return ::SW_ROUTE_OK if every hop forwards the packet, ::SW_ROUTE_DISCARD
+ *         if one discards it or on invalid arguments.
+ */
+sw_route_result_t sw_router_resolve(const sw_router_t *const *routers,
+                                    size_t num_routers,
+                                    const uint8_t *packet,
+                                    size_t len,
+                                    uint8_t *ports,
+                                    size_t *consumed,
+                                    size_t *hops);
+
+/**
+ * @brief Clear a translation table.
+ *
+ * @param[out] table Table. No-op if NULL.
+ */
+void sw_xlat_init(sw_xlat_table_t *table);
+
+/**
+ * @brief Set the translation rule for a leading octet.
+ *
+ * @param[in,out] table      Table.
+ * @param[in]     lead       Leading octet the rule matches (path or logical).
+ * @param[in]     strip      Leading octets to delete, the matched one included.
+ * @param[in]     prefix     Octets to insert in their place; may be NULL if
+ *                           @p prefix_len is 0.
+ * @param[in]     prefix_len 0..::SW_XLAT_MAX_PREFIX.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM (also if the rule would do nothing).
+ */
+sw_result_t sw_xlat_set(sw_xlat_table_t *table,
+                        uint8_t lead,
+                        uint8_t strip,
+                        const uint8_t *prefix,
+                        uint8_t prefix_len);
+
+/**
+ * @brief Remove the translation rule for a leading octet.
+ *
+ * @param[in,out] table Table.
+ * @param[in]     lead  Leading octet.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_xlat_clear(sw_xlat_table_t *table, uint8_t lead);
+
+/**
+ * @brief Translate a packet's leading address octets in place.
+ *
+ * The packet occupies `buf[*off .. *off + *len)` of a buffer of @p cap
+ * octets, so the octets before it are headroom. The rule of its leading
+ * octet, if any, is applied by writing the new address octets just before
+ * the cargo (the octets after those stripped); the cargo moves only when
+ * the rule inserts more octets than the headroom and stripped octets can
+ * hold, and then only if the buffer has room after the packet.
+ *
+ * @param[in]     table Table.
+ * @param[in,out] buf   Buffer holding the packet.
+ * @param[in]     cap   Buffer capacity in octets.
+ * @param[in,out] off   Offset of the packet in @p buf.
+ * @param[in,out] len   Packet length in octets.
+ * @return ::SW_OK (also if no rule applies), ::SW_ERR if the packet is
+ *         shorter than the octets to strip or the buffer is too small (the
+ *         packet is then unchanged), or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_xlat_apply(const sw_xlat_table_t *table,
+                          uint8_t *buf,
+                          size_t cap,
+                          size_t *off,
+                          size_t *len);
+
+/**
+ * @brief Give a router caller-owned storage for its per-port translation
+ *        tables, so routers that translate nothing carry one pointer only.
+ *
+ * @param[in,out] router Router.
+ * @param[in]     ports  One table pointer per port (NULL: none), used as
+ *                       they are and possibly shared with routers that
+ *                       translate alike; NULL to translate nothing.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_router_set_xlat_ports(sw_router_t *router, const sw_xlat_table_t **ports);
+
+/**
+ * @brief Attach a translation table to an output port.
+ *
+ * @param[in,out] router Router with storage from sw_router_set_xlat_ports().
+ * @param[in]     port   Existing output port.
+ * @param[in]     table  Table, owned by the caller and possibly shared; NULL
+ *                       to translate nothing at this port.
+ * @return ::SW_OK, ::SW_ERR if the router has no per-port storage,
+ *         ::SW_WRONG_PORT, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_router_set_xlat(sw_router_t *router, uint8_t port, const sw_xlat_table_t *table);
+
+/**
+ * @brief Apply an output port's egress translation to a packet.
+ *
+ * Call after sw_router_route() chose @p port and any leading character it
+ * deleted has been dropped (by advancing @p off). See sw_xlat_apply().
+ *
+ * @param[in]     router Router.
+ * @param[in]     port   Output port.
+ * @param[in,out] buf    Buffer holding the packet.
+ * @param[in]     cap    Buffer capacity in octets.
+ * @param[in,out] off    Offset of the packet in @p buf.
+ * @param[in,out] len    Packet length in octets.
+ * @return As sw_xlat_apply(); ::SW_OK without change if the port has no
+ *         table.
+ */
+sw_result_t sw_router_translate(const sw_router_t *router,
+                                uint8_t port,
+                                uint8_t *buf,
+                                size_t cap,
+                                size_t *off,
+                                size_t *len);
+
 /* ============================================================================
  * SPACEWIRE LINK LAYER
  * ============================================================================ */
@@ -0,0 +1,302 @@
+/**
+ * @file spacewire_archive.h
+ * @brief Columnar telemetry archive of decoded packets, one APID per chunk.
+ *
+ * An archive writer collects the decoded packets of one APID as columns:
+ * the capture time and the header fields of every packet (Target Logical
+ * Address, User Application, APID, sequence count, data length) and,
+ * optionally, the parameters a decommutation plan extracts from its data
+ * field. sw_archive_flush() turns the collected rows into a self-describing
+ * chunk for the application to append to its archive file; writers of
+ * different APIDs may append to the same file.
+ *
+ * A chunk is laid out as
+ *
+ *     [ chunk header: APID, row count, time range, size ]
+ *     [ column descriptors: type, encoding, null count, buffer offsets ]
+ *     [ buffers, each 64-octet aligned and padded ]
+ *
+ * Buffers follow the Apache Arrow columnar format: fixed-width values are
+ * contiguous in the host's (little-endian) byte order, and a validity buffer
+ * is an LSB-first bitmap present only for columns with nulls. A plain column
+ * can therefore be handed to Arrow, or scanned in place from a read-only
+ * `mmap` of the archive, without copying. The Arrow IPC schema and message
+ * metadata are not written; the chunk header and column descriptors take
+ * their place.
+ *
+ * Columns are compressed with lightweight encodings chosen per chunk:
+ *
+ *   - constant: every valid row has the same value (an APID column, or a
+ *     status flag that did not change); no buffer at all;
+ *   - frame of reference: integers stored as offsets from the chunk minimum
+ *     in 1, 2 or 4 octets, when narrower than the column type (times,
+ *     counters, raw ADC readings);
+ *   - plain: the Arrow buffer itself.
+ *
+ * sw_archive_read() decodes any column to its plain values.
+ *
+ * Parameter rows the plan rejects (another APID, a short data field) are
+ * nulls. Archives are in the writing host's byte order.
+ */
+
+#ifndef SPACEWIRE_ARCHIVE_H
+#define SPACEWIRE_ARCHIVE_H
+
+#include "spacewire_decom.h"
+
+#include <stddef.h>
+
+/** @brief Chunk identifier ("SWAC"). */
+#define SW_ARCHIVE_MAGIC 0x43415753u
+
+/** @brief Chunk format version. */
+#define SW_ARCHIVE_VERSION 1u
+
+/** @brief Alignment of chunks and buffers, in octets. */
+#define SW_ARCHIVE_ALIGN 64u
+
+/** @brief Header columns, ahead of the parameter columns. */
+#define SW_ARCHIVE_COL_TIME 0u     /**< Capture time, ::SW_ARCHIVE_U64. */
+#define SW_ARCHIVE_COL_ADDR 1u     /**< Target Logical Address, ::SW_ARCHIVE_U8. */
+#define SW_ARCHIVE_COL_USER_APP 2u /**< User Application, ::SW_ARCHIVE_U8. */
+#define SW_ARCHIVE_COL_APID 3u     /**< APID, ::SW_ARCHIVE_U16. */
+#define SW_ARCHIVE_COL_SEQ 4u      /**< Sequence count, ::SW_ARCHIVE_U16. */
+#define SW_ARCHIVE_COL_LENGTH 5u   /**< Data-field octets, ::SW_ARCHIVE_U16. */
+#define SW_ARCHIVE_COL_PARAM 6u    /**< Parameter i is column SW_ARCHIVE_COL_PARAM + i. */
+
+/**
+ * @brief Column value type; Arrow UInt8, UInt16, UInt64, Int64 or Float64.
+ */
+typedef enum
+{
+    SW_ARCHIVE_U8 = 0,  /**< uint8_t. */
+    SW_ARCHIVE_U16 = 1, /**< uint16_t. */
+    SW_ARCHIVE_U64 = 2, /**< uint64_t. */
+    SW_ARCHIVE_I64 = 3, /**< int64_t. */
+    SW_ARCHIVE_F64 = 4  /**< double. */
+} sw_archive_type_t;
+
+/**
+ * @brief Column encoding.
+ */
+typedef enum
+{
+    SW_ARCHIVE_PLAIN = 0, /**< Arrow values buffer. */
+    SW_ARCHIVE_CONST = 1, /**< Every valid row holds @ref sw_archive_column_t::base. */
+    SW_ARCHIVE_FOR = 2    /**< Offsets from @ref sw_archive_column_t::base, `width` octets. */
+} sw_archive_encoding_t;
+
+/**
+ * @brief Chunk header; chunks are SW_ARCHIVE_ALIGN-octet aligned.
+ */
+typedef struct
+{
+    uint32_t magic;       /**< ::SW_ARCHIVE_MAGIC. */
+    uint16_t version;     /**< ::SW_ARCHIVE_VERSION. */
+    uint16_t apid;        /**< APID of the chunk. */
+    uint32_t num_rows;    /**< Rows. */
+    uint32_t num_columns; /**< Column descriptors following the header. */
+    uint64_t size;        /**< Chunk octets, header included; a multiple of 64. */
+    uint64_t t_min;       /**< Earliest capture time. */
+    uint64_t t_max;       /**< Latest capture time. */
+} sw_archive_chunk_t;
+
+/**
+ * @brief Column descriptor.
+ *
+ * Buffer offsets are relative to the chunk header; 0 means no buffer.
+ */
+typedef struct
+{
+    uint8_t type;        /**< ::sw_archive_type_t. */
+    uint8_t encoding;    /**< ::sw_archive_encoding_t. */
+    uint8_t width;       /**< Octets per stored value; 0 for a constant. */
+    uint8_t reserved;    /**< 0. */
+    uint32_t null_count; /**< Null rows. */
+    uint64_t base;       /**< Constant or reference value, as stored in the column. */
+    uint64_t validity;   /**< Validity bitmap; 0 if there are no nulls. */
+    uint64_t values;     /**< Values; 0 for a constant. */
+} sw_archive_column_t;
+
+/**
+ * @brief Archive writer for one APID.
+ */
+typedef struct
+{
+    uint64_t *time;              /**< Time column. */
+    uint8_t *addr;               /**< Logical-address column. */
+    uint8_t *user_app;           /**< User Application column. */
+    uint16_t *apid;              /**< APID column. */
+    uint16_t *seq;               /**< Sequence-count column. */
+    uint16_t *length;            /**< Data-length column. */
+    uint8_t *valid;              /**< Parameter validity per row. */
+    void **params;               /**< Parameter columns, 64-bit elements. */
+    void **cursor;               /**< Parameter columns at the next row. */
+    uint8_t *types;              /**< ::sw_archive_type_t per parameter. */
+    const sw_decom_plan_t *plan; /**< Decommutation plan; NULL for headers only. */
+    uint32_t max_rows;           /**< Rows per chunk. */
+    uint32_t num_rows;           /**< Rows collected. */
+    uint16_t num_params;         /**< Parameter columns. */
+    uint16_t chunk_apid;         /**< APID written to chunk headers. */
+} sw_archive_writer_t;
+
+/**
+ * @brief Read-only view of an archive image.
+ */
+typedef struct
+{
+    const uint8_t *image; /**< Archive image. */
+    size_t len;           /**< Octets available. */
+} sw_archive_reader_t;
+
+/**
+ * @brief Element size of a column type.
+ *
+ * @param[in] type ::sw_archive_type_t.
+ * @return Octets per value.
+ */
+static inline size_t sw_archive_type_size(uint8_t type)
+{
+    return type == SW_ARCHIVE_U8 ? 1u : type == SW_ARCHIVE_U16 ? 2u : 8u;
+}
+
+/**
+ * @brief Storage a writer needs.
+ *
+ * @param[in] max_rows   Rows per chunk.
+ * @param[in] num_params Parameters of the plan, or 0.
+ * @return Octets for the @p storage argument of sw_archive_writer_init().
+ */
+size_t sw_archive_storage_size(uint32_t max_rows, uint16_t num_params);
+
+/**
+ * @brief Initialise a writer.
+ *
+ * @param[out] w        Writer.
+ * @param[in]  apid     APID of the chunks; taken from @p plan if one is given.
+ * @param[in]  plan     Decommutation plan, or NULL to archive headers only.
+ * @param[in]  params   Parameter definitions @p plan was compiled from; NULL
+ *                      without a plan.
+ * @param[in]  max_rows Rows per chunk, 1..2^24.
+ * @param[in]  storage  Column storage; 8-octet aligned.
+ * @param[in]  size     Octets at @p storage; sw_archive_storage_size() suffices.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_archive_writer_init(sw_archive_writer_t *w,
+                                   uint16_t apid,
+                                   const sw_decom_plan_t *plan,
+                                   const sw_decom_param_t *params,
+                                   uint32_t max_rows,
+                                   void *storage,
+                                   size_t size);
+
+/**
+ * @brief Append decoded packets as rows.
+ *
+ * The application demultiplexes packets by APID, one writer each; a packet
+ * of another APID is still archived, with null parameters.
+ *
+ * @param[in,out] w      Writer.
+ * @param[in]     times  Capture time of each packet.
+ * @param[in]     frames Packets, as filled by sw_packet_decode().
+ * @param[in]     n      Number of packets.
+ * @return Rows appended; fewer than @p n when the chunk is full (flush, then
+ *         append the rest).
+ */
+size_t sw_archive_append(sw_archive_writer_t *w,
+                         const uint64_t *times,
+                         const sw_packet_frame_t *frames,
+                         size_t n);
+
+/**
+ * @brief Octets the next flush of @p w may produce.
+ *
+ * @param[in] w Writer.
+ * @return Bound for the @p size argument of sw_archive_flush().
+ */
+size_t sw_archive_flush_bound(const sw_archive_writer_t *w);
+
+/**
+ * @brief Encode the collected rows as a chunk and start a new one.
+ *
+ * Produces nothing if no rows were collected.
+ *
+ * @param[in,out] w    Writer.
+ * @param[out]    buf  Output; SW_ARCHIVE_ALIGN-octet aligned.
+ * @param[in]     size Capacity of @p buf.
+ * @param[out]    len  Octets to append to the archive.
+ * @return ::SW_OK, ::SW_ERR if @p buf is too small, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_archive_flush(sw_archive_writer_t *w, void *buf, size_t size, size_t *len);
+
+/**
+ * @brief Open an archive image.
+ *
+ * @param[out] r     Reader.
+ * @param[in]  image Archive image; SW_ARCHIVE_ALIGN-octet aligned.
+ * @param[in]  len   Octets available at @p image.
+ * @return ::SW_OK, ::SW_ERR if @p image does not start with a chunk, or
+ *         ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_archive_open(sw_archive_reader_t *r, const void *image, size_t len);
+
+/**
+ * @brief Step to the next chunk.
+ *
+ * A chunk that is torn (the writer died while appending) or malformed ends
+ * the archive.
+ *
+ * @param[in] r     Reader.
+ * @param[in] chunk Current chunk, or NULL for the first.
+ * @return Next chunk, or NULL at the end.
+ */
+const sw_archive_chunk_t *sw_archive_next(const sw_archive_reader_t *r,
+                                          const sw_archive_chunk_t *chunk);
+
+/**
+ * @brief Column descriptor @p index of a chunk.
+ *
+ * @param[in] chunk Chunk returned by sw_archive_next().
+ * @param[in] index Column.
+ * @return Descriptor, or NULL if @p index is out of range.
+ */
+const sw_archive_column_t *sw_archive_column(const sw_archive_chunk_t *chunk, uint32_t index);
+
+/**
+ * @brief Arrow values buffer of a plain column, for scanning in place.
+ *
+ * @param[in] chunk Chunk.
+ * @param[in] col   Column of @p chunk.
+ * @return Values, or NULL if the column is encoded.
+ */
+const void *sw_archive_values(const sw_archive_chunk_t *chunk, const sw_archive_column_t *col);
+
+/**
+ * @brief Arrow validity bitmap of a column.
+ *
+ * @param[in] chunk Chunk.
+ * @param[in] col   Column of @p chunk.
+ * @return Bitmap, bit i set for a valid row i; NULL if there are no nulls.
+ */
+const uint8_t *sw_archive_validity(const sw_archive_chunk_t *chunk,
+                                   const sw_archive_column_t *col);
+
+/**
+ * @brief Decode rows of a column to plain values.
+ *
+ * Null rows read as the column's reference value.
+ *
+ * @param[in]  chunk Chunk.
+ * @param[in]  col   Column of @p chunk.
+ * @param[in]  first First row.
+ * @param[in]  n     Rows.
+ * @param[out] out   @p n values of the column type.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM if the rows are out of range.
+ */
+sw_result_t sw_archive_read(const sw_archive_chunk_t *chunk,
+                            const sw_archive_column_t *col,
+                            uint32_t first,
+                            uint32_t n,
+                            void *out);
+
+#endif /* SPACEWIRE_ARCHIVE_H */
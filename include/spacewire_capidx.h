@@ -0,0 +1,286 @@
+/**
+ * @file spacewire_capidx.h
+ * @brief Time and APID / logical-address index for long packet captures.
+ *
+ * A capture index is a sidecar file written next to a packet capture while
+ * the capture is being recorded. For every captured packet the application
+ * passes its capture time, the octet offset of its record in the capture
+ * file and the packet itself; the index remembers where the packet is and
+ * which APID and Target Logical Address it carries. The capture file format
+ * is the application's own: the index only stores offsets into it.
+ *
+ * The sidecar is append-only. Packets are gathered into segments of up to
+ * `max_records` packets; sw_capidx_flush() lays a segment out as
+ *
+ *     [ segment header: record count, time span, size ]
+ *     [ records: (time, capture offset), in capture order ]
+ *     [ key directory: one entry per APID / address seen, sorted ]
+ *     [ posting lists: record numbers per key, ascending ]
+ *
+ * and the application appends it to the sidecar. sw_capidx_finish() appends
+ * a directory of all segments (the sparse time index) and a trailer.
+ *
+ * Queries run on the sidecar image as it lies in memory, normally a read-only
+ * `mmap` of the file, and touch only the pages they need: a binary search of
+ * the segment directory, then per segment a binary search of the key
+ * directory and of the key's posting list. Before sw_capidx_finish() (the
+ * capture is still running, or the recorder died) there is no directory;
+ * queries then step from segment header to segment header, and a torn last
+ * segment is ignored.
+ *
+ * Capture times must not decrease. Sidecars are in the writing host's byte
+ * order.
+ */
+
+#ifndef SPACEWIRE_CAPIDX_H
+#define SPACEWIRE_CAPIDX_H
+
+#include "spacewire_packet.h"
+
+#include <stddef.h>
+
+/** @brief Sidecar identifier ("SWCI"). */
+#define SW_CAPIDX_MAGIC 0x49435753u
+
+/** @brief Segment identifier ("SWCS"). */
+#define SW_CAPIDX_SEGMENT_MAGIC 0x53435753u
+
+/** @brief Trailer identifier ("SWCE"). */
+#define SW_CAPIDX_TRAILER_MAGIC 0x45435753u
+
+/** @brief Sidecar format version. */
+#define SW_CAPIDX_VERSION 1u
+
+/** @brief Query key: every packet. */
+#define SW_CAPIDX_ANY 0xFFFFFFFFu
+
+/** @brief Query key: packets with APID @p apid. */
+#define SW_CAPIDX_APID(apid) ((uint32_t)(apid) & 0x7FFu)
+
+/** @brief Query key: packets to Target Logical Address @p addr. */
+#define SW_CAPIDX_ADDR(addr) (0x10000u | ((uint32_t)(addr) & 0xFFu))
+
+/** @brief Distinct keys: 2048 APIDs and 256 logical addresses. */
+#define SW_CAPIDX_NUM_KEYS (2048u + 256u)
+
+/**
+ * @brief Sidecar header, the first 16 octets.
+ */
+typedef struct
+{
+    uint32_t magic;    /**< ::SW_CAPIDX_MAGIC. */
+    uint32_t version;  /**< ::SW_CAPIDX_VERSION. */
+    uint64_t reserved; /**< 0. */
+} sw_capidx_file_header_t;
+
+/**
+ * @brief Segment header.
+ */
+typedef struct
+{
+    uint32_t magic;        /**< ::SW_CAPIDX_SEGMENT_MAGIC. */
+    uint32_t num_records;  /**< Packets in the segment. */
+    uint32_t num_keys;     /**< Key directory entries, without the sentinel. */
+    uint32_t num_postings; /**< Posting-list entries. */
+    uint64_t size;         /**< Segment octets, header included; a multiple of 8. */
+    uint64_t t_first;      /**< Time of the first packet. */
+    uint64_t t_last;       /**< Time of the last packet. */
+} sw_capidx_segment_t;
+
+/**
+ * @brief One indexed packet; also a query result.
+ */
+typedef struct
+{
+    uint64_t time;   /**< Capture time, in the application's unit. */
+    uint64_t offset; /**< Offset of the packet's record in the capture file. */
+} sw_capidx_record_t;
+
+/**
+ * @brief Key directory entry of a segment.
+ *
+ * The postings of key k are `postings[start_k, start_{k+1})`; a sentinel with
+ * key ::SW_CAPIDX_ANY ends the directory.
+ */
+typedef struct
+{
+    uint32_t key;   /**< SW_CAPIDX_APID() or SW_CAPIDX_ADDR() value. */
+    uint32_t start; /**< First posting of the key. */
+} sw_capidx_key_t;
+
+/**
+ * @brief Segment directory entry.
+ */
+typedef struct
+{
+    uint64_t t_first; /**< Time of the segment's first packet. */
+    uint64_t t_last;  /**< Time of the segment's last packet. */
+    uint64_t offset;  /**< Sidecar offset of the segment header. */
+} sw_capidx_dirent_t;
+
+/**
+ * @brief Sidecar trailer, the last 16 octets of a finished sidecar.
+ */
+typedef struct
+{
+    uint32_t magic;        /**< ::SW_CAPIDX_TRAILER_MAGIC. */
+    uint32_t num_segments; /**< Segment directory entries. */
+    uint64_t dir_offset;   /**< Sidecar offset of the segment directory. */
+} sw_capidx_trailer_t;
+
+/**
+ * @brief Index writer.
+ */
+typedef struct
+{
+    sw_capidx_record_t *records;         /**< Current segment, max_records entries. */
+    uint16_t *keys;                      /**< 2 * max_records key indices. */
+    uint32_t max_records;                /**< Packets per segment. */
+    uint32_t num_records;                /**< Packets in the current segment. */
+    sw_capidx_dirent_t *dir;             /**< Segment directory; may be NULL. */
+    uint32_t max_segments;               /**< Capacity of @ref dir. */
+    uint32_t num_segments;               /**< Segments flushed. */
+    uint8_t dir_overflow;                /**< 1 if @ref dir ran out; no directory is written. */
+    uint8_t finished;                    /**< 1 after sw_capidx_finish(). */
+    uint64_t written;                    /**< Sidecar octets produced so far. */
+    uint64_t last_time;                  /**< Time of the last packet added. */
+    uint32_t counts[SW_CAPIDX_NUM_KEYS]; /**< Flush scratch. */
+} sw_capidx_writer_t;
+
+/**
+ * @brief Read-only view of a sidecar image.
+ */
+typedef struct
+{
+    const uint8_t *image;          /**< Sidecar image. */
+    size_t end;                    /**< End of the segment area. */
+    const sw_capidx_dirent_t *dir; /**< Segment directory; NULL if unfinished. */
+    uint32_t num_segments;         /**< Entries in @ref dir. */
+} sw_capidx_reader_t;
+
+/**
+ * @brief Position of a query that is continued over several calls.
+ *
+ * Zero-initialise before the first call; keep the query arguments unchanged
+ * while continuing.
+ */
+typedef struct
+{
+    uint64_t segment; /**< Sidecar offset of the current segment; 0 = not started. */
+    uint32_t pos;     /**< Next entry of the segment's record or posting list. */
+} sw_capidx_cursor_t;
+
+/**
+ * @brief Sidecar octets one flush may produce for segments of @p max_records.
+ *
+ * @param[in] max_records Packets per segment.
+ * @return Bound for the @p size argument of sw_capidx_flush().
+ */
+size_t sw_capidx_flush_bound(uint32_t max_records);
+
+/**
+ * @brief Initialise a writer.
+ *
+ * @param[out] w            Writer.
+ * @param[in]  records      Storage for max_records records.
+ * @param[in]  keys         Storage for 2 * max_records key indices.
+ * @param[in]  max_records  Packets per segment, 1..2^24.
+ * @param[in]  dir          Storage for the segment directory, or NULL to
+ *                          write none (queries then walk the segments).
+ * @param[in]  max_segments Capacity of @p dir. If the capture outgrows it,
+ *                          the sidecar is finished without a directory.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_capidx_writer_init(sw_capidx_writer_t *w,
+                                  sw_capidx_record_t *records,
+                                  uint16_t *keys,
+                                  uint32_t max_records,
+                                  sw_capidx_dirent_t *dir,
+                                  uint32_t max_segments);
+
+/**
+ * @brief Index one captured packet.
+ *
+ * The APID is taken from a CCSDS PTP packet, and the logical address is the
+ * first octet after any path address; a packet without them is indexed by
+ * time only.
+ *
+ * @param[in,out] w      Writer.
+ * @param[in]     time   Capture time; not before the previous packet's.
+ * @param[in]     offset Offset of the packet's record in the capture file.
+ * @param[in]     pkt    Packet octets as captured.
+ * @param[in]     len    Packet length.
+ * @return ::SW_OK, ::SW_ERR if the segment is full (flush, then add again) or
+ *         the writer is finished, or ::SW_INVALID_PARAM (also for a time
+ *         going backwards).
+ */
+sw_result_t sw_capidx_add(sw_capidx_writer_t *w,
+                          uint64_t time,
+                          uint64_t offset,
+                          const uint8_t *pkt,
+                          size_t len);
+
+/**
+ * @brief Close the current segment and produce the octets to append.
+ *
+ * Emits the sidecar header first if nothing has been produced yet, and
+ * nothing at all for an empty segment. Flush when the segment is full and
+ * whenever the sidecar should catch up with the capture on disk.
+ *
+ * @param[in,out] w    Writer.
+ * @param[out]    buf  Output; 8-octet aligned.
+ * @param[in]     size Capacity of @p buf; sw_capidx_flush_bound() suffices.
+ * @param[out]    len  Octets to append to the sidecar.
+ * @return ::SW_OK, ::SW_ERR if @p buf is too small or the writer is finished,
+ *         or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_capidx_flush(sw_capidx_writer_t *w, void *buf, size_t size, size_t *len);
+
+/**
+ * @brief Flush, then produce the segment directory and trailer.
+ *
+ * @param[in,out] w    Writer; finished afterwards.
+ * @param[out]    buf  Output; 8-octet aligned.
+ * @param[in]     size Capacity of @p buf: the flush bound plus 24 octets per
+ *                     segment and 16 for the trailer.
+ * @param[out]    len  Octets to append to the sidecar.
+ * @return ::SW_OK, ::SW_ERR if @p buf is too small or the writer is finished,
+ *         or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_capidx_finish(sw_capidx_writer_t *w, void *buf, size_t size, size_t *len);
+
+/**
+ * @brief Open a sidecar image, finished or not.
+ *
+ * @param[out] r     Reader.
+ * @param[in]  image Sidecar image; 8-octet aligned.
+ * @param[in]  len   Octets available at @p image.
+ * @return ::SW_OK, ::SW_ERR if @p image is not a sidecar, or
+ *         ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_capidx_open(sw_capidx_reader_t *r, const void *image, size_t len);
+
+/**
+ * @brief Find packets with a key in a time window.
+ *
+ * Results are in capture order. Call again with the same cursor until fewer
+ * than @p max results come back.
+ *
+ * @param[in]     r       Reader.
+ * @param[in]     key     SW_CAPIDX_APID(), SW_CAPIDX_ADDR() or ::SW_CAPIDX_ANY.
+ * @param[in]     t_begin First time included.
+ * @param[in]     t_end   First time excluded.
+ * @param[in,out] cursor  Query position.
+ * @param[out]    out     Results.
+ * @param[in]     max     Capacity of @p out.
+ * @return Results written.
+ */
+size_t sw_capidx_query(const sw_capidx_reader_t *r,
+                       uint32_t key,
+                       uint64_t t_begin,
+                       uint64_t t_end,
+                       sw_capidx_cursor_t *cursor,
+                       sw_capidx_record_t *out,
+                       size_t max);
+
+#endif /* SPACEWIRE_CAPIDX_H */
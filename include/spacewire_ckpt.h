@@ -0,0 +1,175 @@
+/**
+ * @file spacewire_ckpt.h
+ * @brief Checkpoints of a simulated network, to branch runs from one state.
+ *
+ * A checkpoint is one contiguous image of everything a ::sw_sim_t run
+ * depends on: routers (tables, link states, counters), the network model,
+ * per-node simulator state (port queues, random streams, statistics), the
+ * pending events (in-flight packets among them) and the registered route
+ * tables. Warm a network up to steady state once, save it, and start any
+ * number of what-if runs from the image instead of from an empty network.
+ *
+ * The image is a fixed header followed by the raw arrays, each section
+ * starting on a ::SW_CKPT_ALIGN boundary, so no section needs parsing:
+ *
+ *   - sw_ckpt_restore() copies the sections into caller-owned storage;
+ *   - sw_ckpt_attach() runs the simulation in the image itself. Mapped from a
+ *     file with `mmap(MAP_PRIVATE)`, each branch then shares every page it
+ *     does not write with the file and the other branches.
+ *
+ * Images are in the saving build's native layout and byte order; the header
+ * records the structure sizes and checksums, and anything else is refused.
+ * sw_ckpt_restore() checks the whole image; sw_ckpt_attach() checks only the
+ * header and section directory, so attaching reads no page the run does not.
+ * They are for branching runs on one host, not for archiving. Routing tables
+ * are saved with their routers; routers sharing a table are restored with a
+ * copy of it each (sw_router_copy()). Egress translation tables
+ * (sw_router_set_xlat()) are saved as the routers' pointers to their
+ * per-port storage, not as contents; the simulator does not use them.
+ */
+
+#ifndef SPACEWIRE_CKPT_H
+#define SPACEWIRE_CKPT_H
+
+#include "spacewire_sim.h"
+
+#include <stddef.h>
+
+/** @brief Image identifier ("SWCK"). */
+#define SW_CKPT_MAGIC 0x4B435753u
+
+/** @brief Image format version. */
+#define SW_CKPT_VERSION 2u
+
+/** @brief Alignment of the image and of each section in it. */
+#define SW_CKPT_ALIGN 64u
+
+/**
+ * @brief Sections of an image, in image order.
+ */
+typedef enum
+{
+    SW_CKPT_NODES = 0,     /**< ::sw_net_node_t array (routers). */
+    SW_CKPT_LINKS = 1,     /**< ::sw_net_link_t array. */
+    SW_CKPT_SIM_NODES = 2, /**< ::sw_sim_node_t array. */
+    SW_CKPT_EVENTS = 3,    /**< Pending ::sw_sim_event_t, in heap order. */
+    SW_CKPT_TABLES = 4,    /**< Registered route tables, num_nodes * 256 octets each. */
+    SW_CKPT_NUM_SECTIONS = 5
+} sw_ckpt_section_id_t;
+
+/**
+ * @brief Location of one section in an image.
+ */
+typedef struct
+{
+    uint64_t offset; /**< From the start of the image; a multiple of ::SW_CKPT_ALIGN. */
+    uint64_t size;   /**< In octets. */
+} sw_ckpt_section_t;
+
+/**
+ * @brief Image header: scalars of the network and simulator, and the
+ *        section directory.
+ */
+typedef struct
+{
+    uint32_t magic;                                   /**< ::SW_CKPT_MAGIC. */
+    uint32_t version;                                 /**< ::SW_CKPT_VERSION. */
+    uint64_t image_size;                              /**< Header and sections, in octets. */
+    uint32_t checksum;                                /**< Over the image, checksums 0. */
+    uint32_t header_checksum;                         /**< Over the header, checksums 0. */
+    uint16_t struct_size[SW_CKPT_NUM_SECTIONS];       /**< Element size of each section. */
+    uint16_t num_nodes;                               /**< Network nodes. */
+    uint16_t num_links;                               /**< Network links. */
+    uint16_t num_tables;                              /**< Registered route tables. */
+    uint16_t num_addrs;                               /**< Traffic addresses. */
+    uint32_t num_events;                              /**< Pending events. */
+    uint32_t overflows;                               /**< Simulator overflow count. */
+    uint32_t seq;                                     /**< Simulator external sequence. */
+    uint64_t now;                                     /**< Simulated time in ns. */
+    uint16_t addr_node[SW_ROUTE_TABLE_SIZE];          /**< Network address map. */
+    uint8_t addrs[SW_ROUTE_TABLE_SIZE];               /**< Traffic addresses. */
+    sw_ckpt_section_t sections[SW_CKPT_NUM_SECTIONS]; /**< Section directory. */
+} sw_ckpt_header_t;
+
+/**
+ * @brief Caller-owned storage a checkpoint is restored into.
+ */
+typedef struct
+{
+    sw_net_node_t *nodes;     /**< max_nodes network nodes. */
+    sw_net_link_t *links;     /**< max_links links. */
+    sw_sim_node_t *sim_nodes; /**< max_nodes simulator node states. */
+    sw_sim_event_t *events;   /**< max_events events. */
+    uint8_t *tables;          /**< max_tables tables of max_nodes * 256 octets. */
+    uint16_t max_nodes;       /**< Capacity of @ref nodes and @ref sim_nodes. */
+    uint16_t max_links;       /**< Capacity of @ref links. */
+    uint32_t max_events;      /**< Capacity of @ref events. */
+    uint16_t max_tables;      /**< Capacity of @ref tables. */
+} sw_ckpt_storage_t;
+
+/**
+ * @brief Size of the image sw_ckpt_save() would write.
+ *
+ * @param[in] sim Simulator (not a partition of a parallel run).
+ * @return Octets, or 0 if @p sim is NULL.
+ */
+size_t sw_ckpt_size(const sw_sim_t *sim);
+
+/**
+ * @brief Save a simulator and its network.
+ *
+ * @param[in]  sim  Simulator (not a partition of a parallel run).
+ * @param[out] buf  Image buffer, aligned to ::SW_CKPT_ALIGN.
+ * @param[in]  size Capacity of @p buf.
+ * @param[out] len  Octets written.
+ * @return ::SW_OK, ::SW_ERR if @p buf is too small, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ckpt_save(const sw_sim_t *sim, void *buf, size_t size, size_t *len);
+
+/**
+ * @brief Restore an image into caller-owned storage.
+ *
+ * On success @p net and @p sim are ready to run and independent of
+ * @p image. The simulator capacity is storage->max_events.
+ *
+ * @param[in]  image   Image.
+ * @param[in]  len     Octets available at @p image.
+ * @param[in]  storage Storage to copy into.
+ * @param[out] net     Restored network.
+ * @param[out] sim     Restored simulator.
+ * @return ::SW_OK, ::SW_ERR if the image is corrupt, from another build or
+ *         does not fit @p storage, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ckpt_restore(const void *image,
+                            size_t len,
+                            const sw_ckpt_storage_t *storage,
+                            sw_net_t *net,
+                            sw_sim_t *sim);
+
+/**
+ * @brief Run a simulation in place in a writable image.
+ *
+ * The network, node states and route tables stay in @p image and are
+ * modified as the run goes on; only the pending events, which need room to
+ * grow, are copied to @p events.
+ *
+ * Only the header and section directory are checked, not the section
+ * contents: attach images this host saved, or sw_ckpt_restore() them.
+ *
+ * @param[in,out] image      Image, aligned to ::SW_CKPT_ALIGN (page-aligned
+ *                           when mapped).
+ * @param[in]     len        Octets available at @p image.
+ * @param[out]    events     Event storage.
+ * @param[in]     max_events Capacity of @p events.
+ * @param[out]    net        Network over @p image.
+ * @param[out]    sim        Simulator over @p image.
+ * @return As sw_ckpt_restore().
+ */
+sw_result_t sw_ckpt_attach(void *image,
+                           size_t len,
+                           sw_sim_event_t *events,
+                           uint32_t max_events,
+                           sw_net_t *net,
+                           sw_sim_t *sim);
+
+#endif /* SPACEWIRE_CKPT_H */
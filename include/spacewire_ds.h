@@ -0,0 +1,257 @@
+/**
+ * @file spacewire_ds.h
+ * @brief Software data-strobe character decoder for captured link waveforms.
+ *
+ * On the wire, and in the CODEC, SpaceWire is a pair of Data and Strobe
+ * signals (ECSS-E-ST-50-12C clause 7). This decoder works on samples of the
+ * two lines taken by a logic analyser, offline and at any oversampling
+ * ratio, to debug links; it does not take the CODEC's place on the packet
+ * path.
+ *
+ * - Clock recovery: D xor S changes once per bit, so every sample where it
+ *   differs from the previous one starts a bit, whose value is D there.
+ * - Characters: a parity bit and a control flag, then eight data bits (LSB
+ *   first) or two control bits. Parity is odd over the previous character's
+ *   data or control bits and the current parity bit and flag.
+ * - Classes: data characters, EOP and EEP, FCT, NULL (ESC FCT) and
+ *   time-codes (ESC and a data character); ESC followed by anything else is
+ *   an escape error.
+ * - Errors: a parity or escape error, or a disconnect (no bit for longer
+ *   than a configurable number of samples), ends any packet being received
+ *   with an EEP, as a receiver does, and the decoder resynchronises.
+ * - Packets: data characters up to each EOP or EEP are collected in a
+ *   caller buffer and passed to sw_packet_decode(), and the result to a
+ *   callback.
+ *
+ * Synchronisation: like a receiver after link reset, the decoder ignores
+ * everything until it has seen a NULL, whose bit pattern fixes the
+ * character boundaries. Both lines are taken to be low before the first
+ * sample.
+ *
+ * Samples are bit-sliced: each line is packed 64 samples to a word
+ * (sample i is bit i % 64 of word i / 64), so edge detection runs 64
+ * samples per operation and, with BMI2, the bits of a word are gathered
+ * with one PEXT. sw_ds_pack() converts the common one-octet-per-sample
+ * export format eight samples per multiply. The encoder produces such
+ * words from characters, for stimulus and tests.
+ */
+
+#ifndef SPACEWIRE_DS_H
+#define SPACEWIRE_DS_H
+
+#include "spacewire_packet.h"
+
+/** @brief Samples per packed word. */
+#define SW_DS_WORD_SAMPLES 64u
+
+/**
+ * @brief Decoded character classes and link events.
+ */
+typedef enum
+{
+    SW_DS_DATA = 0,         /**< Data character; value is the octet. */
+    SW_DS_EOP = 1,          /**< End of packet. */
+    SW_DS_EEP = 2,          /**< Error end of packet. */
+    SW_DS_FCT = 3,          /**< Flow-control token. */
+    SW_DS_NULL = 4,         /**< NULL (ESC FCT). */
+    SW_DS_TIME_CODE = 5,    /**< Time-code; value is the time (bits 0-5) and flags (6-7). */
+    SW_DS_PARITY_ERROR = 6, /**< Parity error; synchronisation lost. */
+    SW_DS_ESC_ERROR = 7,    /**< ESC followed by EOP, EEP or ESC; synchronisation lost. */
+    SW_DS_DISCONNECT = 8    /**< No bit for too long; synchronisation lost. */
+} sw_ds_char_type_t;
+
+/**
+ * @brief A decoded character or link event.
+ */
+typedef struct
+{
+    uint64_t sample; /**< Sample of its first bit; for a disconnect, the gap's first. */
+    uint8_t type;    /**< ::sw_ds_char_type_t. */
+    uint8_t value;   /**< Octet of a data character or time-code. */
+} sw_ds_char_t;
+
+/**
+ * @brief Receive a decoded character or event (debug path; slower).
+ *
+ * @param[in] ctx Context from ::sw_ds_config_t.
+ * @param[in] ch  Character.
+ */
+typedef void (*sw_ds_char_fn)(void *ctx, const sw_ds_char_t *ch);
+
+/**
+ * @brief Receive a packet and what sw_packet_decode() made of it.
+ *
+ * @param[in] ctx    Context from ::sw_ds_config_t.
+ * @param[in] pf     Decoded frame; valid when @p result is ::SW_OK.
+ * @param[in] result Result of sw_packet_decode().
+ * @param[in] status PTP status from sw_packet_decode().
+ * @param[in] pkt    Packet octets as received.
+ * @param[in] len    Packet length.
+ * @param[in] end    How the packet ended.
+ */
+typedef void (*sw_ds_packet_fn)(void *ctx,
+                                const sw_packet_frame_t *pf,
+                                sw_result_t result,
+                                sw_ptp_status_t status,
+                                const uint8_t *pkt,
+                                size_t len,
+                                sw_end_marker_t end);
+
+/**
+ * @brief Decoder configuration.
+ */
+typedef struct
+{
+    uint8_t *buf;                /**< Packet buffer. */
+    uint32_t cap;                /**< Its capacity; longer packets are dropped. */
+    uint32_t disconnect_samples; /**< Gap that is a disconnect; 0 for none, else >= 64. */
+    sw_ds_packet_fn on_packet;   /**< Packet callback; may be NULL. */
+    sw_ds_char_fn on_char;       /**< Character callback; may be NULL. */
+    void *ctx;                   /**< Context for the callbacks. */
+} sw_ds_config_t;
+
+/**
+ * @brief Decoder counters.
+ */
+typedef struct
+{
+    uint64_t bits;             /**< Bits recovered. */
+    uint64_t data;             /**< Data characters. */
+    uint64_t eops;             /**< EOPs. */
+    uint64_t eeps;             /**< EEPs received. */
+    uint64_t fcts;             /**< FCTs. */
+    uint64_t nulls;            /**< NULLs. */
+    uint64_t time_codes;       /**< Time-codes. */
+    uint32_t parity_errors;    /**< Parity errors. */
+    uint32_t escape_errors;    /**< Escape errors. */
+    uint32_t disconnects;      /**< Disconnects. */
+    uint32_t packets;          /**< Packets passed to sw_packet_decode(). */
+    uint32_t packets_ok;       /**< Of those, decoded with ::SW_OK. */
+    uint32_t packets_oversize; /**< Packets longer than the buffer, dropped. */
+} sw_ds_stats_t;
+
+/**
+ * @brief Decoder state.
+ */
+typedef struct
+{
+    sw_ds_config_t config;    /**< Configuration. */
+    sw_ds_stats_t stats;      /**< Counters. */
+    uint64_t acc;             /**< Recovered bits not yet parsed, oldest in bit 0. */
+    uint64_t bit_sample[128]; /**< Sample of each queued bit by bit number % 128 (on_char). */
+    uint64_t parsed;          /**< Bits parsed so far (the number of acc bit 0). */
+    uint64_t samples;         /**< Samples consumed. */
+    uint64_t gap;             /**< Samples since the last bit. */
+    uint64_t esc_sample;      /**< Sample of the last ESC. */
+    uint32_t len;             /**< Octets of the packet being received. */
+    uint8_t nbits;            /**< Valid bits in @ref acc. */
+    uint8_t prev_x;           /**< D xor S at the last sample. */
+    uint8_t synced;           /**< 1 once a NULL has fixed the character boundaries. */
+    uint8_t parity;           /**< Parity of the previous character's data or control bits. */
+    uint8_t escape;           /**< 1 after an ESC. */
+    uint8_t oversize;         /**< 1 if the packet being received overflowed. */
+    uint8_t disconnected;     /**< 1 while the current gap is already reported. */
+} sw_ds_decoder_t;
+
+/**
+ * @brief Initialise a decoder.
+ *
+ * @param[out] dec    Decoder.
+ * @param[in]  config Configuration; copied.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ds_init(sw_ds_decoder_t *dec, const sw_ds_config_t *config);
+
+/**
+ * @brief Decode the next packed samples of a capture.
+ *
+ * Characters and packets are reported as they complete; a character split
+ * across calls is completed by the next one.
+ *
+ * @param[in,out] dec   Decoder.
+ * @param[in]     d     Data line, ::SW_DS_WORD_SAMPLES samples per word.
+ * @param[in]     s     Strobe line, likewise.
+ * @param[in]     words Words of each.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ds_decode(sw_ds_decoder_t *dec, const uint64_t *d, const uint64_t *s, size_t words);
+
+/**
+ * @brief Pack one-octet-per-sample captures into line words.
+ *
+ * @param[in]  samples Samples, each an octet of channel bits.
+ * @param[in]  count   Number of samples; a multiple of ::SW_DS_WORD_SAMPLES.
+ * @param[in]  d_bit   Channel bit (0..7) of the Data line.
+ * @param[in]  s_bit   Channel bit of the Strobe line.
+ * @param[out] d       count / 64 Data words.
+ * @param[out] s       count / 64 Strobe words.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ds_pack(const uint8_t *samples,
+                       size_t count,
+                       unsigned d_bit,
+                       unsigned s_bit,
+                       uint64_t *d,
+                       uint64_t *s);
+
+/* ============================================================================
+ * ENCODER
+ * ============================================================================ */
+
+/**
+ * @brief Data-strobe encoder writing line words.
+ */
+typedef struct
+{
+    uint64_t *d;              /**< Data words. */
+    uint64_t *s;              /**< Strobe words. */
+    size_t max_words;         /**< Capacity of each. */
+    uint64_t samples;         /**< Samples written. */
+    uint32_t samples_per_bit; /**< Oversampling ratio. */
+    uint8_t d_level;          /**< Current Data level. */
+    uint8_t s_level;          /**< Current Strobe level. */
+    uint8_t parity;           /**< Parity of the previous character's data or control bits. */
+} sw_ds_encoder_t;
+
+/**
+ * @brief Initialise an encoder; both lines start low and the words are cleared.
+ *
+ * @param[out] enc             Encoder.
+ * @param[out] d               Data words.
+ * @param[out] s               Strobe words.
+ * @param[in]  max_words       Capacity of each.
+ * @param[in]  samples_per_bit Samples per bit; non-zero.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ds_encoder_init(sw_ds_encoder_t *enc,
+                               uint64_t *d,
+                               uint64_t *s,
+                               size_t max_words,
+                               uint32_t samples_per_bit);
+
+/**
+ * @brief Encode one character.
+ *
+ * @param[in,out] enc   Encoder.
+ * @param[in]     type  ::SW_DS_DATA, ::SW_DS_EOP, ::SW_DS_EEP, ::SW_DS_FCT,
+ *                      ::SW_DS_NULL or ::SW_DS_TIME_CODE.
+ * @param[in]     value Octet of a data character or time-code.
+ * @return ::SW_OK, ::SW_ERR if the words are full, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ds_encode_char(sw_ds_encoder_t *enc, sw_ds_char_type_t type, uint8_t value);
+
+/**
+ * @brief Encode a packet: its octets as data characters, then EOP or EEP.
+ *
+ * @param[in,out] enc Encoder.
+ * @param[in]     pkt Packet.
+ * @param[in]     len Length.
+ * @param[in]     end End marker.
+ * @return ::SW_OK, ::SW_ERR if the words are full, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ds_encode_packet(sw_ds_encoder_t *enc,
+                                const uint8_t *pkt,
+                                size_t len,
+                                sw_end_marker_t end);
+
+#endif /* SPACEWIRE_DS_H */
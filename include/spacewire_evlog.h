@@ -0,0 +1,195 @@
+/**
+ * @file spacewire_evlog.h
+ * @brief Flight-recorder event log for link and routing anomalies.
+ *
+ * Each thread that should be recorded attaches its own ring of fixed-size
+ * 16-octet records. The library then logs link-state changes made through
+ * sw_link_set_state(), invalid-address discards in sw_router_route() and EEP
+ * discards in sw_packet_decode() into the calling thread's ring; the
+ * application adds its own events (e.g. link disconnect timeouts reported by
+ * the CODEC) with sw_evlog_record().
+ *
+ * A ring has a single writer, its owning thread, so recording is a timestamp
+ * read, five stores and a release store of the head — no locks and no
+ * read-modify-write. Threads without a ring pay one thread-local load and a
+ * branch. Snapshots and dumps may run concurrently from any thread, including
+ * a crash handler, and never block the writer: records overwritten while
+ * being copied are left out.
+ */
+
+#ifndef SPACEWIRE_EVLOG_H
+#define SPACEWIRE_EVLOG_H
+
+#include "spacewire.h"
+
+/**
+ * @brief Storage class of the per-thread ring pointer.
+ *
+ * Defaults to the GCC/Clang `__thread` specifier. Single-threaded targets may
+ * build with `-DSW_EVLOG_THREAD_LOCAL=` to use one plain global.
+ */
+#ifndef SW_EVLOG_THREAD_LOCAL
+#    define SW_EVLOG_THREAD_LOCAL __thread
+#endif
+
+/** @brief Magic value at the start of each ring in a dump ("SWEV"). */
+#define SW_EVLOG_DUMP_MAGIC 0x53574556u
+
+/**
+ * @brief Event types.
+ */
+typedef enum
+{
+    SW_EV_NONE = 0x00,            /**< Unused record. */
+    SW_EV_LINK_STATE = 0x01,      /**< Link state changed; aux = old, arg = new state. */
+    SW_EV_INVALID_ADDRESS = 0x02, /**< Router invalid-address discard; arg = leading octet. */
+    SW_EV_EEP = 0x03,             /**< Packet discarded on EEP; arg = length (saturated). */
+    SW_EV_TIMEOUT = 0x04,         /**< Timeout reported by the application; arg is its own. */
+    SW_EV_USER = 0x80             /**< First application-defined type. */
+} sw_ev_type_t;
+
+/**
+ * @brief One event record (16 octets).
+ */
+typedef struct
+{
+    uint64_t timestamp; /**< Timestamp counter at the event, see sw_evlog_timestamp(). */
+    uint32_t obj;       /**< Object the event concerns: low 32 bits of its address. */
+    uint16_t arg;       /**< Type-specific argument. */
+    uint8_t type;       /**< ::sw_ev_type_t. */
+    uint8_t aux;        /**< Type-specific auxiliary octet. */
+} sw_ev_record_t;
+
+/**
+ * @brief A per-thread event ring.
+ *
+ * @note `head` is written by the owning thread only and read atomically by
+ *       snapshots; `next` links registered rings.
+ */
+typedef struct sw_evlog_ring
+{
+    sw_ev_record_t *records;    /**< Caller-owned record storage. */
+    uint32_t mask;              /**< Record count - 1; the count is a power of two. */
+    uint32_t head;              /**< Records written so far (free-running). */
+    uint32_t thread_id;         /**< Application-chosen identifier for dumps. */
+    struct sw_evlog_ring *next; /**< Next registered ring. */
+} sw_evlog_ring_t;
+
+/**
+ * @brief Header written ahead of each ring by sw_evlog_dump().
+ */
+typedef struct
+{
+    uint32_t magic;     /**< ::SW_EVLOG_DUMP_MAGIC. */
+    uint32_t thread_id; /**< Ring's thread identifier. */
+    uint32_t head;      /**< Ring head when the dump started. */
+    uint32_t count;     /**< Number of records that follow. */
+} sw_evlog_dump_header_t;
+
+/**
+ * @brief Sink for sw_evlog_dump(), e.g. a wrapper around write(2).
+ *
+ * @return 0 on success, non-zero to abort the dump.
+ */
+typedef int (*sw_evlog_write_fn)(void *ctx, const void *data, size_t len);
+
+/**
+ * @brief Read the event timestamp counter.
+ *
+ * The x86 TSC or the AArch64 virtual counter. Define `SW_EVLOG_TIMESTAMP()` to
+ * an expression yielding a `uint64_t` to use another clock (e.g. a hardware
+ * timer on an embedded target); without either, 0 is recorded and events are
+ * ordered by their position in the ring only.
+ */
+static inline uint64_t sw_evlog_timestamp(void)
+{
+#if defined(SW_EVLOG_TIMESTAMP)
+    return (uint64_t)(SW_EVLOG_TIMESTAMP());
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint64_t)__builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Initialise a ring over caller-owned storage.
+ *
+ * @param[out] ring      Ring to initialise.
+ * @param[in]  records   Record storage.
+ * @param[in]  count     Number of records; a power of two, at least 2. The
+ *                       ring retains the @p count - 1 most recent records.
+ * @param[in]  thread_id Identifier reported in dumps.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_evlog_ring_init(sw_evlog_ring_t *ring,
+                               sw_ev_record_t *records,
+                               uint32_t count,
+                               uint32_t thread_id);
+
+/**
+ * @brief Make @p ring the calling thread's event ring.
+ *
+ * @param[in] ring Ring to record into, or NULL to stop recording.
+ */
+void sw_evlog_attach(sw_evlog_ring_t *ring);
+
+/**
+ * @brief The calling thread's event ring.
+ *
+ * @return Attached ring, or NULL.
+ */
+sw_evlog_ring_t *sw_evlog_current(void);
+
+/**
+ * @brief Add a ring to the process-wide list walked by sw_evlog_dump().
+ *
+ * Lock-free; a registered ring must stay valid for the life of the process.
+ *
+ * @param[in] ring Ring to register.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM if @p ring is NULL or already listed.
+ */
+sw_result_t sw_evlog_register(sw_evlog_ring_t *ring);
+
+/**
+ * @brief Record an event in the calling thread's ring.
+ *
+ * No-op if the thread has no ring attached.
+ *
+ * @param[in] type Event type.
+ * @param[in] obj  Object the event concerns; may be NULL.
+ * @param[in] arg  Type-specific argument.
+ * @param[in] aux  Type-specific auxiliary octet.
+ */
+void sw_evlog_record(sw_ev_type_t type, const void *obj, uint16_t arg, uint8_t aux);
+
+/**
+ * @brief Copy a ring's surviving records, oldest first.
+ *
+ * @param[in]  ring Ring to read; may be owned by another thread.
+ * @param[out] out  Destination.
+ * @param[in]  max  Capacity of @p out in records.
+ * @return Records copied: the most recent ones (at most the ring size - 1)
+ *         that were not overwritten while being copied.
+ */
+size_t sw_evlog_snapshot(const sw_evlog_ring_t *ring, sw_ev_record_t *out, size_t max);
+
+/**
+ * @brief Write every registered ring to a sink.
+ *
+ * Each ring is written as an ::sw_evlog_dump_header_t followed by its records,
+ * oldest first, in host byte order. Uses only a small stack buffer, so it may
+ * be called from a crash handler if @p sink is async-signal-safe.
+ *
+ * @param[in] sink Sink.
+ * @param[in] ctx  Context passed to @p sink.
+ * @return ::SW_OK, ::SW_INVALID_PARAM if @p sink is NULL, or ::SW_ERR if the
+ *         sink failed.
+ */
+sw_result_t sw_evlog_dump(sw_evlog_write_fn sink, void *ctx);
+
+#endif /* SPACEWIRE_EVLOG_H */
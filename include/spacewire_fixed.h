@@ -0,0 +1,96 @@
+/**
+ * @file spacewire_fixed.h
+ * @brief Encoders specialised at compile time for fixed-size command packets.
+ *
+ * Most commands have a fixed logical address, user application, APID and
+ * payload size; only the sequence count and the payload octets change from
+ * one packet to the next. SW_DEFINE_FIXED_COMMAND() emits, for one such
+ * definition, an inline encoder that writes the same octets as
+ * sw_packet_encode() (path-less, ECSS-E-ST-50-53C Figure 5-1) with:
+ *
+ * - the encapsulation header and the constant parts of the CCSDS primary
+ *   header (version, type, secondary-header flag, APID, sequence flags,
+ *   packet data length) folded into constants at compile time;
+ * - the payload copied with a constant-size memcpy(), which the compiler
+ *   turns into straight-line stores for small payloads;
+ * - no run-time length, bounds or argument checks: the definition is
+ *   checked at compile time instead, and the caller's buffer must hold
+ *   `<name>_LEN` octets.
+ *
+ * The encoder does not update the sw_get_statistics() counters and records
+ * no trace span; count commands in the caller if those are needed.
+ *
+ * Example, a 12-octet PUS telecommand payload to logical address 0x42:
+ *
+ *     SW_DEFINE_FIXED_COMMAND(cmd_set_mode, 0x42, 0, SP_PACKET_TYPE_TC, 1, 0x123, 3, 12)
+ *
+ *     uint8_t pkt[cmd_set_mode_LEN];
+ *     size_t n = cmd_set_mode_encode(pkt, seq++, payload);
+ */
+
+#ifndef SPACEWIRE_FIXED_H
+#define SPACEWIRE_FIXED_H
+
+#include "spacewire_packet.h"
+
+#include <string.h>
+
+/** @brief Octets of a fixed command before its payload: encapsulation and primary header. */
+#define SW_FIXED_HEADER_LEN (SW_PTP_HEADER_LEN + 6u)
+
+/**
+ * @brief Compile-time check inside a definition; a negative array size fails
+ *        the build.
+ */
+#define SW_FIXED_CHECK(name, what, cond) typedef char name##_##what[(cond) ? 1 : -1]
+
+/**
+ * @brief Define a specialised encoder for a fixed-size command.
+ *
+ * Emits `<name>_LEN`, the encoded length, and
+ * `size_t <name>_encode(uint8_t *buf, uint16_t seq_count, const uint8_t *payload)`,
+ * which writes `<name>_LEN` octets to @p buf (the sequence count is taken
+ * modulo 2^14) and returns `<name>_LEN`.
+ *
+ * @param name         Identifier prefix.
+ * @param logical_addr Target Logical Address (32..254).
+ * @param user_app     User Application value.
+ * @param type         Packet type, ::SP_PACKET_TYPE_TM or ::SP_PACKET_TYPE_TC.
+ * @param sec_hdr      Secondary-header flag, 0 or 1.
+ * @param apid         APID, 0..0x7FF.
+ * @param seq_flags    Sequence flags, 0..3 (3: unsegmented).
+ * @param payload_len  Payload octets, 1..65535.
+ */
+#define SW_DEFINE_FIXED_COMMAND(name,                                                              \
+                                logical_addr,                                                      \
+                                user_app,                                                          \
+                                type,                                                              \
+                                sec_hdr,                                                           \
+                                apid,                                                              \
+                                seq_flags,                                                         \
+                                payload_len)                                                       \
+    SW_FIXED_CHECK(name, addr_ok, (logical_addr) >= 32 && (logical_addr) <= 254);                  \
+    SW_FIXED_CHECK(name, fields_ok, (user_app) <= 0xFF && (type) <= 1 && (sec_hdr) <= 1);          \
+    SW_FIXED_CHECK(name, apid_ok, (apid) <= 0x7FF && (seq_flags) <= 3);                            \
+    SW_FIXED_CHECK(name, len_ok, (payload_len) >= 1 && (payload_len) <= 0xFFFF);                   \
+    enum                                                                                           \
+    {                                                                                              \
+        name##_LEN = SW_FIXED_HEADER_LEN + (payload_len)                                           \
+    };                                                                                             \
+    static inline size_t name##_encode(uint8_t *buf, uint16_t seq_count, const uint8_t *payload)   \
+    {                                                                                              \
+        buf[0] = (uint8_t)(logical_addr);                                                          \
+        buf[1] = (uint8_t)SW_PTP_PROTOCOL_ID;                                                      \
+        buf[2] = (uint8_t)SW_PTP_RESERVED;                                                         \
+        buf[3] = (uint8_t)(user_app);                                                              \
+        buf[4] = (uint8_t)(((type) << 4) | ((sec_hdr) << 3) | ((apid) >> 8));                      \
+        buf[5] = (uint8_t)((apid) & 0xFF);                                                         \
+        buf[6] = (uint8_t)(((seq_flags) << 6) | ((seq_count >> 8) & 0x3Fu));                       \
+        buf[7] = (uint8_t)(seq_count & 0xFFu);                                                     \
+        buf[8] = (uint8_t)(((payload_len) - 1) >> 8);                                              \
+        buf[9] = (uint8_t)(((payload_len) - 1) & 0xFF);                                            \
+        memcpy(&buf[SW_FIXED_HEADER_LEN], payload, (payload_len));                                 \
+        return (size_t)name##_LEN;                                                                 \
+    }
+
+#endif /* SPACEWIRE_FIXED_H */
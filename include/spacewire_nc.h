@@ -0,0 +1,155 @@
+/**
+ * @file spacewire_nc.h
+ * @brief Worst-case delay and backlog bounds for flows (network calculus).
+ *
+ * The analyser takes a network (spacewire_net.h) with the routing tables
+ * installed in its routers, link bit rates and latencies, and a set of flows.
+ * Each flow runs from a source node to a logical address and is bounded by
+ * the token-bucket arrival curve a policer or shaper at the source enforces:
+ * at most `burst + rate * t` octets in any interval of length t, in packets
+ * of at most `max_len` octets. For every flow it gives a worst-case
+ * end-to-end delay and a worst-case backlog, or says why there is none.
+ *
+ * Network model, in the wormhole terms of ECSS-E-ST-50-12C:
+ *
+ * - a packet holds each output port from the moment it is granted until its
+ *   tail has crossed that link, and it holds the ports behind it while its
+ *   header waits further on (no buffering is credited, which is safe);
+ * - an output port grants waiting input ports in round-robin order, so while
+ *   a packet waits, every other input port gets the port at most once;
+ * - a data character takes 10 bit times, as in the simulator; a packet's
+ *   tail moves at the rate of the slowest link still ahead of it;
+ * - packets injected at a node enter its router through port 0 in FIFO
+ *   order, and are delivered at the node owning their address without
+ *   further contention.
+ *
+ * Per-packet bound (recursive calculus). Let hop h of a flow be the output
+ * port it takes at the h-th router. Its occupancy O(h), from grant to the
+ * tail crossing the link, is the link latency, plus the wait at hop h + 1,
+ * plus O(h + 1), plus the extra tail time where link h is the bottleneck.
+ * The wait at a hop is, for every other input port feeding the same output,
+ * the longest occupancy of a flow from that input. The traversal of one
+ * packet, once at the head of its source queue, is D = wait(0) + O(0). Both
+ * are independent of the load, because round-robin caps each competitor at
+ * one packet per grant. Occupancies are memoised per hop, so the cost is the
+ * sum over output ports of (hops on the port)², and a cycle of hops waiting
+ * on one another (a possible wormhole deadlock) is detected rather than
+ * followed.
+ *
+ * Source bound (network calculus). The injection queue of a node serves its
+ * flows' packets one at a time, each within its D, so it offers them the
+ * rate-latency service curve R (t - T)+ with R = min(max_len / D) and
+ * T = max(D). Against the sum of the flows' token buckets (σ, ρ) this gives
+ * a delay bound of T + σ / R and a backlog bound of σ + ρ T, valid while
+ * ρ <= R. The flows of one source share the bound.
+ *
+ * All storage is caller-owned. Routes are read with sw_router_get_route();
+ * the network is not modified.
+ */
+
+#ifndef SPACEWIRE_NC_H
+#define SPACEWIRE_NC_H
+
+#include "spacewire_net.h"
+
+/** @brief "No hop" index. */
+#define SW_NC_NONE UINT32_MAX
+
+/** @brief A delay or backlog with no finite bound. */
+#define SW_NC_UNBOUNDED UINT64_MAX
+
+/**
+ * @brief Outcome of the analysis of one flow.
+ */
+typedef enum
+{
+    SW_NC_BOUNDED = 0,  /**< Delay and backlog are bounded. */
+    SW_NC_NO_ROUTE = 1, /**< The routing tables do not lead to the address. */
+    SW_NC_OVERLOAD = 2, /**< The source's flows exceed the rate it is guaranteed. */
+    SW_NC_DEADLOCK = 3  /**< The flow waits on a cycle of held ports. */
+} sw_nc_status_t;
+
+/**
+ * @brief A flow and its arrival curve.
+ */
+typedef struct
+{
+    uint16_t src;     /**< Source node. */
+    uint8_t dst_addr; /**< Destination logical address (32..254). */
+    uint16_t max_len; /**< Largest packet in octets, address included; non-zero. */
+    uint32_t burst;   /**< Arrival-curve burst in octets. */
+    uint32_t rate;    /**< Arrival-curve rate in octets/s. */
+} sw_nc_flow_t;
+
+/**
+ * @brief One hop of a flow: an output port it takes.
+ */
+typedef struct
+{
+    uint32_t flow;         /**< Flow index. */
+    uint32_t next;         /**< Next hop on the same output port, or ::SW_NC_NONE. */
+    uint32_t out;          /**< Output port: link * 2, plus 1 if sent from link.node[1]. */
+    uint8_t in_port;       /**< Input port the flow arrives on (0 at the source). */
+    uint8_t last;          /**< 1 on the flow's last hop. */
+    uint8_t state;         /**< Internal: occupancy not computed, in progress or known. */
+    uint64_t tx_ns;        /**< Tail time at the slowest link from here on. */
+    uint64_t occupancy_ns; /**< Worst-case occupancy of the port, or ::SW_NC_UNBOUNDED. */
+} sw_nc_hop_t;
+
+/**
+ * @brief Bounds of one source node's injection queue.
+ */
+typedef struct
+{
+    uint64_t burst;      /**< Sum of its flows' bursts in octets. */
+    uint64_t rate;       /**< Sum of its flows' rates in octets/s. */
+    uint64_t latency_ns; /**< T: largest per-packet traversal. */
+    double service;      /**< R: guaranteed rate in octets/ns. */
+} sw_nc_source_t;
+
+/**
+ * @brief Scratch space for the analysis.
+ */
+typedef struct
+{
+    sw_nc_hop_t *hops;       /**< Hop storage: at most max_nodes - 1 per flow. */
+    size_t max_hops;         /**< Capacity of @ref hops. */
+    uint32_t *out_head;      /**< 2 * max_links list heads, one per output port. */
+    sw_nc_source_t *sources; /**< max_nodes source aggregates. */
+} sw_nc_work_t;
+
+/**
+ * @brief Bounds of one flow.
+ */
+typedef struct
+{
+    uint8_t status;     /**< ::sw_nc_status_t. */
+    uint8_t num_hops;   /**< Output ports on the path. */
+    uint32_t first_hop; /**< Index of its first hop in the work's hop array. */
+    uint64_t packet_ns; /**< D: traversal of one packet from the head of the source queue. */
+    uint64_t delay_ns;  /**< Worst-case end-to-end delay, or ::SW_NC_UNBOUNDED. */
+    uint64_t backlog;   /**< Worst-case source backlog in octets, or ::SW_NC_UNBOUNDED. */
+} sw_nc_bound_t;
+
+/**
+ * @brief Compute worst-case bounds for a set of flows.
+ *
+ * A flow that cannot be bounded gets its status and ::SW_NC_UNBOUNDED; a
+ * deadlock or overload holds up the other flows of its source as well. The
+ * rest are still analysed.
+ *
+ * @param[in]  net       Network with routes installed.
+ * @param[in]  flows     Flows.
+ * @param[in]  num_flows Number of flows; less than ::SW_NC_NONE.
+ * @param[in]  work      Scratch space; hops stay valid for inspection.
+ * @param[out] bounds    num_flows results.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM if an argument is invalid or the
+ *         hop storage is too small.
+ */
+sw_result_t sw_nc_analyse(const sw_net_t *net,
+                          const sw_nc_flow_t *flows,
+                          size_t num_flows,
+                          const sw_nc_work_t *work,
+                          sw_nc_bound_t *bounds);
+
+#endif /* SPACEWIRE_NC_H */
@@ -0,0 +1,293 @@
+/**
+ * @file spacewire_net.h
+ * @brief Network model: routers, terminals and links, with shortest-path routing.
+ *
+ * A network is a set of nodes, each one a ::sw_router_t, joined by
+ * full-duplex links between numbered ports. A node may own a logical address;
+ * packets arriving with that address in the leading octet are delivered to
+ * the node rather than routed, which models a terminal, or a router with a
+ * node attached to its configuration port.
+ *
+ * Route computation plays the part of the network manager: it runs a
+ * shortest-path search towards every addressed node over the links that are
+ * up and writes the resulting next-hop ports into a table that can be
+ * installed into the routers, compared with the previous table or handed to
+ * the simulator (spacewire_sim.h) to install later. After the first
+ * computation, link changes can instead be applied incrementally
+ * (sw_net_spf_set_link()): only the destinations the change affects are
+ * recomputed, and the result is the list of routing-table entries that
+ * changed rather than a whole new table.
+ *
+ * All storage is caller-owned. Nodes and links are referred to by index.
+ */
+
+#ifndef SPACEWIRE_NET_H
+#define SPACEWIRE_NET_H
+
+#include "spacewire.h"
+
+/** @brief "No node" / "no link" index. */
+#define SW_NET_NONE 0xFFFFu
+
+/** @brief Route-table entry of an address a node cannot reach (or owns). */
+#define SW_NET_NO_ROUTE 0xFFu
+
+/** @brief Distance of an unreachable node. */
+#define SW_NET_UNREACHABLE UINT64_MAX
+
+/** @brief Number of assignable logical addresses (32..254). */
+#define SW_NET_NUM_ADDRS (SW_LOGICAL_ADDR_RESERVED - SW_LOGICAL_ADDR_MIN)
+
+/**
+ * @brief A full-duplex link between two node ports.
+ */
+typedef struct
+{
+    uint16_t node[2];    /**< Endpoint nodes. */
+    uint8_t port[2];     /**< Port at each endpoint. */
+    uint8_t up;          /**< 1 if the link is running (as known to the manager). */
+    uint32_t cost;       /**< Routing metric; 1 (hop count) unless changed. */
+    uint32_t bit_rate;   /**< Signalling rate in bit/s. */
+    uint32_t latency_ns; /**< Propagation and switching delay in ns. */
+} sw_net_link_t;
+
+/**
+ * @brief A network node.
+ */
+typedef struct
+{
+    sw_router_t router;               /**< Routing switch of the node. */
+    uint16_t port_link[SW_NUM_PORTS]; /**< Link on each port, or ::SW_NET_NONE. */
+    uint8_t logical_addr;             /**< Address delivered here, or 0 for none. */
+} sw_net_node_t;
+
+/**
+ * @brief A network over caller-owned node and link arrays.
+ */
+typedef struct
+{
+    sw_net_node_t *nodes;                    /**< Node storage. */
+    sw_net_link_t *links;                    /**< Link storage. */
+    uint16_t num_nodes;                      /**< Nodes in use. */
+    uint16_t max_nodes;                      /**< Capacity of @ref nodes. */
+    uint16_t num_links;                      /**< Links in use. */
+    uint16_t max_links;                      /**< Capacity of @ref links. */
+    uint16_t addr_node[SW_ROUTE_TABLE_SIZE]; /**< Node owning each logical address. */
+} sw_net_t;
+
+/**
+ * @brief Scratch space for route computation, each array sized for
+ *        ::sw_net_t::max_nodes entries.
+ */
+typedef struct
+{
+    uint64_t *dist; /**< Distance of each node to the destination (full computation). */
+    uint16_t *heap; /**< Priority-queue storage. */
+    uint16_t *pos;  /**< Position of each node in @ref heap. */
+    uint16_t *list; /**< Affected nodes (incremental updates only). */
+    uint8_t *mark;  /**< Affected-node flags (incremental updates only). */
+} sw_net_work_t;
+
+/**
+ * @brief One routing-table change: what sw_router_add_route() or
+ *        sw_router_remove_route() must do on one router.
+ */
+typedef struct
+{
+    uint16_t node; /**< Router (node index). */
+    uint8_t addr;  /**< Logical address. */
+    uint8_t port;  /**< New output port, or ::SW_NET_NO_ROUTE to remove the route. */
+} sw_net_route_change_t;
+
+/**
+ * @brief Shortest-path state kept between incremental updates.
+ */
+typedef struct
+{
+    uint64_t *dist;     /**< ::SW_NET_NUM_ADDRS rows of max_nodes distances. */
+    uint8_t *table;     /**< Current route table, as from sw_net_compute_routes(). */
+    sw_net_work_t work; /**< Scratch space (dist unused). */
+    size_t stride;      /**< Row length of @ref dist. */
+} sw_net_spf_t;
+
+/**
+ * @brief Initialise an empty network.
+ *
+ * @param[out] net       Network to initialise.
+ * @param[in]  nodes     Node storage.
+ * @param[in]  max_nodes Capacity of @p nodes; less than ::SW_NET_NONE.
+ * @param[in]  links     Link storage.
+ * @param[in]  max_links Capacity of @p links; less than ::SW_NET_NONE.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_net_init(sw_net_t *net,
+                        sw_net_node_t *nodes,
+                        uint16_t max_nodes,
+                        sw_net_link_t *links,
+                        uint16_t max_links);
+
+/**
+ * @brief Copy a network into other storage, e.g. one copy per worker thread.
+ *
+ * Routers sharing a table get a copy of it each (sw_router_copy()), so the
+ * copy shares nothing with @p src.
+ *
+ * @param[out] dst   Network to initialise.
+ * @param[in]  nodes Node storage for at least src->max_nodes nodes.
+ * @param[in]  links Link storage for at least src->max_links links.
+ * @param[in]  src   Network to copy.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_net_clone(sw_net_t *dst,
+                         sw_net_node_t *nodes,
+                         sw_net_link_t *links,
+                         const sw_net_t *src);
+
+/**
+ * @brief Add a node.
+ *
+ * @param[in,out] net          Network.
+ * @param[in]     num_ports    Ports of the node's router, counting port 0.
+ * @param[in]     logical_addr Address delivered at the node (32..254), or 0.
+ * @param[out]    index        Index of the new node; may be NULL.
+ * @return ::SW_OK, ::SW_WRONG_ADDRESS if the address is invalid or taken, or
+ *         ::SW_INVALID_PARAM if the network is full.
+ */
+sw_result_t sw_net_add_node(sw_net_t *net,
+                            uint8_t num_ports,
+                            uint8_t logical_addr,
+                            uint16_t *index);
+
+/**
+ * @brief Connect two unused node ports with a link that is up.
+ *
+ * @param[in,out] net        Network.
+ * @param[in]     a          First node.
+ * @param[in]     port_a     Port of @p a (1..num_ports - 1).
+ * @param[in]     b          Second node.
+ * @param[in]     port_b     Port of @p b.
+ * @param[in]     bit_rate   Signalling rate in bit/s; non-zero.
+ * @param[in]     latency_ns Propagation and switching delay in ns.
+ * @param[out]    index      Index of the new link; may be NULL.
+ * @return ::SW_OK, ::SW_WRONG_PORT if a port does not exist or is in use, or
+ *         ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_net_connect(sw_net_t *net,
+                           uint16_t a,
+                           uint8_t port_a,
+                           uint16_t b,
+                           uint8_t port_b,
+                           uint32_t bit_rate,
+                           uint32_t latency_ns,
+                           uint16_t *index);
+
+/**
+ * @brief The node at the far end of a port.
+ *
+ * @param[in]  net  Network.
+ * @param[in]  node Node.
+ * @param[in]  port Port of @p node.
+ * @param[out] peer_port Port at the far end; may be NULL.
+ * @return Peer node, or ::SW_NET_NONE if the port has no link.
+ */
+uint16_t sw_net_peer(const sw_net_t *net, uint16_t node, uint8_t port, uint8_t *peer_port);
+
+/**
+ * @brief Compute next-hop ports from every node to every addressed node.
+ *
+ * One shortest-path search per addressed node over the links that are up.
+ * Among equal-cost next hops a node picks its lowest-numbered port, so the
+ * table depends only on the topology, never on search order.
+ *
+ * @param[in]  net   Network.
+ * @param[in]  work  Scratch space.
+ * @param[out] table ::sw_net_t::num_nodes rows of ::SW_ROUTE_TABLE_SIZE ports:
+ *                   `table[node * 256 + addr]`, ::SW_NET_NO_ROUTE where the
+ *                   address is unreachable, unassigned or owned by the node.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_net_compute_routes(const sw_net_t *net, const sw_net_work_t *work, uint8_t *table);
+
+/**
+ * @brief Compute routes and keep the shortest-path state for incremental updates.
+ *
+ * The set of nodes and addresses is fixed from here on; links may change only
+ * through sw_net_spf_set_link(). Link costs must be at least 1.
+ *
+ * @param[out] spf   State to initialise.
+ * @param[in]  net   Network.
+ * @param[in]  dist  Storage for ::SW_NET_NUM_ADDRS * net->max_nodes distances.
+ * @param[out] table Route table, laid out as for sw_net_compute_routes().
+ * @param[in]  work  Scratch space with heap, pos, list and mark; its arrays
+ *                   are used again by every update.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_net_spf_init(sw_net_spf_t *spf,
+                            const sw_net_t *net,
+                            uint64_t *dist,
+                            uint8_t *table,
+                            const sw_net_work_t *work);
+
+/**
+ * @brief Change a link's state or cost and update the routes incrementally.
+ *
+ * spf->table ends up identical to what sw_net_compute_routes() would give for
+ * the new topology. The entries that differ from the previous table are
+ * written to @p changes, sorted by router and then address, ready for
+ * sw_net_apply_route_changes().
+ *
+ * @param[in,out] spf         State from sw_net_spf_init().
+ * @param[in,out] net         Network (the link is updated).
+ * @param[in]     link        Link.
+ * @param[in]     up          Non-zero if the link is up.
+ * @param[in]     cost        Routing metric; at least 1.
+ * @param[out]    changes     Changed entries; may be NULL if @p max_changes is 0.
+ * @param[in]     max_changes Capacity of @p changes.
+ * @param[out]    num_changes Number of entries that changed.
+ * @return ::SW_OK, ::SW_ERR if more than @p max_changes entries changed (the
+ *         state and spf->table are still updated; reinstall the whole table),
+ *         or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_net_spf_set_link(sw_net_spf_t *spf,
+                                sw_net_t *net,
+                                uint16_t link,
+                                int up,
+                                uint32_t cost,
+                                sw_net_route_change_t *changes,
+                                size_t max_changes,
+                                size_t *num_changes);
+
+/**
+ * @brief Apply routing-table changes to the routers.
+ *
+ * @param[in,out] net     Network.
+ * @param[in]     changes Changes from sw_net_spf_set_link().
+ * @param[in]     count   Number of changes.
+ * @return ::SW_OK on success, error code otherwise.
+ */
+sw_result_t sw_net_apply_route_changes(sw_net_t *net,
+                                       const sw_net_route_change_t *changes,
+                                       size_t count);
+
+/**
+ * @brief Install one node's row of a route table into its router.
+ *
+ * Addresses with ::SW_NET_NO_ROUTE are removed from the routing table.
+ *
+ * @param[in,out] net  Network.
+ * @param[in]     node Node.
+ * @param[in]     row  ::SW_ROUTE_TABLE_SIZE output ports.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_net_install_node_routes(sw_net_t *net, uint16_t node, const uint8_t *row);
+
+/**
+ * @brief Install a route table into every router.
+ *
+ * @param[in,out] net   Network.
+ * @param[in]     table Table from sw_net_compute_routes().
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_net_install_routes(sw_net_t *net, const uint8_t *table);
+
+#endif /* SPACEWIRE_NET_H */
@@ -0,0 +1,143 @@
+/**
+ * @file spacewire_psim.h
+ * @brief Conservative parallel discrete-event simulation of large networks.
+ *
+ * The nodes of a network are split into partitions, each simulated by its own
+ * ::sw_sim_t with its own event queue, typically one partition per core.
+ * Partitions advance together in windows: every window starts at the
+ * earliest pending event anywhere and is as long as the lookahead — the
+ * smallest latency of a link between two partitions. An event processed in
+ * a window can only affect another partition through a packet crossing such
+ * a link, which arrives after the window ends, so within a window partitions
+ * never wait for each other. Events for other partitions travel through
+ * single-producer single-consumer lock-free queues, one per ordered pair of
+ * partitions, and are merged into the receiver's queue.
+ *
+ * Node state is only ever touched by the node's own partition and every
+ * event has a unique key (time, node, scheduling node, sequence number), so
+ * each node sees the same events in the same order as under the sequential
+ * engine: results are identical, whatever the partitioning or the number of
+ * threads, provided no event queue overflows.
+ *
+ * A run is prepared with the sequential API — sw_sim_init(), traffic, link
+ * events and installs — and then split with sw_psim_init(). The engine owns
+ * no threads: each application thread calls sw_psim_run() for its own
+ * partition. sw_psim_run_serial() runs all partitions on the calling thread.
+ */
+
+#ifndef SPACEWIRE_PSIM_H
+#define SPACEWIRE_PSIM_H
+
+#include "spacewire_sim.h"
+
+/** @brief Most partitions of a parallel simulation. */
+#define SW_PSIM_MAX_PARTS 64u
+
+/** @brief Assumed cache-line size, used to keep queue indices apart. */
+#define SW_PSIM_CACHE_LINE 64u
+
+/**
+ * @brief Event queue from one partition to another.
+ *
+ * @note `tail` is written by the producer only and `head` by the consumer
+ *       only; each sits on its own cache line.
+ */
+typedef struct
+{
+    uint32_t tail;                                       /**< Next slot to fill. */
+    uint8_t pad0[SW_PSIM_CACHE_LINE - sizeof(uint32_t)]; /**< Keeps @ref head apart. */
+    uint32_t head;                                       /**< Next slot to drain. */
+    uint8_t pad1[SW_PSIM_CACHE_LINE - sizeof(uint32_t)]; /**< Keeps @ref slots apart. */
+    sw_sim_event_t *slots;                               /**< Slot storage. */
+    uint32_t mask;                                       /**< Slot count - 1. */
+} sw_psim_queue_t;
+
+/**
+ * @brief A parallel simulation over caller-owned storage.
+ */
+typedef struct
+{
+    sw_sim_t *parts;                       /**< One simulator per partition. */
+    sw_psim_queue_t *queues;               /**< num_parts x num_parts queues, [from][to]. */
+    const uint16_t *owner;                 /**< Partition of each node. */
+    uint16_t num_parts;                    /**< Number of partitions. */
+    uint8_t serial;                        /**< 1 while run by sw_psim_run_serial(). */
+    uint64_t lookahead;                    /**< Window length in ns. */
+    uint64_t windows;                      /**< Windows completed. */
+    uint32_t arrived;                      /**< Barrier: partitions arrived. */
+    uint32_t sense;                        /**< Barrier: current phase. */
+    uint64_t next_time[SW_PSIM_MAX_PARTS]; /**< Earliest pending event of each partition. */
+} sw_psim_t;
+
+/**
+ * @brief Assign nodes to partitions in contiguous index blocks.
+ *
+ * Suits networks numbered along their geometry (e.g. a mesh row by row);
+ * any other assignment minimising cut links with long latency works too.
+ *
+ * @param[in]  net       Network.
+ * @param[in]  num_parts Number of partitions; non-zero.
+ * @param[out] owner     Partition of each of net->num_nodes nodes.
+ */
+void sw_psim_partition_blocks(const sw_net_t *net, uint16_t num_parts, uint16_t *owner);
+
+/**
+ * @brief Split a prepared sequential simulation into partitions.
+ *
+ * The partitions share @p sim's network, node states and route tables; its
+ * pending events move to their partitions, leaving @p sim empty. Schedule
+ * everything (traffic, link events, installs) before the split.
+ *
+ * @param[out]    psim            Parallel simulation to initialise.
+ * @param[in,out] sim             Prepared simulator.
+ * @param[out]    parts           num_parts simulators.
+ * @param[in]     num_parts       Number of partitions, 1..::SW_PSIM_MAX_PARTS.
+ * @param[in]     owner           Partition of each node; must outlive @p psim.
+ * @param[in]     events          num_parts * events_per_part event slots.
+ * @param[in]     events_per_part Event-queue capacity of each partition.
+ * @param[out]    queues          num_parts * num_parts queues.
+ * @param[in]     slots           num_parts * num_parts * queue_len slots.
+ * @param[in]     queue_len       Capacity of each queue; a power of two.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM (including a link with zero latency
+ *         between two partitions, which leaves no lookahead).
+ */
+sw_result_t sw_psim_init(sw_psim_t *psim,
+                         sw_sim_t *sim,
+                         sw_sim_t *parts,
+                         uint16_t num_parts,
+                         const uint16_t *owner,
+                         sw_sim_event_t *events,
+                         uint32_t events_per_part,
+                         sw_psim_queue_t *queues,
+                         sw_sim_event_t *slots,
+                         uint32_t queue_len);
+
+/**
+ * @brief Simulate one partition up to @p until.
+ *
+ * Call concurrently, one thread per partition; every call returns once all
+ * partitions have reached @p until. A full outgoing queue is waited on.
+ * Threads spin at the window barriers, so give each its own core: with more
+ * threads than cores a window costs a scheduler time slice.
+ *
+ * @param[in,out] psim  Parallel simulation.
+ * @param[in]     part  Partition run by the calling thread.
+ * @param[in]     until End time in ns.
+ * @return Events processed by this partition.
+ */
+uint64_t sw_psim_run(sw_psim_t *psim, uint16_t part, uint64_t until);
+
+/**
+ * @brief Simulate every partition up to @p until on the calling thread.
+ *
+ * Same windows and results as sw_psim_run(). Events that find their
+ * outgoing queue full are dropped (and counted in the sender's overflows),
+ * so size the queues for one window's traffic.
+ *
+ * @param[in,out] psim  Parallel simulation.
+ * @param[in]     until End time in ns.
+ * @return Events processed.
+ */
+uint64_t sw_psim_run_serial(sw_psim_t *psim, uint64_t until);
+
+#endif /* SPACEWIRE_PSIM_H */
@@ -0,0 +1,206 @@
+/**
+ * @file spacewire_pubsub.h
+ * @brief Zero-copy publish/subscribe of decoded CCSDS PTP packets.
+ *
+ * One publisher receives SpaceWire packets into a shared buffer arena, runs
+ * sw_packet_decode() on them in place and publishes a descriptor per delivered
+ * packet. Any number of subscribers, in the same or in other processes, read
+ * the decoded packets straight out of the arena through their own cursors.
+ *
+ * The channel lives entirely in a caller-supplied memory region, typically a
+ * shared-memory mapping; the library performs no allocation and no system
+ * calls. Everything inside the region is addressed by offset, so each process
+ * may map it at a different address.
+ *
+ * The publisher never waits for subscribers. Each slot is protected by a
+ * sequence stamp (a seqlock): a subscriber that falls more than a ring's worth
+ * behind skips ahead and counts the lost packets, and a view that is
+ * overwritten while being read is reported by sw_pubsub_release().
+ */
+
+#ifndef SPACEWIRE_PUBSUB_H
+#define SPACEWIRE_PUBSUB_H
+
+#include "spacewire_packet.h"
+
+/** @brief Magic value at the start of a formatted channel region ("SWPS"). */
+#define SW_PUBSUB_MAGIC 0x53575053u
+
+/** @brief Alignment of the channel header and of every slot, in octets. */
+#define SW_PUBSUB_ALIGN 64u
+
+/**
+ * @brief Channel header at the start of the shared region.
+ *
+ * @note `head` and the slot stamps are accessed atomically; the remaining
+ *       fields are written once by sw_pubsub_create().
+ */
+typedef struct
+{
+    uint32_t magic;      /**< ::SW_PUBSUB_MAGIC once formatted. */
+    uint32_t slot_count; /**< Number of slots; a power of two. */
+    uint32_t slot_size;  /**< Data capacity of each slot in octets. */
+    uint32_t stride;     /**< Distance between consecutive slots in octets. */
+    uint32_t head;       /**< Sequence number of the next packet to publish. */
+    uint32_t discarded;  /**< Received packets that sw_packet_decode() discarded. */
+} sw_pubsub_header_t;
+
+/**
+ * @brief Per-slot descriptor, stored in the region ahead of the slot data.
+ */
+typedef struct
+{
+    uint32_t stamp;       /**< 2n+1 while packet n is written, 2n+2 once published. */
+    uint32_t len;         /**< Received packet length in octets. */
+    uint32_t data_off;    /**< Offset of the CCSDS data field from the slot data. */
+    uint8_t logical_addr; /**< Decoded Target Logical Address. */
+    uint8_t user_app;     /**< Decoded User Application value. */
+    sp_packet_t packet;   /**< Decoded CCSDS packet; `data` is process-local, see data_off. */
+} sw_pubsub_desc_t;
+
+/**
+ * @brief Process-local handle onto a channel region.
+ */
+typedef struct
+{
+    sw_pubsub_header_t *hdr; /**< Channel header in the shared region. */
+    uint8_t *slots;          /**< First slot in this process's mapping. */
+    uint32_t mask;           /**< slot_count - 1. */
+} sw_pubsub_t;
+
+/**
+ * @brief A subscriber's private cursor.
+ */
+typedef struct
+{
+    const sw_pubsub_t *ch; /**< Channel read from. */
+    uint32_t next;         /**< Sequence number of the next packet to read. */
+    uint32_t held;         /**< Non-zero while a view returned by peek is held. */
+    uint32_t received;     /**< Packets read and successfully released. */
+    uint32_t dropped;      /**< Packets overwritten before they could be read. */
+} sw_pubsub_sub_t;
+
+/**
+ * @brief A decoded packet viewed in place in the arena.
+ */
+typedef struct
+{
+    uint32_t seq;         /**< Publication sequence number. */
+    const uint8_t *raw;   /**< Received packet (starts at the Target Logical Address). */
+    uint32_t raw_len;     /**< Received packet length in octets. */
+    sw_packet_frame_t pf; /**< Decoded frame; `pf.packet.data` points into the arena. */
+} sw_pubsub_msg_t;
+
+/**
+ * @brief Region size needed for a channel.
+ *
+ * @param[in] slot_count Number of slots; must be a power of two.
+ * @param[in] slot_size  Largest packet to carry, in octets.
+ * @return Region size in octets, or 0 if the parameters are invalid.
+ */
+size_t sw_pubsub_region_size(uint32_t slot_count, uint32_t slot_size);
+
+/**
+ * @brief Format a region as an empty channel (publisher side).
+ *
+ * @param[out] ch         Handle to initialise.
+ * @param[in]  mem        Region, aligned to ::SW_PUBSUB_ALIGN.
+ * @param[in]  mem_len    Region size in octets.
+ * @param[in]  slot_count Number of slots; must be a power of two.
+ * @param[in]  slot_size  Largest packet to carry, in octets.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_pubsub_create(sw_pubsub_t *ch,
+                             void *mem,
+                             size_t mem_len,
+                             uint32_t slot_count,
+                             uint32_t slot_size);
+
+/**
+ * @brief Attach to a region already formatted by sw_pubsub_create().
+ *
+ * @param[out] ch      Handle to initialise.
+ * @param[in]  mem     This process's mapping of the region.
+ * @param[in]  mem_len Mapping size in octets.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM if the region is not a valid
+ *         channel or is shorter than its header describes.
+ */
+sw_result_t sw_pubsub_attach(sw_pubsub_t *ch, void *mem, size_t mem_len);
+
+/**
+ * @brief Reserve the next slot so a packet can be received straight into it.
+ *
+ * Invalidates the packet previously held by the slot. Follow with
+ * sw_pubsub_commit().
+ *
+ * @param[in,out] ch       Channel (publisher).
+ * @param[out]    capacity Slot capacity in octets; may be NULL.
+ * @return Slot data area, or NULL if @p ch is NULL.
+ */
+uint8_t *sw_pubsub_reserve(sw_pubsub_t *ch, size_t *capacity);
+
+/**
+ * @brief Decode the packet received into the reserved slot and publish it.
+ *
+ * Runs sw_packet_decode() in place. A delivered packet is published; a
+ * discarded one is counted in the header and the slot is reused by the next
+ * reservation.
+ *
+ * @param[in,out] ch     Channel (publisher).
+ * @param[in]     len    Octets received into the slot.
+ * @param[in]     end    End-of-packet marker reported by the link layer.
+ * @param[out]    status Receive status from sw_packet_decode(); may be NULL.
+ * @return ::SW_OK if published, ::SW_ERR if discarded, ::SW_INVALID_PARAM if
+ *         @p len exceeds the slot.
+ */
+sw_result_t sw_pubsub_commit(sw_pubsub_t *ch,
+                             size_t len,
+                             sw_end_marker_t end,
+                             sw_ptp_status_t *status);
+
+/**
+ * @brief Copy a received packet into the arena, decode it and publish it.
+ *
+ * Convenience wrapper around sw_pubsub_reserve() and sw_pubsub_commit() for
+ * drivers that cannot receive into the arena directly.
+ *
+ * @return As sw_pubsub_commit().
+ */
+sw_result_t sw_pubsub_publish(sw_pubsub_t *ch,
+                              const uint8_t *buf,
+                              size_t len,
+                              sw_end_marker_t end,
+                              sw_ptp_status_t *status);
+
+/**
+ * @brief Start a subscriber at the channel's current head (new packets only).
+ *
+ * @param[out] sub Subscriber cursor. No-op if NULL.
+ * @param[in]  ch  Channel to read.
+ */
+void sw_pubsub_sub_init(sw_pubsub_sub_t *sub, const sw_pubsub_t *ch);
+
+/**
+ * @brief View the next packet without copying it.
+ *
+ * If the subscriber has been lapped by the publisher it first skips to the
+ * oldest packet still held and adds the skipped packets to `dropped`. The
+ * view stays in place until sw_pubsub_release().
+ *
+ * @param[in,out] sub Subscriber cursor.
+ * @param[out]    msg View of the packet.
+ * @return ::SW_OK if a packet is available, ::SW_ERR if none is.
+ */
+sw_result_t sw_pubsub_peek(sw_pubsub_sub_t *sub, sw_pubsub_msg_t *msg);
+
+/**
+ * @brief Finish with the view returned by sw_pubsub_peek() and advance.
+ *
+ * @param[in,out] sub Subscriber cursor.
+ * @return ::SW_OK if the view was stable while held, or ::SW_ERR if the
+ *         publisher overwrote it meanwhile — anything derived from it must then
+ *         be dropped (it is counted in `dropped`).
+ */
+sw_result_t sw_pubsub_release(sw_pubsub_sub_t *sub);
+
+#endif /* SPACEWIRE_PUBSUB_H */
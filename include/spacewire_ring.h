@@ -0,0 +1,192 @@
+/**
+ * @file spacewire_ring.h
+ * @brief Single-producer single-consumer rings of packet descriptors.
+ *
+ * A ring hands packets from one thread to another by descriptor: the octets
+ * stay in the producer's buffer and only the descriptor (pointer, length,
+ * port, end marker, timestamp) is copied. One thread pushes and one thread
+ * pops; neither takes a lock or executes a read-modify-write.
+ *
+ * The producer and consumer indices sit on separate cache lines, and each
+ * side keeps a private copy of the other's index, refreshed only when the
+ * ring looks full (producer) or empty (consumer). In steady state a burst
+ * therefore touches the shared index lines once, not once per packet.
+ *
+ * A descriptor either points at the packet in an application buffer or, for
+ * packets of up to ::SW_DESC_INLINE_MAX octets, carries the octets itself.
+ * An inline packet needs no buffer of its own, and the consumer finds it on
+ * the descriptor's cache line instead of following a pointer. Rings, the
+ * transmit queues (spacewire_txq.h) and the SpaceFibre VC queues copy either
+ * kind alike; read the octets with sw_desc_data() and decode with
+ * sw_desc_decode().
+ */
+
+#ifndef SPACEWIRE_RING_H
+#define SPACEWIRE_RING_H
+
+#include "spacewire_packet.h"
+
+#include <string.h>
+
+/** @brief Assumed cache-line size, used to keep the two sides apart. */
+#define SW_RING_CACHE_LINE 64u
+
+/**
+ * @brief Largest packet stored inline in a descriptor.
+ *
+ * The default makes a descriptor one 64-octet cache line on 64-bit targets;
+ * 104 makes it two. Library and application must be built with the same
+ * value.
+ */
+#ifndef SW_DESC_INLINE_MAX
+#    define SW_DESC_INLINE_MAX 40u
+#endif
+
+/**
+ * @brief A packet descriptor (24 octets plus ::SW_DESC_INLINE_MAX on 64-bit
+ *        targets).
+ */
+typedef struct
+{
+    uint8_t *data;                   /**< Packet octets in an application buffer; NULL if inline. */
+    uint32_t len;                    /**< Packet length in octets. */
+    uint8_t port;                    /**< Port the packet arrived on or leaves by. */
+    uint8_t end;                     /**< ::sw_end_marker_t reported with the packet. */
+    uint16_t tag;                    /**< Application-defined (e.g. buffer-pool index). */
+    uint64_t timestamp;              /**< Application-defined time, e.g. of reception. */
+    uint8_t inl[SW_DESC_INLINE_MAX]; /**< Packet octets when @ref data is NULL. */
+} sw_desc_t;
+
+/**
+ * @brief Whether a descriptor carries its packet inline.
+ */
+static inline int sw_desc_is_inline(const sw_desc_t *desc)
+{
+    return desc->data == NULL;
+}
+
+/**
+ * @brief The packet octets of a descriptor, inline or external.
+ *
+ * @note For an inline packet the pointer is into @p desc, so it is valid only
+ *       as long as that copy of the descriptor.
+ */
+static inline const uint8_t *sw_desc_data(const sw_desc_t *desc)
+{
+    return desc->data ? desc->data : desc->inl;
+}
+
+/**
+ * @brief Store a packet in a descriptor: inline if it fits, else by pointer.
+ *
+ * The other fields are left as they are.
+ *
+ * @param[out] desc Descriptor.
+ * @param[in]  buf  Packet octets.
+ * @param[in]  len  Packet length in octets.
+ * @return 1 if the octets were copied inline and @p buf may be reused at
+ *         once; 0 if the descriptor points at @p buf, which must then stay
+ *         valid until the packet is consumed.
+ */
+static inline int sw_desc_set_packet(sw_desc_t *desc, uint8_t *buf, uint32_t len)
+{
+    desc->len = len;
+    if (len > SW_DESC_INLINE_MAX)
+    {
+        desc->data = buf;
+        return 0;
+    }
+    desc->data = NULL;
+    memcpy(desc->inl, buf, len);
+    return 1;
+}
+
+/**
+ * @brief sw_packet_decode() of a descriptor's packet, inline or external,
+ *        with its end marker.
+ *
+ * @note The decoded data field of an inline packet points into @p desc.
+ */
+static inline sw_result_t sw_desc_decode(sw_packet_frame_t *pf,
+                                         const sw_desc_t *desc,
+                                         sw_ptp_status_t *status)
+{
+    return sw_packet_decode(pf, sw_desc_data(desc), desc->len, (sw_end_marker_t)desc->end, status);
+}
+
+/**
+ * @brief A ring over caller-owned descriptor slots.
+ *
+ * @note `tail` and `head_cache` belong to the producer, `head` and
+ *       `tail_cache` to the consumer; each pair has its own cache line.
+ */
+typedef struct
+{
+    uint32_t tail;                                            /**< Next slot to fill. */
+    uint32_t head_cache;                                      /**< Producer's copy of @ref head. */
+    uint8_t pad0[SW_RING_CACHE_LINE - 2u * sizeof(uint32_t)]; /**< Separates the sides. */
+    uint32_t head;                                            /**< Next slot to drain. */
+    uint32_t tail_cache;                                      /**< Consumer's copy of @ref tail. */
+    uint8_t pad1[SW_RING_CACHE_LINE - 2u * sizeof(uint32_t)]; /**< Separates @ref slots. */
+    sw_desc_t *slots;                                         /**< Slot storage. */
+    uint32_t mask;                                            /**< Slot count - 1. */
+} sw_ring_t;
+
+/**
+ * @brief Initialise an empty ring.
+ *
+ * @param[out] ring  Ring.
+ * @param[in]  slots Descriptor storage.
+ * @param[in]  count Number of slots; a power of two.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_ring_init(sw_ring_t *ring, sw_desc_t *slots, uint32_t count);
+
+/**
+ * @brief Append descriptors (producer only).
+ *
+ * @param[in,out] ring  Ring.
+ * @param[in]     descs Descriptors, in order.
+ * @param[in]     n     Number of descriptors.
+ * @return Descriptors appended: the first `return` of @p descs; fewer than
+ *         @p n if the ring filled up.
+ */
+uint32_t sw_ring_push_burst(sw_ring_t *ring, const sw_desc_t *descs, uint32_t n);
+
+/**
+ * @brief Remove descriptors (consumer only).
+ *
+ * @param[in,out] ring Ring.
+ * @param[out]    out  Descriptors, oldest first.
+ * @param[in]     max  Capacity of @p out.
+ * @return Descriptors removed; 0 if the ring is empty.
+ */
+uint32_t sw_ring_pop_burst(sw_ring_t *ring, sw_desc_t *out, uint32_t max);
+
+/**
+ * @brief Append one descriptor (producer only).
+ * @return ::SW_OK, or ::SW_ERR if the ring is full.
+ */
+static inline sw_result_t sw_ring_push(sw_ring_t *ring, const sw_desc_t *desc)
+{
+    return sw_ring_push_burst(ring, desc, 1) == 1 ? SW_OK : SW_ERR;
+}
+
+/**
+ * @brief Remove one descriptor (consumer only).
+ * @return ::SW_OK, or ::SW_ERR if the ring is empty.
+ */
+static inline sw_result_t sw_ring_pop(sw_ring_t *ring, sw_desc_t *desc)
+{
+    return sw_ring_pop_burst(ring, desc, 1) == 1 ? SW_OK : SW_ERR;
+}
+
+/**
+ * @brief Descriptors in the ring; exact only when both sides are idle.
+ *
+ * @param[in] ring Ring.
+ * @return Descriptors queued.
+ */
+uint32_t sw_ring_count(const sw_ring_t *ring);
+
+#endif /* SPACEWIRE_RING_H */
@@ -0,0 +1,140 @@
+/**
+ * @file spacewire_rss.h
+ * @brief Flow-hash receive steering across decode worker threads.
+ *
+ * One receive thread cannot decode at the aggregate rate of several links,
+ * so the steering stage spreads received packets over N worker threads,
+ * each fed by its own SPSC descriptor ring (spacewire_ring.h) and calling
+ * sw_packet_decode() itself. Like receive-side scaling on a NIC:
+ *
+ * - Flow key: the logical address, user application (VC) and APID, read
+ *   from their fixed offsets in the received packet without decoding it, in
+ *   the ::SW_TOPK_KEY layout (spacewire_topk.h); a packet that is not CCSDS
+ *   PTP is keyed by its logical address alone.
+ * - Indirection: a seeded multiplicative hash of the key selects one of
+ *   ::SW_RSS_BUCKETS buckets, and the bucket's entry in the indirection
+ *   table selects the worker. All packets of a flow therefore go through
+ *   the same ring and stay in order.
+ * - Rebalancing: each bucket counts the octets steered through it. With
+ *   skewed traffic sw_rss_rebalance() moves buckets from the busiest
+ *   workers to the idlest ones. A bucket that moves keeps its old worker
+ *   until that worker has popped the bucket's last packet from its ring, so
+ *   a flow is never in two rings at once and its order survives the move.
+ *
+ * The steering thread is the producer of every worker ring; workers pop
+ * their own ring. A steering context has a single writer.
+ */
+
+#ifndef SPACEWIRE_RSS_H
+#define SPACEWIRE_RSS_H
+
+#include "spacewire_ring.h"
+#include "spacewire_topk.h"
+
+/** @brief Indirection table entries. */
+#define SW_RSS_BUCKETS 256u
+
+/** @brief Most worker threads. */
+#define SW_RSS_MAX_WORKERS 64u
+
+/** @brief Descriptors steered per internal batch. */
+#define SW_RSS_BATCH 32u
+
+/**
+ * @brief An indirection-table entry.
+ */
+typedef struct
+{
+    uint8_t worker; /**< Worker whose ring receives the bucket's packets. */
+    uint8_t target; /**< Worker it moves to; equal to @ref worker when settled. */
+    uint32_t last;  /**< Position in the worker's ring just after its last packet. */
+    uint64_t load;  /**< Octets steered, halved at each rebalance. */
+} sw_rss_bucket_t;
+
+/**
+ * @brief Steering context.
+ */
+typedef struct
+{
+    sw_ring_t *rings;                        /**< One ring per worker. */
+    uint8_t num_workers;                     /**< Number of workers. */
+    uint32_t seed;                           /**< Hash seed. */
+    sw_rss_bucket_t buckets[SW_RSS_BUCKETS]; /**< Indirection table. */
+    uint64_t packets[SW_RSS_MAX_WORKERS];    /**< Packets steered, by worker. */
+    uint64_t moves;                          /**< Buckets moved to another worker. */
+} sw_rss_t;
+
+/**
+ * @brief Initialise steering over @p num_workers rings.
+ *
+ * The buckets are dealt to the workers in turn.
+ *
+ * @param[out] rss         Steering context.
+ * @param[in]  rings       Worker rings, already initialised.
+ * @param[in]  num_workers 1..::SW_RSS_MAX_WORKERS.
+ * @param[in]  seed        Hash seed.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_rss_init(sw_rss_t *rss, sw_ring_t *rings, uint8_t num_workers, uint32_t seed);
+
+/**
+ * @brief Flow key of a received packet (starting at its logical address).
+ *
+ * @param[in] pkt Packet.
+ * @param[in] len Length in octets.
+ * @return ::SW_TOPK_KEY of the logical address, user application and APID;
+ *         VC 0 and ::SW_TOPK_NO_APID if it is not a CCSDS PTP packet, and 0
+ *         if it is empty.
+ */
+uint32_t sw_rss_flow_key(const uint8_t *pkt, size_t len);
+
+/**
+ * @brief Bucket of a flow key.
+ *
+ * @param[in] rss Steering context.
+ * @param[in] key Flow key.
+ * @return Bucket index.
+ */
+static inline uint32_t sw_rss_bucket(const sw_rss_t *rss, uint32_t key)
+{
+    return ((key ^ rss->seed) * 0x9E3779B1u) >> 24;
+}
+
+/**
+ * @brief Steer received packets to their workers' rings.
+ *
+ * Descriptors are taken in order while their rings have room, and pushed in
+ * one burst per worker and batch.
+ *
+ * @param[in,out] rss   Steering context.
+ * @param[in]     descs Descriptors of received packets.
+ * @param[in]     n     Number of descriptors.
+ * @return Descriptors steered: the first `return` of @p descs; fewer than
+ *         @p n if the next one's ring is full.
+ */
+uint32_t sw_rss_steer_burst(sw_rss_t *rss, const sw_desc_t *descs, uint32_t n);
+
+/**
+ * @brief Move a bucket to another worker, once its packets have drained.
+ *
+ * @param[in,out] rss    Steering context.
+ * @param[in]     bucket Bucket index.
+ * @param[in]     worker New worker.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_rss_move(sw_rss_t *rss, uint32_t bucket, uint8_t worker);
+
+/**
+ * @brief Even out the load of the workers.
+ *
+ * While it narrows the gap, the largest bucket of the busiest worker that is
+ * smaller than the gap between the busiest and the idlest worker is moved to
+ * the idlest. The bucket loads are then halved, so older traffic weighs less
+ * at the next call.
+ *
+ * @param[in,out] rss Steering context.
+ * @return Buckets moved.
+ */
+uint32_t sw_rss_rebalance(sw_rss_t *rss);
+
+#endif /* SPACEWIRE_RSS_H */
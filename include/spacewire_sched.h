@@ -0,0 +1,119 @@
+/**
+ * @file spacewire_sched.h
+ * @brief Work-stealing scheduler for port processing.
+ *
+ * Each input port is one task. Running a task performs one burst of that
+ * port's work — receive, route, encode or decode, transmit — through a
+ * caller-supplied poll function. Tasks live in per-worker run queues
+ * (Chase-Lev deques); a worker that finds its own ports idle steals a task
+ * from another worker, so heavy ports that happen to share a worker are
+ * spread across the pool.
+ *
+ * A task is held by exactly one queue or one running worker at a time, so
+ * bursts of the same port never overlap and per-port packet order is kept.
+ *
+ * The scheduler owns no threads: the application runs sw_sched_run_once()
+ * in a loop on each of its worker threads or tasks.
+ */
+
+#ifndef SPACEWIRE_SCHED_H
+#define SPACEWIRE_SCHED_H
+
+#include "spacewire.h"
+
+/**
+ * @brief Capacity of each worker's run queue, and so the most tasks a
+ *        scheduler can hold; a power of two.
+ *
+ * Override with `-DSW_SCHED_MAX_TASKS=n`.
+ */
+#ifndef SW_SCHED_MAX_TASKS
+#    define SW_SCHED_MAX_TASKS 64u
+#endif
+
+/** @brief Scheduler flag: never steal, each task stays on its home worker. */
+#define SW_SCHED_STATIC 0x01u
+
+/**
+ * @brief Process one burst of a task's (input port's) work.
+ *
+ * @param[in] ctx    Context passed to sw_sched_init().
+ * @param[in] task   Task (input port) index, 0..num_tasks-1.
+ * @param[in] worker Index of the worker running the burst.
+ * @return Packets processed; 0 marks the port as idle.
+ */
+typedef size_t (*sw_sched_poll_fn)(void *ctx, uint16_t task, unsigned worker);
+
+/**
+ * @brief A worker: its run queue and counters.
+ *
+ * @note `top` and `bottom` are accessed atomically. The counters are written
+ *       only by the owning worker.
+ */
+typedef struct
+{
+    uint32_t top;                       /**< Next task to take (any worker). */
+    uint32_t bottom;                    /**< Next free slot (owner only). */
+    uint16_t tasks[SW_SCHED_MAX_TASKS]; /**< Run-queue storage. */
+    uint8_t last_idle;                  /**< 1 if the previous burst found no work. */
+    unsigned victim;                    /**< Next worker to try stealing from. */
+    uint32_t busy_polls;                /**< Bursts that processed packets. */
+    uint32_t idle_polls;                /**< Bursts that found the port idle. */
+    uint32_t empty_polls;               /**< Calls that found no task at all. */
+    uint32_t steals;                    /**< Tasks taken from other workers. */
+    uint64_t packets;                   /**< Packets processed. */
+} sw_sched_worker_t;
+
+/**
+ * @brief Scheduler state.
+ */
+typedef struct
+{
+    sw_sched_worker_t *workers; /**< Caller-owned worker array. */
+    unsigned num_workers;       /**< Number of workers. */
+    uint16_t num_tasks;         /**< Number of tasks (input ports). */
+    uint32_t flags;             /**< ::SW_SCHED_STATIC or 0. */
+    sw_sched_poll_fn poll;      /**< Burst function. */
+    void *ctx;                  /**< Context for @ref poll. */
+} sw_sched_t;
+
+/**
+ * @brief Initialise a scheduler.
+ *
+ * Task i starts on worker i mod @p num_workers, the same placement a static
+ * per-port pinning would use.
+ *
+ * @param[out] sched       Scheduler to initialise.
+ * @param[in]  workers     Caller-owned array of @p num_workers workers.
+ * @param[in]  num_workers Number of workers (at least 1).
+ * @param[in]  num_tasks   Number of tasks, 1..::SW_SCHED_MAX_TASKS.
+ * @param[in]  poll        Burst function.
+ * @param[in]  ctx         Context passed to @p poll.
+ * @param[in]  flags       ::SW_SCHED_STATIC or 0.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_sched_init(sw_sched_t *sched,
+                          sw_sched_worker_t *workers,
+                          unsigned num_workers,
+                          uint16_t num_tasks,
+                          sw_sched_poll_fn poll,
+                          void *ctx,
+                          uint32_t flags);
+
+/**
+ * @brief Run one burst on behalf of a worker.
+ *
+ * Takes the oldest task from the worker's own queue, so its ports are served
+ * round-robin. When the previous burst was idle or the queue is empty, it
+ * first tries to steal from the other workers (unless ::SW_SCHED_STATIC).
+ * The task is then returned to this worker's queue.
+ *
+ * Must be called only from the thread that owns @p worker.
+ *
+ * @param[in,out] sched  Scheduler.
+ * @param[in]     worker Index of the calling worker.
+ * @return Packets processed by the burst; 0 if idle or no task was found.
+ */
+size_t sw_sched_run_once(sw_sched_t *sched, unsigned worker);
+
+#endif /* SPACEWIRE_SCHED_H */
@@ -0,0 +1,213 @@
+/**
+ * @file spacewire_sfq.h
+ * @brief Disk-backed store-and-forward queue for an output port or VC.
+ *
+ * While the link behind an output port (or a virtual channel of it) is down,
+ * the forwarding path spills the packets for it into a store-and-forward
+ * queue instead of dropping them or holding them in RAM. When the link comes
+ * back, the queue drains in priority order (0 is the most urgent; FIFO
+ * within a priority) straight from storage, as fast as the link accepts.
+ *
+ * A queue lives in one region, normally a file mapped with
+ * `mmap(MAP_SHARED)` by the application:
+ *
+ *     [ superblock A | superblock B ]            two ::SW_SFQ_META_SLOT pages
+ *     [ record log, used circularly ]            data_size octets
+ *
+ * Records are appended to the log and never modified:
+ *
+ *     [ logical position | length | priority | kind | checksum | packet ]
+ *
+ * Positions are 64-bit and only grow; the octet of position p lies at
+ * p % data_size. The queue state is the append position (head) and, per
+ * priority, the position of the next record to forward; space behind the
+ * oldest record unforwarded at the last commit is free again. RAM use is
+ * this small state: packets stay in the mapping, and the kernel pages them
+ * in and out.
+ *
+ * Crash safety: sw_sfq_commit() writes the state to the older superblock
+ * together with a generation number and a checksum, so one of the two is
+ * always whole. sw_sfq_open() takes the newest valid superblock and then
+ * walks the log past the committed head, keeping every record whose position
+ * stamp and checksum are intact; a torn last record is discarded. Delivery
+ * is at least once: packets forwarded after the last commit are forwarded
+ * again after a crash. For durability, write the data pages back (`msync`)
+ * before a commit and the superblock page after it.
+ *
+ * The queue is in the writing host's byte order.
+ */
+
+#ifndef SPACEWIRE_SFQ_H
+#define SPACEWIRE_SFQ_H
+
+#include "spacewire_packet.h"
+
+#include <stddef.h>
+
+/** @brief Superblock identifier ("SWSQ"). */
+#define SW_SFQ_MAGIC 0x51535753u
+
+/** @brief Queue format version. */
+#define SW_SFQ_VERSION 1u
+
+/** @brief Priority levels; 0 is forwarded first. */
+#define SW_SFQ_PRIORITIES 4u
+
+/** @brief Octets reserved for each superblock, one page. */
+#define SW_SFQ_META_SLOT 4096u
+
+/** @brief Octets ahead of the record log. */
+#define SW_SFQ_META_SIZE (2u * SW_SFQ_META_SLOT)
+
+/** @brief Alignment of records in the log. */
+#define SW_SFQ_ALIGN 8u
+
+/**
+ * @brief Superblock: the committed queue state.
+ */
+typedef struct
+{
+    uint32_t magic;                   /**< ::SW_SFQ_MAGIC. */
+    uint32_t version;                 /**< ::SW_SFQ_VERSION. */
+    uint64_t generation;              /**< Commit number; the newer valid copy wins. */
+    uint64_t data_size;               /**< Octets of the record log. */
+    uint64_t head;                    /**< Append position. */
+    uint64_t tail;                    /**< Oldest unforwarded record. */
+    uint64_t next[SW_SFQ_PRIORITIES]; /**< Next record to forward, per priority. */
+    uint32_t checksum;                /**< Over the superblock, this field as zero. */
+    uint32_t reserved;                /**< 0. */
+} sw_sfq_super_t;
+
+/**
+ * @brief Record header; the packet octets follow.
+ */
+typedef struct
+{
+    uint64_t pos;       /**< Logical position of the record. */
+    uint32_t len;       /**< Packet octets; padding octets for a pad record. */
+    uint8_t priority;   /**< Priority of the packet. */
+    uint8_t kind;       /**< 1 for a packet, 2 for padding up to the log's end. */
+    uint16_t reserved;  /**< 0. */
+    uint32_t checksum;  /**< Over header and packet, this field as zero. */
+    uint32_t reserved2; /**< 0. */
+} sw_sfq_record_t;
+
+/**
+ * @brief Queue state in RAM.
+ */
+typedef struct
+{
+    uint8_t *region;                     /**< Superblocks, then the log. */
+    uint8_t *log;                        /**< Record log. */
+    uint64_t data_size;                  /**< Octets of the record log. */
+    uint64_t generation;                 /**< Generation of the last commit. */
+    uint64_t head;                       /**< Append position. */
+    uint64_t tail;                       /**< Tail of the last commit; the log before it is free. */
+    uint64_t next[SW_SFQ_PRIORITIES];    /**< Next record to forward, per priority. */
+    uint32_t pending[SW_SFQ_PRIORITIES]; /**< Records waiting, per priority. */
+    uint64_t spilled;                    /**< Packets appended. */
+    uint64_t forwarded;                  /**< Packets popped. */
+    uint64_t rejected;                   /**< Packets refused for lack of space. */
+} sw_sfq_t;
+
+/**
+ * @brief Region octets for a record log of @p data_size octets.
+ *
+ * @param[in] data_size Log octets; a multiple of ::SW_SFQ_ALIGN.
+ * @return Region size.
+ */
+size_t sw_sfq_region_size(uint64_t data_size);
+
+/**
+ * @brief Initialise an empty queue in a region, discarding its contents.
+ *
+ * @param[out] q      Queue.
+ * @param[in]  region Region; 8-octet aligned.
+ * @param[in]  size   Octets of @p region; the log takes all but
+ *                    ::SW_SFQ_META_SIZE, rounded down to ::SW_SFQ_ALIGN.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM (also if the log would hold less
+ *         than one page).
+ */
+sw_result_t sw_sfq_format(sw_sfq_t *q, void *region, size_t size);
+
+/**
+ * @brief Reopen the queue in a region, e.g. after a restart or a crash.
+ *
+ * @param[out] q      Queue.
+ * @param[in]  region Region; 8-octet aligned.
+ * @param[in]  size   Octets of @p region.
+ * @return ::SW_OK, ::SW_ERR if neither superblock is valid, or
+ *         ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_sfq_open(sw_sfq_t *q, void *region, size_t size);
+
+/**
+ * @brief Append a packet.
+ *
+ * @param[in,out] q        Queue.
+ * @param[in]     priority 0..SW_SFQ_PRIORITIES-1.
+ * @param[in]     pkt      Packet octets.
+ * @param[in]     len      Packet length, > 0.
+ * @return ::SW_OK, ::SW_ERR if the log is full, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_sfq_push(sw_sfq_t *q, uint8_t priority, const uint8_t *pkt, uint32_t len);
+
+/**
+ * @brief Look at the next packet to forward without removing it.
+ *
+ * @param[in]  q        Queue.
+ * @param[out] pkt      Packet octets, in the region.
+ * @param[out] len      Packet length.
+ * @param[out] priority Its priority; may be NULL.
+ * @return ::SW_OK, ::SW_ERR if the queue is empty, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_sfq_peek(const sw_sfq_t *q, const uint8_t **pkt, uint32_t *len, uint8_t *priority);
+
+/**
+ * @brief Remove the packet sw_sfq_peek() returned.
+ *
+ * @param[in,out] q Queue.
+ * @return ::SW_OK, ::SW_ERR if the queue is empty, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_sfq_pop(sw_sfq_t *q);
+
+/**
+ * @brief Forward function for sw_sfq_drain().
+ *
+ * @return 0 if the link took the packet, non-zero to stop draining (the
+ *         packet stays queued).
+ */
+typedef int (*sw_sfq_send_fn)(void *ctx, uint8_t priority, const uint8_t *pkt, uint32_t len);
+
+/**
+ * @brief Forward up to @p max packets in priority order.
+ *
+ * @param[in,out] q    Queue.
+ * @param[in]     send Forward function.
+ * @param[in]     ctx  Passed to @p send.
+ * @param[in]     max  Packet budget.
+ * @return Packets forwarded and removed.
+ */
+size_t sw_sfq_drain(sw_sfq_t *q, sw_sfq_send_fn send, void *ctx, size_t max);
+
+/**
+ * @brief Persist the queue state in the older superblock.
+ *
+ * @param[in,out] q Queue.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_sfq_commit(sw_sfq_t *q);
+
+/**
+ * @brief Octets of the log in use, from the tail of the last commit to the
+ *        head.
+ *
+ * Records forwarded since the last commit keep their space until the next
+ * one: after a crash, the log is read again from the committed tail.
+ *
+ * @param[in] q Queue.
+ * @return Octets in use.
+ */
+uint64_t sw_sfq_used(const sw_sfq_t *q);
+
+#endif /* SPACEWIRE_SFQ_H */
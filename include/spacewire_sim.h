@@ -0,0 +1,303 @@
+/**
+ * @file spacewire_sim.h
+ * @brief Discrete-event simulation of a SpaceWire network, with link-failure
+ *        trials.
+ *
+ * The simulator moves packets through a ::sw_net_t. Every node forwards with
+ * its own ::sw_router_t, so the routing tables installed in the routers —
+ * including stale ones while a change is being rolled out — decide where
+ * packets go. Events are link failures and repairs, routing-table installs,
+ * traffic generation and packet arrivals.
+ *
+ * Timing model: a packet is stored and forwarded. Sending it through a port
+ * takes 10 bit periods per octet (data character with parity and flag) once
+ * the port is free, and it reaches the next node after the link latency.
+ * Packets on a link when it fails are lost, as are packets routed to a port
+ * whose link is down, packets for an address a router does not know, and
+ * packets that exceed ::SW_SIM_MAX_HOPS (transient routing loops).
+ *
+ * Runs are deterministic: events are ordered by time, then node, then the
+ * node that scheduled them and its sequence number, and each node draws from
+ * its own random stream seeded from the run seed.
+ *
+ * sw_sim_link_failure_trial() runs one Monte-Carlo trial: fail one link under
+ * steady traffic, let the network manager recompute routes and reinstall the
+ * tables that changed after a detection delay and a random per-router
+ * install delay, and measure the packets lost and the time to convergence.
+ * Trials are independent given their seed, so a pool of threads, each with
+ * its own copy of the network (sw_net_clone()) and simulator, can run them in
+ * parallel (see bench/bench_link_failure.c).
+ */
+
+#ifndef SPACEWIRE_SIM_H
+#define SPACEWIRE_SIM_H
+
+#include "spacewire_net.h"
+
+/** @brief Most address octets carried by a simulated packet. */
+#define SW_SIM_MAX_HEADER 8u
+
+/** @brief Routing tables a simulator can reference for installs. */
+#define SW_SIM_MAX_TABLES 8u
+
+/**
+ * @brief Routers a packet may cross before it is dropped as looping.
+ *
+ * Override with `-DSW_SIM_MAX_HOPS=n`.
+ */
+#ifndef SW_SIM_MAX_HOPS
+#    define SW_SIM_MAX_HOPS 64u
+#endif
+
+/**
+ * @brief Event types.
+ */
+typedef enum
+{
+    SW_SIM_EV_GENERATE = 0,  /**< Traffic source at the node emits a packet. */
+    SW_SIM_EV_ARRIVE = 1,    /**< Packet arrives at the node on a port. */
+    SW_SIM_EV_LINK_DOWN = 2, /**< The node's port loses its link. */
+    SW_SIM_EV_LINK_UP = 3,   /**< The node's port regains its link. */
+    SW_SIM_EV_INSTALL = 4    /**< The node's router takes a new routing table. */
+} sw_sim_event_type_t;
+
+/**
+ * @brief A scheduled event; packets travel inside their arrival events.
+ */
+typedef struct
+{
+    uint64_t time;                  /**< Simulated time in ns. */
+    uint64_t created;               /**< Packet: generation time in ns. */
+    uint32_t seq;                   /**< Sequence number of the scheduling node. */
+    uint32_t epoch;                 /**< Arrival: link epoch at departure. */
+    uint16_t node;                  /**< Node the event happens at. */
+    uint16_t origin;                /**< Scheduling node, ::SW_NET_NONE if external. */
+    uint16_t len;                   /**< Packet: length in octets, header included. */
+    uint16_t arg;                   /**< Install: table index. */
+    uint8_t type;                   /**< ::sw_sim_event_type_t. */
+    uint8_t port;                   /**< Arrival and link events: port of the node. */
+    uint8_t hops;                   /**< Packet: routers crossed so far. */
+    uint8_t hdr_len;                /**< Packet: address octets left in @ref hdr. */
+    uint8_t hdr[SW_SIM_MAX_HEADER]; /**< Packet: address octets, leading first. */
+} sw_sim_event_t;
+
+/**
+ * @brief Traffic and loss counters (per node, or summed over the network).
+ */
+typedef struct
+{
+    uint32_t generated;      /**< Packets generated. */
+    uint32_t delivered;      /**< Packets delivered to their destination. */
+    uint32_t lost_no_route;  /**< Discarded by a router (unknown address). */
+    uint32_t lost_link;      /**< Sent to a dead port, or on a link when it failed. */
+    uint32_t lost_hops;      /**< Dropped after ::SW_SIM_MAX_HOPS routers. */
+    uint64_t latency_sum_ns; /**< Sum of delivery latencies. */
+    uint64_t latency_max_ns; /**< Largest delivery latency. */
+    uint64_t last_loss_ns;   /**< Time of the most recent loss. */
+} sw_sim_stats_t;
+
+/**
+ * @brief Per-node simulation state.
+ */
+typedef struct
+{
+    uint64_t busy_until[SW_NUM_PORTS]; /**< Time each output port becomes free. */
+    uint32_t epoch[SW_NUM_PORTS];      /**< Link failures seen on each port. */
+    uint64_t rng;                      /**< Random stream state. */
+    uint32_t next_seq;                 /**< Sequence number of the next event scheduled. */
+    uint32_t gen_interval_ns;          /**< Mean packet interval, 0 if not a source. */
+    uint16_t gen_len;                  /**< Generated packet length in octets. */
+    sw_sim_stats_t stats;              /**< Counters. */
+} sw_sim_node_t;
+
+struct sw_sim;
+
+/**
+ * @brief Sink for events addressed to a node another partition simulates.
+ *
+ * @param[in] sim Scheduling simulator.
+ * @param[in] ctx Context stored with the hook.
+ * @param[in] ev  Event, already numbered.
+ * @return ::SW_OK, or ::SW_ERR if the event was dropped.
+ */
+typedef sw_result_t (*sw_sim_remote_fn)(struct sw_sim *sim, void *ctx, const sw_sim_event_t *ev);
+
+/**
+ * @brief A simulator over caller-owned storage.
+ *
+ * A simulator normally runs the whole network. Under the parallel engine
+ * (spacewire_psim.h) it runs one partition: @ref owner maps nodes to
+ * partitions and events for other partitions' nodes go to @ref remote.
+ */
+typedef struct sw_sim
+{
+    sw_net_t *net;                            /**< Simulated network. */
+    sw_sim_node_t *nodes;                     /**< One state per network node. */
+    sw_sim_event_t *events;                   /**< Pending events (binary heap). */
+    uint32_t num_events;                      /**< Events pending. */
+    uint32_t max_events;                      /**< Capacity of @ref events. */
+    uint32_t overflows;                       /**< Events dropped: queue full. */
+    uint32_t seq;                             /**< Sequence of external events. */
+    uint64_t now;                             /**< Current simulated time in ns. */
+    const uint8_t *tables[SW_SIM_MAX_TABLES]; /**< Tables referenced by installs. */
+    uint16_t num_tables;                      /**< Tables registered. */
+    uint16_t num_addrs;                       /**< Addresses traffic is sent to. */
+    uint8_t addrs[SW_ROUTE_TABLE_SIZE];       /**< Logical addresses of the nodes. */
+    const uint16_t *owner;                    /**< Partition of each node, or NULL. */
+    uint16_t partition;                       /**< Partition simulated here. */
+    sw_sim_remote_fn remote;                  /**< Sink for other partitions' events. */
+    void *remote_ctx;                         /**< Context of @ref remote. */
+} sw_sim_t;
+
+/**
+ * @brief Parameters of a link-failure trial.
+ */
+typedef struct
+{
+    uint64_t seed;              /**< Seed of the trial's random choices. */
+    uint16_t link;              /**< Link to fail, or ::SW_NET_NONE for a random one. */
+    uint16_t packet_len;        /**< Octets per generated packet, address included. */
+    uint32_t interval_ns;       /**< Mean packet interval of every addressed node. */
+    uint64_t warmup_ns;         /**< Steady traffic before the failure. */
+    uint64_t duration_ns;       /**< Simulated time after the failure. */
+    uint32_t detect_ns;         /**< Failure detection and route computation delay. */
+    uint32_t install_spread_ns; /**< Routers install uniformly within this window. */
+} sw_sim_failure_cfg_t;
+
+/**
+ * @brief Outcome of a link-failure trial.
+ */
+typedef struct
+{
+    uint16_t link;            /**< Link that failed. */
+    uint16_t routers_updated; /**< Routers whose tables changed. */
+    uint32_t unreachable;     /**< (Node, address) pairs cut off by the failure. */
+    uint32_t lost;            /**< Packets lost in the whole run. */
+    uint32_t delivered;       /**< Packets delivered in the whole run. */
+    uint64_t convergence_ns;  /**< Failure to the last table install. */
+    uint64_t disruption_ns;   /**< Failure to the last packet loss, 0 if none. */
+    sw_sim_stats_t stats;     /**< Network-wide counters. */
+} sw_sim_failure_result_t;
+
+/**
+ * @brief Initialise a simulator at time 0.
+ *
+ * Ports whose link is up start connected, the others in error; routers keep
+ * their routing tables. No node generates traffic until sw_sim_set_traffic().
+ *
+ * @param[out] sim        Simulator to initialise.
+ * @param[in]  net        Network; must outlive the simulator.
+ * @param[in]  nodes      State storage for net->num_nodes nodes.
+ * @param[in]  events     Event storage. Size it for the packets in flight
+ *                        plus one event per source and per pending install
+ *                        or link event.
+ * @param[in]  max_events Capacity of @p events.
+ * @param[in]  seed       Seed of the per-node random streams.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_sim_init(sw_sim_t *sim,
+                        sw_net_t *net,
+                        sw_sim_node_t *nodes,
+                        sw_sim_event_t *events,
+                        uint32_t max_events,
+                        uint64_t seed);
+
+/**
+ * @brief Make a node a traffic source.
+ *
+ * The node sends packets of @p len octets to logical addresses of other nodes
+ * chosen uniformly at random, at intervals uniform in [interval/2, 3*interval/2).
+ *
+ * @param[in,out] sim         Simulator.
+ * @param[in]     node        Source node.
+ * @param[in]     interval_ns Mean packet interval; non-zero.
+ * @param[in]     len         Packet length in octets, address included; non-zero.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_sim_set_traffic(sw_sim_t *sim, uint16_t node, uint32_t interval_ns, uint16_t len);
+
+/**
+ * @brief Schedule a link failure or repair at both ends.
+ *
+ * @param[in,out] sim  Simulator.
+ * @param[in]     link Link.
+ * @param[in]     time Time of the change in ns.
+ * @param[in]     up   0 for a failure, non-zero for a repair.
+ * @return ::SW_OK, ::SW_ERR if the event queue is full, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_sim_schedule_link(sw_sim_t *sim, uint16_t link, uint64_t time, int up);
+
+/**
+ * @brief Register a route table for later installs.
+ *
+ * @param[in,out] sim   Simulator.
+ * @param[in]     table Table from sw_net_compute_routes(); must stay valid.
+ * @param[out]    index Index to pass to sw_sim_schedule_install().
+ * @return ::SW_OK, or ::SW_INVALID_PARAM if the table list is full.
+ */
+sw_result_t sw_sim_add_table(sw_sim_t *sim, const uint8_t *table, uint16_t *index);
+
+/**
+ * @brief Schedule the install of a node's row of a registered table.
+ *
+ * @param[in,out] sim   Simulator.
+ * @param[in]     node  Node whose router is updated.
+ * @param[in]     time  Install time in ns.
+ * @param[in]     table Index from sw_sim_add_table().
+ * @return ::SW_OK, ::SW_ERR if the event queue is full, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_sim_schedule_install(sw_sim_t *sim, uint16_t node, uint64_t time, uint16_t table);
+
+/**
+ * @brief Queue an event numbered elsewhere, e.g. one received from another
+ *        partition.
+ *
+ * @param[in,out] sim Simulator.
+ * @param[in]     ev  Event; its origin and sequence number are kept.
+ * @return ::SW_OK, ::SW_ERR if the event queue is full, or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_sim_insert(sw_sim_t *sim, const sw_sim_event_t *ev);
+
+/**
+ * @brief Process every event before @p until and advance the clock to it.
+ *
+ * @param[in,out] sim   Simulator.
+ * @param[in]     until End time in ns.
+ * @return Events processed.
+ */
+uint64_t sw_sim_run(sw_sim_t *sim, uint64_t until);
+
+/**
+ * @brief Sum the per-node counters.
+ *
+ * @param[in]  sim   Simulator.
+ * @param[out] stats Network-wide counters.
+ */
+void sw_sim_get_stats(const sw_sim_t *sim, sw_sim_stats_t *stats);
+
+/**
+ * @brief Run one link-failure trial.
+ *
+ * Installs shortest-path routes for the intact network, re-initialises the
+ * simulator with every addressed node as a traffic source, fails the link at
+ * cfg->warmup_ns and installs the recomputed tables of the routers whose
+ * routes changed at failure + detect_ns + a uniform delay in
+ * [0, install_spread_ns]. The network's links are left as they were.
+ *
+ * @param[in,out] sim    Simulator set up by sw_sim_init(); its network,
+ *                       storage and capacity are reused.
+ * @param[in]     cfg    Trial parameters.
+ * @param[in]     work   Route-computation scratch space.
+ * @param[out]    tables Two route tables: 2 * num_nodes * ::SW_ROUTE_TABLE_SIZE
+ *                       octets.
+ * @param[out]    result Outcome.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise (including a
+ *         network without a link that is up).
+ */
+sw_result_t sw_sim_link_failure_trial(sw_sim_t *sim,
+                                      const sw_sim_failure_cfg_t *cfg,
+                                      const sw_net_work_t *work,
+                                      uint8_t *tables,
+                                      sw_sim_failure_result_t *result);
+
+#endif /* SPACEWIRE_SIM_H */
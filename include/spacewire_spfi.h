@@ -0,0 +1,291 @@
+/**
+ * @file spacewire_spfi.h
+ * @brief Software model of the SpaceFibre virtual-channel layer
+ *        (ECSS-E-ST-50-11C) carrying SpaceWire packets.
+ *
+ * SpaceFibre moves the same packets as SpaceWire — here the CCSDS PTP packets
+ * built by sw_packet_encode(), addresses included — over virtual channels
+ * (VCs) that share one lane. This module models the parts of its data-link
+ * layer that decide what goes on the lane, so that the packet and network
+ * layers can be reused and tested on top of it without hardware:
+ *
+ * - **Virtual channels.** Each transmit VC takes packets from its own
+ *   descriptor ring (spacewire_ring.h); ::sw_virtual_channel_t values, i.e.
+ *   User Application fields, are mapped to VCs with sw_spfi_tx_map().
+ * - **Data frames.** Packets are packed into frames of up to 64 four-symbol
+ *   words. Each packet ends with an EOP or EEP symbol, padded with FILL to a
+ *   word boundary; a packet that does not fit continues in the VC's next
+ *   frame. A frame carries its VC, a sequence number and a CRC-16.
+ * - **Flow control.** A VC sends a frame only while it holds credit: one
+ *   flow-control token (FCT), granted by the far end with sw_spfi_tx_fct(),
+ *   per frame of space freed in the VC's receive buffer.
+ * - **Medium access.** Of the VCs with data and credit, the one with the
+ *   highest priority sends the next frame; among equal priorities, the one
+ *   with the most bandwidth credit. While it has packets waiting, a VC earns
+ *   credit in proportion to its reserved share for every word sent on the
+ *   lane and spends it for the words it sends, so saturated VCs of one
+ *   priority share the lane in the ratio of their reservations.
+ *
+ * Symbols are modelled as octets with a K flag, and the control symbols by
+ * model codes (::SW_SPFI_EOP, ::SW_SPFI_EEP, ::SW_SPFI_FILL) rather than
+ * 8B/10B characters. Not modelled: the lane and retry layers (a frame with a
+ * bad CRC is counted and dropped, not retransmitted; a sequence gap is
+ * counted), broadcast frames and scheduled (time-slot) QoS.
+ *
+ * All storage is caller-owned. A transmitter and a receiver each belong to
+ * one thread; the VC rings may be filled from other threads.
+ */
+
+#ifndef SPACEWIRE_SPFI_H
+#define SPACEWIRE_SPFI_H
+
+#include "spacewire_packet.h"
+#include "spacewire_ring.h"
+
+/** @brief Virtual channels per link. */
+#define SW_SPFI_MAX_VC 32u
+
+/** @brief Symbols per word. */
+#define SW_SPFI_WORD 4u
+
+/** @brief Data words per frame, at most. */
+#define SW_SPFI_FRAME_WORDS 64u
+
+/** @brief Data symbols per frame, at most. */
+#define SW_SPFI_FRAME_DATA (SW_SPFI_WORD * SW_SPFI_FRAME_WORDS)
+
+/** @brief Words a frame adds around its data: start and end of frame. */
+#define SW_SPFI_FRAME_OVERHEAD 2u
+
+/** @brief Model code of the end-of-packet control symbol. */
+#define SW_SPFI_EOP 0xFDu
+
+/** @brief Model code of the error-end-of-packet control symbol. */
+#define SW_SPFI_EEP 0xFEu
+
+/** @brief Model code of the fill control symbol. */
+#define SW_SPFI_FILL 0xFBu
+
+/** @brief Entry of the VC map for an unmapped ::sw_virtual_channel_t. */
+#define SW_SPFI_NO_VC 0xFFu
+
+/** @brief Bound of a VC's bandwidth credit, in word-percent (8 full frames). */
+#define SW_SPFI_BW_CREDIT_LIMIT                                                                    \
+    (8 * (int32_t)(SW_SPFI_FRAME_WORDS + SW_SPFI_FRAME_OVERHEAD) * 100)
+
+/**
+ * @brief A data frame.
+ */
+typedef struct
+{
+    uint8_t vc;                         /**< Virtual channel. */
+    uint8_t seq;                        /**< Frame sequence number on the link. */
+    uint16_t len;                       /**< Data symbols; a multiple of 4. */
+    uint16_t crc;                       /**< CRC-16 over VC, sequence and data. */
+    uint8_t k[SW_SPFI_FRAME_DATA / 8u]; /**< Bit i set: data[i] is a control symbol. */
+    uint8_t data[SW_SPFI_FRAME_DATA];   /**< Data symbols. */
+} sw_spfi_frame_t;
+
+/**
+ * @brief Configuration of a transmit VC.
+ */
+typedef struct
+{
+    uint8_t priority;  /**< 0 (highest) to 15. */
+    uint8_t bandwidth; /**< Reserved share of the lane in percent. */
+} sw_spfi_vc_config_t;
+
+/**
+ * @brief A transmit VC.
+ */
+typedef struct
+{
+    sw_ring_t *queue;  /**< Packets to send; NULL if the VC is not configured. */
+    sw_desc_t cur;     /**< Packet being framed. */
+    uint32_t cur_off;  /**< Octets of @ref cur framed so far. */
+    uint8_t has_cur;   /**< 1 if @ref cur is valid. */
+    uint8_t priority;  /**< 0 (highest) to 15. */
+    uint8_t bandwidth; /**< Reserved share of the lane in percent. */
+    uint32_t credits;  /**< Frames the far end can accept (FCTs held). */
+    int32_t bw_credit; /**< Bandwidth credit in word-percent. */
+    uint64_t frames;   /**< Frames sent. */
+    uint64_t words;    /**< Words sent, frame overhead included. */
+    uint64_t packets;  /**< Packets completed. */
+    uint64_t overuse;  /**< Frames sent while the bandwidth credit was negative. */
+} sw_spfi_tx_vc_t;
+
+/**
+ * @brief Transmit side of a link.
+ */
+typedef struct
+{
+    sw_spfi_tx_vc_t vc[SW_SPFI_MAX_VC]; /**< Virtual channels. */
+    uint8_t vc_map[256];                /**< ::sw_virtual_channel_t to VC, or ::SW_SPFI_NO_VC. */
+    uint8_t num_vcs;                    /**< One more than the highest configured VC. */
+    uint8_t seq;                        /**< Sequence number of the next frame. */
+    uint64_t words;                     /**< Words sent on the lane. */
+} sw_spfi_tx_t;
+
+/**
+ * @brief Delivery of a received packet.
+ *
+ * @param[in] ctx Context given to sw_spfi_rx_init().
+ * @param[in] vc  Virtual channel.
+ * @param[in] pkt Packet octets, valid during the call.
+ * @param[in] len Packet length.
+ * @param[in] end End marker the packet arrived with.
+ */
+typedef void (*sw_spfi_deliver_fn)(void *ctx,
+                                   uint8_t vc,
+                                   const uint8_t *pkt,
+                                   uint32_t len,
+                                   sw_end_marker_t end);
+
+/**
+ * @brief A receive VC: reassembly of the packet in progress.
+ */
+typedef struct
+{
+    uint8_t *buf;     /**< Reassembly buffer; NULL if the VC is not configured. */
+    uint32_t cap;     /**< Octets of @ref buf. */
+    uint32_t len;     /**< Octets of the packet so far. */
+    uint8_t oversize; /**< The packet overflowed @ref buf and is being skipped. */
+    uint64_t packets; /**< Packets delivered. */
+    uint64_t dropped; /**< Packets longer than @ref cap, discarded. */
+} sw_spfi_rx_vc_t;
+
+/**
+ * @brief Receive side of a link.
+ */
+typedef struct
+{
+    sw_spfi_rx_vc_t vc[SW_SPFI_MAX_VC]; /**< Virtual channels. */
+    sw_spfi_deliver_fn deliver;         /**< Packet delivery. */
+    void *ctx;                          /**< Context for @ref deliver. */
+    uint8_t seq;                        /**< Sequence number expected next. */
+    uint64_t frames;                    /**< Frames accepted. */
+    uint64_t crc_errors;                /**< Frames dropped for a bad CRC. */
+    uint64_t seq_errors;                /**< Frames out of sequence (accepted, resynchronised). */
+} sw_spfi_rx_t;
+
+/**
+ * @brief CRC-16 of a frame (CCITT polynomial, initial value 0xFFFF).
+ *
+ * @param[in] frame Frame; its @ref sw_spfi_frame_t::crc is not read.
+ * @return CRC over VC, sequence number, control flags and data symbols.
+ */
+uint16_t sw_spfi_frame_crc(const sw_spfi_frame_t *frame);
+
+/**
+ * @brief Words a frame occupies on the lane, start and end of frame included.
+ *
+ * @param[in] frame Frame.
+ * @return Words.
+ */
+static inline uint32_t sw_spfi_frame_words(const sw_spfi_frame_t *frame)
+{
+    return (uint32_t)frame->len / SW_SPFI_WORD + SW_SPFI_FRAME_OVERHEAD;
+}
+
+/**
+ * @brief Initialise a transmitter with no VCs and an empty VC map.
+ *
+ * @param[out] tx Transmitter.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_spfi_tx_init(sw_spfi_tx_t *tx);
+
+/**
+ * @brief Configure a transmit VC.
+ *
+ * @param[in,out] tx     Transmitter.
+ * @param[in]     vc     VC number, below ::SW_SPFI_MAX_VC.
+ * @param[in]     config Priority and reserved bandwidth.
+ * @param[in]     queue  Ring of packets to send; the transmitter pops it.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM (also if the reservations of all VCs
+ *         would exceed 100 percent).
+ */
+sw_result_t sw_spfi_tx_add_vc(sw_spfi_tx_t *tx,
+                              uint8_t vc,
+                              const sw_spfi_vc_config_t *config,
+                              sw_ring_t *queue);
+
+/**
+ * @brief Map a ::sw_virtual_channel_t (User Application value) to a VC.
+ *
+ * @param[in,out] tx   Transmitter.
+ * @param[in]     from Virtual channel of the packet layer.
+ * @param[in]     vc   Configured VC, or ::SW_SPFI_NO_VC to unmap.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_spfi_tx_map(sw_spfi_tx_t *tx, sw_virtual_channel_t from, uint8_t vc);
+
+/**
+ * @brief Queue a packet on the VC its virtual channel maps to.
+ *
+ * @param[in,out] tx   Transmitter.
+ * @param[in]     from Virtual channel of the packet, e.g.
+ *                     sw_packet_virtual_channel() of its frame.
+ * @param[in]     desc Packet; its octets must stay valid until framed, and
+ *                     @ref sw_desc_t::end selects EOP or EEP.
+ * @return ::SW_OK, ::SW_ERR if the VC's ring is full, or ::SW_INVALID_PARAM
+ *         if @p from is not mapped.
+ */
+sw_result_t sw_spfi_tx_enqueue(sw_spfi_tx_t *tx, sw_virtual_channel_t from, const sw_desc_t *desc);
+
+/**
+ * @brief Add flow-control credit: FCTs received for a VC.
+ *
+ * @param[in,out] tx     Transmitter.
+ * @param[in]     vc     VC.
+ * @param[in]     frames Frames of receive-buffer space granted.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_spfi_tx_fct(sw_spfi_tx_t *tx, uint8_t vc, uint32_t frames);
+
+/**
+ * @brief Select a VC and build the next data frame.
+ *
+ * @param[in,out] tx    Transmitter.
+ * @param[out]    frame Frame to send.
+ * @return ::SW_OK, ::SW_ERR if no VC has both data and credit, or
+ *         ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_spfi_tx_next_frame(sw_spfi_tx_t *tx, sw_spfi_frame_t *frame);
+
+/**
+ * @brief Initialise a receiver with no VCs.
+ *
+ * @param[out] rx      Receiver.
+ * @param[in]  deliver Called for each complete packet.
+ * @param[in]  ctx     Passed to @p deliver.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_spfi_rx_init(sw_spfi_rx_t *rx, sw_spfi_deliver_fn deliver, void *ctx);
+
+/**
+ * @brief Configure a receive VC.
+ *
+ * @param[in,out] rx  Receiver.
+ * @param[in]     vc  VC number, below ::SW_SPFI_MAX_VC.
+ * @param[in]     buf Reassembly buffer, as long as the longest packet.
+ * @param[in]     cap Octets of @p buf.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_spfi_rx_add_vc(sw_spfi_rx_t *rx, uint8_t vc, uint8_t *buf, uint32_t cap);
+
+/**
+ * @brief Receive a frame and deliver the packets it completes.
+ *
+ * Accepted or dropped, the frame's receive-buffer space is free again once
+ * this returns; the link returns one FCT for the frame's VC
+ * (sw_spfi_tx_fct() at the far end).
+ *
+ * @param[in,out] rx    Receiver.
+ * @param[in]     frame Frame.
+ * @return ::SW_OK, ::SW_ERR if the frame was dropped (bad CRC, bad length or
+ *         unconfigured VC), or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_spfi_rx_frame(sw_spfi_rx_t *rx, const sw_spfi_frame_t *frame);
+
+#endif /* SPACEWIRE_SPFI_H */
@@ -0,0 +1,211 @@
+/**
+ * @file spacewire_tf.h
+ * @brief Multiplexer of CCSDS packets into TM or AOS transfer frames.
+ *
+ * A downlink gateway receives CCSDS packets over SpaceWire with
+ * sw_packet_decode() and forwards them in fixed-length transfer frames:
+ * TM (CCSDS 132.0-B) or AOS (CCSDS 732.0-B, M_PDU data field). The
+ * multiplexer writes each packet straight from its decoded view — the
+ * primary header rebuilt from the parsed fields, the data field copied
+ * from where the received buffer holds it — into the data field of the
+ * open frame of its virtual channel (VC):
+ *
+ * - Spanning: a packet that does not fit continues in the VC's next frame,
+ *   and so on; a frame is handed to the callback as soon as it is full.
+ * - First header pointer: each frame records the offset of the first packet
+ *   header that starts in it, or ::SW_TF_FHP_NONE if it carries only the
+ *   continuation of a packet.
+ * - Counters: each VC numbers its frames (8 bits for TM, 24 bits for AOS);
+ *   TM frames also carry the master-channel count across all VCs, taken in
+ *   the order frames are emitted.
+ * - Idle filling: sw_tf_flush() closes a part-filled frame with a CCSDS idle
+ *   packet (APID ::SW_TF_IDLE_APID) that ends exactly at the end of a frame,
+ *   and sw_tf_idle_frame() emits a frame of idle data only, for when the
+ *   downlink must be fed and no VC has anything to send.
+ *
+ * The frames have no secondary header, operational control field or (for
+ * AOS) insert zone and header error control; a frame error control field
+ * (CRC-16) is optional. Synchronisation and channel coding are left to the
+ * downlink.
+ *
+ * All storage is caller-owned: each VC fills a frame buffer of its own,
+ * which the callback may read only until it returns. A multiplexer belongs
+ * to one thread.
+ */
+
+#ifndef SPACEWIRE_TF_H
+#define SPACEWIRE_TF_H
+
+#include "spacewire_packet.h"
+
+/** @brief Virtual channels (AOS: 0..63; TM: 0..7). */
+#define SW_TF_MAX_VC 64u
+
+/** @brief Transfer-frame primary header octets, TM and AOS alike. */
+#define SW_TF_PRIMARY_HEADER_LEN 6u
+
+/** @brief First header pointer when no packet header starts in the frame. */
+#define SW_TF_FHP_NONE 0x7FFu
+
+/** @brief First header pointer of a frame holding only idle data. */
+#define SW_TF_FHP_IDLE 0x7FEu
+
+/** @brief APID of the idle packets used to fill a frame. */
+#define SW_TF_IDLE_APID 0x7FFu
+
+/** @brief Octet repeated in idle packets and idle frames. */
+#define SW_TF_IDLE_OCTET 0x55u
+
+/** @brief Shortest CCSDS packet: primary header and one data octet. */
+#define SW_TF_MIN_PACKET 7u
+
+/**
+ * @brief Frame format.
+ */
+typedef enum
+{
+    SW_TF_TM = 0, /**< TM transfer frame, version 1. */
+    SW_TF_AOS = 1 /**< AOS transfer frame, version 2, carrying an M_PDU. */
+} sw_tf_kind_t;
+
+/**
+ * @brief Called with each frame, in emission order.
+ *
+ * @param ctx   Context given to sw_tf_init().
+ * @param vc    Virtual channel.
+ * @param frame Frame octets; valid until the callback returns.
+ * @param len   Frame length in octets.
+ */
+typedef void (*sw_tf_frame_fn)(void *ctx, uint8_t vc, const uint8_t *frame, uint16_t len);
+
+/**
+ * @brief Physical-channel configuration.
+ */
+typedef struct
+{
+    sw_tf_kind_t kind;  /**< Frame format. */
+    uint16_t scid;      /**< Spacecraft identifier (TM: 10 bits, AOS: 8 bits). */
+    uint16_t frame_len; /**< Frame length in octets, fixed on the channel. */
+    uint8_t fecf;       /**< 1 to end each frame with a CRC-16 error control field. */
+} sw_tf_config_t;
+
+/**
+ * @brief A virtual channel.
+ */
+typedef struct
+{
+    uint8_t *frame;       /**< Frame being filled (caller storage, frame_len octets). */
+    uint16_t fill;        /**< Octets of the data field filled. */
+    uint16_t fhp;         /**< First header pointer of the open frame. */
+    uint32_t count;       /**< Number of the next frame (mod 2^8 for TM, 2^24 for AOS). */
+    uint64_t frames;      /**< Frames emitted. */
+    uint64_t packets;     /**< Packets started. */
+    uint64_t idle_octets; /**< Idle-packet and idle-frame octets emitted. */
+} sw_tf_vc_t;
+
+/**
+ * @brief Multiplexer state.
+ */
+typedef struct
+{
+    sw_tf_config_t config;       /**< Channel configuration. */
+    uint16_t data_off;           /**< Offset of the packet zone in a frame. */
+    uint16_t data_len;           /**< Octets of the packet zone. */
+    uint8_t mc_count;            /**< TM master-channel frame count of the next frame. */
+    sw_tf_frame_fn on_frame;     /**< Frame callback. */
+    void *ctx;                   /**< Callback context. */
+    sw_tf_vc_t vc[SW_TF_MAX_VC]; /**< Virtual channels; unused while frame is NULL. */
+} sw_tf_mux_t;
+
+/**
+ * @brief Initialise a multiplexer with no virtual channels.
+ *
+ * @param[out] mux      Multiplexer.
+ * @param[in]  config   Channel configuration; the frame must leave room for
+ *                      at least ::SW_TF_MIN_PACKET octets of packets and at
+ *                      most 2046 (the first header pointer's range).
+ * @param[in]  on_frame Frame callback.
+ * @param[in]  ctx      Callback context.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_tf_init(sw_tf_mux_t *mux,
+                       const sw_tf_config_t *config,
+                       sw_tf_frame_fn on_frame,
+                       void *ctx);
+
+/**
+ * @brief Open a virtual channel.
+ *
+ * @param[in,out] mux   Multiplexer.
+ * @param[in]     vc    VC identifier (TM: 0..7, AOS: 0..63).
+ * @param[in]     frame Frame buffer of `config.frame_len` octets.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_tf_add_vc(sw_tf_mux_t *mux, uint8_t vc, uint8_t *frame);
+
+/**
+ * @brief Append a decoded packet to a virtual channel.
+ *
+ * The primary header is written from @p pkt's fields (with the data length
+ * field from `data_len`) and the data field is copied from `pkt->data`,
+ * across as many frames as it takes; full frames are emitted on the way.
+ *
+ * @param[in,out] mux Multiplexer.
+ * @param[in]     vc  Open virtual channel.
+ * @param[in]     pkt Packet, e.g. `&pf.packet` after sw_packet_decode(); at
+ *                    least one data octet.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_tf_put(sw_tf_mux_t *mux, uint8_t vc, const sp_packet_t *pkt);
+
+/**
+ * @brief Append an already-encoded packet to a virtual channel.
+ *
+ * @param[in,out] mux Multiplexer.
+ * @param[in]     vc  Open virtual channel.
+ * @param[in]     pkt Packet octets, primary header first.
+ * @param[in]     len Packet length; at least ::SW_TF_MIN_PACKET and equal to
+ *                    the length its header declares.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_tf_put_raw(sw_tf_mux_t *mux, uint8_t vc, const uint8_t *pkt, size_t len);
+
+/**
+ * @brief Close a virtual channel's part-filled frame with idle data.
+ *
+ * The rest of the frame is filled with one idle packet. If fewer than
+ * ::SW_TF_MIN_PACKET octets are left, the idle packet also fills the whole
+ * next frame, so that the VC is empty on return. Nothing happens if the
+ * open frame is empty.
+ *
+ * @param[in,out] mux Multiplexer.
+ * @param[in]     vc  Open virtual channel.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_tf_flush(sw_tf_mux_t *mux, uint8_t vc);
+
+/**
+ * @brief Emit a frame of idle data only on a virtual channel.
+ *
+ * The first header pointer (TM) or M_PDU header (AOS) is ::SW_TF_FHP_IDLE
+ * and the data field is idle data. AOS idle frames are normally sent on
+ * VC 63. The VC's counters advance as for any frame.
+ *
+ * @param[in,out] mux Multiplexer.
+ * @param[in]     vc  Open virtual channel with an empty frame.
+ * @return ::SW_OK, ::SW_ERR if the VC's frame is part-filled (flush it
+ *         first), or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_tf_idle_frame(sw_tf_mux_t *mux, uint8_t vc);
+
+/**
+ * @brief CRC-16 of a frame's error control field (CCITT polynomial 0x1021,
+ *        initial value 0xFFFF).
+ *
+ * @param[in] data Octets.
+ * @param[in] len  Number of octets.
+ * @return CRC.
+ */
+uint16_t sw_tf_crc(const uint8_t *data, size_t len);
+
+#endif /* SPACEWIRE_TF_H */
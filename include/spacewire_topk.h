@@ -0,0 +1,164 @@
+/**
+ * @file spacewire_topk.h
+ * @brief Streaming heavy-hitter detection over (logical address, APID, VC)
+ *        flows.
+ *
+ * Finds the flows carrying the most octets with memory fixed at K counters,
+ * however many flows there are, using the Space-Saving algorithm weighted by
+ * packet length: a packet of a tracked flow adds its length to the flow's
+ * counter; a packet of an untracked flow, once all K counters are in use,
+ * takes over the smallest counter, inheriting its value as the new flow's
+ * possible overcount. Every flow carrying more than 1/K of the octets is then
+ * guaranteed to be tracked, and each estimate lies between `count - error`
+ * and `count`.
+ *
+ * Counters sit in a min-heap, with an open-addressed hash index from flow key
+ * to counter, so the smallest is found at once and an update is a hash lookup
+ * plus a sift towards the leaves. Heavy flows settle in the leaves, where
+ * their updates move nothing, and a sift is at most log2(K) steps otherwise.
+ * An update is thus O(log K) in the worst case, not O(1): the O(1) stream
+ * summary (counters in buckets of equal count) relies on unit increments,
+ * and a packet length moves a counter past any number of buckets.
+ *
+ * Feed it from the router path with sw_topk_add_packet() next to
+ * sw_router_route(), or from the receive path with sw_topk_add_frame() after
+ * sw_packet_decode(). A detector has a single writer; use one per thread and
+ * merge their top-K lists when reporting.
+ */
+
+#ifndef SPACEWIRE_TOPK_H
+#define SPACEWIRE_TOPK_H
+
+#include "spacewire_packet.h"
+
+/** @brief APID value of a flow whose packets are not CCSDS PTP packets. */
+#define SW_TOPK_NO_APID 0x800u
+
+/**
+ * @brief Flow key: logical address, user application (VC) and APID.
+ */
+#define SW_TOPK_KEY(logical_addr, vc, apid)                                                        \
+    (((uint32_t)(logical_addr) << 24) | ((uint32_t)(vc) << 16) | ((uint32_t)(apid) & 0xFFFu))
+
+/** @brief Logical address of a flow key. */
+#define SW_TOPK_KEY_ADDR(key) ((uint8_t)((key) >> 24))
+
+/** @brief Virtual channel (user application) of a flow key. */
+#define SW_TOPK_KEY_VC(key) ((uint8_t)((key) >> 16))
+
+/** @brief APID of a flow key, or ::SW_TOPK_NO_APID. */
+#define SW_TOPK_KEY_APID(key) ((uint16_t)((key) & 0xFFFu))
+
+/**
+ * @brief One tracked flow.
+ */
+typedef struct
+{
+    uint32_t key;   /**< Flow key, see ::SW_TOPK_KEY. */
+    uint16_t slot;  /**< Position in the heap (internal). */
+    uint64_t count; /**< Octets counted, overcount included. */
+    uint64_t error; /**< Largest possible overcount. */
+} sw_topk_entry_t;
+
+/**
+ * @brief A heavy-hitter detector over caller-owned storage.
+ */
+typedef struct
+{
+    sw_topk_entry_t *entries; /**< K counters. */
+    uint16_t *heap;           /**< K entry indices, a min-heap on count. */
+    uint16_t *index;          /**< Hash slots: entry index + 1, or 0 if free. */
+    uint32_t index_mask;      /**< Hash slot count - 1. */
+    uint16_t capacity;        /**< K. */
+    uint16_t num_entries;     /**< Counters in use. */
+    uint64_t total;           /**< Octets seen. */
+} sw_topk_t;
+
+/**
+ * @brief Initialise a detector.
+ *
+ * @param[out] topk        Detector.
+ * @param[in]  entries     @p capacity counters.
+ * @param[in]  heap        @p capacity heap slots.
+ * @param[in]  capacity    K, 1..32767.
+ * @param[in]  index       @p index_slots hash slots.
+ * @param[in]  index_slots A power of two of at least 2 * @p capacity.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_topk_init(sw_topk_t *topk,
+                         sw_topk_entry_t *entries,
+                         uint16_t *heap,
+                         uint16_t capacity,
+                         uint16_t *index,
+                         uint32_t index_slots);
+
+/**
+ * @brief Forget every flow.
+ * @param[in,out] topk Detector. No-op if NULL.
+ */
+void sw_topk_reset(sw_topk_t *topk);
+
+/**
+ * @brief Count @p octets for flow @p key.
+ *
+ * @param[in,out] topk   Detector.
+ * @param[in]     key    Flow key.
+ * @param[in]     octets Packet length.
+ */
+void sw_topk_add(sw_topk_t *topk, uint32_t key, uint32_t octets);
+
+/**
+ * @brief Count a packet as seen by a router.
+ *
+ * Leading path-address octets are skipped. The flow is the packet's logical
+ * address and, for a CCSDS PTP packet, its user application and APID; other
+ * packets count as APID ::SW_TOPK_NO_APID, VC 0.
+ *
+ * @param[in,out] topk Detector.
+ * @param[in]     pkt  Packet, as passed to sw_router_route().
+ * @param[in]     len  Packet length in octets.
+ */
+void sw_topk_add_packet(sw_topk_t *topk, const uint8_t *pkt, size_t len);
+
+/**
+ * @brief Count a decoded CCSDS PTP packet.
+ *
+ * @param[in,out] topk   Detector.
+ * @param[in]     pf     Frame filled by sw_packet_decode().
+ * @param[in]     octets Received length.
+ */
+void sw_topk_add_frame(sw_topk_t *topk, const sw_packet_frame_t *pf, size_t octets);
+
+/**
+ * @brief Estimate the octets of one flow.
+ *
+ * @param[in]  topk  Detector.
+ * @param[in]  key   Flow key.
+ * @param[out] error Largest possible overcount; may be NULL.
+ * @return Upper bound on the flow's octets; 0 if untracked, in which case the
+ *         flow carried at most the smallest tracked count.
+ */
+uint64_t sw_topk_estimate(const sw_topk_t *topk, uint32_t key, uint64_t *error);
+
+/**
+ * @brief Copy the heaviest flows, heaviest first.
+ *
+ * @param[in]  topk Detector.
+ * @param[out] out  Up to @p max entries.
+ * @param[in]  max  Capacity of @p out.
+ * @return Entries written.
+ */
+uint16_t sw_topk_top(const sw_topk_t *topk, sw_topk_entry_t *out, uint16_t max);
+
+/**
+ * @brief Age all counts by a right shift, so recent traffic dominates.
+ *
+ * Call periodically (e.g. once a second with @p shift 1 for a half-life of
+ * one period). Order is preserved, so nothing is re-sorted.
+ *
+ * @param[in,out] topk  Detector.
+ * @param[in]     shift Bits to shift; 1..63.
+ */
+void sw_topk_decay(sw_topk_t *topk, unsigned shift);
+
+#endif /* SPACEWIRE_TOPK_H */
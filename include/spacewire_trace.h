@@ -0,0 +1,219 @@
+/**
+ * @file spacewire_trace.h
+ * @brief Span tracing of the packet path, exported as Chrome trace JSON.
+ *
+ * Each thread that should be traced attaches its own buffer of fixed-size
+ * 24-octet span records. The library then records a span around
+ * sw_packet_encode(), sw_router_route(), sw_ring_push_burst(),
+ * sw_ring_pop_burst(), sw_txq_enqueue_burst(), sw_txq_dequeue_burst() and
+ * sw_packet_decode() into the calling thread's buffer; the application adds
+ * spans of its own (e.g. a whole burst, or a wait on a ring) with
+ * sw_trace_begin() and sw_trace_end().
+ *
+ * Every span carries the thread's current trace identifier, set with
+ * sw_trace_set_id() — typically a packet or burst sequence number that the
+ * application carries from stage to stage (e.g. in ::sw_desc_t::tag). Sampling
+ * is by identifier: with one span in N, a thread records only while its
+ * identifier is a multiple of N, so the stages of a sampled packet are kept on
+ * every thread that handles it and the others cost nothing but the check.
+ *
+ * A buffer has a single writer, its owning thread, so recording a span is two
+ * timestamp reads, the record's stores and a release store of the head — no
+ * locks and no read-modify-write. Threads without a buffer, or whose current
+ * identifier is not sampled, pay one thread-local load and a branch per span.
+ * A full buffer overwrites its oldest spans, like the event log
+ * (spacewire_evlog.h).
+ *
+ * sw_trace_export_json() writes every registered buffer in the Chrome trace
+ * event format, which chrome://tracing and the Perfetto UI open directly: one
+ * track per thread, spans named after the stage, the trace identifier and
+ * object in the span's arguments.
+ */
+
+#ifndef SPACEWIRE_TRACE_H
+#define SPACEWIRE_TRACE_H
+
+#include "spacewire_evlog.h"
+
+/**
+ * @brief Storage class of the per-thread trace state.
+ *
+ * Defaults to that of the event log, ::SW_EVLOG_THREAD_LOCAL.
+ */
+#ifndef SW_TRACE_THREAD_LOCAL
+#    define SW_TRACE_THREAD_LOCAL SW_EVLOG_THREAD_LOCAL
+#endif
+
+/**
+ * @brief Span types.
+ */
+typedef enum
+{
+    SW_SPAN_NONE = 0x00,        /**< Unused record. */
+    SW_SPAN_ENCODE = 0x01,      /**< sw_packet_encode(); arg = octets written. */
+    SW_SPAN_ROUTE = 0x02,       /**< sw_router_route(); arg = output port, 0xFFFF on discard. */
+    SW_SPAN_RING_PUSH = 0x03,   /**< sw_ring_push_burst(); arg = descriptors appended. */
+    SW_SPAN_RING_POP = 0x04,    /**< sw_ring_pop_burst(); arg = descriptors removed. */
+    SW_SPAN_DECODE = 0x05,      /**< sw_packet_decode(); arg = ::sw_ptp_status_t. */
+    SW_SPAN_TXQ_ENQUEUE = 0x06, /**< sw_txq_enqueue_burst(); arg = descriptors appended. */
+    SW_SPAN_TXQ_DEQUEUE = 0x07, /**< sw_txq_dequeue_burst(); arg = descriptors removed. */
+    SW_SPAN_USER = 0x80         /**< First application-defined type. */
+} sw_span_t;
+
+/**
+ * @brief One span record (24 octets).
+ */
+typedef struct
+{
+    uint64_t start;    /**< Timestamp counter at the start, see sw_evlog_timestamp(). */
+    uint32_t duration; /**< Counter ticks to the end, saturated. */
+    uint32_t id;       /**< Trace identifier current at the start. */
+    uint32_t obj;      /**< Object the span concerns: low 32 bits of its address. */
+    uint16_t arg;      /**< Type-specific argument. */
+    uint8_t span;      /**< ::sw_span_t. */
+    uint8_t reserved;  /**< 0. */
+} sw_trace_event_t;
+
+/**
+ * @brief A per-thread span buffer.
+ *
+ * @note `head` is written by the owning thread only and read atomically by
+ *       snapshots and exports; `next` links registered buffers.
+ */
+typedef struct sw_trace_buf
+{
+    sw_trace_event_t *events;  /**< Caller-owned record storage. */
+    uint32_t mask;             /**< Record count - 1; the count is a power of two. */
+    uint32_t head;             /**< Records written so far (free-running). */
+    uint32_t thread_id;        /**< Application-chosen identifier, the track in exports. */
+    uint32_t sample_mask;      /**< Identifiers with these bits clear are recorded. */
+    struct sw_trace_buf *next; /**< Next registered buffer. */
+} sw_trace_buf_t;
+
+/**
+ * @brief Sink for sw_trace_export_json(), e.g. a wrapper around write(2).
+ *
+ * @return 0 on success, non-zero to abort the export.
+ */
+typedef int (*sw_trace_write_fn)(void *ctx, const void *data, size_t len);
+
+/**
+ * @brief The calling thread's buffer if its current identifier is sampled,
+ *        else NULL.
+ *
+ * @internal Read by sw_trace_begin(); maintained by sw_trace_attach() and
+ *           sw_trace_set_id().
+ */
+extern SW_TRACE_THREAD_LOCAL sw_trace_buf_t *sw_trace_sampled;
+
+/**
+ * @brief Initialise a buffer over caller-owned storage.
+ *
+ * @param[out] buf          Buffer to initialise.
+ * @param[in]  events       Record storage.
+ * @param[in]  count        Number of records; a power of two, at least 2. The
+ *                          buffer retains the @p count - 1 most recent spans.
+ * @param[in]  thread_id    Identifier of the thread's track in exports.
+ * @param[in]  sample_every Record the spans of one identifier in this many; a
+ *                          power of two. Give every buffer the same value so
+ *                          that a sampled packet is traced on all threads.
+ * @return ::SW_OK on success, ::SW_INVALID_PARAM otherwise.
+ */
+sw_result_t sw_trace_buf_init(sw_trace_buf_t *buf,
+                              sw_trace_event_t *events,
+                              uint32_t count,
+                              uint32_t thread_id,
+                              uint32_t sample_every);
+
+/**
+ * @brief Make @p buf the calling thread's span buffer.
+ *
+ * @param[in] buf Buffer to record into, or NULL to stop tracing.
+ */
+void sw_trace_attach(sw_trace_buf_t *buf);
+
+/**
+ * @brief Add a buffer to the process-wide list walked by
+ *        sw_trace_export_json().
+ *
+ * Lock-free; a registered buffer must stay valid for the life of the process.
+ *
+ * @param[in] buf Buffer to register.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM if @p buf is NULL or already listed.
+ */
+sw_result_t sw_trace_register(sw_trace_buf_t *buf);
+
+/**
+ * @brief Set the calling thread's trace identifier for the spans that follow.
+ *
+ * @param[in] id Packet or burst identifier; decides sampling.
+ */
+void sw_trace_set_id(uint32_t id);
+
+/**
+ * @brief The calling thread's trace identifier.
+ *
+ * @return Identifier last set, 0 initially.
+ */
+uint32_t sw_trace_id(void);
+
+/**
+ * @brief Record a finished span; see sw_trace_end().
+ */
+void sw_trace_record(uint64_t start, sw_span_t span, const void *obj, uint16_t arg);
+
+/**
+ * @brief Start a span.
+ *
+ * @return Start timestamp to pass to sw_trace_end(), or 0 if the span is not
+ *         recorded (no buffer attached, or the identifier is not sampled).
+ */
+static inline uint64_t sw_trace_begin(void)
+{
+    if (!sw_trace_sampled)
+        return 0;
+
+    const uint64_t t = sw_evlog_timestamp();
+    return t != 0 ? t : 1u;
+}
+
+/**
+ * @brief End a span started with sw_trace_begin().
+ *
+ * @param[in] start Value returned by sw_trace_begin(); 0 records nothing.
+ * @param[in] span  Span type.
+ * @param[in] obj   Object the span concerns; may be NULL.
+ * @param[in] arg   Type-specific argument.
+ */
+static inline void sw_trace_end(uint64_t start, sw_span_t span, const void *obj, uint16_t arg)
+{
+    if (start != 0)
+        sw_trace_record(start, span, obj, arg);
+}
+
+/**
+ * @brief Copy a buffer's surviving spans, oldest first.
+ *
+ * @param[in]  buf Buffer to read; may be owned by another thread.
+ * @param[out] out Destination.
+ * @param[in]  max Capacity of @p out in records.
+ * @return Records copied: the most recent ones (at most the buffer size - 1)
+ *         that were not overwritten while being copied.
+ */
+size_t sw_trace_snapshot(const sw_trace_buf_t *buf, sw_trace_event_t *out, size_t max);
+
+/**
+ * @brief Write every registered buffer to a sink as Chrome trace JSON.
+ *
+ * Times are in microseconds from the earliest span exported. Uses only a
+ * small stack buffer; spans overwritten during the export are left out.
+ *
+ * @param[in] sink         Sink.
+ * @param[in] ctx          Context passed to @p sink.
+ * @param[in] ticks_per_us Timestamp counter ticks per microsecond, e.g. the
+ *                         TSC frequency in MHz; > 0.
+ * @return ::SW_OK, ::SW_INVALID_PARAM, or ::SW_ERR if the sink failed.
+ */
+sw_result_t sw_trace_export_json(sw_trace_write_fn sink, void *ctx, double ticks_per_us);
+
+#endif /* SPACEWIRE_TRACE_H */
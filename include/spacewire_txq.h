@@ -0,0 +1,134 @@
+/**
+ * @file spacewire_txq.h
+ * @brief Multi-producer single-consumer transmit queues of packet descriptors.
+ *
+ * One queue per link: any number of application threads append encoded
+ * packets by descriptor, and the thread that owns the link removes them in
+ * bursts and hands them to the driver. Producers need no lock of their own.
+ *
+ * - Enqueue: a producer reserves a run of slots with one compare-and-swap
+ *   on the shared tail, copies its descriptors in and publishes each slot
+ *   by storing its sequence number. A burst therefore occupies consecutive
+ *   slots and stays in order; bursts of different producers interleave in
+ *   reservation order.
+ * - Dequeue: the link owner copies out slots while their sequence numbers
+ *   show them published, then releases them with one store of the head. A
+ *   producer that has reserved slots but not yet filled them holds back the
+ *   slots behind it until it does.
+ * - Backpressure: the queue holds at most `limit` descriptors (at most the
+ *   slot count; it may be lowered and raised at run time, e.g. to bound the
+ *   queueing delay ahead of a slow link). A producer that finds no room
+ *   gets a short count and decides whether to retry, wait or drop; the
+ *   refused descriptors are counted.
+ *
+ * As in the SPSC ring, the producer-side and consumer-side indices sit on
+ * separate cache lines, and producers share a copy of the head that they
+ * refresh only when the queue looks full.
+ */
+
+#ifndef SPACEWIRE_TXQ_H
+#define SPACEWIRE_TXQ_H
+
+#include "spacewire_ring.h"
+
+/**
+ * @brief A queue slot: a descriptor and its publication sequence number.
+ */
+typedef struct
+{
+    sw_desc_t desc; /**< Descriptor. */
+    uint32_t seq;   /**< Position + 1 once the descriptor at that position is written. */
+} sw_txq_slot_t;
+
+/**
+ * @brief A transmit queue over caller-owned slots.
+ *
+ * @note `tail`, `head_cache`, `limit` and `rejected` are shared by the
+ *       producers, `head` belongs to the consumer; each group has its own
+ *       cache line.
+ */
+typedef struct
+{
+    uint32_t tail;                                            /**< Next slot to reserve. */
+    uint32_t head_cache;                                      /**< Producers' copy of @ref head. */
+    uint32_t limit;                                           /**< Most descriptors queued. */
+    uint32_t rejected;                                        /**< Descriptors refused (wraps). */
+    uint8_t pad0[SW_RING_CACHE_LINE - 4u * sizeof(uint32_t)]; /**< Separates the sides. */
+    uint32_t head;                                            /**< Next slot to drain. */
+    uint8_t pad1[SW_RING_CACHE_LINE - sizeof(uint32_t)];      /**< Separates @ref slots. */
+    sw_txq_slot_t *slots;                                     /**< Slot storage. */
+    uint32_t mask;                                            /**< Slot count - 1. */
+} sw_txq_t;
+
+/**
+ * @brief Initialise an empty queue.
+ *
+ * @param[out] q     Queue.
+ * @param[in]  slots Slot storage.
+ * @param[in]  count Number of slots; a power of two, at most 2^31.
+ * @param[in]  limit Most descriptors queued; 0 for @p count.
+ * @return ::SW_OK or ::SW_INVALID_PARAM.
+ */
+sw_result_t sw_txq_init(sw_txq_t *q, sw_txq_slot_t *slots, uint32_t count, uint32_t limit);
+
+/**
+ * @brief Change the queue limit (any thread).
+ *
+ * Lowering it below the descriptors already queued refuses new ones until
+ * the consumer has drained below it; nothing queued is dropped.
+ *
+ * @param[in,out] q     Queue.
+ * @param[in]     limit Most descriptors queued; 0 for the slot count.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM if it exceeds the slot count.
+ */
+sw_result_t sw_txq_set_limit(sw_txq_t *q, uint32_t limit);
+
+/**
+ * @brief Append descriptors (any producer thread).
+ *
+ * @param[in,out] q     Queue.
+ * @param[in]     descs Descriptors, in order.
+ * @param[in]     n     Number of descriptors.
+ * @return Descriptors appended: the first `return` of @p descs; fewer than
+ *         @p n if the queue reached its limit.
+ */
+uint32_t sw_txq_enqueue_burst(sw_txq_t *q, const sw_desc_t *descs, uint32_t n);
+
+/**
+ * @brief Remove descriptors (the link-owner thread only).
+ *
+ * @param[in,out] q   Queue.
+ * @param[out]    out Descriptors, oldest first.
+ * @param[in]     max Capacity of @p out.
+ * @return Descriptors removed; 0 if none is published yet.
+ */
+uint32_t sw_txq_dequeue_burst(sw_txq_t *q, sw_desc_t *out, uint32_t max);
+
+/**
+ * @brief Append one descriptor (any producer thread).
+ * @return ::SW_OK, or ::SW_ERR if the queue is at its limit.
+ */
+static inline sw_result_t sw_txq_enqueue(sw_txq_t *q, const sw_desc_t *desc)
+{
+    return sw_txq_enqueue_burst(q, desc, 1) == 1 ? SW_OK : SW_ERR;
+}
+
+/**
+ * @brief Remove one descriptor (the link-owner thread only).
+ * @return ::SW_OK, or ::SW_ERR if none is published.
+ */
+static inline sw_result_t sw_txq_dequeue(sw_txq_t *q, sw_desc_t *desc)
+{
+    return sw_txq_dequeue_burst(q, desc, 1) == 1 ? SW_OK : SW_ERR;
+}
+
+/**
+ * @brief Descriptors reserved and not yet removed; exact only when all
+ *        threads are idle.
+ *
+ * @param[in] q Queue.
+ * @return Descriptors queued.
+ */
+uint32_t sw_txq_count(const sw_txq_t *q);
+
+#endif /* SPACEWIRE_TXQ_H */
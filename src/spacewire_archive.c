@@ -0,0 +1,542 @@
+/**
+ * @file spacewire_archive.c
+ * @brief Columnar telemetry archive of decoded packets, one APID per chunk.
+ */
+
+#include "../include/spacewire_archive.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/** @brief Largest chunk accepted by sw_archive_writer_init(). */
+#define SW_ARCHIVE_MAX_ROWS (1u << 24)
+
+/** @brief Values decoded per inner batch of sw_archive_read(). */
+#define SW_ARCHIVE_BATCH 256u
+
+/* ============================================================================
+ * LAYOUT
+ * ============================================================================ */
+
+/** @brief Round @p n up to a multiple of @p a, a power of two. */
+static uint64_t sw_archive_align(uint64_t n, uint64_t a)
+{
+    return (n + a - 1u) & ~(a - 1u);
+}
+
+/** @brief Octets of the chunk header and column descriptors. */
+static uint64_t sw_archive_meta_size(uint32_t num_columns)
+{
+    return sw_archive_align(sizeof(sw_archive_chunk_t) +
+                                (uint64_t)num_columns * sizeof(sw_archive_column_t),
+                            SW_ARCHIVE_ALIGN);
+}
+
+/** @brief Octets of a validity bitmap for @p rows. */
+static uint64_t sw_archive_bitmap_size(uint32_t rows)
+{
+    return ((uint64_t)rows + 7u) / 8u;
+}
+
+/**
+ * @brief Order-preserving unsigned key of value @p i of a column.
+ *
+ * Signed values have their sign bit flipped so that unsigned comparison and
+ * subtraction order them correctly; other values are their own key.
+ */
+static uint64_t sw_archive_key(const void *values, uint8_t type, uint32_t i)
+{
+    switch (type)
+    {
+    case SW_ARCHIVE_U8:
+        return ((const uint8_t *)values)[i];
+    case SW_ARCHIVE_U16:
+        return ((const uint16_t *)values)[i];
+    case SW_ARCHIVE_I64:
+        return ((const uint64_t *)values)[i] ^ ((uint64_t)1 << 63);
+    default:
+        return ((const uint64_t *)values)[i];
+    }
+}
+
+/** @brief Inverse of sw_archive_key(): the stored bits of key @p k. */
+static uint64_t sw_archive_unkey(uint64_t k, uint8_t type)
+{
+    return type == SW_ARCHIVE_I64 ? k ^ ((uint64_t)1 << 63) : k;
+}
+
+size_t sw_archive_storage_size(uint32_t max_rows, uint16_t num_params)
+{
+    const uint64_t rows = max_rows;
+
+    return (size_t)(rows * 8u + (uint64_t)num_params * rows * 8u +
+                    sw_archive_align(2u * (uint64_t)num_params * sizeof(void *), 8u) +
+                    3u * sw_archive_align(rows * 2u, 8u) + 3u * sw_archive_align(rows, 8u) +
+                    sw_archive_align(num_params, 8u));
+}
+
+size_t sw_archive_flush_bound(const sw_archive_writer_t *w)
+{
+    if (!w)
+        return 0;
+
+    const uint32_t columns = SW_ARCHIVE_COL_PARAM + w->num_params;
+    const uint64_t per_column =
+        sw_archive_align(sw_archive_bitmap_size(w->max_rows), SW_ARCHIVE_ALIGN) +
+        sw_archive_align((uint64_t)w->max_rows * 8u, SW_ARCHIVE_ALIGN);
+
+    return (size_t)(sw_archive_meta_size(columns) + columns * per_column);
+}
+
+/* ============================================================================
+ * WRITER
+ * ============================================================================ */
+
+/** @brief Carve @p n octets, 8-octet aligned, from @p *p. */
+static void *sw_archive_carve(uint8_t **p, uint64_t n)
+{
+    void *r = *p;
+    *p += sw_archive_align(n, 8u);
+    return r;
+}
+
+sw_result_t sw_archive_writer_init(sw_archive_writer_t *w,
+                                   uint16_t apid,
+                                   const sw_decom_plan_t *plan,
+                                   const sw_decom_param_t *params,
+                                   uint32_t max_rows,
+                                   void *storage,
+                                   size_t size)
+{
+    if (!w || !storage || max_rows == 0 || max_rows > SW_ARCHIVE_MAX_ROWS)
+        return SW_INVALID_PARAM;
+    if (plan && !params)
+        return SW_INVALID_PARAM;
+    if (((uintptr_t)storage & 7u) != 0)
+        return SW_INVALID_PARAM;
+
+    const uint16_t num_params = plan ? plan->num_params : 0;
+    if (size < sw_archive_storage_size(max_rows, num_params))
+        return SW_INVALID_PARAM;
+
+    memset(w, 0, sizeof(*w));
+    uint8_t *p = storage;
+    w->time = sw_archive_carve(&p, (uint64_t)max_rows * 8u);
+    w->params = sw_archive_carve(&p, (uint64_t)num_params * sizeof(void *));
+    w->cursor = sw_archive_carve(&p, (uint64_t)num_params * sizeof(void *));
+    for (uint16_t i = 0; i < num_params; i++)
+        w->params[i] = sw_archive_carve(&p, (uint64_t)max_rows * 8u);
+    w->apid = sw_archive_carve(&p, (uint64_t)max_rows * 2u);
+    w->seq = sw_archive_carve(&p, (uint64_t)max_rows * 2u);
+    w->length = sw_archive_carve(&p, (uint64_t)max_rows * 2u);
+    w->addr = sw_archive_carve(&p, max_rows);
+    w->user_app = sw_archive_carve(&p, max_rows);
+    w->valid = sw_archive_carve(&p, max_rows);
+    w->types = sw_archive_carve(&p, num_params);
+
+    for (uint16_t i = 0; i < num_params; i++)
+        w->types[i] = params[i].type == SW_DECOM_INT     ? SW_ARCHIVE_I64
+                      : params[i].type == SW_DECOM_FLOAT ? SW_ARCHIVE_F64
+                                                         : SW_ARCHIVE_U64;
+
+    w->plan = plan;
+    w->max_rows = max_rows;
+    w->num_params = num_params;
+    w->chunk_apid = (uint16_t)((plan ? plan->apid : apid) & 0x7FFu);
+
+    return SW_OK;
+}
+
+size_t sw_archive_append(sw_archive_writer_t *w,
+                         const uint64_t *times,
+                         const sw_packet_frame_t *frames,
+                         size_t n)
+{
+    if (!w || !times || !frames)
+        return 0;
+
+    const uint32_t r = w->num_rows;
+    const size_t m = n < w->max_rows - r ? n : w->max_rows - r;
+
+    for (size_t i = 0; i < m; i++)
+    {
+        const sw_packet_frame_t *f = &frames[i];
+        w->time[r + i] = times[i];
+        w->addr[r + i] = f->logical_addr;
+        w->user_app[r + i] = f->user_app;
+        w->apid[r + i] = (uint16_t)f->packet.ph.apid;
+        w->seq[r + i] = (uint16_t)f->packet.ph.seq_count;
+        w->length[r + i] = f->packet.data_len;
+    }
+
+    if (w->plan && m > 0)
+    {
+        for (uint16_t p = 0; p < w->num_params; p++)
+            w->cursor[p] = (uint64_t *)w->params[p] + r;
+        sw_decom_run(w->plan, frames, m, w->cursor, &w->valid[r]);
+    }
+
+    w->num_rows = r + (uint32_t)m;
+    return m;
+}
+
+/**
+ * @brief Encode one column at @p off of the chunk.
+ *
+ * @param[out] d     Descriptor.
+ * @param[in]  type  Column type.
+ * @param[in]  src   Row values, of the column type.
+ * @param[in]  valid Row validity, or NULL if every row is valid.
+ * @param[in]  rows  Rows.
+ * @param[out] chunk Chunk being built.
+ * @param[in]  off   First free, aligned octet of @p chunk.
+ * @return First free, aligned octet after the column's buffers.
+ */
+static uint64_t sw_archive_encode(sw_archive_column_t *d,
+                                  uint8_t type,
+                                  const void *src,
+                                  const uint8_t *valid,
+                                  uint32_t rows,
+                                  uint8_t *chunk,
+                                  uint64_t off)
+{
+    const uint8_t size = (uint8_t)sw_archive_type_size(type);
+    uint32_t nulls = 0;
+    uint64_t lo = UINT64_MAX;
+    uint64_t hi = 0;
+
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        if (valid && !valid[i])
+        {
+            nulls++;
+            continue;
+        }
+        const uint64_t k = sw_archive_key(src, type, i);
+        lo = k < lo ? k : lo;
+        hi = k > hi ? k : hi;
+    }
+    if (nulls == rows)
+        lo = hi = 0;
+
+    /* The narrowest encoding: a constant, offsets in fewer octets, or plain. */
+    const uint64_t range = hi - lo;
+    const uint8_t width = range == 0           ? 0u
+                          : range <= 0xFFu     ? 1u
+                          : range <= 0xFFFFu   ? 2u
+                          : range <= UINT32_MAX ? 4u
+                                                : 8u;
+
+    memset(d, 0, sizeof(*d));
+    d->type = type;
+    d->null_count = nulls;
+    d->base = sw_archive_unkey(lo, type);
+    if (width == 0)
+    {
+        d->encoding = SW_ARCHIVE_CONST;
+    }
+    else if (width < size && type != SW_ARCHIVE_F64)
+    {
+        d->encoding = SW_ARCHIVE_FOR;
+        d->width = width;
+    }
+    else
+    {
+        d->encoding = SW_ARCHIVE_PLAIN;
+        d->width = size;
+        d->base = 0;
+    }
+
+    if (nulls > 0)
+    {
+        const uint64_t bytes = sw_archive_bitmap_size(rows);
+        const uint64_t end = sw_archive_align(off + bytes, SW_ARCHIVE_ALIGN);
+        uint8_t *bits = chunk + off;
+
+        memset(bits, 0, end - off);
+        for (uint32_t i = 0; i < rows; i++)
+            bits[i / 8u] = (uint8_t)(bits[i / 8u] | ((valid[i] ? 1u : 0u) << (i % 8u)));
+        d->validity = off;
+        off = end;
+    }
+
+    if (d->encoding == SW_ARCHIVE_CONST)
+        return off;
+
+    const uint64_t end = sw_archive_align(off + (uint64_t)rows * d->width, SW_ARCHIVE_ALIGN);
+    uint8_t *out = chunk + off;
+    d->values = off;
+
+    if (d->encoding == SW_ARCHIVE_PLAIN)
+    {
+        memcpy(out, src, (size_t)rows * size);
+    }
+    else
+    {
+        /* Null rows store offset 0, the reference value. */
+        for (uint32_t i = 0; i < rows; i++)
+        {
+            const uint64_t delta = valid && !valid[i] ? 0u : sw_archive_key(src, type, i) - lo;
+            if (width == 1u)
+            {
+                out[i] = (uint8_t)delta;
+            }
+            else if (width == 2u)
+            {
+                const uint16_t v = (uint16_t)delta;
+                memcpy(out + 2u * i, &v, sizeof(v));
+            }
+            else
+            {
+                const uint32_t v = (uint32_t)delta;
+                memcpy(out + 4u * i, &v, sizeof(v));
+            }
+        }
+    }
+
+    memset(out + (uint64_t)rows * d->width, 0, end - off - (uint64_t)rows * d->width);
+    return end;
+}
+
+sw_result_t sw_archive_flush(sw_archive_writer_t *w, void *buf, size_t size, size_t *len)
+{
+    if (!w || !buf || !len || ((uintptr_t)buf & (SW_ARCHIVE_ALIGN - 1u)) != 0)
+        return SW_INVALID_PARAM;
+
+    *len = 0;
+    if (w->num_rows == 0)
+        return SW_OK;
+    if (size < sw_archive_flush_bound(w))
+        return SW_ERR;
+
+    const uint32_t rows = w->num_rows;
+    const uint32_t columns = SW_ARCHIVE_COL_PARAM + w->num_params;
+    uint8_t *chunk = buf;
+    sw_archive_column_t *cols = (sw_archive_column_t *)(void *)(chunk + sizeof(sw_archive_chunk_t));
+    uint64_t off = sw_archive_meta_size(columns);
+
+    memset(chunk, 0, (size_t)off);
+
+    const struct
+    {
+        uint8_t type;
+        const void *src;
+    } header[SW_ARCHIVE_COL_PARAM] = {
+        {SW_ARCHIVE_U64, w->time},
+        {SW_ARCHIVE_U8, w->addr},
+        {SW_ARCHIVE_U8, w->user_app},
+        {SW_ARCHIVE_U16, w->apid},
+        {SW_ARCHIVE_U16, w->seq},
+        {SW_ARCHIVE_U16, w->length},
+    };
+
+    for (uint32_t c = 0; c < SW_ARCHIVE_COL_PARAM; c++)
+        off = sw_archive_encode(&cols[c], header[c].type, header[c].src, NULL, rows, chunk, off);
+    for (uint16_t p = 0; p < w->num_params; p++)
+        off = sw_archive_encode(&cols[SW_ARCHIVE_COL_PARAM + p],
+                                w->types[p],
+                                w->params[p],
+                                w->valid,
+                                rows,
+                                chunk,
+                                off);
+
+    sw_archive_chunk_t hdr;
+    hdr.magic = SW_ARCHIVE_MAGIC;
+    hdr.version = SW_ARCHIVE_VERSION;
+    hdr.apid = w->chunk_apid;
+    hdr.num_rows = rows;
+    hdr.num_columns = columns;
+    hdr.size = off;
+    hdr.t_min = UINT64_MAX;
+    hdr.t_max = 0;
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        hdr.t_min = w->time[i] < hdr.t_min ? w->time[i] : hdr.t_min;
+        hdr.t_max = w->time[i] > hdr.t_max ? w->time[i] : hdr.t_max;
+    }
+    memcpy(chunk, &hdr, sizeof(hdr));
+
+    *len = (size_t)off;
+    w->num_rows = 0;
+    return SW_OK;
+}
+
+/* ============================================================================
+ * READER
+ * ============================================================================ */
+
+/** @brief Whether the chunk at @p chunk, with @p avail octets, is complete. */
+static int sw_archive_check(const sw_archive_chunk_t *chunk, uint64_t avail)
+{
+    if (avail < sizeof(*chunk) || chunk->magic != SW_ARCHIVE_MAGIC ||
+        chunk->version != SW_ARCHIVE_VERSION)
+        return 0;
+    if (chunk->size > avail || chunk->size % SW_ARCHIVE_ALIGN != 0 ||
+        chunk->num_columns > 0xFFFFu || chunk->num_rows > SW_ARCHIVE_MAX_ROWS ||
+        chunk->size < sw_archive_meta_size(chunk->num_columns))
+        return 0;
+
+    const sw_archive_column_t *cols = (const sw_archive_column_t *)(chunk + 1);
+    for (uint32_t c = 0; c < chunk->num_columns; c++)
+    {
+        const sw_archive_column_t *d = &cols[c];
+        const uint64_t values = (uint64_t)chunk->num_rows * d->width;
+
+        if (d->type > SW_ARCHIVE_F64 || d->encoding > SW_ARCHIVE_FOR ||
+            d->null_count > chunk->num_rows)
+            return 0;
+        if ((d->validity | d->values) % SW_ARCHIVE_ALIGN != 0 ||
+            (d->null_count > 0) != (d->validity != 0))
+            return 0;
+        if (d->validity && d->validity + sw_archive_bitmap_size(chunk->num_rows) > chunk->size)
+            return 0;
+        if (d->encoding == SW_ARCHIVE_CONST)
+        {
+            if (d->width != 0 || d->values != 0)
+                return 0;
+            continue;
+        }
+        if (d->values == 0 || d->values + values > chunk->size)
+            return 0;
+        if (d->encoding == SW_ARCHIVE_PLAIN ? d->width != sw_archive_type_size(d->type)
+                                            : d->width != 1u && d->width != 2u && d->width != 4u)
+            return 0;
+    }
+    return 1;
+}
+
+sw_result_t sw_archive_open(sw_archive_reader_t *r, const void *image, size_t len)
+{
+    if (!r || (!image && len > 0))
+        return SW_INVALID_PARAM;
+    if (((uintptr_t)image & (SW_ARCHIVE_ALIGN - 1u)) != 0)
+        return SW_INVALID_PARAM;
+
+    r->image = image;
+    r->len = len;
+
+    if (len >= sizeof(uint32_t) && ((const sw_archive_chunk_t *)image)->magic != SW_ARCHIVE_MAGIC)
+        return SW_ERR;
+    return SW_OK;
+}
+
+const sw_archive_chunk_t *sw_archive_next(const sw_archive_reader_t *r,
+                                          const sw_archive_chunk_t *chunk)
+{
+    if (!r || !r->image)
+        return NULL;
+
+    const uint64_t off =
+        chunk ? (uint64_t)((const uint8_t *)chunk - r->image) + chunk->size : 0u;
+    if (off >= r->len)
+        return NULL;
+
+    const sw_archive_chunk_t *next = (const sw_archive_chunk_t *)(const void *)(r->image + off);
+    return sw_archive_check(next, r->len - off) ? next : NULL;
+}
+
+const sw_archive_column_t *sw_archive_column(const sw_archive_chunk_t *chunk, uint32_t index)
+{
+    if (!chunk || index >= chunk->num_columns)
+        return NULL;
+    return &((const sw_archive_column_t *)(chunk + 1))[index];
+}
+
+const void *sw_archive_values(const sw_archive_chunk_t *chunk, const sw_archive_column_t *col)
+{
+    if (!chunk || !col || col->encoding != SW_ARCHIVE_PLAIN)
+        return NULL;
+    return (const uint8_t *)chunk + col->values;
+}
+
+const uint8_t *sw_archive_validity(const sw_archive_chunk_t *chunk,
+                                   const sw_archive_column_t *col)
+{
+    if (!chunk || !col || col->validity == 0)
+        return NULL;
+    return (const uint8_t *)chunk + col->validity;
+}
+
+sw_result_t sw_archive_read(const sw_archive_chunk_t *chunk,
+                            const sw_archive_column_t *col,
+                            uint32_t first,
+                            uint32_t n,
+                            void *out)
+{
+    if (!chunk || !col || (!out && n > 0))
+        return SW_INVALID_PARAM;
+    if (first > chunk->num_rows || n > chunk->num_rows - first)
+        return SW_INVALID_PARAM;
+
+    const size_t size = sw_archive_type_size(col->type);
+    const uint8_t *in = (const uint8_t *)chunk + col->values;
+    uint8_t *dst = out;
+
+    if (col->encoding == SW_ARCHIVE_PLAIN)
+    {
+        memcpy(dst, in + (size_t)first * size, (size_t)n * size);
+        return SW_OK;
+    }
+
+    /* Widen a batch of stored offsets, add the reference, then narrow to the
+     * column type; each step is a simple loop over the batch. */
+    const uint64_t base = sw_archive_unkey(col->base, col->type);
+    uint64_t v[SW_ARCHIVE_BATCH];
+
+    for (uint32_t done = 0; done < n; done += SW_ARCHIVE_BATCH)
+    {
+        const uint32_t m = n - done < SW_ARCHIVE_BATCH ? n - done : SW_ARCHIVE_BATCH;
+        const uint32_t row = first + done;
+
+        switch (col->width)
+        {
+        case 1:
+            for (uint32_t i = 0; i < m; i++)
+                v[i] = in[row + i];
+            break;
+        case 2:
+            for (uint32_t i = 0; i < m; i++)
+            {
+                uint16_t x;
+                memcpy(&x, in + 2u * (row + i), sizeof(x));
+                v[i] = x;
+            }
+            break;
+        case 4:
+            for (uint32_t i = 0; i < m; i++)
+            {
+                uint32_t x;
+                memcpy(&x, in + 4u * (row + i), sizeof(x));
+                v[i] = x;
+            }
+            break;
+        default:
+            memset(v, 0, m * sizeof(v[0]));
+            break;
+        }
+
+        for (uint32_t i = 0; i < m; i++)
+            v[i] = sw_archive_unkey(base + v[i], col->type);
+
+        if (size == 1u)
+        {
+            for (uint32_t i = 0; i < m; i++)
+                dst[done + i] = (uint8_t)v[i];
+        }
+        else if (size == 2u)
+        {
+            for (uint32_t i = 0; i < m; i++)
+            {
+                const uint16_t x = (uint16_t)v[i];
+                memcpy(dst + 2u * (done + i), &x, sizeof(x));
+            }
+        }
+        else
+        {
+            memcpy(dst + 8u * (size_t)done, v, m * sizeof(v[0]));
+        }
+    }
+
+    return SW_OK;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file spacewire_atomic.h
+ * @brief Internal atomic helpers for the lock-free components.
+ *
+ * Thin wrappers over the GCC/Clang `__atomic` builtins, which are available in
+ * C99 mode and work on memory shared between processes. Not part of the public
+ * API.
+ */
+
+#ifndef SPACEWIRE_ATOMIC_H
+#define SPACEWIRE_ATOMIC_H
+
+#if !defined(__GNUC__)
+#    error "the lock-free components require the GCC/Clang __atomic builtins"
+#endif
+
+#define SW_ATOMIC_LOAD_RELAXED(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define SW_ATOMIC_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SW_ATOMIC_STORE_RELAXED(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define SW_ATOMIC_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define SW_ATOMIC_FETCH_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+#define SW_ATOMIC_FETCH_ADD_RELAXED(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define SW_ATOMIC_CAS(p, expected, desired)                                                        \
+    __atomic_compare_exchange_n((p), (expected), (desired), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define SW_ATOMIC_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define SW_ATOMIC_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define SW_ATOMIC_FENCE_SEQ_CST() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif /* SPACEWIRE_ATOMIC_H */
@@ -0,0 +1,432 @@
+/**
+ * @file spacewire_capidx.c
+ * @brief Time and APID / logical-address index for long packet captures.
+ */
+
+#include "../include/spacewire_capidx.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/** @brief Key index of a packet without an APID or logical address. */
+#define SW_CAPIDX_NO_KEY 0xFFFFu
+
+/** @brief Largest segment accepted by sw_capidx_writer_init(). */
+#define SW_CAPIDX_MAX_RECORDS (1u << 24)
+
+/* ============================================================================
+ * LAYOUT
+ * ============================================================================ */
+
+/** @brief Round @p n up to a multiple of 8. */
+static uint64_t sw_capidx_align(uint64_t n)
+{
+    return (n + 7u) & ~(uint64_t)7u;
+}
+
+/** @brief Octets of a segment with the given counts. */
+static uint64_t sw_capidx_segment_size(uint64_t records, uint64_t keys, uint64_t postings)
+{
+    return sw_capidx_align(sizeof(sw_capidx_segment_t) + records * sizeof(sw_capidx_record_t) +
+                           (keys + 1u) * sizeof(sw_capidx_key_t) + postings * sizeof(uint32_t));
+}
+
+/** @brief Query key of key index @p k (APIDs first, then addresses). */
+static uint32_t sw_capidx_key_of(uint32_t k)
+{
+    return k < 2048u ? SW_CAPIDX_APID(k) : SW_CAPIDX_ADDR(k - 2048u);
+}
+
+size_t sw_capidx_flush_bound(uint32_t max_records)
+{
+    const uint64_t keys = 2u * (uint64_t)max_records < SW_CAPIDX_NUM_KEYS
+                              ? 2u * (uint64_t)max_records
+                              : SW_CAPIDX_NUM_KEYS;
+
+    return (size_t)(sizeof(sw_capidx_file_header_t) +
+                    sw_capidx_segment_size(max_records, keys, 2u * (uint64_t)max_records));
+}
+
+/* ============================================================================
+ * WRITER
+ * ============================================================================ */
+
+sw_result_t sw_capidx_writer_init(sw_capidx_writer_t *w,
+                                  sw_capidx_record_t *records,
+                                  uint16_t *keys,
+                                  uint32_t max_records,
+                                  sw_capidx_dirent_t *dir,
+                                  uint32_t max_segments)
+{
+    if (!w || !records || !keys || max_records == 0 || max_records > SW_CAPIDX_MAX_RECORDS)
+        return SW_INVALID_PARAM;
+
+    memset(w, 0, sizeof(*w));
+    w->records = records;
+    w->keys = keys;
+    w->max_records = max_records;
+    w->dir = dir;
+    w->max_segments = dir ? max_segments : 0;
+
+    return SW_OK;
+}
+
+sw_result_t sw_capidx_add(sw_capidx_writer_t *w,
+                          uint64_t time,
+                          uint64_t offset,
+                          const uint8_t *pkt,
+                          size_t len)
+{
+    if (!w || (!pkt && len > 0))
+        return SW_INVALID_PARAM;
+    if (time < w->last_time)
+        return SW_INVALID_PARAM;
+    if (w->finished || w->num_records >= w->max_records)
+        return SW_ERR;
+
+    uint16_t apid = SW_CAPIDX_NO_KEY;
+    uint16_t addr = SW_CAPIDX_NO_KEY;
+
+    size_t i = 0;
+    while (i < len && pkt[i] <= SW_PATH_ADDR_MAX)
+        i++;
+
+    if (i < len)
+    {
+        /* [addr | 0x02 | 0x00 | user app | primary header ...]; APID in octets 4-5. */
+        const uint8_t *ptp = &pkt[i];
+        addr = (uint16_t)(2048u + ptp[0]);
+        if (len - i >= SW_PTP_HEADER_LEN + 2u && ptp[1] == SW_PTP_PROTOCOL_ID)
+            apid = (uint16_t)(((ptp[4] & 0x07u) << 8) | ptp[5]);
+    }
+
+    const uint32_t n = w->num_records++;
+    w->records[n].time = time;
+    w->records[n].offset = offset;
+    w->keys[2u * n] = apid;
+    w->keys[2u * n + 1u] = addr;
+    w->last_time = time;
+
+    return SW_OK;
+}
+
+sw_result_t sw_capidx_flush(sw_capidx_writer_t *w, void *buf, size_t size, size_t *len)
+{
+    if (!w || !buf || !len)
+        return SW_INVALID_PARAM;
+
+    *len = 0;
+    if (w->finished)
+        return SW_ERR;
+
+    uint8_t *out = (uint8_t *)buf;
+    const uint32_t n = w->num_records;
+    const size_t head = w->written == 0 ? sizeof(sw_capidx_file_header_t) : 0;
+
+    /* Counting sort of the postings by key. */
+    uint32_t num_keys = 0;
+    uint32_t num_postings = 0;
+    memset(w->counts, 0, sizeof(w->counts));
+    for (uint32_t i = 0; i < 2u * n; i++)
+    {
+        if (w->keys[i] != SW_CAPIDX_NO_KEY)
+        {
+            if (w->counts[w->keys[i]]++ == 0)
+                num_keys++;
+            num_postings++;
+        }
+    }
+
+    const uint64_t seg_size = n > 0 ? sw_capidx_segment_size(n, num_keys, num_postings) : 0;
+    if (head + seg_size > size)
+        return SW_ERR;
+
+    if (head > 0)
+    {
+        const sw_capidx_file_header_t fh = {SW_CAPIDX_MAGIC, SW_CAPIDX_VERSION, 0};
+        memcpy(out, &fh, sizeof(fh));
+    }
+
+    if (n > 0)
+    {
+        uint8_t *seg = out + head;
+        const sw_capidx_segment_t h = {SW_CAPIDX_SEGMENT_MAGIC,
+                                       n,
+                                       num_keys,
+                                       num_postings,
+                                       seg_size,
+                                       w->records[0].time,
+                                       w->records[n - 1u].time};
+        memcpy(seg, &h, sizeof(h));
+
+        uint8_t *p = seg + sizeof(h);
+        memcpy(p, w->records, (size_t)n * sizeof(sw_capidx_record_t));
+        p += (size_t)n * sizeof(sw_capidx_record_t);
+
+        /* Key directory, turning each count into the key's next posting. */
+        sw_capidx_key_t *dir = (sw_capidx_key_t *)(void *)p;
+        uint32_t start = 0;
+        for (uint32_t k = 0; k < SW_CAPIDX_NUM_KEYS; k++)
+        {
+            if (w->counts[k] == 0)
+                continue;
+
+            const uint32_t count = w->counts[k];
+            dir->key = sw_capidx_key_of(k);
+            dir->start = start;
+            dir++;
+            w->counts[k] = start;
+            start += count;
+        }
+        dir->key = SW_CAPIDX_ANY;
+        dir->start = num_postings;
+
+        uint32_t *postings = (uint32_t *)(void *)(dir + 1);
+        for (uint32_t i = 0; i < 2u * n; i++)
+        {
+            if (w->keys[i] != SW_CAPIDX_NO_KEY)
+                postings[w->counts[w->keys[i]]++] = i / 2u;
+        }
+
+        const size_t used = (size_t)((uint8_t *)(postings + num_postings) - seg);
+        memset(seg + used, 0, (size_t)seg_size - used);
+
+        if (w->num_segments < w->max_segments)
+        {
+            sw_capidx_dirent_t *d = &w->dir[w->num_segments++];
+            d->t_first = h.t_first;
+            d->t_last = h.t_last;
+            d->offset = w->written + head;
+        }
+        else
+        {
+            w->dir_overflow = 1;
+        }
+    }
+
+    *len = head + (size_t)seg_size;
+    w->written += *len;
+    w->num_records = 0;
+
+    return SW_OK;
+}
+
+sw_result_t sw_capidx_finish(sw_capidx_writer_t *w, void *buf, size_t size, size_t *len)
+{
+    if (!w || !buf || !len)
+        return SW_INVALID_PARAM;
+
+    *len = 0;
+    if (w->finished)
+        return SW_ERR;
+
+    /* Everything must fit before anything is consumed. */
+    const uint32_t segments = w->num_segments + (w->num_records > 0 ? 1u : 0u);
+    const size_t tail = w->dir && !w->dir_overflow && segments <= w->max_segments
+                            ? segments * sizeof(sw_capidx_dirent_t) + sizeof(sw_capidx_trailer_t)
+                            : 0;
+    if (size < tail)
+        return SW_ERR;
+
+    size_t flushed = 0;
+    const sw_result_t r = sw_capidx_flush(w, buf, size - tail, &flushed);
+    if (r != SW_OK)
+        return r;
+
+    uint8_t *out = (uint8_t *)buf + flushed;
+    if (tail > 0)
+    {
+        const sw_capidx_trailer_t t = {SW_CAPIDX_TRAILER_MAGIC, w->num_segments, w->written};
+        memcpy(out, w->dir, (size_t)w->num_segments * sizeof(sw_capidx_dirent_t));
+        memcpy(out + (size_t)w->num_segments * sizeof(sw_capidx_dirent_t), &t, sizeof(t));
+    }
+
+    *len = flushed + tail;
+    w->written += tail;
+    w->finished = 1;
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * READER
+ * ============================================================================ */
+
+sw_result_t sw_capidx_open(sw_capidx_reader_t *r, const void *image, size_t len)
+{
+    if (!r || !image || ((uintptr_t)image & 7u) != 0)
+        return SW_INVALID_PARAM;
+
+    const sw_capidx_file_header_t *fh = (const sw_capidx_file_header_t *)image;
+    if (len < sizeof(*fh) || fh->magic != SW_CAPIDX_MAGIC || fh->version != SW_CAPIDX_VERSION)
+        return SW_ERR;
+
+    r->image = (const uint8_t *)image;
+    r->end = len;
+    r->dir = NULL;
+    r->num_segments = 0;
+
+    if (len % 8u == 0 && len >= sizeof(*fh) + sizeof(sw_capidx_trailer_t))
+    {
+        const sw_capidx_trailer_t *t =
+            (const sw_capidx_trailer_t *)(const void *)(r->image + len - sizeof(*t));
+        const uint64_t dir_end =
+            t->dir_offset + (uint64_t)t->num_segments * sizeof(sw_capidx_dirent_t);
+
+        if (t->magic == SW_CAPIDX_TRAILER_MAGIC && t->dir_offset >= sizeof(*fh) &&
+            t->dir_offset % 8u == 0 && dir_end == len - sizeof(*t))
+        {
+            r->dir = (const sw_capidx_dirent_t *)(const void *)(r->image + t->dir_offset);
+            r->num_segments = t->num_segments;
+            r->end = (size_t)t->dir_offset;
+        }
+    }
+
+    return SW_OK;
+}
+
+/** @brief The segment at @p offset, or NULL past the end or if it is torn. */
+static const sw_capidx_segment_t *sw_capidx_segment_at(const sw_capidx_reader_t *r,
+                                                       uint64_t offset)
+{
+    if (offset % 8u != 0 || offset + sizeof(sw_capidx_segment_t) > r->end)
+        return NULL;
+
+    const sw_capidx_segment_t *h = (const sw_capidx_segment_t *)(const void *)(r->image + offset);
+    if (h->magic != SW_CAPIDX_SEGMENT_MAGIC || h->num_records == 0 ||
+        h->num_keys > SW_CAPIDX_NUM_KEYS || h->size % 8u != 0 ||
+        h->size < sw_capidx_segment_size(h->num_records, h->num_keys, h->num_postings) ||
+        h->size > r->end - offset)
+        return NULL;
+
+    return h;
+}
+
+/**
+ * @brief Entry @p i of a segment's record list, or of a posting list into it.
+ *
+ * A corrupt posting is clamped into the segment rather than trusted.
+ */
+static const sw_capidx_record_t *sw_capidx_entry(const sw_capidx_segment_t *h,
+                                                 const uint32_t *postings,
+                                                 uint32_t i)
+{
+    const sw_capidx_record_t *records = (const sw_capidx_record_t *)(h + 1);
+
+    if (!postings)
+        return &records[i];
+    return &records[postings[i] < h->num_records ? postings[i] : 0u];
+}
+
+size_t sw_capidx_query(const sw_capidx_reader_t *r,
+                       uint32_t key,
+                       uint64_t t_begin,
+                       uint64_t t_end,
+                       sw_capidx_cursor_t *cursor,
+                       sw_capidx_record_t *out,
+                       size_t max)
+{
+    if (!r || !cursor || !out || max == 0 || t_begin >= t_end)
+        return 0;
+
+    uint64_t seg = cursor->segment;
+    uint32_t pos = cursor->pos;
+    size_t n = 0;
+
+    if (seg == 0)
+    {
+        /* Sparse time index: the first segment ending at or after t_begin. */
+        seg = sizeof(sw_capidx_file_header_t);
+        if (r->dir)
+        {
+            uint32_t lo = 0;
+            uint32_t hi = r->num_segments;
+            while (lo < hi)
+            {
+                const uint32_t mid = lo + (hi - lo) / 2u;
+                if (r->dir[mid].t_last < t_begin)
+                    lo = mid + 1u;
+                else
+                    hi = mid;
+            }
+            seg = lo < r->num_segments ? r->dir[lo].offset : r->end;
+        }
+        pos = 0;
+    }
+
+    const sw_capidx_segment_t *h;
+    while (n < max && (h = sw_capidx_segment_at(r, seg)) != NULL)
+    {
+        if (h->t_first >= t_end)
+            break;
+
+        if (h->t_last >= t_begin)
+        {
+            const sw_capidx_record_t *records = (const sw_capidx_record_t *)(h + 1);
+            const sw_capidx_key_t *keys = (const sw_capidx_key_t *)(records + h->num_records);
+            const uint32_t *postings = NULL;
+            uint32_t count = h->num_records;
+
+            if (key != SW_CAPIDX_ANY)
+            {
+                uint32_t lo = 0;
+                uint32_t hi = h->num_keys;
+                while (lo < hi)
+                {
+                    const uint32_t mid = lo + (hi - lo) / 2u;
+                    if (keys[mid].key < key)
+                        lo = mid + 1u;
+                    else
+                        hi = mid;
+                }
+
+                count = 0;
+                if (lo < h->num_keys && keys[lo].key == key &&
+                    keys[lo].start <= keys[lo + 1u].start &&
+                    keys[lo + 1u].start <= h->num_postings)
+                {
+                    postings = (const uint32_t *)(keys + h->num_keys + 1u) + keys[lo].start;
+                    count = keys[lo + 1u].start - keys[lo].start;
+                }
+            }
+
+            /* Records are in time order, so every list is too. */
+            uint32_t lo = 0;
+            uint32_t hi = count;
+            while (lo < hi)
+            {
+                const uint32_t mid = lo + (hi - lo) / 2u;
+                if (sw_capidx_entry(h, postings, mid)->time < t_begin)
+                    lo = mid + 1u;
+                else
+                    hi = mid;
+            }
+
+            for (uint32_t i = pos > lo ? pos : lo; i < count; i++)
+            {
+                const sw_capidx_record_t *rec = sw_capidx_entry(h, postings, i);
+                if (rec->time >= t_end)
+                {
+                    /* Nothing later can match. */
+                    cursor->segment = r->end;
+                    cursor->pos = 0;
+                    return n;
+                }
+                if (n == max)
+                {
+                    cursor->segment = seg;
+                    cursor->pos = i;
+                    return n;
+                }
+                out[n++] = *rec;
+            }
+        }
+
+        seg += h->size;
+        pos = 0;
+    }
+
+    cursor->segment = seg;
+    cursor->pos = pos;
+    return n;
+}
@@ -0,0 +1,287 @@
+/**
+ * @file spacewire_ckpt.c
+ * @brief Checkpoints of a simulated network, to branch runs from one state.
+ */
+
+#include "../include/spacewire_ckpt.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* ============================================================================
+ * LAYOUT
+ * ============================================================================ */
+
+/** @brief Round @p n up to a multiple of ::SW_CKPT_ALIGN. */
+static uint64_t sw_ckpt_align(uint64_t n)
+{
+    return (n + SW_CKPT_ALIGN - 1u) & ~(uint64_t)(SW_CKPT_ALIGN - 1u);
+}
+
+/** @brief Element size of each section in this build. */
+static const uint16_t sw_ckpt_struct_size[SW_CKPT_NUM_SECTIONS] = {
+    (uint16_t)sizeof(sw_net_node_t),
+    (uint16_t)sizeof(sw_net_link_t),
+    (uint16_t)sizeof(sw_sim_node_t),
+    (uint16_t)sizeof(sw_sim_event_t),
+    (uint16_t)SW_ROUTE_TABLE_SIZE,
+};
+
+/**
+ * @brief Lay out the sections of an image from its element counts.
+ * @return Total image size.
+ */
+static uint64_t sw_ckpt_layout(sw_ckpt_header_t *h)
+{
+    const uint64_t counts[SW_CKPT_NUM_SECTIONS] = {
+        h->num_nodes,
+        h->num_links,
+        h->num_nodes,
+        h->num_events,
+        (uint64_t)h->num_tables * h->num_nodes,
+    };
+    uint64_t offset = sw_ckpt_align(sizeof(sw_ckpt_header_t));
+
+    for (unsigned s = 0; s < SW_CKPT_NUM_SECTIONS; s++)
+    {
+        h->struct_size[s] = sw_ckpt_struct_size[s];
+        h->sections[s].offset = offset;
+        h->sections[s].size = counts[s] * sw_ckpt_struct_size[s];
+        offset = sw_ckpt_align(offset + h->sections[s].size);
+    }
+
+    return offset;
+}
+
+/**
+ * @brief FNV-1a over the 64-bit words of @p size octets, continuing @p h.
+ */
+static uint64_t sw_ckpt_fnv(uint64_t h, const uint8_t *p, uint64_t size)
+{
+    for (uint64_t i = 0; i < size; i += 8u)
+    {
+        uint64_t w = 0;
+        memcpy(&w, &p[i], sizeof(w));
+        h = (h ^ w) * 0x100000001B3u;
+    }
+
+    return h;
+}
+
+/**
+ * @brief Checksums of an image, its checksum fields counted as zero.
+ *
+ * FNV-1a over 64-bit words, folded to 32 bits; @p size is a multiple of
+ * ::SW_CKPT_ALIGN. @p full also covers the sections after the header.
+ */
+static uint32_t sw_ckpt_checksum(const uint8_t *image, uint64_t size, int full)
+{
+    sw_ckpt_header_t h;
+    memcpy(&h, image, sizeof(h));
+    h.checksum = 0;
+    h.header_checksum = 0;
+
+    uint64_t x = sw_ckpt_fnv(0xCBF29CE484222325u, (const uint8_t *)&h, sizeof(h));
+    if (full)
+        x = sw_ckpt_fnv(x, &image[sizeof(h)], size - sizeof(h));
+
+    return (uint32_t)(x ^ (x >> 32));
+}
+
+/**
+ * @brief Validate an image and read its header; @p full checks the sections
+ *        too.
+ * @return ::SW_OK or ::SW_ERR.
+ */
+static sw_result_t sw_ckpt_check(const void *image, size_t len, int full, sw_ckpt_header_t *h)
+{
+    if (len < sizeof(*h))
+        return SW_ERR;
+
+    memcpy(h, image, sizeof(*h));
+    if (h->magic != SW_CKPT_MAGIC || h->version != SW_CKPT_VERSION || h->image_size > len ||
+        h->num_tables > SW_SIM_MAX_TABLES || h->num_addrs > SW_ROUTE_TABLE_SIZE)
+        return SW_ERR;
+
+    sw_ckpt_header_t expect = *h;
+    if (sw_ckpt_layout(&expect) != h->image_size ||
+        memcmp(expect.struct_size, h->struct_size, sizeof(h->struct_size)) != 0 ||
+        memcmp(expect.sections, h->sections, sizeof(h->sections)) != 0)
+        return SW_ERR;
+
+    const uint32_t sum = sw_ckpt_checksum((const uint8_t *)image, h->image_size, full);
+    if (sum != (full ? h->checksum : h->header_checksum))
+        return SW_ERR;
+
+    return SW_OK;
+}
+
+/**
+ * @brief Restore the scalars of a network and simulator from a header.
+ */
+static void sw_ckpt_load_scalars(const sw_ckpt_header_t *h, sw_net_t *net, sw_sim_t *sim)
+{
+    net->num_nodes = h->num_nodes;
+    net->num_links = h->num_links;
+    memcpy(net->addr_node, h->addr_node, sizeof(net->addr_node));
+
+    memset(sim, 0, sizeof(*sim));
+    sim->net = net;
+    sim->num_events = h->num_events;
+    sim->overflows = h->overflows;
+    sim->seq = h->seq;
+    sim->now = h->now;
+    sim->num_tables = h->num_tables;
+    sim->num_addrs = h->num_addrs;
+    memcpy(sim->addrs, h->addrs, sizeof(sim->addrs));
+}
+
+/* ============================================================================
+ * SAVE AND RESTORE
+ * ============================================================================ */
+
+size_t sw_ckpt_size(const sw_sim_t *sim)
+{
+    if (!sim)
+        return 0;
+
+    sw_ckpt_header_t h;
+    memset(&h, 0, sizeof(h));
+    h.num_nodes = sim->net->num_nodes;
+    h.num_links = sim->net->num_links;
+    h.num_events = sim->num_events;
+    h.num_tables = sim->num_tables;
+
+    return (size_t)sw_ckpt_layout(&h);
+}
+
+sw_result_t sw_ckpt_save(const sw_sim_t *sim, void *buf, size_t size, size_t *len)
+{
+    if (!sim || !buf || !len || sim->owner || ((uintptr_t)buf % SW_CKPT_ALIGN) != 0)
+        return SW_INVALID_PARAM;
+
+    const sw_net_t *net = sim->net;
+    uint8_t *image = (uint8_t *)buf;
+    sw_ckpt_header_t h;
+
+    memset(&h, 0, sizeof(h));
+    h.magic = SW_CKPT_MAGIC;
+    h.version = SW_CKPT_VERSION;
+    h.num_nodes = net->num_nodes;
+    h.num_links = net->num_links;
+    h.num_tables = sim->num_tables;
+    h.num_addrs = sim->num_addrs;
+    h.num_events = sim->num_events;
+    h.overflows = sim->overflows;
+    h.seq = sim->seq;
+    h.now = sim->now;
+    memcpy(h.addr_node, net->addr_node, sizeof(h.addr_node));
+    memcpy(h.addrs, sim->addrs, sizeof(h.addrs));
+    h.image_size = sw_ckpt_layout(&h);
+
+    if (h.image_size > size)
+        return SW_ERR;
+
+    /* Zero the padding too, so equal states give equal images. */
+    memset(image, 0, (size_t)h.image_size);
+
+    const size_t table_size = (size_t)net->num_nodes * SW_ROUTE_TABLE_SIZE;
+    const void *src[SW_CKPT_NUM_SECTIONS] = {net->nodes, net->links, sim->nodes, sim->events, NULL};
+
+    for (unsigned s = 0; s < SW_CKPT_TABLES; s++)
+        memcpy(&image[h.sections[s].offset], src[s], (size_t)h.sections[s].size);
+
+    /* Routers sharing a table are saved with a copy of it each, as the
+     * shared table lives outside the network. */
+    sw_net_node_t *nodes = (sw_net_node_t *)(void *)&image[h.sections[SW_CKPT_NODES].offset];
+    for (uint16_t n = 0; n < net->num_nodes; n++)
+        sw_router_copy(&nodes[n].router, &net->nodes[n].router);
+
+    for (uint16_t t = 0; t < sim->num_tables; t++)
+        memcpy(&image[h.sections[SW_CKPT_TABLES].offset + t * table_size],
+               sim->tables[t],
+               table_size);
+
+    memcpy(image, &h, sizeof(h));
+    h.checksum = sw_ckpt_checksum(image, h.image_size, 1);
+    h.header_checksum = sw_ckpt_checksum(image, h.image_size, 0);
+    memcpy(image, &h, sizeof(h));
+
+    *len = (size_t)h.image_size;
+    return SW_OK;
+}
+
+sw_result_t sw_ckpt_restore(const void *image,
+                            size_t len,
+                            const sw_ckpt_storage_t *storage,
+                            sw_net_t *net,
+                            sw_sim_t *sim)
+{
+    if (!image || !storage || !net || !sim || !storage->nodes || !storage->links ||
+        !storage->sim_nodes || !storage->events || storage->max_events == 0)
+        return SW_INVALID_PARAM;
+
+    sw_ckpt_header_t h;
+    if (sw_ckpt_check(image, len, 1, &h) != SW_OK || h.num_nodes > storage->max_nodes ||
+        h.num_links > storage->max_links || h.num_events > storage->max_events ||
+        h.num_tables > storage->max_tables || (h.num_tables > 0 && !storage->tables))
+        return SW_ERR;
+
+    const uint8_t *in = (const uint8_t *)image;
+    void *dst[SW_CKPT_NUM_SECTIONS] = {
+        storage->nodes, storage->links, storage->sim_nodes, storage->events, storage->tables};
+
+    for (unsigned s = 0; s < SW_CKPT_NUM_SECTIONS; s++)
+    {
+        if (h.sections[s].size > 0)
+            memcpy(dst[s], &in[h.sections[s].offset], (size_t)h.sections[s].size);
+    }
+
+    net->nodes = storage->nodes;
+    net->links = storage->links;
+    net->max_nodes = storage->max_nodes;
+    net->max_links = storage->max_links;
+    sw_ckpt_load_scalars(&h, net, sim);
+
+    sim->nodes = storage->sim_nodes;
+    sim->events = storage->events;
+    sim->max_events = storage->max_events;
+    for (uint16_t t = 0; t < h.num_tables; t++)
+        sim->tables[t] = &storage->tables[(size_t)t * h.num_nodes * SW_ROUTE_TABLE_SIZE];
+
+    return SW_OK;
+}
+
+sw_result_t sw_ckpt_attach(void *image,
+                           size_t len,
+                           sw_sim_event_t *events,
+                           uint32_t max_events,
+                           sw_net_t *net,
+                           sw_sim_t *sim)
+{
+    if (!image || !events || max_events == 0 || !net || !sim ||
+        ((uintptr_t)image % SW_CKPT_ALIGN) != 0)
+        return SW_INVALID_PARAM;
+
+    sw_ckpt_header_t h;
+    if (sw_ckpt_check(image, len, 0, &h) != SW_OK || h.num_events > max_events)
+        return SW_ERR;
+
+    uint8_t *in = (uint8_t *)image;
+    memcpy(events, &in[h.sections[SW_CKPT_EVENTS].offset], (size_t)h.sections[SW_CKPT_EVENTS].size);
+
+    net->nodes = (sw_net_node_t *)(void *)&in[h.sections[SW_CKPT_NODES].offset];
+    net->links = (sw_net_link_t *)(void *)&in[h.sections[SW_CKPT_LINKS].offset];
+    net->max_nodes = h.num_nodes;
+    net->max_links = h.num_links;
+    sw_ckpt_load_scalars(&h, net, sim);
+
+    sim->nodes = (sw_sim_node_t *)(void *)&in[h.sections[SW_CKPT_SIM_NODES].offset];
+    sim->events = events;
+    sim->max_events = max_events;
+    for (uint16_t t = 0; t < h.num_tables; t++)
+        sim->tables[t] = &in[h.sections[SW_CKPT_TABLES].offset +
+                             (size_t)t * h.num_nodes * SW_ROUTE_TABLE_SIZE];
+
+    return SW_OK;
+}
@@ -0,0 +1,282 @@
+/**
+ * @file spacewire_decom.c
+ * @brief Compiled telemetry decommutation of CCSDS packet data fields.
+ */
+
+#include "../include/spacewire_decom.h"
+
+#include <string.h>
+
+/* Op kinds: the value type, a byte swap, and a field spanning nine octets. */
+#define SW_DECOM_KIND_UINT 0u
+#define SW_DECOM_KIND_INT 1u
+#define SW_DECOM_KIND_F32 2u
+#define SW_DECOM_KIND_F64 3u
+#define SW_DECOM_KIND_TYPE 3u
+#define SW_DECOM_KIND_SWAP 4u
+#define SW_DECOM_KIND_WIDE 8u
+
+/** @brief Rows the batch loops are padded to; a multiple of any vector width. */
+#define SW_DECOM_LANES 8u
+
+/* ============================================================================
+ * COMPILATION
+ * ============================================================================ */
+
+sw_result_t sw_decom_compile(sw_decom_plan_t *plan,
+                             uint16_t apid,
+                             const sw_decom_param_t *params,
+                             uint16_t num_params,
+                             sw_decom_word_t *words,
+                             sw_decom_op_t *ops)
+{
+    if (!plan || !params || num_params == 0 || !words || !ops)
+        return SW_INVALID_PARAM;
+
+    uint32_t min_len = 0;
+
+    for (uint16_t i = 0; i < num_params; i++)
+    {
+        const sw_decom_param_t *p = &params[i];
+        const uint32_t end = (p->bit_offset + p->width + 7u) / 8u;
+
+        if (p->width == 0 || p->width > 64u || p->bit_offset / 8u + 9u > 0x10000u ||
+            end > 0xFFFFu || p->type > SW_DECOM_FLOAT || p->endian > SW_DECOM_LITTLE)
+            return SW_INVALID_PARAM;
+        if (p->endian == SW_DECOM_LITTLE && (p->bit_offset % 8u != 0 || p->width % 8u != 0))
+            return SW_INVALID_PARAM;
+        if (p->type == SW_DECOM_FLOAT && p->width != 32u && p->width != 64u)
+            return SW_INVALID_PARAM;
+
+        if (end > min_len)
+            min_len = end;
+
+        /* Insertion by bit offset; the definitions are compiled once. */
+        uint16_t j = i;
+        while (j > 0 && params[ops[j - 1u].param].bit_offset > p->bit_offset)
+        {
+            ops[j] = ops[j - 1u];
+            j--;
+        }
+        ops[j].param = i;
+    }
+
+    /* Open a word at the first parameter that does not fit the current one. */
+    uint16_t num_words = 0;
+    for (uint16_t i = 0; i < num_params; i++)
+    {
+        sw_decom_op_t *op = &ops[i];
+        const sw_decom_param_t *p = &params[op->param];
+
+        if (num_words == 0 ||
+            p->bit_offset + p->width > words[num_words - 1u].octet * 8u + 64u)
+        {
+            words[num_words].octet = (uint16_t)(p->bit_offset / 8u);
+            words[num_words].first_op = i;
+            words[num_words].num_ops = 0;
+            num_words++;
+        }
+
+        sw_decom_word_t *w = &words[num_words - 1u];
+        const uint32_t rel = p->bit_offset - w->octet * 8u;
+        w->num_ops++;
+
+        op->width = p->width;
+        op->mask = p->width == 64u ? UINT64_MAX : (((uint64_t)1 << p->width) - 1u);
+        op->kind = p->type == SW_DECOM_UINT  ? SW_DECOM_KIND_UINT
+                   : p->type == SW_DECOM_INT ? SW_DECOM_KIND_INT
+                   : p->width == 32u         ? SW_DECOM_KIND_F32
+                                             : SW_DECOM_KIND_F64;
+        if (p->endian == SW_DECOM_LITTLE)
+            op->kind |= SW_DECOM_KIND_SWAP;
+
+        if (rel + p->width <= 64u)
+        {
+            op->shift = (uint8_t)(64u - rel - p->width);
+        }
+        else
+        {
+            /* Only the word's first parameter can overhang, by < 8 bits. */
+            op->shift = (uint8_t)rel;
+            op->kind |= SW_DECOM_KIND_WIDE;
+        }
+    }
+
+    plan->words = words;
+    plan->ops = ops;
+    plan->num_words = num_words;
+    plan->num_params = num_params;
+    plan->apid = (uint16_t)(apid & 0x7FFu);
+    plan->min_len = min_len;
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * EXTRACTION
+ * ============================================================================ */
+
+/** @brief Big-endian 64-bit window at @p p, all eight octets present. */
+static uint64_t sw_decom_load8(const uint8_t *p)
+{
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) |
+           ((uint64_t)p[3] << 32) | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+/** @brief Big-endian 64-bit window at @p octet, zero-filled past @p len. */
+static uint64_t sw_decom_load(const uint8_t *data, uint32_t len, uint32_t octet)
+{
+    const uint8_t *p = data + octet;
+
+    if (len >= octet + 8u)
+        return sw_decom_load8(p);
+
+    uint64_t w = 0;
+    for (uint32_t i = 0; i < 8u; i++)
+        w = (w << 8) | (octet + i < len ? p[i] : 0u);
+    return w;
+}
+
+static uint64_t sw_decom_bswap(uint64_t v)
+{
+    return ((v & 0x00000000000000FFull) << 56) | ((v & 0x000000000000FF00ull) << 40) |
+           ((v & 0x0000000000FF0000ull) << 24) | ((v & 0x00000000FF000000ull) << 8) |
+           ((v & 0x000000FF00000000ull) >> 8) | ((v & 0x0000FF0000000000ull) >> 24) |
+           ((v & 0x00FF000000000000ull) >> 40) | ((v & 0xFF00000000000000ull) >> 56);
+}
+
+/**
+ * @brief Convert @p count raw field values and copy the first @p m to
+ *        @p column at row @p base.
+ *
+ * @p count is @p m rounded up to whole lanes, so that vectorised loops need
+ * no scalar remainder; rows past @p m are padding.
+ */
+static void sw_decom_store(const sw_decom_op_t *op,
+                           uint64_t *v,
+                           size_t m,
+                           size_t count,
+                           void *column,
+                           size_t base)
+{
+    if (op->kind & SW_DECOM_KIND_SWAP)
+    {
+        const unsigned drop = 64u - op->width;
+        for (size_t i = 0; i < count; i++)
+            v[i] = sw_decom_bswap(v[i]) >> drop;
+    }
+
+    switch (op->kind & SW_DECOM_KIND_TYPE)
+    {
+    case SW_DECOM_KIND_INT:
+    {
+        /* Sign extension; the column takes the two's-complement bits. */
+        const uint64_t sign = (uint64_t)1 << (op->width - 1u);
+        for (size_t i = 0; i < count; i++)
+            v[i] = (v[i] ^ sign) - sign;
+        break;
+    }
+
+    case SW_DECOM_KIND_F32:
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint32_t bits = (uint32_t)v[i];
+            float f;
+            double d;
+            memcpy(&f, &bits, sizeof(f));
+            d = (double)f;
+            memcpy(&v[i], &d, sizeof(d));
+        }
+        break;
+
+    default:
+        /* Unsigned integers and doubles are stored as extracted. */
+        break;
+    }
+
+    memcpy((uint64_t *)column + base, v, m * sizeof(*v));
+}
+
+size_t sw_decom_run(const sw_decom_plan_t *plan,
+                    const sw_packet_frame_t *frames,
+                    size_t n,
+                    void *const *columns,
+                    uint8_t *valid)
+{
+    if (!plan || !frames || !columns)
+        return 0;
+
+    uint64_t w[SW_DECOM_BATCH];
+    uint64_t v[SW_DECOM_BATCH];
+    uint8_t ok[SW_DECOM_BATCH];
+    size_t rows = 0;
+
+    for (size_t base = 0; base < n; base += SW_DECOM_BATCH)
+    {
+        const size_t m = n - base < SW_DECOM_BATCH ? n - base : SW_DECOM_BATCH;
+        const size_t count = (m + SW_DECOM_LANES - 1u) & ~(size_t)(SW_DECOM_LANES - 1u);
+        const sw_packet_frame_t *f = &frames[base];
+
+        for (size_t i = 0; i < m; i++)
+        {
+            ok[i] = (uint8_t)(f[i].packet.ph.apid == plan->apid && f[i].packet.data &&
+                              f[i].packet.data_len >= plan->min_len);
+            rows += ok[i];
+            if (valid)
+                valid[base + i] = ok[i];
+        }
+        for (size_t i = m; i < count; i++)
+            ok[i] = 0;
+
+        for (uint16_t wi = 0; wi < plan->num_words; wi++)
+        {
+            const sw_decom_word_t *word = &plan->words[wi];
+
+            /* Gather the window of every packet, then run the word's ops. A
+             * window inside min_len needs no bounds check for valid rows. */
+            if (word->octet + 8u <= plan->min_len)
+            {
+                for (size_t i = 0; i < count; i++)
+                    w[i] = ok[i] ? sw_decom_load8(f[i].packet.data + word->octet) : 0;
+            }
+            else
+            {
+                for (size_t i = 0; i < count; i++)
+                    w[i] = ok[i] ? sw_decom_load(f[i].packet.data,
+                                                 f[i].packet.data_len,
+                                                 word->octet)
+                                 : 0;
+            }
+
+            for (uint16_t k = 0; k < word->num_ops; k++)
+            {
+                const sw_decom_op_t *op = &plan->ops[word->first_op + k];
+
+                if (op->kind & SW_DECOM_KIND_WIDE)
+                {
+                    /* The ninth octet holds the field's last bits. */
+                    const uint32_t rest = word->octet + 8u;
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        const uint64_t last =
+                            ok[i] && rest < f[i].packet.data_len ? f[i].packet.data[rest] : 0u;
+                        v[i] = ((w[i] << op->shift) | (last >> (8u - op->shift))) >>
+                               (64u - op->width);
+                    }
+                }
+                else
+                {
+                    const uint64_t mask = op->mask;
+                    const unsigned shift = op->shift;
+                    for (size_t i = 0; i < count; i++)
+                        v[i] = (w[i] >> shift) & mask;
+                }
+
+                sw_decom_store(op, v, m, count, columns[op->param], base);
+            }
+        }
+    }
+
+    return rows;
+}
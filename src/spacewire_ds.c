@@ -0,0 +1,508 @@
+/**
+ * @file spacewire_ds.c
+ * @brief Software data-strobe character decoder for captured link waveforms.
+ *
+ * Per 64-sample word, x = D ^ S and the bit starts are the samples where x
+ * differs from the sample before: edges = x ^ (x << 1 | carry). The bits are
+ * the D samples at the edges, gathered with PEXT where the target has BMI2
+ * and by walking the edges otherwise (and always when characters are
+ * reported, to note each bit's sample). Bits queue in a 64-bit accumulator,
+ * oldest first, and characters are cut from its low end: a parity bit, a
+ * flag, and 8 or 2 more bits.
+ */
+
+#include "../include/spacewire_ds.h"
+
+#include <string.h>
+
+#if defined(__BMI2__)
+#    include <immintrin.h>
+#endif
+
+/** @brief Control codes: the two bits after the flag, first sent in bit 0. */
+enum
+{
+    SW_DS_CODE_FCT = 0,
+    SW_DS_CODE_EEP = 1,
+    SW_DS_CODE_EOP = 2,
+    SW_DS_CODE_ESC = 3
+};
+
+/** @brief NULL (ESC FCT) in the low eight bits, the first parity bit masked off. */
+#define SW_DS_NULL_BITS 0x2Eu
+#define SW_DS_NULL_MASK 0xFEu
+
+/** @brief Parity of the low eight bits. */
+static uint8_t sw_ds_parity8(uint32_t v)
+{
+    v ^= v >> 4;
+    v ^= v >> 2;
+    v ^= v >> 1;
+    return (uint8_t)(v & 1u);
+}
+
+/** @brief Index of the lowest set bit of a non-zero word. */
+static unsigned sw_ds_ctz(uint64_t v)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(v);
+#else
+    unsigned n = 0;
+    while (!(v & 1u))
+    {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/** @brief Index of the highest set bit of a non-zero word. */
+static unsigned sw_ds_msb(uint64_t v)
+{
+#if defined(__GNUC__)
+    return 63u - (unsigned)__builtin_clzll(v);
+#else
+    unsigned n = 0;
+    while (v >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+/* ============================================================================
+ * CHARACTERS
+ * ============================================================================ */
+
+/** @brief Report a character or event to the debug callback. */
+static void sw_ds_emit(const sw_ds_decoder_t *dec,
+                       sw_ds_char_type_t type,
+                       uint64_t sample,
+                       uint8_t value)
+{
+    if (dec->config.on_char)
+    {
+        const sw_ds_char_t ch = {.sample = sample, .type = (uint8_t)type, .value = value};
+        dec->config.on_char(dec->config.ctx, &ch);
+    }
+}
+
+/** @brief Sample of the oldest bit in the accumulator (0 without on_char). */
+static uint64_t sw_ds_bit_sample(const sw_ds_decoder_t *dec)
+{
+    return dec->config.on_char ? dec->bit_sample[dec->parsed % 128u] : 0;
+}
+
+/** @brief Drop @p n bits from the accumulator. */
+static void sw_ds_consume(sw_ds_decoder_t *dec, unsigned n)
+{
+    dec->acc = n >= 64u ? 0 : dec->acc >> n;
+    dec->nbits = (uint8_t)(dec->nbits - n);
+    dec->parsed += n;
+}
+
+/** @brief Hand the packet received so far to sw_packet_decode() and the callback. */
+static void sw_ds_end_packet(sw_ds_decoder_t *dec, sw_end_marker_t end)
+{
+    if (dec->oversize)
+    {
+        dec->stats.packets_oversize++;
+    }
+    else if (dec->len > 0)
+    {
+        sw_packet_frame_t pf;
+        sw_ptp_status_t status = SW_PTP_STATUS_OK;
+        const sw_result_t r = sw_packet_decode(&pf, dec->config.buf, dec->len, end, &status);
+
+        dec->stats.packets++;
+        if (r == SW_OK)
+            dec->stats.packets_ok++;
+        if (dec->config.on_packet)
+            dec->config.on_packet(dec->config.ctx, &pf, r, status, dec->config.buf, dec->len, end);
+    }
+
+    dec->len = 0;
+    dec->oversize = 0;
+}
+
+/**
+ * @brief Report an error, end any packet in progress with an EEP and wait
+ *        for the next NULL.
+ */
+static void sw_ds_lose_sync(sw_ds_decoder_t *dec, sw_ds_char_type_t type, uint64_t sample)
+{
+    sw_ds_emit(dec, type, sample, 0);
+    if (dec->len > 0 || dec->oversize)
+        sw_ds_end_packet(dec, SW_END_EEP);
+    dec->synced = 0;
+    dec->escape = 0;
+}
+
+/** @brief Handle a control character. */
+static void sw_ds_control(sw_ds_decoder_t *dec, unsigned code, uint64_t sample)
+{
+    if (dec->escape)
+    {
+        dec->escape = 0;
+        if (code == SW_DS_CODE_FCT)
+        {
+            dec->stats.nulls++;
+            sw_ds_emit(dec, SW_DS_NULL, dec->esc_sample, 0);
+        }
+        else
+        {
+            dec->stats.escape_errors++;
+            sw_ds_lose_sync(dec, SW_DS_ESC_ERROR, dec->esc_sample);
+        }
+        return;
+    }
+
+    switch (code)
+    {
+    case SW_DS_CODE_FCT:
+        dec->stats.fcts++;
+        sw_ds_emit(dec, SW_DS_FCT, sample, 0);
+        break;
+    case SW_DS_CODE_ESC:
+        dec->escape = 1;
+        dec->esc_sample = sample;
+        break;
+    case SW_DS_CODE_EOP:
+        dec->stats.eops++;
+        sw_ds_emit(dec, SW_DS_EOP, sample, 0);
+        sw_ds_end_packet(dec, SW_END_EOP);
+        break;
+    default:
+        dec->stats.eeps++;
+        sw_ds_emit(dec, SW_DS_EEP, sample, 0);
+        sw_ds_end_packet(dec, SW_END_EEP);
+        break;
+    }
+}
+
+/** @brief Handle a data character: packet octet, or time-code after an ESC. */
+static void sw_ds_data(sw_ds_decoder_t *dec, uint8_t value, uint64_t sample)
+{
+    if (dec->escape)
+    {
+        dec->escape = 0;
+        dec->stats.time_codes++;
+        sw_ds_emit(dec, SW_DS_TIME_CODE, dec->esc_sample, value);
+        return;
+    }
+
+    dec->stats.data++;
+    sw_ds_emit(dec, SW_DS_DATA, sample, value);
+    if (dec->len < dec->config.cap)
+        dec->config.buf[dec->len++] = value;
+    else
+        dec->oversize = 1;
+}
+
+/** @brief Cut every complete character from the accumulator. */
+static void sw_ds_parse(sw_ds_decoder_t *dec)
+{
+    for (;;)
+    {
+        if (!dec->synced)
+        {
+            /* Slide until the low bits read NULL, then take it. */
+            while (dec->nbits >= 8u && (dec->acc & SW_DS_NULL_MASK) != SW_DS_NULL_BITS)
+                sw_ds_consume(dec, 1);
+            if (dec->nbits < 8u)
+                return;
+
+            dec->stats.nulls++;
+            sw_ds_emit(dec, SW_DS_NULL, sw_ds_bit_sample(dec), 0);
+            sw_ds_consume(dec, 8);
+            dec->synced = 1;
+            dec->parity = 0;
+            dec->escape = 0;
+            continue;
+        }
+
+        if (dec->nbits < 4u)
+            return;
+
+        const unsigned p = (unsigned)(dec->acc & 1u);
+        const unsigned flag = (unsigned)(dec->acc >> 1) & 1u;
+        const unsigned len = flag ? 4u : 10u;
+        if (dec->nbits < len)
+            return;
+
+        const uint64_t sample = sw_ds_bit_sample(dec);
+        if ((dec->parity ^ p ^ flag) != 1u)
+        {
+            dec->stats.parity_errors++;
+            sw_ds_lose_sync(dec, SW_DS_PARITY_ERROR, sample);
+            sw_ds_consume(dec, 1);
+            continue;
+        }
+
+        const uint32_t value = (uint32_t)(dec->acc >> 2) & (flag ? 0x03u : 0xFFu);
+        dec->parity = sw_ds_parity8(value);
+        sw_ds_consume(dec, len);
+
+        if (flag)
+            sw_ds_control(dec, value, sample);
+        else
+            sw_ds_data(dec, (uint8_t)value, sample);
+    }
+}
+
+/** @brief Append @p count bits, oldest in bit 0, parsing as the accumulator fills. */
+static void sw_ds_push_bits(sw_ds_decoder_t *dec, uint64_t bits, unsigned count)
+{
+    dec->stats.bits += count;
+
+    while (count > 0)
+    {
+        const unsigned room = 64u - dec->nbits;
+        const unsigned k = count < room ? count : room;
+        const uint64_t chunk = k == 64u ? bits : bits & ((1ull << k) - 1u);
+
+        dec->acc |= chunk << dec->nbits;
+        dec->nbits = (uint8_t)(dec->nbits + k);
+        bits = k == 64u ? 0 : bits >> k;
+        count -= k;
+        sw_ds_parse(dec);
+    }
+}
+
+/* ============================================================================
+ * DECODER
+ * ============================================================================ */
+
+sw_result_t sw_ds_init(sw_ds_decoder_t *dec, const sw_ds_config_t *config)
+{
+    if (!dec || !config || !config->buf || config->cap == 0 ||
+        (config->disconnect_samples != 0 && config->disconnect_samples < SW_DS_WORD_SAMPLES))
+        return SW_INVALID_PARAM;
+
+    memset(dec, 0, sizeof(*dec));
+    dec->config = *config;
+
+    return SW_OK;
+}
+
+/** @brief Track the time since the last bit; report a disconnect once per gap. */
+static void sw_ds_check_gap(sw_ds_decoder_t *dec, uint64_t edges)
+{
+    const uint64_t limit = dec->config.disconnect_samples;
+
+    dec->gap += edges ? sw_ds_ctz(edges) : SW_DS_WORD_SAMPLES;
+    if (limit != 0 && dec->gap > limit && !dec->disconnected && dec->stats.bits > 0)
+    {
+        const uint64_t end = dec->samples + (edges ? sw_ds_ctz(edges) : SW_DS_WORD_SAMPLES);
+        dec->disconnected = 1;
+        dec->stats.disconnects++;
+        dec->acc = 0;
+        dec->parsed += dec->nbits;
+        dec->nbits = 0;
+        sw_ds_lose_sync(dec, SW_DS_DISCONNECT, end - dec->gap);
+    }
+
+    if (edges)
+    {
+        dec->gap = 63u - sw_ds_msb(edges);
+        dec->disconnected = 0;
+    }
+}
+
+sw_result_t sw_ds_decode(sw_ds_decoder_t *dec, const uint64_t *d, const uint64_t *s, size_t words)
+{
+    if (!dec || ((!d || !s) && words > 0))
+        return SW_INVALID_PARAM;
+
+    for (size_t w = 0; w < words; w++)
+    {
+        const uint64_t x = d[w] ^ s[w];
+        const uint64_t edges = x ^ ((x << 1) | dec->prev_x);
+        dec->prev_x = (uint8_t)(x >> 63);
+
+        sw_ds_check_gap(dec, edges);
+
+        if (edges != 0)
+        {
+#if defined(__BMI2__)
+            if (!dec->config.on_char)
+            {
+                sw_ds_push_bits(dec,
+                                _pext_u64(d[w], edges),
+                                (unsigned)__builtin_popcountll(edges));
+                dec->samples += SW_DS_WORD_SAMPLES;
+                continue;
+            }
+#endif
+            uint64_t bits = 0;
+            unsigned count = 0;
+            for (uint64_t e = edges; e != 0; e &= e - 1u)
+            {
+                const unsigned i = sw_ds_ctz(e);
+                if (dec->config.on_char)
+                    dec->bit_sample[(dec->parsed + dec->nbits + count) % 128u] = dec->samples + i;
+                bits |= ((d[w] >> i) & 1u) << count;
+                count++;
+            }
+            sw_ds_push_bits(dec, bits, count);
+        }
+
+        dec->samples += SW_DS_WORD_SAMPLES;
+    }
+
+    return SW_OK;
+}
+
+sw_result_t sw_ds_pack(const uint8_t *samples,
+                       size_t count,
+                       unsigned d_bit,
+                       unsigned s_bit,
+                       uint64_t *d,
+                       uint64_t *s)
+{
+    if (!samples || !d || !s || count % SW_DS_WORD_SAMPLES != 0 || d_bit > 7u || s_bit > 7u)
+        return SW_INVALID_PARAM;
+
+    /* Eight samples per step: move the channel bit of each octet to bit 0 of
+     * the octet, and let the multiply gather the eight bits into the top
+     * octet (octet k's bit lands on bit 56 + k). */
+    const uint64_t lsb = 0x0101010101010101ull;
+    const uint64_t gather = 0x0102040810204080ull;
+
+    for (size_t w = 0; w < count / SW_DS_WORD_SAMPLES; w++)
+    {
+        uint64_t dw = 0;
+        uint64_t sw = 0;
+        for (unsigned k = 0; k < 8u; k++)
+        {
+            const uint8_t *p = &samples[w * SW_DS_WORD_SAMPLES + k * 8u];
+            uint64_t v = 0;
+            for (unsigned b = 0; b < 8u; b++)
+                v |= (uint64_t)p[b] << (8u * b);
+
+            dw |= ((((v >> d_bit) & lsb) * gather) >> 56) << (8u * k);
+            sw |= ((((v >> s_bit) & lsb) * gather) >> 56) << (8u * k);
+        }
+        d[w] = dw;
+        s[w] = sw;
+    }
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * ENCODER
+ * ============================================================================ */
+
+sw_result_t sw_ds_encoder_init(sw_ds_encoder_t *enc,
+                               uint64_t *d,
+                               uint64_t *s,
+                               size_t max_words,
+                               uint32_t samples_per_bit)
+{
+    if (!enc || !d || !s || samples_per_bit == 0)
+        return SW_INVALID_PARAM;
+
+    memset(enc, 0, sizeof(*enc));
+    enc->d = d;
+    enc->s = s;
+    enc->max_words = max_words;
+    enc->samples_per_bit = samples_per_bit;
+    memset(d, 0, max_words * sizeof(*d));
+    memset(s, 0, max_words * sizeof(*s));
+
+    return SW_OK;
+}
+
+/** @brief Set samples [from, from + n) of a line to 1. */
+static void sw_ds_fill(uint64_t *line, uint64_t from, uint64_t n)
+{
+    while (n > 0)
+    {
+        const unsigned off = (unsigned)(from % SW_DS_WORD_SAMPLES);
+        const uint64_t k = n < SW_DS_WORD_SAMPLES - off ? n : SW_DS_WORD_SAMPLES - off;
+        const uint64_t mask = k == 64u ? ~0ull : ((1ull << k) - 1u) << off;
+
+        line[from / SW_DS_WORD_SAMPLES] |= mask;
+        from += k;
+        n -= k;
+    }
+}
+
+/** @brief Send one bit: D takes its value and S toggles if D does not. */
+static void sw_ds_put_bit(sw_ds_encoder_t *enc, unsigned bit)
+{
+    const uint8_t x = (uint8_t)(enc->d_level ^ enc->s_level);
+    enc->d_level = (uint8_t)bit;
+    enc->s_level = (uint8_t)(bit ^ x ^ 1u);
+
+    if (enc->d_level)
+        sw_ds_fill(enc->d, enc->samples, enc->samples_per_bit);
+    if (enc->s_level)
+        sw_ds_fill(enc->s, enc->samples, enc->samples_per_bit);
+    enc->samples += enc->samples_per_bit;
+}
+
+/**
+ * @brief Send a character: parity, flag and @p n bits of @p value, if the
+ *        words have room for it.
+ */
+static sw_result_t sw_ds_put_char(sw_ds_encoder_t *enc, unsigned flag, uint32_t value, unsigned n)
+{
+    if (enc->samples + (uint64_t)(n + 2u) * enc->samples_per_bit >
+        (uint64_t)enc->max_words * SW_DS_WORD_SAMPLES)
+        return SW_ERR;
+
+    sw_ds_put_bit(enc, 1u ^ enc->parity ^ flag);
+    sw_ds_put_bit(enc, flag);
+    for (unsigned i = 0; i < n; i++)
+        sw_ds_put_bit(enc, (value >> i) & 1u);
+
+    enc->parity = sw_ds_parity8(value);
+    return SW_OK;
+}
+
+sw_result_t sw_ds_encode_char(sw_ds_encoder_t *enc, sw_ds_char_type_t type, uint8_t value)
+{
+    if (!enc)
+        return SW_INVALID_PARAM;
+
+    switch (type)
+    {
+    case SW_DS_DATA:
+        return sw_ds_put_char(enc, 0, value, 8);
+    case SW_DS_EOP:
+        return sw_ds_put_char(enc, 1, SW_DS_CODE_EOP, 2);
+    case SW_DS_EEP:
+        return sw_ds_put_char(enc, 1, SW_DS_CODE_EEP, 2);
+    case SW_DS_FCT:
+        return sw_ds_put_char(enc, 1, SW_DS_CODE_FCT, 2);
+    case SW_DS_NULL:
+        if (sw_ds_put_char(enc, 1, SW_DS_CODE_ESC, 2) != SW_OK)
+            return SW_ERR;
+        return sw_ds_put_char(enc, 1, SW_DS_CODE_FCT, 2);
+    case SW_DS_TIME_CODE:
+        if (sw_ds_put_char(enc, 1, SW_DS_CODE_ESC, 2) != SW_OK)
+            return SW_ERR;
+        return sw_ds_put_char(enc, 0, value, 8);
+    default:
+        return SW_INVALID_PARAM;
+    }
+}
+
+sw_result_t sw_ds_encode_packet(sw_ds_encoder_t *enc,
+                                const uint8_t *pkt,
+                                size_t len,
+                                sw_end_marker_t end)
+{
+    if (!enc || (!pkt && len > 0))
+        return SW_INVALID_PARAM;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (sw_ds_put_char(enc, 0, pkt[i], 8) != SW_OK)
+            return SW_ERR;
+    }
+
+    return sw_ds_encode_char(enc, end == SW_END_EEP ? SW_DS_EEP : SW_DS_EOP, 0);
+}
@@ -0,0 +1,190 @@
+/**
+ * @file spacewire_evlog.c
+ * @brief Flight-recorder event log for link and routing anomalies.
+ *
+ * Record i of a ring lives in slot i & mask. The owner writes the slot and
+ * then publishes head = i + 1 with a release store, so a reader that observes
+ * head h after copying knows that slots of records below h - count + 1 may
+ * have been rewritten meanwhile — the record h may already be in progress.
+ * A ring of N records therefore always yields its N - 1 most recent ones.
+ */
+
+#include "../include/spacewire_evlog.h"
+
+#include "spacewire_atomic.h"
+
+#include <string.h>
+
+/** @brief Records copied per chunk by sw_evlog_dump(). */
+#define SW_EVLOG_DUMP_CHUNK 32u
+
+/* The calling thread's ring. */
+static SW_EVLOG_THREAD_LOCAL sw_evlog_ring_t *t_evlog_ring;
+
+/* Registered rings (lock-free list, push only). */
+static sw_evlog_ring_t *g_evlog_registry;
+
+/* ============================================================================
+ * RING SET-UP
+ * ============================================================================ */
+
+sw_result_t sw_evlog_ring_init(sw_evlog_ring_t *ring,
+                               sw_ev_record_t *records,
+                               uint32_t count,
+                               uint32_t thread_id)
+{
+    if (!ring || !records || count < 2 || (count & (count - 1u)) != 0)
+        return SW_INVALID_PARAM;
+
+    memset(records, 0, (size_t)count * sizeof(*records));
+
+    ring->records = records;
+    ring->mask = count - 1u;
+    ring->head = 0;
+    ring->thread_id = thread_id;
+    ring->next = NULL;
+
+    return SW_OK;
+}
+
+void sw_evlog_attach(sw_evlog_ring_t *ring)
+{
+    t_evlog_ring = ring;
+}
+
+sw_evlog_ring_t *sw_evlog_current(void)
+{
+    return t_evlog_ring;
+}
+
+sw_result_t sw_evlog_register(sw_evlog_ring_t *ring)
+{
+    if (!ring)
+        return SW_INVALID_PARAM;
+
+    sw_evlog_ring_t *head = SW_ATOMIC_LOAD_ACQUIRE(&g_evlog_registry);
+
+    for (const sw_evlog_ring_t *r = head; r; r = r->next)
+    {
+        if (r == ring)
+            return SW_INVALID_PARAM;
+    }
+
+    do
+    {
+        ring->next = head;
+    } while (!SW_ATOMIC_CAS(&g_evlog_registry, &head, ring));
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * RECORDING
+ * ============================================================================ */
+
+void sw_evlog_record(sw_ev_type_t type, const void *obj, uint16_t arg, uint8_t aux)
+{
+    sw_evlog_ring_t *ring = t_evlog_ring;
+    if (!ring)
+        return;
+
+    const uint32_t h = SW_ATOMIC_LOAD_RELAXED(&ring->head);
+    sw_ev_record_t *rec = &ring->records[h & ring->mask];
+
+    rec->timestamp = sw_evlog_timestamp();
+    rec->obj = (uint32_t)(uintptr_t)obj;
+    rec->arg = arg;
+    rec->type = (uint8_t)type;
+    rec->aux = aux;
+
+    SW_ATOMIC_STORE_RELEASE(&ring->head, h + 1u);
+}
+
+/* ============================================================================
+ * SNAPSHOT AND DUMP
+ * ============================================================================ */
+
+/**
+ * @brief Copy records [first, first + n) and report how many leading ones
+ *        were overwritten while being copied.
+ * @param[in]  ring  Ring to read.
+ * @param[in]  first Index of the first record.
+ * @param[in]  n     Number of records.
+ * @param[out] out   Destination for @p n records.
+ * @return Number of leading records in @p out that are not valid.
+ */
+static uint32_t sw_evlog_copy(const sw_evlog_ring_t *ring,
+                              uint32_t first,
+                              uint32_t n,
+                              sw_ev_record_t *out)
+{
+    for (uint32_t i = 0; i < n; i++)
+        out[i] = ring->records[(first + i) & ring->mask];
+
+    SW_ATOMIC_FENCE_ACQUIRE();
+    const uint32_t h = SW_ATOMIC_LOAD_RELAXED(&ring->head);
+
+    /* Records below h - mask (= h - count + 1) may have been rewritten. */
+    const uint32_t oldest_safe = h - ring->mask;
+    if ((int32_t)(oldest_safe - first) <= 0)
+        return 0;
+
+    const uint32_t lost = oldest_safe - first;
+    return lost < n ? lost : n;
+}
+
+size_t sw_evlog_snapshot(const sw_evlog_ring_t *ring, sw_ev_record_t *out, size_t max)
+{
+    if (!ring || !out || max == 0)
+        return 0;
+
+    const uint32_t h = SW_ATOMIC_LOAD_ACQUIRE(&ring->head);
+    uint32_t n = h < ring->mask ? h : ring->mask;
+    if (n > max)
+        n = (uint32_t)max;
+
+    const uint32_t lost = sw_evlog_copy(ring, h - n, n, out);
+    if (lost > 0)
+        memmove(out, &out[lost], (size_t)(n - lost) * sizeof(*out));
+
+    return n - lost;
+}
+
+sw_result_t sw_evlog_dump(sw_evlog_write_fn sink, void *ctx)
+{
+    if (!sink)
+        return SW_INVALID_PARAM;
+
+    sw_ev_record_t chunk[SW_EVLOG_DUMP_CHUNK];
+
+    for (const sw_evlog_ring_t *ring = SW_ATOMIC_LOAD_ACQUIRE(&g_evlog_registry); ring;
+         ring = ring->next)
+    {
+        const uint32_t h = SW_ATOMIC_LOAD_ACQUIRE(&ring->head);
+        const uint32_t n = h < ring->mask ? h : ring->mask;
+
+        const sw_evlog_dump_header_t hdr = {
+            .magic = SW_EVLOG_DUMP_MAGIC, .thread_id = ring->thread_id, .head = h, .count = n};
+        if (sink(ctx, &hdr, sizeof(hdr)) != 0)
+            return SW_ERR;
+
+        /* The count is fixed by the header, so records lost to a concurrent
+         * writer are emitted as ::SW_EV_NONE. */
+        for (uint32_t done = 0; done < n;)
+        {
+            const uint32_t left = n - done;
+            const uint32_t len = left < SW_EVLOG_DUMP_CHUNK ? left : SW_EVLOG_DUMP_CHUNK;
+            const uint32_t lost = sw_evlog_copy(ring, h - n + done, len, chunk);
+
+            if (lost > 0)
+                memset(chunk, 0, (size_t)lost * sizeof(chunk[0]));
+
+            if (sink(ctx, chunk, (size_t)len * sizeof(chunk[0])) != 0)
+                return SW_ERR;
+
+            done += len;
+        }
+    }
+
+    return SW_OK;
+}
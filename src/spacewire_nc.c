@@ -0,0 +1,294 @@
+/**
+ * @file spacewire_nc.c
+ * @brief Worst-case delay and backlog bounds for flows (network calculus).
+ *
+ * Hops are built flow by flow, each flow's hops contiguous, and threaded onto
+ * one list per output port kept sorted by input port, so the wait at a hop is
+ * one pass over the list taking the longest occupancy of each input-port run.
+ * Occupancies are computed on demand and memoised; a hop met again while its
+ * own occupancy is still being computed closes a cycle, and every hop on that
+ * cycle's call chain is then unbounded. The recursion is at most as deep as
+ * the number of hops.
+ */
+
+#include "../include/spacewire_nc.h"
+
+#include <string.h>
+
+/** @brief sw_nc_hop_t::state values. */
+enum
+{
+    SW_NC_HOP_NEW = 0,
+    SW_NC_HOP_BUSY = 1,
+    SW_NC_HOP_DONE = 2
+};
+
+/** @brief Saturating sum of two bounds. */
+static uint64_t sw_nc_add(uint64_t a, uint64_t b)
+{
+    return a > SW_NC_UNBOUNDED - b ? SW_NC_UNBOUNDED : a + b;
+}
+
+/** @brief A non-negative double rounded up to an integer bound. */
+static uint64_t sw_nc_ceil(double x)
+{
+    if (x >= 18446744073709551615.0)
+        return SW_NC_UNBOUNDED;
+    const uint64_t n = (uint64_t)x;
+    return (double)n < x ? n + 1u : n;
+}
+
+/* ============================================================================
+ * PATHS
+ * ============================================================================ */
+
+/** @brief Time in ns for @p octets data characters at @p bit_rate, rounded up. */
+static uint64_t sw_nc_tx_ns(uint32_t octets, uint32_t bit_rate)
+{
+    const uint64_t bits = (uint64_t)octets * 10u;
+    return (bits * 1000000000u + bit_rate - 1u) / bit_rate;
+}
+
+/** @brief Thread a hop onto its output port's list, keeping input ports in order. */
+static void sw_nc_link_hop(const sw_nc_work_t *work, uint32_t h)
+{
+    sw_nc_hop_t *hop = &work->hops[h];
+    uint32_t *at = &work->out_head[hop->out];
+
+    while (*at != SW_NC_NONE && work->hops[*at].in_port <= hop->in_port)
+        at = &work->hops[*at].next;
+
+    hop->next = *at;
+    *at = h;
+}
+
+/**
+ * @brief Follow a flow's route from its source to its address, appending
+ *        its hops at @p *used; bound->status tells whether it got there.
+ * @return ::SW_OK, or ::SW_INVALID_PARAM if the hop storage ran out.
+ */
+static sw_result_t sw_nc_build_path(const sw_net_t *net,
+                                    const sw_nc_flow_t *flow,
+                                    uint32_t index,
+                                    const sw_nc_work_t *work,
+                                    size_t *used,
+                                    sw_nc_bound_t *bound)
+{
+    const uint16_t dst = net->addr_node[flow->dst_addr];
+    uint16_t node = flow->src;
+    uint8_t in_port = 0;
+    size_t n = 0;
+
+    bound->first_hop = (uint32_t)*used;
+    bound->status = SW_NC_NO_ROUTE;
+
+    if (dst == SW_NET_NONE)
+        return SW_OK;
+
+    while (node != dst)
+    {
+        if (n + 1u >= net->num_nodes)
+            return SW_OK; /* a routing loop */
+
+        const sw_route_entry_t *route =
+            sw_router_get_route(&net->nodes[node].router, flow->dst_addr);
+        if (!route || route->output_port == 0)
+            return SW_OK;
+
+        const uint16_t l = net->nodes[node].port_link[route->output_port];
+        if (l == SW_NET_NONE || !net->links[l].up)
+            return SW_OK;
+
+        if (*used + n >= work->max_hops)
+            return SW_INVALID_PARAM;
+
+        sw_nc_hop_t *hop = &work->hops[*used + n];
+        memset(hop, 0, sizeof(*hop));
+        hop->flow = index;
+        hop->out = (uint32_t)l * 2u + (net->links[l].node[0] != node);
+        hop->in_port = in_port;
+        n++;
+
+        node = sw_net_peer(net, node, route->output_port, &in_port);
+    }
+
+    if (n == 0)
+        return SW_OK; /* the source owns the address */
+
+    /* The tail moves at the slowest link still ahead. */
+    uint32_t slowest = UINT32_MAX;
+    for (size_t i = n; i-- > 0;)
+    {
+        sw_nc_hop_t *hop = &work->hops[*used + i];
+        const uint32_t rate = net->links[hop->out / 2u].bit_rate;
+        if (rate < slowest)
+            slowest = rate;
+        hop->tx_ns = sw_nc_tx_ns(flow->max_len, slowest);
+    }
+    work->hops[*used + n - 1u].last = 1;
+
+    for (size_t i = 0; i < n; i++)
+        sw_nc_link_hop(work, (uint32_t)(*used + i));
+
+    bound->status = SW_NC_BOUNDED;
+    bound->num_hops = (uint8_t)n;
+    *used += n;
+    return SW_OK;
+}
+
+/* ============================================================================
+ * PER-PACKET BOUND
+ * ============================================================================ */
+
+static uint64_t sw_nc_occupancy(const sw_net_t *net, const sw_nc_work_t *work, uint32_t h);
+
+/**
+ * @brief Longest wait for the output port of hop @p h: one occupancy from
+ *        every other input port feeding it, the longest of each.
+ */
+static uint64_t sw_nc_wait(const sw_net_t *net, const sw_nc_work_t *work, uint32_t h)
+{
+    const uint8_t in_port = work->hops[h].in_port;
+    uint64_t sum = 0;
+    uint64_t run_max = 0;
+    uint32_t run_port = SW_NC_NONE;
+
+    for (uint32_t g = work->out_head[work->hops[h].out]; g != SW_NC_NONE; g = work->hops[g].next)
+    {
+        const uint8_t port = work->hops[g].in_port;
+        if (port == in_port)
+            continue;
+
+        if (port != run_port)
+        {
+            sum = sw_nc_add(sum, run_max);
+            run_max = 0;
+            run_port = port;
+        }
+
+        const uint64_t occ = sw_nc_occupancy(net, work, g);
+        if (occ > run_max)
+            run_max = occ;
+    }
+
+    return sw_nc_add(sum, run_max);
+}
+
+/** @brief Worst-case time hop @p h holds its output port, memoised. */
+static uint64_t sw_nc_occupancy(const sw_net_t *net, const sw_nc_work_t *work, uint32_t h)
+{
+    sw_nc_hop_t *hop = &work->hops[h];
+
+    if (hop->state == SW_NC_HOP_DONE)
+        return hop->occupancy_ns;
+    if (hop->state == SW_NC_HOP_BUSY)
+        return SW_NC_UNBOUNDED;
+
+    hop->state = SW_NC_HOP_BUSY;
+
+    uint64_t occ = net->links[hop->out / 2u].latency_ns;
+    if (hop->last)
+    {
+        occ = sw_nc_add(occ, hop->tx_ns);
+    }
+    else
+    {
+        /* The header waits and moves on while the port stays held; the
+         * tail leaves at the slowest link's pace. */
+        const sw_nc_hop_t *next = &work->hops[h + 1u];
+        occ = sw_nc_add(occ, hop->tx_ns - next->tx_ns);
+        occ = sw_nc_add(occ, sw_nc_wait(net, work, h + 1u));
+        occ = sw_nc_add(occ, sw_nc_occupancy(net, work, h + 1u));
+    }
+
+    hop->occupancy_ns = occ;
+    hop->state = SW_NC_HOP_DONE;
+    return occ;
+}
+
+/* ============================================================================
+ * ANALYSIS
+ * ============================================================================ */
+
+sw_result_t sw_nc_analyse(const sw_net_t *net,
+                          const sw_nc_flow_t *flows,
+                          size_t num_flows,
+                          const sw_nc_work_t *work,
+                          sw_nc_bound_t *bounds)
+{
+    if (!net || (!flows && num_flows > 0) || !work || !work->hops || !work->out_head ||
+        !work->sources || !bounds || num_flows >= SW_NC_NONE)
+        return SW_INVALID_PARAM;
+
+    for (size_t i = 0; i < num_flows; i++)
+    {
+        if (flows[i].src >= net->num_nodes || flows[i].max_len == 0)
+            return SW_INVALID_PARAM;
+    }
+
+    for (size_t o = 0; o < 2u * (size_t)net->num_links; o++)
+        work->out_head[o] = SW_NC_NONE;
+    memset(work->sources, 0, (size_t)net->num_nodes * sizeof(*work->sources));
+
+    size_t used = 0;
+    for (size_t i = 0; i < num_flows; i++)
+    {
+        sw_nc_bound_t *b = &bounds[i];
+        memset(b, 0, sizeof(*b));
+
+        if (sw_nc_build_path(net, &flows[i], (uint32_t)i, work, &used, b) != SW_OK)
+            return SW_INVALID_PARAM;
+    }
+
+    /* Per-packet traversal, and each source's service curve. */
+    for (size_t i = 0; i < num_flows; i++)
+    {
+        sw_nc_bound_t *b = &bounds[i];
+        if (b->status != SW_NC_BOUNDED)
+            continue;
+
+        b->packet_ns = sw_nc_add(sw_nc_wait(net, work, b->first_hop),
+                                 sw_nc_occupancy(net, work, b->first_hop));
+
+        sw_nc_source_t *s = &work->sources[flows[i].src];
+        s->burst += flows[i].burst;
+        s->rate += flows[i].rate;
+        if (b->packet_ns > s->latency_ns)
+            s->latency_ns = b->packet_ns;
+
+        const double service = b->packet_ns == SW_NC_UNBOUNDED
+                                   ? 0.0
+                                   : (double)flows[i].max_len / (double)b->packet_ns;
+        if (s->service == 0.0 || service < s->service)
+            s->service = service;
+        if (service == 0.0)
+            s->latency_ns = SW_NC_UNBOUNDED;
+    }
+
+    for (size_t i = 0; i < num_flows; i++)
+    {
+        sw_nc_bound_t *b = &bounds[i];
+        b->delay_ns = SW_NC_UNBOUNDED;
+        b->backlog = SW_NC_UNBOUNDED;
+        if (b->status != SW_NC_BOUNDED)
+            continue;
+
+        const sw_nc_source_t *s = &work->sources[flows[i].src];
+        if (s->latency_ns == SW_NC_UNBOUNDED)
+        {
+            b->status = SW_NC_DEADLOCK;
+            continue;
+        }
+        if ((double)s->rate / 1e9 > s->service)
+        {
+            b->status = SW_NC_OVERLOAD;
+            continue;
+        }
+
+        const double t = (double)s->latency_ns;
+        b->delay_ns = sw_nc_ceil(t + (double)s->burst / s->service);
+        b->backlog = sw_nc_ceil((double)s->burst + (double)s->rate * t / 1e9);
+    }
+
+    return SW_OK;
+}
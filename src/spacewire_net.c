@@ -0,0 +1,681 @@
+/**
+ * @file spacewire_net.c
+ * @brief Network model: routers, terminals and links, with shortest-path routing.
+ *
+ * Routes towards an address are computed with Dijkstra's algorithm run
+ * backwards from the owning node, links being symmetric. Next hops are chosen
+ * afterwards from the distances alone (lowest port on a shortest path), which
+ * keeps the table canonical: any algorithm producing the same distances
+ * produces the same table, and the incremental update below can be checked
+ * against a full recomputation entry for entry.
+ *
+ * The incremental update keeps one distance vector per destination. A link
+ * change matters to a destination only if the link now offers a shorter path
+ * (then distances fall from the link's far end outwards, Dijkstra-style) or
+ * carried next-hop traffic to it (then the subtree behind the link is
+ * recomputed on its own). Either way only the nodes whose distance moved,
+ * and their neighbours, can change next hop.
+ */
+
+#include "../include/spacewire_net.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * TOPOLOGY
+ * ============================================================================ */
+
+sw_result_t sw_net_init(sw_net_t *net,
+                        sw_net_node_t *nodes,
+                        uint16_t max_nodes,
+                        sw_net_link_t *links,
+                        uint16_t max_links)
+{
+    if (!net || !nodes || !links || max_nodes == 0 || max_nodes >= SW_NET_NONE ||
+        max_links >= SW_NET_NONE)
+        return SW_INVALID_PARAM;
+
+    memset(net, 0, sizeof(*net));
+    net->nodes = nodes;
+    net->links = links;
+    net->max_nodes = max_nodes;
+    net->max_links = max_links;
+
+    for (size_t a = 0; a < SW_ROUTE_TABLE_SIZE; a++)
+        net->addr_node[a] = SW_NET_NONE;
+
+    return SW_OK;
+}
+
+sw_result_t sw_net_clone(sw_net_t *dst,
+                         sw_net_node_t *nodes,
+                         sw_net_link_t *links,
+                         const sw_net_t *src)
+{
+    if (!dst || !nodes || !links || !src || dst == src)
+        return SW_INVALID_PARAM;
+
+    *dst = *src;
+    dst->nodes = nodes;
+    dst->links = links;
+    memcpy(nodes, src->nodes, (size_t)src->num_nodes * sizeof(*nodes));
+    memcpy(links, src->links, (size_t)src->num_links * sizeof(*links));
+    for (uint16_t n = 0; n < src->num_nodes; n++)
+        sw_router_copy(&nodes[n].router, &src->nodes[n].router);
+
+    return SW_OK;
+}
+
+sw_result_t sw_net_add_node(sw_net_t *net,
+                            uint8_t num_ports,
+                            uint8_t logical_addr,
+                            uint16_t *index)
+{
+    if (!net || net->num_nodes >= net->max_nodes)
+        return SW_INVALID_PARAM;
+
+    if (logical_addr != 0 &&
+        (logical_addr < SW_LOGICAL_ADDR_MIN || logical_addr == SW_LOGICAL_ADDR_RESERVED ||
+         net->addr_node[logical_addr] != SW_NET_NONE))
+        return SW_WRONG_ADDRESS;
+
+    const uint16_t n = net->num_nodes++;
+    sw_net_node_t *node = &net->nodes[n];
+
+    sw_router_init(&node->router, num_ports);
+    for (size_t p = 0; p < SW_NUM_PORTS; p++)
+        node->port_link[p] = SW_NET_NONE;
+    node->logical_addr = logical_addr;
+
+    if (logical_addr != 0)
+        net->addr_node[logical_addr] = n;
+
+    if (index)
+        *index = n;
+
+    return SW_OK;
+}
+
+sw_result_t sw_net_connect(sw_net_t *net,
+                           uint16_t a,
+                           uint8_t port_a,
+                           uint16_t b,
+                           uint8_t port_b,
+                           uint32_t bit_rate,
+                           uint32_t latency_ns,
+                           uint16_t *index)
+{
+    if (!net || a >= net->num_nodes || b >= net->num_nodes || a == b || bit_rate == 0 ||
+        net->num_links >= net->max_links)
+        return SW_INVALID_PARAM;
+
+    sw_net_node_t *na = &net->nodes[a];
+    sw_net_node_t *nb = &net->nodes[b];
+
+    if (port_a == SW_PORT_CONFIG || port_a >= na->router.num_ports ||
+        na->port_link[port_a] != SW_NET_NONE)
+        return SW_WRONG_PORT;
+
+    if (port_b == SW_PORT_CONFIG || port_b >= nb->router.num_ports ||
+        nb->port_link[port_b] != SW_NET_NONE)
+        return SW_WRONG_PORT;
+
+    const uint16_t l = net->num_links++;
+    sw_net_link_t *link = &net->links[l];
+
+    link->node[0] = a;
+    link->node[1] = b;
+    link->port[0] = port_a;
+    link->port[1] = port_b;
+    link->up = 1;
+    link->cost = 1;
+    link->bit_rate = bit_rate;
+    link->latency_ns = latency_ns;
+
+    na->port_link[port_a] = l;
+    nb->port_link[port_b] = l;
+
+    if (index)
+        *index = l;
+
+    return SW_OK;
+}
+
+uint16_t sw_net_peer(const sw_net_t *net, uint16_t node, uint8_t port, uint8_t *peer_port)
+{
+    if (!net || node >= net->num_nodes || port >= SW_NUM_PORTS)
+        return SW_NET_NONE;
+
+    const uint16_t l = net->nodes[node].port_link[port];
+    if (l == SW_NET_NONE)
+        return SW_NET_NONE;
+
+    const sw_net_link_t *link = &net->links[l];
+    const unsigned far = (link->node[0] == node && link->port[0] == port) ? 1u : 0u;
+
+    if (peer_port)
+        *peer_port = link->port[far];
+
+    return link->node[far];
+}
+
+/* ============================================================================
+ * ROUTE COMPUTATION
+ * ============================================================================ */
+
+/** @brief Routing weight of a link: its cost if up, else unreachable. */
+static uint64_t sw_net_weight(const sw_net_link_t *link)
+{
+    return link->up ? link->cost : SW_NET_UNREACHABLE;
+}
+
+/** @brief Heap order: distance, then node index. */
+static int sw_net_before(const uint64_t *dist, uint16_t x, uint16_t y)
+{
+    return dist[x] < dist[y] || (dist[x] == dist[y] && x < y);
+}
+
+/**
+ * @brief Move the heap entry at @p i up until its parent precedes it.
+ */
+static void sw_net_sift_up(const sw_net_work_t *w, const uint64_t *dist, uint32_t i)
+{
+    const uint16_t x = w->heap[i];
+
+    while (i > 0)
+    {
+        const uint32_t parent = (i - 1u) / 2u;
+        if (!sw_net_before(dist, x, w->heap[parent]))
+            break;
+        w->heap[i] = w->heap[parent];
+        w->pos[w->heap[i]] = (uint16_t)i;
+        i = parent;
+    }
+
+    w->heap[i] = x;
+    w->pos[x] = (uint16_t)i;
+}
+
+/**
+ * @brief Move the heap entry at @p i down until it precedes its children.
+ */
+static void sw_net_sift_down(const sw_net_work_t *w, const uint64_t *dist, uint32_t i, uint32_t len)
+{
+    const uint16_t x = w->heap[i];
+
+    for (;;)
+    {
+        uint32_t c = 2u * i + 1u;
+        if (c >= len)
+            break;
+        if (c + 1u < len && sw_net_before(dist, w->heap[c + 1u], w->heap[c]))
+            c++;
+        if (!sw_net_before(dist, w->heap[c], x))
+            break;
+        w->heap[i] = w->heap[c];
+        w->pos[w->heap[i]] = (uint16_t)i;
+        i = c;
+    }
+
+    w->heap[i] = x;
+    w->pos[x] = (uint16_t)i;
+}
+
+/**
+ * @brief Queue node @p v, or move it up after its distance decreased.
+ */
+static void sw_net_heap_update(const sw_net_work_t *w,
+                               const uint64_t *dist,
+                               uint32_t *len,
+                               uint16_t v)
+{
+    if (w->pos[v] == SW_NET_NONE)
+    {
+        w->heap[*len] = v;
+        sw_net_sift_up(w, dist, (*len)++);
+    }
+    else
+    {
+        sw_net_sift_up(w, dist, w->pos[v]);
+    }
+}
+
+/**
+ * @brief Run Dijkstra's algorithm from the queued nodes until the queue is empty.
+ *
+ * Every queued node leaves the queue, so work->pos is all ::SW_NET_NONE again
+ * on return.
+ *
+ * @param[in]     net      Network.
+ * @param[in]     w        Scratch space holding the queue.
+ * @param[in,out] dist     Distances.
+ * @param[in]     len     Queue length.
+ * @param[in]     only    If not NULL, lower only the distances of the nodes
+ *                        flagged in this array.
+ * @param[in,out] changed If not NULL, length of work->list: nodes lowered are
+ *                        flagged in work->mark and appended to work->list.
+ */
+static void sw_net_relax(const sw_net_t *net,
+                         const sw_net_work_t *w,
+                         uint64_t *dist,
+                         uint32_t len,
+                         const uint8_t *only,
+                         uint32_t *changed)
+{
+    while (len > 0)
+    {
+        const uint16_t u = w->heap[0];
+        w->pos[u] = SW_NET_NONE;
+        if (--len > 0)
+        {
+            w->heap[0] = w->heap[len];
+            sw_net_sift_down(w, dist, 0, len);
+        }
+
+        const sw_net_node_t *node = &net->nodes[u];
+        for (uint8_t p = 1; p < node->router.num_ports; p++)
+        {
+            const uint16_t l = node->port_link[p];
+            if (l == SW_NET_NONE || !net->links[l].up)
+                continue;
+
+            const uint16_t v = sw_net_peer(net, u, p, NULL);
+            if (only && !only[v])
+                continue;
+
+            const uint64_t d = dist[u] + net->links[l].cost;
+            if (d >= dist[v])
+                continue;
+
+            dist[v] = d;
+            sw_net_heap_update(w, dist, &len, v);
+
+            if (changed && !w->mark[v])
+            {
+                w->mark[v] = 1;
+                w->list[(*changed)++] = v;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Fill @p dist with the distance of every node to @p dest.
+ */
+static void sw_net_distances(const sw_net_t *net,
+                             const sw_net_work_t *w,
+                             uint64_t *dist,
+                             uint16_t dest)
+{
+    for (uint16_t n = 0; n < net->num_nodes; n++)
+    {
+        dist[n] = SW_NET_UNREACHABLE;
+        w->pos[n] = SW_NET_NONE;
+    }
+
+    dist[dest] = 0;
+    w->heap[0] = dest;
+    w->pos[dest] = 0;
+
+    sw_net_relax(net, w, dist, 1, NULL, NULL);
+}
+
+/**
+ * @brief Next-hop port of node @p n towards the node at distance 0: the lowest
+ *        port on a shortest path.
+ * @return Port, or ::SW_NET_NO_ROUTE if @p n is the destination or cut off.
+ */
+static uint8_t sw_net_next_hop(const sw_net_t *net, const uint64_t *dist, uint16_t n)
+{
+    if (dist[n] == 0 || dist[n] == SW_NET_UNREACHABLE)
+        return SW_NET_NO_ROUTE;
+
+    const sw_net_node_t *node = &net->nodes[n];
+    for (uint8_t p = 1; p < node->router.num_ports; p++)
+    {
+        const uint16_t l = node->port_link[p];
+        if (l == SW_NET_NONE || !net->links[l].up)
+            continue;
+
+        const uint16_t v = sw_net_peer(net, n, p, NULL);
+        if (dist[v] != SW_NET_UNREACHABLE && dist[v] + net->links[l].cost == dist[n])
+            return p;
+    }
+
+    return SW_NET_NO_ROUTE;
+}
+
+sw_result_t sw_net_compute_routes(const sw_net_t *net, const sw_net_work_t *work, uint8_t *table)
+{
+    if (!net || !work || !work->dist || !work->heap || !work->pos || !table)
+        return SW_INVALID_PARAM;
+
+    memset(table, SW_NET_NO_ROUTE, (size_t)net->num_nodes * SW_ROUTE_TABLE_SIZE);
+
+    for (size_t addr = SW_LOGICAL_ADDR_MIN; addr < SW_LOGICAL_ADDR_RESERVED; addr++)
+    {
+        const uint16_t dest = net->addr_node[addr];
+        if (dest == SW_NET_NONE)
+            continue;
+
+        sw_net_distances(net, work, work->dist, dest);
+
+        for (uint16_t n = 0; n < net->num_nodes; n++)
+            table[(size_t)n * SW_ROUTE_TABLE_SIZE + addr] = sw_net_next_hop(net, work->dist, n);
+    }
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * INCREMENTAL ROUTE MAINTENANCE
+ * ============================================================================ */
+
+/** @brief Distances of every node to the owner of @p addr. */
+static uint64_t *sw_net_spf_dist(const sw_net_spf_t *spf, size_t addr)
+{
+    return &spf->dist[(addr - SW_LOGICAL_ADDR_MIN) * spf->stride];
+}
+
+sw_result_t sw_net_spf_init(sw_net_spf_t *spf,
+                            const sw_net_t *net,
+                            uint64_t *dist,
+                            uint8_t *table,
+                            const sw_net_work_t *work)
+{
+    if (!spf || !net || !dist || !table || !work || !work->heap || !work->pos || !work->list ||
+        !work->mark)
+        return SW_INVALID_PARAM;
+
+    spf->dist = dist;
+    spf->table = table;
+    spf->work = *work;
+    spf->stride = net->max_nodes;
+
+    memset(table, SW_NET_NO_ROUTE, (size_t)net->num_nodes * SW_ROUTE_TABLE_SIZE);
+    memset(work->mark, 0, net->num_nodes);
+
+    for (size_t addr = SW_LOGICAL_ADDR_MIN; addr < SW_LOGICAL_ADDR_RESERVED; addr++)
+    {
+        const uint16_t dest = net->addr_node[addr];
+        if (dest == SW_NET_NONE)
+            continue;
+
+        uint64_t *d = sw_net_spf_dist(spf, addr);
+        sw_net_distances(net, work, d, dest);
+
+        for (uint16_t n = 0; n < net->num_nodes; n++)
+            table[(size_t)n * SW_ROUTE_TABLE_SIZE + addr] = sw_net_next_hop(net, d, n);
+    }
+
+    return SW_OK;
+}
+
+/**
+ * @brief Lower distances after link @p l got cheaper or came up.
+ * @return Number of nodes whose distance changed, listed in work->list.
+ */
+static uint32_t sw_net_spf_improve(const sw_net_t *net,
+                                   const sw_net_work_t *w,
+                                   uint64_t *dist,
+                                   const sw_net_link_t *l)
+{
+    uint32_t changed = 0;
+    uint32_t len = 0;
+
+    for (unsigned end = 0; end < 2u; end++)
+    {
+        const uint16_t x = l->node[end];
+        const uint16_t y = l->node[1u - end];
+
+        if (dist[y] == SW_NET_UNREACHABLE || dist[y] + l->cost >= dist[x])
+            continue;
+
+        dist[x] = dist[y] + l->cost;
+        sw_net_heap_update(w, dist, &len, x);
+        w->mark[x] = 1;
+        w->list[changed++] = x;
+    }
+
+    sw_net_relax(net, w, dist, len, NULL, &changed);
+    return changed;
+}
+
+/**
+ * @brief Raise distances after link @p l got dearer or went down.
+ *
+ * Only the nodes whose next-hop path crossed the link can be affected: the
+ * subtree hanging from the link's near end. Their distances are dropped,
+ * re-seeded from neighbours outside the subtree and settled by a search
+ * confined to the subtree.
+ *
+ * @return Number of nodes in the subtree, listed in work->list.
+ */
+static uint32_t sw_net_spf_degrade(const sw_net_t *net,
+                                   const sw_net_work_t *w,
+                                   uint64_t *dist,
+                                   const uint8_t *table,
+                                   size_t addr,
+                                   const sw_net_link_t *l)
+{
+    uint16_t root = SW_NET_NONE;
+
+    for (unsigned end = 0; end < 2u; end++)
+    {
+        if (table[(size_t)l->node[end] * SW_ROUTE_TABLE_SIZE + addr] == l->port[end])
+            root = l->node[end];
+    }
+
+    if (root == SW_NET_NONE)
+        return 0;
+
+    /* Collect the subtree: nodes whose next hop leads to a collected node. */
+    uint32_t count = 0;
+    w->mark[root] = 1;
+    w->list[count++] = root;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint16_t u = w->list[i];
+        const sw_net_node_t *node = &net->nodes[u];
+
+        for (uint8_t p = 1; p < node->router.num_ports; p++)
+        {
+            uint8_t vp = 0;
+            const uint16_t v = sw_net_peer(net, u, p, &vp);
+            if (v == SW_NET_NONE || w->mark[v] ||
+                table[(size_t)v * SW_ROUTE_TABLE_SIZE + addr] != vp)
+                continue;
+
+            w->mark[v] = 1;
+            w->list[count++] = v;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+        dist[w->list[i]] = SW_NET_UNREACHABLE;
+
+    /* Seed each subtree node with its best neighbour outside the subtree. */
+    uint32_t len = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint16_t v = w->list[i];
+        const sw_net_node_t *node = &net->nodes[v];
+        uint64_t best = SW_NET_UNREACHABLE;
+
+        for (uint8_t p = 1; p < node->router.num_ports; p++)
+        {
+            const uint16_t link = node->port_link[p];
+            if (link == SW_NET_NONE || !net->links[link].up)
+                continue;
+
+            const uint16_t u = sw_net_peer(net, v, p, NULL);
+            if (w->mark[u] || dist[u] == SW_NET_UNREACHABLE)
+                continue;
+
+            if (dist[u] + net->links[link].cost < best)
+                best = dist[u] + net->links[link].cost;
+        }
+
+        if (best != SW_NET_UNREACHABLE)
+        {
+            dist[v] = best;
+            sw_net_heap_update(w, dist, &len, v);
+        }
+    }
+
+    sw_net_relax(net, w, dist, len, w->mark, NULL);
+    return count;
+}
+
+/** @brief Change order: node, then address. */
+static int sw_net_change_cmp(const void *a, const void *b)
+{
+    const sw_net_route_change_t *x = (const sw_net_route_change_t *)a;
+    const sw_net_route_change_t *y = (const sw_net_route_change_t *)b;
+
+    if (x->node != y->node)
+        return x->node < y->node ? -1 : 1;
+    return (int)x->addr - (int)y->addr;
+}
+
+sw_result_t sw_net_spf_set_link(sw_net_spf_t *spf,
+                                sw_net_t *net,
+                                uint16_t link,
+                                int up,
+                                uint32_t cost,
+                                sw_net_route_change_t *changes,
+                                size_t max_changes,
+                                size_t *num_changes)
+{
+    if (!spf || !net || link >= net->num_links || cost == 0 || !num_changes ||
+        (!changes && max_changes > 0))
+        return SW_INVALID_PARAM;
+
+    sw_net_link_t *l = &net->links[link];
+    const sw_net_work_t *w = &spf->work;
+    const uint64_t before = sw_net_weight(l);
+
+    l->up = up ? 1u : 0u;
+    l->cost = cost;
+
+    const uint64_t after = sw_net_weight(l);
+    size_t count = 0;
+
+    for (size_t addr = SW_LOGICAL_ADDR_MIN; addr < SW_LOGICAL_ADDR_RESERVED && after != before;
+         addr++)
+    {
+        if (net->addr_node[addr] == SW_NET_NONE)
+            continue;
+
+        uint64_t *dist = sw_net_spf_dist(spf, addr);
+        const uint32_t changed = after < before
+                                     ? sw_net_spf_improve(net, w, dist, l)
+                                     : sw_net_spf_degrade(net, w, dist, spf->table, addr, l);
+
+        /* Next hops depend on the node's own distance and its neighbours':
+         * revisit the nodes that moved, their neighbours and the link ends
+         * (an equal-cost link may offer a lower port). */
+        for (uint32_t i = 0; i < changed + 2u; i++)
+        {
+            const uint16_t u = i < changed ? w->list[i] : l->node[i - changed];
+            const sw_net_node_t *node = &net->nodes[u];
+
+            for (uint8_t p = 0; p < node->router.num_ports; p++)
+            {
+                const uint16_t v = p == 0 ? u : sw_net_peer(net, u, p, NULL);
+                if (v == SW_NET_NONE)
+                    continue;
+
+                uint8_t *entry = &spf->table[(size_t)v * SW_ROUTE_TABLE_SIZE + addr];
+                const uint8_t hop = sw_net_next_hop(net, dist, v);
+                if (hop == *entry)
+                    continue;
+
+                *entry = hop;
+                if (count < max_changes)
+                {
+                    changes[count].node = v;
+                    changes[count].addr = (uint8_t)addr;
+                    changes[count].port = hop;
+                }
+                count++;
+            }
+        }
+
+        for (uint32_t i = 0; i < changed; i++)
+            w->mark[w->list[i]] = 0;
+    }
+
+    *num_changes = count;
+
+    if (count > max_changes)
+        return SW_ERR;
+
+    if (count > 1)
+        qsort(changes, count, sizeof(*changes), sw_net_change_cmp);
+    return SW_OK;
+}
+
+sw_result_t sw_net_apply_route_changes(sw_net_t *net,
+                                       const sw_net_route_change_t *changes,
+                                       size_t count)
+{
+    if (!net || (!changes && count > 0))
+        return SW_INVALID_PARAM;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const sw_net_route_change_t *c = &changes[i];
+        if (c->node >= net->num_nodes)
+            return SW_INVALID_PARAM;
+
+        sw_router_t *router = &net->nodes[c->node].router;
+        const sw_result_t rc = c->port == SW_NET_NO_ROUTE
+                                   ? sw_router_remove_route(router, c->addr)
+                                   : sw_router_add_route(router, c->addr, c->port, 0);
+        if (rc != SW_OK)
+            return rc;
+    }
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * ROUTE INSTALLATION
+ * ============================================================================ */
+
+sw_result_t sw_net_install_node_routes(sw_net_t *net, uint16_t node, const uint8_t *row)
+{
+    if (!net || !row || node >= net->num_nodes)
+        return SW_INVALID_PARAM;
+
+    sw_router_t *router = &net->nodes[node].router;
+
+    for (size_t addr = SW_LOGICAL_ADDR_MIN; addr < SW_LOGICAL_ADDR_RESERVED; addr++)
+    {
+        if (row[addr] == SW_NET_NO_ROUTE)
+            sw_router_remove_route(router, (uint8_t)addr);
+        else if (sw_router_add_route(router, (uint8_t)addr, row[addr], 0) != SW_OK)
+            return SW_INVALID_PARAM;
+    }
+
+    return SW_OK;
+}
+
+sw_result_t sw_net_install_routes(sw_net_t *net, const uint8_t *table)
+{
+    if (!net || !table)
+        return SW_INVALID_PARAM;
+
+    for (uint16_t n = 0; n < net->num_nodes; n++)
+    {
+        const sw_result_t rc =
+            sw_net_install_node_routes(net, n, &table[(size_t)n * SW_ROUTE_TABLE_SIZE]);
+        if (rc != SW_OK)
+            return rc;
+    }
+
+    return SW_OK;
+}
@@ -10,6 +10,9 @@
 
 #include "../include/spacewire_packet.h"
 
+#include "../include/spacewire_evlog.h"
+#include "../include/spacewire_trace.h"
+
 #include <string.h>
 
 /* Global statistics */
@@ -43,7 +46,14 @@ void sw_packet_init(sw_packet_frame_t *pf, const sw_packet_config_t *config)
  * PACKET ENCODING (clause 5.4)
  * ============================================================================ */
 
-size_t sw_packet_encode(const sw_packet_frame_t *pf, uint8_t *buf, size_t buf_len)
+/**
+ * @brief Encode a packet; sw_packet_encode() without the trace span.
+ * @param[in]  pf      Packet frame to encode.
+ * @param[out] buf     Output buffer.
+ * @param[in]  buf_len Size of @p buf.
+ * @return Octets written, or 0 on error.
+ */
+static size_t sw_packet_encode_body(const sw_packet_frame_t *pf, uint8_t *buf, size_t buf_len)
 {
     if (!pf || !buf)
         return 0;
@@ -96,6 +106,15 @@ size_t sw_packet_encode(const sw_packet_frame_t *pf, uint8_t *buf, size_t buf_le
     return offset;
 }
 
+size_t sw_packet_encode(const sw_packet_frame_t *pf, uint8_t *buf, size_t buf_len)
+{
+    const uint64_t t = sw_trace_begin();
+    const size_t n = sw_packet_encode_body(pf, buf, buf_len);
+
+    sw_trace_end(t, SW_SPAN_ENCODE, pf, n > 0xFFFFu ? 0xFFFFu : (uint16_t)n);
+    return n;
+}
+
 /* ============================================================================
  * PACKET DECODING (clause 5.5.4)
  * ============================================================================ */
@@ -135,11 +154,20 @@ static sw_result_t sw_packet_discard(sw_packet_frame_t *pf,
     return SW_ERR;
 }
 
-sw_result_t sw_packet_decode(sw_packet_frame_t *pf,
-                             const uint8_t *buf,
-                             size_t buf_len,
-                             sw_end_marker_t end,
-                             sw_ptp_status_t *status)
+/**
+ * @brief Decode a packet; sw_packet_decode() without the trace span.
+ * @param[out] pf      Packet frame.
+ * @param[in]  buf     Received octets.
+ * @param[in]  buf_len Number of octets.
+ * @param[in]  end     End marker that terminated the packet.
+ * @param[out] status  Receive status; must be non-NULL.
+ * @return ::SW_OK, ::SW_ERR or ::SW_INVALID_PARAM.
+ */
+static sw_result_t sw_packet_decode_body(sw_packet_frame_t *pf,
+                                         const uint8_t *buf,
+                                         size_t buf_len,
+                                         sw_end_marker_t end,
+                                         sw_ptp_status_t *status)
 {
     if (!pf || !buf)
     {
@@ -151,7 +179,10 @@ sw_result_t sw_packet_decode(sw_packet_frame_t *pf,
 
     /* clause 5.5.4.4: a packet terminated by EEP shall be discarded. */
     if (end == SW_END_EEP)
+    {
+        sw_evlog_record(SW_EV_EEP, pf, buf_len > 0xFFFFu ? 0xFFFFu : (uint16_t)buf_len, 0);
         return sw_packet_discard(pf, status, SW_PTP_STATUS_EEP);
+    }
 
     /* Need the encapsulation header plus a minimal CCSDS packet. */
     if (buf_len < (size_t)SW_PTP_HEADER_LEN + SW_PTP_CCSDS_MIN_LEN)
@@ -182,12 +213,28 @@ sw_result_t sw_packet_decode(sw_packet_frame_t *pf,
     g_sw_stats.packets_received++;
     g_sw_stats.bytes_received += (uint32_t)buf_len;
 
-    if (status)
-        *status = SW_PTP_STATUS_OK;
+    *status = SW_PTP_STATUS_OK;
 
     return SW_OK;
 }
 
+sw_result_t sw_packet_decode(sw_packet_frame_t *pf,
+                             const uint8_t *buf,
+                             size_t buf_len,
+                             sw_end_marker_t end,
+                             sw_ptp_status_t *status)
+{
+    const uint64_t t = sw_trace_begin();
+    sw_ptp_status_t st = SW_PTP_STATUS_OK;
+    const sw_result_t r = sw_packet_decode_body(pf, buf, buf_len, end, &st);
+
+    sw_trace_end(t, SW_SPAN_DECODE, pf, (uint16_t)st);
+    if (status)
+        *status = st;
+
+    return r;
+}
+
 /* ============================================================================
  * CONVENIENCE FUNCTION
  * ============================================================================ */
@@ -0,0 +1,292 @@
+/**
+ * @file spacewire_psim.c
+ * @brief Conservative parallel discrete-event simulation of large networks.
+ *
+ * Each window has two phases separated by barriers:
+ *
+ *   1. merge the incoming queues, publish the earliest pending event, barrier;
+ *      all partitions then derive the same window [t_min, t_min + lookahead);
+ *   2. process the window's events, sending remote ones to the queues, barrier.
+ *
+ * Queues are only filled in phase 2. A partition waiting at a barrier, or on
+ * a full outgoing queue, keeps draining its incoming queues, so two
+ * partitions filling each other's queues cannot deadlock; events drained
+ * early belong to a later window and simply wait in the partition's heap.
+ */
+
+#include "../include/spacewire_psim.h"
+
+#include "spacewire_atomic.h"
+
+#include <string.h>
+
+/* ============================================================================
+ * QUEUES
+ * ============================================================================ */
+
+/**
+ * @brief Append an event to a queue (producer only).
+ * @return 1 on success, 0 if the queue is full.
+ */
+static int sw_psim_queue_push(sw_psim_queue_t *q, const sw_sim_event_t *ev)
+{
+    const uint32_t t = SW_ATOMIC_LOAD_RELAXED(&q->tail);
+    const uint32_t h = SW_ATOMIC_LOAD_ACQUIRE(&q->head);
+
+    if (t - h > q->mask)
+        return 0;
+
+    q->slots[t & q->mask] = *ev;
+    SW_ATOMIC_STORE_RELEASE(&q->tail, t + 1u);
+    return 1;
+}
+
+/**
+ * @brief Move every event waiting for partition @p part into its heap.
+ */
+static void sw_psim_drain(sw_psim_t *psim, uint16_t part)
+{
+    sw_sim_t *sim = &psim->parts[part];
+
+    for (uint16_t from = 0; from < psim->num_parts; from++)
+    {
+        sw_psim_queue_t *q = &psim->queues[(size_t)from * psim->num_parts + part];
+        const uint32_t t = SW_ATOMIC_LOAD_ACQUIRE(&q->tail);
+        uint32_t h = SW_ATOMIC_LOAD_RELAXED(&q->head);
+
+        if (h == t)
+            continue;
+
+        for (; h != t; h++)
+            sw_sim_insert(sim, &q->slots[h & q->mask]);
+
+        SW_ATOMIC_STORE_RELEASE(&q->head, h);
+    }
+}
+
+/**
+ * @brief ::sw_sim_remote_fn: queue an event for its owning partition.
+ */
+static sw_result_t sw_psim_remote(sw_sim_t *sim, void *ctx, const sw_sim_event_t *ev)
+{
+    sw_psim_t *psim = (sw_psim_t *)ctx;
+    const uint16_t to = psim->owner[ev->node];
+    sw_psim_queue_t *q = &psim->queues[(size_t)sim->partition * psim->num_parts + to];
+
+    while (!sw_psim_queue_push(q, ev))
+    {
+        if (psim->serial)
+        {
+            sim->overflows++;
+            return SW_ERR;
+        }
+        sw_psim_drain(psim, sim->partition);
+    }
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * WINDOWS
+ * ============================================================================ */
+
+/**
+ * @brief Sense-reversing barrier; waiting partitions keep draining.
+ * @param[in,out] sense The caller's phase, flipped on each use.
+ */
+static void sw_psim_barrier(sw_psim_t *psim, uint16_t part, uint32_t *sense)
+{
+    *sense ^= 1u;
+
+    if (SW_ATOMIC_FETCH_ADD(&psim->arrived, 1u) == psim->num_parts - 1u)
+    {
+        SW_ATOMIC_STORE_RELAXED(&psim->arrived, 0u);
+        SW_ATOMIC_STORE_RELEASE(&psim->sense, *sense);
+        return;
+    }
+
+    while (SW_ATOMIC_LOAD_ACQUIRE(&psim->sense) != *sense)
+        sw_psim_drain(psim, part);
+}
+
+/** @brief Time of a partition's earliest pending event, UINT64_MAX if none. */
+static uint64_t sw_psim_next(const sw_sim_t *sim)
+{
+    return sim->num_events > 0 ? sim->events[0].time : UINT64_MAX;
+}
+
+/** @brief Earliest pending event over the published partition times. */
+static uint64_t sw_psim_min_time(const sw_psim_t *psim)
+{
+    uint64_t t_min = UINT64_MAX;
+    for (uint16_t p = 0; p < psim->num_parts; p++)
+    {
+        if (psim->next_time[p] < t_min)
+            t_min = psim->next_time[p];
+    }
+    return t_min;
+}
+
+/** @brief End of the window starting at @p t_min, capped at @p until. */
+static uint64_t sw_psim_window_end(const sw_psim_t *psim, uint64_t t_min, uint64_t until)
+{
+    if (psim->lookahead >= until - t_min)
+        return until;
+
+    return t_min + psim->lookahead;
+}
+
+/* ============================================================================
+ * SET-UP AND RUN
+ * ============================================================================ */
+
+void sw_psim_partition_blocks(const sw_net_t *net, uint16_t num_parts, uint16_t *owner)
+{
+    if (!net || !owner || num_parts == 0)
+        return;
+
+    for (uint16_t n = 0; n < net->num_nodes; n++)
+        owner[n] = (uint16_t)((uint32_t)n * num_parts / net->num_nodes);
+}
+
+sw_result_t sw_psim_init(sw_psim_t *psim,
+                         sw_sim_t *sim,
+                         sw_sim_t *parts,
+                         uint16_t num_parts,
+                         const uint16_t *owner,
+                         sw_sim_event_t *events,
+                         uint32_t events_per_part,
+                         sw_psim_queue_t *queues,
+                         sw_sim_event_t *slots,
+                         uint32_t queue_len)
+{
+    if (!psim || !sim || !sim->net || !parts || !owner || !events || !queues || !slots ||
+        num_parts == 0 || num_parts > SW_PSIM_MAX_PARTS || events_per_part == 0 ||
+        queue_len == 0 || (queue_len & (queue_len - 1u)) != 0)
+        return SW_INVALID_PARAM;
+
+    const sw_net_t *net = sim->net;
+    uint64_t lookahead = UINT64_MAX;
+
+    for (uint16_t n = 0; n < net->num_nodes; n++)
+    {
+        if (owner[n] >= num_parts)
+            return SW_INVALID_PARAM;
+    }
+
+    for (uint16_t l = 0; l < net->num_links; l++)
+    {
+        const sw_net_link_t *link = &net->links[l];
+        if (owner[link->node[0]] != owner[link->node[1]] && link->latency_ns < lookahead)
+            lookahead = link->latency_ns;
+    }
+
+    if (lookahead == 0)
+        return SW_INVALID_PARAM;
+
+    memset(psim, 0, sizeof(*psim));
+    psim->parts = parts;
+    psim->queues = queues;
+    psim->owner = owner;
+    psim->num_parts = num_parts;
+    psim->lookahead = lookahead;
+
+    for (uint16_t p = 0; p < num_parts; p++)
+    {
+        sw_sim_t *part = &parts[p];
+
+        *part = *sim;
+        part->events = &events[(size_t)p * events_per_part];
+        part->num_events = 0;
+        part->max_events = events_per_part;
+        part->overflows = 0;
+        part->owner = owner;
+        part->partition = p;
+        part->remote = sw_psim_remote;
+        part->remote_ctx = psim;
+    }
+
+    for (size_t q = 0; q < (size_t)num_parts * num_parts; q++)
+    {
+        memset(&queues[q], 0, sizeof(queues[q]));
+        queues[q].slots = &slots[q * queue_len];
+        queues[q].mask = queue_len - 1u;
+    }
+
+    for (uint32_t i = 0; i < sim->num_events; i++)
+    {
+        const sw_sim_event_t *ev = &sim->events[i];
+        if (sw_sim_insert(&parts[owner[ev->node]], ev) != SW_OK)
+            return SW_INVALID_PARAM;
+    }
+    sim->num_events = 0;
+
+    return SW_OK;
+}
+
+uint64_t sw_psim_run(sw_psim_t *psim, uint16_t part, uint64_t until)
+{
+    if (!psim || part >= psim->num_parts)
+        return 0;
+
+    sw_sim_t *sim = &psim->parts[part];
+    uint32_t sense = SW_ATOMIC_LOAD_ACQUIRE(&psim->sense);
+    uint64_t processed = 0;
+
+    for (;;)
+    {
+        sw_psim_drain(psim, part);
+        psim->next_time[part] = sw_psim_next(sim);
+        sw_psim_barrier(psim, part, &sense);
+
+        /* next_time is only rewritten after the barrier closing the window,
+         * so every partition derives the same window from it. */
+        const uint64_t t_min = sw_psim_min_time(psim);
+        if (t_min >= until)
+            break;
+
+        processed += sw_sim_run(sim, sw_psim_window_end(psim, t_min, until));
+        if (part == 0)
+            psim->windows++;
+        sw_psim_barrier(psim, part, &sense);
+    }
+
+    /* Let every partition read next_time before a later run rewrites it. */
+    sw_psim_barrier(psim, part, &sense);
+    sw_sim_run(sim, until);
+
+    return processed;
+}
+
+uint64_t sw_psim_run_serial(sw_psim_t *psim, uint64_t until)
+{
+    if (!psim)
+        return 0;
+
+    uint64_t processed = 0;
+    psim->serial = 1;
+
+    for (;;)
+    {
+        for (uint16_t p = 0; p < psim->num_parts; p++)
+        {
+            sw_psim_drain(psim, p);
+            psim->next_time[p] = sw_psim_next(&psim->parts[p]);
+        }
+
+        const uint64_t t_min = sw_psim_min_time(psim);
+        if (t_min >= until)
+            break;
+
+        const uint64_t end = sw_psim_window_end(psim, t_min, until);
+        for (uint16_t p = 0; p < psim->num_parts; p++)
+            processed += sw_sim_run(&psim->parts[p], end);
+        psim->windows++;
+    }
+
+    for (uint16_t p = 0; p < psim->num_parts; p++)
+        sw_sim_run(&psim->parts[p], until);
+
+    psim->serial = 0;
+    return processed;
+}
@@ -0,0 +1,299 @@
+/**
+ * @file spacewire_pubsub.c
+ * @brief Zero-copy publish/subscribe of decoded CCSDS PTP packets.
+ *
+ * Region layout, every part aligned to ::SW_PUBSUB_ALIGN:
+ *
+ *     [ sw_pubsub_header_t ][ slot 0 ][ slot 1 ] ... [ slot N-1 ]
+ *     slot = [ sw_pubsub_desc_t ][ slot_size data octets ]
+ *
+ * Each slot is a seqlock: the publisher stamps it 2n+1 before overwriting it
+ * with packet n and 2n+2 once the packet is decoded and its descriptor written.
+ * A reader accepts packet n only while the stamp reads 2n+2.
+ */
+
+#include "../include/spacewire_pubsub.h"
+
+#include "spacewire_atomic.h"
+
+#include <string.h>
+
+/* ============================================================================
+ * LAYOUT HELPERS
+ * ============================================================================ */
+
+/**
+ * @brief Round up to a multiple of ::SW_PUBSUB_ALIGN.
+ * @param[in] n Size in octets.
+ * @return Rounded size.
+ */
+static size_t sw_pubsub_align(size_t n)
+{
+    return (n + (SW_PUBSUB_ALIGN - 1u)) & ~(size_t)(SW_PUBSUB_ALIGN - 1u);
+}
+
+/** @brief Space reserved for the descriptor at the start of each slot. */
+#define SW_PUBSUB_DESC_AREA sw_pubsub_align(sizeof(sw_pubsub_desc_t))
+
+/** @brief Space reserved for the channel header. */
+#define SW_PUBSUB_HEADER_AREA sw_pubsub_align(sizeof(sw_pubsub_header_t))
+
+/**
+ * @brief Descriptor of the slot that carries sequence number @p seq.
+ */
+static sw_pubsub_desc_t *sw_pubsub_desc(const sw_pubsub_t *ch, uint32_t seq)
+{
+    return (sw_pubsub_desc_t *)(void *)&ch->slots[(size_t)(seq & ch->mask) * ch->hdr->stride];
+}
+
+/**
+ * @brief Data area of the slot that carries sequence number @p seq.
+ */
+static uint8_t *sw_pubsub_data(const sw_pubsub_t *ch, uint32_t seq)
+{
+    return &ch->slots[(size_t)(seq & ch->mask) * ch->hdr->stride + SW_PUBSUB_DESC_AREA];
+}
+
+/**
+ * @brief Stamp of a slot whose packet @p seq is published.
+ */
+static uint32_t sw_pubsub_ready_stamp(uint32_t seq)
+{
+    return 2u * seq + 2u;
+}
+
+/* ============================================================================
+ * CHANNEL SET-UP
+ * ============================================================================ */
+
+size_t sw_pubsub_region_size(uint32_t slot_count, uint32_t slot_size)
+{
+    if (slot_count == 0 || (slot_count & (slot_count - 1u)) != 0 || slot_size == 0)
+        return 0;
+
+    const size_t stride = sw_pubsub_align(SW_PUBSUB_DESC_AREA + slot_size);
+
+    return SW_PUBSUB_HEADER_AREA + (size_t)slot_count * stride;
+}
+
+sw_result_t sw_pubsub_create(sw_pubsub_t *ch,
+                             void *mem,
+                             size_t mem_len,
+                             uint32_t slot_count,
+                             uint32_t slot_size)
+{
+    if (!ch || !mem || ((uintptr_t)mem % SW_PUBSUB_ALIGN) != 0)
+        return SW_INVALID_PARAM;
+
+    const size_t need = sw_pubsub_region_size(slot_count, slot_size);
+    if (need == 0 || need > mem_len)
+        return SW_INVALID_PARAM;
+
+    memset(mem, 0, need);
+
+    sw_pubsub_header_t *hdr = (sw_pubsub_header_t *)mem;
+    hdr->slot_count = slot_count;
+    hdr->slot_size = slot_size;
+    hdr->stride = (uint32_t)sw_pubsub_align(SW_PUBSUB_DESC_AREA + slot_size);
+    hdr->head = 0;
+    hdr->discarded = 0;
+
+    /* Publish the magic last so an early attach sees either nothing or a
+     * complete header. */
+    SW_ATOMIC_STORE_RELEASE(&hdr->magic, SW_PUBSUB_MAGIC);
+
+    return sw_pubsub_attach(ch, mem, mem_len);
+}
+
+sw_result_t sw_pubsub_attach(sw_pubsub_t *ch, void *mem, size_t mem_len)
+{
+    if (!ch || !mem || mem_len < SW_PUBSUB_HEADER_AREA)
+        return SW_INVALID_PARAM;
+
+    sw_pubsub_header_t *hdr = (sw_pubsub_header_t *)mem;
+    if (SW_ATOMIC_LOAD_ACQUIRE(&hdr->magic) != SW_PUBSUB_MAGIC)
+        return SW_INVALID_PARAM;
+
+    const size_t need = sw_pubsub_region_size(hdr->slot_count, hdr->slot_size);
+    if (need == 0 || need > mem_len)
+        return SW_INVALID_PARAM;
+
+    ch->hdr = hdr;
+    ch->slots = (uint8_t *)mem + SW_PUBSUB_HEADER_AREA;
+    ch->mask = hdr->slot_count - 1u;
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * PUBLISHER
+ * ============================================================================ */
+
+uint8_t *sw_pubsub_reserve(sw_pubsub_t *ch, size_t *capacity)
+{
+    if (!ch)
+        return NULL;
+
+    const uint32_t seq = SW_ATOMIC_LOAD_RELAXED(&ch->hdr->head);
+    sw_pubsub_desc_t *desc = sw_pubsub_desc(ch, seq);
+
+    /* Mark the slot as being written before any of its octets change. */
+    SW_ATOMIC_STORE_RELAXED(&desc->stamp, 2u * seq + 1u);
+    SW_ATOMIC_FENCE_RELEASE();
+
+    if (capacity)
+        *capacity = ch->hdr->slot_size;
+
+    return sw_pubsub_data(ch, seq);
+}
+
+sw_result_t sw_pubsub_commit(sw_pubsub_t *ch,
+                             size_t len,
+                             sw_end_marker_t end,
+                             sw_ptp_status_t *status)
+{
+    if (!ch || len > ch->hdr->slot_size)
+    {
+        if (status)
+            *status = SW_PTP_STATUS_INVALID;
+
+        return SW_INVALID_PARAM;
+    }
+
+    const uint32_t seq = SW_ATOMIC_LOAD_RELAXED(&ch->hdr->head);
+    sw_pubsub_desc_t *desc = sw_pubsub_desc(ch, seq);
+    const uint8_t *data = sw_pubsub_data(ch, seq);
+
+    sw_packet_frame_t pf;
+    if (sw_packet_decode(&pf, data, len, end, status) != SW_OK)
+    {
+        /* The slot keeps its "being written" stamp and is reused next time. */
+        SW_ATOMIC_STORE_RELAXED(&ch->hdr->discarded, ch->hdr->discarded + 1u);
+        return SW_ERR;
+    }
+
+    desc->len = (uint32_t)len;
+    desc->data_off = (uint32_t)(pf.packet.data - data);
+    desc->logical_addr = pf.logical_addr;
+    desc->user_app = pf.user_app;
+    desc->packet = pf.packet;
+
+    SW_ATOMIC_STORE_RELEASE(&desc->stamp, sw_pubsub_ready_stamp(seq));
+    SW_ATOMIC_STORE_RELEASE(&ch->hdr->head, seq + 1u);
+
+    return SW_OK;
+}
+
+sw_result_t sw_pubsub_publish(sw_pubsub_t *ch,
+                              const uint8_t *buf,
+                              size_t len,
+                              sw_end_marker_t end,
+                              sw_ptp_status_t *status)
+{
+    if (!ch || (!buf && len > 0) || len > ch->hdr->slot_size)
+    {
+        if (status)
+            *status = SW_PTP_STATUS_INVALID;
+
+        return SW_INVALID_PARAM;
+    }
+
+    uint8_t *slot = sw_pubsub_reserve(ch, NULL);
+    if (len > 0)
+        memcpy(slot, buf, len);
+
+    return sw_pubsub_commit(ch, len, end, status);
+}
+
+/* ============================================================================
+ * SUBSCRIBERS
+ * ============================================================================ */
+
+void sw_pubsub_sub_init(sw_pubsub_sub_t *sub, const sw_pubsub_t *ch)
+{
+    if (!sub)
+        return;
+
+    memset(sub, 0, sizeof(*sub));
+    sub->ch = ch;
+
+    if (ch)
+        sub->next = SW_ATOMIC_LOAD_ACQUIRE(&ch->hdr->head);
+}
+
+sw_result_t sw_pubsub_peek(sw_pubsub_sub_t *sub, sw_pubsub_msg_t *msg)
+{
+    if (!sub || !sub->ch || !msg)
+        return SW_INVALID_PARAM;
+
+    const sw_pubsub_t *ch = sub->ch;
+    const uint32_t slot_count = ch->mask + 1u;
+
+    for (;;)
+    {
+        const uint32_t head = SW_ATOMIC_LOAD_ACQUIRE(&ch->hdr->head);
+        if (head == sub->next)
+            return SW_ERR;
+
+        /* Lapped: the slot of the oldest unread packet may already be under
+         * reservation for packet `head`, so resume one past it. */
+        if ((uint32_t)(head - sub->next) >= slot_count)
+        {
+            const uint32_t resume = head - slot_count + 1u;
+            sub->dropped += resume - sub->next;
+            sub->next = resume;
+        }
+
+        const uint32_t seq = sub->next;
+        const sw_pubsub_desc_t *desc = sw_pubsub_desc(ch, seq);
+        const uint32_t stamp = SW_ATOMIC_LOAD_ACQUIRE(&desc->stamp);
+
+        const uint32_t len = desc->len;
+        const uint32_t data_off = desc->data_off;
+        const uint8_t logical_addr = desc->logical_addr;
+        const uint8_t user_app = desc->user_app;
+        const sp_packet_t packet = desc->packet;
+
+        SW_ATOMIC_FENCE_ACQUIRE();
+        if (stamp != sw_pubsub_ready_stamp(seq) ||
+            SW_ATOMIC_LOAD_RELAXED(&desc->stamp) != stamp)
+            continue; /* overwritten under us; re-evaluate the lap */
+
+        const uint8_t *data = sw_pubsub_data(ch, seq);
+
+        msg->seq = seq;
+        msg->raw = data;
+        msg->raw_len = len;
+        memset(&msg->pf, 0, sizeof(msg->pf));
+        msg->pf.logical_addr = logical_addr;
+        msg->pf.user_app = user_app;
+        msg->pf.packet = packet;
+        msg->pf.packet.data = &data[data_off];
+
+        sub->held = 1;
+        return SW_OK;
+    }
+}
+
+sw_result_t sw_pubsub_release(sw_pubsub_sub_t *sub)
+{
+    if (!sub || !sub->ch || !sub->held)
+        return SW_INVALID_PARAM;
+
+    const sw_pubsub_desc_t *desc = sw_pubsub_desc(sub->ch, sub->next);
+
+    SW_ATOMIC_FENCE_ACQUIRE();
+    const int stable = SW_ATOMIC_LOAD_RELAXED(&desc->stamp) == sw_pubsub_ready_stamp(sub->next);
+
+    sub->next++;
+    sub->held = 0;
+
+    if (!stable)
+    {
+        sub->dropped++;
+        return SW_ERR;
+    }
+
+    sub->received++;
+    return SW_OK;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file spacewire_ring.c
+ * @brief Single-producer single-consumer rings of packet descriptors.
+ */
+
+#include "../include/spacewire_ring.h"
+#include "../include/spacewire_trace.h"
+
+#include "spacewire_atomic.h"
+
+#include <string.h>
+
+sw_result_t sw_ring_init(sw_ring_t *ring, sw_desc_t *slots, uint32_t count)
+{
+    if (!ring || !slots || count == 0 || (count & (count - 1u)) != 0)
+        return SW_INVALID_PARAM;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = slots;
+    ring->mask = count - 1u;
+
+    return SW_OK;
+}
+
+uint32_t sw_ring_push_burst(sw_ring_t *ring, const sw_desc_t *descs, uint32_t n)
+{
+    if (!ring || !descs)
+        return 0;
+
+    const uint64_t t = sw_trace_begin();
+
+    const uint32_t tail = ring->tail;
+    uint32_t room = ring->mask + 1u - (tail - ring->head_cache);
+
+    if (room < n)
+    {
+        ring->head_cache = SW_ATOMIC_LOAD_ACQUIRE(&ring->head);
+        room = ring->mask + 1u - (tail - ring->head_cache);
+    }
+
+    if (n > room)
+        n = room;
+
+    for (uint32_t i = 0; i < n; i++)
+        ring->slots[(tail + i) & ring->mask] = descs[i];
+
+    if (n > 0)
+        SW_ATOMIC_STORE_RELEASE(&ring->tail, tail + n);
+
+    sw_trace_end(t, SW_SPAN_RING_PUSH, ring, (uint16_t)(n > 0xFFFFu ? 0xFFFFu : n));
+    return n;
+}
+
+uint32_t sw_ring_pop_burst(sw_ring_t *ring, sw_desc_t *out, uint32_t max)
+{
+    if (!ring || !out)
+        return 0;
+
+    const uint64_t t = sw_trace_begin();
+
+    const uint32_t head = ring->head;
+    uint32_t avail = ring->tail_cache - head;
+
+    if (avail < max)
+    {
+        ring->tail_cache = SW_ATOMIC_LOAD_ACQUIRE(&ring->tail);
+        avail = ring->tail_cache - head;
+    }
+
+    if (max > avail)
+        max = avail;
+
+    for (uint32_t i = 0; i < max; i++)
+        out[i] = ring->slots[(head + i) & ring->mask];
+
+    if (max > 0)
+        SW_ATOMIC_STORE_RELEASE(&ring->head, head + max);
+
+    sw_trace_end(t, SW_SPAN_RING_POP, ring, (uint16_t)(max > 0xFFFFu ? 0xFFFFu : max));
+    return max;
+}
+
+uint32_t sw_ring_count(const sw_ring_t *ring)
+{
+    if (!ring)
+        return 0;
+
+    return SW_ATOMIC_LOAD_ACQUIRE(&ring->tail) - SW_ATOMIC_LOAD_ACQUIRE(&ring->head);
+}
@@ -4,6 +4,8 @@
  */
 
 #include "../include/spacewire.h"
+#include "../include/spacewire_evlog.h"
+#include "../include/spacewire_trace.h"
 
 #include <string.h>
 
@@ -33,6 +35,105 @@ void sw_router_init(sw_router_t *router, uint8_t num_ports)
     }
 }
 
+/* ============================================================================
+ * ROUTING TABLES
+ * ============================================================================ */
+
+/** @brief Table in use: @ref sw_router_t::routes, else the router's own. */
+static const sw_route_table_t *sw_router_table(const sw_router_t *router)
+{
+    return router->routes ? router->routes : &router->own;
+}
+
+/** @brief Drop the router's reference to a shared table, back to its own. */
+static void sw_router_leave(sw_router_t *router)
+{
+    if (router->routes && router->routes->refs > 0)
+        router->routes->refs--;
+
+    router->routes = NULL;
+}
+
+/**
+ * @brief The router's table, ready to be written: a table shared with other
+ *        routers is copied into the router's own first.
+ */
+static sw_route_table_t *sw_router_writable(sw_router_t *router)
+{
+    sw_route_table_t *t = router->routes;
+    if (!t)
+        return &router->own;
+
+    if (t->refs == 1)
+        return t;
+
+    memcpy(router->own.entries, t->entries, sizeof(router->own.entries));
+    sw_router_leave(router);
+    return &router->own;
+}
+
+sw_result_t sw_router_set_routes(sw_router_t *router, sw_route_table_t *table)
+{
+    if (!router || !table)
+        return SW_INVALID_PARAM;
+
+    if (table == router->routes)
+        return SW_OK;
+
+    memcpy(table->entries, sw_router_table(router)->entries, sizeof(table->entries));
+    sw_router_leave(router);
+    router->routes = table;
+    table->refs = 1;
+
+    return SW_OK;
+}
+
+sw_result_t sw_router_share_routes(sw_router_t *router, sw_router_t *from)
+{
+    if (!router || !from)
+        return SW_INVALID_PARAM;
+
+    sw_route_table_t *t = from->routes;
+    if (!t)
+        return SW_ERR;
+
+    if (t == router->routes)
+        return SW_OK;
+
+    sw_router_leave(router);
+    router->routes = t;
+    t->refs++;
+
+    return SW_OK;
+}
+
+sw_result_t sw_router_clear_routes(sw_router_t *router)
+{
+    if (!router)
+        return SW_INVALID_PARAM;
+
+    sw_router_leave(router);
+    memset(&router->own, 0, sizeof(router->own));
+
+    return SW_OK;
+}
+
+sw_result_t sw_router_copy(sw_router_t *dst, const sw_router_t *src)
+{
+    if (!dst || !src)
+        return SW_INVALID_PARAM;
+
+    if (dst != src)
+        memcpy(dst, src, sizeof(*dst));
+
+    if (src->routes)
+        memcpy(dst->own.entries, src->routes->entries, sizeof(dst->own.entries));
+    dst->routes = NULL;
+    dst->own.refs = 0;
+
+    return SW_OK;
+}
+
 /* ============================================================================
  * ROUTING CONFIGURATION
  * ============================================================================ */
@@ -52,13 +153,43 @@ sw_result_t sw_router_add_route(sw_router_t *router,
     if (output_port >= router->num_ports)
         return SW_WRONG_PORT;
 
-    router->routes[logical_addr].output_port = output_port;
-    router->routes[logical_addr].configured = 1;
-    router->routes[logical_addr].delete_addr = delete_addr ? 1u : 0u;
+    const sw_route_entry_t want = {output_port, 1, delete_addr ? 1u : 0u};
+    const sw_route_entry_t *cur = &sw_router_table(router)->entries[logical_addr];
+
+    /* Re-adding an unchanged route must not copy a shared table. */
+    if (cur->configured && cur->output_port == want.output_port &&
+        cur->delete_addr == want.delete_addr)
+        return SW_OK;
+
+    sw_router_writable(router)->entries[logical_addr] = want;
+    return SW_OK;
+}
+
+sw_result_t sw_router_remove_route(sw_router_t *router, uint8_t logical_addr)
+{
+    if (!router)
+        return SW_INVALID_PARAM;
+
+    if (logical_addr < SW_LOGICAL_ADDR_MIN || logical_addr == SW_LOGICAL_ADDR_RESERVED)
+        return SW_WRONG_ADDRESS;
 
+    if (!sw_router_table(router)->entries[logical_addr].configured)
+        return SW_OK;
+
+    sw_route_table_t *t = sw_router_writable(router);
+    memset(&t->entries[logical_addr], 0, sizeof(t->entries[logical_addr]));
     return SW_OK;
 }
 
+const sw_route_entry_t *sw_router_get_route(const sw_router_t *router, uint8_t logical_addr)
+{
+    if (!router)
+        return NULL;
+
+    const sw_route_entry_t *entry = &sw_router_table(router)->entries[logical_addr];
+    return entry->configured ? entry : NULL;
+}
+
 /* ============================================================================
  * ROUTING DECISION
  * ============================================================================ */
@@ -67,21 +198,33 @@ sw_result_t sw_router_add_route(sw_router_t *router,
  * @brief Discard a packet whose leading address references a non-existent port
  *        or an unconfigured routing-table entry (clause 5.6.8.5).
  * @param[in,out] router Router whose counters are updated.
+ * @param[in]     lead   Offending leading address character (logged).
  * @return Always ::SW_ROUTE_DISCARD.
  */
-static sw_route_result_t sw_router_invalid_address(sw_router_t *router)
+static sw_route_result_t sw_router_invalid_address(sw_router_t *router, uint8_t lead)
 {
     router->invalid_address_errors++;
     router->packets_discarded++;
 
+    sw_evlog_record(SW_EV_INVALID_ADDRESS, router, lead, 0);
+
     return SW_ROUTE_DISCARD;
 }
 
-sw_route_result_t sw_router_route(sw_router_t *router,
-                                  const uint8_t *packet,
-                                  size_t len,
-                                  uint8_t *output_port,
-                                  uint8_t *delete_leading)
+/**
+ * @brief Routing decision; sw_router_route() without the trace span.
+ * @param[in,out] router         Router.
+ * @param[in]     packet         Packet octets.
+ * @param[in]     len            Packet length.
+ * @param[out]    output_port    Selected output port.
+ * @param[out]    delete_leading Whether the leading address is deleted.
+ * @return ::SW_ROUTE_OK or ::SW_ROUTE_DISCARD.
+ */
+static sw_route_result_t sw_router_route_body(sw_router_t *router,
+                                              const uint8_t *packet,
+                                              size_t len,
+                                              uint8_t *output_port,
+                                              uint8_t *delete_leading)
 {
     if (!router || !packet || !output_port || !delete_leading)
         return SW_ROUTE_DISCARD;
@@ -101,7 +244,7 @@ sw_route_result_t sw_router_route(sw_router_t *router,
     {
         /* Path addressing (clause 5.6.8.3): the character names the output port. */
         if (lead >= router->num_ports)
-            return sw_router_invalid_address(router);
+            return sw_router_invalid_address(router, lead);
 
         *output_port = lead;
         *delete_leading = 1; /* a path address is always deleted (Table 5-11) */
@@ -114,10 +257,10 @@ sw_route_result_t sw_router_route(sw_router_t *router,
      * address that is unconfigured (including the reserved address 255) or that
      * maps to a non-existent port is discarded with an invalid-address error
      * (clause 5.6.8.5). */
-    const sw_route_entry_t *entry = &router->routes[lead];
+    const sw_route_entry_t *entry = &sw_router_table(router)->entries[lead];
 
     if (!entry->configured || entry->output_port >= router->num_ports)
-        return sw_router_invalid_address(router);
+        return sw_router_invalid_address(router, lead);
 
     *output_port = entry->output_port;
     *delete_leading = entry->delete_addr ? 1u : 0u; /* clause 5.6.8.6 */
@@ -126,6 +269,221 @@ sw_route_result_t sw_router_route(sw_router_t *router,
     return SW_ROUTE_OK;
 }
 
+sw_route_result_t sw_router_route(sw_router_t *router,
+                                  const uint8_t *packet,
+                                  size_t len,
+                                  uint8_t *output_port,
+                                  uint8_t *delete_leading)
+{
+    const uint64_t t = sw_trace_begin();
+    const sw_route_result_t r =
+        sw_router_route_body(router, packet, len, output_port, delete_leading);
+
+    sw_trace_end(t, SW_SPAN_ROUTE, router, r == SW_ROUTE_OK ? *output_port : 0xFFFFu);
+    return r;
+}
+
+/* ============================================================================
+ * EGRESS ADDRESS TRANSLATION
+ * ============================================================================ */
+
+void sw_xlat_init(sw_xlat_table_t *table)
+{
+    if (!table)
+        return;
+
+    memset(table, 0, sizeof(*table));
+}
+
+sw_result_t sw_xlat_set(sw_xlat_table_t *table,
+                        uint8_t lead,
+                        uint8_t strip,
+                        const uint8_t *prefix,
+                        uint8_t prefix_len)
+{
+    if (!table || prefix_len > SW_XLAT_MAX_PREFIX || (prefix_len > 0 && !prefix) ||
+        (strip == 0 && prefix_len == 0))
+        return SW_INVALID_PARAM;
+
+    sw_xlat_rule_t *rule = &table->rules[lead];
+    memset(rule, 0, sizeof(*rule));
+    rule->strip = strip;
+    rule->prefix_len = prefix_len;
+    if (prefix_len > 0)
+        memcpy(rule->prefix, prefix, prefix_len);
+    rule->configured = 1;
+
+    return SW_OK;
+}
+
+sw_result_t sw_xlat_clear(sw_xlat_table_t *table, uint8_t lead)
+{
+    if (!table)
+        return SW_INVALID_PARAM;
+
+    memset(&table->rules[lead], 0, sizeof(table->rules[lead]));
+    return SW_OK;
+}
+
+sw_result_t sw_xlat_apply(const sw_xlat_table_t *table,
+                          uint8_t *buf,
+                          size_t cap,
+                          size_t *off,
+                          size_t *len)
+{
+    if (!table || !buf || !off || !len || *off > cap || *len > cap - *off)
+        return SW_INVALID_PARAM;
+
+    if (*len == 0)
+        return SW_OK;
+
+    const sw_xlat_rule_t *rule = &table->rules[buf[*off]];
+    if (!rule->configured)
+        return SW_OK;
+
+    if (rule->strip > *len)
+        return SW_ERR;
+
+    /* The new address octets end where the cargo starts. Only if the
+     * headroom and the stripped octets cannot hold them does the cargo move
+     * towards the end of the buffer. */
+    size_t start = *off + rule->strip;
+    const size_t cargo = *len - rule->strip;
+
+    if (rule->prefix_len > start)
+    {
+        const size_t shift = rule->prefix_len - start;
+        if (shift > cap - start - cargo)
+            return SW_ERR;
+
+        memmove(&buf[start + shift], &buf[start], cargo);
+        start += shift;
+    }
+
+    memcpy(&buf[start - rule->prefix_len], rule->prefix, rule->prefix_len);
+    *off = start - rule->prefix_len;
+    *len = cargo + rule->prefix_len;
+
+    return SW_OK;
+}
+
+sw_result_t sw_router_set_xlat_ports(sw_router_t *router, const sw_xlat_table_t **ports)
+{
+    if (!router)
+        return SW_INVALID_PARAM;
+
+    router->xlat = ports;
+    return SW_OK;
+}
+
+sw_result_t sw_router_set_xlat(sw_router_t *router, uint8_t port, const sw_xlat_table_t *table)
+{
+    if (!router)
+        return SW_INVALID_PARAM;
+
+    if (port >= router->num_ports)
+        return SW_WRONG_PORT;
+
+    if (!router->xlat)
+        return SW_ERR;
+
+    router->xlat[port] = table;
+    return SW_OK;
+}
+
+sw_result_t sw_router_translate(const sw_router_t *router,
+                                uint8_t port,
+                                uint8_t *buf,
+                                size_t cap,
+                                size_t *off,
+                                size_t *len)
+{
+    if (!router || port >= router->num_ports)
+        return SW_INVALID_PARAM;
+
+    if (!router->xlat || !router->xlat[port])
+        return SW_OK;
+
+    return sw_xlat_apply(router->xlat[port], buf, cap, off, len);
+}
+
+/* ============================================================================
+ * MULTI-HOP RESOLUTION
+ * ============================================================================ */
+
+/**
+ * @brief One hop of sw_router_resolve(): the decision of sw_router_route()
+ *        without side effects.
+ * @param[in]     router Router at this hop.
+ * @param[in]     packet Packet octets.
+ * @param[in]     len    Packet length.
+ * @param[in,out] off    Offset of the leading address; advanced past it if
+ *                       the router deletes it.
+ * @param[out]    port   Selected output port.
+ * @return ::SW_ROUTE_OK or ::SW_ROUTE_DISCARD.
+ */
+static sw_route_result_t sw_router_resolve_hop(const sw_router_t *router,
+                                               const uint8_t *packet,
+                                               size_t len,
+                                               size_t *off,
+                                               uint8_t *port)
+{
+    /* Running out of octets is an empty packet at this router (clause 5.6.2.1). */
+    if (!router || *off >= len)
+        return SW_ROUTE_DISCARD;
+
+    const uint8_t lead = packet[*off];
+
+    if (lead <= SW_PATH_ADDR_MAX)
+    {
+        if (lead >= router->num_ports)
+            return SW_ROUTE_DISCARD;
+
+        *port = lead;
+        (*off)++;
+        return SW_ROUTE_OK;
+    }
+
+    const sw_route_entry_t *entry = &sw_router_table(router)->entries[lead];
+
+    if (!entry->configured || entry->output_port >= router->num_ports)
+        return SW_ROUTE_DISCARD;
+
+    *port = entry->output_port;
+    *off += entry->delete_addr ? 1u : 0u;
+    return SW_ROUTE_OK;
+}
+
+sw_route_result_t sw_router_resolve(const sw_router_t *const *routers,
+                                    size_t num_routers,
+                                    const uint8_t *packet,
+                                    size_t len,
+                                    uint8_t *ports,
+                                    size_t *consumed,
+                                    size_t *hops)
+{
+    sw_route_result_t r = (routers && packet && ports) ? SW_ROUTE_OK : SW_ROUTE_DISCARD;
+    size_t off = 0;
+    size_t i = 0;
+
+    while (r == SW_ROUTE_OK && i < num_routers)
+    {
+        r = sw_router_resolve_hop(routers[i], packet, len, &off, &ports[i]);
+        if (r != SW_ROUTE_OK)
+            break;
+
+        /* The configuration port consumes the packet; no router follows. */
+        if (ports[i++] == SW_PORT_CONFIG)
+            break;
+    }
+
+    if (consumed)
+        *consumed = off;
+    if (hops)
+        *hops = i;
+    return r;
+}
+
 /* ============================================================================
  * LINK STATE MANAGEMENT (STUB)
  * ============================================================================ */
@@ -154,5 +512,8 @@ void sw_link_set_state(sw_link_layer_t *link, sw_link_state_t state)
     if (!link)
         return;
 
+    if (link->state != state)
+        sw_evlog_record(SW_EV_LINK_STATE, link, (uint16_t)state, (uint8_t)link->state);
+
     link->state = state;
 }
@@ -0,0 +1,215 @@
+/**
+ * @file spacewire_rss.c
+ * @brief Flow-hash receive steering across decode worker threads.
+ */
+
+#include "../include/spacewire_rss.h"
+
+#include "spacewire_atomic.h"
+
+#include <string.h>
+
+sw_result_t sw_rss_init(sw_rss_t *rss, sw_ring_t *rings, uint8_t num_workers, uint32_t seed)
+{
+    if (!rss || !rings || num_workers == 0 || num_workers > SW_RSS_MAX_WORKERS)
+        return SW_INVALID_PARAM;
+
+    memset(rss, 0, sizeof(*rss));
+    rss->rings = rings;
+    rss->num_workers = num_workers;
+    rss->seed = seed;
+
+    for (uint32_t b = 0; b < SW_RSS_BUCKETS; b++)
+    {
+        rss->buckets[b].worker = (uint8_t)(b % num_workers);
+        rss->buckets[b].target = rss->buckets[b].worker;
+        rss->buckets[b].last = rings[b % num_workers].tail;
+    }
+
+    return SW_OK;
+}
+
+uint32_t sw_rss_flow_key(const uint8_t *pkt, size_t len)
+{
+    if (!pkt || len == 0)
+        return 0;
+
+    /* [addr | 0x02 | 0x00 | user app | primary header ...]; APID in octets 4-5. */
+    if (len >= SW_PTP_HEADER_LEN + 2u && pkt[1] == SW_PTP_PROTOCOL_ID)
+        return SW_TOPK_KEY(pkt[0], pkt[3], ((uint32_t)(pkt[4] & 0x07u) << 8) | pkt[5]);
+
+    return SW_TOPK_KEY(pkt[0], 0u, SW_TOPK_NO_APID);
+}
+
+/**
+ * @brief 1 if the bucket's last packet has left its worker's ring.
+ *
+ * @p tail is the ring's tail including descriptors of the current batch not
+ * yet pushed. The packet at position `last - 1` is still queued while
+ * `last` lies in (head, tail].
+ */
+static int sw_rss_drained(const sw_rss_t *rss, const sw_rss_bucket_t *bk, uint32_t tail)
+{
+    const uint32_t head = SW_ATOMIC_LOAD_ACQUIRE(&rss->rings[bk->worker].head);
+    return tail - bk->last >= tail - head;
+}
+
+/** @brief Free slots of a worker ring, as seen by its producer. */
+static uint32_t sw_rss_room(const sw_ring_t *ring)
+{
+    return ring->mask + 1u - (ring->tail - SW_ATOMIC_LOAD_ACQUIRE(&ring->head));
+}
+
+uint32_t sw_rss_steer_burst(sw_rss_t *rss, const sw_desc_t *descs, uint32_t n)
+{
+    if (!rss || !descs)
+        return 0;
+
+    uint32_t room[SW_RSS_MAX_WORKERS];
+    uint32_t base[SW_RSS_MAX_WORKERS];
+    uint32_t need[SW_RSS_MAX_WORKERS];
+    uint8_t touched[SW_RSS_MAX_WORKERS];
+    uint8_t seen[SW_RSS_MAX_WORKERS];
+    uint8_t worker_of[SW_RSS_BATCH];
+    sw_desc_t sorted[SW_RSS_BATCH];
+    uint32_t done = 0;
+
+    memset(seen, 0, rss->num_workers);
+
+    while (done < n)
+    {
+        const uint32_t chunk = n - done < SW_RSS_BATCH ? n - done : SW_RSS_BATCH;
+        unsigned num_touched = 0;
+        uint32_t k = 0;
+
+        /* Pass 1: choose each packet's worker while its ring has room. */
+        for (; k < chunk; k++)
+        {
+            const sw_desc_t *d = &descs[done + k];
+            sw_rss_bucket_t *bk =
+                &rss->buckets[sw_rss_bucket(rss, sw_rss_flow_key(sw_desc_data(d), d->len))];
+
+            if (bk->target != bk->worker)
+            {
+                const uint8_t old = bk->worker;
+                const uint32_t tail = seen[old] ? base[old] + need[old] : rss->rings[old].tail;
+                if (sw_rss_drained(rss, bk, tail))
+                {
+                    bk->worker = bk->target;
+                    rss->moves++;
+                }
+            }
+
+            const uint8_t w = bk->worker;
+            if (!seen[w])
+            {
+                seen[w] = 1;
+                touched[num_touched++] = w;
+                base[w] = rss->rings[w].tail;
+                room[w] = sw_rss_room(&rss->rings[w]);
+                need[w] = 0;
+            }
+            if (need[w] == room[w])
+                break;
+
+            bk->last = base[w] + ++need[w];
+            bk->load += d->len;
+            worker_of[k] = w;
+        }
+
+        /* Pass 2: group the batch by worker, keeping the order within each. */
+        uint32_t offset[SW_RSS_MAX_WORKERS];
+        uint32_t at = 0;
+        for (unsigned t = 0; t < num_touched; t++)
+        {
+            offset[touched[t]] = at;
+            at += need[touched[t]];
+        }
+        for (uint32_t i = 0; i < k; i++)
+            sorted[offset[worker_of[i]]++] = descs[done + i];
+
+        at = 0;
+        for (unsigned t = 0; t < num_touched; t++)
+        {
+            const uint8_t w = touched[t];
+            if (need[w] > 0)
+                sw_ring_push_burst(&rss->rings[w], &sorted[at], need[w]);
+            rss->packets[w] += need[w];
+            at += need[w];
+            seen[w] = 0;
+        }
+
+        done += k;
+        if (k < chunk)
+            break;
+    }
+
+    return done;
+}
+
+sw_result_t sw_rss_move(sw_rss_t *rss, uint32_t bucket, uint8_t worker)
+{
+    if (!rss || bucket >= SW_RSS_BUCKETS || worker >= rss->num_workers)
+        return SW_INVALID_PARAM;
+
+    sw_rss_bucket_t *bk = &rss->buckets[bucket];
+    bk->target = worker;
+
+    /* Nothing of the bucket queued: move at once. */
+    if (bk->target != bk->worker && sw_rss_drained(rss, bk, rss->rings[bk->worker].tail))
+    {
+        bk->worker = worker;
+        rss->moves++;
+    }
+
+    return SW_OK;
+}
+
+uint32_t sw_rss_rebalance(sw_rss_t *rss)
+{
+    if (!rss)
+        return 0;
+
+    uint64_t load[SW_RSS_MAX_WORKERS] = {0};
+    uint32_t moved = 0;
+
+    for (uint32_t b = 0; b < SW_RSS_BUCKETS; b++)
+        load[rss->buckets[b].target] += rss->buckets[b].load;
+
+    /* Every move lowers the sum of squared loads, so this ends; the bound
+     * is only a guard. */
+    for (uint32_t iter = 0; iter < SW_RSS_BUCKETS; iter++)
+    {
+        uint8_t hi = 0;
+        uint8_t lo = 0;
+        for (uint8_t w = 1; w < rss->num_workers; w++)
+        {
+            if (load[w] > load[hi])
+                hi = w;
+            if (load[w] < load[lo])
+                lo = w;
+        }
+
+        const uint64_t gap = load[hi] - load[lo];
+        uint32_t best = SW_RSS_BUCKETS;
+        for (uint32_t b = 0; b < SW_RSS_BUCKETS; b++)
+        {
+            const sw_rss_bucket_t *bk = &rss->buckets[b];
+            if (bk->target == hi && bk->load > 0 && bk->load < gap &&
+                (best == SW_RSS_BUCKETS || bk->load > rss->buckets[best].load))
+                best = b;
+        }
+        if (best == SW_RSS_BUCKETS)
+            break;
+
+        load[hi] -= rss->buckets[best].load;
+        load[lo] += rss->buckets[best].load;
+        sw_rss_move(rss, best, lo);
+        moved++;
+    }
+
+    for (uint32_t b = 0; b < SW_RSS_BUCKETS; b++)
+        rss->buckets[b].load /= 2u;
+
+    return moved;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file spacewire_sched.c
+ * @brief Work-stealing scheduler for port processing.
+ *
+ * Run queues are Chase-Lev deques (Lê et al., "Correct and efficient
+ * work-stealing for weak memory models", PPoPP 2013). Only the owner pushes at
+ * the bottom; everyone, the owner included, takes from the top. Taking from
+ * the top keeps the owner's ports in round-robin order — popping the bottom
+ * would re-run the port just pushed and starve the others.
+ *
+ * Indices are free-running 32-bit counters compared modulo 2^32. A queue can
+ * never fill: every task is in at most one queue and there are no more tasks
+ * than slots.
+ */
+
+#include "../include/spacewire_sched.h"
+
+#include "spacewire_atomic.h"
+
+#include <string.h>
+
+#if (SW_SCHED_MAX_TASKS & (SW_SCHED_MAX_TASKS - 1u)) != 0
+#    error "SW_SCHED_MAX_TASKS must be a power of two"
+#endif
+
+/* ============================================================================
+ * RUN QUEUE
+ * ============================================================================ */
+
+/**
+ * @brief Append a task to a worker's queue (owner only).
+ */
+static void sw_sched_push(sw_sched_worker_t *w, uint16_t task)
+{
+    const uint32_t b = SW_ATOMIC_LOAD_RELAXED(&w->bottom);
+
+    SW_ATOMIC_STORE_RELAXED(&w->tasks[b & (SW_SCHED_MAX_TASKS - 1u)], task);
+    SW_ATOMIC_FENCE_RELEASE();
+    SW_ATOMIC_STORE_RELAXED(&w->bottom, b + 1u);
+}
+
+/**
+ * @brief Take the oldest task from a worker's queue (any worker).
+ * @param[in,out] w    Queue owner.
+ * @param[out]    task Task taken.
+ * @return 1 if a task was taken, 0 if the queue was empty or the race lost.
+ */
+static int sw_sched_take(sw_sched_worker_t *w, uint16_t *task)
+{
+    uint32_t t = SW_ATOMIC_LOAD_ACQUIRE(&w->top);
+    SW_ATOMIC_FENCE_SEQ_CST();
+    const uint32_t b = SW_ATOMIC_LOAD_ACQUIRE(&w->bottom);
+
+    if ((int32_t)(b - t) <= 0)
+        return 0;
+
+    const uint16_t x = SW_ATOMIC_LOAD_RELAXED(&w->tasks[t & (SW_SCHED_MAX_TASKS - 1u)]);
+    if (!SW_ATOMIC_CAS(&w->top, &t, t + 1u))
+        return 0;
+
+    *task = x;
+    return 1;
+}
+
+/**
+ * @brief Steal one task from any other worker, visiting victims round-robin.
+ * @param[in,out] sched Scheduler.
+ * @param[in]     self  Index of the thief.
+ * @param[out]    task  Task stolen.
+ * @return 1 if a task was stolen, else 0.
+ */
+static int sw_sched_steal(sw_sched_t *sched, unsigned self, uint16_t *task)
+{
+    sw_sched_worker_t *me = &sched->workers[self];
+
+    /* Start with the last successful victim: it is the likeliest to have work. */
+    for (unsigned i = 0; i < sched->num_workers; i++)
+    {
+        const unsigned v = (me->victim + i) % sched->num_workers;
+        if (v == self)
+            continue;
+
+        if (sw_sched_take(&sched->workers[v], task))
+        {
+            me->victim = v;
+            me->steals++;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* ============================================================================
+ * SCHEDULER
+ * ============================================================================ */
+
+sw_result_t sw_sched_init(sw_sched_t *sched,
+                          sw_sched_worker_t *workers,
+                          unsigned num_workers,
+                          uint16_t num_tasks,
+                          sw_sched_poll_fn poll,
+                          void *ctx,
+                          uint32_t flags)
+{
+    if (!sched || !workers || num_workers == 0 || !poll)
+        return SW_INVALID_PARAM;
+
+    if (num_tasks == 0 || num_tasks > SW_SCHED_MAX_TASKS)
+        return SW_INVALID_PARAM;
+
+    memset(workers, 0, (size_t)num_workers * sizeof(*workers));
+
+    for (unsigned w = 0; w < num_workers; w++)
+        workers[w].victim = w;
+
+    for (uint16_t t = 0; t < num_tasks; t++)
+        sw_sched_push(&workers[t % num_workers], t);
+
+    sched->workers = workers;
+    sched->num_workers = num_workers;
+    sched->num_tasks = num_tasks;
+    sched->flags = flags;
+    sched->poll = poll;
+    sched->ctx = ctx;
+
+    return SW_OK;
+}
+
+size_t sw_sched_run_once(sw_sched_t *sched, unsigned worker)
+{
+    if (!sched || worker >= sched->num_workers)
+        return 0;
+
+    sw_sched_worker_t *me = &sched->workers[worker];
+    const int may_steal = !(sched->flags & SW_SCHED_STATIC) && sched->num_workers > 1;
+
+    uint16_t task = 0;
+    int have = 0;
+
+    /* Our own ports went quiet: look for a busy port elsewhere first. */
+    if (may_steal && me->last_idle)
+        have = sw_sched_steal(sched, worker, &task);
+
+    if (!have)
+        have = sw_sched_take(me, &task);
+
+    if (!have && may_steal)
+        have = sw_sched_steal(sched, worker, &task);
+
+    if (!have)
+    {
+        me->empty_polls++;
+        return 0;
+    }
+
+    const size_t n = sched->poll(sched->ctx, task, worker);
+
+    /* The task rejoins this worker's queue: a stolen port migrates here. */
+    sw_sched_push(me, task);
+
+    if (n > 0)
+    {
+        me->busy_polls++;
+        me->packets += n;
+        me->last_idle = 0;
+    }
+    else
+    {
+        me->idle_polls++;
+        me->last_idle = 1;
+    }
+
+    return n;
+}
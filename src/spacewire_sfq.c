@@ -0,0 +1,362 @@
+/**
+ * @file spacewire_sfq.c
+ * @brief Disk-backed store-and-forward queue for an output port or VC.
+ */
+
+#include "../include/spacewire_sfq.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/** @brief Record kinds. */
+#define SW_SFQ_KIND_PACKET 1u
+#define SW_SFQ_KIND_PAD 2u
+
+/** @brief Smallest record log accepted by sw_sfq_format(). */
+#define SW_SFQ_MIN_LOG 4096u
+
+/* ============================================================================
+ * LAYOUT
+ * ============================================================================ */
+
+/** @brief FNV-1a over 64-bit words, then the remaining octets. */
+static uint64_t sw_sfq_hash(uint64_t h, const uint8_t *p, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 8u <= len; i += 8u)
+    {
+        uint64_t w;
+        memcpy(&w, &p[i], sizeof(w));
+        h = (h ^ w) * 0x100000001B3u;
+    }
+    for (; i < len; i++)
+        h = (h ^ p[i]) * 0x100000001B3u;
+
+    return h;
+}
+
+static uint32_t sw_sfq_fold(uint64_t h)
+{
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/** @brief Checksum of a record: its header with the checksum zeroed, then the packet. */
+static uint32_t sw_sfq_record_checksum(const sw_sfq_record_t *rec, const uint8_t *pkt)
+{
+    sw_sfq_record_t hdr = *rec;
+    hdr.checksum = 0;
+
+    uint64_t h = sw_sfq_hash(0xCBF29CE484222325u, (const uint8_t *)&hdr, sizeof(hdr));
+    if (pkt)
+        h = sw_sfq_hash(h, pkt, rec->len);
+    return sw_sfq_fold(h);
+}
+
+static uint32_t sw_sfq_super_checksum(const sw_sfq_super_t *sb)
+{
+    sw_sfq_super_t copy = *sb;
+    copy.checksum = 0;
+    return sw_sfq_fold(sw_sfq_hash(0xCBF29CE484222325u, (const uint8_t *)&copy, sizeof(copy)));
+}
+
+/** @brief Log octets a record of @p len occupies. */
+static uint64_t sw_sfq_record_size(uint64_t len)
+{
+    return (sizeof(sw_sfq_record_t) + len + SW_SFQ_ALIGN - 1u) & ~(uint64_t)(SW_SFQ_ALIGN - 1u);
+}
+
+static sw_sfq_record_t *sw_sfq_at(const sw_sfq_t *q, uint64_t pos)
+{
+    return (sw_sfq_record_t *)(void *)(q->log + pos % q->data_size);
+}
+
+/** @brief Step over the end of the log if no record header fits before it. */
+static uint64_t sw_sfq_skip(const sw_sfq_t *q, uint64_t pos)
+{
+    const uint64_t room = q->data_size - pos % q->data_size;
+    return room < sizeof(sw_sfq_record_t) ? pos + room : pos;
+}
+
+/** @brief Oldest unforwarded record, or the head if there is none. */
+static uint64_t sw_sfq_tail(const sw_sfq_t *q)
+{
+    uint64_t tail = q->head;
+
+    for (unsigned p = 0; p < SW_SFQ_PRIORITIES; p++)
+        if (q->pending[p] > 0 && q->next[p] < tail)
+            tail = q->next[p];
+    return tail;
+}
+
+/**
+ * @brief Whether a whole, intact record is stored at @p pos.
+ *
+ * @return Its log size, or 0.
+ */
+static uint64_t sw_sfq_valid(const sw_sfq_t *q, uint64_t pos)
+{
+    const sw_sfq_record_t *rec = sw_sfq_at(q, pos);
+    const uint64_t room = q->data_size - pos % q->data_size;
+
+    if (rec->pos != pos || sw_sfq_record_size(rec->len) > room)
+        return 0;
+    if (rec->kind == SW_SFQ_KIND_PAD)
+        return sw_sfq_record_checksum(rec, NULL) == rec->checksum ? room : 0;
+    if (rec->kind != SW_SFQ_KIND_PACKET || rec->priority >= SW_SFQ_PRIORITIES || rec->len == 0)
+        return 0;
+    if (sw_sfq_record_checksum(rec, (const uint8_t *)(rec + 1)) != rec->checksum)
+        return 0;
+    return sw_sfq_record_size(rec->len);
+}
+
+size_t sw_sfq_region_size(uint64_t data_size)
+{
+    return (size_t)(SW_SFQ_META_SIZE + data_size);
+}
+
+/* ============================================================================
+ * STATE
+ * ============================================================================ */
+
+sw_result_t sw_sfq_commit(sw_sfq_t *q)
+{
+    if (!q || !q->region)
+        return SW_INVALID_PARAM;
+
+    sw_sfq_super_t sb;
+    memset(&sb, 0, sizeof(sb));
+    sb.magic = SW_SFQ_MAGIC;
+    sb.version = SW_SFQ_VERSION;
+    sb.generation = q->generation + 1u;
+    sb.data_size = q->data_size;
+    sb.head = q->head;
+    sb.tail = sw_sfq_tail(q);
+    for (unsigned p = 0; p < SW_SFQ_PRIORITIES; p++)
+        sb.next[p] = q->pending[p] > 0 ? q->next[p] : q->head;
+    sb.checksum = sw_sfq_super_checksum(&sb);
+
+    /* Overwrite the older copy; the newer one stays whole meanwhile. */
+    memcpy(q->region + (sb.generation % 2u) * SW_SFQ_META_SLOT, &sb, sizeof(sb));
+    q->generation = sb.generation;
+    q->tail = sb.tail;
+
+    return SW_OK;
+}
+
+sw_result_t sw_sfq_format(sw_sfq_t *q, void *region, size_t size)
+{
+    if (!q || !region || ((uintptr_t)region & 7u) != 0 || size < SW_SFQ_META_SIZE)
+        return SW_INVALID_PARAM;
+
+    const uint64_t data_size = (size - SW_SFQ_META_SIZE) & ~(uint64_t)(SW_SFQ_ALIGN - 1u);
+    if (data_size < SW_SFQ_MIN_LOG)
+        return SW_INVALID_PARAM;
+
+    memset(q, 0, sizeof(*q));
+    q->region = region;
+    q->log = q->region + SW_SFQ_META_SIZE;
+    q->data_size = data_size;
+    memset(q->region, 0, SW_SFQ_META_SIZE);
+
+    return sw_sfq_commit(q);
+}
+
+/** @brief Read superblock @p slot if it is valid for a region of @p size. */
+static int sw_sfq_read_super(const uint8_t *region, size_t size, unsigned slot, sw_sfq_super_t *sb)
+{
+    memcpy(sb, region + slot * SW_SFQ_META_SLOT, sizeof(*sb));
+
+    if (sb->magic != SW_SFQ_MAGIC || sb->version != SW_SFQ_VERSION ||
+        sb->checksum != sw_sfq_super_checksum(sb))
+        return 0;
+    if (sb->data_size < SW_SFQ_MIN_LOG || sb->data_size % SW_SFQ_ALIGN != 0 ||
+        sb->data_size > size - SW_SFQ_META_SIZE)
+        return 0;
+    if (sb->tail > sb->head || sb->head - sb->tail > sb->data_size)
+        return 0;
+    for (unsigned p = 0; p < SW_SFQ_PRIORITIES; p++)
+        if (sb->next[p] < sb->tail || sb->next[p] > sb->head)
+            return 0;
+    return 1;
+}
+
+sw_result_t sw_sfq_open(sw_sfq_t *q, void *region, size_t size)
+{
+    if (!q || !region || ((uintptr_t)region & 7u) != 0 || size < SW_SFQ_META_SIZE)
+        return SW_INVALID_PARAM;
+
+    sw_sfq_super_t sb[2];
+    const int ok0 = sw_sfq_read_super(region, size, 0, &sb[0]);
+    const int ok1 = sw_sfq_read_super(region, size, 1, &sb[1]);
+    if (!ok0 && !ok1)
+        return SW_ERR;
+    const sw_sfq_super_t *s = !ok1 || (ok0 && sb[0].generation > sb[1].generation) ? &sb[0]
+                                                                                     : &sb[1];
+
+    memset(q, 0, sizeof(*q));
+    q->region = region;
+    q->log = q->region + SW_SFQ_META_SIZE;
+    q->data_size = s->data_size;
+    q->generation = s->generation;
+    q->tail = s->tail;
+
+    /* Walk the committed records, counting those not yet forwarded, then
+     * the records appended after the commit. The first record that is not
+     * intact ends the log. */
+    uint64_t pos = s->tail;
+    uint64_t size_at;
+
+    for (;;)
+    {
+        pos = sw_sfq_skip(q, pos);
+        size_at = sw_sfq_valid(q, pos);
+        if (size_at == 0 || pos + size_at - s->tail > q->data_size)
+            break;
+
+        const sw_sfq_record_t *rec = sw_sfq_at(q, pos);
+        const unsigned p = rec->priority;
+        if (rec->kind == SW_SFQ_KIND_PACKET && pos >= s->next[p])
+        {
+            if (q->pending[p]++ == 0)
+                q->next[p] = pos;
+        }
+        pos += size_at;
+    }
+
+    q->head = pos;
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * QUEUE
+ * ============================================================================ */
+
+uint64_t sw_sfq_used(const sw_sfq_t *q)
+{
+    return q ? q->head - q->tail : 0;
+}
+
+sw_result_t sw_sfq_push(sw_sfq_t *q, uint8_t priority, const uint8_t *pkt, uint32_t len)
+{
+    if (!q || !q->region || !pkt || len == 0 || priority >= SW_SFQ_PRIORITIES)
+        return SW_INVALID_PARAM;
+
+    const uint64_t need = sw_sfq_record_size(len);
+    uint64_t pos = sw_sfq_skip(q, q->head);
+    uint64_t room = q->data_size - pos % q->data_size;
+    uint64_t at = pos;
+
+    /* A record never wraps: pad the rest of the log and start over. Space
+     * is free only behind the committed tail, which a reopen reads from. */
+    if (need > room)
+        at = pos + room;
+    if (at + need - q->tail > q->data_size)
+    {
+        q->rejected++;
+        return SW_ERR;
+    }
+
+    if (at != pos)
+    {
+        sw_sfq_record_t *pad = sw_sfq_at(q, pos);
+        memset(pad, 0, sizeof(*pad));
+        pad->pos = pos;
+        pad->len = (uint32_t)(room - sizeof(*pad));
+        pad->kind = SW_SFQ_KIND_PAD;
+        pad->checksum = sw_sfq_record_checksum(pad, NULL);
+    }
+
+    sw_sfq_record_t *rec = sw_sfq_at(q, at);
+    memset(rec, 0, sizeof(*rec));
+    rec->pos = at;
+    rec->len = len;
+    rec->priority = priority;
+    rec->kind = SW_SFQ_KIND_PACKET;
+    memcpy(rec + 1, pkt, len);
+    rec->checksum = sw_sfq_record_checksum(rec, pkt);
+
+    if (q->pending[priority]++ == 0)
+        q->next[priority] = at;
+    q->head = at + need;
+    q->spilled++;
+
+    return SW_OK;
+}
+
+/** @brief Most urgent priority with a record waiting, or SW_SFQ_PRIORITIES. */
+static unsigned sw_sfq_first(const sw_sfq_t *q)
+{
+    unsigned p = 0;
+    while (p < SW_SFQ_PRIORITIES && q->pending[p] == 0)
+        p++;
+    return p;
+}
+
+sw_result_t sw_sfq_peek(const sw_sfq_t *q, const uint8_t **pkt, uint32_t *len, uint8_t *priority)
+{
+    if (!q || !pkt || !len)
+        return SW_INVALID_PARAM;
+
+    const unsigned p = sw_sfq_first(q);
+    if (p == SW_SFQ_PRIORITIES)
+        return SW_ERR;
+
+    const sw_sfq_record_t *rec = sw_sfq_at(q, q->next[p]);
+    *pkt = (const uint8_t *)(rec + 1);
+    *len = rec->len;
+    if (priority)
+        *priority = (uint8_t)p;
+
+    return SW_OK;
+}
+
+sw_result_t sw_sfq_pop(sw_sfq_t *q)
+{
+    if (!q)
+        return SW_INVALID_PARAM;
+
+    const unsigned p = sw_sfq_first(q);
+    if (p == SW_SFQ_PRIORITIES)
+        return SW_ERR;
+
+    q->forwarded++;
+    if (--q->pending[p] == 0)
+        return SW_OK;
+
+    /* Step over other priorities' records to the next one of this priority. */
+    uint64_t pos = q->next[p] + sw_sfq_record_size(sw_sfq_at(q, q->next[p])->len);
+    for (;;)
+    {
+        pos = sw_sfq_skip(q, pos);
+        const sw_sfq_record_t *rec = sw_sfq_at(q, pos);
+        if (rec->kind == SW_SFQ_KIND_PACKET && rec->priority == p)
+            break;
+        pos += sw_sfq_record_size(rec->len);
+    }
+    q->next[p] = pos;
+
+    return SW_OK;
+}
+
+size_t sw_sfq_drain(sw_sfq_t *q, sw_sfq_send_fn send, void *ctx, size_t max)
+{
+    if (!q || !send)
+        return 0;
+
+    size_t n = 0;
+    const uint8_t *pkt;
+    uint32_t len;
+    uint8_t priority;
+
+    while (n < max && sw_sfq_peek(q, &pkt, &len, &priority) == SW_OK)
+    {
+        if (send(ctx, priority, pkt, len) != 0)
+            break;
+        sw_sfq_pop(q);
+        n++;
+    }
+
+    return n;
+}
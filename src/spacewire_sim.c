@@ -0,0 +1,589 @@
+/**
+ * @file spacewire_sim.c
+ * @brief Discrete-event simulation of a SpaceWire network, with link-failure
+ *        trials.
+ *
+ * A link failure is detected on the receiving side: each port counts the
+ * failures of its link (its epoch), and a packet carries the epoch of the
+ * port it left. Both ends of a link see the same failures at the same time,
+ * so a packet that arrives with an epoch other than its input port's was on
+ * the wire when the link went down.
+ */
+
+#include "../include/spacewire_sim.h"
+
+#include <string.h>
+
+/* ============================================================================
+ * RANDOM NUMBERS
+ * ============================================================================ */
+
+/** @brief SplitMix64 step, used to derive independent stream seeds. */
+static uint64_t sw_sim_mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/** @brief xorshift64* step; the state must be non-zero. */
+static uint64_t sw_sim_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+/** @brief Uniform value in [0, n); n > 0. */
+static uint64_t sw_sim_below(uint64_t *state, uint64_t n)
+{
+    return sw_sim_rand(state) % n;
+}
+
+/* ============================================================================
+ * EVENT QUEUE
+ * ============================================================================ */
+
+/** @brief Event order: time, node, scheduling node, sequence number. */
+static int sw_sim_before(const sw_sim_event_t *a, const sw_sim_event_t *b)
+{
+    if (a->time != b->time)
+        return a->time < b->time;
+    if (a->node != b->node)
+        return a->node < b->node;
+    if (a->origin != b->origin)
+        return a->origin < b->origin;
+    return a->seq < b->seq;
+}
+
+/**
+ * @brief Queue an event.
+ * @return ::SW_OK, or ::SW_ERR (counted as an overflow) if the queue is full.
+ */
+static sw_result_t sw_sim_push(sw_sim_t *sim, const sw_sim_event_t *ev)
+{
+    if (sim->num_events >= sim->max_events)
+    {
+        sim->overflows++;
+        return SW_ERR;
+    }
+
+    uint32_t i = sim->num_events++;
+    while (i > 0)
+    {
+        const uint32_t parent = (i - 1u) / 2u;
+        if (!sw_sim_before(ev, &sim->events[parent]))
+            break;
+        sim->events[i] = sim->events[parent];
+        i = parent;
+    }
+    sim->events[i] = *ev;
+
+    return SW_OK;
+}
+
+/**
+ * @brief Remove the earliest event into @p ev; the queue must not be empty.
+ */
+static void sw_sim_pop(sw_sim_t *sim, sw_sim_event_t *ev)
+{
+    *ev = sim->events[0];
+
+    const uint32_t len = --sim->num_events;
+    if (len == 0)
+        return;
+
+    const sw_sim_event_t last = sim->events[len];
+    uint32_t i = 0;
+
+    for (;;)
+    {
+        uint32_t c = 2u * i + 1u;
+        if (c >= len)
+            break;
+        if (c + 1u < len && sw_sim_before(&sim->events[c + 1u], &sim->events[c]))
+            c++;
+        if (!sw_sim_before(&sim->events[c], &last))
+            break;
+        sim->events[i] = sim->events[c];
+        i = c;
+    }
+    sim->events[i] = last;
+}
+
+/**
+ * @brief Queue an event scheduled by @p origin at its own next sequence
+ *        number (or an external one for ::SW_NET_NONE).
+ */
+static sw_result_t sw_sim_schedule(sw_sim_t *sim, uint16_t origin, sw_sim_event_t *ev)
+{
+    ev->origin = origin;
+    ev->seq = origin == SW_NET_NONE ? sim->seq++ : sim->nodes[origin].next_seq++;
+
+    if (sim->owner && sim->owner[ev->node] != sim->partition)
+        return sim->remote(sim, sim->remote_ctx, ev);
+
+    return sw_sim_push(sim, ev);
+}
+
+/* ============================================================================
+ * PACKET HANDLING
+ * ============================================================================ */
+
+/** @brief Count a lost packet at node @p n. */
+static void sw_sim_lose(sw_sim_t *sim, uint16_t n, uint32_t *counter)
+{
+    (*counter)++;
+    sim->nodes[n].stats.last_loss_ns = sim->now;
+}
+
+/** @brief Count a packet delivered at node @p n. */
+static void sw_sim_deliver(sw_sim_t *sim, uint16_t n, const sw_sim_event_t *pkt)
+{
+    sw_sim_stats_t *st = &sim->nodes[n].stats;
+    const uint64_t latency = sim->now - pkt->created;
+
+    st->delivered++;
+    st->latency_sum_ns += latency;
+    if (latency > st->latency_max_ns)
+        st->latency_max_ns = latency;
+}
+
+/**
+ * @brief Route a packet at node @p n and send it on.
+ * @param[in,out] pkt Packet (an event); reused as the arrival event.
+ */
+static void sw_sim_forward(sw_sim_t *sim, uint16_t n, sw_sim_event_t *pkt)
+{
+    sw_net_node_t *node = &sim->net->nodes[n];
+    sw_sim_node_t *state = &sim->nodes[n];
+
+    if (pkt->hops >= SW_SIM_MAX_HOPS)
+    {
+        sw_sim_lose(sim, n, &state->stats.lost_hops);
+        return;
+    }
+
+    uint8_t port = 0;
+    uint8_t del = 0;
+    if (sw_router_route(&node->router, pkt->hdr, pkt->hdr_len, &port, &del) != SW_ROUTE_OK)
+    {
+        sw_sim_lose(sim, n, &state->stats.lost_no_route);
+        return;
+    }
+
+    if (del)
+    {
+        memmove(pkt->hdr, &pkt->hdr[1], (size_t)pkt->hdr_len - 1u);
+        pkt->hdr_len--;
+        pkt->len--;
+    }
+
+    if (port == SW_PORT_CONFIG)
+    {
+        sw_sim_deliver(sim, n, pkt);
+        return;
+    }
+
+    const uint16_t l = node->port_link[port];
+    if (l == SW_NET_NONE || node->router.links[port].state != SW_LINK_CONNECTED)
+    {
+        node->router.links[port].errors++;
+        sw_sim_lose(sim, n, &state->stats.lost_link);
+        return;
+    }
+
+    const sw_net_link_t *link = &sim->net->links[l];
+    const uint64_t tx_ns = (uint64_t)pkt->len * 10u * 1000000000u / link->bit_rate;
+    const uint64_t depart = state->busy_until[port] > sim->now ? state->busy_until[port] : sim->now;
+
+    state->busy_until[port] = depart + tx_ns;
+    node->router.links[port].tx_packets++;
+
+    uint8_t peer_port = 0;
+    pkt->node = sw_net_peer(sim->net, n, port, &peer_port);
+    pkt->type = SW_SIM_EV_ARRIVE;
+    pkt->port = peer_port;
+    pkt->epoch = state->epoch[port];
+    pkt->hops++;
+    pkt->time = depart + tx_ns + link->latency_ns;
+
+    if (sw_sim_schedule(sim, n, pkt) != SW_OK)
+        sw_sim_lose(sim, n, &state->stats.lost_link);
+}
+
+/** @brief Handle a packet arriving at node @p n. */
+static void sw_sim_arrive(sw_sim_t *sim, uint16_t n, sw_sim_event_t *pkt)
+{
+    sw_net_node_t *node = &sim->net->nodes[n];
+    sw_sim_node_t *state = &sim->nodes[n];
+    sw_link_t *in = &node->router.links[pkt->port];
+
+    if (in->state != SW_LINK_CONNECTED || state->epoch[pkt->port] != pkt->epoch)
+    {
+        in->errors++;
+        sw_sim_lose(sim, n, &state->stats.lost_link);
+        return;
+    }
+
+    in->rx_packets++;
+
+    if (pkt->hdr_len == 0 || (node->logical_addr != 0 && pkt->hdr[0] == node->logical_addr))
+    {
+        sw_sim_deliver(sim, n, pkt);
+        return;
+    }
+
+    sw_sim_forward(sim, n, pkt);
+}
+
+/** @brief Emit a packet from source node @p n and schedule the next one. */
+static void sw_sim_generate(sw_sim_t *sim, uint16_t n, sw_sim_event_t *ev)
+{
+    sw_sim_node_t *state = &sim->nodes[n];
+    const uint8_t own = sim->net->nodes[n].logical_addr;
+    const uint16_t choices = (uint16_t)(sim->num_addrs - (own != 0 ? 1u : 0u));
+
+    if (state->gen_interval_ns == 0)
+        return;
+
+    if (choices > 0)
+    {
+        /* Pick among the other nodes' addresses. */
+        uint16_t i = (uint16_t)sw_sim_below(&state->rng, choices);
+        if (own != 0 && sim->addrs[i] >= own)
+            i++;
+
+        sw_sim_event_t pkt;
+        memset(&pkt, 0, sizeof(pkt));
+        pkt.created = sim->now;
+        pkt.len = state->gen_len;
+        pkt.hdr[0] = sim->addrs[i];
+        pkt.hdr_len = 1;
+
+        state->stats.generated++;
+        sw_sim_forward(sim, n, &pkt);
+    }
+
+    const uint32_t iv = state->gen_interval_ns;
+    ev->time = sim->now + iv / 2u + sw_sim_below(&state->rng, iv);
+    sw_sim_schedule(sim, n, ev);
+}
+
+/** @brief Process one event at its node. */
+static void sw_sim_process(sw_sim_t *sim, sw_sim_event_t *ev)
+{
+    const uint16_t n = ev->node;
+    sw_net_node_t *node = &sim->net->nodes[n];
+
+    switch (ev->type)
+    {
+    case SW_SIM_EV_GENERATE:
+        sw_sim_generate(sim, n, ev);
+        break;
+    case SW_SIM_EV_ARRIVE:
+        sw_sim_arrive(sim, n, ev);
+        break;
+    case SW_SIM_EV_LINK_DOWN:
+        node->router.links[ev->port].state = SW_LINK_ERROR;
+        sim->nodes[n].epoch[ev->port]++;
+        break;
+    case SW_SIM_EV_LINK_UP:
+        node->router.links[ev->port].state = SW_LINK_CONNECTED;
+        break;
+    case SW_SIM_EV_INSTALL:
+        sw_net_install_node_routes(
+            sim->net, n, &sim->tables[ev->arg][(size_t)n * SW_ROUTE_TABLE_SIZE]);
+        break;
+    default:
+        break;
+    }
+}
+
+/* ============================================================================
+ * SIMULATOR
+ * ============================================================================ */
+
+sw_result_t sw_sim_init(sw_sim_t *sim,
+                        sw_net_t *net,
+                        sw_sim_node_t *nodes,
+                        sw_sim_event_t *events,
+                        uint32_t max_events,
+                        uint64_t seed)
+{
+    if (!sim || !net || !nodes || !events || max_events == 0)
+        return SW_INVALID_PARAM;
+
+    memset(sim, 0, sizeof(*sim));
+    sim->net = net;
+    sim->nodes = nodes;
+    sim->events = events;
+    sim->max_events = max_events;
+
+    memset(nodes, 0, (size_t)net->num_nodes * sizeof(*nodes));
+
+    for (uint16_t n = 0; n < net->num_nodes; n++)
+    {
+        sw_net_node_t *node = &net->nodes[n];
+
+        nodes[n].rng = sw_sim_mix(seed ^ ((uint64_t)n << 32)) | 1u;
+
+        for (uint8_t p = 1; p < node->router.num_ports; p++)
+        {
+            const uint16_t l = node->port_link[p];
+            node->router.links[p].state =
+                (l != SW_NET_NONE && net->links[l].up) ? SW_LINK_CONNECTED : SW_LINK_ERROR;
+        }
+    }
+
+    for (size_t a = SW_LOGICAL_ADDR_MIN; a < SW_LOGICAL_ADDR_RESERVED; a++)
+    {
+        if (net->addr_node[a] != SW_NET_NONE)
+            sim->addrs[sim->num_addrs++] = (uint8_t)a;
+    }
+
+    return SW_OK;
+}
+
+sw_result_t sw_sim_set_traffic(sw_sim_t *sim, uint16_t node, uint32_t interval_ns, uint16_t len)
+{
+    if (!sim || node >= sim->net->num_nodes || interval_ns == 0 || len == 0)
+        return SW_INVALID_PARAM;
+
+    sw_sim_node_t *state = &sim->nodes[node];
+    const int running = state->gen_interval_ns != 0;
+
+    state->gen_interval_ns = interval_ns;
+    state->gen_len = len;
+
+    if (running)
+        return SW_OK;
+
+    sw_sim_event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = SW_SIM_EV_GENERATE;
+    ev.node = node;
+    ev.time = sim->now + sw_sim_below(&state->rng, interval_ns);
+
+    return sw_sim_schedule(sim, SW_NET_NONE, &ev);
+}
+
+sw_result_t sw_sim_schedule_link(sw_sim_t *sim, uint16_t link, uint64_t time, int up)
+{
+    if (!sim || link >= sim->net->num_links)
+        return SW_INVALID_PARAM;
+
+    const sw_net_link_t *l = &sim->net->links[link];
+
+    for (unsigned end = 0; end < 2u; end++)
+    {
+        sw_sim_event_t ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.type = (uint8_t)(up ? SW_SIM_EV_LINK_UP : SW_SIM_EV_LINK_DOWN);
+        ev.node = l->node[end];
+        ev.port = l->port[end];
+        ev.time = time;
+
+        if (sw_sim_schedule(sim, SW_NET_NONE, &ev) != SW_OK)
+            return SW_ERR;
+    }
+
+    return SW_OK;
+}
+
+sw_result_t sw_sim_add_table(sw_sim_t *sim, const uint8_t *table, uint16_t *index)
+{
+    if (!sim || !table || !index || sim->num_tables >= SW_SIM_MAX_TABLES)
+        return SW_INVALID_PARAM;
+
+    *index = sim->num_tables;
+    sim->tables[sim->num_tables++] = table;
+
+    return SW_OK;
+}
+
+sw_result_t sw_sim_schedule_install(sw_sim_t *sim, uint16_t node, uint64_t time, uint16_t table)
+{
+    if (!sim || node >= sim->net->num_nodes || table >= sim->num_tables)
+        return SW_INVALID_PARAM;
+
+    sw_sim_event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = SW_SIM_EV_INSTALL;
+    ev.node = node;
+    ev.arg = table;
+    ev.time = time;
+
+    return sw_sim_schedule(sim, SW_NET_NONE, &ev);
+}
+
+sw_result_t sw_sim_insert(sw_sim_t *sim, const sw_sim_event_t *ev)
+{
+    if (!sim || !ev || ev->node >= sim->net->num_nodes)
+        return SW_INVALID_PARAM;
+
+    return sw_sim_push(sim, ev);
+}
+
+uint64_t sw_sim_run(sw_sim_t *sim, uint64_t until)
+{
+    if (!sim)
+        return 0;
+
+    uint64_t processed = 0;
+    sw_sim_event_t ev;
+
+    while (sim->num_events > 0 && sim->events[0].time < until)
+    {
+        sw_sim_pop(sim, &ev);
+        sim->now = ev.time;
+        sw_sim_process(sim, &ev);
+        processed++;
+    }
+
+    if (until > sim->now)
+        sim->now = until;
+
+    return processed;
+}
+
+void sw_sim_get_stats(const sw_sim_t *sim, sw_sim_stats_t *stats)
+{
+    if (!sim || !stats)
+        return;
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (uint16_t n = 0; n < sim->net->num_nodes; n++)
+    {
+        const sw_sim_stats_t *s = &sim->nodes[n].stats;
+
+        stats->generated += s->generated;
+        stats->delivered += s->delivered;
+        stats->lost_no_route += s->lost_no_route;
+        stats->lost_link += s->lost_link;
+        stats->lost_hops += s->lost_hops;
+        stats->latency_sum_ns += s->latency_sum_ns;
+        if (s->latency_max_ns > stats->latency_max_ns)
+            stats->latency_max_ns = s->latency_max_ns;
+        if (s->last_loss_ns > stats->last_loss_ns)
+            stats->last_loss_ns = s->last_loss_ns;
+    }
+}
+
+/* ============================================================================
+ * LINK-FAILURE TRIAL
+ * ============================================================================ */
+
+/**
+ * @brief Pick the trial's link: the requested one, or a random link that is up.
+ * @return Link index, or ::SW_NET_NONE if there is none.
+ */
+static uint16_t sw_sim_pick_link(const sw_net_t *net, uint16_t link, uint64_t *rng)
+{
+    if (link != SW_NET_NONE)
+        return (link < net->num_links && net->links[link].up) ? link : SW_NET_NONE;
+
+    uint16_t up = 0;
+    for (uint16_t l = 0; l < net->num_links; l++)
+        up = (uint16_t)(up + net->links[l].up);
+
+    if (up == 0)
+        return SW_NET_NONE;
+
+    uint64_t k = sw_sim_below(rng, up);
+    for (uint16_t l = 0; l < net->num_links; l++)
+    {
+        if (net->links[l].up && k-- == 0)
+            return l;
+    }
+
+    return SW_NET_NONE;
+}
+
+sw_result_t sw_sim_link_failure_trial(sw_sim_t *sim,
+                                      const sw_sim_failure_cfg_t *cfg,
+                                      const sw_net_work_t *work,
+                                      uint8_t *tables,
+                                      sw_sim_failure_result_t *result)
+{
+    if (!sim || !sim->net || !cfg || !work || !tables || !result || cfg->interval_ns == 0 ||
+        cfg->packet_len == 0)
+        return SW_INVALID_PARAM;
+
+    sw_net_t *net = sim->net;
+    const size_t row = SW_ROUTE_TABLE_SIZE;
+    uint8_t *before = tables;
+    uint8_t *after = &tables[(size_t)net->num_nodes * row];
+    uint64_t rng = sw_sim_mix(cfg->seed) | 1u;
+
+    memset(result, 0, sizeof(*result));
+
+    const uint16_t link = sw_sim_pick_link(net, cfg->link, &rng);
+    if (link == SW_NET_NONE)
+        return SW_INVALID_PARAM;
+
+    /* Routes before and after the failure, as the manager computes them. */
+    if (sw_net_compute_routes(net, work, before) != SW_OK)
+        return SW_INVALID_PARAM;
+
+    net->links[link].up = 0;
+    const sw_result_t rc = sw_net_compute_routes(net, work, after);
+    net->links[link].up = 1;
+    if (rc != SW_OK)
+        return rc;
+
+    sw_net_install_routes(net, before);
+    sw_sim_init(sim, net, sim->nodes, sim->events, sim->max_events, cfg->seed);
+
+    for (uint16_t n = 0; n < net->num_nodes; n++)
+    {
+        if (net->nodes[n].logical_addr != 0)
+            sw_sim_set_traffic(sim, n, cfg->interval_ns, cfg->packet_len);
+    }
+
+    const uint64_t t_fail = cfg->warmup_ns;
+    uint16_t table = 0;
+    sw_sim_add_table(sim, after, &table);
+    sw_sim_schedule_link(sim, link, t_fail, 0);
+
+    result->link = link;
+
+    for (uint16_t n = 0; n < net->num_nodes; n++)
+    {
+        const uint8_t *old_row = &before[(size_t)n * row];
+        const uint8_t *new_row = &after[(size_t)n * row];
+
+        if (memcmp(old_row, new_row, row) == 0)
+            continue;
+
+        for (size_t a = 0; a < row; a++)
+        {
+            if (old_row[a] != SW_NET_NO_ROUTE && new_row[a] == SW_NET_NO_ROUTE)
+                result->unreachable++;
+        }
+
+        const uint64_t delay =
+            (uint64_t)cfg->detect_ns + sw_sim_below(&rng, (uint64_t)cfg->install_spread_ns + 1u);
+        sw_sim_schedule_install(sim, n, t_fail + delay, table);
+
+        result->routers_updated++;
+        if (delay > result->convergence_ns)
+            result->convergence_ns = delay;
+    }
+
+    sw_sim_run(sim, t_fail + cfg->duration_ns);
+    sw_sim_get_stats(sim, &result->stats);
+
+    result->lost = result->stats.lost_no_route + result->stats.lost_link +
+                   result->stats.lost_hops;
+    result->delivered = result->stats.delivered;
+    if (result->lost > 0 && result->stats.last_loss_ns >= t_fail)
+        result->disruption_ns = result->stats.last_loss_ns - t_fail;
+
+    return SW_OK;
+}
@@ -0,0 +1,368 @@
+/**
+ * @file spacewire_spfi.c
+ * @brief Software model of the SpaceFibre virtual-channel layer
+ *        (ECSS-E-ST-50-11C) carrying SpaceWire packets.
+ *
+ * Bandwidth credit is kept in word-percent so that it stays integral: after
+ * a frame of w words, every VC with packets waiting gains w * bandwidth and
+ * the sender pays the sum of those gains. Over the VCs that keep sending, the
+ * credits then drift apart unless each gets its share in the ratio of the
+ * reservations, and the largest-credit choice steers them back to it; the
+ * reservation of an idle VC is spread over the busy ones instead of pulling
+ * their credits down together. Credit is bounded by ::SW_SPFI_BW_CREDIT_LIMIT
+ * in both directions, so a VC cannot bank a long burst.
+ */
+
+#include "../include/spacewire_spfi.h"
+
+#include <string.h>
+
+/* ============================================================================
+ * FRAMES
+ * ============================================================================ */
+
+/** CRC-16 (CCITT polynomial 0x1021) of each top nibble, four bits at a time. */
+static const uint16_t sw_spfi_crc_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+/** @brief Fold one octet into a CRC-16 (CCITT polynomial 0x1021). */
+static uint16_t sw_spfi_crc_octet(uint16_t crc, uint8_t octet)
+{
+    crc = (uint16_t)(((unsigned)crc << 4) ^ sw_spfi_crc_nibble[(crc >> 12) ^ (octet >> 4)]);
+    crc = (uint16_t)(((unsigned)crc << 4) ^ sw_spfi_crc_nibble[(crc >> 12) ^ (octet & 0x0Fu)]);
+    return crc;
+}
+
+uint16_t sw_spfi_frame_crc(const sw_spfi_frame_t *frame)
+{
+    if (!frame || frame->len > SW_SPFI_FRAME_DATA)
+        return 0;
+
+    uint16_t crc = 0xFFFFu;
+    crc = sw_spfi_crc_octet(crc, frame->vc);
+    crc = sw_spfi_crc_octet(crc, frame->seq);
+
+    for (uint32_t i = 0; i < (uint32_t)(frame->len + 7u) / 8u; i++)
+        crc = sw_spfi_crc_octet(crc, frame->k[i]);
+    for (uint32_t i = 0; i < frame->len; i++)
+        crc = sw_spfi_crc_octet(crc, frame->data[i]);
+
+    return crc;
+}
+
+/** @brief Append a control symbol to a frame. */
+static void sw_spfi_put_control(sw_spfi_frame_t *frame, uint32_t *n, uint8_t code)
+{
+    frame->k[*n / 8u] |= (uint8_t)(1u << (*n % 8u));
+    frame->data[(*n)++] = code;
+}
+
+/* ============================================================================
+ * TRANSMIT
+ * ============================================================================ */
+
+sw_result_t sw_spfi_tx_init(sw_spfi_tx_t *tx)
+{
+    if (!tx)
+        return SW_INVALID_PARAM;
+
+    memset(tx, 0, sizeof(*tx));
+    memset(tx->vc_map, SW_SPFI_NO_VC, sizeof(tx->vc_map));
+
+    return SW_OK;
+}
+
+sw_result_t sw_spfi_tx_add_vc(sw_spfi_tx_t *tx,
+                              uint8_t vc,
+                              const sw_spfi_vc_config_t *config,
+                              sw_ring_t *queue)
+{
+    if (!tx || !config || !queue || vc >= SW_SPFI_MAX_VC || config->priority > 15u)
+        return SW_INVALID_PARAM;
+
+    unsigned reserved = config->bandwidth;
+    for (uint8_t i = 0; i < tx->num_vcs; i++)
+    {
+        if (i != vc && tx->vc[i].queue)
+            reserved += tx->vc[i].bandwidth;
+    }
+    if (reserved > 100u)
+        return SW_INVALID_PARAM;
+
+    sw_spfi_tx_vc_t *v = &tx->vc[vc];
+    memset(v, 0, sizeof(*v));
+    v->queue = queue;
+    v->priority = config->priority;
+    v->bandwidth = config->bandwidth;
+
+    if (vc >= tx->num_vcs)
+        tx->num_vcs = (uint8_t)(vc + 1u);
+
+    return SW_OK;
+}
+
+sw_result_t sw_spfi_tx_map(sw_spfi_tx_t *tx, sw_virtual_channel_t from, uint8_t vc)
+{
+    if (!tx || (vc != SW_SPFI_NO_VC && (vc >= SW_SPFI_MAX_VC || !tx->vc[vc].queue)))
+        return SW_INVALID_PARAM;
+
+    tx->vc_map[from] = vc;
+    return SW_OK;
+}
+
+sw_result_t sw_spfi_tx_enqueue(sw_spfi_tx_t *tx, sw_virtual_channel_t from, const sw_desc_t *desc)
+{
+    if (!tx || !desc || tx->vc_map[from] == SW_SPFI_NO_VC)
+        return SW_INVALID_PARAM;
+
+    return sw_ring_push(tx->vc[tx->vc_map[from]].queue, desc);
+}
+
+sw_result_t sw_spfi_tx_fct(sw_spfi_tx_t *tx, uint8_t vc, uint32_t frames)
+{
+    if (!tx || vc >= SW_SPFI_MAX_VC || !tx->vc[vc].queue)
+        return SW_INVALID_PARAM;
+
+    tx->vc[vc].credits += frames;
+    return SW_OK;
+}
+
+/**
+ * @brief Whether a VC has a packet to frame, taking the next one from its
+ *        ring if needed.
+ */
+static int sw_spfi_has_data(sw_spfi_tx_vc_t *v)
+{
+    if (!v->has_cur && sw_ring_pop(v->queue, &v->cur) == SW_OK)
+    {
+        v->has_cur = 1;
+        v->cur_off = 0;
+    }
+    return v->has_cur;
+}
+
+/**
+ * @brief Medium access: the ready VC with the highest priority, then the
+ *        most bandwidth credit, then the lowest number.
+ * @return VC number, or ::SW_SPFI_NO_VC if none is ready.
+ */
+static uint8_t sw_spfi_select(sw_spfi_tx_t *tx)
+{
+    uint8_t best = SW_SPFI_NO_VC;
+
+    for (uint8_t i = 0; i < tx->num_vcs; i++)
+    {
+        sw_spfi_tx_vc_t *v = &tx->vc[i];
+        if (!v->queue || v->credits == 0 || !sw_spfi_has_data(v))
+            continue;
+
+        if (best == SW_SPFI_NO_VC || v->priority < tx->vc[best].priority ||
+            (v->priority == tx->vc[best].priority && v->bw_credit > tx->vc[best].bw_credit))
+            best = i;
+    }
+
+    return best;
+}
+
+/**
+ * @brief Pack the VC's packets into a frame until it is full or the VC runs
+ *        out of packets.
+ * @return Data symbols in the frame.
+ */
+static uint32_t sw_spfi_pack(sw_spfi_tx_vc_t *v, sw_spfi_frame_t *frame)
+{
+    uint32_t n = 0;
+
+    while (n < SW_SPFI_FRAME_DATA && sw_spfi_has_data(v))
+    {
+        const uint32_t left = v->cur.len - v->cur_off;
+        const uint32_t room = SW_SPFI_FRAME_DATA - n;
+        const uint32_t k = left < room ? left : room;
+
+        memcpy(&frame->data[n], &sw_desc_data(&v->cur)[v->cur_off], k);
+        n += k;
+        v->cur_off += k;
+
+        /* The end marker goes in the next frame if this one is full. */
+        if (v->cur_off < v->cur.len || n == SW_SPFI_FRAME_DATA)
+            break;
+
+        sw_spfi_put_control(frame, &n, v->cur.end == SW_END_EEP ? SW_SPFI_EEP : SW_SPFI_EOP);
+        while (n % SW_SPFI_WORD != 0)
+            sw_spfi_put_control(frame, &n, SW_SPFI_FILL);
+
+        v->has_cur = 0;
+        v->packets++;
+    }
+
+    return n;
+}
+
+/** @brief Clamp a bandwidth credit to ±::SW_SPFI_BW_CREDIT_LIMIT. */
+static int32_t sw_spfi_clamp_credit(int64_t credit)
+{
+    if (credit > SW_SPFI_BW_CREDIT_LIMIT)
+        return SW_SPFI_BW_CREDIT_LIMIT;
+    if (credit < -SW_SPFI_BW_CREDIT_LIMIT)
+        return -SW_SPFI_BW_CREDIT_LIMIT;
+    return (int32_t)credit;
+}
+
+sw_result_t sw_spfi_tx_next_frame(sw_spfi_tx_t *tx, sw_spfi_frame_t *frame)
+{
+    if (!tx || !frame)
+        return SW_INVALID_PARAM;
+
+    const uint8_t vc = sw_spfi_select(tx);
+    if (vc == SW_SPFI_NO_VC)
+        return SW_ERR;
+
+    sw_spfi_tx_vc_t *v = &tx->vc[vc];
+
+    memset(frame->k, 0, sizeof(frame->k));
+    frame->vc = vc;
+    frame->seq = tx->seq++;
+    frame->len = (uint16_t)sw_spfi_pack(v, frame);
+    frame->crc = sw_spfi_frame_crc(frame);
+
+    const uint32_t words = sw_spfi_frame_words(frame);
+
+    if (v->bw_credit < 0)
+        v->overuse++;
+    v->credits--;
+    v->frames++;
+    v->words += words;
+    tx->words += words;
+
+    /* Only VCs with packets waiting earn credit, and the sender pays what
+     * they earn together, so the credits of the busy VCs sum to zero. */
+    uint32_t busy_bw = v->bandwidth;
+    for (uint8_t i = 0; i < tx->num_vcs; i++)
+    {
+        sw_spfi_tx_vc_t *u = &tx->vc[i];
+        if (i != vc && u->queue && sw_spfi_has_data(u))
+            busy_bw += u->bandwidth;
+    }
+
+    for (uint8_t i = 0; i < tx->num_vcs; i++)
+    {
+        sw_spfi_tx_vc_t *u = &tx->vc[i];
+        if (!u->queue || (i != vc && !u->has_cur))
+            continue;
+
+        int64_t credit = (int64_t)u->bw_credit + (int64_t)words * u->bandwidth;
+        if (i == vc)
+            credit -= (int64_t)words * busy_bw;
+        u->bw_credit = sw_spfi_clamp_credit(credit);
+    }
+
+    return SW_OK;
+}
+
+/* ============================================================================
+ * RECEIVE
+ * ============================================================================ */
+
+sw_result_t sw_spfi_rx_init(sw_spfi_rx_t *rx, sw_spfi_deliver_fn deliver, void *ctx)
+{
+    if (!rx || !deliver)
+        return SW_INVALID_PARAM;
+
+    memset(rx, 0, sizeof(*rx));
+    rx->deliver = deliver;
+    rx->ctx = ctx;
+
+    return SW_OK;
+}
+
+sw_result_t sw_spfi_rx_add_vc(sw_spfi_rx_t *rx, uint8_t vc, uint8_t *buf, uint32_t cap)
+{
+    if (!rx || !buf || cap == 0 || vc >= SW_SPFI_MAX_VC)
+        return SW_INVALID_PARAM;
+
+    sw_spfi_rx_vc_t *v = &rx->vc[vc];
+    memset(v, 0, sizeof(*v));
+    v->buf = buf;
+    v->cap = cap;
+
+    return SW_OK;
+}
+
+sw_result_t sw_spfi_rx_frame(sw_spfi_rx_t *rx, const sw_spfi_frame_t *frame)
+{
+    if (!rx || !frame)
+        return SW_INVALID_PARAM;
+
+    if (frame->vc >= SW_SPFI_MAX_VC || !rx->vc[frame->vc].buf ||
+        frame->len > SW_SPFI_FRAME_DATA || frame->len % SW_SPFI_WORD != 0)
+        return SW_ERR;
+
+    if (sw_spfi_frame_crc(frame) != frame->crc)
+    {
+        rx->crc_errors++;
+        return SW_ERR;
+    }
+
+    if (frame->seq != rx->seq)
+        rx->seq_errors++;
+    rx->seq = (uint8_t)(frame->seq + 1u);
+    rx->frames++;
+
+    sw_spfi_rx_vc_t *v = &rx->vc[frame->vc];
+    uint32_t i = 0;
+
+    while (i < frame->len)
+    {
+        /* Copy the run of data symbols up to the next control symbol. */
+        uint32_t j = i;
+        while (j < frame->len && !(frame->k[j / 8u] & (1u << (j % 8u))))
+        {
+            /* Skip eight data symbols at a time on an empty flag octet. */
+            if (j % 8u == 0 && frame->k[j / 8u] == 0)
+                j += 8u;
+            else
+                j++;
+        }
+        if (j > frame->len)
+            j = frame->len;
+
+        const uint32_t run = j - i;
+        if (!v->oversize && v->len + run <= v->cap)
+        {
+            memcpy(&v->buf[v->len], &frame->data[i], run);
+            v->len += run;
+        }
+        else if (run > 0)
+        {
+            v->oversize = 1;
+        }
+
+        if (j == frame->len)
+            break;
+
+        const uint8_t code = frame->data[j];
+        if (code == SW_SPFI_EOP || code == SW_SPFI_EEP)
+        {
+            if (v->oversize)
+            {
+                v->dropped++;
+            }
+            else
+            {
+                v->packets++;
+                rx->deliver(rx->ctx,
+                            frame->vc,
+                            v->buf,
+                            v->len,
+                            code == SW_SPFI_EEP ? SW_END_EEP : SW_END_EOP);
+            }
+            v->len = 0;
+            v->oversize = 0;
+        }
+        i = j + 1u;
+    }
+
+    return SW_OK;
+}
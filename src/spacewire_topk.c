@@ -0,0 +1,254 @@
+/**
+ * @file spacewire_topk.c
+ * @brief Streaming heavy-hitter detection (weighted Space-Saving).
+ */
+
+#include "../include/spacewire_topk.h"
+
+#include <string.h>
+
+/* ============================================================================
+ * HASH INDEX (linear probing)
+ * ============================================================================ */
+
+/** @brief Home slot of @p key. */
+static uint32_t sw_topk_hash(const sw_topk_t *topk, uint32_t key)
+{
+    const uint32_t h = key * 0x9E3779B1u;
+    return (h ^ (h >> 16)) & topk->index_mask;
+}
+
+/** @brief Slot holding @p key, or the free slot ending its probe sequence. */
+static uint32_t sw_topk_find(const sw_topk_t *topk, uint32_t key)
+{
+    uint32_t s = sw_topk_hash(topk, key);
+
+    while (topk->index[s] != 0 && topk->entries[topk->index[s] - 1u].key != key)
+        s = (s + 1u) & topk->index_mask;
+
+    return s;
+}
+
+/** @brief Remove slot @p s, shifting later members of its run back. */
+static void sw_topk_unindex(sw_topk_t *topk, uint32_t s)
+{
+    uint32_t next = (s + 1u) & topk->index_mask;
+
+    while (topk->index[next] != 0)
+    {
+        const uint32_t home = sw_topk_hash(topk, topk->entries[topk->index[next] - 1u].key);
+
+        /* Move the entry back unless its home lies cyclically in (s, next]. */
+        if (((next - home) & topk->index_mask) >= ((next - s) & topk->index_mask))
+        {
+            topk->index[s] = topk->index[next];
+            s = next;
+        }
+        next = (next + 1u) & topk->index_mask;
+    }
+
+    topk->index[s] = 0;
+}
+
+/* ============================================================================
+ * MIN-HEAP
+ * ============================================================================ */
+
+/** @brief Restore the heap below slot @p i after its count grew. */
+static void sw_topk_sift_down(sw_topk_t *topk, uint16_t i)
+{
+    const uint16_t e = topk->heap[i];
+    const uint64_t count = topk->entries[e].count;
+
+    for (;;)
+    {
+        uint32_t c = 2u * i + 1u;
+        if (c >= topk->num_entries)
+            break;
+        if (c + 1u < topk->num_entries &&
+            topk->entries[topk->heap[c + 1u]].count < topk->entries[topk->heap[c]].count)
+            c++;
+        if (topk->entries[topk->heap[c]].count >= count)
+            break;
+
+        topk->heap[i] = topk->heap[c];
+        topk->entries[topk->heap[i]].slot = i;
+        i = (uint16_t)c;
+    }
+
+    topk->heap[i] = e;
+    topk->entries[e].slot = i;
+}
+
+/* ============================================================================
+ * UPDATES AND QUERIES
+ * ============================================================================ */
+
+sw_result_t sw_topk_init(sw_topk_t *topk,
+                         sw_topk_entry_t *entries,
+                         uint16_t *heap,
+                         uint16_t capacity,
+                         uint16_t *index,
+                         uint32_t index_slots)
+{
+    if (!topk || !entries || !heap || !index || capacity == 0 || capacity > 0x7FFFu ||
+        index_slots < 2u * capacity || (index_slots & (index_slots - 1u)) != 0)
+        return SW_INVALID_PARAM;
+
+    topk->entries = entries;
+    topk->heap = heap;
+    topk->index = index;
+    topk->index_mask = index_slots - 1u;
+    topk->capacity = capacity;
+    sw_topk_reset(topk);
+
+    return SW_OK;
+}
+
+void sw_topk_reset(sw_topk_t *topk)
+{
+    if (!topk)
+        return;
+
+    memset(topk->index, 0, ((size_t)topk->index_mask + 1u) * sizeof(*topk->index));
+    topk->num_entries = 0;
+    topk->total = 0;
+}
+
+void sw_topk_add(sw_topk_t *topk, uint32_t key, uint32_t octets)
+{
+    if (!topk)
+        return;
+
+    topk->total += octets;
+
+    const uint32_t s = sw_topk_find(topk, key);
+    uint16_t e;
+
+    if (topk->index[s] != 0)
+    {
+        e = (uint16_t)(topk->index[s] - 1u);
+    }
+    else if (topk->num_entries < topk->capacity)
+    {
+        /* A free counter: append it as a leaf; a zero count keeps the heap. */
+        e = topk->num_entries++;
+        topk->entries[e].key = key;
+        topk->entries[e].count = 0;
+        topk->entries[e].error = 0;
+        topk->entries[e].slot = 0;
+        topk->index[s] = (uint16_t)(e + 1u);
+
+        uint16_t i = (uint16_t)(topk->num_entries - 1u);
+        while (i > 0)
+        {
+            const uint16_t parent = (uint16_t)((i - 1u) / 2u);
+            topk->heap[i] = topk->heap[parent];
+            topk->entries[topk->heap[i]].slot = i;
+            i = parent;
+        }
+        topk->heap[0] = e;
+        topk->entries[e].slot = 0;
+    }
+    else
+    {
+        /* Take over the smallest counter. */
+        e = topk->heap[0];
+        sw_topk_unindex(topk, sw_topk_find(topk, topk->entries[e].key));
+        topk->index[sw_topk_find(topk, key)] = (uint16_t)(e + 1u);
+        topk->entries[e].key = key;
+        topk->entries[e].error = topk->entries[e].count;
+    }
+
+    topk->entries[e].count += octets;
+    sw_topk_sift_down(topk, topk->entries[e].slot);
+}
+
+void sw_topk_add_packet(sw_topk_t *topk, const uint8_t *pkt, size_t len)
+{
+    if (!topk || !pkt)
+        return;
+
+    size_t i = 0;
+    while (i < len && pkt[i] <= SW_PATH_ADDR_MAX)
+        i++;
+    if (i >= len)
+        return;
+
+    const uint8_t *ptp = &pkt[i];
+    const size_t left = len - i;
+    uint32_t key = SW_TOPK_KEY(ptp[0], 0u, SW_TOPK_NO_APID);
+
+    /* [addr | 0x02 | 0x00 | user app | primary header ...]; APID in octets 4-5. */
+    if (left >= SW_PTP_HEADER_LEN + 2u && ptp[1] == SW_PTP_PROTOCOL_ID)
+        key = SW_TOPK_KEY(ptp[0], ptp[3], ((uint32_t)(ptp[4] & 0x07u) << 8) | ptp[5]);
+
+    sw_topk_add(topk, key, (uint32_t)len);
+}
+
+void sw_topk_add_frame(sw_topk_t *topk, const sw_packet_frame_t *pf, size_t octets)
+{
+    if (!topk || !pf)
+        return;
+
+    sw_topk_add(topk,
+                SW_TOPK_KEY(pf->logical_addr, pf->user_app, pf->packet.ph.apid),
+                (uint32_t)octets);
+}
+
+uint64_t sw_topk_estimate(const sw_topk_t *topk, uint32_t key, uint64_t *error)
+{
+    if (error)
+        *error = 0;
+    if (!topk)
+        return 0;
+
+    const uint32_t s = sw_topk_find(topk, key);
+    if (topk->index[s] == 0)
+        return 0;
+
+    const sw_topk_entry_t *e = &topk->entries[topk->index[s] - 1u];
+    if (error)
+        *error = e->error;
+    return e->count;
+}
+
+uint16_t sw_topk_top(const sw_topk_t *topk, sw_topk_entry_t *out, uint16_t max)
+{
+    if (!topk || !out || max == 0)
+        return 0;
+
+    uint16_t n = 0;
+
+    /* Insertion into the sorted output; only entries that make the cut move. */
+    for (uint16_t e = 0; e < topk->num_entries; e++)
+    {
+        const sw_topk_entry_t *entry = &topk->entries[e];
+        if (n == max && entry->count <= out[n - 1u].count)
+            continue;
+
+        uint16_t i = n < max ? n++ : (uint16_t)(n - 1u);
+        while (i > 0 && out[i - 1u].count < entry->count)
+        {
+            out[i] = out[i - 1u];
+            i--;
+        }
+        out[i] = *entry;
+    }
+
+    return n;
+}
+
+void sw_topk_decay(sw_topk_t *topk, unsigned shift)
+{
+    if (!topk || shift == 0 || shift > 63u)
+        return;
+
+    /* x >> shift is monotonic, so the heap order survives. */
+    for (uint16_t e = 0; e < topk->num_entries; e++)
+    {
+        topk->entries[e].count >>= shift;
+        topk->entries[e].error >>= shift;
+    }
+    topk->total >>= shift;
+}
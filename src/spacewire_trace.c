@@ -0,0 +1,357 @@
+/**
+ * @file spacewire_trace.c
+ * @brief Span tracing of the packet path, exported as Chrome trace JSON.
+ *
+ * A span is written once, when it ends, as one record holding its start and
+ * duration (a Chrome "complete" event), so nested spans need no matching at
+ * export time. The buffer protocol is that of the event log: record i lives
+ * in slot i & mask and is published by a release store of head = i + 1; a
+ * reader that observes head h after copying discards records below
+ * h - count + 1.
+ */
+
+#include "../include/spacewire_trace.h"
+
+#include "spacewire_atomic.h"
+
+#include <string.h>
+
+/** @brief Records copied per chunk by the export. */
+#define SW_TRACE_CHUNK 32u
+
+/** @brief Export line buffer; flushed once it holds more than half. */
+#define SW_TRACE_LINE 512u
+
+SW_TRACE_THREAD_LOCAL sw_trace_buf_t *sw_trace_sampled;
+
+/* The calling thread's buffer and identifier. */
+static SW_TRACE_THREAD_LOCAL sw_trace_buf_t *t_trace_buf;
+static SW_TRACE_THREAD_LOCAL uint32_t t_trace_id;
+
+/* Registered buffers (lock-free list, push only). */
+static sw_trace_buf_t *g_trace_registry;
+
+/* ============================================================================
+ * BUFFER SET-UP
+ * ============================================================================ */
+
+sw_result_t sw_trace_buf_init(sw_trace_buf_t *buf,
+                              sw_trace_event_t *events,
+                              uint32_t count,
+                              uint32_t thread_id,
+                              uint32_t sample_every)
+{
+    if (!buf || !events || count < 2 || (count & (count - 1u)) != 0)
+        return SW_INVALID_PARAM;
+
+    if (sample_every == 0 || (sample_every & (sample_every - 1u)) != 0)
+        return SW_INVALID_PARAM;
+
+    memset(events, 0, (size_t)count * sizeof(*events));
+
+    buf->events = events;
+    buf->mask = count - 1u;
+    buf->head = 0;
+    buf->thread_id = thread_id;
+    buf->sample_mask = sample_every - 1u;
+    buf->next = NULL;
+
+    return SW_OK;
+}
+
+/**
+ * @brief Recompute whether the calling thread records its current spans.
+ */
+static void sw_trace_update_sampled(void)
+{
+    sw_trace_buf_t *buf = t_trace_buf;
+    sw_trace_sampled = buf && (t_trace_id & buf->sample_mask) == 0 ? buf : NULL;
+}
+
+void sw_trace_attach(sw_trace_buf_t *buf)
+{
+    t_trace_buf = buf;
+    sw_trace_update_sampled();
+}
+
+sw_result_t sw_trace_register(sw_trace_buf_t *buf)
+{
+    if (!buf)
+        return SW_INVALID_PARAM;
+
+    sw_trace_buf_t *head = SW_ATOMIC_LOAD_ACQUIRE(&g_trace_registry);
+
+    for (const sw_trace_buf_t *b = head; b; b = b->next)
+    {
+        if (b == buf)
+            return SW_INVALID_PARAM;
+    }
+
+    do
+    {
+        buf->next = head;
+    } while (!SW_ATOMIC_CAS(&g_trace_registry, &head, buf));
+
+    return SW_OK;
+}
+
+void sw_trace_set_id(uint32_t id)
+{
+    t_trace_id = id;
+    sw_trace_update_sampled();
+}
+
+uint32_t sw_trace_id(void)
+{
+    return t_trace_id;
+}
+
+/* ============================================================================
+ * RECORDING
+ * ============================================================================ */
+
+void sw_trace_record(uint64_t start, sw_span_t span, const void *obj, uint16_t arg)
+{
+    sw_trace_buf_t *buf = sw_trace_sampled;
+    if (!buf)
+        return;
+
+    const uint64_t ticks = sw_evlog_timestamp() - start;
+    const uint32_t h = SW_ATOMIC_LOAD_RELAXED(&buf->head);
+    sw_trace_event_t *ev = &buf->events[h & buf->mask];
+
+    ev->start = start;
+    ev->duration = ticks > UINT32_MAX ? UINT32_MAX : (uint32_t)ticks;
+    ev->id = t_trace_id;
+    ev->obj = (uint32_t)(uintptr_t)obj;
+    ev->arg = arg;
+    ev->span = (uint8_t)span;
+    ev->reserved = 0;
+
+    SW_ATOMIC_STORE_RELEASE(&buf->head, h + 1u);
+}
+
+/* ============================================================================
+ * SNAPSHOT
+ * ============================================================================ */
+
+/**
+ * @brief Copy records [first, first + n) and report how many leading ones
+ *        were overwritten while being copied.
+ * @param[in]  buf   Buffer to read.
+ * @param[in]  first Index of the first record.
+ * @param[in]  n     Number of records.
+ * @param[out] out   Destination for @p n records.
+ * @return Number of leading records in @p out that are not valid.
+ */
+static uint32_t sw_trace_copy(const sw_trace_buf_t *buf,
+                              uint32_t first,
+                              uint32_t n,
+                              sw_trace_event_t *out)
+{
+    for (uint32_t i = 0; i < n; i++)
+        out[i] = buf->events[(first + i) & buf->mask];
+
+    SW_ATOMIC_FENCE_ACQUIRE();
+    const uint32_t h = SW_ATOMIC_LOAD_RELAXED(&buf->head);
+
+    const uint32_t oldest_safe = h - buf->mask;
+    if ((int32_t)(oldest_safe - first) <= 0)
+        return 0;
+
+    const uint32_t lost = oldest_safe - first;
+    return lost < n ? lost : n;
+}
+
+size_t sw_trace_snapshot(const sw_trace_buf_t *buf, sw_trace_event_t *out, size_t max)
+{
+    if (!buf || !out || max == 0)
+        return 0;
+
+    const uint32_t h = SW_ATOMIC_LOAD_ACQUIRE(&buf->head);
+    uint32_t n = h < buf->mask ? h : buf->mask;
+    if (n > max)
+        n = (uint32_t)max;
+
+    const uint32_t lost = sw_trace_copy(buf, h - n, n, out);
+    if (lost > 0)
+        memmove(out, &out[lost], (size_t)(n - lost) * sizeof(*out));
+
+    return n - lost;
+}
+
+/* ============================================================================
+ * CHROME TRACE EXPORT
+ * ============================================================================ */
+
+/**
+ * @brief Export state: the sink and a line buffer.
+ */
+typedef struct
+{
+    sw_trace_write_fn sink;   /**< Sink. */
+    void *ctx;                /**< Sink context. */
+    int failed;               /**< The sink reported an error. */
+    size_t len;               /**< Octets in @ref line. */
+    char line[SW_TRACE_LINE]; /**< Pending output. */
+} sw_trace_out_t;
+
+/** @brief Hand the pending output to the sink. */
+static void sw_trace_flush(sw_trace_out_t *o)
+{
+    if (o->len > 0 && !o->failed && o->sink(o->ctx, o->line, o->len) != 0)
+        o->failed = 1;
+    o->len = 0;
+}
+
+/** @brief Append a string. */
+static void sw_trace_put(sw_trace_out_t *o, const char *s)
+{
+    for (; *s; s++)
+        o->line[o->len++] = *s;
+}
+
+/** @brief Append @p v in decimal. */
+static void sw_trace_put_u64(sw_trace_out_t *o, uint64_t v)
+{
+    char digits[20];
+    unsigned n = 0;
+
+    do
+    {
+        digits[n++] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while (v != 0);
+
+    while (n > 0)
+        o->line[o->len++] = digits[--n];
+}
+
+/** @brief Write @p ns nanoseconds as microseconds with three decimals. */
+static void sw_trace_put_us(sw_trace_out_t *o, uint64_t ns)
+{
+    sw_trace_put_u64(o, ns / 1000u);
+    o->line[o->len++] = '.';
+    o->line[o->len++] = (char)('0' + ns / 100u % 10u);
+    o->line[o->len++] = (char)('0' + ns / 10u % 10u);
+    o->line[o->len++] = (char)('0' + ns % 10u);
+}
+
+/** @brief Append the name of span type @p span. */
+static void sw_trace_put_name(sw_trace_out_t *o, uint8_t span)
+{
+    static const char *const names[] = {
+        "none", "encode", "route", "ring_push", "ring_pop", "decode", "txq_enqueue", "txq_dequeue"};
+
+    if (span < sizeof(names) / sizeof(names[0]))
+    {
+        sw_trace_put(o, names[span]);
+    }
+    else if (span >= SW_SPAN_USER)
+    {
+        sw_trace_put(o, "user");
+        sw_trace_put_u64(o, (uint64_t)(span - SW_SPAN_USER));
+    }
+    else
+    {
+        sw_trace_put(o, "span");
+        sw_trace_put_u64(o, span);
+    }
+}
+
+/** @brief Append one span as a complete ("X") event. */
+static void sw_trace_put_event(sw_trace_out_t *o,
+                               const sw_trace_buf_t *buf,
+                               const sw_trace_event_t *ev,
+                               uint64_t base,
+                               double ns_per_tick,
+                               int first)
+{
+    const uint64_t rel = ev->start > base ? ev->start - base : 0;
+
+    sw_trace_put(o, first ? "\n{\"name\":\"" : ",\n{\"name\":\"");
+    sw_trace_put_name(o, ev->span);
+    sw_trace_put(o, "\",\"cat\":\"spacewire\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+    sw_trace_put_u64(o, buf->thread_id);
+    sw_trace_put(o, ",\"ts\":");
+    sw_trace_put_us(o, (uint64_t)((double)rel * ns_per_tick));
+    sw_trace_put(o, ",\"dur\":");
+    sw_trace_put_us(o, (uint64_t)((double)ev->duration * ns_per_tick));
+    sw_trace_put(o, ",\"args\":{\"id\":");
+    sw_trace_put_u64(o, ev->id);
+    sw_trace_put(o, ",\"obj\":");
+    sw_trace_put_u64(o, ev->obj);
+    sw_trace_put(o, ",\"arg\":");
+    sw_trace_put_u64(o, ev->arg);
+    sw_trace_put(o, "}}");
+
+    if (o->len > SW_TRACE_LINE / 2u)
+        sw_trace_flush(o);
+}
+
+/**
+ * @brief Visit the surviving records of a buffer in chunks.
+ * @param[in]     buf   Buffer.
+ * @param[in,out] o     Export state, or NULL to only find the earliest start.
+ * @param[in,out] base  Earliest start seen (updated when @p o is NULL).
+ * @param[in]     scale Nanoseconds per tick.
+ * @param[in,out] first Nothing written yet.
+ */
+static void sw_trace_walk(const sw_trace_buf_t *buf,
+                          sw_trace_out_t *o,
+                          uint64_t *base,
+                          double scale,
+                          int *first)
+{
+    sw_trace_event_t chunk[SW_TRACE_CHUNK];
+    const uint32_t h = SW_ATOMIC_LOAD_ACQUIRE(&buf->head);
+    const uint32_t n = h < buf->mask ? h : buf->mask;
+
+    for (uint32_t done = 0; done < n;)
+    {
+        const uint32_t left = n - done;
+        const uint32_t len = left < SW_TRACE_CHUNK ? left : SW_TRACE_CHUNK;
+        const uint32_t lost = sw_trace_copy(buf, h - n + done, len, chunk);
+
+        for (uint32_t i = lost; i < len; i++)
+        {
+            if (chunk[i].span == SW_SPAN_NONE)
+                continue;
+
+            if (!o)
+            {
+                if (chunk[i].start < *base)
+                    *base = chunk[i].start;
+                continue;
+            }
+
+            sw_trace_put_event(o, buf, &chunk[i], *base, scale, *first);
+            *first = 0;
+        }
+
+        done += len;
+    }
+}
+
+sw_result_t sw_trace_export_json(sw_trace_write_fn sink, void *ctx, double ticks_per_us)
+{
+    if (!sink || !(ticks_per_us > 0.0))
+        return SW_INVALID_PARAM;
+
+    sw_trace_out_t o = {.sink = sink, .ctx = ctx, .failed = 0, .len = 0};
+    const double scale = 1000.0 / ticks_per_us;
+    sw_trace_buf_t *const registry = SW_ATOMIC_LOAD_ACQUIRE(&g_trace_registry);
+    uint64_t base = UINT64_MAX;
+    int first = 1;
+
+    for (const sw_trace_buf_t *buf = registry; buf; buf = buf->next)
+        sw_trace_walk(buf, NULL, &base, scale, &first);
+
+    sw_trace_put(&o, "{\"traceEvents\":[");
+    for (const sw_trace_buf_t *buf = registry; buf && !o.failed; buf = buf->next)
+        sw_trace_walk(buf, &o, &base, scale, &first);
+    sw_trace_put(&o, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    sw_trace_flush(&o);
+
+    return o.failed ? SW_ERR : SW_OK;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file spacewire_txq.c
+ * @brief Multi-producer single-consumer transmit queues of packet descriptors.
+ */
+
+#include "../include/spacewire_txq.h"
+#include "../include/spacewire_trace.h"
+
+#include "spacewire_atomic.h"
+
+#include <string.h>
+
+sw_result_t sw_txq_init(sw_txq_t *q, sw_txq_slot_t *slots, uint32_t count, uint32_t limit)
+{
+    if (!q || !slots || count == 0 || count > 0x80000000u || (count & (count - 1u)) != 0 ||
+        limit > count)
+        return SW_INVALID_PARAM;
+
+    memset(q, 0, sizeof(*q));
+    memset(slots, 0, (size_t)count * sizeof(*slots));
+    q->slots = slots;
+    q->mask = count - 1u;
+    q->limit = limit ? limit : count;
+
+    return SW_OK;
+}
+
+sw_result_t sw_txq_set_limit(sw_txq_t *q, uint32_t limit)
+{
+    if (!q || limit > q->mask + 1u)
+        return SW_INVALID_PARAM;
+
+    SW_ATOMIC_STORE_RELAXED(&q->limit, limit ? limit : q->mask + 1u);
+    return SW_OK;
+}
+
+/**
+ * @brief Free room below @p limit with @p tail reserved and @p head drained.
+ *
+ * A stale head (another producer may have stored an older copy) only makes
+ * the result smaller, never wrap. A stale tail can: once the consumer has
+ * drained past it, @p tail - @p head wraps and the result is 0, so a caller
+ * finding no room reloads the tail before reporting backpressure.
+ */
+static uint32_t sw_txq_room(uint32_t tail, uint32_t head, uint32_t limit)
+{
+    const uint32_t used = tail - head;
+    return used >= limit ? 0 : limit - used;
+}
+
+uint32_t sw_txq_enqueue_burst(sw_txq_t *q, const sw_desc_t *descs, uint32_t n)
+{
+    if (!q || !descs)
+        return 0;
+
+    const uint64_t t = sw_trace_begin();
+
+    uint32_t tail = SW_ATOMIC_LOAD_RELAXED(&q->tail);
+    uint32_t k;
+
+    for (;;)
+    {
+        const uint32_t limit = SW_ATOMIC_LOAD_RELAXED(&q->limit);
+        uint32_t room = sw_txq_room(tail, SW_ATOMIC_LOAD_ACQUIRE(&q->head_cache), limit);
+
+        if (room < n)
+        {
+            /* The acquire orders the slot writes below after the consumer's
+             * reads; the release passes that on to producers using the copy. */
+            const uint32_t head = SW_ATOMIC_LOAD_ACQUIRE(&q->head);
+            SW_ATOMIC_STORE_RELEASE(&q->head_cache, head);
+            room = sw_txq_room(tail, head, limit);
+        }
+
+        k = n < room ? n : room;
+        if (k == 0)
+        {
+            /* No room may only mean our tail is stale: retry with the
+             * current one, and report backpressure only if it held. */
+            const uint32_t now = SW_ATOMIC_LOAD_ACQUIRE(&q->tail);
+            if (now == tail)
+                break;
+            tail = now;
+            continue;
+        }
+
+        /* On failure @p tail is reloaded and the room recomputed. */
+        if (SW_ATOMIC_CAS(&q->tail, &tail, tail + k))
+            break;
+    }
+
+    for (uint32_t i = 0; i < k; i++)
+    {
+        sw_txq_slot_t *slot = &q->slots[(tail + i) & q->mask];
+        slot->desc = descs[i];
+        SW_ATOMIC_STORE_RELEASE(&slot->seq, tail + i + 1u);
+    }
+
+    if (k < n)
+        SW_ATOMIC_FETCH_ADD_RELAXED(&q->rejected, n - k);
+
+    sw_trace_end(t, SW_SPAN_TXQ_ENQUEUE, q, (uint16_t)(k > 0xFFFFu ? 0xFFFFu : k));
+    return k;
+}
+
+uint32_t sw_txq_dequeue_burst(sw_txq_t *q, sw_desc_t *out, uint32_t max)
+{
+    if (!q || !out)
+        return 0;
+
+    const uint64_t t = sw_trace_begin();
+
+    const uint32_t head = q->head;
+    uint32_t n = 0;
+
+    while (n < max)
+    {
+        const sw_txq_slot_t *slot = &q->slots[(head + n) & q->mask];
+        if (SW_ATOMIC_LOAD_ACQUIRE(&slot->seq) != head + n + 1u)
+            break;
+        out[n++] = slot->desc;
+    }
+
+    if (n > 0)
+        SW_ATOMIC_STORE_RELEASE(&q->head, head + n);
+
+    sw_trace_end(t, SW_SPAN_TXQ_DEQUEUE, q, (uint16_t)(n > 0xFFFFu ? 0xFFFFu : n));
+    return n;
+}
+
+uint32_t sw_txq_count(const sw_txq_t *q)
+{
+    if (!q)
+        return 0;
+
+    return SW_ATOMIC_LOAD_ACQUIRE(&q->tail) - SW_ATOMIC_LOAD_ACQUIRE(&q->head);
+}
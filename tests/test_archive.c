@@ -0,0 +1,278 @@
+/**
+ * @file test_archive.c
+ * @brief Unit tests for the columnar telemetry archive.
+ */
+#include "cunit.h"
+#include "spacewire_archive.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define ROWS 300u
+#define DATA_LEN 16u
+
+#define STORAGE (64u * 1024u)
+#define IMAGE (128u * 1024u)
+
+static uint8_t g_storage_region[STORAGE + SW_ARCHIVE_ALIGN];
+static uint8_t g_image_region[3u][IMAGE + SW_ARCHIVE_ALIGN];
+static uint8_t *g_storage;
+static uint8_t *g_image[3];
+static uint8_t g_data[ROWS][DATA_LEN];
+static sw_packet_frame_t g_frames[ROWS];
+static uint64_t g_times[ROWS];
+
+static uint8_t *align64(uint8_t *region)
+{
+    const uintptr_t p = (uintptr_t)region;
+    return &region[(SW_ARCHIVE_ALIGN - (p % SW_ARCHIVE_ALIGN)) % SW_ARCHIVE_ALIGN];
+}
+
+static void make_frames(void)
+{
+    g_storage = align64(g_storage_region);
+    for (unsigned k = 0; k < 3u; k++)
+        g_image[k] = align64(g_image_region[k]);
+
+    for (unsigned i = 0; i < ROWS; i++)
+    {
+        for (unsigned j = 0; j < DATA_LEN; j++)
+            g_data[i][j] = (uint8_t)(i * 7u + j * 13u);
+        g_data[i][0] = 0x5A; /* constant */
+        memset(&g_frames[i], 0, sizeof(g_frames[i]));
+        g_frames[i].logical_addr = (uint8_t)(0x40u + i % 3u);
+        g_frames[i].user_app = 2;
+        g_frames[i].packet.ph.apid = 0x123u;
+        g_frames[i].packet.ph.seq_count = (unsigned)((1000u + i) & 0x3FFFu);
+        g_frames[i].packet.data = g_data[i];
+        g_frames[i].packet.data_len = DATA_LEN;
+        g_times[i] = 5000000000ull + 1000u * i;
+    }
+}
+
+static int test_archive_headers(void)
+{
+    sw_archive_writer_t w;
+    sw_archive_reader_t r;
+    size_t len = 0;
+
+    make_frames();
+    ASSERT_EQ_INT(SW_OK,
+                  sw_archive_writer_init(&w, 0x123, NULL, NULL, ROWS, g_storage, STORAGE));
+    ASSERT_EQ_INT(ROWS, (int)sw_archive_append(&w, g_times, g_frames, ROWS));
+    ASSERT_EQ_INT(0, (int)sw_archive_append(&w, g_times, g_frames, 1));
+    ASSERT_TRUE(sw_archive_flush_bound(&w) <= IMAGE);
+    ASSERT_EQ_INT(SW_OK, sw_archive_flush(&w, g_image[0], IMAGE, &len));
+    ASSERT_TRUE(len > 0 && len % SW_ARCHIVE_ALIGN == 0);
+
+    ASSERT_EQ_INT(SW_OK, sw_archive_open(&r, g_image[0], len));
+    const sw_archive_chunk_t *c = sw_archive_next(&r, NULL);
+    ASSERT_TRUE(c != NULL);
+    ASSERT_EQ_INT(0x123, c->apid);
+    ASSERT_EQ_INT(ROWS, (int)c->num_rows);
+    ASSERT_EQ_INT(SW_ARCHIVE_COL_PARAM, (int)c->num_columns);
+    ASSERT_TRUE(c->t_min == g_times[0] && c->t_max == g_times[ROWS - 1u]);
+    ASSERT_TRUE(sw_archive_next(&r, c) == NULL);
+    ASSERT_TRUE(sw_archive_column(c, SW_ARCHIVE_COL_PARAM) == NULL);
+
+    /* Times span 299 us: offsets from the first time in four octets. */
+    const sw_archive_column_t *col = sw_archive_column(c, SW_ARCHIVE_COL_TIME);
+    ASSERT_EQ_INT(SW_ARCHIVE_FOR, col->encoding);
+    ASSERT_EQ_INT(4, col->width);
+    ASSERT_TRUE(col->base == g_times[0]);
+    ASSERT_TRUE(sw_archive_values(c, col) == NULL);
+    ASSERT_TRUE(sw_archive_validity(c, col) == NULL);
+    uint64_t times[ROWS];
+    ASSERT_EQ_INT(SW_OK, sw_archive_read(c, col, 0, ROWS, times));
+    ASSERT_TRUE(memcmp(times, g_times, sizeof(times)) == 0);
+    ASSERT_EQ_INT(SW_OK, sw_archive_read(c, col, 290, 10, times));
+    ASSERT_TRUE(times[9] == g_times[299]);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_archive_read(c, col, 290, 11, times));
+
+    /* Constant APID and User Application; addresses are plain octets. */
+    ASSERT_EQ_INT(SW_ARCHIVE_CONST, sw_archive_column(c, SW_ARCHIVE_COL_APID)->encoding);
+    ASSERT_TRUE(sw_archive_column(c, SW_ARCHIVE_COL_APID)->base == 0x123u);
+    ASSERT_EQ_INT(SW_ARCHIVE_CONST, sw_archive_column(c, SW_ARCHIVE_COL_USER_APP)->encoding);
+    col = sw_archive_column(c, SW_ARCHIVE_COL_ADDR);
+    ASSERT_EQ_INT(SW_ARCHIVE_PLAIN, col->encoding);
+    const uint8_t *addr = sw_archive_values(c, col);
+    ASSERT_TRUE(addr != NULL && ((uintptr_t)addr % SW_ARCHIVE_ALIGN) == 0);
+    ASSERT_EQ_INT(0x42, addr[299]);
+
+    /* Sequence counts 1000..1299 would need 16-bit offsets: stay plain. */
+    col = sw_archive_column(c, SW_ARCHIVE_COL_SEQ);
+    ASSERT_EQ_INT(SW_ARCHIVE_PLAIN, col->encoding);
+    ASSERT_EQ_INT(2, col->width);
+    uint16_t seq[ROWS];
+    ASSERT_EQ_INT(SW_OK, sw_archive_read(c, col, 0, ROWS, seq));
+    ASSERT_EQ_INT(1000, seq[0]);
+    ASSERT_EQ_INT(1299, seq[299]);
+    uint8_t apid_bytes[2 * ROWS];
+    col = sw_archive_column(c, SW_ARCHIVE_COL_APID);
+    ASSERT_EQ_INT(SW_OK, sw_archive_read(c, col, 0, ROWS, apid_bytes));
+    ASSERT_EQ_INT(0x123, apid_bytes[2 * 299] | (apid_bytes[2 * 299 + 1] << 8));
+
+    /* Flushing an empty writer produces nothing. */
+    ASSERT_EQ_INT(SW_OK, sw_archive_flush(&w, g_image[0], IMAGE, &len));
+    ASSERT_EQ_INT(0, (int)len);
+    return 0;
+}
+
+/* Decommutated parameters, with nulls for other APIDs and short packets. */
+static int test_archive_params(void)
+{
+    const sw_decom_param_t params[] = {
+        {0, 8, SW_DECOM_BIG, SW_DECOM_UINT},    /* constant 0x5A */
+        {8, 12, SW_DECOM_BIG, SW_DECOM_INT},    /* signed, 12 bits */
+        {32, 32, SW_DECOM_BIG, SW_DECOM_FLOAT}, /* plain doubles */
+        {64, 64, SW_DECOM_BIG, SW_DECOM_UINT},  /* wide range: plain */
+    };
+    sw_decom_word_t words[4];
+    sw_decom_op_t ops[4];
+    sw_decom_plan_t plan;
+    sw_archive_writer_t w;
+    sw_archive_reader_t r;
+    size_t len = 0;
+
+    make_frames();
+    g_frames[10].packet.ph.apid = 0x124u;
+    g_frames[200].packet.data_len = 4;
+
+    ASSERT_EQ_INT(SW_OK, sw_decom_compile(&plan, 0x123, params, 4, words, ops));
+    ASSERT_EQ_INT(SW_INVALID_PARAM,
+                  sw_archive_writer_init(&w, 0, &plan, NULL, ROWS, g_storage, STORAGE));
+    ASSERT_EQ_INT(SW_INVALID_PARAM,
+                  sw_archive_writer_init(&w, 0, &plan, params, ROWS, g_storage, 64));
+    ASSERT_TRUE(sw_archive_storage_size(ROWS, 4) <= STORAGE);
+    ASSERT_EQ_INT(SW_OK,
+                  sw_archive_writer_init(&w, 0, &plan, params, ROWS, g_storage, STORAGE));
+
+    /* Appended in two calls; the second is cut at the chunk size. */
+    ASSERT_EQ_INT(100, (int)sw_archive_append(&w, g_times, g_frames, 100));
+    ASSERT_EQ_INT(200, (int)sw_archive_append(&w, &g_times[100], &g_frames[100], 250));
+    ASSERT_EQ_INT(SW_ERR, sw_archive_flush(&w, g_image[0], 1024, &len));
+    ASSERT_EQ_INT(SW_OK, sw_archive_flush(&w, g_image[0], IMAGE, &len));
+
+    ASSERT_EQ_INT(SW_OK, sw_archive_open(&r, g_image[0], len));
+    const sw_archive_chunk_t *c = sw_archive_next(&r, NULL);
+    ASSERT_TRUE(c != NULL);
+    ASSERT_EQ_INT(SW_ARCHIVE_COL_PARAM + 4, (int)c->num_columns);
+
+    /* The header columns keep every row; the APID column now varies. */
+    ASSERT_EQ_INT(0, (int)sw_archive_column(c, SW_ARCHIVE_COL_APID)->null_count);
+    ASSERT_EQ_INT(SW_ARCHIVE_FOR, sw_archive_column(c, SW_ARCHIVE_COL_APID)->encoding);
+
+    for (unsigned p = 0; p < 4u; p++)
+    {
+        const sw_archive_column_t *col = sw_archive_column(c, SW_ARCHIVE_COL_PARAM + p);
+        const uint8_t *bits = sw_archive_validity(c, col);
+        ASSERT_EQ_INT(2, (int)col->null_count);
+        ASSERT_TRUE(bits != NULL);
+        ASSERT_EQ_INT(0, (bits[10 / 8] >> (10 % 8)) & 1);
+        ASSERT_EQ_INT(0, (bits[200 / 8] >> (200 % 8)) & 1);
+        ASSERT_EQ_INT(1, (bits[11 / 8] >> (11 % 8)) & 1);
+        ASSERT_EQ_INT(1, (bits[299 / 8] >> (299 % 8)) & 1);
+    }
+
+    const sw_archive_column_t *col = sw_archive_column(c, SW_ARCHIVE_COL_PARAM + 0);
+    ASSERT_EQ_INT(SW_ARCHIVE_CONST, col->encoding);
+    ASSERT_TRUE(col->base == 0x5Au);
+
+    col = sw_archive_column(c, SW_ARCHIVE_COL_PARAM + 1);
+    ASSERT_EQ_INT(SW_ARCHIVE_I64, col->type);
+    ASSERT_EQ_INT(SW_ARCHIVE_FOR, col->encoding);
+    ASSERT_EQ_INT(2, col->width);
+    int64_t ints[ROWS];
+    ASSERT_EQ_INT(SW_OK, sw_archive_read(c, col, 0, ROWS, ints));
+    for (unsigned i = 0; i < ROWS; i++)
+    {
+        if (i == 10 || i == 200)
+            continue;
+        int64_t v = (int64_t)(((unsigned)g_data[i][1] << 4) | (g_data[i][2] >> 4));
+        if (v >= 2048)
+            v -= 4096;
+        ASSERT_TRUE(ints[i] == v);
+    }
+
+    col = sw_archive_column(c, SW_ARCHIVE_COL_PARAM + 2);
+    ASSERT_EQ_INT(SW_ARCHIVE_F64, col->type);
+    ASSERT_EQ_INT(SW_ARCHIVE_PLAIN, col->encoding);
+    const double *dbl = sw_archive_values(c, col);
+    ASSERT_TRUE(dbl != NULL);
+    {
+        const uint8_t *d = g_data[7];
+        const uint32_t bits = ((uint32_t)d[4] << 24) | ((uint32_t)d[5] << 16) |
+                              ((uint32_t)d[6] << 8) | d[7];
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        ASSERT_TRUE(memcmp(&dbl[7], &(double){(double)f}, sizeof(double)) == 0);
+    }
+
+    col = sw_archive_column(c, SW_ARCHIVE_COL_PARAM + 3);
+    ASSERT_EQ_INT(SW_ARCHIVE_PLAIN, col->encoding);
+    ASSERT_EQ_INT(8, col->width);
+    return 0;
+}
+
+/* Chunks of several APIDs in one archive; a torn tail is ignored. */
+static int test_archive_chunks(void)
+{
+    sw_archive_writer_t w[2];
+    uint8_t *storage[2] = {g_storage, g_storage + 16384u};
+    sw_archive_reader_t r;
+    size_t total = 0;
+    size_t len = 0;
+
+    make_frames();
+    ASSERT_EQ_INT(SW_OK, sw_archive_writer_init(&w[0], 0x10, NULL, NULL, 64, storage[0], 16384));
+    ASSERT_EQ_INT(SW_OK, sw_archive_writer_init(&w[1], 0x20, NULL, NULL, 64, storage[1], 16384));
+    ASSERT_EQ_INT(SW_INVALID_PARAM,
+                  sw_archive_writer_init(&w[1], 0x20, NULL, NULL, 0, storage[1], 16384));
+
+    /* Alternate chunks of the two writers, as two recorders would append. */
+    for (unsigned k = 0; k < 4u; k++)
+    {
+        sw_archive_writer_t *wr = &w[k % 2u];
+        ASSERT_EQ_INT(50, (int)sw_archive_append(wr, &g_times[50u * k], &g_frames[50u * k], 50));
+        ASSERT_EQ_INT(SW_OK, sw_archive_flush(wr, g_image[1] + total, IMAGE - total, &len));
+        total += len;
+    }
+
+    ASSERT_EQ_INT(SW_OK, sw_archive_open(&r, g_image[1], total));
+    unsigned chunks = 0;
+    for (const sw_archive_chunk_t *c = sw_archive_next(&r, NULL); c; c = sw_archive_next(&r, c))
+    {
+        ASSERT_EQ_INT(chunks % 2u ? 0x20 : 0x10, c->apid);
+        ASSERT_TRUE(c->t_min == g_times[50u * chunks]);
+        chunks++;
+    }
+    ASSERT_EQ_INT(4, (int)chunks);
+
+    /* The recorder died while appending the last chunk. */
+    ASSERT_EQ_INT(SW_OK, sw_archive_open(&r, g_image[1], total - 64u));
+    chunks = 0;
+    for (const sw_archive_chunk_t *c = sw_archive_next(&r, NULL); c; c = sw_archive_next(&r, c))
+        chunks++;
+    ASSERT_EQ_INT(3, (int)chunks);
+
+    /* A corrupted descriptor ends the archive too. */
+    const sw_archive_chunk_t *first = sw_archive_next(&r, NULL);
+    sw_archive_column_t *col = (sw_archive_column_t *)(uintptr_t)sw_archive_column(first, 1);
+    col->values = first->size;
+    ASSERT_TRUE(sw_archive_next(&r, NULL) == NULL);
+
+    memset(g_image[2], 0, 64);
+    ASSERT_EQ_INT(SW_ERR, sw_archive_open(&r, g_image[2], 64));
+    ASSERT_EQ_INT(SW_OK, sw_archive_open(&r, g_image[2], 0));
+    ASSERT_TRUE(sw_archive_next(&r, NULL) == NULL);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_archive_open(&r, g_image[2] + 8, 56));
+    return 0;
+}
+
+test_result_t test_spacewire_archive_run_all(void)
+{
+    RUN_TEST(test_archive_headers);
+    RUN_TEST(test_archive_params);
+    RUN_TEST(test_archive_chunks);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
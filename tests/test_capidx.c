@@ -0,0 +1,274 @@
+/**
+ * @file test_capidx.c
+ * @brief Unit tests for the capture index.
+ */
+#include "cunit.h"
+#include "spacewire_capidx.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define PACKETS 1000u
+#define SEGMENT 64u
+#define MAX_SEGMENTS 32u
+
+typedef struct
+{
+    uint64_t time;
+    uint64_t offset;
+    uint32_t apid; /* SW_CAPIDX_ANY if none */
+    uint32_t addr; /* SW_CAPIDX_ANY if none */
+} packet_t;
+
+static packet_t g_packets[PACKETS];
+static sw_capidx_writer_t g_w;
+static sw_capidx_record_t g_records[SEGMENT];
+static uint16_t g_keys[2u * SEGMENT];
+static sw_capidx_dirent_t g_dir[MAX_SEGMENTS];
+static uint64_t g_image[65536]; /* 8-octet aligned */
+static size_t g_len;
+static size_t g_seg_end[MAX_SEGMENTS + 1u]; /* sidecar length after each flush */
+static unsigned g_flushes;
+
+/* Capture a synthetic stream, flushing the sidecar into g_image. */
+static int build(uint32_t max_segments, int finish)
+{
+    uint8_t pkt[64];
+    const uint8_t payload[4] = {1, 2, 3, 4};
+    uint64_t offset = 0;
+    size_t out;
+
+    ASSERT_EQ_INT(SW_OK,
+                  sw_capidx_writer_init(&g_w, g_records, g_keys, SEGMENT, g_dir, max_segments));
+    g_len = 0;
+    g_flushes = 0;
+
+    for (uint32_t i = 0; i < PACKETS; i++)
+    {
+        packet_t *p = &g_packets[i];
+        size_t len;
+
+        p->time = 1000u + (uint64_t)(i / 3u) * 7u; /* repeated times */
+        p->offset = offset;
+        if (i % 50u == 49u)
+        {
+            /* Not a PTP packet. */
+            pkt[0] = 0x30;
+            pkt[1] = 0x01;
+            len = 2;
+            p->apid = SW_CAPIDX_ANY;
+            p->addr = SW_CAPIDX_ADDR(0x30);
+        }
+        else
+        {
+            const uint8_t addr = (uint8_t)(0x40u + i % 3u);
+            const uint16_t apid = (uint16_t)((i * 7u) % 11u == 0 ? 0x123u : (i % 5u) + 0x700u);
+            /* Every fourth packet is captured with two path octets in front. */
+            const size_t lead = i % 4u == 0 ? 2u : 0u;
+            pkt[0] = 3;
+            pkt[1] = 9;
+            len = lead + sw_packet_create(addr, 0, apid, payload, 4, &pkt[lead], 60);
+            p->apid = SW_CAPIDX_APID(apid);
+            p->addr = SW_CAPIDX_ADDR(addr);
+            ASSERT_TRUE(len > lead);
+        }
+        offset += 16u + len;
+
+        sw_result_t r = sw_capidx_add(&g_w, p->time, p->offset, pkt, len);
+        if (r == SW_ERR)
+        {
+            ASSERT_EQ_INT(SW_OK,
+                          sw_capidx_flush(&g_w,
+                                          (uint8_t *)g_image + g_len,
+                                          sizeof(g_image) - g_len,
+                                          &out));
+            g_len += out;
+            g_seg_end[g_flushes++] = g_len;
+            r = sw_capidx_add(&g_w, p->time, p->offset, pkt, len);
+        }
+        ASSERT_EQ_INT(SW_OK, r);
+    }
+
+    if (finish)
+    {
+        ASSERT_EQ_INT(SW_OK,
+                      sw_capidx_finish(&g_w,
+                                       (uint8_t *)g_image + g_len,
+                                       sizeof(g_image) - g_len,
+                                       &out));
+        g_len += out;
+    }
+    return 0;
+}
+
+/* Run a query in calls of at most @p step results and compare it with a
+ * scan of the first @p known packets. */
+static int check(const sw_capidx_reader_t *r,
+                 uint32_t key,
+                 uint64_t t_begin,
+                 uint64_t t_end,
+                 size_t step,
+                 uint32_t known)
+{
+    static sw_capidx_record_t got[PACKETS];
+    sw_capidx_cursor_t cursor;
+    size_t n = 0;
+    size_t k;
+
+    memset(&cursor, 0, sizeof(cursor));
+    do
+    {
+        k = sw_capidx_query(r, key, t_begin, t_end, &cursor, &got[n], step);
+        n += k;
+    } while (k == step && n + step <= PACKETS);
+
+    size_t expect = 0;
+    for (uint32_t i = 0; i < known; i++)
+    {
+        const packet_t *p = &g_packets[i];
+        if (p->time < t_begin || p->time >= t_end)
+            continue;
+        if (key != SW_CAPIDX_ANY && key != p->apid && key != p->addr)
+            continue;
+
+        ASSERT_TRUE(expect < n);
+        ASSERT_TRUE(got[expect].time == p->time);
+        ASSERT_TRUE(got[expect].offset == p->offset);
+        expect++;
+    }
+    ASSERT_EQ_INT((int)expect, (int)n);
+    return 0;
+}
+
+static int test_capidx_init(void)
+{
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_capidx_writer_init(NULL, g_records, g_keys, 4, NULL, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_capidx_writer_init(&g_w, NULL, g_keys, 4, NULL, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_capidx_writer_init(&g_w, g_records, g_keys, 0, NULL, 0));
+    ASSERT_EQ_INT(SW_OK, sw_capidx_writer_init(&g_w, g_records, g_keys, SEGMENT, NULL, 0));
+
+    /* Header, segment header, records, keys + sentinel, postings. */
+    ASSERT_EQ_INT(16 + 40 + 16 + 3 * 8 + 2 * 4, (int)sw_capidx_flush_bound(1));
+
+    /* An empty capture is a valid sidecar. */
+    size_t len;
+    sw_capidx_reader_t r;
+    sw_capidx_cursor_t cursor = {0, 0};
+    sw_capidx_record_t rec;
+    ASSERT_EQ_INT(SW_OK, sw_capidx_writer_init(&g_w, g_records, g_keys, SEGMENT, g_dir, 1));
+    ASSERT_EQ_INT(SW_OK, sw_capidx_finish(&g_w, g_image, sizeof(g_image), &len));
+    ASSERT_EQ_INT(32, (int)len);
+    ASSERT_EQ_INT(SW_OK, sw_capidx_open(&r, g_image, len));
+    ASSERT_TRUE(r.dir != NULL);
+    ASSERT_EQ_INT(0, (int)sw_capidx_query(&r, SW_CAPIDX_ANY, 0, UINT64_MAX, &cursor, &rec, 1));
+    return 0;
+}
+
+static int test_capidx_query(void)
+{
+    sw_capidx_reader_t r;
+
+    if (build(MAX_SEGMENTS, 1) != 0)
+        return 1;
+    ASSERT_EQ_INT(SW_OK, sw_capidx_open(&r, g_image, g_len));
+    ASSERT_TRUE(r.dir != NULL);
+    ASSERT_EQ_INT((PACKETS + SEGMENT - 1u) / SEGMENT, (int)r.num_segments);
+
+    const uint64_t t_last = g_packets[PACKETS - 1u].time;
+    const uint32_t keys[] = {SW_CAPIDX_APID(0x123),
+                             SW_CAPIDX_APID(0x702),
+                             SW_CAPIDX_ADDR(0x41),
+                             SW_CAPIDX_ADDR(0x30),
+                             SW_CAPIDX_ANY};
+
+    for (unsigned k = 0; k < sizeof(keys) / sizeof(keys[0]); k++)
+    {
+        ASSERT_EQ_INT(0, check(&r, keys[k], 0, UINT64_MAX, 1000, PACKETS));
+        ASSERT_EQ_INT(0, check(&r, keys[k], 1500, 2400, 1000, PACKETS));
+        ASSERT_EQ_INT(0, check(&r, keys[k], 1500, 2400, 3, PACKETS));
+        ASSERT_EQ_INT(0, check(&r, keys[k], 1007, 1008, 1, PACKETS));
+        ASSERT_EQ_INT(0, check(&r, keys[k], t_last, t_last + 1u, 2, PACKETS));
+    }
+
+    /* Keys and windows without packets. */
+    ASSERT_EQ_INT(0, check(&r, SW_CAPIDX_APID(0x124), 0, UINT64_MAX, 10, PACKETS));
+    ASSERT_EQ_INT(0, check(&r, SW_CAPIDX_ANY, 0, 1000, 10, PACKETS));
+    ASSERT_EQ_INT(0, check(&r, SW_CAPIDX_ANY, t_last + 1u, UINT64_MAX, 10, PACKETS));
+    ASSERT_EQ_INT(0, check(&r, SW_CAPIDX_ANY, 1502, 1503, 10, PACKETS));
+    return 0;
+}
+
+/* A sidecar read while the capture runs, or after the recorder died. */
+static int test_capidx_unfinished(void)
+{
+    sw_capidx_reader_t r;
+
+    if (build(MAX_SEGMENTS, 0) != 0)
+        return 1;
+    ASSERT_TRUE(g_flushes >= 3);
+    ASSERT_EQ_INT(SW_OK, sw_capidx_open(&r, g_image, g_len));
+    ASSERT_TRUE(r.dir == NULL);
+    ASSERT_EQ_INT(0, check(&r, SW_CAPIDX_APID(0x123), 1100, 2200, 4, g_flushes * SEGMENT));
+    ASSERT_EQ_INT(0, check(&r, SW_CAPIDX_ANY, 0, UINT64_MAX, 1000, g_flushes * SEGMENT));
+
+    /* Torn last segment: it is ignored. */
+    const size_t torn = g_seg_end[g_flushes - 2u] + 100u;
+    ASSERT_EQ_INT(SW_OK, sw_capidx_open(&r, g_image, torn));
+    ASSERT_EQ_INT(0,
+                  check(&r, SW_CAPIDX_ADDR(0x40), 0, UINT64_MAX, 7, (g_flushes - 1u) * SEGMENT));
+
+    /* No directory storage, or too little of it: no directory written. */
+    if (build(2, 1) != 0)
+        return 1;
+    ASSERT_EQ_INT(SW_OK, sw_capidx_open(&r, g_image, g_len));
+    ASSERT_TRUE(r.dir == NULL);
+    ASSERT_EQ_INT(0, check(&r, SW_CAPIDX_APID(0x702), 1300, 3000, 5, PACKETS));
+    return 0;
+}
+
+static int test_capidx_errors(void)
+{
+    sw_capidx_reader_t r;
+    size_t len;
+    const uint8_t pkt[2] = {0x50, 0x00};
+
+    ASSERT_EQ_INT(SW_OK, sw_capidx_writer_init(&g_w, g_records, g_keys, 2, g_dir, MAX_SEGMENTS));
+    ASSERT_EQ_INT(SW_OK, sw_capidx_add(&g_w, 10, 0, pkt, 2));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_capidx_add(&g_w, 9, 0, pkt, 2));
+    ASSERT_EQ_INT(SW_OK, sw_capidx_add(&g_w, 10, 18, NULL, 0));
+    ASSERT_EQ_INT(SW_ERR, sw_capidx_add(&g_w, 11, 34, pkt, 2));
+
+    /* Too small a buffer consumes nothing. */
+    ASSERT_EQ_INT(SW_ERR, sw_capidx_flush(&g_w, g_image, 40, &len));
+    ASSERT_EQ_INT(2, (int)g_w.num_records);
+    ASSERT_EQ_INT(SW_ERR, sw_capidx_finish(&g_w, g_image, 100, &len));
+    ASSERT_EQ_INT(SW_OK, sw_capidx_finish(&g_w, g_image, sizeof(g_image), &len));
+    size_t again = 1;
+    ASSERT_EQ_INT(SW_ERR, sw_capidx_finish(&g_w, g_image, sizeof(g_image), &again));
+    ASSERT_EQ_INT(0, (int)again);
+    ASSERT_EQ_INT(SW_ERR, sw_capidx_add(&g_w, 12, 50, pkt, 2));
+
+    ASSERT_EQ_INT(SW_OK, sw_capidx_open(&r, g_image, len));
+    sw_capidx_cursor_t cursor = {0, 0};
+    sw_capidx_record_t got[4];
+    ASSERT_EQ_INT(1, (int)sw_capidx_query(&r, SW_CAPIDX_ADDR(0x50), 0, 100, &cursor, got, 4));
+    ASSERT_TRUE(got[0].time == 10u && got[0].offset == 0);
+    memset(&cursor, 0, sizeof(cursor));
+    ASSERT_EQ_INT(2, (int)sw_capidx_query(&r, SW_CAPIDX_ANY, 0, 100, &cursor, got, 4));
+    ASSERT_TRUE(got[1].offset == 18u);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_capidx_open(&r, (uint8_t *)g_image + 4, len - 8u));
+    ASSERT_EQ_INT(SW_ERR, sw_capidx_open(&r, g_image, 8));
+
+    g_image[0] ^= 1u;
+    ASSERT_EQ_INT(SW_ERR, sw_capidx_open(&r, g_image, len));
+    return 0;
+}
+
+test_result_t test_spacewire_capidx_run_all(void)
+{
+    RUN_TEST(test_capidx_init);
+    RUN_TEST(test_capidx_query);
+    RUN_TEST(test_capidx_unfinished);
+    RUN_TEST(test_capidx_errors);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
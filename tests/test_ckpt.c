@@ -0,0 +1,317 @@
+/**
+ * @file test_ckpt.c
+ * @brief Unit tests for simulator checkpoints.
+ */
+#include "cunit.h"
+#include "spacewire_ckpt.h"
+#include "test_runners.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SIDE 4u
+#define NODES (SIDE * SIDE)
+#define LINKS (2u * SIDE * (SIDE - 1u))
+#define EVENTS 1024u
+#define IMAGE_SIZE (160u * 1024u)
+
+typedef struct
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[LINKS];
+    uint64_t dist[NODES];
+    uint16_t heap[NODES];
+    uint16_t pos[NODES];
+    uint8_t tables[2 * NODES * SW_ROUTE_TABLE_SIZE];
+    sw_sim_t sim;
+    sw_sim_node_t sim_nodes[NODES];
+    sw_sim_event_t events[EVENTS];
+} fixture_t;
+
+static uint8_t g_raw[2][IMAGE_SIZE + SW_CKPT_ALIGN];
+
+static uint8_t *image_buf(unsigned i)
+{
+    const uintptr_t p = (uintptr_t)g_raw[i];
+    return &g_raw[i][(SW_CKPT_ALIGN - p % SW_CKPT_ALIGN) % SW_CKPT_ALIGN];
+}
+
+/*
+ * A 4 x 4 mesh under traffic from every node; the link east of n5 fails at
+ * 200 us and the new routes are installed at 230 us.
+ */
+static int setup(fixture_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    ASSERT_EQ_INT(SW_OK, sw_net_init(&f->net, f->nodes, NODES, f->links, LINKS));
+
+    for (unsigned i = 0; i < NODES; i++)
+        ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 5, (uint8_t)(0x40u + i), NULL));
+
+    uint16_t failing = SW_NET_NONE;
+    for (unsigned y = 0; y < SIDE; y++)
+    {
+        for (unsigned x = 0; x < SIDE; x++)
+        {
+            const uint16_t n = (uint16_t)(y * SIDE + x);
+            uint16_t l = 0;
+            if (x + 1u < SIDE)
+            {
+                ASSERT_EQ_INT(SW_OK,
+                              sw_net_connect(&f->net, n, 2, (uint16_t)(n + 1u), 4, 100000000, 300,
+                                             &l));
+                if (n == 5)
+                    failing = l;
+            }
+            if (y + 1u < SIDE)
+                ASSERT_EQ_INT(SW_OK,
+                              sw_net_connect(&f->net, n, 3, (uint16_t)(n + SIDE), 1, 100000000,
+                                             200, NULL));
+        }
+    }
+
+    const sw_net_work_t work = {.dist = f->dist, .heap = f->heap, .pos = f->pos};
+    uint8_t *after = &f->tables[NODES * SW_ROUTE_TABLE_SIZE];
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&f->net, &work, f->tables));
+    ASSERT_EQ_INT(SW_OK, sw_net_install_routes(&f->net, f->tables));
+    f->links[failing].up = 0;
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&f->net, &work, after));
+    f->links[failing].up = 1;
+
+    ASSERT_EQ_INT(SW_OK, sw_sim_init(&f->sim, &f->net, f->sim_nodes, f->events, EVENTS, 5));
+    for (uint16_t n = 0; n < NODES; n++)
+        ASSERT_EQ_INT(SW_OK, sw_sim_set_traffic(&f->sim, n, 5000, 32));
+
+    uint16_t t = 0;
+    ASSERT_EQ_INT(SW_OK, sw_sim_add_table(&f->sim, after, &t));
+    ASSERT_EQ_INT(SW_OK, sw_sim_schedule_link(&f->sim, failing, 200000, 0));
+    for (uint16_t n = 0; n < NODES; n++)
+        ASSERT_EQ_INT(SW_OK, sw_sim_schedule_install(&f->sim, n, 230000, t));
+    return 0;
+}
+
+/* Compare everything a run leaves behind. */
+static int same_state(const sw_sim_t *a, const sw_sim_t *b)
+{
+    ASSERT_TRUE(a->now == b->now);
+    ASSERT_EQ_INT((int)a->num_events, (int)b->num_events);
+    ASSERT_EQ_MEM(a->nodes, b->nodes, NODES * sizeof(sw_sim_node_t));
+    ASSERT_EQ_MEM(a->net->nodes, b->net->nodes, NODES * sizeof(sw_net_node_t));
+    ASSERT_EQ_MEM(a->net->links, b->net->links, LINKS * sizeof(sw_net_link_t));
+    ASSERT_EQ_MEM(a->events, b->events, a->num_events * sizeof(sw_sim_event_t));
+    return 0;
+}
+
+/* A restored run continues exactly as the original does. */
+static int test_ckpt_restore(void)
+{
+    static fixture_t orig;
+    static fixture_t copy;
+    uint8_t *image = image_buf(0);
+    uint8_t *again = image_buf(1);
+    size_t len = 0;
+    size_t len2 = 0;
+
+    ASSERT_EQ_INT(0, setup(&orig));
+    sw_sim_run(&orig.sim, 150000);
+    ASSERT_TRUE(orig.sim.num_events > NODES); /* packets in flight */
+
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_save(&orig.sim, image, sw_ckpt_size(&orig.sim) - 1u, &len));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ckpt_save(&orig.sim, image + 8, IMAGE_SIZE - 8u, &len));
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_save(&orig.sim, image, IMAGE_SIZE, &len));
+    ASSERT_EQ_INT((int)sw_ckpt_size(&orig.sim), (int)len);
+    ASSERT_EQ_INT(0, (int)(len % SW_CKPT_ALIGN));
+
+    memset(&copy, 0xA5, sizeof(copy));
+    sw_ckpt_storage_t st = {.nodes = copy.nodes,
+                            .links = copy.links,
+                            .sim_nodes = copy.sim_nodes,
+                            .events = copy.events,
+                            .tables = copy.tables,
+                            .max_nodes = NODES,
+                            .max_links = LINKS,
+                            .max_events = EVENTS,
+                            .max_tables = 2};
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_restore(image, len, &st, &copy.net, &copy.sim));
+    ASSERT_EQ_INT(0, same_state(&orig.sim, &copy.sim));
+    ASSERT_EQ_MEM(orig.sim.tables[0], copy.sim.tables[0], NODES * SW_ROUTE_TABLE_SIZE);
+
+    /* Equal states give equal images. */
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_save(&copy.sim, again, IMAGE_SIZE, &len2));
+    ASSERT_EQ_INT((int)len, (int)len2);
+    ASSERT_EQ_MEM(image, again, len);
+
+    sw_sim_run(&orig.sim, 1000000);
+    sw_sim_run(&copy.sim, 1000000);
+    ASSERT_EQ_INT(0, same_state(&orig.sim, &copy.sim));
+
+    sw_sim_stats_t s;
+    sw_sim_get_stats(&copy.sim, &s);
+    ASSERT_TRUE(s.lost_link > 0); /* the failure after the checkpoint happened */
+
+    /* Storage too small. */
+    st.max_events = 4;
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_restore(image, len, &st, &copy.net, &copy.sim));
+    st.max_events = EVENTS;
+    st.max_tables = 0;
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_restore(image, len, &st, &copy.net, &copy.sim));
+    return 0;
+}
+
+/* Branches attached to copies of one image run independently in place. */
+static int test_ckpt_attach(void)
+{
+    static fixture_t orig;
+    static sw_sim_event_t events[EVENTS];
+    uint8_t *image = image_buf(0);
+    uint8_t *branch = image_buf(1);
+    sw_net_t net;
+    sw_sim_t sim;
+    size_t len = 0;
+
+    ASSERT_EQ_INT(0, setup(&orig));
+    sw_sim_run(&orig.sim, 150000);
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_save(&orig.sim, image, IMAGE_SIZE, &len));
+
+    memcpy(branch, image, len);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ckpt_attach(branch + 8, len, events, EVENTS, &net, &sim));
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_attach(branch, len, events, 4, &net, &sim));
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_attach(branch, len, events, EVENTS, &net, &sim));
+    ASSERT_TRUE((uint8_t *)net.nodes > branch && (uint8_t *)net.nodes < branch + len);
+
+    sw_sim_run(&orig.sim, 1000000);
+    sw_sim_run(&sim, 1000000);
+    ASSERT_EQ_INT(0, same_state(&orig.sim, &sim));
+
+    /* What-if: the saved image is untouched, so a second branch can bring
+     * the failed link back early and lose fewer packets. */
+    sw_sim_stats_t first;
+    sw_sim_stats_t second;
+    sw_sim_get_stats(&sim, &first);
+
+    memcpy(branch, image, len);
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_attach(branch, len, events, EVENTS, &net, &sim));
+    uint16_t failing = 0;
+    while (net.links[failing].node[0] != 5 || net.links[failing].port[0] != 2)
+        failing++;
+    ASSERT_EQ_INT(SW_OK, sw_sim_schedule_link(&sim, failing, 205000, 1));
+    sw_sim_run(&sim, 1000000);
+    sw_sim_get_stats(&sim, &second);
+    ASSERT_TRUE(second.lost_link < first.lost_link);
+    return 0;
+}
+
+/* Same routes, each in a table of the router's own. */
+static int own_routes(const sw_net_t *a, const sw_net_t *b)
+{
+    for (uint16_t n = 0; n < a->num_nodes; n++)
+    {
+        ASSERT_TRUE(b->nodes[n].router.routes == NULL);
+        for (unsigned addr = 0; addr < SW_ROUTE_TABLE_SIZE; addr++)
+        {
+            const sw_route_entry_t *x = sw_router_get_route(&a->nodes[n].router, (uint8_t)addr);
+            const sw_route_entry_t *y = sw_router_get_route(&b->nodes[n].router, (uint8_t)addr);
+            ASSERT_TRUE(x == y || (x && y && memcmp(x, y, sizeof(*x)) == 0));
+        }
+    }
+    return 0;
+}
+
+/* Routers sharing a table outside the network are saved and cloned with a
+ * copy of it each. */
+static int test_ckpt_shared_routes(void)
+{
+    static fixture_t orig;
+    static fixture_t copy;
+    static sw_route_table_t table;
+    uint8_t *image = image_buf(0);
+    size_t len = 0;
+
+    ASSERT_EQ_INT(0, setup(&orig));
+    ASSERT_EQ_INT(SW_OK, sw_router_set_routes(&orig.nodes[0].router, &table));
+    ASSERT_EQ_INT(SW_OK, sw_router_share_routes(&orig.nodes[1].router, &orig.nodes[0].router));
+    ASSERT_EQ_INT(2, (int)table.refs);
+
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_save(&orig.sim, image, IMAGE_SIZE, &len));
+    sw_ckpt_storage_t st = {.nodes = copy.nodes,
+                            .links = copy.links,
+                            .sim_nodes = copy.sim_nodes,
+                            .events = copy.events,
+                            .tables = copy.tables,
+                            .max_nodes = NODES,
+                            .max_links = LINKS,
+                            .max_events = EVENTS,
+                            .max_tables = 2};
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_restore(image, len, &st, &copy.net, &copy.sim));
+    ASSERT_EQ_INT(0, own_routes(&orig.net, &copy.net));
+
+    ASSERT_EQ_INT(SW_OK, sw_net_clone(&copy.net, copy.nodes, copy.links, &orig.net));
+    ASSERT_EQ_INT(0, own_routes(&orig.net, &copy.net));
+
+    /* Changing the copies leaves the original's table alone. */
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&copy.nodes[1].router, 0x40, 1, 0));
+    ASSERT_TRUE(orig.nodes[1].router.routes == &table && table.refs == 2);
+    ASSERT_TRUE(!table.entries[0x40].configured || table.entries[0x40].output_port != 1);
+    return 0;
+}
+
+static int test_ckpt_corrupt(void)
+{
+    static fixture_t orig;
+    static fixture_t copy;
+    uint8_t *image = image_buf(0);
+    size_t len = 0;
+
+    ASSERT_EQ_INT(0, setup(&orig));
+    sw_sim_run(&orig.sim, 50000);
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_save(&orig.sim, image, IMAGE_SIZE, &len));
+
+    sw_ckpt_storage_t st = {.nodes = copy.nodes,
+                            .links = copy.links,
+                            .sim_nodes = copy.sim_nodes,
+                            .events = copy.events,
+                            .tables = copy.tables,
+                            .max_nodes = NODES,
+                            .max_links = LINKS,
+                            .max_events = EVENTS,
+                            .max_tables = 2};
+
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_restore(image, len - 1u, &st, &copy.net, &copy.sim));
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_restore(image, 16, &st, &copy.net, &copy.sim));
+
+    /* A flipped bit anywhere is caught. */
+    image[len / 2u] ^= 0x10u;
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_restore(image, len, &st, &copy.net, &copy.sim));
+
+    /* Attaching checks the header only, leaving the sections unread. */
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_attach(image, len, copy.events, EVENTS, &copy.net, &copy.sim));
+    image[len / 2u] ^= 0x10u;
+    image[offsetof(sw_ckpt_header_t, now)] ^= 0x10u;
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_attach(image, len, copy.events, EVENTS, &copy.net, &copy.sim));
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_restore(image, len, &st, &copy.net, &copy.sim));
+    image[offsetof(sw_ckpt_header_t, now)] ^= 0x10u;
+
+    /* So is an image laid out by another build. */
+    sw_ckpt_header_t h;
+    memcpy(&h, image, sizeof(h));
+    h.struct_size[SW_CKPT_EVENTS]++;
+    memcpy(image, &h, sizeof(h));
+    ASSERT_EQ_INT(SW_ERR, sw_ckpt_restore(image, len, &st, &copy.net, &copy.sim));
+    h.struct_size[SW_CKPT_EVENTS]--;
+    memcpy(image, &h, sizeof(h));
+
+    ASSERT_EQ_INT(SW_OK, sw_ckpt_restore(image, len, &st, &copy.net, &copy.sim));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ckpt_restore(NULL, len, &st, &copy.net, &copy.sim));
+    return 0;
+}
+
+test_result_t test_spacewire_ckpt_run_all(void)
+{
+    RUN_TEST(test_ckpt_restore);
+    RUN_TEST(test_ckpt_attach);
+    RUN_TEST(test_ckpt_shared_routes);
+    RUN_TEST(test_ckpt_corrupt);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
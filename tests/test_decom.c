@@ -0,0 +1,217 @@
+/**
+ * @file test_decom.c
+ * @brief Unit tests for the decommutation engine.
+ */
+#include "cunit.h"
+#include "spacewire_decom.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define MAX_PARAMS 40u
+#define PACKETS 150u /* more than two inner batches */
+#define DATA_LEN 48u
+
+static sw_decom_plan_t g_plan;
+static sw_decom_word_t g_words[MAX_PARAMS];
+static sw_decom_op_t g_ops[MAX_PARAMS];
+static sw_decom_param_t g_params[MAX_PARAMS];
+static uint8_t g_data[PACKETS][DATA_LEN];
+static sw_packet_frame_t g_frames[PACKETS];
+static uint64_t g_columns[MAX_PARAMS][PACKETS];
+static uint8_t g_valid[PACKETS];
+
+static uint32_t g_rng = 2463534242u;
+
+static uint32_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+/* Reference: the parameter assembled bit by bit, as a generic decoder would. */
+static uint64_t reference(const sw_decom_param_t *p, const uint8_t *data)
+{
+    uint64_t v = 0;
+
+    if (p->endian == SW_DECOM_LITTLE)
+    {
+        for (unsigned i = p->width / 8u; i-- > 0;)
+            v = (v << 8) | data[p->bit_offset / 8u + i];
+    }
+    else
+    {
+        for (uint32_t b = p->bit_offset; b < p->bit_offset + p->width; b++)
+            v = (v << 1) | ((data[b / 8u] >> (7u - b % 8u)) & 1u);
+    }
+
+    if (p->type == SW_DECOM_INT && p->width < 64u && (v >> (p->width - 1u)) != 0)
+        v |= UINT64_MAX << p->width;
+    if (p->type == SW_DECOM_FLOAT && p->width == 32u)
+    {
+        const uint32_t bits = (uint32_t)v;
+        float f;
+        double d;
+        memcpy(&f, &bits, sizeof(f));
+        d = (double)f;
+        memcpy(&v, &d, sizeof(v));
+    }
+    return v;
+}
+
+static void make_frames(uint16_t apid)
+{
+    for (unsigned i = 0; i < PACKETS; i++)
+    {
+        for (unsigned j = 0; j < DATA_LEN; j++)
+            g_data[i][j] = (uint8_t)rnd();
+        memset(&g_frames[i], 0, sizeof(g_frames[i]));
+        g_frames[i].packet.ph.apid = (unsigned)(apid & 0x7FFu);
+        g_frames[i].packet.data = g_data[i];
+        g_frames[i].packet.data_len = DATA_LEN;
+    }
+}
+
+static int run_and_compare(uint16_t num_params)
+{
+    void *columns[MAX_PARAMS];
+    for (unsigned p = 0; p < num_params; p++)
+        columns[p] = g_columns[p];
+
+    memset(g_columns, 0xA5, sizeof(g_columns));
+    const size_t rows = sw_decom_run(&g_plan, g_frames, PACKETS, columns, g_valid);
+
+    size_t expect_rows = 0;
+    for (unsigned i = 0; i < PACKETS; i++)
+    {
+        const int ok = g_frames[i].packet.ph.apid == g_plan.apid &&
+                       g_frames[i].packet.data_len >= g_plan.min_len;
+        expect_rows += (size_t)ok;
+        ASSERT_EQ_INT(ok, g_valid[i]);
+
+        for (unsigned p = 0; p < num_params; p++)
+        {
+            const uint64_t expect = ok ? reference(&g_params[p], g_data[i]) : 0;
+            ASSERT_TRUE(g_columns[p][i] == expect);
+        }
+    }
+    ASSERT_EQ_INT((int)expect_rows, (int)rows);
+    return 0;
+}
+
+static int test_decom_compile(void)
+{
+    sw_decom_param_t p[4] = {
+        {0, 12, SW_DECOM_BIG, SW_DECOM_UINT},
+        {12, 4, SW_DECOM_BIG, SW_DECOM_INT},
+        {40, 32, SW_DECOM_BIG, SW_DECOM_FLOAT},
+        {16, 16, SW_DECOM_LITTLE, SW_DECOM_UINT},
+    };
+
+    ASSERT_EQ_INT(SW_OK, sw_decom_compile(&g_plan, 0x7AB, p, 4, g_words, g_ops));
+    ASSERT_EQ_INT(0x7AB, g_plan.apid);
+    ASSERT_EQ_INT(9, (int)g_plan.min_len);
+
+    /* Bits 0..71: all but the float share the window at octet 0. */
+    ASSERT_EQ_INT(2, g_plan.num_words);
+    ASSERT_EQ_INT(0, g_words[0].octet);
+    ASSERT_EQ_INT(3, g_words[0].num_ops);
+    ASSERT_EQ_INT(5, g_words[1].octet);
+    ASSERT_EQ_INT(0, g_ops[0].param);
+    ASSERT_EQ_INT(3, g_ops[2].param);
+    ASSERT_EQ_INT(2, g_ops[3].param);
+
+    p[0].width = 0;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_decom_compile(&g_plan, 1, p, 4, g_words, g_ops));
+    p[0].width = 65;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_decom_compile(&g_plan, 1, p, 4, g_words, g_ops));
+    p[0].width = 12;
+    p[2].width = 16;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_decom_compile(&g_plan, 1, p, 4, g_words, g_ops));
+    p[2].width = 32;
+    p[3].bit_offset = 17;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_decom_compile(&g_plan, 1, p, 4, g_words, g_ops));
+    p[3].bit_offset = 16;
+    p[3].width = 12;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_decom_compile(&g_plan, 1, p, 4, g_words, g_ops));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_decom_compile(&g_plan, 1, p, 0, g_words, g_ops));
+    return 0;
+}
+
+/* A fixed layout: packed status bits, signed and little-endian counters,
+ * floats, and fields that straddle windows or overhang into a ninth octet. */
+static int test_decom_layout(void)
+{
+    const sw_decom_param_t p[] = {
+        {0, 1, SW_DECOM_BIG, SW_DECOM_UINT},
+        {1, 3, SW_DECOM_BIG, SW_DECOM_UINT},
+        {4, 12, SW_DECOM_BIG, SW_DECOM_INT},
+        {16, 32, SW_DECOM_LITTLE, SW_DECOM_INT},
+        {48, 16, SW_DECOM_LITTLE, SW_DECOM_UINT},
+        {64, 32, SW_DECOM_BIG, SW_DECOM_FLOAT},
+        {96, 64, SW_DECOM_BIG, SW_DECOM_FLOAT},
+        {160, 64, SW_DECOM_LITTLE, SW_DECOM_FLOAT},
+        {227, 64, SW_DECOM_BIG, SW_DECOM_UINT}, /* nine octets */
+        {291, 62, SW_DECOM_BIG, SW_DECOM_INT},  /* nine octets */
+        {352, 32, SW_DECOM_LITTLE, SW_DECOM_FLOAT},
+        {5, 7, SW_DECOM_BIG, SW_DECOM_UINT}, /* overlaps, out of order */
+    };
+    const uint16_t n = (uint16_t)(sizeof(p) / sizeof(p[0]));
+
+    memcpy(g_params, p, sizeof(p));
+    ASSERT_EQ_INT(SW_OK, sw_decom_compile(&g_plan, 0x123, g_params, n, g_words, g_ops));
+    ASSERT_EQ_INT(48, (int)g_plan.min_len);
+    ASSERT_TRUE(g_plan.num_words < n);
+
+    make_frames(0x123);
+    ASSERT_EQ_INT(0, run_and_compare(n));
+
+    /* Other APIDs and short data fields give invalid, zero rows. */
+    g_frames[3].packet.ph.apid = 0x124u;
+    g_frames[70].packet.data_len = 47;
+    g_frames[149].packet.data_len = 12;
+    ASSERT_EQ_INT(0, run_and_compare(n));
+    return 0;
+}
+
+/* Random layouts against the bit-by-bit reference. */
+static int test_decom_random(void)
+{
+    for (unsigned round = 0; round < 40u; round++)
+    {
+        const uint16_t n = (uint16_t)(1u + rnd() % MAX_PARAMS);
+        for (unsigned i = 0; i < n; i++)
+        {
+            sw_decom_param_t *p = &g_params[i];
+            p->type = (uint8_t)(rnd() % 3u);
+            p->endian = (uint8_t)(rnd() % 2u);
+            if (p->type == SW_DECOM_FLOAT)
+                p->width = (uint8_t)(rnd() % 2u ? 32u : 64u);
+            else if (p->endian == SW_DECOM_LITTLE)
+                p->width = (uint8_t)(8u * (1u + rnd() % 8u));
+            else
+                p->width = (uint8_t)(1u + rnd() % 64u);
+
+            const uint32_t room = DATA_LEN * 8u - p->width;
+            p->bit_offset = rnd() % (room + 1u);
+            if (p->endian == SW_DECOM_LITTLE)
+                p->bit_offset &= ~7u;
+        }
+
+        ASSERT_EQ_INT(SW_OK, sw_decom_compile(&g_plan, 0x55, g_params, n, g_words, g_ops));
+        make_frames(0x55);
+        g_frames[rnd() % PACKETS].packet.data_len = (uint16_t)(g_plan.min_len - 1u);
+        ASSERT_EQ_INT(0, run_and_compare(n));
+    }
+    return 0;
+}
+
+test_result_t test_spacewire_decom_run_all(void)
+{
+    RUN_TEST(test_decom_compile);
+    RUN_TEST(test_decom_layout);
+    RUN_TEST(test_decom_random);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
@@ -0,0 +1,302 @@
+/**
+ * @file test_ds.c
+ * @brief Unit tests for the data-strobe character decoder.
+ */
+#include "cunit.h"
+#include "spacewire_ds.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define WORDS 256u
+#define SPB 3u
+#define MAX_EVENTS 512u
+
+typedef struct
+{
+    sw_ds_char_t chars[MAX_EVENTS];
+    size_t num_chars;
+    sw_result_t results[8];
+    sw_end_marker_t ends[8];
+    size_t lens[8];
+    uint16_t apids[8];
+    size_t num_packets;
+} ds_log_t;
+
+static uint64_t g_d[WORDS];
+static uint64_t g_s[WORDS];
+static uint8_t g_buf[64];
+static ds_log_t g_log;
+static int g_len; /* octets of each packet in the stream */
+
+static void on_char(void *ctx, const sw_ds_char_t *ch)
+{
+    ds_log_t *log = ctx;
+    if (log->num_chars < MAX_EVENTS)
+        log->chars[log->num_chars++] = *ch;
+}
+
+static void on_packet(void *ctx,
+                      const sw_packet_frame_t *pf,
+                      sw_result_t result,
+                      sw_ptp_status_t status,
+                      const uint8_t *pkt,
+                      size_t len,
+                      sw_end_marker_t end)
+{
+    ds_log_t *log = ctx;
+    (void)status;
+    (void)pkt;
+    if (log->num_packets < 8u)
+    {
+        log->results[log->num_packets] = result;
+        log->ends[log->num_packets] = end;
+        log->lens[log->num_packets] = len;
+        log->apids[log->num_packets] = result == SW_OK ? (uint16_t)pf->packet.ph.apid : 0;
+        log->num_packets++;
+    }
+}
+
+static size_t make_packet(uint8_t *buf, size_t cap, unsigned apid)
+{
+    static const uint8_t payload[6] = {1, 2, 3, 4, 5, 6};
+    sw_packet_frame_t pf;
+    const sw_packet_config_t config = {.path = NULL,
+                                       .path_len = 0,
+                                       .logical_addr = 0x40,
+                                       .user_app = 0};
+    sw_packet_init(&pf, &config);
+    pf.packet.ph.apid = apid & 0x7FFu;
+    pf.packet.data = payload;
+    pf.packet.data_len = sizeof(payload);
+    return sw_packet_encode(&pf, buf, cap);
+}
+
+static int start(sw_ds_decoder_t *dec, int chars, uint32_t disconnect)
+{
+    const sw_ds_config_t config = {.buf = g_buf,
+                                   .cap = sizeof(g_buf),
+                                   .disconnect_samples = disconnect,
+                                   .on_packet = on_packet,
+                                   .on_char = chars ? on_char : NULL,
+                                   .ctx = &g_log};
+    memset(&g_log, 0, sizeof(g_log));
+    ASSERT_EQ_INT(SW_OK, sw_ds_init(dec, &config));
+    return 0;
+}
+
+/* Idle link traffic, a packet, a time-code and an EEP-terminated packet. */
+static int encode_stream(sw_ds_encoder_t *enc, uint64_t *second_packet)
+{
+    uint8_t pkt[32];
+    const size_t len = make_packet(pkt, sizeof(pkt), 0x123);
+    ASSERT_TRUE(len > 10);
+    g_len = (int)len;
+
+    ASSERT_EQ_INT(SW_OK, sw_ds_encoder_init(enc, g_d, g_s, WORDS, SPB));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(enc, SW_DS_NULL, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(enc, SW_DS_NULL, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(enc, SW_DS_FCT, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_packet(enc, pkt, len, SW_END_EOP));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(enc, SW_DS_TIME_CODE, 0x5A));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(enc, SW_DS_NULL, 0));
+    if (second_packet)
+        *second_packet = enc->samples;
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_packet(enc, pkt, len, SW_END_EEP));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(enc, SW_DS_NULL, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_packet(enc, pkt, len, SW_END_EOP));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(enc, SW_DS_NULL, 0));
+    return 0;
+}
+
+static int test_ds_roundtrip(void)
+{
+    sw_ds_encoder_t enc;
+    sw_ds_decoder_t dec;
+    ASSERT_EQ_INT(0, encode_stream(&enc, NULL));
+    const size_t words = (size_t)(enc.samples + 63u) / 64u;
+
+    ASSERT_EQ_INT(0, start(&dec, 1, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_decode(&dec, g_d, g_s, words));
+
+    /* NULL, NULL, FCT, data, EOP, time-code, NULL, data, EEP, NULL, ... */
+    const int n = g_len;
+    ASSERT_EQ_INT(3 * n + 10, (int)g_log.num_chars);
+    ASSERT_EQ_INT(SW_DS_NULL, g_log.chars[0].type);
+    ASSERT_EQ_INT(0, (int)g_log.chars[0].sample);
+    ASSERT_EQ_INT(SW_DS_NULL, g_log.chars[1].type);
+    ASSERT_EQ_INT(8 * SPB, (int)g_log.chars[1].sample);
+    ASSERT_EQ_INT(SW_DS_FCT, g_log.chars[2].type);
+    ASSERT_EQ_INT(SW_DS_DATA, g_log.chars[3].type);
+    ASSERT_EQ_INT(0x40, g_log.chars[3].value);
+    ASSERT_EQ_INT(SW_DS_EOP, g_log.chars[3 + n].type);
+    ASSERT_EQ_INT(SW_DS_TIME_CODE, g_log.chars[4 + n].type);
+    ASSERT_EQ_INT(0x5A, g_log.chars[4 + n].value);
+    ASSERT_EQ_INT(SW_DS_EEP, g_log.chars[6 + 2 * n].type);
+
+    ASSERT_EQ_INT(3, (int)g_log.num_packets);
+    ASSERT_EQ_INT(SW_OK, g_log.results[0]);
+    ASSERT_EQ_INT(0x123, g_log.apids[0]);
+    ASSERT_EQ_INT(n, (int)g_log.lens[0]);
+    ASSERT_EQ_INT(SW_ERR, g_log.results[1]);
+    ASSERT_EQ_INT(SW_END_EEP, g_log.ends[1]);
+    ASSERT_EQ_INT(SW_OK, g_log.results[2]);
+
+    ASSERT_EQ_INT(3 * n, (int)dec.stats.data);
+    ASSERT_EQ_INT(2, (int)dec.stats.eops);
+    ASSERT_EQ_INT(1, (int)dec.stats.eeps);
+    ASSERT_EQ_INT(1, (int)dec.stats.fcts);
+    ASSERT_EQ_INT(5, (int)dec.stats.nulls);
+    ASSERT_EQ_INT(1, (int)dec.stats.time_codes);
+    ASSERT_EQ_INT(2, (int)dec.stats.packets_ok);
+    ASSERT_EQ_INT(0, (int)dec.stats.parity_errors);
+
+    /* The packet-only path, fed one word at a time, agrees. */
+    const sw_ds_stats_t full = dec.stats;
+    ASSERT_EQ_INT(0, start(&dec, 0, 0));
+    for (size_t w = 0; w < words; w++)
+        ASSERT_EQ_INT(SW_OK, sw_ds_decode(&dec, &g_d[w], &g_s[w], 1));
+    ASSERT_EQ_MEM(&full, &dec.stats, sizeof(full));
+    ASSERT_EQ_INT(0, (int)g_log.num_chars);
+    ASSERT_EQ_INT(3, (int)g_log.num_packets);
+    return 0;
+}
+
+/* Flip the value of bit @p bit from sample @p at: both lines change, so the
+ * clock (D xor S) stays intact. */
+static void flip_bit(uint64_t at, unsigned bit)
+{
+    for (uint64_t i = at + (uint64_t)bit * SPB; i < at + (uint64_t)(bit + 1u) * SPB; i++)
+    {
+        g_d[i / 64u] ^= 1ull << (i % 64u);
+        g_s[i / 64u] ^= 1ull << (i % 64u);
+    }
+}
+
+static int test_ds_errors(void)
+{
+    sw_ds_encoder_t enc;
+    sw_ds_decoder_t dec;
+    uint64_t at = 0;
+
+    /* A data bit of the second packet: the next character's parity fails,
+     * the packet ends in EEP and the decoder picks up at the next NULL. */
+    ASSERT_EQ_INT(0, encode_stream(&enc, &at));
+    flip_bit(at + 5u * 10u * SPB, 4);
+    ASSERT_EQ_INT(0, start(&dec, 0, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_decode(&dec, g_d, g_s, WORDS));
+    ASSERT_EQ_INT(1, (int)dec.stats.parity_errors);
+    ASSERT_EQ_INT(3, (int)g_log.num_packets);
+    ASSERT_EQ_INT(SW_END_EEP, g_log.ends[1]);
+    ASSERT_EQ_INT(6, (int)g_log.lens[1]);
+    ASSERT_EQ_INT(SW_OK, g_log.results[2]);
+
+    /* The NULL before it turned into ESC EOP: an escape error. */
+    ASSERT_EQ_INT(0, encode_stream(&enc, &at));
+    flip_bit(at - 4u * SPB, 3);
+    ASSERT_EQ_INT(0, start(&dec, 1, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_decode(&dec, g_d, g_s, WORDS));
+    ASSERT_EQ_INT(1, (int)dec.stats.escape_errors);
+    ASSERT_EQ_INT(SW_DS_ESC_ERROR, g_log.chars[5 + g_len].type);
+    ASSERT_EQ_INT((int)(at - 8u * SPB), (int)g_log.chars[5 + g_len].sample);
+    ASSERT_EQ_INT(2, (int)dec.stats.packets_ok);
+
+    /* The lines stop mid-packet: a disconnect ends it with an EEP. */
+    uint8_t pkt[32];
+    const size_t len = make_packet(pkt, sizeof(pkt), 7);
+    ASSERT_EQ_INT(SW_OK, sw_ds_encoder_init(&enc, g_d, g_s, WORDS, SPB));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(&enc, SW_DS_NULL, 0));
+    for (size_t i = 0; i < 10; i++)
+        ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(&enc, SW_DS_DATA, pkt[i]));
+    const uint64_t gap = enc.samples;
+    if (enc.d_level)
+        g_d[gap / 64u] |= ~0ull << (gap % 64u);
+    if (enc.s_level)
+        g_s[gap / 64u] |= ~0ull << (gap % 64u);
+    for (size_t w = gap / 64u + 1u; w < gap / 64u + 4u; w++)
+    {
+        g_d[w] = enc.d_level ? ~0ull : 0;
+        g_s[w] = enc.s_level ? ~0ull : 0;
+    }
+    enc.samples = (gap / 64u + 4u) * 64u;
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(&enc, SW_DS_NULL, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_packet(&enc, pkt, len, SW_END_EOP));
+
+    ASSERT_EQ_INT(0, start(&dec, 1, 128));
+    ASSERT_EQ_INT(SW_OK, sw_ds_decode(&dec, g_d, g_s, (size_t)(enc.samples + 63u) / 64u));
+    ASSERT_EQ_INT(1, (int)dec.stats.disconnects);
+    ASSERT_EQ_INT(SW_DS_DISCONNECT, g_log.chars[11].type);
+    ASSERT_EQ_INT((int)(gap - SPB + 1u), (int)g_log.chars[11].sample);
+    ASSERT_EQ_INT(2, (int)g_log.num_packets);
+    ASSERT_EQ_INT(SW_END_EEP, g_log.ends[0]);
+    ASSERT_EQ_INT(10, (int)g_log.lens[0]);
+    ASSERT_EQ_INT(SW_OK, g_log.results[1]);
+
+    /* A packet longer than the buffer is dropped. */
+    const sw_ds_config_t small = {.buf = g_buf, .cap = 8};
+    ASSERT_EQ_INT(SW_OK, sw_ds_init(&dec, &small));
+    ASSERT_EQ_INT(SW_OK, sw_ds_decode(&dec, g_d, g_s, (size_t)(enc.samples + 63u) / 64u));
+    ASSERT_EQ_INT(1, (int)dec.stats.packets_oversize);
+    ASSERT_EQ_INT(0, (int)dec.stats.packets);
+    return 0;
+}
+
+static int test_ds_pack(void)
+{
+    static uint8_t samples[WORDS * 64u];
+    static uint64_t d[WORDS];
+    static uint64_t s[WORDS];
+    sw_ds_encoder_t enc;
+
+    ASSERT_EQ_INT(0, encode_stream(&enc, NULL));
+    for (size_t i = 0; i < sizeof(samples); i++)
+    {
+        const unsigned dv = (unsigned)(g_d[i / 64u] >> (i % 64u)) & 1u;
+        const unsigned sv = (unsigned)(g_s[i / 64u] >> (i % 64u)) & 1u;
+        samples[i] = (uint8_t)((i * 37u) & 0x9Bu) | (uint8_t)(dv << 2) | (uint8_t)(sv << 5);
+    }
+
+    ASSERT_EQ_INT(SW_OK, sw_ds_pack(samples, sizeof(samples), 2, 5, d, s));
+    ASSERT_EQ_MEM(g_d, d, sizeof(d));
+    ASSERT_EQ_MEM(g_s, s, sizeof(s));
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_pack(samples, 63, 2, 5, d, s));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_pack(samples, 64, 8, 5, d, s));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_pack(NULL, 64, 2, 5, d, s));
+    return 0;
+}
+
+static int test_ds_params(void)
+{
+    sw_ds_decoder_t dec;
+    sw_ds_encoder_t enc;
+    sw_ds_config_t config = {.buf = g_buf, .cap = sizeof(g_buf)};
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_init(NULL, &config));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_init(&dec, NULL));
+    config.disconnect_samples = 10;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_init(&dec, &config));
+    config.disconnect_samples = 0;
+    config.cap = 0;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_init(&dec, &config));
+    config.cap = sizeof(g_buf);
+    ASSERT_EQ_INT(SW_OK, sw_ds_init(&dec, &config));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_decode(&dec, NULL, g_s, 1));
+    ASSERT_EQ_INT(SW_OK, sw_ds_decode(&dec, NULL, NULL, 0));
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_encoder_init(&enc, g_d, g_s, 1, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encoder_init(&enc, g_d, g_s, 1, 6));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ds_encode_char(&enc, SW_DS_PARITY_ERROR, 0));
+    ASSERT_EQ_INT(SW_OK, sw_ds_encode_char(&enc, SW_DS_DATA, 0x55)); /* 60 samples */
+    ASSERT_EQ_INT(SW_ERR, sw_ds_encode_char(&enc, SW_DS_FCT, 0));    /* 84 > 64 */
+    return 0;
+}
+
+test_result_t test_spacewire_ds_run_all(void)
+{
+    RUN_TEST(test_ds_roundtrip);
+    RUN_TEST(test_ds_errors);
+    RUN_TEST(test_ds_pack);
+    RUN_TEST(test_ds_params);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
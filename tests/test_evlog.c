@@ -0,0 +1,173 @@
+/**
+ * @file test_evlog.c
+ * @brief Unit tests for the flight-recorder event log.
+ */
+#include "cunit.h"
+#include "spacewire.h"
+#include "spacewire_evlog.h"
+#include "spacewire_packet.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+static int test_evlog_ring_init(void)
+{
+    sw_evlog_ring_t ring;
+    sw_ev_record_t records[8];
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_evlog_ring_init(NULL, records, 8, 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_evlog_ring_init(&ring, NULL, 8, 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_evlog_ring_init(&ring, records, 6, 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_evlog_ring_init(&ring, records, 1, 1));
+    ASSERT_EQ_INT(SW_OK, sw_evlog_ring_init(&ring, records, 8, 7));
+    ASSERT_EQ_INT(7, (int)ring.mask);
+    ASSERT_EQ_INT(0, (int)ring.head);
+
+    /* Without an attached ring, recording is a no-op. */
+    sw_evlog_attach(NULL);
+    sw_evlog_record(SW_EV_TIMEOUT, NULL, 1, 2);
+    ASSERT_EQ_INT(0, (int)ring.head);
+    ASSERT_TRUE(sw_evlog_current() == NULL);
+    return 0;
+}
+
+/* The library itself logs link-state changes, invalid addresses and EEPs. */
+static int test_evlog_library_hooks(void)
+{
+    sw_evlog_ring_t ring;
+    sw_ev_record_t records[16];
+    ASSERT_EQ_INT(SW_OK, sw_evlog_ring_init(&ring, records, 16, 1));
+    sw_evlog_attach(&ring);
+    ASSERT_TRUE(sw_evlog_current() == &ring);
+
+    const sw_link_config_t config = {.bit_rate = 100000000, .disconnect_timeout = 850};
+    sw_link_layer_t link;
+    sw_link_init(&link, &config);
+    sw_link_set_state(&link, SW_LINK_CONNECTED);
+    sw_link_set_state(&link, SW_LINK_CONNECTED); /* no change, not logged */
+
+    sw_router_t router;
+    sw_router_init(&router, 4);
+    const uint8_t bad[2] = {0x77, 0x00};
+    uint8_t port = 0;
+    uint8_t del = 0;
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD, sw_router_route(&router, bad, sizeof(bad), &port, &del));
+
+    const uint8_t payload[2] = {1, 2};
+    uint8_t buf[32];
+    const size_t n = sw_packet_create(0x40, 0, 0x10, payload, sizeof(payload), buf, sizeof(buf));
+    sw_packet_frame_t pf;
+    ASSERT_EQ_INT(SW_ERR, sw_packet_decode(&pf, buf, n, SW_END_EEP, NULL));
+
+    sw_evlog_record(SW_EV_TIMEOUT, &link, 850, 3);
+    sw_evlog_attach(NULL);
+
+    sw_ev_record_t out[16];
+    ASSERT_EQ_INT(4, (int)sw_evlog_snapshot(&ring, out, 16));
+
+    ASSERT_EQ_INT(SW_EV_LINK_STATE, out[0].type);
+    ASSERT_EQ_INT(SW_LINK_UNINITIALIZED, out[0].aux);
+    ASSERT_EQ_INT(SW_LINK_CONNECTED, out[0].arg);
+    ASSERT_TRUE(out[0].obj == (uint32_t)(uintptr_t)&link);
+
+    ASSERT_EQ_INT(SW_EV_INVALID_ADDRESS, out[1].type);
+    ASSERT_EQ_INT(0x77, out[1].arg);
+    ASSERT_TRUE(out[1].obj == (uint32_t)(uintptr_t)&router);
+
+    ASSERT_EQ_INT(SW_EV_EEP, out[2].type);
+    ASSERT_EQ_INT((int)n, out[2].arg);
+
+    ASSERT_EQ_INT(SW_EV_TIMEOUT, out[3].type);
+    ASSERT_EQ_INT(850, out[3].arg);
+    ASSERT_EQ_INT(3, out[3].aux);
+
+    for (int i = 1; i < 4; i++)
+        ASSERT_TRUE(out[i].timestamp >= out[i - 1].timestamp);
+    return 0;
+}
+
+/* A full ring of N keeps the N - 1 most recent records, oldest first. */
+static int test_evlog_wraparound(void)
+{
+    sw_evlog_ring_t ring;
+    sw_ev_record_t records[4];
+    ASSERT_EQ_INT(SW_OK, sw_evlog_ring_init(&ring, records, 4, 2));
+    sw_evlog_attach(&ring);
+
+    for (uint16_t i = 0; i < 10; i++)
+        sw_evlog_record(SW_EV_USER, NULL, i, 0);
+    sw_evlog_attach(NULL);
+
+    sw_ev_record_t out[8];
+    ASSERT_EQ_INT(3, (int)sw_evlog_snapshot(&ring, out, 8));
+    for (int i = 0; i < 3; i++)
+        ASSERT_EQ_INT(7 + i, out[i].arg);
+
+    /* A smaller destination receives the newest records. */
+    ASSERT_EQ_INT(2, (int)sw_evlog_snapshot(&ring, out, 2));
+    ASSERT_EQ_INT(8, out[0].arg);
+    ASSERT_EQ_INT(9, out[1].arg);
+
+    ASSERT_EQ_INT(0, (int)sw_evlog_snapshot(NULL, out, 8));
+    return 0;
+}
+
+typedef struct
+{
+    uint8_t data[512];
+    size_t len;
+} sink_t;
+
+static int sink_write(void *ctx, const void *data, size_t len)
+{
+    sink_t *s = (sink_t *)ctx;
+    if (s->len + len > sizeof(s->data))
+        return -1;
+    memcpy(&s->data[s->len], data, len);
+    s->len += len;
+    return 0;
+}
+
+/* The dump walks every registered ring and writes header + records. */
+static int test_evlog_dump(void)
+{
+    static sw_evlog_ring_t ring;
+    static sw_ev_record_t records[4];
+    ASSERT_EQ_INT(SW_OK, sw_evlog_ring_init(&ring, records, 4, 42));
+    ASSERT_EQ_INT(SW_OK, sw_evlog_register(&ring));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_evlog_register(&ring)); /* already listed */
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_evlog_register(NULL));
+
+    sw_evlog_attach(&ring);
+    sw_evlog_record(SW_EV_USER, NULL, 0xBEEF, 1);
+    sw_evlog_record(SW_EV_USER, NULL, 0xCAFE, 2);
+    sw_evlog_attach(NULL);
+
+    sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_evlog_dump(NULL, &sink));
+    ASSERT_EQ_INT(SW_OK, sw_evlog_dump(sink_write, &sink));
+    ASSERT_EQ_INT((int)(sizeof(sw_evlog_dump_header_t) + 2 * sizeof(sw_ev_record_t)),
+                  (int)sink.len);
+
+    sw_evlog_dump_header_t hdr;
+    memcpy(&hdr, sink.data, sizeof(hdr));
+    ASSERT_EQ_INT((int)SW_EVLOG_DUMP_MAGIC, (int)hdr.magic);
+    ASSERT_EQ_INT(42, (int)hdr.thread_id);
+    ASSERT_EQ_INT(2, (int)hdr.count);
+
+    sw_ev_record_t rec;
+    memcpy(&rec, &sink.data[sizeof(hdr) + sizeof(rec)], sizeof(rec));
+    ASSERT_EQ_INT(0xCAFE, rec.arg);
+    ASSERT_EQ_INT(2, rec.aux);
+    return 0;
+}
+
+test_result_t test_spacewire_evlog_run_all(void)
+{
+    RUN_TEST(test_evlog_ring_init);
+    RUN_TEST(test_evlog_library_hooks);
+    RUN_TEST(test_evlog_wraparound);
+    RUN_TEST(test_evlog_dump);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
@@ -0,0 +1,102 @@
+/**
+ * @file test_fixed.c
+ * @brief Unit tests for the compile-time specialised command encoders.
+ */
+#include "cunit.h"
+#include "spacewire_fixed.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+SW_DEFINE_FIXED_COMMAND(cmd_small, 0x42, 0, SP_PACKET_TYPE_TC, 1, 0x123, 3, 1)
+SW_DEFINE_FIXED_COMMAND(cmd_mode, 0xFE, 7, SP_PACKET_TYPE_TC, 0, 0x7FF, 3, 12)
+SW_DEFINE_FIXED_COMMAND(cmd_table, 0x20, 0xFF, SP_PACKET_TYPE_TM, 1, 0x001, 0, 300)
+
+static uint8_t g_payload[300];
+
+/** Encode the same command with sw_packet_encode(). */
+static size_t generic(uint8_t *buf,
+                      uint8_t addr,
+                      uint8_t user_app,
+                      unsigned type,
+                      unsigned sec_hdr,
+                      unsigned apid,
+                      unsigned seq_flags,
+                      uint16_t seq_count,
+                      uint16_t len)
+{
+    sw_packet_frame_t pf;
+    const sw_packet_config_t config = {.path = NULL,
+                                       .path_len = 0,
+                                       .logical_addr = addr,
+                                       .user_app = user_app};
+    sw_packet_init(&pf, &config);
+    pf.packet.ph.type = type & 1u;
+    pf.packet.ph.sec_hdr_flag = sec_hdr & 1u;
+    pf.packet.ph.apid = apid & 0x7FFu;
+    pf.packet.ph.seq_flags = seq_flags & 3u;
+    pf.packet.ph.seq_count = seq_count & 0x3FFFu;
+    pf.packet.data = g_payload;
+    pf.packet.data_len = len;
+    return sw_packet_encode(&pf, buf, 400);
+}
+
+static int test_fixed_matches_generic(void)
+{
+    static const uint16_t seqs[] = {0, 1, 0x100, 0x3FFF, 0x4005, 0xFFFF};
+    uint8_t want[400];
+    uint8_t got[400];
+
+    for (size_t i = 0; i < sizeof(g_payload); i++)
+        g_payload[i] = (uint8_t)(i * 7u + 1u);
+
+    ASSERT_EQ_INT(11, cmd_small_LEN);
+    ASSERT_EQ_INT(22, cmd_mode_LEN);
+    ASSERT_EQ_INT(310, cmd_table_LEN);
+
+    for (size_t s = 0; s < sizeof(seqs) / sizeof(seqs[0]); s++)
+    {
+        const uint16_t seq = seqs[s];
+
+        ASSERT_EQ_INT(cmd_small_LEN, (int)generic(want, 0x42, 0, 1, 1, 0x123, 3, seq, 1));
+        ASSERT_EQ_INT(cmd_small_LEN, (int)cmd_small_encode(got, seq, g_payload));
+        ASSERT_EQ_MEM(want, got, cmd_small_LEN);
+
+        ASSERT_EQ_INT(cmd_mode_LEN, (int)generic(want, 0xFE, 7, 1, 0, 0x7FF, 3, seq, 12));
+        ASSERT_EQ_INT(cmd_mode_LEN, (int)cmd_mode_encode(got, seq, g_payload));
+        ASSERT_EQ_MEM(want, got, cmd_mode_LEN);
+
+        ASSERT_EQ_INT(cmd_table_LEN, (int)generic(want, 0x20, 0xFF, 0, 1, 0x001, 0, seq, 300));
+        ASSERT_EQ_INT(cmd_table_LEN, (int)cmd_table_encode(got, seq, g_payload));
+        ASSERT_EQ_MEM(want, got, cmd_table_LEN);
+    }
+    return 0;
+}
+
+/* The output decodes like any other packet; nothing past the length is touched. */
+static int test_fixed_decode(void)
+{
+    uint8_t buf[cmd_mode_LEN + 4];
+    sw_packet_frame_t pf;
+    sw_ptp_status_t status;
+
+    memset(buf, 0xA5, sizeof(buf));
+    ASSERT_EQ_INT(cmd_mode_LEN, (int)cmd_mode_encode(buf, 0x1234, g_payload));
+    ASSERT_EQ_INT(0xA5, buf[cmd_mode_LEN]);
+    ASSERT_EQ_INT(SW_OK, sw_packet_decode(&pf, buf, cmd_mode_LEN, SW_END_EOP, &status));
+    ASSERT_EQ_INT(SW_PTP_STATUS_OK, status);
+    ASSERT_EQ_INT(0xFE, pf.logical_addr);
+    ASSERT_EQ_INT(7, pf.user_app);
+    ASSERT_EQ_INT(0x7FF, (int)pf.packet.ph.apid);
+    ASSERT_EQ_INT(0x1234, (int)pf.packet.ph.seq_count);
+    ASSERT_EQ_INT(12, pf.packet.data_len);
+    ASSERT_EQ_MEM(g_payload, pf.packet.data, 12);
+    return 0;
+}
+
+test_result_t test_spacewire_fixed_run_all(void)
+{
+    RUN_TEST(test_fixed_matches_generic);
+    RUN_TEST(test_fixed_decode);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
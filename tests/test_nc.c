@@ -0,0 +1,222 @@
+/**
+ * @file test_nc.c
+ * @brief Unit tests for the worst-case delay and backlog analysis.
+ */
+#include "cunit.h"
+#include "spacewire_nc.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define MAX_NODES 4u
+#define MAX_LINKS 4u
+#define MAX_HOPS 16u
+
+typedef struct
+{
+    sw_net_t net;
+    sw_net_node_t nodes[MAX_NODES];
+    sw_net_link_t links[MAX_LINKS];
+    sw_nc_hop_t hops[MAX_HOPS];
+    uint32_t out_head[2u * MAX_LINKS];
+    sw_nc_source_t sources[MAX_NODES];
+    sw_nc_work_t work;
+} nc_fixture_t;
+
+static void fixture_work(nc_fixture_t *f, size_t max_hops)
+{
+    f->work.hops = f->hops;
+    f->work.max_hops = max_hops;
+    f->work.out_head = f->out_head;
+    f->work.sources = f->sources;
+}
+
+/*
+ * Terminals 0x40 (n0) and 0x41 (n1) both send to 0x42 (n3) through router
+ * n2, whose port 3 they contend for; every link 100 Mbit/s, 100 ns:
+ *
+ *   n0 -1-1- n2 -3-1- n3
+ *            2
+ *            |
+ *   n1 -1----+
+ */
+static int build_merge(nc_fixture_t *f)
+{
+    ASSERT_EQ_INT(SW_OK, sw_net_init(&f->net, f->nodes, MAX_NODES, f->links, MAX_LINKS));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 2, 0x40, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 2, 0x41, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 4, 0, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 2, 0x42, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(&f->net, 0, 1, 2, 1, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(&f->net, 1, 1, 2, 2, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(&f->net, 2, 3, 3, 1, 100000000, 100, NULL));
+
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&f->nodes[0].router, 0x42, 1, 0));
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&f->nodes[1].router, 0x42, 1, 0));
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&f->nodes[2].router, 0x42, 3, 0));
+    fixture_work(f, MAX_HOPS);
+    return 0;
+}
+
+static int test_nc_merge(void)
+{
+    static nc_fixture_t f;
+    ASSERT_EQ_INT(0, build_merge(&f));
+
+    /* 100 octets take 10 us at 100 Mbit/s, 50 octets 5 us. */
+    sw_nc_flow_t flows[2] = {
+        {.src = 0, .dst_addr = 0x42, .max_len = 100, .burst = 1000, .rate = 1000000},
+        {.src = 1, .dst_addr = 0x42, .max_len = 50, .burst = 200, .rate = 1000000},
+    };
+    sw_nc_bound_t b[2];
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, flows, 2, &f.work, b));
+
+    /* Last hop: latency plus the packet. First hop: latency, the wait for the
+     * other flow's last hop, then the last hop itself. */
+    ASSERT_EQ_INT(SW_NC_BOUNDED, b[0].status);
+    ASSERT_EQ_INT(2, b[0].num_hops);
+    ASSERT_EQ_INT(10100, (int)f.hops[b[0].first_hop + 1u].occupancy_ns);
+    ASSERT_EQ_INT(5100, (int)f.hops[b[1].first_hop + 1u].occupancy_ns);
+    ASSERT_EQ_INT(100 + 5100 + 10100, (int)b[0].packet_ns);
+    ASSERT_EQ_INT(100 + 10100 + 5100, (int)b[1].packet_ns);
+
+    /* T + σ / R with R = max_len / D; σ + ρ T. */
+    ASSERT_EQ_INT(15300 + 1000 * 15300 / 100, (int)b[0].delay_ns);
+    ASSERT_EQ_INT(15300 + 200 * 15300 / 50, (int)b[1].delay_ns);
+    ASSERT_EQ_INT(1016, (int)b[0].backlog);
+    ASSERT_EQ_INT(216, (int)b[1].backlog);
+
+    /* Two flows from one source share its queue and its bound, but do not
+     * wait for each other at the router. */
+    sw_nc_flow_t shared[2] = {flows[0], flows[0]};
+    shared[1].max_len = 50;
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, shared, 2, &f.work, b));
+    ASSERT_EQ_INT(10200, (int)b[0].packet_ns);
+    ASSERT_EQ_INT(5200, (int)b[1].packet_ns);
+    ASSERT_EQ_INT((int)b[0].delay_ns, (int)b[1].delay_ns);
+    ASSERT_EQ_INT(10200 + 2000 * 5200 / 50, (int)b[0].delay_ns);
+
+    /* Above the guaranteed 100 octets per 15.3 us the source overloads. */
+    flows[0].rate = 7000000;
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, flows, 2, &f.work, b));
+    ASSERT_EQ_INT(SW_NC_OVERLOAD, b[0].status);
+    ASSERT_TRUE(b[0].delay_ns == SW_NC_UNBOUNDED && b[0].backlog == SW_NC_UNBOUNDED);
+    ASSERT_EQ_INT(SW_NC_BOUNDED, b[1].status);
+    return 0;
+}
+
+static int test_nc_slow_link(void)
+{
+    static nc_fixture_t f;
+    ASSERT_EQ_INT(0, build_merge(&f));
+    f.links[2].bit_rate = 10000000;
+
+    /* The tail leaves the first link at the pace of the 10 Mbit/s one. */
+    const sw_nc_flow_t flow = {.src = 0, .dst_addr = 0x42, .max_len = 100, .burst = 100};
+    sw_nc_bound_t b;
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    ASSERT_EQ_INT(100000, (int)f.hops[0].tx_ns);
+    ASSERT_EQ_INT(100 + 100 + 100000, (int)b.packet_ns);
+    ASSERT_EQ_INT(2 * 100200, (int)b.delay_ns);
+    return 0;
+}
+
+/*
+ * Four routers in a ring, each owning an address; every node sends two hops
+ * clockwise, so each flow's first port waits on the next flow's second.
+ */
+static int test_nc_deadlock(void)
+{
+    static nc_fixture_t f;
+    ASSERT_EQ_INT(SW_OK, sw_net_init(&f.net, f.nodes, MAX_NODES, f.links, MAX_LINKS));
+    for (uint8_t n = 0; n < 4; n++)
+        ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f.net, 3, (uint8_t)(0x40 + n), NULL));
+    for (uint16_t n = 0; n < 4; n++)
+    {
+        const uint16_t next = (uint16_t)((n + 1u) % 4u);
+        const uint8_t dst = (uint8_t)(0x40 + (n + 2u) % 4u);
+        ASSERT_EQ_INT(SW_OK, sw_net_connect(&f.net, n, 2, next, 1, 100000000, 0, NULL));
+        ASSERT_EQ_INT(SW_OK, sw_router_add_route(&f.nodes[n].router, dst, 2, 0));
+        ASSERT_EQ_INT(SW_OK, sw_router_add_route(&f.nodes[next].router, dst, 2, 0));
+    }
+    fixture_work(&f, MAX_HOPS);
+
+    sw_nc_flow_t flows[5];
+    for (uint16_t n = 0; n < 4; n++)
+    {
+        flows[n] = (sw_nc_flow_t){
+            .src = n, .dst_addr = (uint8_t)(0x40 + (n + 2u) % 4u), .max_len = 64, .burst = 64};
+    }
+    sw_nc_bound_t b[5];
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, flows, 4, &f.work, b));
+    for (unsigned n = 0; n < 4; n++)
+    {
+        ASSERT_EQ_INT(SW_NC_DEADLOCK, b[n].status);
+        ASSERT_TRUE(b[n].delay_ns == SW_NC_UNBOUNDED);
+    }
+
+    /* Three of the four flows leave the ring acyclic. */
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, flows, 3, &f.work, b));
+    for (unsigned n = 0; n < 3; n++)
+        ASSERT_EQ_INT(SW_NC_BOUNDED, b[n].status);
+
+    /* n0 has no route to 0x43. */
+    flows[4] = (sw_nc_flow_t){.src = 0, .dst_addr = 0x43, .max_len = 64};
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, &flows[4], 1, &f.work, b));
+    ASSERT_EQ_INT(SW_NC_NO_ROUTE, b[0].status);
+    return 0;
+}
+
+static int test_nc_errors(void)
+{
+    static nc_fixture_t f;
+    ASSERT_EQ_INT(0, build_merge(&f));
+
+    sw_nc_flow_t flow = {.src = 0, .dst_addr = 0x42, .max_len = 100, .burst = 100};
+    sw_nc_bound_t b;
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_nc_analyse(NULL, &flow, 1, &f.work, &b));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_nc_analyse(&f.net, &flow, 1, NULL, &b));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_nc_analyse(&f.net, &flow, 1, &f.work, NULL));
+    flow.src = 4;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    flow.src = 0;
+    flow.max_len = 0;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    flow.max_len = 100;
+
+    /* Not enough hop storage. */
+    fixture_work(&f, 1);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    fixture_work(&f, MAX_HOPS);
+
+    /* Unknown address, the source's own address, a link down, no route. */
+    flow.dst_addr = 0x50;
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    ASSERT_EQ_INT(SW_NC_NO_ROUTE, b.status);
+    flow.dst_addr = 0x40;
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    ASSERT_EQ_INT(SW_NC_NO_ROUTE, b.status);
+    flow.dst_addr = 0x42;
+    f.links[2].up = 0;
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    ASSERT_EQ_INT(SW_NC_NO_ROUTE, b.status);
+    f.links[2].up = 1;
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&f.nodes[2].router, 0x42, 1, 0));
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    ASSERT_EQ_INT(SW_NC_NO_ROUTE, b.status); /* a loop between n0 and n2 */
+    ASSERT_EQ_INT(SW_OK, sw_router_remove_route(&f.nodes[2].router, 0x42));
+    ASSERT_EQ_INT(SW_OK, sw_nc_analyse(&f.net, &flow, 1, &f.work, &b));
+    ASSERT_EQ_INT(SW_NC_NO_ROUTE, b.status);
+    ASSERT_TRUE(b.delay_ns == SW_NC_UNBOUNDED);
+    return 0;
+}
+
+test_result_t test_spacewire_nc_run_all(void)
+{
+    RUN_TEST(test_nc_merge);
+    RUN_TEST(test_nc_slow_link);
+    RUN_TEST(test_nc_deadlock);
+    RUN_TEST(test_nc_errors);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
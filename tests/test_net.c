@@ -0,0 +1,293 @@
+/**
+ * @file test_net.c
+ * @brief Unit tests for the network model and shortest-path routing.
+ */
+#include "cunit.h"
+#include "spacewire_net.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define NODES 5u
+
+/*
+ * Terminal 0x40 (n0) and terminal 0x41 (n4) joined by two paths:
+ *
+ *   n0 -1-1- n1 -2-1- n2 -2-1- n4
+ *             3       3
+ *             |       |
+ *             1- n3 -2
+ */
+static int build_diamond(sw_net_t *net, sw_net_node_t *nodes, sw_net_link_t *links)
+{
+    ASSERT_EQ_INT(SW_OK, sw_net_init(net, nodes, NODES, links, 8));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(net, 2, 0x40, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(net, 4, 0, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(net, 4, 0, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(net, 3, 0, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(net, 2, 0x41, NULL));
+
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(net, 0, 1, 1, 1, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(net, 1, 2, 2, 1, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(net, 1, 3, 3, 1, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(net, 3, 2, 2, 3, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(net, 2, 2, 4, 1, 100000000, 100, NULL));
+    return 0;
+}
+
+static int test_net_build(void)
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[8];
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_net_init(NULL, nodes, NODES, links, 8));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_net_init(&net, nodes, 0, links, 8));
+    ASSERT_EQ_INT(0, build_diamond(&net, nodes, links));
+    ASSERT_EQ_INT(5, net.num_nodes);
+    ASSERT_EQ_INT(5, net.num_links);
+    ASSERT_EQ_INT(4, net.addr_node[0x41]);
+
+    /* Full, duplicate or invalid address, busy or missing port. */
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_net_add_node(&net, 2, 0, NULL));
+    net.num_nodes--;
+    ASSERT_EQ_INT(SW_WRONG_ADDRESS, sw_net_add_node(&net, 2, 0x40, NULL));
+    ASSERT_EQ_INT(SW_WRONG_ADDRESS, sw_net_add_node(&net, 2, 0x10, NULL));
+    net.num_nodes++;
+    ASSERT_EQ_INT(SW_WRONG_PORT, sw_net_connect(&net, 0, 1, 3, 1, 1000, 0, NULL));
+    ASSERT_EQ_INT(SW_WRONG_PORT, sw_net_connect(&net, 3, 0, 4, 1, 1000, 0, NULL));
+    ASSERT_EQ_INT(SW_WRONG_PORT, sw_net_connect(&net, 3, 5, 2, 1, 1000, 0, NULL));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_net_connect(&net, 3, 2, 3, 1, 1000, 0, NULL));
+
+    uint8_t peer_port = 0;
+    ASSERT_EQ_INT(2, sw_net_peer(&net, 3, 2, &peer_port));
+    ASSERT_EQ_INT(3, peer_port);
+    ASSERT_EQ_INT(1, sw_net_peer(&net, 2, 1, &peer_port));
+    ASSERT_EQ_INT(2, peer_port);
+    ASSERT_EQ_INT(SW_NET_NONE, sw_net_peer(&net, 0, 0, NULL));
+
+    /* A clone is independent of the original. */
+    sw_net_t copy;
+    sw_net_node_t copy_nodes[NODES];
+    sw_net_link_t copy_links[8];
+    ASSERT_EQ_INT(SW_OK, sw_net_clone(&copy, copy_nodes, copy_links, &net));
+    copy.links[0].up = 0;
+    ASSERT_EQ_INT(1, net.links[0].up);
+    ASSERT_EQ_INT(4, copy.addr_node[0x41]);
+    return 0;
+}
+
+static int test_net_routes(void)
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[8];
+    ASSERT_EQ_INT(0, build_diamond(&net, nodes, links));
+
+    uint64_t dist[NODES];
+    uint16_t heap[NODES];
+    uint16_t pos[NODES];
+    const sw_net_work_t work = {.dist = dist, .heap = heap, .pos = pos};
+    uint8_t table[NODES * SW_ROUTE_TABLE_SIZE];
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_net_compute_routes(&net, NULL, table));
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&net, &work, table));
+
+    static const uint8_t to_41[NODES] = {1, 2, 2, 2, SW_NET_NO_ROUTE};
+    static const uint8_t to_40[NODES] = {SW_NET_NO_ROUTE, 1, 1, 1, 1};
+    for (unsigned n = 0; n < NODES; n++)
+    {
+        ASSERT_EQ_INT(to_41[n], table[n * SW_ROUTE_TABLE_SIZE + 0x41]);
+        ASSERT_EQ_INT(to_40[n], table[n * SW_ROUTE_TABLE_SIZE + 0x40]);
+        ASSERT_EQ_INT(SW_NET_NO_ROUTE, table[n * SW_ROUTE_TABLE_SIZE + 0x42]);
+    }
+
+    ASSERT_EQ_INT(SW_OK, sw_net_install_routes(&net, table));
+    uint8_t port = 0;
+    uint8_t del = 0;
+    const uint8_t pkt[2] = {0x41, 0};
+    ASSERT_EQ_INT(SW_ROUTE_OK, sw_router_route(&nodes[1].router, pkt, sizeof(pkt), &port, &del));
+    ASSERT_EQ_INT(2, port);
+    ASSERT_EQ_INT(0, del);
+
+    /* n1-n2 down: traffic goes round through n3. */
+    links[1].up = 0;
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&net, &work, table));
+    ASSERT_EQ_INT(3, table[1 * SW_ROUTE_TABLE_SIZE + 0x41]);
+    ASSERT_EQ_INT(3, table[2 * SW_ROUTE_TABLE_SIZE + 0x40]);
+    ASSERT_EQ_INT(SW_OK, sw_net_install_routes(&net, table));
+    ASSERT_EQ_INT(SW_ROUTE_OK, sw_router_route(&nodes[1].router, pkt, sizeof(pkt), &port, &del));
+    ASSERT_EQ_INT(3, port);
+
+    /* Equal costs: the lowest port wins. */
+    links[1].up = 1;
+    links[1].cost = 2;
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&net, &work, table));
+    ASSERT_EQ_INT(2, table[1 * SW_ROUTE_TABLE_SIZE + 0x41]);
+    ASSERT_EQ_INT(1, table[2 * SW_ROUTE_TABLE_SIZE + 0x40]);
+
+    /* Cutting n0 off removes its address everywhere. */
+    links[0].up = 0;
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&net, &work, table));
+    ASSERT_EQ_INT(SW_OK, sw_net_install_routes(&net, table));
+    for (unsigned n = 0; n < NODES; n++)
+        ASSERT_EQ_INT(SW_NET_NO_ROUTE, table[n * SW_ROUTE_TABLE_SIZE + 0x40]);
+    ASSERT_TRUE(sw_router_get_route(&nodes[2].router, 0x40) == NULL);
+    return 0;
+}
+
+static int test_net_incremental(void)
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[8];
+    ASSERT_EQ_INT(0, build_diamond(&net, nodes, links));
+
+    static uint64_t dist[SW_NET_NUM_ADDRS * NODES];
+    uint8_t table[NODES * SW_ROUTE_TABLE_SIZE];
+    uint16_t heap[NODES];
+    uint16_t pos[NODES];
+    uint16_t list[NODES];
+    uint8_t mark[NODES];
+    const sw_net_work_t work = {.heap = heap, .pos = pos, .list = list, .mark = mark};
+
+    sw_net_spf_t spf;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_net_spf_init(&spf, &net, dist, table, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_spf_init(&spf, &net, dist, table, &work));
+    ASSERT_EQ_INT(SW_OK, sw_net_install_routes(&net, table));
+    ASSERT_EQ_INT(2, table[1 * SW_ROUTE_TABLE_SIZE + 0x41]);
+
+    /* n1-n2 down: exactly n1 -> 0x41 and n2 -> 0x40 change, by router. */
+    sw_net_route_change_t changes[8];
+    size_t n = 0;
+    ASSERT_EQ_INT(SW_OK, sw_net_spf_set_link(&spf, &net, 1, 0, 1, changes, 8, &n));
+    ASSERT_EQ_INT(2, (int)n);
+    ASSERT_EQ_INT(1, changes[0].node);
+    ASSERT_EQ_INT(0x41, changes[0].addr);
+    ASSERT_EQ_INT(3, changes[0].port);
+    ASSERT_EQ_INT(2, changes[1].node);
+    ASSERT_EQ_INT(0x40, changes[1].addr);
+    ASSERT_EQ_INT(3, changes[1].port);
+    ASSERT_EQ_INT(0, links[1].up);
+
+    ASSERT_EQ_INT(SW_OK, sw_net_apply_route_changes(&net, changes, n));
+    uint8_t port = 0;
+    uint8_t del = 0;
+    const uint8_t pkt[2] = {0x41, 0};
+    ASSERT_EQ_INT(SW_ROUTE_OK, sw_router_route(&nodes[1].router, pkt, sizeof(pkt), &port, &del));
+    ASSERT_EQ_INT(3, port);
+
+    /* No change, no diff. */
+    ASSERT_EQ_INT(SW_OK, sw_net_spf_set_link(&spf, &net, 1, 0, 1, changes, 8, &n));
+    ASSERT_EQ_INT(0, (int)n);
+
+    /* Back up at equal cost to the detour: the lower port wins again. */
+    ASSERT_EQ_INT(SW_OK, sw_net_spf_set_link(&spf, &net, 1, 1, 2, changes, 8, &n));
+    ASSERT_EQ_INT(2, (int)n);
+    ASSERT_EQ_INT(2, changes[0].port);
+    ASSERT_EQ_INT(1, changes[1].port);
+
+    /* Cutting n0 off removes 0x40 everywhere and 0x41 at n0; a short change
+     * buffer reports the overflow but the table is still updated. */
+    ASSERT_EQ_INT(SW_ERR, sw_net_spf_set_link(&spf, &net, 0, 0, 1, changes, 2, &n));
+    ASSERT_EQ_INT(5, (int)n);
+    ASSERT_EQ_INT(SW_NET_NO_ROUTE, table[4 * SW_ROUTE_TABLE_SIZE + 0x40]);
+    ASSERT_EQ_INT(SW_NET_NO_ROUTE, table[0 * SW_ROUTE_TABLE_SIZE + 0x41]);
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_net_spf_set_link(&spf, &net, 0, 1, 0, changes, 8, &n));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_net_spf_set_link(&spf, &net, 9, 1, 1, changes, 8, &n));
+    return 0;
+}
+
+#define RAND_NODES 40u
+#define RAND_LINKS 80u
+
+/* Random flaps and cost changes on a random graph: the incremental table
+ * always equals a full recomputation, and the diff is exactly the entries
+ * that differ. */
+static int test_net_incremental_matches_full(void)
+{
+    static sw_net_node_t nodes[RAND_NODES];
+    static sw_net_link_t links[RAND_LINKS];
+    static uint64_t dist[SW_NET_NUM_ADDRS * RAND_NODES];
+    static uint8_t table[RAND_NODES * SW_ROUTE_TABLE_SIZE];
+    static uint8_t prev[RAND_NODES * SW_ROUTE_TABLE_SIZE];
+    static uint8_t full[RAND_NODES * SW_ROUTE_TABLE_SIZE];
+    static sw_net_route_change_t changes[RAND_NODES * SW_NET_NUM_ADDRS];
+    uint64_t full_dist[RAND_NODES];
+    uint16_t heap[RAND_NODES];
+    uint16_t pos[RAND_NODES];
+    uint16_t list[RAND_NODES];
+    uint8_t mark[RAND_NODES];
+
+    sw_net_t net;
+    ASSERT_EQ_INT(SW_OK, sw_net_init(&net, nodes, RAND_NODES, links, RAND_LINKS));
+    for (unsigned i = 0; i < RAND_NODES; i++)
+        ASSERT_EQ_INT(SW_OK, sw_net_add_node(&net, 8, (uint8_t)(i % 2u ? 0x40u + i : 0u), NULL));
+
+    uint32_t rng = 12345u;
+    uint8_t next_port[RAND_NODES];
+    memset(next_port, 1, sizeof(next_port));
+    while (net.num_links < RAND_LINKS)
+    {
+        rng = rng * 1103515245u + 12345u;
+        const uint16_t a = (uint16_t)((rng >> 8) % RAND_NODES);
+        rng = rng * 1103515245u + 12345u;
+        const uint16_t b = (uint16_t)((rng >> 8) % RAND_NODES);
+        if (a == b || next_port[a] >= 8 || next_port[b] >= 8)
+        {
+            if (next_port[a] >= 8 && next_port[b] >= 8)
+                break;
+            continue;
+        }
+        ASSERT_EQ_INT(SW_OK,
+                      sw_net_connect(&net, a, next_port[a]++, b, next_port[b]++, 1000, 0, NULL));
+    }
+
+    const sw_net_work_t work = {
+        .dist = full_dist, .heap = heap, .pos = pos, .list = list, .mark = mark};
+    sw_net_spf_t spf;
+    ASSERT_EQ_INT(SW_OK, sw_net_spf_init(&spf, &net, dist, table, &work));
+
+    for (unsigned step = 0; step < 300; step++)
+    {
+        rng = rng * 1103515245u + 12345u;
+        const uint16_t l = (uint16_t)((rng >> 8) % net.num_links);
+        rng = rng * 1103515245u + 12345u;
+        const int up = ((rng >> 8) % 3u) != 0;
+        const uint32_t cost = 1u + (rng >> 12) % 3u;
+
+        memcpy(prev, table, sizeof(prev));
+        size_t n = 0;
+        ASSERT_EQ_INT(
+            SW_OK,
+            sw_net_spf_set_link(&spf, &net, l, up, cost, changes, sizeof(changes) / 4u, &n));
+
+        ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&net, &work, full));
+        ASSERT_EQ_MEM(full, table, sizeof(full));
+
+        size_t differ = 0;
+        for (size_t i = 0; i < sizeof(full); i++)
+            differ += prev[i] != full[i];
+        ASSERT_EQ_INT((int)differ, (int)n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            ASSERT_EQ_INT(full[changes[i].node * SW_ROUTE_TABLE_SIZE + changes[i].addr],
+                          changes[i].port);
+            ASSERT_TRUE(i == 0 || changes[i - 1].node < changes[i].node ||
+                        (changes[i - 1].node == changes[i].node &&
+                         changes[i - 1].addr < changes[i].addr));
+        }
+    }
+    return 0;
+}
+
+test_result_t test_spacewire_net_run_all(void)
+{
+    RUN_TEST(test_net_build);
+    RUN_TEST(test_net_routes);
+    RUN_TEST(test_net_incremental);
+    RUN_TEST(test_net_incremental_matches_full);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
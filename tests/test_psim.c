@@ -0,0 +1,190 @@
+/**
+ * @file test_psim.c
+ * @brief Unit tests for the parallel network simulator.
+ *
+ * Partitions are run in turn from one thread with sw_psim_run_serial(), which
+ * follows the same windows as the threaded engine.
+ */
+#include "cunit.h"
+#include "spacewire_psim.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define SIDE 4u
+#define NODES (SIDE * SIDE)
+#define LINKS (2u * SIDE * (SIDE - 1u))
+#define EVENTS 1024u
+#define PARTS 4u
+#define QUEUE_LEN 256u
+
+typedef struct
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[LINKS];
+    uint64_t dist[NODES];
+    uint16_t heap[NODES];
+    uint16_t pos[NODES];
+    uint8_t tables[2 * NODES * SW_ROUTE_TABLE_SIZE];
+    sw_sim_t sim;
+    sw_sim_node_t sim_nodes[NODES];
+    sw_sim_event_t events[EVENTS];
+} fixture_t;
+
+typedef struct
+{
+    sw_psim_t psim;
+    sw_sim_t parts[PARTS];
+    uint16_t owner[NODES];
+    sw_sim_event_t events[PARTS * EVENTS];
+    sw_psim_queue_t queues[PARTS * PARTS];
+    sw_sim_event_t slots[PARTS * PARTS * QUEUE_LEN];
+} parallel_t;
+
+/*
+ * A 4 x 4 mesh, node i having logical address 0x40 + i and ports 1 north,
+ * 2 east, 3 south, 4 west. Every node sends traffic; the link between n5 and
+ * n6 fails at 200 us and the new routes are installed at 230 us.
+ */
+static int setup(fixture_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    ASSERT_EQ_INT(SW_OK, sw_net_init(&f->net, f->nodes, NODES, f->links, LINKS));
+
+    for (unsigned i = 0; i < NODES; i++)
+        ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 5, (uint8_t)(0x40u + i), NULL));
+
+    uint16_t failing = SW_NET_NONE;
+    for (unsigned y = 0; y < SIDE; y++)
+    {
+        for (unsigned x = 0; x < SIDE; x++)
+        {
+            const uint16_t n = (uint16_t)(y * SIDE + x);
+            uint16_t l = 0;
+            if (x + 1u < SIDE)
+            {
+                ASSERT_EQ_INT(SW_OK,
+                              sw_net_connect(&f->net, n, 2, (uint16_t)(n + 1u), 4, 100000000, 300,
+                                             &l));
+                if (n == 5)
+                    failing = l;
+            }
+            if (y + 1u < SIDE)
+                ASSERT_EQ_INT(SW_OK,
+                              sw_net_connect(&f->net, n, 3, (uint16_t)(n + SIDE), 1, 100000000,
+                                             200, NULL));
+        }
+    }
+
+    const sw_net_work_t work = {.dist = f->dist, .heap = f->heap, .pos = f->pos};
+    uint8_t *after = &f->tables[NODES * SW_ROUTE_TABLE_SIZE];
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&f->net, &work, f->tables));
+    ASSERT_EQ_INT(SW_OK, sw_net_install_routes(&f->net, f->tables));
+    f->links[failing].up = 0;
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&f->net, &work, after));
+    f->links[failing].up = 1;
+
+    ASSERT_EQ_INT(SW_OK, sw_sim_init(&f->sim, &f->net, f->sim_nodes, f->events, EVENTS, 3));
+    for (uint16_t n = 0; n < NODES; n++)
+        ASSERT_EQ_INT(SW_OK, sw_sim_set_traffic(&f->sim, n, 5000, 32));
+
+    uint16_t t = 0;
+    ASSERT_EQ_INT(SW_OK, sw_sim_add_table(&f->sim, after, &t));
+    ASSERT_EQ_INT(SW_OK, sw_sim_schedule_link(&f->sim, failing, 200000, 0));
+    for (uint16_t n = 0; n < NODES; n++)
+        ASSERT_EQ_INT(SW_OK, sw_sim_schedule_install(&f->sim, n, 230000, t));
+    return 0;
+}
+
+/* Partitioned runs reproduce the sequential run exactly, node by node. */
+static int test_psim_matches_sequential(void)
+{
+    static fixture_t seq;
+    static fixture_t par;
+    static parallel_t p;
+    const uint16_t counts[] = {1, 2, 3, 4};
+
+    ASSERT_EQ_INT(0, setup(&seq));
+    sw_sim_run(&seq.sim, 500000);
+    sw_sim_run(&seq.sim, 1000000);
+
+    sw_sim_stats_t st;
+    sw_sim_get_stats(&seq.sim, &st);
+    ASSERT_TRUE(st.generated > 3000);
+    ASSERT_TRUE(st.lost_link > 0);
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        ASSERT_EQ_INT(0, setup(&par));
+        sw_psim_partition_blocks(&par.net, counts[c], p.owner);
+        ASSERT_EQ_INT(SW_OK,
+                      sw_psim_init(&p.psim, &par.sim, p.parts, counts[c], p.owner, p.events,
+                                   EVENTS, p.queues, p.slots, QUEUE_LEN));
+        ASSERT_EQ_INT(0, (int)par.sim.num_events);
+        ASSERT_TRUE(p.psim.lookahead == (counts[c] == 1 ? UINT64_MAX : 200u));
+
+        const uint64_t first = sw_psim_run_serial(&p.psim, 500000);
+        const uint64_t second = sw_psim_run_serial(&p.psim, 1000000);
+        ASSERT_TRUE(first > 0 && second > 0);
+
+        for (uint16_t i = 0; i < counts[c]; i++)
+        {
+            ASSERT_EQ_INT(0, (int)p.parts[i].overflows);
+            ASSERT_EQ_INT(1000000, (int)p.parts[i].now);
+        }
+
+        ASSERT_EQ_MEM(seq.sim_nodes, par.sim_nodes, sizeof(seq.sim_nodes));
+        for (unsigned n = 0; n < NODES; n++)
+            ASSERT_EQ_MEM(seq.nodes[n].router.links,
+                          par.nodes[n].router.links,
+                          sizeof(seq.nodes[n].router.links));
+        for (unsigned a = 0; a < SW_ROUTE_TABLE_SIZE; a++)
+        {
+            const sw_route_entry_t *x = sw_router_get_route(&seq.nodes[0].router, (uint8_t)a);
+            const sw_route_entry_t *y = sw_router_get_route(&par.nodes[0].router, (uint8_t)a);
+            ASSERT_TRUE(x == y || (x && y && memcmp(x, y, sizeof(*x)) == 0));
+        }
+    }
+    return 0;
+}
+
+static int test_psim_invalid(void)
+{
+    static fixture_t f;
+    static parallel_t p;
+
+    ASSERT_EQ_INT(0, setup(&f));
+    sw_psim_partition_blocks(&f.net, 2, p.owner);
+    ASSERT_EQ_INT(0, p.owner[0]);
+    ASSERT_EQ_INT(1, p.owner[NODES - 1u]);
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM,
+                  sw_psim_init(&p.psim, &f.sim, p.parts, 0, p.owner, p.events, EVENTS, p.queues,
+                               p.slots, QUEUE_LEN));
+    ASSERT_EQ_INT(SW_INVALID_PARAM,
+                  sw_psim_init(&p.psim, &f.sim, p.parts, 2, p.owner, p.events, EVENTS, p.queues,
+                               p.slots, 100));
+
+    p.owner[3] = 2;
+    ASSERT_EQ_INT(SW_INVALID_PARAM,
+                  sw_psim_init(&p.psim, &f.sim, p.parts, 2, p.owner, p.events, EVENTS, p.queues,
+                               p.slots, QUEUE_LEN));
+
+    /* A zero-latency link across partitions leaves no lookahead. */
+    p.owner[3] = 0;
+    f.links[0].latency_ns = 0;
+    p.owner[f.links[0].node[1]] = 1;
+    ASSERT_EQ_INT(SW_INVALID_PARAM,
+                  sw_psim_init(&p.psim, &f.sim, p.parts, 2, p.owner, p.events, EVENTS, p.queues,
+                               p.slots, QUEUE_LEN));
+    ASSERT_TRUE(f.sim.num_events > 0); /* nothing moved */
+    return 0;
+}
+
+test_result_t test_spacewire_psim_run_all(void)
+{
+    RUN_TEST(test_psim_matches_sequential);
+    RUN_TEST(test_psim_invalid);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
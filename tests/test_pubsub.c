@@ -0,0 +1,180 @@
+/**
+ * @file test_pubsub.c
+ * @brief Unit tests for the zero-copy publish/subscribe channel.
+ */
+#include "cunit.h"
+#include "spacewire_pubsub.h"
+#include "test_runners.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Backing store for the "shared" region; aligned by hand inside it. */
+static uint8_t g_region[8192 + SW_PUBSUB_ALIGN];
+
+static void *region(void)
+{
+    const uintptr_t p = (uintptr_t)g_region;
+    return &g_region[(SW_PUBSUB_ALIGN - (p % SW_PUBSUB_ALIGN)) % SW_PUBSUB_ALIGN];
+}
+
+/* Encode a PTP packet whose one-octet data field is @p tag. */
+static size_t make_packet(uint8_t tag, uint16_t apid, uint8_t *buf, size_t buf_len)
+{
+    const uint8_t payload[1] = {tag};
+    return sw_packet_create(0x40, 0x03, apid, payload, sizeof(payload), buf, buf_len);
+}
+
+static int test_pubsub_create_and_attach(void)
+{
+    sw_pubsub_t pub;
+    sw_pubsub_t sub_view;
+
+    ASSERT_EQ_INT(0, (int)sw_pubsub_region_size(3, 64)); /* not a power of two */
+    ASSERT_EQ_INT(0, (int)sw_pubsub_region_size(4, 0));
+
+    const size_t need = sw_pubsub_region_size(4, 64);
+    ASSERT_TRUE(need > 0 && need <= 8192);
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_pubsub_create(&pub, region(), need - 1, 4, 64));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_pubsub_create(&pub, (uint8_t *)region() + 1, need, 4, 64));
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_create(&pub, region(), need, 4, 64));
+
+    /* A second "process" attaches to the same region. */
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_attach(&sub_view, region(), need));
+    ASSERT_EQ_INT(3, (int)sub_view.mask);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_pubsub_attach(&sub_view, region(), need / 2));
+
+    static uint8_t blank[256];
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_pubsub_attach(&sub_view, blank, sizeof(blank)));
+    return 0;
+}
+
+/* Two subscribers read the same decoded packet in place, without copies. */
+static int test_pubsub_fanout_zero_copy(void)
+{
+    sw_pubsub_t pub;
+    const size_t need = sw_pubsub_region_size(8, 128);
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_create(&pub, region(), need, 8, 128));
+
+    sw_pubsub_t view;
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_attach(&view, region(), need));
+
+    sw_pubsub_sub_t a;
+    sw_pubsub_sub_t b;
+    sw_pubsub_sub_init(&a, &view);
+    sw_pubsub_sub_init(&b, &view);
+
+    sw_pubsub_msg_t msg;
+    ASSERT_EQ_INT(SW_ERR, sw_pubsub_peek(&a, &msg)); /* nothing yet */
+
+    /* Receive straight into the arena, then decode in place. */
+    size_t cap = 0;
+    uint8_t *slot = sw_pubsub_reserve(&pub, &cap);
+    ASSERT_EQ_INT(128, (int)cap);
+    const size_t n = make_packet(0x5A, 0x123, slot, cap);
+    sw_ptp_status_t status = SW_PTP_STATUS_INVALID;
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_commit(&pub, n, SW_END_EOP, &status));
+    ASSERT_EQ_INT(SW_PTP_STATUS_OK, status);
+
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_peek(&a, &msg));
+    ASSERT_EQ_INT(0, (int)msg.seq);
+    ASSERT_EQ_INT((int)n, (int)msg.raw_len);
+    ASSERT_EQ_INT(0x40, msg.pf.logical_addr);
+    ASSERT_EQ_INT(0x03, msg.pf.user_app);
+    ASSERT_EQ_INT(0x123, msg.pf.packet.ph.apid);
+    ASSERT_EQ_INT(1, msg.pf.packet.data_len);
+    ASSERT_EQ_INT(0x5A, msg.pf.packet.data[0]);
+    /* The view points into the arena, at the decoded data field. */
+    ASSERT_TRUE(msg.pf.packet.data == slot + SW_PTP_HEADER_LEN + 6);
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_release(&a));
+
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_peek(&b, &msg));
+    ASSERT_EQ_INT(0x5A, msg.pf.packet.data[0]);
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_release(&b));
+
+    ASSERT_EQ_INT(SW_ERR, sw_pubsub_peek(&a, &msg));
+    ASSERT_EQ_INT(1, (int)a.received);
+    ASSERT_EQ_INT(1, (int)b.received);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_pubsub_release(&a)); /* nothing held */
+    return 0;
+}
+
+/* Discarded packets are counted but never published. */
+static int test_pubsub_discards(void)
+{
+    sw_pubsub_t pub;
+    const size_t need = sw_pubsub_region_size(4, 64);
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_create(&pub, region(), need, 4, 64));
+
+    sw_pubsub_sub_t sub;
+    sw_pubsub_sub_init(&sub, &pub);
+
+    uint8_t buf[64];
+    const size_t n = make_packet(1, 0x10, buf, sizeof(buf));
+    sw_ptp_status_t status = SW_PTP_STATUS_OK;
+
+    ASSERT_EQ_INT(SW_ERR, sw_pubsub_publish(&pub, buf, n, SW_END_EEP, &status));
+    ASSERT_EQ_INT(SW_PTP_STATUS_EEP, status);
+    ASSERT_EQ_INT(1, (int)pub.hdr->discarded);
+
+    static uint8_t big[65];
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_pubsub_publish(&pub, big, sizeof(big), SW_END_EOP, NULL));
+
+    sw_pubsub_msg_t msg;
+    ASSERT_EQ_INT(SW_ERR, sw_pubsub_peek(&sub, &msg));
+
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_publish(&pub, buf, n, SW_END_EOP, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_peek(&sub, &msg));
+    ASSERT_EQ_INT(0, (int)msg.seq); /* the discarded packet used no sequence number */
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_release(&sub));
+    return 0;
+}
+
+/* A slow subscriber is lapped: the publisher carries on and the subscriber
+ * skips ahead, counting what it lost. */
+static int test_pubsub_slow_subscriber(void)
+{
+    sw_pubsub_t pub;
+    const size_t need = sw_pubsub_region_size(4, 64);
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_create(&pub, region(), need, 4, 64));
+
+    sw_pubsub_sub_t sub;
+    sw_pubsub_sub_init(&sub, &pub);
+
+    uint8_t buf[64];
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        const size_t n = make_packet(i, 0x20, buf, sizeof(buf));
+        ASSERT_EQ_INT(SW_OK, sw_pubsub_publish(&pub, buf, n, SW_END_EOP, NULL));
+    }
+
+    /* Packets 7..9 are still intact; 0..6 were lost. */
+    sw_pubsub_msg_t msg;
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_peek(&sub, &msg));
+    ASSERT_EQ_INT(7, (int)msg.seq);
+    ASSERT_EQ_INT(7, msg.pf.packet.data[0]);
+    ASSERT_EQ_INT(7, (int)sub.dropped);
+
+    /* The publisher overwrites the held view; release reports it. */
+    const size_t n = make_packet(10, 0x20, buf, sizeof(buf));
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_publish(&pub, buf, n, SW_END_EOP, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_publish(&pub, buf, n, SW_END_EOP, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_publish(&pub, buf, n, SW_END_EOP, NULL));
+    ASSERT_EQ_INT(SW_ERR, sw_pubsub_release(&sub));
+    ASSERT_EQ_INT(8, (int)sub.dropped);
+
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_peek(&sub, &msg));
+    ASSERT_EQ_INT(10, (int)msg.seq);
+    ASSERT_EQ_INT(SW_OK, sw_pubsub_release(&sub));
+    return 0;
+}
+
+test_result_t test_spacewire_pubsub_run_all(void)
+{
+    RUN_TEST(test_pubsub_create_and_attach);
+    RUN_TEST(test_pubsub_fanout_zero_copy);
+    RUN_TEST(test_pubsub_discards);
+    RUN_TEST(test_pubsub_slow_subscriber);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
@@ -0,0 +1,167 @@
+/**
+ * @file test_ring.c
+ * @brief Unit tests for the SPSC descriptor ring.
+ */
+#include "cunit.h"
+#include "spacewire_ring.h"
+#include "test_runners.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define SLOTS 8u
+
+static sw_ring_t g_ring;
+static sw_desc_t g_slots[SLOTS];
+
+static sw_desc_t desc(uint32_t n)
+{
+    sw_desc_t d;
+    memset(&d, 0, sizeof(d));
+    d.len = n;
+    d.port = (uint8_t)(n % 19u);
+    d.tag = (uint16_t)n;
+    d.timestamp = 1000u + n;
+    return d;
+}
+
+static int test_ring_init(void)
+{
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ring_init(NULL, g_slots, SLOTS));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ring_init(&g_ring, NULL, SLOTS));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ring_init(&g_ring, g_slots, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_ring_init(&g_ring, g_slots, 6));
+    ASSERT_EQ_INT(SW_OK, sw_ring_init(&g_ring, g_slots, SLOTS));
+    ASSERT_EQ_INT(0, (int)sw_ring_count(&g_ring));
+
+    /* The two sides never share a cache line. */
+    ASSERT_TRUE(offsetof(sw_ring_t, head) - offsetof(sw_ring_t, tail) >= SW_RING_CACHE_LINE);
+    return 0;
+}
+
+static int test_ring_single(void)
+{
+    sw_desc_t d = desc(7);
+    sw_desc_t out;
+
+    ASSERT_EQ_INT(SW_OK, sw_ring_init(&g_ring, g_slots, SLOTS));
+    ASSERT_EQ_INT(SW_ERR, sw_ring_pop(&g_ring, &out));
+
+    for (uint32_t i = 0; i < SLOTS; i++)
+    {
+        d = desc(i);
+        ASSERT_EQ_INT(SW_OK, sw_ring_push(&g_ring, &d));
+    }
+    d = desc(99);
+    ASSERT_EQ_INT(SW_ERR, sw_ring_push(&g_ring, &d));
+    ASSERT_EQ_INT(SLOTS, (int)sw_ring_count(&g_ring));
+
+    for (uint32_t i = 0; i < SLOTS; i++)
+    {
+        const sw_desc_t expect = desc(i);
+        ASSERT_EQ_INT(SW_OK, sw_ring_pop(&g_ring, &out));
+        ASSERT_EQ_MEM(&expect, &out, sizeof(out));
+    }
+    ASSERT_EQ_INT(SW_ERR, sw_ring_pop(&g_ring, &out));
+    return 0;
+}
+
+/* Partial bursts across many wrap-arounds keep FIFO order; the 32-bit
+ * indices are started near overflow. */
+static int test_ring_burst_wrap(void)
+{
+    sw_desc_t in[5];
+    sw_desc_t out[5];
+    uint32_t next_in = 0;
+    uint32_t next_out = 0;
+
+    ASSERT_EQ_INT(SW_OK, sw_ring_init(&g_ring, g_slots, SLOTS));
+    g_ring.tail = g_ring.head = g_ring.head_cache = g_ring.tail_cache = UINT32_MAX - 20u;
+
+    for (unsigned round = 0; round < 50u; round++)
+    {
+        const uint32_t want = 1u + round % 5u;
+        for (uint32_t i = 0; i < want; i++)
+            in[i] = desc(next_in + i);
+
+        const uint32_t queued = sw_ring_count(&g_ring);
+        const uint32_t pushed = sw_ring_push_burst(&g_ring, in, want);
+        ASSERT_EQ_INT((int)(want < SLOTS - queued ? want : SLOTS - queued), (int)pushed);
+        next_in += pushed;
+
+        const uint32_t popped = sw_ring_pop_burst(&g_ring, out, 1u + (round * 3u) % 4u);
+        for (uint32_t i = 0; i < popped; i++)
+        {
+            const sw_desc_t expect = desc(next_out++);
+            ASSERT_EQ_MEM(&expect, &out[i], sizeof(out[i]));
+        }
+    }
+
+    while (sw_ring_pop_burst(&g_ring, out, 5) > 0)
+        ;
+    ASSERT_EQ_INT(0, (int)sw_ring_count(&g_ring));
+    ASSERT_TRUE(next_in > 2u * SLOTS);
+    ASSERT_EQ_INT(0, sw_ring_pop_burst(&g_ring, out, 0));
+    return 0;
+}
+
+/* Small packets travel inside the descriptor, larger ones by pointer; both
+ * decode from the popped copy. */
+static int test_ring_inline(void)
+{
+    static const uint8_t payload[64] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t small[SW_DESC_INLINE_MAX];
+    uint8_t large[96];
+    sw_desc_t d;
+    sw_desc_t out[2];
+    sw_packet_frame_t pf;
+    sw_ptp_status_t status;
+
+    const uint32_t small_len =
+        (uint32_t)sw_packet_create(0x42, 1, 0x123, payload, 8, small, sizeof(small));
+    const uint32_t large_len =
+        (uint32_t)sw_packet_create(0x43, 2, 0x124, payload, 64, large, sizeof(large));
+    ASSERT_TRUE(small_len == 18 && small_len <= SW_DESC_INLINE_MAX);
+    ASSERT_TRUE(large_len > SW_DESC_INLINE_MAX);
+
+    ASSERT_EQ_INT(SW_OK, sw_ring_init(&g_ring, g_slots, SLOTS));
+    d = desc(1);
+    d.end = SW_END_EOP;
+    ASSERT_EQ_INT(1, sw_desc_set_packet(&d, small, small_len));
+    ASSERT_TRUE(sw_desc_is_inline(&d));
+    ASSERT_EQ_INT(SW_OK, sw_ring_push(&g_ring, &d));
+    memset(small, 0, sizeof(small));
+
+    d = desc(2);
+    d.end = SW_END_EOP;
+    ASSERT_EQ_INT(0, sw_desc_set_packet(&d, large, large_len));
+    ASSERT_TRUE(!sw_desc_is_inline(&d) && sw_desc_data(&d) == large);
+    ASSERT_EQ_INT(SW_OK, sw_ring_push(&g_ring, &d));
+
+    ASSERT_EQ_INT(2, (int)sw_ring_pop_burst(&g_ring, out, 2));
+    ASSERT_EQ_INT(SW_OK, sw_desc_decode(&pf, &out[0], &status));
+    ASSERT_EQ_INT(SW_PTP_STATUS_OK, status);
+    ASSERT_TRUE(pf.logical_addr == 0x42 && pf.user_app == 1 && pf.packet.ph.apid == 0x123);
+    ASSERT_EQ_INT(8, pf.packet.data_len);
+    ASSERT_EQ_MEM(payload, pf.packet.data, 8);
+    ASSERT_TRUE(pf.packet.data >= out[0].inl && pf.packet.data < out[0].inl + SW_DESC_INLINE_MAX);
+
+    ASSERT_EQ_INT(SW_OK, sw_desc_decode(&pf, &out[1], &status));
+    ASSERT_TRUE(pf.logical_addr == 0x43 && pf.packet.ph.apid == 0x124);
+    ASSERT_EQ_MEM(payload, pf.packet.data, 64);
+
+    /* An EEP recorded in the descriptor discards the packet. */
+    out[0].end = SW_END_EEP;
+    ASSERT_EQ_INT(SW_ERR, sw_desc_decode(&pf, &out[0], &status));
+    ASSERT_EQ_INT(SW_PTP_STATUS_EEP, status);
+    return 0;
+}
+
+test_result_t test_spacewire_ring_run_all(void)
+{
+    RUN_TEST(test_ring_init);
+    RUN_TEST(test_ring_single);
+    RUN_TEST(test_ring_burst_wrap);
+    RUN_TEST(test_ring_inline);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
@@ -106,6 +106,34 @@ static int test_router_add_route_validation(void)
     return 0;
 }
 
+static int test_router_remove_route(void)
+{
+    sw_router_t router;
+    sw_router_init(&router, 4);
+
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&router, 0x40, 2, 1));
+    const sw_route_entry_t *e = sw_router_get_route(&router, 0x40);
+    ASSERT_TRUE(e != NULL);
+    ASSERT_EQ_INT(2, e->output_port);
+    ASSERT_EQ_INT(1, e->delete_addr);
+    ASSERT_TRUE(sw_router_get_route(&router, 0x41) == NULL);
+    ASSERT_TRUE(sw_router_get_route(NULL, 0x40) == NULL);
+
+    ASSERT_EQ_INT(SW_OK, sw_router_remove_route(&router, 0x40));
+    ASSERT_TRUE(sw_router_get_route(&router, 0x40) == NULL);
+    ASSERT_EQ_INT(SW_OK, sw_router_remove_route(&router, 0x40)); /* idempotent */
+
+    uint8_t port = 0;
+    uint8_t del = 0;
+    const uint8_t pkt[2] = {0x40, 0x99};
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD, sw_router_route(&router, pkt, sizeof(pkt), &port, &del));
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_router_remove_route(NULL, 0x40));
+    ASSERT_EQ_INT(SW_WRONG_ADDRESS, sw_router_remove_route(&router, 0x10));
+    ASSERT_EQ_INT(SW_WRONG_ADDRESS, sw_router_remove_route(&router, 0xFF));
+    return 0;
+}
+
 static int test_router_route_invalid_args_and_empty(void)
 {
     sw_router_t router;
@@ -128,6 +156,295 @@ static int test_router_route_invalid_args_and_empty(void)
     return 0;
 }
 
+/* One pass over a chain agrees with routing hop by hop and stripping the
+ * deleted octets from a copy. */
+static int test_router_resolve_chain(void)
+{
+    sw_router_t r[4];
+    const sw_router_t *chain[4] = {&r[0], &r[1], &r[2], &r[3]};
+    const uint8_t pkt[] = {2, 5, 0x40, 0x41, 0x02, 0x00, 0x00, 0xAB};
+    uint8_t copy[sizeof(pkt)];
+    uint8_t ports[4] = {0};
+    size_t consumed = 99;
+    size_t hops = 99;
+
+    for (int i = 0; i < 4; i++)
+        sw_router_init(&r[i], 8);
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&r[2], 0x40, 3, 1));
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&r[3], 0x41, 6, 0));
+
+    ASSERT_EQ_INT(SW_ROUTE_OK,
+                  sw_router_resolve(chain, 4, pkt, sizeof(pkt), ports, &consumed, &hops));
+    ASSERT_EQ_INT(4, (int)hops);
+    ASSERT_EQ_INT(3, (int)consumed);
+
+    memcpy(copy, pkt, sizeof(pkt));
+    size_t len = sizeof(copy);
+    for (int i = 0; i < 4; i++)
+    {
+        uint8_t port = 0xFF;
+        uint8_t del = 0;
+        ASSERT_EQ_INT(SW_ROUTE_OK, sw_router_route(&r[i], copy, len, &port, &del));
+        ASSERT_EQ_INT(port, ports[i]);
+        if (del)
+            memmove(copy, &copy[1], --len);
+    }
+    ASSERT_EQ_INT((int)(sizeof(pkt) - consumed), (int)len);
+    ASSERT_EQ_MEM(&pkt[consumed], copy, len);
+
+    /* The resolver leaves the routers' counters alone. */
+    ASSERT_EQ_INT(1, (int)r[0].packets_routed);
+
+    /* A configuration port ends the walk. */
+    const uint8_t cfg[] = {1, 0, 0x02};
+    ASSERT_EQ_INT(SW_ROUTE_OK,
+                  sw_router_resolve(chain, 4, cfg, sizeof(cfg), ports, &consumed, &hops));
+    ASSERT_TRUE(hops == 2 && consumed == 2 && ports[0] == 1 && ports[1] == SW_PORT_CONFIG);
+
+    /* No routers: nothing is consumed. */
+    ASSERT_EQ_INT(SW_ROUTE_OK,
+                  sw_router_resolve(chain, 0, pkt, sizeof(pkt), ports, &consumed, &hops));
+    ASSERT_TRUE(hops == 0 && consumed == 0);
+    return 0;
+}
+
+/* The discarding hop is reported; nothing is counted. */
+static int test_router_resolve_discard(void)
+{
+    sw_router_t r[3];
+    const sw_router_t *chain[3] = {&r[0], &r[1], &r[2]};
+    uint8_t ports[3];
+    size_t consumed = 0;
+    size_t hops = 0;
+
+    for (int i = 0; i < 3; i++)
+        sw_router_init(&r[i], 4);
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&r[1], 0x50, 2, 0));
+
+    /* Unconfigured logical address at the third router. */
+    const uint8_t unrouted[] = {1, 0x50, 0xAA};
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD,
+                  sw_router_resolve(chain, 3, unrouted, sizeof(unrouted), ports, &consumed, &hops));
+    ASSERT_TRUE(hops == 2 && consumed == 1 && ports[0] == 1 && ports[1] == 2);
+    ASSERT_EQ_INT(0, (int)r[2].invalid_address_errors);
+
+    /* Path address to a port the second router does not have. */
+    const uint8_t no_port[] = {3, 9, 0xAA};
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD,
+                  sw_router_resolve(chain, 3, no_port, sizeof(no_port), ports, &consumed, &hops));
+    ASSERT_TRUE(hops == 1 && consumed == 1);
+
+    /* The path runs out before the last router. */
+    const uint8_t short_path[] = {2, 3};
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD,
+                  sw_router_resolve(
+                      chain, 3, short_path, sizeof(short_path), ports, &consumed, &hops));
+    ASSERT_TRUE(hops == 2 && consumed == 2);
+
+    const sw_router_t *gap[2] = {&r[0], NULL};
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD,
+                  sw_router_resolve(gap, 2, short_path, sizeof(short_path), ports, NULL, &hops));
+    ASSERT_EQ_INT(1, (int)hops);
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD, sw_router_resolve(NULL, 3, unrouted, 3, ports, NULL, NULL));
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD, sw_router_resolve(chain, 3, NULL, 3, ports, NULL, NULL));
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD,
+                  sw_router_resolve(chain, 3, unrouted, 3, NULL, &consumed, &hops));
+    ASSERT_TRUE(hops == 0 && consumed == 0);
+    return 0;
+}
+
+/* Rewrite, insert and delete leading octets in place, within the headroom. */
+static int test_router_xlat_apply(void)
+{
+    static sw_xlat_table_t table;
+    const uint8_t rewrite[] = {0x60};
+    const uint8_t path[] = {3, 7};
+    const uint8_t both[] = {5, 0x70};
+    uint8_t buf[16];
+    size_t off;
+    size_t len;
+
+    sw_xlat_init(&table);
+    ASSERT_EQ_INT(SW_OK, sw_xlat_set(&table, 0x40, 1, rewrite, 1));
+    ASSERT_EQ_INT(SW_OK, sw_xlat_set(&table, 0x41, 0, path, 2));
+    ASSERT_EQ_INT(SW_OK, sw_xlat_set(&table, 0x42, 1, both, 2));
+    ASSERT_EQ_INT(SW_OK, sw_xlat_set(&table, 5, 1, NULL, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_xlat_set(&table, 0x43, 0, NULL, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_xlat_set(&table, 0x43, 1, NULL, 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_xlat_set(&table, 0x43, 1, path, SW_XLAT_MAX_PREFIX + 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_xlat_set(NULL, 0x43, 1, path, 1));
+
+    /* Rewrite: one octet changes where it is. */
+    const uint8_t pkt[] = {0x40, 0x02, 0x00, 0x09, 0xAA, 0xBB};
+    memset(buf, 0, sizeof(buf));
+    memcpy(&buf[4], pkt, sizeof(pkt));
+    off = 4;
+    len = sizeof(pkt);
+    ASSERT_EQ_INT(SW_OK, sw_xlat_apply(&table, buf, sizeof(buf), &off, &len));
+    ASSERT_TRUE(off == 4 && len == sizeof(pkt) && buf[4] == 0x60);
+    ASSERT_EQ_MEM(&pkt[1], &buf[5], sizeof(pkt) - 1u);
+
+    /* Replace the logical address with a path and a new one: one octet of
+     * headroom is taken. */
+    buf[4] = 0x42;
+    ASSERT_EQ_INT(SW_OK, sw_xlat_apply(&table, buf, sizeof(buf), &off, &len));
+    ASSERT_TRUE(off == 3 && len == sizeof(pkt) + 1u);
+    ASSERT_TRUE(buf[3] == 5 && buf[4] == 0x70);
+    ASSERT_EQ_MEM(&pkt[1], &buf[5], sizeof(pkt) - 1u);
+
+    /* Delete a path octet. */
+    ASSERT_EQ_INT(SW_OK, sw_xlat_apply(&table, buf, sizeof(buf), &off, &len));
+    ASSERT_TRUE(off == 4 && len == sizeof(pkt) && buf[4] == 0x70);
+
+    /* No rule for 0x70: unchanged. */
+    ASSERT_EQ_INT(SW_OK, sw_xlat_apply(&table, buf, sizeof(buf), &off, &len));
+    ASSERT_TRUE(off == 4 && len == sizeof(pkt));
+
+    /* Insert a path without headroom: the cargo moves up. */
+    memcpy(buf, pkt, sizeof(pkt));
+    buf[0] = 0x41;
+    off = 0;
+    len = sizeof(pkt);
+    ASSERT_EQ_INT(SW_OK, sw_xlat_apply(&table, buf, sizeof(buf), &off, &len));
+    ASSERT_TRUE(off == 0 && len == sizeof(pkt) + 2u);
+    ASSERT_TRUE(buf[0] == 3 && buf[1] == 7 && buf[2] == 0x41);
+    ASSERT_EQ_MEM(&pkt[1], &buf[3], sizeof(pkt) - 1u);
+
+    /* ... unless the buffer is full. */
+    off = 0;
+    len = sizeof(pkt);
+    buf[0] = 0x41;
+    ASSERT_EQ_INT(SW_ERR, sw_xlat_apply(&table, buf, sizeof(pkt) + 1u, &off, &len));
+    ASSERT_TRUE(off == 0 && len == sizeof(pkt) && buf[0] == 0x41);
+
+    /* Too short to strip; bad arguments. */
+    len = 0;
+    ASSERT_EQ_INT(SW_OK, sw_xlat_apply(&table, buf, sizeof(buf), &off, &len));
+    ASSERT_EQ_INT(SW_OK, sw_xlat_clear(&table, 0x40));
+    ASSERT_EQ_INT(SW_OK, sw_xlat_set(&table, 0x40, 3, NULL, 0));
+    buf[0] = 0x40;
+    len = 2;
+    ASSERT_EQ_INT(SW_ERR, sw_xlat_apply(&table, buf, sizeof(buf), &off, &len));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_xlat_apply(&table, buf, 8, &off, &(size_t){9}));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_xlat_apply(NULL, buf, sizeof(buf), &off, &len));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_xlat_clear(NULL, 0x40));
+    return 0;
+}
+
+/* Route, drop a deleted address by moving the offset, translate at egress. */
+static int test_router_xlat_egress(void)
+{
+    static sw_xlat_table_t table;
+    const sw_xlat_table_t *ports[8] = {NULL};
+    sw_router_t router;
+    const uint8_t next[] = {0x80};
+    uint8_t buf[12] = {0, 0, 4, 0x50, 0x02, 0x00, 0x00, 0xAB};
+    size_t off = 2;
+    size_t len = 6;
+    uint8_t port = 0;
+    uint8_t del = 0;
+
+    sw_router_init(&router, 8);
+    sw_xlat_init(&table);
+    ASSERT_EQ_INT(SW_OK, sw_xlat_set(&table, 0x50, 1, next, 1));
+    ASSERT_EQ_INT(SW_ERR, sw_router_set_xlat(&router, 4, &table));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_router_set_xlat_ports(NULL, ports));
+    ASSERT_EQ_INT(SW_OK, sw_router_set_xlat_ports(&router, ports));
+    ASSERT_EQ_INT(SW_OK, sw_router_set_xlat(&router, 4, &table));
+    ASSERT_TRUE(ports[4] == &table);
+    ASSERT_EQ_INT(SW_WRONG_PORT, sw_router_set_xlat(&router, 8, &table));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_router_set_xlat(NULL, 4, &table));
+
+    ASSERT_EQ_INT(SW_ROUTE_OK, sw_router_route(&router, &buf[off], len, &port, &del));
+    ASSERT_TRUE(port == 4 && del == 1);
+    off += del;
+    len -= del;
+    ASSERT_EQ_INT(SW_OK, sw_router_translate(&router, port, buf, sizeof(buf), &off, &len));
+    ASSERT_TRUE(off == 3 && len == 5 && buf[3] == 0x80 && buf[7] == 0xAB);
+
+    /* Ports without a table leave the packet alone. */
+    ASSERT_EQ_INT(SW_OK, sw_router_translate(&router, 1, buf, sizeof(buf), &off, &len));
+    ASSERT_TRUE(off == 3 && buf[3] == 0x80);
+    ASSERT_EQ_INT(SW_OK, sw_router_set_xlat(&router, 4, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_router_translate(&router, 4, buf, sizeof(buf), &off, &len));
+    ASSERT_EQ_INT(SW_OK, sw_router_set_xlat(&router, 4, &table));
+    ASSERT_EQ_INT(SW_OK, sw_router_set_xlat_ports(&router, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_router_translate(&router, 4, buf, sizeof(buf), &off, &len));
+    ASSERT_TRUE(off == 3 && buf[3] == 0x80);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_router_translate(&router, 9, buf, sizeof(buf), &off, &len));
+    return 0;
+}
+
+/* Routers sharing one table copy it when changed; the last one writes it. */
+static int test_router_shared_routes(void)
+{
+    static sw_route_table_t table;
+    static sw_router_t master;
+    static sw_router_t r[3];
+    static sw_router_t copy;
+    uint8_t port = 0;
+    uint8_t del = 0;
+    const uint8_t pkt[2] = {0x40, 0x99};
+
+    sw_router_init(&master, 8);
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&master, 0x40, 5, 0));
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&master, 0x41, 6, 1));
+
+    /* A router's own table is never shared. */
+    sw_router_init(&r[0], 8);
+    ASSERT_EQ_INT(SW_ERR, sw_router_share_routes(&r[0], &master));
+
+    ASSERT_EQ_INT(SW_OK, sw_router_set_routes(&master, &table));
+    ASSERT_TRUE(master.routes == &table && table.refs == 1);
+    ASSERT_EQ_INT(6, sw_router_get_route(&master, 0x41)->output_port);
+    for (int i = 0; i < 3; i++)
+    {
+        sw_router_init(&r[i], 8);
+        ASSERT_EQ_INT(SW_OK, sw_router_share_routes(&r[i], &master));
+        ASSERT_TRUE(r[i].routes == &table);
+    }
+    ASSERT_EQ_INT(4, (int)table.refs);
+    ASSERT_EQ_INT(SW_ROUTE_OK, sw_router_route(&r[2], pkt, sizeof(pkt), &port, &del));
+    ASSERT_EQ_INT(5, port);
+
+    /* Unchanged routes do not copy; a change copies into the router's own. */
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&r[0], 0x40, 5, 0));
+    ASSERT_EQ_INT(SW_OK, sw_router_remove_route(&r[0], 0x42));
+    ASSERT_TRUE(r[0].routes == &table);
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&r[0], 0x40, 7, 0));
+    ASSERT_TRUE(r[0].routes == NULL && table.refs == 3);
+    ASSERT_EQ_INT(7, sw_router_get_route(&r[0], 0x40)->output_port);
+    ASSERT_EQ_INT(6, sw_router_get_route(&r[0], 0x41)->output_port);
+    ASSERT_EQ_INT(5, sw_router_get_route(&r[1], 0x40)->output_port);
+
+    /* So does the router that set the table up. */
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&master, 0x40, 1, 0));
+    ASSERT_TRUE(master.routes == NULL && table.refs == 2);
+    ASSERT_EQ_INT(1, sw_router_get_route(&master, 0x40)->output_port);
+    ASSERT_EQ_INT(5, sw_router_get_route(&r[2], 0x40)->output_port);
+
+    /* A copy holds the shared routes in its own table. */
+    ASSERT_EQ_INT(SW_OK, sw_router_copy(&copy, &r[2]));
+    ASSERT_TRUE(copy.routes == NULL && table.refs == 2);
+    ASSERT_EQ_INT(5, sw_router_get_route(&copy, 0x40)->output_port);
+
+    /* The last router left on a table writes it in place again. */
+    ASSERT_EQ_INT(SW_OK, sw_router_remove_route(&r[1], 0x41));
+    ASSERT_TRUE(r[1].routes == NULL && table.refs == 1);
+    ASSERT_EQ_INT(SW_OK, sw_router_remove_route(&r[2], 0x41));
+    ASSERT_TRUE(r[2].routes == &table);
+    ASSERT_TRUE(sw_router_get_route(&r[2], 0x41) == NULL);
+
+    ASSERT_EQ_INT(SW_OK, sw_router_clear_routes(&r[2]));
+    ASSERT_TRUE(r[2].routes == NULL && table.refs == 0);
+    ASSERT_TRUE(sw_router_get_route(&r[2], 0x40) == NULL);
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_router_share_routes(&r[0], NULL));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_router_set_routes(&r[0], NULL));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_router_copy(NULL, &r[0]));
+    return 0;
+}
+
 static int test_link_layer_state_helpers(void)
 {
     const sw_link_config_t config = {
@@ -165,7 +482,13 @@ test_result_t test_spacewire_router_run_all(void)
     RUN_TEST(test_router_path_addressing);
     RUN_TEST(test_router_logical_addressing);
     RUN_TEST(test_router_add_route_validation);
+    RUN_TEST(test_router_remove_route);
     RUN_TEST(test_router_route_invalid_args_and_empty);
+    RUN_TEST(test_router_resolve_chain);
+    RUN_TEST(test_router_resolve_discard);
+    RUN_TEST(test_router_xlat_apply);
+    RUN_TEST(test_router_xlat_egress);
+    RUN_TEST(test_router_shared_routes);
     RUN_TEST(test_link_layer_state_helpers);
     return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
 }
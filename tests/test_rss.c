@@ -0,0 +1,194 @@
+/**
+ * @file test_rss.c
+ * @brief Unit tests for flow-hash receive steering.
+ */
+#include "cunit.h"
+#include "spacewire_rss.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define WORKERS 4u
+#define SLOTS 16u
+#define FLOWS 8u
+
+static sw_rss_t g_rss;
+static sw_ring_t g_rings[WORKERS];
+static sw_desc_t g_slots[WORKERS][SLOTS];
+static uint8_t g_pkts[FLOWS][32];
+static uint32_t g_lens[FLOWS];
+
+static void setup(void)
+{
+    static const uint8_t payload[4] = {1, 2, 3, 4};
+
+    for (uint32_t w = 0; w < WORKERS; w++)
+        sw_ring_init(&g_rings[w], g_slots[w], SLOTS);
+    for (uint32_t f = 0; f < FLOWS; f++)
+        g_lens[f] = (uint32_t)sw_packet_create((uint8_t)(0x40u + f % 2u),
+                                               (uint8_t)(f / 2u),
+                                               (uint16_t)(0x100u + f),
+                                               payload,
+                                               sizeof(payload),
+                                               g_pkts[f],
+                                               sizeof(g_pkts[f]));
+}
+
+static sw_desc_t desc(uint32_t flow, uint32_t seq)
+{
+    sw_desc_t d;
+    memset(&d, 0, sizeof(d));
+    d.data = g_pkts[flow];
+    d.len = g_lens[flow];
+    d.tag = (uint16_t)flow;
+    d.timestamp = seq;
+    return d;
+}
+
+/** Worker a flow is steered to now. */
+static uint8_t worker_of(uint32_t flow)
+{
+    const uint32_t key = sw_rss_flow_key(g_pkts[flow], g_lens[flow]);
+    return g_rss.buckets[sw_rss_bucket(&g_rss, key)].worker;
+}
+
+static int test_rss_key(void)
+{
+    const uint8_t other[6] = {0x41, 0x01, 0x00, 0x07, 0xFF, 0xFF};
+
+    setup();
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_rss_init(&g_rss, NULL, WORKERS, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_rss_init(&g_rss, g_rings, 0, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_rss_init(&g_rss, g_rings, SW_RSS_MAX_WORKERS + 1u, 0));
+    ASSERT_EQ_INT(SW_OK, sw_rss_init(&g_rss, g_rings, WORKERS, 0x1234u));
+    ASSERT_EQ_INT(3, g_rss.buckets[7].worker);
+
+    /* Fixed offsets: logical address, user application and APID. */
+    ASSERT_EQ_INT((int)SW_TOPK_KEY(0x41, 2, 0x105),
+                  (int)sw_rss_flow_key(g_pkts[5], g_lens[5]));
+    ASSERT_EQ_INT((int)SW_TOPK_KEY(0x41, 0, SW_TOPK_NO_APID),
+                  (int)sw_rss_flow_key(other, sizeof(other)));
+    ASSERT_EQ_INT((int)SW_TOPK_KEY(0x41, 0, SW_TOPK_NO_APID), (int)sw_rss_flow_key(other, 5));
+    ASSERT_EQ_INT(0, (int)sw_rss_flow_key(other, 0));
+    ASSERT_TRUE(sw_rss_bucket(&g_rss, 0xFFFFFFFFu) < SW_RSS_BUCKETS);
+    return 0;
+}
+
+/* Each flow lands on its bucket's worker, in order; a full ring stops the
+ * burst at the first descriptor it cannot take. */
+static int test_rss_steer(void)
+{
+    sw_desc_t in[80];
+    sw_desc_t out[SLOTS];
+    uint32_t expect[FLOWS] = {0};
+    uint32_t queued[WORKERS] = {0};
+
+    setup();
+    ASSERT_EQ_INT(SW_OK, sw_rss_init(&g_rss, g_rings, WORKERS, 7));
+    for (uint32_t i = 0; i < 80u; i++)
+        in[i] = desc(i % FLOWS, i / FLOWS);
+
+    /* Eight flows on four workers: some ring takes at least 20 and overflows. */
+    uint32_t fit = 0;
+    while (fit < 80u && queued[worker_of(fit % FLOWS)] < SLOTS)
+        queued[worker_of(fit++ % FLOWS)]++;
+
+    ASSERT_TRUE(fit < 80u);
+    ASSERT_EQ_INT((int)fit, (int)sw_rss_steer_burst(&g_rss, in, 80));
+    for (uint32_t w = 0; w < WORKERS; w++)
+    {
+        ASSERT_EQ_INT((int)queued[w], (int)sw_ring_count(&g_rings[w]));
+        ASSERT_EQ_INT((int)queued[w], (int)g_rss.packets[w]);
+
+        const uint32_t n = sw_ring_pop_burst(&g_rings[w], out, SLOTS);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            ASSERT_EQ_INT(w, worker_of(out[i].tag));
+            ASSERT_EQ_INT((int)expect[out[i].tag], (int)out[i].timestamp);
+            expect[out[i].tag]++;
+        }
+    }
+
+    /* The rest follows once the rings are drained. */
+    ASSERT_TRUE(sw_rss_steer_burst(&g_rss, &in[fit], 80u - fit) > 0);
+    ASSERT_EQ_INT(0, (int)sw_rss_steer_burst(&g_rss, in, 0));
+    return 0;
+}
+
+/* A moved bucket stays with its worker until its queued packets are popped. */
+static int test_rss_move(void)
+{
+    sw_desc_t out[SLOTS];
+
+    setup();
+    ASSERT_EQ_INT(SW_OK, sw_rss_init(&g_rss, g_rings, WORKERS, 7));
+    const uint32_t b = sw_rss_bucket(&g_rss, sw_rss_flow_key(g_pkts[0], g_lens[0]));
+    const uint8_t from = g_rss.buckets[b].worker;
+    const uint8_t to = (uint8_t)((from + 1u) % WORKERS);
+
+    /* Idle bucket: moves at once. */
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_rss_move(&g_rss, SW_RSS_BUCKETS, to));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_rss_move(&g_rss, b, WORKERS));
+    ASSERT_EQ_INT(SW_OK, sw_rss_move(&g_rss, b, to));
+    ASSERT_EQ_INT(to, worker_of(0));
+    ASSERT_EQ_INT(SW_OK, sw_rss_move(&g_rss, b, from));
+    ASSERT_EQ_INT(2, (int)g_rss.moves);
+
+    /* Busy bucket: its next packets keep going to the old worker. */
+    const sw_desc_t d0 = desc(0, 0);
+    const sw_desc_t d1 = desc(0, 1);
+    const sw_desc_t d2 = desc(0, 2);
+    ASSERT_EQ_INT(1, (int)sw_rss_steer_burst(&g_rss, &d0, 1));
+    ASSERT_EQ_INT(SW_OK, sw_rss_move(&g_rss, b, to));
+    ASSERT_EQ_INT(1, (int)sw_rss_steer_burst(&g_rss, &d1, 1));
+    ASSERT_EQ_INT(from, worker_of(0));
+    ASSERT_EQ_INT(2, (int)sw_ring_count(&g_rings[from]));
+
+    ASSERT_EQ_INT(1, (int)sw_ring_pop_burst(&g_rings[from], out, 1));
+    ASSERT_EQ_INT(1, (int)sw_rss_steer_burst(&g_rss, &d2, 1));
+    ASSERT_EQ_INT(2, (int)sw_ring_count(&g_rings[from]));
+    ASSERT_EQ_INT(0, (int)sw_ring_count(&g_rings[to]));
+
+    ASSERT_EQ_INT(2, (int)sw_ring_pop_burst(&g_rings[from], out, SLOTS));
+    ASSERT_EQ_INT(1, (int)sw_rss_steer_burst(&g_rss, &d2, 1));
+    ASSERT_EQ_INT(to, worker_of(0));
+    ASSERT_EQ_INT(1, (int)sw_ring_count(&g_rings[to]));
+    ASSERT_EQ_INT(3, (int)g_rss.moves);
+    return 0;
+}
+
+/* Skewed load is spread over the workers, and the loads decay. */
+static int test_rss_rebalance(void)
+{
+    setup();
+    ASSERT_EQ_INT(SW_OK, sw_rss_init(&g_rss, g_rings, WORKERS, 7));
+
+    /* Worker 0 carries eight heavy buckets; the others are idle. */
+    for (uint32_t i = 0; i < 8u; i++)
+        g_rss.buckets[i * WORKERS].load = 1000u;
+    ASSERT_EQ_INT(6, (int)sw_rss_rebalance(&g_rss));
+
+    uint32_t per_worker[WORKERS] = {0};
+    for (uint32_t i = 0; i < 8u; i++)
+    {
+        const sw_rss_bucket_t *bk = &g_rss.buckets[i * WORKERS];
+        per_worker[bk->worker]++;
+        ASSERT_EQ_INT(500, (int)bk->load);
+    }
+    for (uint32_t w = 0; w < WORKERS; w++)
+        ASSERT_EQ_INT(2, (int)per_worker[w]);
+
+    /* Balanced: nothing moves. */
+    ASSERT_EQ_INT(0, (int)sw_rss_rebalance(&g_rss));
+    ASSERT_EQ_INT(0, (int)sw_rss_rebalance(NULL));
+    return 0;
+}
+
+test_result_t test_spacewire_rss_run_all(void)
+{
+    RUN_TEST(test_rss_key);
+    RUN_TEST(test_rss_steer);
+    RUN_TEST(test_rss_move);
+    RUN_TEST(test_rss_rebalance);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
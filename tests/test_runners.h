@@ -14,5 +14,26 @@ typedef struct
 test_result_t test_spacewire_spw_packet_run_all(void);
 test_result_t test_spacewire_router_run_all(void);
 test_result_t test_spacewire_packet_run_all(void);
+test_result_t test_spacewire_pubsub_run_all(void);
+test_result_t test_spacewire_sched_run_all(void);
+test_result_t test_spacewire_evlog_run_all(void);
+test_result_t test_spacewire_net_run_all(void);
+test_result_t test_spacewire_sim_run_all(void);
+test_result_t test_spacewire_psim_run_all(void);
+test_result_t test_spacewire_ckpt_run_all(void);
+test_result_t test_spacewire_topk_run_all(void);
+test_result_t test_spacewire_ring_run_all(void);
+test_result_t test_spacewire_capidx_run_all(void);
+test_result_t test_spacewire_decom_run_all(void);
+test_result_t test_spacewire_archive_run_all(void);
+test_result_t test_spacewire_sfq_run_all(void);
+test_result_t test_spacewire_trace_run_all(void);
+test_result_t test_spacewire_spfi_run_all(void);
+test_result_t test_spacewire_nc_run_all(void);
+test_result_t test_spacewire_ds_run_all(void);
+test_result_t test_spacewire_txq_run_all(void);
+test_result_t test_spacewire_rss_run_all(void);
+test_result_t test_spacewire_fixed_run_all(void);
+test_result_t test_spacewire_tf_run_all(void);
 
 #endif /* TEST_RUNNERS_H */
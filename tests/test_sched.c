@@ -0,0 +1,184 @@
+/**
+ * @file test_sched.c
+ * @brief Unit tests for the work-stealing port scheduler.
+ *
+ * Workers are stepped in turn from one thread, which makes the stealing
+ * decisions deterministic.
+ */
+#include "cunit.h"
+#include "spacewire_sched.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define NUM_TASKS 4u
+#define BURST 8u
+
+/* Synthetic ports: a backlog of packets and the worker that last served them. */
+typedef struct
+{
+    uint32_t backlog[NUM_TASKS];
+    uint32_t served[NUM_TASKS];
+    uint32_t next_seq[NUM_TASKS]; /* per-port order check */
+    unsigned last_worker[NUM_TASKS];
+    int order_errors;
+} ports_t;
+
+static size_t poll_port(void *ctx, uint16_t task, unsigned worker)
+{
+    ports_t *p = (ports_t *)ctx;
+    uint32_t n = p->backlog[task] < BURST ? p->backlog[task] : BURST;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        /* Packets of one port must be processed in arrival order. */
+        if (p->served[task] != p->next_seq[task])
+            p->order_errors++;
+        p->served[task]++;
+        p->next_seq[task]++;
+    }
+
+    p->backlog[task] -= n;
+    p->last_worker[task] = worker;
+    return n;
+}
+
+/* Every task is in exactly one run queue between bursts. */
+static uint32_t queued_tasks(const sw_sched_t *s)
+{
+    uint32_t total = 0;
+    for (unsigned w = 0; w < s->num_workers; w++)
+        total += s->workers[w].bottom - s->workers[w].top;
+    return total;
+}
+
+/* Drain the backlog, always stepping the worker that is furthest behind in
+ * time. A burst costs one unit per packet plus one for the poll itself, so
+ * idle polls are cheap, as on a real receive ring. Returns the makespan. */
+static unsigned drain(sw_sched_t *s, ports_t *p)
+{
+    unsigned clock[4] = {0};
+    for (;;)
+    {
+        uint32_t left = 0;
+        for (unsigned t = 0; t < NUM_TASKS; t++)
+            left += p->backlog[t];
+        if (left == 0)
+            break;
+
+        unsigned w = 0;
+        for (unsigned i = 1; i < s->num_workers; i++)
+        {
+            if (clock[i] < clock[w])
+                w = i;
+        }
+        clock[w] += 1u + (unsigned)sw_sched_run_once(s, w);
+    }
+
+    unsigned makespan = 0;
+    for (unsigned i = 0; i < s->num_workers; i++)
+    {
+        if (clock[i] > makespan)
+            makespan = clock[i];
+    }
+    return makespan;
+}
+
+static int test_sched_init_validation(void)
+{
+    sw_sched_t s;
+    sw_sched_worker_t workers[2];
+    ports_t p;
+    memset(&p, 0, sizeof(p));
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sched_init(NULL, workers, 2, 4, poll_port, &p, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sched_init(&s, NULL, 2, 4, poll_port, &p, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sched_init(&s, workers, 0, 4, poll_port, &p, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sched_init(&s, workers, 2, 0, poll_port, &p, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM,
+                  sw_sched_init(&s, workers, 2, SW_SCHED_MAX_TASKS + 1u, poll_port, &p, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sched_init(&s, workers, 2, 4, NULL, &p, 0));
+
+    ASSERT_EQ_INT(SW_OK, sw_sched_init(&s, workers, 2, 4, poll_port, &p, 0));
+    ASSERT_EQ_INT(2, (int)(workers[0].bottom - workers[0].top)); /* tasks 0, 2 */
+    ASSERT_EQ_INT(2, (int)(workers[1].bottom - workers[1].top)); /* tasks 1, 3 */
+
+    ASSERT_EQ_INT(0, (int)sw_sched_run_once(&s, 2)); /* no such worker */
+    ASSERT_EQ_INT(0, (int)sw_sched_run_once(NULL, 0));
+    return 0;
+}
+
+/* With static placement the heavy ports stay on their home worker. */
+static int test_sched_static_pinning(void)
+{
+    sw_sched_t s;
+    sw_sched_worker_t workers[2];
+    ports_t p;
+    memset(&p, 0, sizeof(p));
+    p.backlog[0] = 400; /* both heavy ports are homed on worker 0 */
+    p.backlog[2] = 400;
+
+    ASSERT_EQ_INT(SW_OK, sw_sched_init(&s, workers, 2, NUM_TASKS, poll_port, &p, SW_SCHED_STATIC));
+    const unsigned makespan = drain(&s, &p);
+
+    ASSERT_EQ_INT(0, (int)workers[1].packets);
+    ASSERT_EQ_INT(800, (int)workers[0].packets);
+    ASSERT_EQ_INT(0, (int)(workers[0].steals + workers[1].steals));
+    ASSERT_TRUE(makespan >= 800); /* one worker carries all 800 packets */
+    ASSERT_EQ_INT(NUM_TASKS, (int)queued_tasks(&s));
+    return 0;
+}
+
+/* An idle worker steals one of the heavy ports, halving the drain time. */
+static int test_sched_work_stealing(void)
+{
+    sw_sched_t s;
+    sw_sched_worker_t workers[2];
+    ports_t p;
+    memset(&p, 0, sizeof(p));
+    p.backlog[0] = 400;
+    p.backlog[2] = 400;
+
+    ASSERT_EQ_INT(SW_OK, sw_sched_init(&s, workers, 2, NUM_TASKS, poll_port, &p, 0));
+    const unsigned makespan = drain(&s, &p);
+
+    ASSERT_TRUE(workers[1].steals > 0);
+    ASSERT_TRUE(workers[1].packets > 0);
+    ASSERT_EQ_INT(800, (int)(workers[0].packets + workers[1].packets));
+    ASSERT_TRUE(makespan < 600); /* static pinning needs over 800 */
+    ASSERT_EQ_INT(0, p.order_errors);
+    ASSERT_EQ_INT(400, (int)p.served[0]);
+    ASSERT_EQ_INT(400, (int)p.served[2]);
+    ASSERT_EQ_INT(NUM_TASKS, (int)queued_tasks(&s));
+    return 0;
+}
+
+/* A single worker serves all its ports round-robin. */
+static int test_sched_round_robin(void)
+{
+    sw_sched_t s;
+    sw_sched_worker_t workers[1];
+    ports_t p;
+    memset(&p, 0, sizeof(p));
+    for (unsigned t = 0; t < NUM_TASKS; t++)
+        p.backlog[t] = 100;
+
+    ASSERT_EQ_INT(SW_OK, sw_sched_init(&s, workers, 1, NUM_TASKS, poll_port, &p, 0));
+    for (unsigned i = 0; i < NUM_TASKS; i++)
+        ASSERT_EQ_INT(BURST, (int)sw_sched_run_once(&s, 0));
+
+    for (unsigned t = 0; t < NUM_TASKS; t++)
+        ASSERT_EQ_INT(BURST, (int)p.served[t]);
+
+    ASSERT_EQ_INT(0, (int)workers[0].steals); /* nobody to steal from */
+    return 0;
+}
+
+test_result_t test_spacewire_sched_run_all(void)
+{
+    RUN_TEST(test_sched_init_validation);
+    RUN_TEST(test_sched_static_pinning);
+    RUN_TEST(test_sched_work_stealing);
+    RUN_TEST(test_sched_round_robin);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
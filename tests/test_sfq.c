@@ -0,0 +1,241 @@
+/**
+ * @file test_sfq.c
+ * @brief Unit tests for the store-and-forward queue.
+ */
+#include "cunit.h"
+#include "spacewire_sfq.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define LOG_SIZE 8192u
+#define REGION (SW_SFQ_META_SIZE + LOG_SIZE)
+
+static uint64_t g_region[REGION / 8u];
+static uint64_t g_copy[REGION / 8u];
+
+/* Packet @p id of @p len octets, recognisable on the way out. */
+static void make_packet(uint8_t *pkt, uint32_t len, uint32_t id)
+{
+    for (uint32_t i = 0; i < len; i++)
+        pkt[i] = (uint8_t)(id * 31u + i);
+}
+
+static int check_packet(const uint8_t *pkt, uint32_t len, uint32_t id)
+{
+    for (uint32_t i = 0; i < len; i++)
+        if (pkt[i] != (uint8_t)(id * 31u + i))
+            return 0;
+    return 1;
+}
+
+/* Pop one packet and check it is @p id of @p len octets at @p priority. */
+static int pop_expect(sw_sfq_t *q, uint32_t id, uint32_t len, uint8_t priority)
+{
+    const uint8_t *pkt;
+    uint32_t got_len;
+    uint8_t got_priority;
+
+    ASSERT_EQ_INT(SW_OK, sw_sfq_peek(q, &pkt, &got_len, &got_priority));
+    ASSERT_EQ_INT((int)len, (int)got_len);
+    ASSERT_EQ_INT(priority, got_priority);
+    ASSERT_TRUE(check_packet(pkt, len, id));
+    ASSERT_EQ_INT(SW_OK, sw_sfq_pop(q));
+    return 0;
+}
+
+static int test_sfq_priority(void)
+{
+    sw_sfq_t q;
+    uint8_t pkt[300];
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sfq_format(&q, g_region, SW_SFQ_META_SIZE + 100u));
+    ASSERT_EQ_INT(SW_OK, sw_sfq_format(&q, g_region, sizeof(g_region)));
+    ASSERT_TRUE(q.data_size == LOG_SIZE);
+    ASSERT_EQ_INT(SW_ERR, sw_sfq_pop(&q));
+
+    /* Interleaved priorities come out by priority, FIFO within one. */
+    static const uint8_t prio[8] = {3, 1, 3, 0, 1, 2, 0, 3};
+    for (uint32_t id = 0; id < 8u; id++)
+    {
+        make_packet(pkt, 10u + id, id);
+        ASSERT_EQ_INT(SW_OK, sw_sfq_push(&q, prio[id], pkt, 10u + id));
+    }
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sfq_push(&q, SW_SFQ_PRIORITIES, pkt, 10));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sfq_push(&q, 0, pkt, 0));
+    ASSERT_EQ_INT(2, (int)q.pending[0]);
+
+    static const uint32_t order[8] = {3, 6, 1, 4, 5, 0, 2, 7};
+    for (unsigned i = 0; i < 8u; i++)
+        ASSERT_EQ_INT(0, pop_expect(&q, order[i], 10u + order[i], prio[order[i]]));
+    ASSERT_TRUE(sw_sfq_used(&q) > 0); /* freed by the next commit */
+    ASSERT_EQ_INT(SW_OK, sw_sfq_commit(&q));
+    ASSERT_TRUE(sw_sfq_used(&q) == 0);
+    ASSERT_TRUE(q.spilled == 8 && q.forwarded == 8);
+    return 0;
+}
+
+static int send_some(void *ctx, uint8_t priority, const uint8_t *pkt, uint32_t len)
+{
+    unsigned *budget = ctx;
+    (void)priority;
+    (void)pkt;
+    (void)len;
+    if (*budget == 0)
+        return 1;
+    (*budget)--;
+    return 0;
+}
+
+/* Space is reused around the end of the log; a full log refuses packets. */
+static int test_sfq_wrap(void)
+{
+    sw_sfq_t q;
+    uint8_t pkt[1000];
+    uint32_t in = 0;
+    uint32_t out = 0;
+
+    ASSERT_EQ_INT(SW_OK, sw_sfq_format(&q, g_region, sizeof(g_region)));
+
+    for (unsigned round = 0; round < 200u; round++)
+    {
+        /* Fill until refused, then drain a part: lengths vary, so records
+         * meet the end of the log at every offset. */
+        for (;;)
+        {
+            const uint32_t len = 1u + (in * 37u) % 700u;
+            make_packet(pkt, len, in);
+            if (sw_sfq_push(&q, 0, pkt, len) != SW_OK)
+                break;
+            in++;
+        }
+        ASSERT_TRUE(sw_sfq_used(&q) <= LOG_SIZE);
+        ASSERT_TRUE(q.rejected == round + 1u);
+
+        const uint32_t n = 1u + round % 5u;
+        for (uint32_t k = 0; k < n && out < in; k++, out++)
+            ASSERT_EQ_INT(0, pop_expect(&q, out, 1u + (out * 37u) % 700u, 0));
+        ASSERT_EQ_INT(SW_OK, sw_sfq_commit(&q));
+    }
+    ASSERT_TRUE(q.head > 4u * LOG_SIZE);
+
+    unsigned budget = 3;
+    ASSERT_EQ_INT(3, (int)sw_sfq_drain(&q, send_some, &budget, 100));
+    out += 3;
+    budget = 1000;
+    ASSERT_EQ_INT((int)(in - out), (int)sw_sfq_drain(&q, send_some, &budget, 100000));
+    ASSERT_EQ_INT(SW_ERR, sw_sfq_pop(&q));
+    return 0;
+}
+
+/* Reopen after clean commits, after a crash, and with a torn record. */
+static int test_sfq_recovery(void)
+{
+    sw_sfq_t q;
+    sw_sfq_t r;
+    uint8_t pkt[200];
+
+    ASSERT_EQ_INT(SW_OK, sw_sfq_format(&q, g_region, sizeof(g_region)));
+    for (uint32_t id = 0; id < 10u; id++)
+    {
+        make_packet(pkt, 100, id);
+        ASSERT_EQ_INT(SW_OK, sw_sfq_push(&q, (uint8_t)(id % 2u), pkt, 100));
+    }
+    ASSERT_EQ_INT(0, pop_expect(&q, 0, 100, 0));
+    ASSERT_EQ_INT(0, pop_expect(&q, 2, 100, 0));
+    ASSERT_EQ_INT(SW_OK, sw_sfq_commit(&q));
+
+    /* After the commit: one more forwarded, two more spilled. */
+    ASSERT_EQ_INT(0, pop_expect(&q, 4, 100, 0));
+    for (uint32_t id = 10; id < 12u; id++)
+    {
+        make_packet(pkt, 100, id);
+        ASSERT_EQ_INT(SW_OK, sw_sfq_push(&q, 0, pkt, 100));
+    }
+
+    /* Crash: the packets appended after the commit survive; the one
+     * forwarded after it comes again (at least once). */
+    memcpy(g_copy, g_region, sizeof(g_region));
+    ASSERT_EQ_INT(SW_OK, sw_sfq_open(&r, g_copy, sizeof(g_copy)));
+    ASSERT_TRUE(r.head == q.head);
+    ASSERT_EQ_INT(5, (int)r.pending[0]);
+    ASSERT_EQ_INT(5, (int)r.pending[1]);
+    static const uint32_t order[10] = {4, 6, 8, 10, 11, 1, 3, 5, 7, 9};
+    for (unsigned i = 0; i < 10u; i++)
+        ASSERT_EQ_INT(0, pop_expect(&r, order[i], 100, order[i] < 10u ? order[i] % 2u : 0));
+
+    /* A torn last record is dropped. */
+    memcpy(g_copy, g_region, sizeof(g_region));
+    ((uint8_t *)g_copy)[SW_SFQ_META_SIZE + (q.head - 10u) % LOG_SIZE] ^= 0xFFu;
+    ASSERT_EQ_INT(SW_OK, sw_sfq_open(&r, g_copy, sizeof(g_copy)));
+    ASSERT_EQ_INT(4, (int)r.pending[0]);
+    ASSERT_TRUE(r.head < q.head);
+
+    /* A torn newest superblock: the older one is used. */
+    ASSERT_EQ_INT(SW_OK, sw_sfq_commit(&q));
+    memcpy(g_copy, g_region, sizeof(g_region));
+    ((uint8_t *)g_copy)[(q.generation % 2u) * SW_SFQ_META_SLOT + 24u] ^= 0x01u;
+    ASSERT_EQ_INT(SW_OK, sw_sfq_open(&r, g_copy, sizeof(g_copy)));
+    ASSERT_TRUE(r.generation == q.generation - 1u);
+    ASSERT_TRUE(r.head == q.head);
+    ASSERT_EQ_INT(5, (int)r.pending[0]);
+
+    /* Neither superblock valid. */
+    memset(g_copy, 0, SW_SFQ_META_SIZE);
+    ASSERT_EQ_INT(SW_ERR, sw_sfq_open(&r, g_copy, sizeof(g_copy)));
+    return 0;
+}
+
+/* Space of records popped after the last commit is not reused before the
+ * next one: a reopen still finds every packet from the committed tail. */
+static int test_sfq_reuse_after_commit(void)
+{
+    sw_sfq_t q;
+    sw_sfq_t r;
+    uint8_t pkt[400];
+    uint32_t in = 0;
+
+    ASSERT_EQ_INT(SW_OK, sw_sfq_format(&q, g_region, sizeof(g_region)));
+    for (;;)
+    {
+        make_packet(pkt, 400, in);
+        if (sw_sfq_push(&q, 0, pkt, 400) != SW_OK)
+            break;
+        in++;
+    }
+    ASSERT_TRUE(in > 3u);
+    ASSERT_EQ_INT(SW_OK, sw_sfq_commit(&q));
+
+    for (uint32_t id = 0; id < 3u; id++)
+        ASSERT_EQ_INT(0, pop_expect(&q, id, 400, 0));
+    make_packet(pkt, 400, in);
+    ASSERT_EQ_INT(SW_ERR, sw_sfq_push(&q, 0, pkt, 400));
+
+    memcpy(g_copy, g_region, sizeof(g_region));
+    ASSERT_EQ_INT(SW_OK, sw_sfq_open(&r, g_copy, sizeof(g_copy)));
+    ASSERT_EQ_INT((int)in, (int)r.pending[0]);
+    ASSERT_EQ_INT(0, pop_expect(&r, 0, 400, 0));
+
+    /* Once the pops are committed their space takes new packets. */
+    ASSERT_EQ_INT(SW_OK, sw_sfq_commit(&q));
+    for (uint32_t k = 0; k < 3u; k++, in++)
+    {
+        make_packet(pkt, 400, in);
+        ASSERT_EQ_INT(SW_OK, sw_sfq_push(&q, 0, pkt, 400));
+    }
+    memcpy(g_copy, g_region, sizeof(g_region));
+    ASSERT_EQ_INT(SW_OK, sw_sfq_open(&r, g_copy, sizeof(g_copy)));
+    ASSERT_EQ_INT((int)(in - 3u), (int)r.pending[0]);
+    for (uint32_t id = 3; id < in; id++)
+        ASSERT_EQ_INT(0, pop_expect(&r, id, 400, 0));
+    return 0;
+}
+
+test_result_t test_spacewire_sfq_run_all(void)
+{
+    RUN_TEST(test_sfq_priority);
+    RUN_TEST(test_sfq_wrap);
+    RUN_TEST(test_sfq_recovery);
+    RUN_TEST(test_sfq_reuse_after_commit);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
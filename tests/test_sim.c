@@ -0,0 +1,175 @@
+/**
+ * @file test_sim.c
+ * @brief Unit tests for the network simulator and link-failure trials.
+ */
+#include "cunit.h"
+#include "spacewire_sim.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define NODES 5u
+#define EVENTS 256u
+
+typedef struct
+{
+    sw_net_t net;
+    sw_net_node_t nodes[NODES];
+    sw_net_link_t links[8];
+    uint64_t dist[NODES];
+    uint16_t heap[NODES];
+    uint16_t pos[NODES];
+    uint8_t tables[2 * NODES * SW_ROUTE_TABLE_SIZE];
+    sw_sim_t sim;
+    sw_sim_node_t sim_nodes[NODES];
+    sw_sim_event_t events[EVENTS];
+} fixture_t;
+
+/*
+ * Terminal 0x40 (n0) and terminal 0x41 (n4) joined by two paths, n1-n2
+ * (link 1) being the shorter:
+ *
+ *   n0 -1-1- n1 -2-1- n2 -2-1- n4
+ *             3       3
+ *             |       |
+ *             1- n3 -2
+ */
+static int setup(fixture_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    ASSERT_EQ_INT(SW_OK, sw_net_init(&f->net, f->nodes, NODES, f->links, 8));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 2, 0x40, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 4, 0, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 4, 0, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 3, 0, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_add_node(&f->net, 2, 0x41, NULL));
+
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(&f->net, 0, 1, 1, 1, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(&f->net, 1, 2, 2, 1, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(&f->net, 1, 3, 3, 1, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(&f->net, 3, 2, 2, 3, 100000000, 100, NULL));
+    ASSERT_EQ_INT(SW_OK, sw_net_connect(&f->net, 2, 2, 4, 1, 100000000, 100, NULL));
+
+    const sw_net_work_t work = {.dist = f->dist, .heap = f->heap, .pos = f->pos};
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&f->net, &work, f->tables));
+    ASSERT_EQ_INT(SW_OK, sw_net_install_routes(&f->net, f->tables));
+    ASSERT_EQ_INT(SW_OK, sw_sim_init(&f->sim, &f->net, f->sim_nodes, f->events, EVENTS, 1));
+    return 0;
+}
+
+/* Three unloaded store-and-forward hops of 16 octets at 100 Mbit/s, 100 ns
+ * latency each: 3 * (1600 + 100) ns. */
+static int test_sim_delivery(void)
+{
+    static fixture_t f;
+    ASSERT_EQ_INT(0, setup(&f));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sim_set_traffic(&f.sim, 0, 0, 16));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sim_set_traffic(&f.sim, NODES, 1000, 16));
+    ASSERT_EQ_INT(SW_OK, sw_sim_set_traffic(&f.sim, 0, 100000, 16));
+
+    ASSERT_TRUE(sw_sim_run(&f.sim, 10000000) > 0);
+    ASSERT_EQ_INT(10000000, (int)f.sim.now);
+
+    sw_sim_stats_t st;
+    sw_sim_get_stats(&f.sim, &st);
+    ASSERT_TRUE(st.generated >= 90 && st.generated <= 110);
+    ASSERT_TRUE(st.delivered + 1u >= st.generated);
+    ASSERT_EQ_INT(0, (int)(st.lost_link + st.lost_no_route + st.lost_hops));
+    ASSERT_EQ_INT(5100, (int)st.latency_max_ns);
+    ASSERT_TRUE(st.latency_sum_ns == 5100u * st.delivered);
+    ASSERT_EQ_INT((int)st.delivered, (int)f.sim_nodes[4].stats.delivered);
+    ASSERT_EQ_INT((int)st.delivered, (int)f.nodes[4].router.links[1].rx_packets);
+    ASSERT_EQ_INT(0, (int)f.nodes[3].router.links[1].rx_packets);
+    return 0;
+}
+
+/* A dead port loses traffic until the routes are changed. */
+static int test_sim_link_down_and_install(void)
+{
+    static fixture_t f;
+    ASSERT_EQ_INT(0, setup(&f));
+    ASSERT_EQ_INT(SW_OK, sw_sim_set_traffic(&f.sim, 0, 10000, 16));
+    ASSERT_EQ_INT(SW_OK, sw_sim_schedule_link(&f.sim, 1, 100000, 0));
+
+    f.links[1].up = 0;
+    const sw_net_work_t work = {.dist = f.dist, .heap = f.heap, .pos = f.pos};
+    uint8_t *after = &f.tables[NODES * SW_ROUTE_TABLE_SIZE];
+    ASSERT_EQ_INT(SW_OK, sw_net_compute_routes(&f.net, &work, after));
+
+    uint16_t t = 0;
+    ASSERT_EQ_INT(SW_OK, sw_sim_add_table(&f.sim, after, &t));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sim_schedule_install(&f.sim, 1, 200000, 1));
+    ASSERT_EQ_INT(SW_OK, sw_sim_schedule_install(&f.sim, 1, 200000, t));
+
+    sw_sim_run(&f.sim, 200000);
+    sw_sim_stats_t st;
+    sw_sim_get_stats(&f.sim, &st);
+    ASSERT_TRUE(st.lost_link >= 5);
+    ASSERT_EQ_INT(SW_LINK_ERROR, f.nodes[2].router.links[1].state);
+    ASSERT_TRUE(f.nodes[1].router.links[2].errors == st.lost_link);
+
+    /* After the install no more packets are lost. */
+    const uint32_t lost = st.lost_link;
+    sw_sim_run(&f.sim, 1000000);
+    sw_sim_get_stats(&f.sim, &st);
+    ASSERT_EQ_INT((int)lost, (int)st.lost_link);
+    ASSERT_TRUE(st.last_loss_ns < 200000);
+    ASSERT_TRUE(f.nodes[3].router.links[1].rx_packets > 70);
+    return 0;
+}
+
+static int test_sim_failure_trial(void)
+{
+    static fixture_t f;
+    ASSERT_EQ_INT(0, setup(&f));
+    const sw_net_work_t work = {.dist = f.dist, .heap = f.heap, .pos = f.pos};
+
+    sw_sim_failure_cfg_t cfg = {.seed = 7,
+                                .link = 1,
+                                .packet_len = 16,
+                                .interval_ns = 2000,
+                                .warmup_ns = 100000,
+                                .duration_ns = 400000,
+                                .detect_ns = 5000,
+                                .install_spread_ns = 5000};
+    sw_sim_failure_result_t r1;
+    sw_sim_failure_result_t r2;
+    ASSERT_EQ_INT(SW_OK, sw_sim_link_failure_trial(&f.sim, &cfg, &work, f.tables, &r1));
+
+    ASSERT_EQ_INT(1, r1.link);
+    ASSERT_EQ_INT(2, r1.routers_updated); /* n1 and n2 */
+    ASSERT_EQ_INT(0, (int)r1.unreachable);
+    ASSERT_TRUE(r1.convergence_ns >= 5000 && r1.convergence_ns <= 10000);
+    ASSERT_TRUE(r1.lost > 0);
+    ASSERT_EQ_INT(0, (int)(r1.stats.lost_no_route + r1.stats.lost_hops));
+    ASSERT_TRUE(r1.disruption_ns > 0 && r1.disruption_ns <= r1.convergence_ns);
+    ASSERT_TRUE(r1.delivered > 400);
+    ASSERT_EQ_INT(1, f.links[1].up); /* network left intact */
+
+    /* Same seed, same outcome. */
+    ASSERT_EQ_INT(SW_OK, sw_sim_link_failure_trial(&f.sim, &cfg, &work, f.tables, &r2));
+    ASSERT_EQ_MEM(&r1, &r2, sizeof(r1));
+
+    /* Cutting off a terminal makes its address unreachable from the other
+     * four nodes, and the terminal loses the one address it could reach. */
+    cfg.link = 0;
+    ASSERT_EQ_INT(SW_OK, sw_sim_link_failure_trial(&f.sim, &cfg, &work, f.tables, &r1));
+    ASSERT_EQ_INT(5, (int)r1.unreachable);
+    ASSERT_TRUE(r1.stats.lost_no_route > 0);
+
+    cfg.link = SW_NET_NONE;
+    ASSERT_EQ_INT(SW_OK, sw_sim_link_failure_trial(&f.sim, &cfg, &work, f.tables, &r1));
+    ASSERT_TRUE(r1.link < 5);
+
+    cfg.link = 9;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_sim_link_failure_trial(&f.sim, &cfg, &work, f.tables, &r1));
+    return 0;
+}
+
+test_result_t test_spacewire_sim_run_all(void)
+{
+    RUN_TEST(test_sim_delivery);
+    RUN_TEST(test_sim_link_down_and_install);
+    RUN_TEST(test_sim_failure_trial);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
@@ -0,0 +1,281 @@
+/**
+ * @file test_spfi.c
+ * @brief Unit tests for the SpaceFibre virtual-channel layer model.
+ */
+#include "cunit.h"
+#include "spacewire_spfi.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define SLOTS 64u
+#define MAX_PKT 1200u
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t lens[SLOTS];
+    uint8_t vcs[SLOTS];
+    uint8_t ends[SLOTS];
+    int corrupt; /* a delivered packet did not match its pattern */
+} received_t;
+
+static uint8_t g_pkts[SLOTS][MAX_PKT];
+
+static void fill_packet(uint8_t *pkt, uint32_t len, uint32_t id)
+{
+    for (uint32_t i = 0; i < len; i++)
+        pkt[i] = (uint8_t)(id * 7u + i);
+}
+
+static void on_packet(void *ctx, uint8_t vc, const uint8_t *pkt, uint32_t len, sw_end_marker_t end)
+{
+    received_t *r = ctx;
+    const uint32_t id = r->count;
+
+    for (uint32_t i = 0; i < len; i++)
+        r->corrupt |= pkt[i] != (uint8_t)(id * 7u + i);
+
+    r->lens[id] = len;
+    r->vcs[id] = vc;
+    r->ends[id] = (uint8_t)end;
+    r->count++;
+}
+
+/* Send every frame the transmitter will build to the receiver, returning
+ * one FCT per frame as the link would. */
+static uint32_t run_link(sw_spfi_tx_t *tx, sw_spfi_rx_t *rx)
+{
+    sw_spfi_frame_t frame;
+    uint32_t frames = 0;
+
+    while (sw_spfi_tx_next_frame(tx, &frame) == SW_OK)
+    {
+        if (sw_spfi_rx_frame(rx, &frame) != SW_OK)
+            return 0;
+        sw_spfi_tx_fct(tx, frame.vc, 1);
+        frames++;
+    }
+    return frames;
+}
+
+/* Packets of every length around the frame size survive packing, in order. */
+static int test_spfi_packing(void)
+{
+    sw_spfi_tx_t tx;
+    sw_spfi_rx_t rx;
+    sw_ring_t ring;
+    sw_desc_t slots[SLOTS];
+    static uint8_t rx_buf[MAX_PKT];
+    received_t got = {0};
+
+    const sw_spfi_vc_config_t config = {.priority = 0, .bandwidth = 100};
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_init(&tx));
+    ASSERT_EQ_INT(SW_OK, sw_ring_init(&ring, slots, SLOTS));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_add_vc(&tx, 3, &config, &ring));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_spfi_tx_add_vc(&tx, 32, &config, &ring));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_spfi_tx_add_vc(&tx, 4, &config, &ring));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_map(&tx, 0x21, 3));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_spfi_tx_map(&tx, 0x22, 4));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_fct(&tx, 3, 4));
+
+    ASSERT_EQ_INT(SW_OK, sw_spfi_rx_init(&rx, on_packet, &got));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_rx_add_vc(&rx, 3, rx_buf, sizeof(rx_buf)));
+
+    /* Lengths 0..3 past one and two frames' worth; the last packet has EEP. */
+    static const uint32_t lens[] = {
+        1, 2, 3, 4, 5, 251, 252, 253, 255, 256, 257, 511, 512, 513, 0, 1100};
+    const uint32_t n = sizeof(lens) / sizeof(lens[0]);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        fill_packet(g_pkts[i], lens[i], i);
+        sw_desc_t d = {.end = (uint8_t)(i + 1u == n ? SW_END_EEP : SW_END_EOP)};
+        /* Short packets go inline, and their buffer is reused at once. */
+        if (sw_desc_set_packet(&d, g_pkts[i], lens[i]))
+            memset(g_pkts[i], 0xEE, lens[i]);
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 0x21, &d));
+    }
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_spfi_tx_enqueue(&tx, 0x22, (const sw_desc_t *)slots));
+
+    const uint32_t frames = run_link(&tx, &rx);
+    ASSERT_TRUE(frames > 0);
+    ASSERT_EQ_INT((int)n, (int)got.count);
+    ASSERT_EQ_INT(0, got.corrupt);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ASSERT_EQ_INT((int)lens[i], (int)got.lens[i]);
+        ASSERT_EQ_INT(3, got.vcs[i]);
+    }
+    ASSERT_EQ_INT(SW_END_EEP, got.ends[n - 1u]);
+    ASSERT_EQ_INT(SW_END_EOP, got.ends[0]);
+
+    /* Every frame but the last is full; words add up. */
+    ASSERT_TRUE(tx.vc[3].frames == frames && tx.vc[3].packets == n);
+    ASSERT_TRUE(tx.words == tx.vc[3].words);
+    ASSERT_EQ_INT((int)frames, (int)rx.frames);
+    ASSERT_TRUE(rx.seq_errors == 0);
+    return 0;
+}
+
+/* Without credit nothing is sent; each FCT releases one frame. */
+static int test_spfi_flow_control(void)
+{
+    sw_spfi_tx_t tx;
+    sw_ring_t ring;
+    sw_desc_t slots[SLOTS];
+    sw_spfi_frame_t frame;
+
+    const sw_spfi_vc_config_t config = {.priority = 1, .bandwidth = 50};
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_init(&tx));
+    ASSERT_EQ_INT(SW_OK, sw_ring_init(&ring, slots, SLOTS));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_add_vc(&tx, 0, &config, &ring));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_map(&tx, 0, 0));
+
+    fill_packet(g_pkts[0], 1000, 0);
+    const sw_desc_t d = {.data = g_pkts[0], .len = 1000, .end = SW_END_EOP};
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 0, &d));
+
+    ASSERT_EQ_INT(SW_ERR, sw_spfi_tx_next_frame(&tx, &frame));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_fct(&tx, 0, 2));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_next_frame(&tx, &frame));
+    ASSERT_EQ_INT((int)SW_SPFI_FRAME_DATA, frame.len);
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_next_frame(&tx, &frame));
+    ASSERT_EQ_INT(1, frame.seq);
+    ASSERT_EQ_INT(SW_ERR, sw_spfi_tx_next_frame(&tx, &frame));
+
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_fct(&tx, 0, 5));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_next_frame(&tx, &frame));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_next_frame(&tx, &frame));
+
+    /* 1000 octets + EOP + 3 FILL = 1004 symbols: three full frames and 236. */
+    ASSERT_EQ_INT(236, frame.len);
+    ASSERT_EQ_INT(SW_SPFI_EOP, frame.data[232]);
+    ASSERT_EQ_INT(SW_SPFI_FILL, frame.data[235]);
+    ASSERT_EQ_INT(SW_ERR, sw_spfi_tx_next_frame(&tx, &frame));
+    ASSERT_EQ_INT(3, (int)tx.vc[0].credits);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_spfi_tx_fct(&tx, 1, 1));
+    return 0;
+}
+
+/* Saturated VCs of one priority share the lane by reservation; a higher
+ * priority VC goes first. */
+static int test_spfi_bandwidth(void)
+{
+    sw_spfi_tx_t tx;
+    sw_ring_t rings[3];
+    static sw_desc_t slots[3][SLOTS];
+    sw_spfi_frame_t frame;
+    static uint8_t big[MAX_PKT];
+
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_init(&tx));
+    static const sw_spfi_vc_config_t configs[3] = {{.priority = 2, .bandwidth = 60},
+                                                   {.priority = 2, .bandwidth = 20},
+                                                   {.priority = 1, .bandwidth = 20}};
+    for (uint8_t v = 0; v < 3; v++)
+    {
+        ASSERT_EQ_INT(SW_OK, sw_ring_init(&rings[v], slots[v], SLOTS));
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_add_vc(&tx, v, &configs[v], &rings[v]));
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_map(&tx, v, v));
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_fct(&tx, v, 1000000));
+    }
+    const sw_spfi_vc_config_t over = {.priority = 0, .bandwidth = 1};
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_spfi_tx_add_vc(&tx, 5, &over, &rings[0]));
+
+    /* VC 2 (priority 1) has a few packets: they all go first. */
+    const sw_desc_t d = {.data = big, .len = MAX_PKT, .end = SW_END_EOP};
+    for (int i = 0; i < 3; i++)
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 2, &d));
+    for (int i = 0; i < 10; i++)
+    {
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 0, &d));
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 1, &d));
+    }
+    for (int i = 0; i < 15; i++)
+    {
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_next_frame(&tx, &frame));
+        ASSERT_EQ_INT(2, frame.vc);
+    }
+
+    /* VCs 0 and 1 stay saturated: they share the lane's words 60:20. */
+    const uint64_t words0 = tx.vc[0].words;
+    const uint64_t words1 = tx.vc[1].words;
+    for (int i = 0; i < 4000; i++)
+    {
+        if (sw_ring_count(&rings[0]) < 4u)
+            ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 0, &d));
+        if (sw_ring_count(&rings[1]) < 4u)
+            ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 1, &d));
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_next_frame(&tx, &frame));
+        ASSERT_TRUE(frame.vc < 2u);
+    }
+    const uint64_t share0 = tx.vc[0].words - words0;
+    const uint64_t share1 = tx.vc[1].words - words1;
+    ASSERT_TRUE(share0 > 2.95 * (double)share1 && share0 < 3.05 * (double)share1);
+    return 0;
+}
+
+/* Corrupted frames are dropped; sequence gaps are counted. */
+static int test_spfi_errors(void)
+{
+    sw_spfi_tx_t tx;
+    sw_spfi_rx_t rx;
+    sw_ring_t ring;
+    sw_desc_t slots[SLOTS];
+    sw_spfi_frame_t frame;
+    static uint8_t rx_buf[64];
+    received_t got = {0};
+
+    const sw_spfi_vc_config_t config = {.priority = 0, .bandwidth = 0};
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_init(&tx));
+    ASSERT_EQ_INT(SW_OK, sw_ring_init(&ring, slots, SLOTS));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_add_vc(&tx, 1, &config, &ring));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_map(&tx, 9, 1));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_fct(&tx, 1, 100));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_rx_init(&rx, on_packet, &got));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_rx_add_vc(&rx, 1, rx_buf, sizeof(rx_buf)));
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        fill_packet(g_pkts[i], 40, i);
+        const sw_desc_t d = {.data = g_pkts[i], .len = 40, .end = SW_END_EOP};
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 9, &d));
+        ASSERT_EQ_INT(SW_OK, sw_spfi_tx_next_frame(&tx, &frame));
+
+        if (i == 1)
+        {
+            /* Flip a bit: dropped. The next frame then shows a gap. */
+            frame.data[5] ^= 0x10u;
+            ASSERT_EQ_INT(SW_ERR, sw_spfi_rx_frame(&rx, &frame));
+            got.count++;
+            continue;
+        }
+        ASSERT_EQ_INT(SW_OK, sw_spfi_rx_frame(&rx, &frame));
+    }
+    ASSERT_EQ_INT(3, (int)got.count);
+    ASSERT_EQ_INT(0, got.corrupt);
+    ASSERT_TRUE(rx.crc_errors == 1 && rx.seq_errors == 1 && rx.frames == 2);
+
+    /* A packet longer than the reassembly buffer is discarded whole. */
+    fill_packet(g_pkts[3], 100, 3);
+    const sw_desc_t d = {.data = g_pkts[3], .len = 100, .end = SW_END_EOP};
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_enqueue(&tx, 9, &d));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_tx_next_frame(&tx, &frame));
+    ASSERT_EQ_INT(SW_OK, sw_spfi_rx_frame(&rx, &frame));
+    ASSERT_EQ_INT(3, (int)got.count);
+    ASSERT_TRUE(rx.vc[1].dropped == 1);
+
+    /* A frame for a VC the receiver does not have. */
+    frame.vc = 2;
+    frame.crc = sw_spfi_frame_crc(&frame);
+    ASSERT_EQ_INT(SW_ERR, sw_spfi_rx_frame(&rx, &frame));
+    return 0;
+}
+
+test_result_t test_spacewire_spfi_run_all(void)
+{
+    RUN_TEST(test_spfi_packing);
+    RUN_TEST(test_spfi_flow_control);
+    RUN_TEST(test_spfi_bandwidth);
+    RUN_TEST(test_spfi_errors);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
@@ -0,0 +1,264 @@
+/**
+ * @file test_tf.c
+ * @brief Unit tests for the TM/AOS transfer-frame multiplexer.
+ */
+#include "cunit.h"
+#include "spacewire_tf.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define MAX_FRAMES 16u
+#define MAX_FRAME_LEN 128u
+
+typedef struct
+{
+    uint32_t count;
+    uint8_t vcs[MAX_FRAMES];
+    uint8_t frames[MAX_FRAMES][MAX_FRAME_LEN];
+} captured_t;
+
+static uint8_t g_vc_buf[2][MAX_FRAME_LEN];
+
+static void on_frame(void *ctx, uint8_t vc, const uint8_t *frame, uint16_t len)
+{
+    captured_t *c = ctx;
+    if (c->count < MAX_FRAMES && len <= MAX_FRAME_LEN)
+    {
+        c->vcs[c->count] = vc;
+        memcpy(c->frames[c->count], frame, len);
+    }
+    c->count++;
+}
+
+static uint16_t fhp(const uint8_t *f, uint16_t off)
+{
+    return (uint16_t)(((f[off] & 0x07u) << 8) | f[off + 1u]);
+}
+
+/* Build a packet over SpaceWire, decode it and append the decoded view;
+ * the CCSDS octets are also appended to @p stream. */
+static int put_decoded(sw_tf_mux_t *mux,
+                       uint8_t vc,
+                       uint16_t apid,
+                       uint16_t data_len,
+                       uint8_t *stream,
+                       size_t *n)
+{
+    uint8_t payload[128];
+    uint8_t buf[160];
+    sw_packet_frame_t pf;
+
+    for (uint16_t i = 0; i < data_len; i++)
+        payload[i] = (uint8_t)(apid + i * 3u);
+
+    const size_t len = sw_packet_create(0x42, 0, apid, payload, data_len, buf, sizeof(buf));
+    if (len == 0 || sw_packet_decode(&pf, buf, len, SW_END_EOP, NULL) != SW_OK)
+        return -1;
+
+    memcpy(&stream[*n], &buf[SW_PTP_HEADER_LEN], len - SW_PTP_HEADER_LEN);
+    *n += len - SW_PTP_HEADER_LEN;
+    return sw_tf_put(mux, vc, &pf.packet) == SW_OK ? 0 : -1;
+}
+
+/* Packets span frames; first header pointers, counters and the error
+ * control field are right, and the data fields concatenate to the packets. */
+static int test_tf_tm_spanning(void)
+{
+    static const uint8_t check[] = "123456789";
+    static captured_t got;
+    static uint8_t stream[512];
+    sw_tf_mux_t mux;
+    size_t n = 0;
+
+    /* CRC-16/CCITT-FALSE check value. */
+    ASSERT_EQ_INT(0x29B1, sw_tf_crc(check, 9));
+
+    const sw_tf_config_t config = {.kind = SW_TF_TM, .scid = 0x2AB, .frame_len = 64, .fecf = 1};
+    memset(&got, 0, sizeof(got));
+    ASSERT_EQ_INT(SW_OK, sw_tf_init(&mux, &config, on_frame, &got));
+    ASSERT_EQ_INT(56, mux.data_len);
+    ASSERT_EQ_INT(SW_OK, sw_tf_add_vc(&mux, 3, g_vc_buf[0]));
+
+    /* 16 + 56 + 106 + 9 octets: three full frames and 19 octets. */
+    ASSERT_EQ_INT(0, put_decoded(&mux, 3, 0x101, 10, stream, &n));
+    ASSERT_EQ_INT(0, put_decoded(&mux, 3, 0x102, 50, stream, &n));
+    ASSERT_EQ_INT(0, put_decoded(&mux, 3, 0x103, 100, stream, &n));
+    ASSERT_EQ_INT(0, put_decoded(&mux, 3, 0x104, 3, stream, &n));
+    ASSERT_EQ_INT(3, (int)got.count);
+    ASSERT_EQ_INT(19, mux.vc[3].fill);
+
+    /* The rest of the fourth frame becomes one idle packet. */
+    ASSERT_EQ_INT(SW_OK, sw_tf_flush(&mux, 3));
+    ASSERT_EQ_INT(4, (int)got.count);
+    ASSERT_EQ_INT(37, (int)mux.vc[3].idle_octets);
+    ASSERT_EQ_INT(4, (int)mux.vc[3].packets);
+
+    static const uint16_t want_fhp[] = {0, 16, SW_TF_FHP_NONE, 10};
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        const uint8_t *f = got.frames[i];
+        ASSERT_EQ_INT(3, got.vcs[i]);
+        ASSERT_TRUE(f[0] == 0x2A && f[1] == 0xB6);
+        ASSERT_TRUE(f[2] == i && f[3] == i);
+        ASSERT_EQ_INT(0x18, f[4] & 0xF8);
+        ASSERT_EQ_INT(want_fhp[i], fhp(f, 4));
+        ASSERT_EQ_INT(sw_tf_crc(f, 62), (f[62] << 8) | f[63]);
+        ASSERT_EQ_MEM(&stream[i * 56u], &f[6], i < 3 ? 56 : 19);
+    }
+
+    /* The idle packet: APID 0x7FF, 37 octets, idle data. */
+    const uint8_t *idle = &got.frames[3][6 + 19];
+    ASSERT_TRUE(idle[0] == 0x07 && idle[1] == 0xFF && idle[4] == 0 && idle[5] == 37 - 7);
+    ASSERT_TRUE(idle[6] == SW_TF_IDLE_OCTET && idle[36] == SW_TF_IDLE_OCTET);
+    return 0;
+}
+
+/* Idle filling: a short remainder runs on through a second frame; idle
+ * frames; the master-channel count spans VCs. */
+static int test_tf_idle(void)
+{
+    static captured_t got;
+    static uint8_t stream[256];
+    sw_tf_mux_t mux;
+    size_t n = 0;
+
+    const sw_tf_config_t config = {.kind = SW_TF_TM, .scid = 1, .frame_len = 32, .fecf = 0};
+    memset(&got, 0, sizeof(got));
+    ASSERT_EQ_INT(SW_OK, sw_tf_init(&mux, &config, on_frame, &got));
+    ASSERT_EQ_INT(SW_OK, sw_tf_add_vc(&mux, 0, g_vc_buf[0]));
+    ASSERT_EQ_INT(SW_OK, sw_tf_add_vc(&mux, 7, g_vc_buf[1]));
+
+    /* Nothing to flush. */
+    ASSERT_EQ_INT(SW_OK, sw_tf_flush(&mux, 0));
+    ASSERT_EQ_INT(0, (int)got.count);
+
+    /* 24 of 26 octets: the idle packet takes 2 + 26. */
+    ASSERT_EQ_INT(0, put_decoded(&mux, 0, 0x10, 18, stream, &n));
+    ASSERT_EQ_INT(SW_ERR, sw_tf_idle_frame(&mux, 0));
+    ASSERT_EQ_INT(SW_OK, sw_tf_flush(&mux, 0));
+    ASSERT_EQ_INT(2, (int)got.count);
+    ASSERT_EQ_INT(0, mux.vc[0].fill);
+    ASSERT_EQ_INT(0, fhp(got.frames[0], 4));
+    ASSERT_EQ_INT(SW_TF_FHP_NONE, fhp(got.frames[1], 4));
+    ASSERT_TRUE(got.frames[0][6 + 24] == 0x07 && got.frames[0][6 + 25] == 0xFF);
+    ASSERT_TRUE(got.frames[1][6] == 0xC0 && got.frames[1][8] == 0 && got.frames[1][9] == 28 - 7);
+    ASSERT_TRUE(got.frames[1][10] == SW_TF_IDLE_OCTET && got.frames[1][31] == SW_TF_IDLE_OCTET);
+
+    /* An idle frame on VC 7, then one on VC 0. */
+    ASSERT_EQ_INT(SW_OK, sw_tf_idle_frame(&mux, 7));
+    ASSERT_EQ_INT(SW_OK, sw_tf_idle_frame(&mux, 0));
+    ASSERT_EQ_INT(4, (int)got.count);
+    ASSERT_EQ_INT(7, got.vcs[2]);
+    ASSERT_EQ_INT(0x0E, got.frames[2][1] & 0x0E);
+    ASSERT_EQ_INT(SW_TF_FHP_IDLE, fhp(got.frames[2], 4));
+    ASSERT_TRUE(got.frames[2][6] == SW_TF_IDLE_OCTET && got.frames[2][31] == SW_TF_IDLE_OCTET);
+    for (uint32_t i = 0; i < 4; i++)
+        ASSERT_EQ_INT((int)i, got.frames[i][2]);
+    ASSERT_TRUE(got.frames[2][3] == 0 && got.frames[3][3] == 2);
+    ASSERT_EQ_INT(3, (int)mux.vc[0].frames);
+    ASSERT_EQ_INT(28 + 26, (int)mux.vc[0].idle_octets);
+    return 0;
+}
+
+/* AOS: header, M_PDU pointer, 24-bit count wrap, raw packets. */
+static int test_tf_aos(void)
+{
+    static captured_t got;
+    static uint8_t stream[256];
+    sw_tf_mux_t mux;
+    size_t n = 0;
+
+    const sw_tf_config_t config = {.kind = SW_TF_AOS, .scid = 0xC5, .frame_len = 40, .fecf = 0};
+    memset(&got, 0, sizeof(got));
+    ASSERT_EQ_INT(SW_OK, sw_tf_init(&mux, &config, on_frame, &got));
+    ASSERT_EQ_INT(32, mux.data_len);
+    ASSERT_EQ_INT(SW_OK, sw_tf_add_vc(&mux, 5, g_vc_buf[0]));
+    ASSERT_EQ_INT(SW_OK, sw_tf_add_vc(&mux, 63, g_vc_buf[1]));
+
+    mux.vc[5].count = 0xFFFFFFu;
+    ASSERT_EQ_INT(0, put_decoded(&mux, 5, 0x7F0, 14, stream, &n));
+
+    /* A raw packet whose header disagrees with its length is refused. */
+    uint8_t raw[30];
+    memcpy(raw, stream, 20);
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_put_raw(&mux, 5, raw, 21));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_put_raw(&mux, 5, raw, 6));
+    ASSERT_EQ_INT(SW_OK, sw_tf_put_raw(&mux, 5, raw, 20));
+    ASSERT_EQ_INT(1, (int)got.count);
+    ASSERT_EQ_INT(SW_OK, sw_tf_flush(&mux, 5));
+    ASSERT_EQ_INT(2, (int)got.count);
+
+    const uint8_t *f = got.frames[0];
+    ASSERT_TRUE(f[0] == 0x71 && f[1] == 0x45);
+    ASSERT_TRUE(f[2] == 0xFF && f[3] == 0xFF && f[4] == 0xFF && f[5] == 0);
+    ASSERT_EQ_INT(0, fhp(f, 6));
+    ASSERT_EQ_MEM(stream, &f[8], 20);
+    ASSERT_EQ_MEM(stream, &f[28], 12);
+
+    f = got.frames[1];
+    ASSERT_TRUE(f[2] == 0 && f[3] == 0 && f[4] == 0);
+    ASSERT_EQ_INT(8, fhp(f, 6));
+    ASSERT_EQ_MEM(&stream[12], &f[8], 8);
+
+    ASSERT_EQ_INT(SW_OK, sw_tf_idle_frame(&mux, 63));
+    ASSERT_EQ_INT(0x7F, got.frames[2][1]);
+    ASSERT_EQ_INT(SW_TF_FHP_IDLE, fhp(got.frames[2], 6));
+    return 0;
+}
+
+static int test_tf_errors(void)
+{
+    static captured_t got;
+    sw_tf_mux_t mux;
+    sw_tf_config_t config = {.kind = SW_TF_TM, .scid = 0x400, .frame_len = 64, .fecf = 1};
+    const uint8_t one = 0;
+    sp_packet_t pkt;
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_init(&mux, &config, on_frame, &got));
+    config.scid = 0x3FF;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_init(NULL, &config, on_frame, &got));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_init(&mux, NULL, on_frame, &got));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_init(&mux, &config, NULL, &got));
+    config.frame_len = 6 + 2 + 6;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_init(&mux, &config, on_frame, &got));
+    config.frame_len = 6 + 2 + 2046;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_init(&mux, &config, on_frame, &got));
+    config.frame_len = 6 + 2 + 2045;
+    ASSERT_EQ_INT(SW_OK, sw_tf_init(&mux, &config, on_frame, &got));
+
+    config.kind = SW_TF_AOS;
+    config.scid = 0x100;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_init(&mux, &config, on_frame, &got));
+    config.kind = SW_TF_TM;
+    config.scid = 0;
+    config.frame_len = 64;
+    ASSERT_EQ_INT(SW_OK, sw_tf_init(&mux, &config, on_frame, &got));
+
+    /* TM has 8 VCs. */
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_add_vc(&mux, 8, g_vc_buf[0]));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_add_vc(&mux, 1, NULL));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_add_vc(NULL, 1, g_vc_buf[0]));
+
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.data = &one;
+    pkt.data_len = 1;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_put(&mux, 1, &pkt));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_flush(&mux, 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_idle_frame(&mux, 200));
+    ASSERT_EQ_INT(SW_OK, sw_tf_add_vc(&mux, 1, g_vc_buf[0]));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_put(&mux, 1, NULL));
+    pkt.data_len = 0;
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_put(&mux, 1, &pkt));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_tf_put_raw(&mux, 1, NULL, 7));
+    return 0;
+}
+
+test_result_t test_spacewire_tf_run_all(void)
+{
+    RUN_TEST(test_tf_tm_spanning);
+    RUN_TEST(test_tf_idle);
+    RUN_TEST(test_tf_aos);
+    RUN_TEST(test_tf_errors);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
@@ -0,0 +1,190 @@
+/**
+ * @file test_topk.c
+ * @brief Unit tests for the heavy-hitter detector.
+ */
+#include "cunit.h"
+#include "spacewire_topk.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+#define K 16u
+#define SLOTS 32u
+#define FLOWS 400u
+
+static sw_topk_t g_topk;
+static sw_topk_entry_t g_entries[K];
+static uint16_t g_heap[K];
+static uint16_t g_index[SLOTS];
+
+static uint32_t g_rng = 88172645u;
+
+static uint32_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static int test_topk_init(void)
+{
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_topk_init(&g_topk, g_entries, g_heap, 0, g_index, SLOTS));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_topk_init(&g_topk, g_entries, g_heap, K, g_index, 24));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_topk_init(&g_topk, g_entries, g_heap, K, g_index, 16));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_topk_init(&g_topk, NULL, g_heap, K, g_index, SLOTS));
+    ASSERT_EQ_INT(SW_OK, sw_topk_init(&g_topk, g_entries, g_heap, K, g_index, SLOTS));
+    ASSERT_EQ_INT(0, g_topk.num_entries);
+    return 0;
+}
+
+/* Below capacity every flow is counted exactly. */
+static int test_topk_exact(void)
+{
+    sw_topk_entry_t top[4];
+    uint64_t err = 1;
+
+    ASSERT_EQ_INT(SW_OK, sw_topk_init(&g_topk, g_entries, g_heap, K, g_index, SLOTS));
+    for (uint32_t f = 1; f <= 10; f++)
+    {
+        for (uint32_t i = 0; i < f; i++)
+            sw_topk_add(&g_topk, SW_TOPK_KEY(0x40u + f, 0, f), 100);
+    }
+
+    ASSERT_EQ_INT(10, g_topk.num_entries);
+    ASSERT_TRUE(g_topk.total == 5500u);
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, SW_TOPK_KEY(0x47, 0, 7), &err) == 700u);
+    ASSERT_TRUE(err == 0);
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, SW_TOPK_KEY(0x47, 1, 7), NULL) == 0);
+
+    ASSERT_EQ_INT(4, sw_topk_top(&g_topk, top, 4));
+    ASSERT_TRUE(top[0].key == SW_TOPK_KEY(0x4A, 0, 10) && top[0].count == 1000u);
+    ASSERT_TRUE(top[3].key == SW_TOPK_KEY(0x47, 0, 7) && top[3].count == 700u);
+    ASSERT_EQ_INT(0, sw_topk_top(&g_topk, top, 0));
+    return 0;
+}
+
+/* Skewed traffic over many more flows than counters: the Space-Saving
+ * guarantees hold and the index stays consistent through evictions. */
+static int test_topk_space_saving(void)
+{
+    static uint64_t exact[FLOWS];
+    uint64_t total = 0;
+
+    memset(exact, 0, sizeof(exact));
+    ASSERT_EQ_INT(SW_OK, sw_topk_init(&g_topk, g_entries, g_heap, K, g_index, SLOTS));
+
+    for (unsigned i = 0; i < 200000u; i++)
+    {
+        /* Roughly Zipf: flow f drawn with weight ~ 1 / (f + 1). */
+        uint32_t f = rnd() % FLOWS;
+        f = (uint32_t)((uint64_t)f * (rnd() % FLOWS) / FLOWS);
+        f = (uint32_t)((uint64_t)f * (rnd() % FLOWS) / FLOWS);
+        const uint32_t len = 16u + rnd() % 1000u;
+
+        exact[f] += len;
+        total += len;
+        sw_topk_add(&g_topk, SW_TOPK_KEY(0x20u + f % 200u, f / 200u, f), len);
+    }
+
+    ASSERT_TRUE(g_topk.total == total);
+    ASSERT_EQ_INT(K, g_topk.num_entries);
+
+    uint64_t sum = 0;
+    for (unsigned e = 0; e < K; e++)
+    {
+        const sw_topk_entry_t *entry = &g_entries[e];
+        const uint32_t f = SW_TOPK_KEY_APID(entry->key);
+
+        sum += entry->count;
+        ASSERT_TRUE(entry->count - entry->error <= exact[f]);
+        ASSERT_TRUE(exact[f] <= entry->count);
+        ASSERT_TRUE(sw_topk_estimate(&g_topk, entry->key, NULL) == entry->count);
+        ASSERT_EQ_INT((int)e, g_heap[entry->slot]);
+    }
+    ASSERT_TRUE(sum == total);
+
+    for (unsigned f = 0; f < FLOWS; f++)
+    {
+        if (exact[f] > total / K)
+            ASSERT_TRUE(sw_topk_estimate(&g_topk, SW_TOPK_KEY(0x20u + f % 200u, f / 200u, f),
+                                         NULL) >= exact[f]);
+    }
+
+    /* The heaviest flow is reported first. */
+    sw_topk_entry_t top[1];
+    ASSERT_EQ_INT(1, sw_topk_top(&g_topk, top, 1));
+    ASSERT_EQ_INT(0, SW_TOPK_KEY_APID(top[0].key));
+    return 0;
+}
+
+/* Flows are keyed from raw packets on the router path and from decoded
+ * frames on the receive path alike. */
+static int test_topk_feeds(void)
+{
+    uint8_t buf[64];
+    const uint8_t payload[8] = {0};
+
+    ASSERT_EQ_INT(SW_OK, sw_topk_init(&g_topk, g_entries, g_heap, K, g_index, SLOTS));
+
+    const size_t len = sw_packet_create(0x42, 3, 0x123, payload, sizeof(payload), &buf[2], 62);
+    ASSERT_TRUE(len > 0);
+    buf[0] = 4; /* path octets */
+    buf[1] = 7;
+    sw_topk_add_packet(&g_topk, buf, len + 2u);
+    sw_topk_add_packet(&g_topk, &buf[2], len);
+
+    const uint32_t key = SW_TOPK_KEY(0x42, 3, 0x123);
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, key, NULL) == 2u * len + 2u);
+    ASSERT_EQ_INT(0x42, SW_TOPK_KEY_ADDR(key));
+    ASSERT_EQ_INT(3, SW_TOPK_KEY_VC(key));
+
+    sw_packet_frame_t pf;
+    ASSERT_EQ_INT(SW_OK, sw_packet_decode(&pf, &buf[2], len, SW_END_EOP, NULL));
+    sw_topk_add_frame(&g_topk, &pf, len);
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, key, NULL) == 3u * len + 2u);
+
+    /* Not a PTP packet; a packet of path octets only is ignored. */
+    const uint8_t other[4] = {0x50, 0x01, 0xAA, 0xBB};
+    sw_topk_add_packet(&g_topk, other, sizeof(other));
+    sw_topk_add_packet(&g_topk, buf, 2);
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, SW_TOPK_KEY(0x50, 0, SW_TOPK_NO_APID), NULL) == 4u);
+    ASSERT_EQ_INT(2, g_topk.num_entries);
+    return 0;
+}
+
+static int test_topk_decay(void)
+{
+    sw_topk_entry_t top[3];
+
+    ASSERT_EQ_INT(SW_OK, sw_topk_init(&g_topk, g_entries, g_heap, 2, g_index, 4));
+    sw_topk_add(&g_topk, 1, 1000);
+    sw_topk_add(&g_topk, 2, 400);
+    sw_topk_add(&g_topk, 3, 100); /* evicts flow 2 */
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, 3, NULL) == 500u);
+
+    sw_topk_decay(&g_topk, 1);
+    ASSERT_TRUE(g_topk.total == 750u);
+    ASSERT_EQ_INT(2, sw_topk_top(&g_topk, top, 3));
+    ASSERT_TRUE(top[0].count == 500u && top[1].count == 250u && top[1].error == 200u);
+
+    /* The halved minimum is still at the root: flow 4 replaces flow 3. */
+    sw_topk_add(&g_topk, 4, 1);
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, 3, NULL) == 0);
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, 4, NULL) == 251u);
+
+    sw_topk_reset(&g_topk);
+    ASSERT_EQ_INT(0, sw_topk_top(&g_topk, top, 3));
+    ASSERT_TRUE(sw_topk_estimate(&g_topk, 1, NULL) == 0);
+    return 0;
+}
+
+test_result_t test_spacewire_topk_run_all(void)
+{
+    RUN_TEST(test_topk_init);
+    RUN_TEST(test_topk_exact);
+    RUN_TEST(test_topk_space_saving);
+    RUN_TEST(test_topk_feeds);
+    RUN_TEST(test_topk_decay);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
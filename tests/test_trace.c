@@ -0,0 +1,196 @@
+/**
+ * @file test_trace.c
+ * @brief Unit tests for span tracing.
+ */
+#include "cunit.h"
+#include "spacewire.h"
+#include "spacewire_ring.h"
+#include "spacewire_trace.h"
+#include "test_runners.h"
+
+#include <string.h>
+
+static int test_trace_buf_init(void)
+{
+    sw_trace_buf_t buf;
+    sw_trace_event_t events[8];
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_trace_buf_init(NULL, events, 8, 1, 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_trace_buf_init(&buf, NULL, 8, 1, 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_trace_buf_init(&buf, events, 6, 1, 1));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_trace_buf_init(&buf, events, 8, 1, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_trace_buf_init(&buf, events, 8, 1, 3));
+    ASSERT_EQ_INT(SW_OK, sw_trace_buf_init(&buf, events, 8, 1, 4));
+    ASSERT_EQ_INT(3, (int)buf.sample_mask);
+
+    /* Without an attached buffer, spans are not started. */
+    sw_trace_attach(NULL);
+    ASSERT_TRUE(sw_trace_begin() == 0);
+    sw_trace_record(1, SW_SPAN_USER, NULL, 0);
+    ASSERT_EQ_INT(0, (int)buf.head);
+    return 0;
+}
+
+/* The library records encode, ring hand-off, route and decode spans. */
+static int test_trace_library_spans(void)
+{
+    sw_trace_buf_t buf;
+    sw_trace_event_t events[16];
+    ASSERT_EQ_INT(SW_OK, sw_trace_buf_init(&buf, events, 16, 1, 1));
+    sw_trace_attach(&buf);
+    sw_trace_set_id(42);
+    ASSERT_EQ_INT(42, (int)sw_trace_id());
+
+    const uint8_t payload[4] = {1, 2, 3, 4};
+    uint8_t pkt[32];
+    const size_t n = sw_packet_create(0x40, 0, 0x10, payload, sizeof(payload), pkt, sizeof(pkt));
+
+    sw_ring_t ring;
+    sw_desc_t slots[4];
+    sw_desc_t d = {.data = pkt, .len = (uint32_t)n};
+    ASSERT_EQ_INT(SW_OK, sw_ring_init(&ring, slots, 4));
+    ASSERT_EQ_INT(SW_OK, sw_ring_push(&ring, &d));
+    ASSERT_EQ_INT(SW_OK, sw_ring_pop(&ring, &d));
+
+    sw_router_t router;
+    uint8_t port = 0;
+    uint8_t del = 0;
+    sw_router_init(&router, 4);
+    ASSERT_EQ_INT(SW_OK, sw_router_add_route(&router, 0x40, 2, 0));
+    ASSERT_EQ_INT(SW_ROUTE_OK, sw_router_route(&router, pkt, n, &port, &del));
+    ASSERT_EQ_INT(SW_ROUTE_DISCARD, sw_router_route(&router, pkt, 0, &port, &del));
+
+    sw_packet_frame_t pf;
+    ASSERT_EQ_INT(SW_ERR, sw_packet_decode(&pf, pkt, n, SW_END_EEP, NULL));
+    sw_trace_attach(NULL);
+
+    sw_trace_event_t out[16];
+    ASSERT_EQ_INT(6, (int)sw_trace_snapshot(&buf, out, 16));
+
+    static const uint8_t spans[6] = {SW_SPAN_ENCODE,
+                                     SW_SPAN_RING_PUSH,
+                                     SW_SPAN_RING_POP,
+                                     SW_SPAN_ROUTE,
+                                     SW_SPAN_ROUTE,
+                                     SW_SPAN_DECODE};
+    static const uint16_t args[6] = {0, 1, 1, 2, 0xFFFF, SW_PTP_STATUS_EEP};
+    for (int i = 0; i < 6; i++)
+    {
+        ASSERT_EQ_INT(spans[i], out[i].span);
+        ASSERT_EQ_INT(42, (int)out[i].id);
+        if (i > 0)
+        {
+            ASSERT_EQ_INT(args[i], out[i].arg);
+            ASSERT_TRUE(out[i].start >= out[i - 1].start);
+        }
+    }
+    ASSERT_EQ_INT((int)n, out[0].arg);
+    ASSERT_TRUE(out[1].obj == (uint32_t)(uintptr_t)&ring);
+    ASSERT_TRUE(out[3].obj == (uint32_t)(uintptr_t)&router);
+    return 0;
+}
+
+/* Only identifiers that are multiples of the sampling interval are kept;
+ * application spans enclose library spans. */
+static int test_trace_sampling(void)
+{
+    sw_trace_buf_t buf;
+    sw_trace_event_t events[8];
+    ASSERT_EQ_INT(SW_OK, sw_trace_buf_init(&buf, events, 8, 2, 4));
+    sw_trace_attach(&buf);
+
+    const uint8_t one = 1;
+    uint8_t pkt[32];
+    for (uint32_t id = 1; id <= 8u; id++)
+    {
+        sw_trace_set_id(id);
+        const uint64_t t = sw_trace_begin();
+        ASSERT_EQ_INT(id % 4u == 0, t != 0);
+        ASSERT_TRUE(sw_packet_create(0x40, 0, 0x10, &one, 1, pkt, sizeof(pkt)) > 0);
+        sw_trace_end(t, SW_SPAN_USER + 1, NULL, (uint16_t)id);
+    }
+    sw_trace_attach(NULL);
+
+    sw_trace_event_t out[8];
+    ASSERT_EQ_INT(4, (int)sw_trace_snapshot(&buf, out, 8));
+    ASSERT_EQ_INT(SW_SPAN_ENCODE, out[0].span);
+    ASSERT_EQ_INT(SW_SPAN_USER + 1, out[1].span);
+    ASSERT_EQ_INT(4, (int)out[0].id);
+    ASSERT_EQ_INT(4, out[1].arg);
+    ASSERT_TRUE(out[1].start <= out[0].start);
+    ASSERT_TRUE(out[1].duration >= out[0].duration);
+    ASSERT_EQ_INT(8, (int)out[3].id);
+    return 0;
+}
+
+typedef struct
+{
+    char data[4096];
+    size_t len;
+    size_t limit;
+} sink_t;
+
+static int sink_write(void *ctx, const void *data, size_t len)
+{
+    sink_t *s = (sink_t *)ctx;
+    if (s->len + len > s->limit)
+        return -1;
+    memcpy(&s->data[s->len], data, len);
+    s->len += len;
+    return 0;
+}
+
+/* Registered buffers are written as one Chrome trace JSON document. */
+static int test_trace_export(void)
+{
+    static sw_trace_buf_t buf;
+    static sw_trace_event_t events[64];
+    static sink_t sink;
+
+    ASSERT_EQ_INT(SW_OK, sw_trace_buf_init(&buf, events, 64, 7, 1));
+    ASSERT_EQ_INT(SW_OK, sw_trace_register(&buf));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_trace_register(&buf));
+
+    sw_trace_attach(&buf);
+    sw_trace_set_id(9);
+    const uint8_t one = 1;
+    uint8_t pkt[32];
+    for (int i = 0; i < 20; i++)
+        ASSERT_TRUE(sw_packet_create(0x40, 0, 0x10, &one, 1, pkt, sizeof(pkt)) > 0);
+    sw_trace_end(sw_trace_begin(), SW_SPAN_USER + 3, NULL, 0);
+    sw_trace_attach(NULL);
+
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_trace_export_json(NULL, &sink, 1.0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_trace_export_json(sink_write, &sink, 0.0));
+
+    sink.limit = sizeof(sink.data) - 1u;
+    ASSERT_EQ_INT(SW_OK, sw_trace_export_json(sink_write, &sink, 1000.0));
+    sink.data[sink.len] = '\0';
+
+    ASSERT_TRUE(strncmp(sink.data, "{\"traceEvents\":[\n{", 18) == 0);
+    ASSERT_TRUE(strcmp(&sink.data[sink.len - 27u], "\n],\"displayTimeUnit\":\"ns\"}\n") == 0);
+    ASSERT_TRUE(strstr(sink.data, "{\"name\":\"encode\",\"cat\":\"spacewire\",\"ph\":\"X\""));
+    ASSERT_TRUE(strstr(sink.data, "\"tid\":7,\"ts\":"));
+    ASSERT_TRUE(strstr(sink.data, "\"args\":{\"id\":9,"));
+    ASSERT_TRUE(strstr(sink.data, "\"name\":\"user3\""));
+
+    size_t objects = 0;
+    for (const char *p = sink.data; (p = strstr(p, "\"ph\":\"X\"")) != NULL; p++)
+        objects++;
+    ASSERT_EQ_INT(21, (int)objects);
+
+    /* A failing sink aborts the export. */
+    sink.len = 0;
+    sink.limit = 100;
+    ASSERT_EQ_INT(SW_ERR, sw_trace_export_json(sink_write, &sink, 1000.0));
+    return 0;
+}
+
+test_result_t test_spacewire_trace_run_all(void)
+{
+    RUN_TEST(test_trace_buf_init);
+    RUN_TEST(test_trace_library_spans);
+    RUN_TEST(test_trace_sampling);
+    RUN_TEST(test_trace_export);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
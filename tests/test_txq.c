@@ -0,0 +1,158 @@
+/**
+ * @file test_txq.c
+ * @brief Unit tests for the MPSC transmit queue.
+ */
+#include "cunit.h"
+#include "spacewire_txq.h"
+#include "test_runners.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define SLOTS 8u
+
+static sw_txq_t g_q;
+static sw_txq_slot_t g_slots[SLOTS];
+
+static sw_desc_t desc(uint32_t n)
+{
+    sw_desc_t d;
+    memset(&d, 0, sizeof(d));
+    d.len = n;
+    d.port = (uint8_t)(n % 19u);
+    d.tag = (uint16_t)n;
+    d.timestamp = 1000u + n;
+    return d;
+}
+
+static int test_txq_init(void)
+{
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_txq_init(NULL, g_slots, SLOTS, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_txq_init(&g_q, NULL, SLOTS, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_txq_init(&g_q, g_slots, 0, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_txq_init(&g_q, g_slots, 6, 0));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_txq_init(&g_q, g_slots, SLOTS, SLOTS + 1u));
+    ASSERT_EQ_INT(SW_OK, sw_txq_init(&g_q, g_slots, SLOTS, 0));
+    ASSERT_EQ_INT(SLOTS, (int)g_q.limit);
+    ASSERT_EQ_INT(0, (int)sw_txq_count(&g_q));
+    ASSERT_EQ_INT(SW_INVALID_PARAM, sw_txq_set_limit(&g_q, SLOTS + 1u));
+
+    /* Producers and the consumer never share a cache line. */
+    ASSERT_TRUE(offsetof(sw_txq_t, head) - offsetof(sw_txq_t, tail) >= SW_RING_CACHE_LINE);
+    ASSERT_TRUE(offsetof(sw_txq_t, slots) - offsetof(sw_txq_t, head) >= SW_RING_CACHE_LINE);
+    return 0;
+}
+
+/* The limit refuses descriptors beyond it, counts them, and can be moved
+ * while descriptors are queued. */
+static int test_txq_limit(void)
+{
+    sw_desc_t in[SLOTS];
+    sw_desc_t out[SLOTS];
+    sw_desc_t d;
+
+    for (uint32_t i = 0; i < SLOTS; i++)
+        in[i] = desc(i);
+
+    ASSERT_EQ_INT(SW_OK, sw_txq_init(&g_q, g_slots, SLOTS, 3));
+    ASSERT_EQ_INT(SW_ERR, sw_txq_dequeue(&g_q, &d));
+    ASSERT_EQ_INT(3, (int)sw_txq_enqueue_burst(&g_q, in, 5));
+    ASSERT_EQ_INT(2, (int)g_q.rejected);
+    ASSERT_EQ_INT(SW_ERR, sw_txq_enqueue(&g_q, &in[3]));
+    ASSERT_EQ_INT(3, (int)g_q.rejected);
+
+    /* Raised: room up to the new limit. */
+    ASSERT_EQ_INT(SW_OK, sw_txq_set_limit(&g_q, 0));
+    ASSERT_EQ_INT(5, (int)sw_txq_enqueue_burst(&g_q, &in[3], 5));
+    ASSERT_EQ_INT(SLOTS, (int)sw_txq_count(&g_q));
+
+    /* Lowered below the queue: nothing is dropped, nothing is accepted
+     * until the consumer drains below the limit. */
+    ASSERT_EQ_INT(SW_OK, sw_txq_set_limit(&g_q, 2));
+    ASSERT_EQ_INT(5, (int)sw_txq_dequeue_burst(&g_q, out, 5));
+    ASSERT_EQ_INT(SW_ERR, sw_txq_enqueue(&g_q, &in[0]));
+    ASSERT_EQ_INT(2, (int)sw_txq_dequeue_burst(&g_q, &out[5], 2));
+    ASSERT_EQ_INT(SW_OK, sw_txq_enqueue(&g_q, &in[0]));
+    ASSERT_EQ_INT(1, (int)sw_txq_dequeue_burst(&g_q, &out[7], 1));
+    ASSERT_EQ_MEM(in, out, sizeof(in));
+    ASSERT_EQ_INT(1, (int)sw_txq_dequeue_burst(&g_q, out, SLOTS));
+    ASSERT_EQ_MEM(&in[0], &out[0], sizeof(out[0]));
+    return 0;
+}
+
+/* A reservation not yet filled holds back the slots behind it. */
+static int test_txq_publish_order(void)
+{
+    const sw_desc_t a = desc(1);
+    const sw_desc_t b = desc(2);
+    sw_desc_t out[4];
+
+    ASSERT_EQ_INT(SW_OK, sw_txq_init(&g_q, g_slots, SLOTS, 0));
+
+    /* A producer reserves slot 0 and is preempted before writing it. */
+    g_q.tail = 1;
+    ASSERT_EQ_INT(SW_OK, sw_txq_enqueue(&g_q, &b));
+    ASSERT_EQ_INT(2, (int)sw_txq_count(&g_q));
+    ASSERT_EQ_INT(0, (int)sw_txq_dequeue_burst(&g_q, out, 4));
+
+    g_slots[0].desc = a;
+    g_slots[0].seq = 1;
+    ASSERT_EQ_INT(2, (int)sw_txq_dequeue_burst(&g_q, out, 4));
+    ASSERT_EQ_MEM(&a, &out[0], sizeof(a));
+    ASSERT_EQ_MEM(&b, &out[1], sizeof(b));
+    ASSERT_EQ_INT(0, (int)sw_txq_count(&g_q));
+    return 0;
+}
+
+/* Partial bursts across many wrap-arounds keep FIFO order; the 32-bit
+ * positions are started near overflow. */
+static int test_txq_burst_wrap(void)
+{
+    const uint32_t base = UINT32_MAX - 20u;
+    sw_desc_t in[5];
+    sw_desc_t out[5];
+    uint32_t next_in = 0;
+    uint32_t next_out = 0;
+
+    ASSERT_EQ_INT(SW_OK, sw_txq_init(&g_q, g_slots, SLOTS, 0));
+    g_q.tail = g_q.head = g_q.head_cache = base;
+    for (uint32_t i = 0; i < SLOTS; i++)
+        g_slots[i].seq = base;
+
+    for (unsigned round = 0; round < 50u; round++)
+    {
+        const uint32_t want = 1u + round % 5u;
+        for (uint32_t i = 0; i < want; i++)
+            in[i] = desc(next_in + i);
+
+        const uint32_t queued = sw_txq_count(&g_q);
+        const uint32_t pushed = sw_txq_enqueue_burst(&g_q, in, want);
+        ASSERT_EQ_INT((int)(want < SLOTS - queued ? want : SLOTS - queued), (int)pushed);
+        next_in += pushed;
+
+        const uint32_t popped = sw_txq_dequeue_burst(&g_q, out, 1u + (round * 3u) % 4u);
+        for (uint32_t i = 0; i < popped; i++)
+        {
+            const sw_desc_t expect = desc(next_out++);
+            ASSERT_EQ_MEM(&expect, &out[i], sizeof(out[i]));
+        }
+    }
+
+    uint32_t popped;
+    while ((popped = sw_txq_dequeue_burst(&g_q, out, 5)) > 0)
+        next_out += popped;
+    ASSERT_EQ_INT(0, (int)sw_txq_count(&g_q));
+    ASSERT_EQ_INT((int)next_in, (int)next_out);
+    ASSERT_TRUE(next_in > 2u * SLOTS);
+    ASSERT_EQ_INT(0, sw_txq_dequeue_burst(&g_q, out, 0));
+    return 0;
+}
+
+test_result_t test_spacewire_txq_run_all(void)
+{
+    RUN_TEST(test_txq_init);
+    RUN_TEST(test_txq_limit);
+    RUN_TEST(test_txq_publish_order);
+    RUN_TEST(test_txq_burst_wrap);
+    return (test_result_t){cunit_total_tests - cunit_overall_failures, cunit_total_tests};
+}
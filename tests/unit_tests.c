@@ -29,6 +29,111 @@ int main(void)
     total_passed += r.passed;
     total_tests += r.total;
 
+    r = test_spacewire_pubsub_run_all();
+    REPORT("pubsub", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_sched_run_all();
+    REPORT("sched", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_evlog_run_all();
+    REPORT("evlog", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_net_run_all();
+    REPORT("net", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_sim_run_all();
+    REPORT("sim", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_psim_run_all();
+    REPORT("psim", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_ckpt_run_all();
+    REPORT("ckpt", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_topk_run_all();
+    REPORT("topk", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_ring_run_all();
+    REPORT("ring", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_capidx_run_all();
+    REPORT("capidx", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_decom_run_all();
+    REPORT("decom", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_archive_run_all();
+    REPORT("Archive", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_sfq_run_all();
+    REPORT("Store-and-forward", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_trace_run_all();
+    REPORT("Trace", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_spfi_run_all();
+    REPORT("SpaceFibre VC", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_nc_run_all();
+    REPORT("Network calculus", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_ds_run_all();
+    REPORT("Data-strobe decoder", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_txq_run_all();
+    REPORT("MPSC transmit queue", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_rss_run_all();
+    REPORT("Receive steering", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_fixed_run_all();
+    REPORT("Fixed commands", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
+    r = test_spacewire_tf_run_all();
+    REPORT("Transfer frames", r);
+    total_passed += r.passed;
+    total_tests += r.total;
+
     printf("  ------------------------------\n");
     printf("  %-14s Passed %d/%d\n", "All UT:", total_passed, total_tests);
 